@@ -154,6 +154,11 @@ is not searched for this keyword.
 \arg \c DRMS_QUERY_MEM Sets the memory maximum for a database query.
 \arg \c DRMS_SERVER_WAIT Non-zero value indicates waiting 2 seconds
 before exiting, otherwise don't wait.
+\arg \c DRMS_SUMS_WORKERS Sets the number of threads (each with its own SUMS
+connection) that serve the SUMS requests of the clients. Default is 4.
+\arg \c DRMS_READ_CONNECTIONS Sets the number of extra, read-only database connections that
+client queries run on (concurrently) until a client modifies the database in the server's
+transaction. Default is 0 (all clients share one database connection).
 
 \sa
 create_series describe_series delete_series modify_series show_info 
@@ -187,6 +192,8 @@ create_series describe_series delete_series modify_series show_info
 #define kLoopConnFlag "loopconn"
 #define kDBTimeOut "DRMS_DBTIMEOUT"
 #define kDBUtf8ClientEncoding "DRMS_DBUTF8CLIENTENCODING"
+#define kSUMSWorkers "DRMS_SUMS_WORKERS"
+#define kReadConns "DRMS_READ_CONNECTIONS"
 
 /* Global structure holding command line parameters. */
 CmdParams_t cmdparams;
@@ -197,6 +204,8 @@ ModuleArgs_t module_args[] = {
   {ARG_INT, "DRMS_ARCHIVE", "-9999"}, 
   {ARG_INT, "DRMS_QUERY_MEM", "512"}, 
   {ARG_INT, "DRMS_SERVER_WAIT", "1"},
+  {ARG_INT, kSUMSWorkers, "0", "Number of SUMS worker threads (0 - the default, 4)."},
+  {ARG_INT, kReadConns, "0", "Number of read-only db connections for client queries (0 - none)."},
   {ARG_INT, kDBTimeOut, "-99"},
   {ARG_STRING, kCENVFILE, kNOTSPECIFIED, "If set, write out to a file all C-shell commands that set the essential DRMS_* env variables."},
   {ARG_STRING, kSHENVFILE, kNOTSPECIFIED, "If set, write out to a file all bash-shell command that set the essential DRMS_* env variables."},
@@ -533,6 +542,8 @@ int main (int argc, char *argv[]) {
     }
   env->query_mem   = cmdparams_get_int(&cmdparams, "DRMS_QUERY_MEM", NULL);
   env->server_wait = cmdparams_get_int(&cmdparams, "DRMS_SERVER_WAIT", NULL);
+  env->sums_nworkers = cmdparams_get_int(&cmdparams, kSUMSWorkers, NULL);
+  env->db_nreadconns = cmdparams_get_int(&cmdparams, kReadConns, NULL);
   env->verbose     = verbose;
 
   env->dbpasswd = dbpasswd;
@@ -4,7 +4,7 @@ dirstack_$(sp)  := $(d)
 d               := $(dir)
 
 # Local variables
-MODEXE_$(d)    := $(addprefix $(d)/, test-fl-query)
+MODEXE_$(d)    := $(addprefix $(d)/, test-fl-query test-stage-links)
 MODEXE         := $(MODEXE) $(MODEXE_$(d))
 
 MODEXE_SOCK_$(d):= $(MODEXE_$(d):%=%_sock)
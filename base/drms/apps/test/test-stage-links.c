@@ -0,0 +1,126 @@
+#include "jsoc_main.h"
+#include "drms_types.h"
+
+/* Stages a record set of a series that has linked keywords, with the records' keywords in the columnar
+ * layout (DRMS_KEYWORD_COLUMNS), and checks that the records the linked keywords point to were staged
+ * too, and that the linked keywords' values are those of the target records.
+ *
+ * usage: test-stage-links ds=<record-set spec of a series with at least one linked keyword>
+ */
+
+char *module_name = "DRMS_STAGE_LINKS_TEST";
+
+typedef enum
+{
+   kDSLErr_Success = 0,
+   kDSLErr_Error = 1
+} DSLError_t;
+
+#define kRecSetIn      "ds"
+
+ModuleArgs_t module_args[] =
+{
+     {ARG_STRING, kRecSetIn, "",  "Input record set; the series must have at least one linked keyword."},
+     {ARG_END}
+};
+
+int DoIt(void)
+{
+    int status = DRMS_SUCCESS;
+    const char *rsin = cmdparams_get_str(&cmdparams, kRecSetIn, NULL);
+    DRMS_RecordSet_t *rs = NULL;
+    DRMS_Record_t *rec = NULL;
+    DRMS_Record_t *linkedrec = NULL;
+    DRMS_Keyword_t *key = NULL;
+    HIterator_t *last = NULL;
+    char *val = NULL;
+    char *linkedval = NULL;
+    int irec;
+    int nlinkedkeys = 0;
+    int nchecked = 0;
+    DSLError_t rv = kDSLErr_Success;
+
+    /* the records get no keyword structs of their own until their keywords are looked up */
+    drms_env->keyword_columns = 1;
+
+    rs = drms_open_records(drms_env, rsin, &status);
+    if (!rs || status != DRMS_SUCCESS || rs->n < 1)
+    {
+        fprintf(stderr, "Unable to open records '%s'.\n", rsin);
+        return kDSLErr_Error;
+    }
+
+    if (drms_stage_records(rs, 1, 0) != DRMS_SUCCESS)
+    {
+        fprintf(stderr, "Unable to stage records '%s'.\n", rsin);
+        rv = kDSLErr_Error;
+    }
+
+    for (irec = 0; rv == kDSLErr_Success && irec < rs->n; irec++)
+    {
+        rec = rs->records[irec];
+
+        while ((key = drms_record_nextkey(rec, &last, 0)) != NULL)
+        {
+            if (!key->info->islink)
+            {
+                continue;
+            }
+
+            nlinkedkeys++;
+            linkedrec = drms_link_follow(rec, key->info->linkname, &status);
+
+            if (!linkedrec)
+            {
+                /* the link is not set for this record */
+                continue;
+            }
+
+            if (linkedrec->sunum >= 0 && !linkedrec->su)
+            {
+                fprintf(stderr, "%s: record %lld, linked by %s, was not staged.\n", key->info->name, linkedrec->recnum, key->info->linkname);
+                rv = kDSLErr_Error;
+            }
+
+            val = drms_getkey_string(rec, key->info->name, &status);
+            linkedval = drms_getkey_string(linkedrec, key->info->target_key, &status);
+
+            if (!val || !linkedval || strcmp(val, linkedval) != 0)
+            {
+                fprintf(stderr, "%s: value '%s' is not the value '%s' of %s in the linked record.\n", key->info->name, val ? val : "", linkedval ? linkedval : "", key->info->target_key);
+                rv = kDSLErr_Error;
+            }
+
+            if (val)
+            {
+                free(val);
+                val = NULL;
+            }
+
+            if (linkedval)
+            {
+                free(linkedval);
+                linkedval = NULL;
+            }
+
+            nchecked++;
+        }
+
+        if (last)
+        {
+            hiter_destroy(&last);
+        }
+    }
+
+    if (rv == kDSLErr_Success && nlinkedkeys == 0)
+    {
+        fprintf(stderr, "The records of '%s' have no linked keywords.\n", rsin);
+        rv = kDSLErr_Error;
+    }
+
+    printf("%d records, %d linked keyword values checked: %s\n", rs->n, nchecked, rv == kDSLErr_Success ? "ok" : "FAILED");
+
+    drms_close_records(rs, DRMS_FREE_RECORD);
+
+    return rv;
+}
@@ -0,0 +1,337 @@
+/* Benchmark for the drms_array2* conversions. For a few common source/destination type pairs, it
+ * converts an image of npix pixels (16M by default; 1% of the pixels are missing) with the
+ * library's drms_array2* functions and with scalar loops like the ones the library used
+ * to have, checks that the results are identical, and reports the conversion rate of each.
+ * The longlong, double, and time pairs are scaled with a bscale and bzero that are not exact
+ * in binary, so a kernel that fused bscale * x + bzero into an fma would not match. Build this
+ * without -march or -mfma flags, so that the scalar loops are not fused either.
+ *
+ * usage: benchdrmsarray [npix] [nrounds]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "drms.h"
+
+#define BZERO 32768.0
+#define BSCALE 0.0625
+#define BZERO_INEXACT (1.0 / 3.0)
+#define BSCALE_INEXACT 0.1
+
+static double Now(void)
+{
+   struct timeval tv;
+
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1.0e6;
+}
+
+/* The scalar loops - one per benchmarked pair. */
+static void Short2Float(arraylen_t n, double bzero, double bscale, short *src, float *dst)
+{
+   double value;
+   arraylen_t i;
+
+   for (i = 0; i < n; i++, src++, dst++)
+   {
+      if (*src == DRMS_MISSING_SHORT)
+        *dst = DRMS_MISSING_FLOAT;
+      else
+      {
+         value = bscale * *src + bzero;
+         if (!(value < -FLT_MAX || value > FLT_MAX))
+           *dst = (float)value;
+         else
+           *dst = DRMS_MISSING_FLOAT;
+      }
+   }
+}
+
+static void Int2Double(arraylen_t n, double bzero, double bscale, int *src, double *dst)
+{
+   double value;
+   arraylen_t i;
+
+   for (i = 0; i < n; i++, src++, dst++)
+   {
+      if (*src == DRMS_MISSING_INT)
+        *dst = DRMS_MISSING_DOUBLE;
+      else
+      {
+         value = bscale * *src + bzero;
+         if (!(value < -DBL_MAX || value > DBL_MAX))
+           *dst = value;
+         else
+           *dst = DRMS_MISSING_DOUBLE;
+      }
+   }
+}
+
+static void Float2Short(arraylen_t n, double bzero, double bscale, float *src, short *dst)
+{
+   double rangechk;
+   arraylen_t i;
+
+   for (i = 0; i < n; i++, src++, dst++)
+   {
+      if (isnan(*src))
+        *dst = DRMS_MISSING_SHORT;
+      else
+      {
+         rangechk = round(bscale * *src + bzero);
+         if (!(rangechk < SHRT_MIN || rangechk > SHRT_MAX))
+           *dst = (short)rangechk;
+         else
+           *dst = DRMS_MISSING_SHORT;
+      }
+   }
+}
+
+static void Double2Float(arraylen_t n, double bzero, double bscale, double *src, float *dst)
+{
+   arraylen_t i;
+
+   for (i = 0; i < n; i++, src++, dst++)
+   {
+      if (isnan(*src))
+        *dst = DRMS_MISSING_FLOAT;
+      else if (!(*src < -FLT_MAX || *src > FLT_MAX))
+        *dst = (float)*src;
+      else
+        *dst = DRMS_MISSING_FLOAT;
+   }
+}
+
+static void LongLong2LongLong(arraylen_t n, double bzero, double bscale, long long *src, long long *dst)
+{
+   double rangechk;
+   arraylen_t i;
+
+   for (i = 0; i < n; i++, src++, dst++)
+   {
+      if (*src == DRMS_MISSING_LONGLONG)
+        *dst = DRMS_MISSING_LONGLONG;
+      else
+      {
+         rangechk = round(bscale * *src + bzero);
+         if (!(rangechk < LLONG_MIN || rangechk > LLONG_MAX))
+           *dst = (long long)rangechk;
+         else
+           *dst = DRMS_MISSING_LONGLONG;
+      }
+   }
+}
+
+/* dstmissing is DRMS_MISSING_DOUBLE or DRMS_MISSING_TIME */
+static void LongLong2Double(arraylen_t n, double bzero, double bscale, long long *src, double *dst, double dstmissing)
+{
+   double value;
+   arraylen_t i;
+
+   for (i = 0; i < n; i++, src++, dst++)
+   {
+      if (*src == DRMS_MISSING_LONGLONG)
+        *dst = dstmissing;
+      else
+      {
+         value = bscale * *src + bzero;
+         if (!(value < -DBL_MAX || value > DBL_MAX))
+           *dst = value;
+         else
+           *dst = dstmissing;
+      }
+   }
+}
+
+/* srctime - the source is DRMS_TYPE_TIME (missing is DRMS_MISSING_TIME), else DRMS_TYPE_DOUBLE (missing is NaN) */
+static void Double2LongLong(arraylen_t n, double bzero, double bscale, double *src, long long *dst, int srctime)
+{
+   double rangechk;
+   arraylen_t i;
+
+   for (i = 0; i < n; i++, src++, dst++)
+   {
+      if (srctime ? *src == DRMS_MISSING_TIME : isnan(*src))
+        *dst = DRMS_MISSING_LONGLONG;
+      else
+      {
+         rangechk = round(bscale * *src + bzero);
+         if (!(rangechk < LLONG_MIN || rangechk > LLONG_MAX))
+           *dst = (long long)rangechk;
+         else
+           *dst = DRMS_MISSING_LONGLONG;
+      }
+   }
+}
+
+static void Double2Double(arraylen_t n, double bzero, double bscale, double *src, double *dst, double dstmissing)
+{
+   double value;
+   arraylen_t i;
+
+   for (i = 0; i < n; i++, src++, dst++)
+   {
+      if (isnan(*src))
+        *dst = dstmissing;
+      else
+      {
+         value = bscale * *src + bzero;
+         if (!(value < -DBL_MAX || value > DBL_MAX))
+           *dst = value;
+         else
+           *dst = dstmissing;
+      }
+   }
+}
+
+typedef struct
+{
+   const char *name;
+   DRMS_Type_t srctype;
+   DRMS_Type_t dsttype;
+   double bzero;
+   double bscale;
+} Pair_t;
+
+static void Fill(DRMS_Type_t type, arraylen_t npix, void *data)
+{
+   arraylen_t ipix;
+   int missing;
+   long val;
+
+   srandom(17);
+   for (ipix = 0; ipix < npix; ipix++)
+   {
+      missing = (random() % 100 == 0);
+      val = random() % 65536 - 32767;
+
+      switch (type)
+      {
+         case DRMS_TYPE_SHORT:
+           ((short *)data)[ipix] = missing ? DRMS_MISSING_SHORT : (short)val;
+           break;
+         case DRMS_TYPE_INT:
+           ((int *)data)[ipix] = missing ? DRMS_MISSING_INT : (int)val * 1000;
+           break;
+         case DRMS_TYPE_LONGLONG:
+           ((long long *)data)[ipix] = missing ? DRMS_MISSING_LONGLONG : (long long)val * random();
+           break;
+         case DRMS_TYPE_FLOAT:
+           ((float *)data)[ipix] = missing ? DRMS_MISSING_FLOAT : val / 3.0f;
+           break;
+         case DRMS_TYPE_DOUBLE:
+           ((double *)data)[ipix] = missing ? DRMS_MISSING_DOUBLE : val / 7.0;
+           break;
+         case DRMS_TYPE_TIME:
+           /* seconds since 1977.01.01_TAI, to 2020 or so */
+           ((double *)data)[ipix] = missing ? DRMS_MISSING_TIME : (double)random() / 1.5 + val / 7.0;
+           break;
+         default:
+           break;
+      }
+   }
+}
+
+static void Scalar(Pair_t *pair, arraylen_t npix, void *src, void *dst)
+{
+   if (pair->srctype == DRMS_TYPE_LONGLONG)
+   {
+      if (pair->dsttype == DRMS_TYPE_LONGLONG)
+        LongLong2LongLong(npix, pair->bzero, pair->bscale, src, dst);
+      else
+        LongLong2Double(npix, pair->bzero, pair->bscale, src, dst, pair->dsttype == DRMS_TYPE_TIME ? DRMS_MISSING_TIME : DRMS_MISSING_DOUBLE);
+      return;
+   }
+
+   if (pair->srctype == DRMS_TYPE_TIME || (pair->srctype == DRMS_TYPE_DOUBLE && pair->dsttype != DRMS_TYPE_FLOAT))
+   {
+      if (pair->dsttype == DRMS_TYPE_LONGLONG)
+        Double2LongLong(npix, pair->bzero, pair->bscale, src, dst, pair->srctype == DRMS_TYPE_TIME);
+      else
+        Double2Double(npix, pair->bzero, pair->bscale, src, dst, pair->dsttype == DRMS_TYPE_TIME ? DRMS_MISSING_TIME : DRMS_MISSING_DOUBLE);
+      return;
+   }
+
+   switch (pair->srctype)
+   {
+      case DRMS_TYPE_SHORT:
+        Short2Float(npix, pair->bzero, pair->bscale, src, dst);
+        break;
+      case DRMS_TYPE_INT:
+        Int2Double(npix, pair->bzero, pair->bscale, src, dst);
+        break;
+      case DRMS_TYPE_FLOAT:
+        Float2Short(npix, pair->bzero, pair->bscale, src, dst);
+        break;
+      case DRMS_TYPE_DOUBLE:
+        Double2Float(npix, pair->bzero, pair->bscale, src, dst);
+        break;
+      default:
+        break;
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   arraylen_t npix = argc > 1 ? atoll(argv[1]) : 16 * 1024 * 1024;
+   int nrounds = argc > 2 ? atoi(argv[2]) : 10;
+   Pair_t pairs[] =
+   {
+      { "short->float", DRMS_TYPE_SHORT, DRMS_TYPE_FLOAT, BZERO, BSCALE },
+      { "int->double", DRMS_TYPE_INT, DRMS_TYPE_DOUBLE, BZERO, BSCALE },
+      { "float->short", DRMS_TYPE_FLOAT, DRMS_TYPE_SHORT, -BZERO / 16, 1.0 / BSCALE / 16 },
+      { "double->float", DRMS_TYPE_DOUBLE, DRMS_TYPE_FLOAT, 0.0, 1.0 },
+      { "longlong->longlong", DRMS_TYPE_LONGLONG, DRMS_TYPE_LONGLONG, BZERO_INEXACT, BSCALE_INEXACT },
+      { "longlong->double", DRMS_TYPE_LONGLONG, DRMS_TYPE_DOUBLE, BZERO_INEXACT, BSCALE_INEXACT },
+      { "longlong->time", DRMS_TYPE_LONGLONG, DRMS_TYPE_TIME, BZERO_INEXACT, BSCALE_INEXACT },
+      { "double->longlong", DRMS_TYPE_DOUBLE, DRMS_TYPE_LONGLONG, BZERO_INEXACT, BSCALE_INEXACT },
+      { "double->double", DRMS_TYPE_DOUBLE, DRMS_TYPE_DOUBLE, BZERO_INEXACT, BSCALE_INEXACT },
+      { "double->time", DRMS_TYPE_DOUBLE, DRMS_TYPE_TIME, BZERO_INEXACT, BSCALE_INEXACT },
+      { "time->longlong", DRMS_TYPE_TIME, DRMS_TYPE_LONGLONG, BZERO_INEXACT, BSCALE_INEXACT }
+   };
+   int ipair;
+   int iround;
+   void *src = malloc(npix * 8);
+   void *dst = malloc(npix * 8);
+   void *ref = malloc(npix * 8);
+   double tscalar;
+   double tlib;
+   int dstsize;
+   int status = 0;
+
+   printf("%-20s %12s %12s %8s\n", "conversion", "scalar Mpx/s", "lib Mpx/s", "speedup");
+
+   for (ipair = 0; ipair < sizeof(pairs) / sizeof(pairs[0]); ipair++)
+   {
+      Fill(pairs[ipair].srctype, npix, src);
+      dstsize = drms_sizeof(pairs[ipair].dsttype);
+
+      tscalar = Now();
+      for (iround = 0; iround < nrounds; iround++)
+      {
+         Scalar(&pairs[ipair], npix, src, ref);
+      }
+      tscalar = Now() - tscalar;
+
+      tlib = Now();
+      for (iround = 0; iround < nrounds; iround++)
+      {
+         drms_array_rawconvert(npix, pairs[ipair].dsttype, pairs[ipair].bzero, pairs[ipair].bscale, dst, pairs[ipair].srctype, src);
+      }
+      tlib = Now() - tlib;
+
+      if (memcmp(ref, dst, npix * dstsize))
+      {
+         fprintf(stderr, "%s: results differ.\n", pairs[ipair].name);
+         status = 1;
+      }
+
+      printf("%-20s %12.1f %12.1f %8.2f\n", pairs[ipair].name, npix * nrounds / tscalar / 1.0e6, npix * nrounds / tlib / 1.0e6, tscalar / tlib);
+   }
+
+   free(src);
+   free(dst);
+   free(ref);
+
+   return status;
+}
@@ -0,0 +1,160 @@
+/* Load test for drms_server. It connects nclients sessions to a running drms_server (the way socket
+ * modules do), and each session sends the same query (DRMS_TXTQUERY) over and over for a few seconds.
+ * It reports the queries per second and the mean query latency for 1, 2, 4, ... maxclients clients.
+ * Run it against a drms_server started with and without DRMS_READ_CONNECTIONS to see how well the
+ * server's client queries scale.
+ *
+ * usage: benchdrmsserver host:port [seconds] [maxclients] [query]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "drms.h"
+
+typedef struct
+{
+   DRMS_Session_t *session;
+   const char *query;
+   double duration;
+   long nqueries;
+   long errors;
+   double latency; /* sum of the query latencies (s) */
+} Client_t;
+
+static double Now(void)
+{
+   struct timeval tv;
+
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1.0e6;
+}
+
+static void *Client(void *data)
+{
+   Client_t *client = (Client_t *)data;
+   DB_Text_Result_t *result = NULL;
+   char *errmsg = NULL;
+   double start = Now();
+   double tquery;
+
+   while ((tquery = Now()) - start < client->duration)
+   {
+      drms_send_commandcode(client->session->sockfd, DRMS_TXTQUERY);
+      result = db_client_query_txt(client->session->sockfd, client->query, 0, &errmsg);
+      client->latency += Now() - tquery;
+
+      if (result)
+      {
+         db_free_text_result(result);
+         client->nqueries++;
+      }
+      else
+      {
+         client->errors++;
+      }
+
+      if (errmsg)
+      {
+         free(errmsg);
+         errmsg = NULL;
+      }
+   }
+
+   return NULL;
+}
+
+static int Run(const char *server, int nclients, double duration, const char *query)
+{
+   Client_t *clients = calloc(nclients, sizeof(Client_t));
+   pthread_t *threads = malloc(nclients * sizeof(pthread_t));
+   long nqueries = 0;
+   long errors = 0;
+   double latency = 0;
+   double wall;
+   int iclient;
+   int nconnected;
+
+   /* drms_connect() is not thread-safe - connect all sessions first. */
+   for (nconnected = 0; nconnected < nclients; nconnected++)
+   {
+      clients[nconnected].session = drms_connect(server);
+      if (!clients[nconnected].session)
+      {
+         fprintf(stderr, "Couldn't connect to drms_server at %s.\n", server);
+         break;
+      }
+
+      clients[nconnected].query = query;
+      clients[nconnected].duration = duration;
+   }
+
+   if (nconnected == nclients)
+   {
+      wall = Now();
+
+      for (iclient = 0; iclient < nclients; iclient++)
+      {
+         pthread_create(&threads[iclient], NULL, Client, &clients[iclient]);
+      }
+
+      for (iclient = 0; iclient < nclients; iclient++)
+      {
+         pthread_join(threads[iclient], NULL);
+         nqueries += clients[iclient].nqueries;
+         errors += clients[iclient].errors;
+         latency += clients[iclient].latency;
+      }
+
+      wall = Now() - wall;
+
+      printf("%8d %12.0f %14.3f %8ld\n", nclients, nqueries / wall, nqueries + errors > 0 ? latency / (nqueries + errors) * 1.0e3 : 0.0, errors);
+      fflush(stdout);
+   }
+
+   for (iclient = 0; iclient < nconnected; iclient++)
+   {
+      /* abort = 0 - the server keeps running */
+      drms_send_commandcode(clients[iclient].session->sockfd, DRMS_DISCONNECT);
+      Writeint(clients[iclient].session->sockfd, 0);
+      close(clients[iclient].session->sockfd);
+      free(clients[iclient].session);
+   }
+
+   free(threads);
+   free(clients);
+
+   return nconnected == nclients ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+   const char *server = NULL;
+   double duration;
+   int maxclients;
+   const char *query;
+   int nclients;
+
+   if (argc < 2)
+   {
+      fprintf(stderr, "usage: %s host:port [seconds] [maxclients] [query]\n", argv[0]);
+      return 1;
+   }
+
+   server = argv[1];
+   duration = argc > 2 ? atof(argv[2]) : 5.0;
+   maxclients = argc > 3 ? atoi(argv[3]) : 32;
+   query = argc > 4 ? argv[4] : "SELECT count(*) FROM pg_catalog.pg_class";
+
+   printf("%8s %12s %14s %8s\n", "clients", "queries/s", "latency ms", "errors");
+
+   for (nclients = 1; nclients <= maxclients; nclients *= 2)
+   {
+      if (Run(server, nclients, duration, query))
+      {
+         return 1;
+      }
+   }
+
+   return 0;
+}
@@ -1,4 +1,6 @@
 #include "drms.h"
+#include <sys/mman.h>
+#include <fcntl.h>
 
 // #define DEBUG
 
@@ -66,12 +68,64 @@ void drms_free_array(DRMS_Array_t *arr)
 {
   if  (arr)
   {
-    if (arr->data)
-      free(arr->data);
+    drms_array_freedata(arr);
     free(arr);
   }
 }
 
+/* Free (or unmap) the data part of array. Every array constructor zeroes mapaddr, so a mapaddr means the data
+   were mapped by drms_array_mapfile(). */
+void drms_array_freedata(DRMS_Array_t *arr)
+{
+  if (arr->mapaddr)
+  {
+    munmap(arr->mapaddr, arr->maplen);
+    arr->mapaddr = NULL;
+    arr->maplen = 0;
+  }
+  else if (arr->data)
+  {
+    free(arr->data);
+  }
+
+  arr->data = NULL;
+}
+
+/* Map len bytes, starting at offset, of file filename into memory and make them the data part of
+   array. The mapping is private: the data can be modified, but the changes are not written to the file. */
+int drms_array_mapfile(DRMS_Array_t *arr, const char *filename, long long offset, long long len)
+{
+  int fd;
+  struct stat stbuf;
+  void *addr;
+
+  if (len <= 0 || offset < 0)
+    return DRMS_ERROR_INVALIDDATA;
+
+  if ((fd = open(filename, O_RDONLY)) == -1)
+    return DRMS_ERROR_INVALIDFILE;
+
+  if (fstat(fd, &stbuf) || stbuf.st_size < offset + len)
+  {
+    close(fd);
+    return DRMS_ERROR_INVALIDFILE;
+  }
+
+  /* offset need not be page-aligned - map from the start of the file. */
+  addr = mmap(NULL, (size_t)(offset + len), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (addr == MAP_FAILED)
+    return DRMS_ERROR_OUTOFMEMORY;
+
+  madvise(addr, (size_t)(offset + len), MADV_SEQUENTIAL);
+
+  arr->mapaddr = addr;
+  arr->maplen = (size_t)(offset + len);
+  arr->data = (char *)addr + offset;
+  return DRMS_SUCCESS;
+}
+
 /* Convert array from one DRMS type to another in place. */
 void drms_array_convert_inplace(DRMS_Type_t newtype, double bzero, 
 				double bscale, DRMS_Array_t *src)
@@ -82,7 +136,7 @@ void drms_array_convert_inplace(DRMS_Type_t newtype, double bzero,
   {
     tmp = drms_array_convert(newtype, bzero, bscale, src);
     src->type = newtype;
-    free(src->data);
+    drms_array_freedata(src);
     src->data = tmp->data;
     free(tmp);
   }
@@ -351,6 +405,227 @@ void drms_array_fprint(FILE *keyfile, DRMS_Array_t *arr, const char *colsep,
 
 
 /*************** Careful array conversion routines. ********************/
+
+/* The numeric conversions are done by the kernels below. They are written so
+   that the compiler can vectorize them: the missing-value and range checks
+   produce masks, and every element is converted, then a select picks the
+   converted value or the missing value. With gcc on x86-64, each kernel is
+   also compiled for SSE4.1, AVX2, and AVX-512, and the version for the host
+   cpu is chosen when the program is loaded. The kernels don't look at the
+   floating-point exception flags, so they are compiled with no-trapping-math,
+   which lets gcc convert elements that end up being replaced by missing. They
+   are also compiled with fp-contract=off - otherwise gcc fuses bscale * x + bzero
+   into an fma in the AVX-512 and AVX2 versions, which rounds once instead of
+   twice, and the results would depend on the host cpu. Only AVX-512DQ has
+   vector conversions between double and long long, so gcc 11 and later also
+   make an x86-64-v4 (AVX-512F/BW/CD/DQ/VL) version. */
+#if defined(__GNUC__) && (__GNUC__ >= 11) && defined(__x86_64__) && !defined(__INTEL_COMPILER) && !defined(__clang__)
+#define ARRAY_KERNEL __attribute__((target_clones("arch=x86-64-v4", "avx512f", "avx2", "sse4.1", "default"), optimize("tree-vectorize", "no-trapping-math", "fp-contract=off")))
+#elif defined(__GNUC__) && (__GNUC__ >= 6) && defined(__x86_64__) && !defined(__INTEL_COMPILER) && !defined(__clang__)
+#define ARRAY_KERNEL __attribute__((target_clones("avx512f", "avx2", "sse4.1", "default"), optimize("tree-vectorize", "no-trapping-math", "fp-contract=off")))
+#else
+#define ARRAY_KERNEL
+#endif
+
+/* Kernel element types - DRMS type name, C type. DRMS_TYPE_TIME has the C type
+   of DRMS_TYPE_DOUBLE, but its missing value is not NaN. */
+#define ARRAY_SRC_INT_TYPES(X, ...) \
+  X(CHAR, char, __VA_ARGS__) X(SHORT, short, __VA_ARGS__) X(INT, int, __VA_ARGS__) X(LONGLONG, long long, __VA_ARGS__)
+#define ARRAY_SRC_FP_TYPES(X, ...) \
+  X(FLOAT, float, __VA_ARGS__) X(TIME, double, __VA_ARGS__) X(DOUBLE, double, __VA_ARGS__)
+#define ARRAY_SRC_TYPES(X, ...) \
+  ARRAY_SRC_INT_TYPES(X, __VA_ARGS__) ARRAY_SRC_FP_TYPES(X, __VA_ARGS__)
+#define ARRAY_DST_INT_TYPES(X) X(CHAR, char) X(SHORT, short) X(INT, int) X(LONGLONG, long long)
+#define ARRAY_DST_FP_TYPES(X) X(FLOAT, float) X(DOUBLE, double)
+
+#define ARRAY_ISMISSING_CHAR(s) ((s) == DRMS_MISSING_CHAR)
+#define ARRAY_ISMISSING_SHORT(s) ((s) == DRMS_MISSING_SHORT)
+#define ARRAY_ISMISSING_INT(s) ((s) == DRMS_MISSING_INT)
+#define ARRAY_ISMISSING_LONGLONG(s) ((s) == DRMS_MISSING_LONGLONG)
+#define ARRAY_ISMISSING_FLOAT(s) (isnan(s))
+#define ARRAY_ISMISSING_TIME(s) ((s) == DRMS_MISSING_TIME)
+#define ARRAY_ISMISSING_DOUBLE(s) (isnan(s))
+
+/* Range of the integer types, after rounding. */
+#define ARRAY_MIN_CHAR SCHAR_MIN
+#define ARRAY_MAX_CHAR SCHAR_MAX
+#define ARRAY_MIN_SHORT SHRT_MIN
+#define ARRAY_MAX_SHORT SHRT_MAX
+#define ARRAY_MIN_INT INT_MIN
+#define ARRAY_MAX_INT INT_MAX
+#define ARRAY_MIN_LONGLONG LLONG_MIN
+#define ARRAY_MAX_LONGLONG LLONG_MAX
+
+/* Range of the floating-point types - for unscaled and scaled values. An unscaled
+   double is never out of range. */
+#define ARRAY_UMAX_FLOAT FLT_MAX
+#define ARRAY_UMAX_DOUBLE HUGE_VAL
+#define ARRAY_SMAX_FLOAT FLT_MAX
+#define ARRAY_SMAX_DOUBLE DBL_MAX
+
+/* Integer to integer, unscaled. The kernels return 1 if any element was out of
+   range of the destination type (and was set to missing). */
+#define ARRAY_INT2INT(SN, ST, DN, DT)                                             \
+static ARRAY_KERNEL int Convert_##SN##_##DN(arraylen_t n, const ST *restrict src, \
+                                            DT *restrict dst, DT dmiss)           \
+{                                                                                 \
+  arraylen_t i;                                                                   \
+  int range = 0;                                                                  \
+  for (i = 0; i < n; i++)                                                         \
+  {                                                                               \
+    ST s = src[i];                                                                \
+    int miss = ARRAY_ISMISSING_##SN(s);                                           \
+    int bad = (miss == 0) & ((ST)(DT)s != s);                                           \
+    range |= bad;                                                                 \
+    dst[i] = (miss | bad) ? dmiss : (DT)s;                                        \
+  }                                                                               \
+  return range;                                                                   \
+}
+
+/* Anything to integer, scaled (and floating point to integer, unscaled, with
+   bscale = 1 and bzero = 0) - the value is rounded as round() does, but without
+   a branch (v - trunc(v) is exact) - where the kernel isn't vectorized, a
+   branch on the fraction is mispredicted for half the pixels. Out-of-range
+   values are zeroed before the conversion so that it is defined for all
+   elements. */
+#define ARRAY_ROUND2INT(SN, ST, DN, DT)                                           \
+static ARRAY_KERNEL int ScaleConvert_##SN##_##DN(arraylen_t n, double bzero,      \
+                                                 double bscale,                   \
+                                                 const ST *restrict src,          \
+                                                 DT *restrict dst, DT dmiss)      \
+{                                                                                 \
+  arraylen_t i;                                                                   \
+  int range = 0;                                                                  \
+  for (i = 0; i < n; i++)                                                         \
+  {                                                                               \
+    ST s = src[i];                                                                \
+    double v = bscale * s + bzero;                                                \
+    double t = trunc(v);                                                          \
+    double r = t + copysign((double)(fabs(v - t) >= 0.5), v);                     \
+    int miss = ARRAY_ISMISSING_##SN(s);                                           \
+    int bad = (miss == 0) & ((r < ARRAY_MIN_##DN) | (r > ARRAY_MAX_##DN));              \
+    DT d;                                                                         \
+    range |= bad;                                                                 \
+    r = (miss | bad) ? 0.0 : r;                                                   \
+    d = (DT)r;                                                                    \
+    dst[i] = (miss | bad) ? dmiss : d;                                            \
+  }                                                                               \
+  return range;                                                                   \
+}
+
+/* Anything to floating point, unscaled and scaled. */
+#define ARRAY_TOFP(SN, ST, DN, DT)                                                \
+static ARRAY_KERNEL int Convert_##SN##_##DN(arraylen_t n, const ST *restrict src, \
+                                            DT *restrict dst, DT dmiss)           \
+{                                                                                 \
+  arraylen_t i;                                                                   \
+  int range = 0;                                                                  \
+  for (i = 0; i < n; i++)                                                         \
+  {                                                                               \
+    ST s = src[i];                                                                \
+    DT d = (DT)s;                                                                 \
+    int miss = ARRAY_ISMISSING_##SN(s);                                           \
+    int bad = (miss == 0) & ((s < -ARRAY_UMAX_##DN) | (s > ARRAY_UMAX_##DN));           \
+    range |= bad;                                                                 \
+    dst[i] = (miss | bad) ? dmiss : d;                                            \
+  }                                                                               \
+  return range;                                                                   \
+}                                                                                 \
+                                                                                  \
+static ARRAY_KERNEL int ScaleConvert_##SN##_##DN(arraylen_t n, double bzero,      \
+                                                 double bscale,                   \
+                                                 const ST *restrict src,          \
+                                                 DT *restrict dst, DT dmiss)      \
+{                                                                                 \
+  arraylen_t i;                                                                   \
+  int range = 0;                                                                  \
+  for (i = 0; i < n; i++)                                                         \
+  {                                                                               \
+    ST s = src[i];                                                                \
+    double v = bscale * s + bzero;                                                \
+    DT d = (DT)v;                                                                 \
+    int miss = ARRAY_ISMISSING_##SN(s);                                           \
+    int bad = (miss == 0) & ((v < -ARRAY_SMAX_##DN) | (v > ARRAY_SMAX_##DN));           \
+    range |= bad;                                                                 \
+    dst[i] = (miss | bad) ? dmiss : d;                                            \
+  }                                                                               \
+  return range;                                                                   \
+}
+
+#define ARRAY_TOINT_KERNELS(DN, DT) \
+  ARRAY_SRC_INT_TYPES(ARRAY_INT2INT, DN, DT) ARRAY_SRC_TYPES(ARRAY_ROUND2INT, DN, DT)
+#define ARRAY_TOFP_KERNELS(DN, DT) ARRAY_SRC_TYPES(ARRAY_TOFP, DN, DT)
+
+ARRAY_DST_INT_TYPES(ARRAY_TOINT_KERNELS)
+ARRAY_DST_FP_TYPES(ARRAY_TOFP_KERNELS)
+
+/* Dispatch on the source type. Floating-point sources have no unscaled kernel
+   to an integer type. */
+#define ARRAY_CASE_INT2INT(SN, ST, DN, DT, DMISS)                               \
+  case DRMS_TYPE_##SN:                                                          \
+    range = scaled ? ScaleConvert_##SN##_##DN(n, bzero, bscale, src, dst, DMISS) \
+                   : Convert_##SN##_##DN(n, src, dst, DMISS);                   \
+    break;
+#define ARRAY_CASE_FP2INT(SN, ST, DN, DT, DMISS)                                \
+  case DRMS_TYPE_##SN:                                                          \
+    range = ScaleConvert_##SN##_##DN(n, bzero, bscale, src, dst, DMISS);        \
+    break;
+#define ARRAY_CASE_TOFP(SN, ST, DN, DT, DMISS) ARRAY_CASE_INT2INT(SN, ST, DN, DT, DMISS)
+
+#define ARRAY_DISPATCH_TOINT(DN, DT)                                            \
+  case DRMS_TYPE_##DN:                                                          \
+    switch (src_type)                                                           \
+    {                                                                           \
+      ARRAY_SRC_INT_TYPES(ARRAY_CASE_INT2INT, DN, DT, DRMS_MISSING_##DN)        \
+      ARRAY_SRC_FP_TYPES(ARRAY_CASE_FP2INT, DN, DT, DRMS_MISSING_##DN)          \
+      default:                                                                  \
+        return DRMS_ERROR_INVALIDTYPE;                                          \
+    }                                                                           \
+    break;
+#define ARRAY_DISPATCH_TOFP(DN, DT)                                             \
+  case DRMS_TYPE_##DN:                                                          \
+    switch (src_type)                                                           \
+    {                                                                           \
+      ARRAY_SRC_TYPES(ARRAY_CASE_TOFP, DN, DT, DRMS_MISSING_##DN)               \
+      default:                                                                  \
+        return DRMS_ERROR_INVALIDTYPE;                                          \
+    }                                                                           \
+    break;
+
+/* Convert n numeric (not string) elements of type src_type to dst_type, applying
+   bscale and bzero. Missing values become missing values, and values out of
+   range of dst_type become missing values and make the return value DRMS_RANGE. */
+static int ArrayConvert(arraylen_t n, DRMS_Type_t src_type, double bzero, double bscale,
+                        const void *src, DRMS_Type_t dst_type, void *dst)
+{
+  int scaled = !(fabs(bzero) == 0.0 && bscale == 1.0);
+  int range = 0;
+
+  if (!scaled && src_type == dst_type)
+  {
+    memcpy(dst, src, n * drms_sizeof(dst_type));
+    return DRMS_SUCCESS;
+  }
+
+  switch (dst_type)
+  {
+    ARRAY_DST_INT_TYPES(ARRAY_DISPATCH_TOINT)
+    ARRAY_DST_FP_TYPES(ARRAY_DISPATCH_TOFP)
+    case DRMS_TYPE_TIME:
+      /* The DRMS_TYPE_DOUBLE kernels, with the time missing value. */
+      switch (src_type)
+      {
+        ARRAY_SRC_TYPES(ARRAY_CASE_TOFP, DOUBLE, double, DRMS_MISSING_TIME)
+        default:
+          return DRMS_ERROR_INVALIDTYPE;
+      }
+      break;
+    default:
+      return DRMS_ERROR_INVALIDTYPE;
+  }
+
+  return range ? DRMS_RANGE : DRMS_SUCCESS;
+}
 int drms_array2char(arraylen_t n, DRMS_Type_t src_type, double bzero, double bscale, 
 		    void *src,  char *dst)
 {
@@ -359,133 +634,15 @@ int drms_array2char(arraylen_t n, DRMS_Type_t src_type, double bzero, double bsc
   double value;
   double rangechk;
 
+  if (src_type != DRMS_TYPE_STRING)
+  {
+    return ArrayConvert(n, src_type, bzero, bscale, src, DRMS_TYPE_CHAR, dst);
+  }
+
   if (bzero == 0.0 && bscale==1.0)
   {
     switch(src_type)
     {
-    case DRMS_TYPE_CHAR:       
-      stat = DRMS_SUCCESS;
-      memcpy(dst,src,n);    
-      break;
-    case DRMS_TYPE_SHORT:
-      {
-	short *ssrc = (short *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{	  
-	  if (*ssrc == DRMS_MISSING_SHORT)
-	    *dst = DRMS_MISSING_CHAR;	    
-	  else if (!(*ssrc < SCHAR_MIN || *ssrc > SCHAR_MAX))
-	    *dst = (char) *ssrc;
-	  else
-	  {
-	    stat = DRMS_RANGE;  
-	    *dst = DRMS_MISSING_CHAR;
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_INT:  
-      {
-	int *ssrc = (int *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc == DRMS_MISSING_INT)
-	    *dst = DRMS_MISSING_CHAR;	    
-	  else if (!(*ssrc < SCHAR_MIN || *ssrc > SCHAR_MAX))
-	    *dst = (char) *ssrc;
-	  else
-	  {
-	    stat = DRMS_RANGE;  
-	    *dst = DRMS_MISSING_CHAR;
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      {
-	long long *ssrc = (long long *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-          if (*ssrc == DRMS_MISSING_LONGLONG)
-            *dst = DRMS_MISSING_CHAR;       
-          else if (!(*ssrc < SCHAR_MIN || *ssrc > SCHAR_MAX))
-            *dst = (char) *ssrc;
-          else
-	  {
-	    stat = DRMS_RANGE;  
-	    *dst = DRMS_MISSING_CHAR;
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_FLOAT:
-      {
-	float *ssrc = (float *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-          if (isnan(*ssrc))
-            *dst = DRMS_MISSING_CHAR;       
-          else 
-	  {
-	     rangechk = round(*ssrc);
-	     if (!(rangechk < SCHAR_MIN || rangechk > SCHAR_MAX))
-	       *dst = (char)rangechk;
-	     else
-	     {
-		stat = DRMS_RANGE;  
-		*dst = DRMS_MISSING_CHAR;
-	     }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_TIME: 
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-          if (*ssrc == DRMS_MISSING_TIME)
-            *dst = DRMS_MISSING_CHAR;       
-          else 
-	  {
-	     rangechk = round(*ssrc);
-	     if (!(rangechk < SCHAR_MIN || rangechk > SCHAR_MAX))
-	       *dst = (char)rangechk;
-	     else
-	     {
-		stat = DRMS_RANGE;  
-		*dst = DRMS_MISSING_CHAR;
-	     }
-	  }
-	}
-      }
-    case DRMS_TYPE_DOUBLE: 	
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-          if (isnan(*ssrc))
-            *dst = DRMS_MISSING_CHAR;       
-          else 
-	  {
-	     rangechk = round(*ssrc);
-	     if (!(rangechk < SCHAR_MIN || rangechk > SCHAR_MAX))
-	       *dst = (char)rangechk;
-	     else
-	     {
-		stat = DRMS_RANGE;  
-		*dst = DRMS_MISSING_CHAR;
-	     }
-	  }
-	}
-      }
-      break;
     case DRMS_TYPE_STRING: 
       {
 	double val;
@@ -523,170 +680,6 @@ int drms_array2char(arraylen_t n, DRMS_Type_t src_type, double bzero, double bsc
   {
     switch(src_type)
     {
-    case DRMS_TYPE_CHAR:       
-      {
-	char *ssrc = (char *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_CHAR)
-	    *dst = DRMS_MISSING_CHAR;
-	  else
-	  {
-	    value = bscale* *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < SCHAR_MIN || rangechk > SCHAR_MAX))
-	      *dst = (char)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_CHAR;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_SHORT:
-      {
-	short *ssrc = (short *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_SHORT)
-	    *dst = DRMS_MISSING_CHAR;
-	  else
-	  {
-	    value = bscale* *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < SCHAR_MIN || rangechk > SCHAR_MAX))
-	      *dst = (char)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_CHAR;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_INT:  
-      {
-	int *ssrc = (int *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_INT)
-	    *dst = DRMS_MISSING_CHAR;
-	  else
-	  {
-	    value = bscale* *ssrc + bzero;
-
-	    rangechk = round(value);
-	    if (!(rangechk < SCHAR_MIN || rangechk > SCHAR_MAX))
-	      *dst = (char)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_CHAR;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      {
-	long long *ssrc = (long long *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_LONGLONG)
-	    *dst = DRMS_MISSING_CHAR;
-	  else
-	  {
-	    value = bscale* *ssrc + bzero;
-
-	    rangechk = round(value);
-	    if (!(rangechk < SCHAR_MIN || rangechk > SCHAR_MAX))
-	      *dst = (char)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_CHAR;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_FLOAT:
-      {
-	float *ssrc = (float *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	    *dst = DRMS_MISSING_CHAR;
-	  else
-	  {
-	    value = bscale* *ssrc + bzero;
-
-	    rangechk = round(value);
-	    if (!(rangechk < SCHAR_MIN || rangechk > SCHAR_MAX))
-	      *dst = (char)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_CHAR;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_TIME: 
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_TIME)
-	    *dst = DRMS_MISSING_CHAR;
-	  else
-	  {
-	    value = bscale* *ssrc + bzero;
-
-	    rangechk = round(value);
-	    if (!(rangechk < SCHAR_MIN || rangechk > SCHAR_MAX))
-	      *dst = (char)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_CHAR;
-	    }
-	  }
-	}
-      }
-    case DRMS_TYPE_DOUBLE: 	
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	    *dst = DRMS_MISSING_CHAR;
-	  else
-	  {
-	    value = bscale* *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < SCHAR_MIN || rangechk > SCHAR_MAX))
-	      *dst = (char)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_CHAR;
-	    }
-	  }
-	}
-      }
-      break;
     case DRMS_TYPE_STRING: 
       {
 	char *endptr;
@@ -733,134 +726,20 @@ int drms_array2short(arraylen_t n, DRMS_Type_t src_type, double bzero, double bs
   arraylen_t i;
   double rangechk;
 
+  if (src_type != DRMS_TYPE_STRING)
+  {
+    return ArrayConvert(n, src_type, bzero, bscale, src, DRMS_TYPE_SHORT, dst);
+  }
+
   if (fabs(bzero)==0.0 && bscale==1.0)
   {
     switch(src_type)
     {
-    case DRMS_TYPE_CHAR:       
-      {
-	char *ssrc = (char *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-          if (*ssrc == DRMS_MISSING_CHAR)
-            *dst = DRMS_MISSING_SHORT;       
-          else 	
-	    *dst = (short) *ssrc;
-	}
-      }
-      break;
-    case DRMS_TYPE_SHORT:
-      stat = DRMS_SUCCESS;
-      memcpy(dst,src,n*sizeof(short));    
-      break;
-    case DRMS_TYPE_INT:  
+    case DRMS_TYPE_STRING: 
       {
-	int *ssrc = (int *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc == DRMS_MISSING_INT)
-            *dst = DRMS_MISSING_SHORT;       
-	  else if (!(*ssrc < SHRT_MIN || *ssrc > SHRT_MAX))
-	    *dst = (short) *ssrc;
-	  else
-	  {
-	    stat = DRMS_RANGE;  
-	    *dst = DRMS_MISSING_SHORT;
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      {
-	long long *ssrc = (long long *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc == DRMS_MISSING_LONGLONG)
-            *dst = DRMS_MISSING_SHORT;       
-	  else 	  if (!(*ssrc < SHRT_MIN || *ssrc > SHRT_MAX))
-	    *dst = (short) *ssrc;
-	  else
-	  {
-	    stat = DRMS_RANGE;  
-	    *dst = DRMS_MISSING_SHORT;
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_FLOAT:
-      {
-	float *ssrc = (float *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-            *dst = DRMS_MISSING_SHORT;       
-	  else
-	  {
-	     rangechk = round(*ssrc);
-	     if (!(rangechk < SHRT_MIN || rangechk > SHRT_MAX))
-	       *dst = (short)rangechk;
-	     else
-	     {
-		stat = DRMS_RANGE;  
-		*dst = DRMS_MISSING_SHORT;
-	     }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_TIME: 
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc == DRMS_MISSING_TIME)
-            *dst = DRMS_MISSING_SHORT;       
-	  else 
-	  {
-	     rangechk = round(*ssrc);
-	     if (!(rangechk < SHRT_MIN || rangechk > SHRT_MAX))
-	       *dst = (short)rangechk;
-	     else
-	     {
-		stat = DRMS_RANGE;  
-		*dst = DRMS_MISSING_SHORT;
-	     }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_DOUBLE: 	
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-            *dst = DRMS_MISSING_SHORT;       
-	  else
-	  {
-	     rangechk = round(*ssrc);
-	     if (!(rangechk < SHRT_MIN || rangechk > SHRT_MAX))
-	       *dst = (short)rangechk;
-	     else
-	     {
-		stat = DRMS_RANGE;  
-		*dst = DRMS_MISSING_SHORT;
-	     }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_STRING: 
-      {
-	double val;
-	char *endptr;
-	char **ssrc = (char **) src;
+	double val;
+	char *endptr;
+	char **ssrc = (char **) src;
 	stat = DRMS_SUCCESS;
 	for (i=0; i<n; i++, ssrc++, dst++)
 	{
@@ -892,166 +771,6 @@ int drms_array2short(arraylen_t n, DRMS_Type_t src_type, double bzero, double bs
   {
     switch(src_type)
     {
-    case DRMS_TYPE_CHAR:       
-      {
-	char *ssrc = (char *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_CHAR)
-	    *dst = DRMS_MISSING_SHORT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < SHRT_MIN || rangechk > SHRT_MAX))
-	      *dst = (short)round(rangechk);
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_SHORT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_SHORT:
-      {
-	short *ssrc = (short *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_SHORT)
-	    *dst = DRMS_MISSING_SHORT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < SHRT_MIN || rangechk > SHRT_MAX))
-	      *dst = (short)round(rangechk);
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_SHORT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_INT:  
-      {
-	int *ssrc = (int *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_INT)
-	    *dst = DRMS_MISSING_SHORT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < SHRT_MIN || rangechk > SHRT_MAX))
-	      *dst = (short)round(rangechk);
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_SHORT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      {
-	long long *ssrc = (long long *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_LONGLONG)
-	    *dst = DRMS_MISSING_SHORT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < SHRT_MIN || rangechk > SHRT_MAX))
-	      *dst = (short)round(rangechk);
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_SHORT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_FLOAT:
-      {
-	float *ssrc = (float *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	    *dst = DRMS_MISSING_SHORT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < SHRT_MIN || rangechk > SHRT_MAX))
-	      *dst = (short)round(rangechk);
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_SHORT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_TIME: 
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_TIME)
-	    *dst = DRMS_MISSING_SHORT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < SHRT_MIN || rangechk > SHRT_MAX))
-	      *dst = (short)round(rangechk);
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_SHORT;
-	    }
-	  }
-	}
-      }
-    case DRMS_TYPE_DOUBLE: 	
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	    *dst = DRMS_MISSING_SHORT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < SHRT_MIN || rangechk > SHRT_MAX))
-	      *dst = (short)round(rangechk);
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_SHORT;
-	    }
-	  }
-	}
-      }
-      break;
     case DRMS_TYPE_STRING: 
       {
 	char *endptr;
@@ -1098,120 +817,15 @@ int drms_array2int(arraylen_t n, DRMS_Type_t src_type, double bzero, double bsca
   arraylen_t i;
   double rangechk;
 
+  if (src_type != DRMS_TYPE_STRING)
+  {
+    return ArrayConvert(n, src_type, bzero, bscale, src, DRMS_TYPE_INT, dst);
+  }
+
   if (fabs(bzero)==0.0 && bscale==1.0)
   {
     switch(src_type)
     {
-    case DRMS_TYPE_CHAR:       
-      {
-	char *ssrc = (char *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_CHAR)
-            *dst = DRMS_MISSING_INT;       
-	  else 
-	    *dst = (int) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_SHORT:
-      {
-	short *ssrc = (short *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_SHORT)
-            *dst = DRMS_MISSING_INT;       
-	  else 
-	    *dst = (int) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_INT:  
-      stat = DRMS_SUCCESS;
-      memcpy(dst,src,n*sizeof(int));    
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      {
-	long long *ssrc = (long long *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc == DRMS_MISSING_LONGLONG)
-            *dst = DRMS_MISSING_INT;       
-	  else if (!(*ssrc < INT_MIN || *ssrc > INT_MAX))
-	    *dst = (int) *ssrc;
-	  else
-	  {
-	    stat = DRMS_RANGE;  
-	    *dst = DRMS_MISSING_INT;
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_FLOAT:
-      {
-	float *ssrc = (float *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-            *dst = DRMS_MISSING_INT;       
-	  else 
-	  {
-	     rangechk = round(*ssrc);
-	     if (!(rangechk < INT_MIN || rangechk > INT_MAX))
-	       *dst = (int)rangechk;
-	     else
-	     {
-		stat = DRMS_RANGE;  
-		*dst = DRMS_MISSING_INT;
-	     }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_TIME: 
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc == DRMS_MISSING_TIME)
-            *dst = DRMS_MISSING_INT;       
-	  else
-	  {
-	     rangechk = round(*ssrc);
-	     if (!(rangechk < INT_MIN || rangechk > INT_MAX))
-	       *dst = (int)rangechk;
-	     else
-	     {
-		stat = DRMS_RANGE;  
-		*dst = DRMS_MISSING_INT;
-	     }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_DOUBLE: 	
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-            *dst = DRMS_MISSING_INT;       
-	  else
-	  {
-	     rangechk = round(*ssrc);
-	     if (!(rangechk < INT_MIN || rangechk > INT_MAX))
-	       *dst = (int)rangechk;
-	     else
-	     {
-		stat = DRMS_RANGE;  
-		*dst = DRMS_MISSING_INT;
-	     }
-	  }
-	}
-      }
-      break;
     case DRMS_TYPE_STRING: 
       {
 	double val;
@@ -1248,179 +862,17 @@ int drms_array2int(arraylen_t n, DRMS_Type_t src_type, double bzero, double bsca
   {
     switch(src_type)
     {
-    case DRMS_TYPE_CHAR:       
+    case DRMS_TYPE_STRING: 
       {
-	char *ssrc = (char *) src;
+	char *endptr;
+	char **ssrc = (char **) src;
 	stat = DRMS_SUCCESS;
 	for (i=0; i<n; i++, ssrc++, dst++)
 	{
-	  if (*ssrc==DRMS_MISSING_CHAR)
-	    *dst = DRMS_MISSING_INT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < INT_MIN || rangechk > INT_MAX))
-	      *dst = (int)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_INT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_SHORT:
-      {
-	short *ssrc = (short *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_SHORT)
-	    *dst = DRMS_MISSING_INT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < INT_MIN || rangechk > INT_MAX))
-	      *dst = (int)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_INT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_INT:  
-      {
-	int *ssrc = (int *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_INT)
-	    *dst = DRMS_MISSING_INT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < INT_MIN || rangechk > INT_MAX))
-	      *dst = (int)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_INT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      {
-	long long *ssrc = (long long *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_LONGLONG)
-	    *dst = DRMS_MISSING_INT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < INT_MIN || rangechk > INT_MAX))
-	      *dst = (int)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_INT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_FLOAT:
-      {
-	float *ssrc = (float *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	  {
-	    *dst = DRMS_MISSING_INT;
-	  }
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < INT_MIN || rangechk > INT_MAX))
-	      *dst = (int)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_INT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_TIME: 
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_TIME)
-	    *dst = DRMS_MISSING_INT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < INT_MIN || rangechk > INT_MAX))
-	      *dst = (int)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_INT;
-	    }
-	  }
-	}
-      }
-    case DRMS_TYPE_DOUBLE: 	
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	    *dst = DRMS_MISSING_INT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < INT_MIN || rangechk > INT_MAX))
-	      *dst = (int)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_INT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_STRING: 
-      {
-	char *endptr;
-	char **ssrc = (char **) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  value = strtod(*ssrc,&endptr);
-	  if (value==0.0 && endptr==*ssrc )	
-	  {	  
-	    stat = DRMS_BADSTRING;
+	  value = strtod(*ssrc,&endptr);
+	  if (value==0.0 && endptr==*ssrc )	
+	  {	  
+	    stat = DRMS_BADSTRING;
 	    *dst = DRMS_MISSING_INT;
 	  }
 	  else 
@@ -1454,113 +906,15 @@ int drms_array2longlong(arraylen_t n, DRMS_Type_t src_type, double bzero,
   arraylen_t i;
   double rangechk;
 
+  if (src_type != DRMS_TYPE_STRING)
+  {
+    return ArrayConvert(n, src_type, bzero, bscale, src, DRMS_TYPE_LONGLONG, dst);
+  }
+
   if (fabs(bzero)==0.0 && bscale==1.0)
   {
     switch(src_type)
     {
-    case DRMS_TYPE_CHAR:       
-      {
-	char *ssrc = (char *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_CHAR)
-            *dst = DRMS_MISSING_LONGLONG;       
-	  else 	 
-	    *dst = (long long) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_SHORT:
-      {
-	short *ssrc = (short *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_SHORT)
-            *dst = DRMS_MISSING_LONGLONG;       
-	  else 	
-	    *dst = (long long) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_INT:  
-      {
-	int *ssrc = (int *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_INT)
-            *dst = DRMS_MISSING_LONGLONG;       
-	  else 
-	    *dst = (long long) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      stat = DRMS_SUCCESS;
-      memcpy(dst,src,n*sizeof(long long));    
-      break;
-    case DRMS_TYPE_FLOAT:
-      {
-	float *ssrc = (float *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-            *dst = DRMS_MISSING_LONGLONG;       
-	  else 
-	  {
-	     rangechk = round(*ssrc);
-	     if (!(rangechk < LLONG_MIN || rangechk > LLONG_MAX))
-	       *dst = (long long)rangechk;
-	     else
-	     {
-		stat = DRMS_RANGE;  
-		*dst = DRMS_MISSING_LONGLONG;
-	     }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_TIME: 
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc == DRMS_MISSING_TIME)
-            *dst = DRMS_MISSING_LONGLONG;       
-	  else 
-	  {
-	     rangechk = round(*ssrc);
-	     if (!(rangechk < LLONG_MIN || rangechk > LLONG_MAX))
-	       *dst = (long long)rangechk;
-	     else
-	     {
-		stat = DRMS_RANGE;  
-		*dst = DRMS_MISSING_LONGLONG;
-	     }
-
-	  }
-	}
-      }
-    case DRMS_TYPE_DOUBLE: 	
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-            *dst = DRMS_MISSING_LONGLONG;       
-	  else
-	  {
-	     rangechk = round(*ssrc);
-	     if (!(rangechk < LLONG_MIN || rangechk > LLONG_MAX))
-	       *dst = (long long)rangechk;
-	     else
-	     {
-		stat = DRMS_RANGE;  
-		*dst = DRMS_MISSING_LONGLONG;
-	     }
-	  }
-	}
-      }
-      break;
     case DRMS_TYPE_STRING: 
       {
 	double val;
@@ -1597,167 +951,6 @@ int drms_array2longlong(arraylen_t n, DRMS_Type_t src_type, double bzero,
   {
     switch(src_type)
     {
-    case DRMS_TYPE_CHAR:       
-      {
-	char *ssrc = (char *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_CHAR)
-	    *dst = DRMS_MISSING_LONGLONG;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < LLONG_MIN || rangechk > LLONG_MAX))
-	      *dst = (long long)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_LONGLONG;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_SHORT:
-      {
-	short *ssrc = (short *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_SHORT)
-	    *dst = DRMS_MISSING_LONGLONG;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < LLONG_MIN || rangechk > LLONG_MAX))
-	      *dst = (long long)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_LONGLONG;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_INT:  
-      {
-	int *ssrc = (int *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_INT)
-	    *dst = DRMS_MISSING_LONGLONG;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < LLONG_MIN || rangechk > LLONG_MAX))
-	      *dst = (long long)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_LONGLONG;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      {
-	long long *ssrc = (long long *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_LONGLONG)
-	    *dst = DRMS_MISSING_LONGLONG;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < LLONG_MIN || rangechk > LLONG_MAX))
-	      *dst = (long long)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_LONGLONG;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_FLOAT:
-      {
-	float *ssrc = (float *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	    *dst = DRMS_MISSING_LONGLONG;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < LLONG_MIN || rangechk > LLONG_MAX))
-	      *dst = (long long)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_LONGLONG;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_TIME: 
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_TIME)
-	    *dst = DRMS_MISSING_LONGLONG;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < LLONG_MIN || rangechk > LLONG_MAX))
-	      *dst = (long long)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_LONGLONG;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_DOUBLE: 	
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	    *dst = DRMS_MISSING_LONGLONG;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    rangechk = round(value);
-	    if (!(rangechk < LLONG_MIN || rangechk > LLONG_MAX))
-	      *dst = (long long)rangechk;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_LONGLONG;
-	    }
-	  }
-	}
-      }
-      break;
     case DRMS_TYPE_STRING: 
       {
 	char *endptr;
@@ -1804,93 +997,15 @@ int drms_array2float(arraylen_t n, DRMS_Type_t src_type, double bzero, double bs
   int stat;
   arraylen_t i;
 
+  if (src_type != DRMS_TYPE_STRING)
+  {
+    return ArrayConvert(n, src_type, bzero, bscale, src, DRMS_TYPE_FLOAT, dst);
+  }
+
   if ( fabs(bzero)==0.0 && bscale==1.0 )
   {
     switch(src_type)
     {
-    case DRMS_TYPE_CHAR:       
-      {
-	char *ssrc = (char *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_CHAR)
-            *dst = DRMS_MISSING_FLOAT;       
-	  else 	
-	    *dst = (float) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_SHORT:
-      {
-	short *ssrc = (short *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_SHORT)
-            *dst = DRMS_MISSING_FLOAT;       
-	  else 	
-	    *dst = (float) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_INT:  
-      {
-	int *ssrc = (int *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_INT)
-            *dst = DRMS_MISSING_FLOAT;       
-	  else 	
-	    *dst = (float) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      {
-	long long *ssrc = (long long *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_LONGLONG)
-            *dst = DRMS_MISSING_FLOAT;       
-	  else 	
-	    *dst = (float) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_FLOAT:
-      stat = DRMS_SUCCESS;
-      memcpy(dst,src,n);    
-      break;
-    case DRMS_TYPE_TIME: 
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc == DRMS_MISSING_TIME)
-            *dst = DRMS_MISSING_FLOAT;       
-	  else 	if (!(*ssrc < -FLT_MAX || *ssrc > FLT_MAX))
-	    *dst = (float) *ssrc;
-	  else
-	  {
-	    stat = DRMS_RANGE;  
-	    *dst = DRMS_MISSING_FLOAT;
-	  }
-	}
-      }
-    case DRMS_TYPE_DOUBLE: 	
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-            *dst = DRMS_MISSING_FLOAT;       
-	  else 	if (!(*ssrc < -FLT_MAX || *ssrc > FLT_MAX))
-	    *dst = (float) *ssrc;
-	  else
-	  {
-	    stat = DRMS_RANGE;  
-	    *dst = DRMS_MISSING_FLOAT;
-	  }
-	}
-      }
-      break;
     case DRMS_TYPE_STRING: 
       {
 	float val;
@@ -1923,159 +1038,6 @@ int drms_array2float(arraylen_t n, DRMS_Type_t src_type, double bzero, double bs
   {
     switch(src_type)
     {
-    case DRMS_TYPE_CHAR:       
-      {
-	char *ssrc = (char *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_CHAR)
-	    *dst = DRMS_MISSING_FLOAT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -FLT_MAX || value > FLT_MAX))
-	      *dst = (float) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_FLOAT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_SHORT:
-      {
-	short *ssrc = (short *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_SHORT)
-	    *dst = DRMS_MISSING_FLOAT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -FLT_MAX || value > FLT_MAX))
-	      *dst = (float) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_FLOAT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_INT:  
-      {
-	int *ssrc = (int *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_INT)
-	    *dst = DRMS_MISSING_FLOAT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -FLT_MAX || value > FLT_MAX))
-	      *dst = (float) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_FLOAT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      {
-	long long *ssrc = (long long *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_LONGLONG)
-	    *dst = DRMS_MISSING_FLOAT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -FLT_MAX || value > FLT_MAX))
-	      *dst = (float) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_FLOAT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_FLOAT:
-      {
-	float *ssrc = (float *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	    *dst = DRMS_MISSING_FLOAT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -FLT_MAX || value > FLT_MAX))
-	      *dst = (float) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_FLOAT;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_TIME: 
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_TIME)
-	    *dst = DRMS_MISSING_FLOAT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -FLT_MAX || value > FLT_MAX))
-	      *dst = (float) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_FLOAT;
-	    }
-	  }
-	}
-      }
-    case DRMS_TYPE_DOUBLE: 	
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	    *dst = DRMS_MISSING_FLOAT;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -FLT_MAX || value > FLT_MAX))
-	      *dst = (float) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_FLOAT;
-	    }
-	  }
-	}
-      }
-      break;
     case DRMS_TYPE_STRING: 
       {
 	char *endptr;
@@ -2123,80 +1085,15 @@ int drms_array2double(arraylen_t n, DRMS_Type_t src_type, double bzero, double b
   int stat;
   arraylen_t i;
 
-  if (fabs(bzero)==0.0 && bscale==1.0)
-  {
-    switch(src_type)
-    {
-    case DRMS_TYPE_CHAR:       
-      {
-	char *ssrc = (char *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_CHAR)
-            *dst = DRMS_MISSING_DOUBLE;       
-	  else 
-	    *dst = (double) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_SHORT:
-      {
-	short *ssrc = (short *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_SHORT)
-            *dst = DRMS_MISSING_DOUBLE;       
-	  else 
-	    *dst = (double) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_INT:  
-      {
-	int *ssrc = (int *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_INT)
-            *dst = DRMS_MISSING_DOUBLE;       
-	  else 
-	    *dst = (double) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      {
-	long long *ssrc = (long long *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_LONGLONG)
-            *dst = DRMS_MISSING_DOUBLE;       
-	  else 
-	    *dst = (double) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_FLOAT:
-      {
-	float *ssrc = (float *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (isnan(*ssrc))
-            *dst = DRMS_MISSING_DOUBLE;       
-	  else 
-	    *dst = (double) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_TIME: 
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_TIME)
-            *dst = DRMS_MISSING_DOUBLE;       
-	  else 
-	    *dst = (double) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_DOUBLE: 	
-      stat = DRMS_SUCCESS;
-      memcpy(dst,src,n*sizeof(double));
-      break;
+  if (src_type != DRMS_TYPE_STRING)
+  {
+    return ArrayConvert(n, src_type, bzero, bscale, src, DRMS_TYPE_DOUBLE, dst);
+  }
+
+  if (fabs(bzero)==0.0 && bscale==1.0)
+  {
+    switch(src_type)
+    {
     case DRMS_TYPE_STRING: 
       {
 	double val;
@@ -2229,160 +1126,6 @@ int drms_array2double(arraylen_t n, DRMS_Type_t src_type, double bzero, double b
   {
     switch(src_type)
     {
-    case DRMS_TYPE_CHAR:       
-      {
-	char *ssrc = (char *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_CHAR)
-	    *dst = DRMS_MISSING_DOUBLE;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_DOUBLE;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_SHORT:
-      {
-	short *ssrc = (short *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_SHORT)
-	    *dst = DRMS_MISSING_DOUBLE;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_DOUBLE;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_INT:  
-      {
-	int *ssrc = (int *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_INT)
-	    *dst = DRMS_MISSING_DOUBLE;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_DOUBLE;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      {
-	long long *ssrc = (long long *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_LONGLONG)
-	    *dst = DRMS_MISSING_DOUBLE;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_DOUBLE;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_FLOAT:
-      {
-	float *ssrc = (float *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	    *dst = DRMS_MISSING_DOUBLE;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_DOUBLE;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_TIME: 
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_TIME)
-	    *dst = DRMS_MISSING_TIME;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_TIME;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_DOUBLE: 	
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	    *dst = DRMS_MISSING_DOUBLE;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_DOUBLE;
-	    }
-	  }
-	}
-      }
-      break;
     case DRMS_TYPE_STRING: 
       {
 	char *endptr;
@@ -2431,80 +1174,15 @@ int drms_array2time(arraylen_t n, DRMS_Type_t src_type, double bzero, double bsc
   int stat;
   arraylen_t i;
 
+  if (src_type != DRMS_TYPE_STRING)
+  {
+    return ArrayConvert(n, src_type, bzero, bscale, src, DRMS_TYPE_TIME, dst);
+  }
+
   if (fabs(bzero)==0.0 && bscale==1.0)
   {
     switch(src_type)
     {
-    case DRMS_TYPE_CHAR:       
-      {
-	char *ssrc = (char *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_CHAR)
-            *dst = DRMS_MISSING_TIME;       
-	  else 
-	    *dst = (double) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_SHORT:
-      {
-	short *ssrc = (short *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_SHORT)
-            *dst = DRMS_MISSING_TIME;       
-	  else 
-	    *dst = (double) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_INT:  
-      {
-	int *ssrc = (int *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_INT)
-            *dst = DRMS_MISSING_TIME;       
-	  else 
-	    *dst = (double) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      {
-	long long *ssrc = (long long *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (*ssrc == DRMS_MISSING_LONGLONG)
-            *dst = DRMS_MISSING_TIME;       
-	  else 
-	    *dst = (double) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_FLOAT:
-      {
-	float *ssrc = (float *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (isnan(*ssrc))
-            *dst = DRMS_MISSING_TIME;       
-	  else 
-	    *dst = (double) *ssrc;
-      }
-      break;
-    case DRMS_TYPE_TIME: 
-      stat = DRMS_SUCCESS;
-      memcpy(dst,src,n*sizeof(double));
-      break;
-    case DRMS_TYPE_DOUBLE: 	
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	  if (isnan(*ssrc))
-            *dst = DRMS_MISSING_TIME;       
-	  else 
-	    *dst = (double) *ssrc;
-      }
-      break;
     case DRMS_TYPE_STRING: 
       {
 	double val;
@@ -2531,159 +1209,6 @@ int drms_array2time(arraylen_t n, DRMS_Type_t src_type, double bzero, double bsc
   {
     switch(src_type)
     {
-    case DRMS_TYPE_CHAR:       
-      {
-	char *ssrc = (char *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_CHAR)
-	    *dst = DRMS_MISSING_TIME;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_TIME;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_SHORT:
-      {
-	short *ssrc = (short *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_SHORT)
-	    *dst = DRMS_MISSING_TIME;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_TIME;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_INT:  
-      {
-	int *ssrc = (int *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_INT)
-	    *dst = DRMS_MISSING_TIME;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_TIME;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_LONGLONG:  
-      {
-	long long *ssrc = (long long *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_LONGLONG)
-	    *dst = DRMS_MISSING_TIME;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_TIME;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_FLOAT:
-      {
-	float *ssrc = (float *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	    *dst = DRMS_MISSING_TIME;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_TIME;
-	    }
-	  }
-	}
-      }
-      break;
-    case DRMS_TYPE_TIME: 
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (*ssrc==DRMS_MISSING_TIME)
-	    *dst = DRMS_MISSING_TIME;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_TIME;
-	    }
-	  }
-	}
-      }
-    case DRMS_TYPE_DOUBLE: 	
-      {
-	double *ssrc = (double *) src;
-	stat = DRMS_SUCCESS;
-	for (i=0; i<n; i++, ssrc++, dst++)
-	{
-	  if (isnan(*ssrc))
-	    *dst = DRMS_MISSING_TIME;
-	  else
-	  {
-	    value = bscale * *ssrc + bzero;
-	    if (!(value < -DBL_MAX || value > DBL_MAX))
-	      *dst = (double) value;
-	    else
-	    {
-	      stat = DRMS_RANGE;  
-	      *dst = DRMS_MISSING_TIME;
-	    }
-	  }
-	}
-      }
-      break;
     case DRMS_TYPE_STRING: 
       {
 	char **ssrc = (char **) src;
@@ -703,6 +703,30 @@ DRMS_Array_t *drms_array_create(DRMS_Type_t type, int naxis,
    @param src The DRMS array struct to free.
 */
 void drms_free_array(DRMS_Array_t *src);
+
+/**
+   Frees @a arr->data (or, if @a arr->data are part of a file mapped with
+   ::drms_array_mapfile, unmaps the file), and sets @a arr->data to NULL.
+
+   @param arr The DRMS array struct whose data are freed.
+*/
+void drms_array_freedata(DRMS_Array_t *arr);
+
+/**
+   Maps @a len bytes of file @a filename, starting at byte @a offset, into
+   memory and makes them the data of @a arr. The mapping is private - the
+   data may be modified, but the file is not. The data must be released with
+   ::drms_free_array or ::drms_array_freedata, never with free(), and
+   @a arr->data must not be replaced before they are (@a arr->mapaddr
+   alone says the data are mapped).
+
+   @param arr The DRMS array struct whose data are mapped.
+   @param filename The file to map.
+   @param offset The offset in @a filename of the first byte of the data.
+   @param len The number of bytes of data.
+   @return DRMS status (see drms_statuscodes.h). 0 if successful, non-0 otherwise.
+*/
+int drms_array_mapfile(DRMS_Array_t *arr, const char *filename, long long offset, long long len);
 /* @} */
 
 
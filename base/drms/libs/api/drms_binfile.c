@@ -133,6 +133,21 @@ bailout:
   return 1;
 }
 
+/*
+ *  Read the header of a binary file into rf (as drms_binfile_read with nodata
+ *  set) and return in dataoffset the offset of the data in the file.
+ */
+int drms_binfile_readlayout (char *filename, DRMS_Array_t *rf,
+    long long *dataoffset) {
+  if (drms_binfile_read (filename, 1, rf)) return 1;
+			     /*  magic, type, naxis, axis1 ... axisn, buflen  */
+  *dataoffset = 8 + 4 + 4 + 4 * rf->naxis + 8;
+  if (rf->type == DRMS_TYPE_CHAR || rf->type == DRMS_TYPE_SHORT ||
+      rf->type == DRMS_TYPE_INT || rf->type == DRMS_TYPE_LONGLONG)
+    *dataoffset += 16;					/*  bscale, bzero  */
+  return 0;
+}
+
 int drms_binfile_write (char *filename, DRMS_Array_t *rf) {
   int i;
   FILE *fp;
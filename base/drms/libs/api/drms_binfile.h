@@ -6,6 +6,7 @@
 #define __DRMS_BINFILE_H
 
 int drms_binfile_read(char *filename, int nodata, DRMS_Array_t *ar);
+int drms_binfile_readlayout(char *filename, DRMS_Array_t *ar, long long *dataoffset);
 int drms_binfile_write(char *filename, DRMS_Array_t *arr);
 int drms_zipfile_read(char *filename, int nodata,DRMS_Array_t *ar);
 int drms_zipfile_write(char *filename, DRMS_Array_t *rf);
@@ -22,6 +23,12 @@ int drms_zipfile_write(char *filename, DRMS_Array_t *rf);
    blah blah
 */
 
+/**
+   @fn int drms_binfile_readlayout(char *filename, DRMS_Array_t *ar, long long *dataoffset)
+   Reads the header of a binary file (as ::drms_binfile_read with nodata set), and
+   returns the offset of the data in the file.
+*/
+
 /**
    @fn int drms_binfile_write(char *filename, DRMS_Array_t *arr)
    blah blah
@@ -38,6 +38,139 @@ int drms_cache_init(DRMS_Env_t *env) {
   return 0;
 }
 
+/* drms_server creates a lock for each cache its server threads share; clients and modules have none, and
+ * drms_lock_cache() and drms_unlock_cache() are no-ops on a NULL lock. */
+DRMS_CacheLock_t *drms_cache_lock_create(void)
+{
+  DRMS_CacheLock_t *lock = NULL;
+
+  lock = calloc(1, sizeof(DRMS_CacheLock_t));
+  XASSERT(lock);
+  pthread_rwlock_init(&lock->lock, NULL);
+  pthread_mutex_init(&lock->writermtx, NULL);
+
+  return lock;
+}
+
+void drms_cache_lock_destroy(DRMS_CacheLock_t **lock)
+{
+  if (lock && *lock)
+  {
+    pthread_rwlock_destroy(&(*lock)->lock);
+    pthread_mutex_destroy(&(*lock)->writermtx);
+    free(*lock);
+    *lock = NULL;
+  }
+}
+
+/* Returns 1 if this thread holds lock for writing; if so, counts another hold. */
+static int CacheLockRetake(DRMS_CacheLock_t *lock)
+{
+  int mine;
+
+  pthread_mutex_lock(&lock->writermtx);
+  mine = (lock->nwrite > 0 && pthread_equal(lock->writer, pthread_self()));
+  if (mine)
+  {
+    lock->nwrite++;
+  }
+  pthread_mutex_unlock(&lock->writermtx);
+
+  return mine;
+}
+
+void drms_lock_cache(DRMS_CacheLock_t *lock, int write)
+{
+  if (!lock || CacheLockRetake(lock))
+  {
+    return;
+  }
+
+  if (write)
+  {
+    pthread_rwlock_wrlock(&lock->lock);
+    pthread_mutex_lock(&lock->writermtx);
+    lock->writer = pthread_self();
+    lock->nwrite = 1;
+    pthread_mutex_unlock(&lock->writermtx);
+  }
+  else
+  {
+    pthread_rwlock_rdlock(&lock->lock);
+  }
+}
+
+void drms_unlock_cache(DRMS_CacheLock_t *lock)
+{
+  int release = 1;
+
+  if (!lock)
+  {
+    return;
+  }
+
+  pthread_mutex_lock(&lock->writermtx);
+  if (lock->nwrite > 0 && pthread_equal(lock->writer, pthread_self()))
+  {
+    release = (--lock->nwrite == 0);
+  }
+  pthread_mutex_unlock(&lock->writermtx);
+
+  if (release)
+  {
+    pthread_rwlock_unlock(&lock->lock);
+  }
+}
+
+/* One-call series_cache and record_cache operations, each under the cache's lock. A template or record
+ * pointer stays valid after the lock is released - only its removal from the cache frees it. */
+DRMS_Record_t *drms_series_cache_lookup(DRMS_Env_t *env, const char *series)
+{
+  DRMS_Record_t *template = NULL;
+
+  drms_lock_cache(env->series_cache_lock, 0);
+  template = (DRMS_Record_t *)hcon_lookup_lower(&env->series_cache, series);
+  drms_unlock_cache(env->series_cache_lock);
+
+  return template;
+}
+
+void drms_series_cache_remove(DRMS_Env_t *env, const char *series)
+{
+  drms_lock_cache(env->series_cache_lock, 1);
+  hcon_remove(&env->series_cache, series);
+  drms_unlock_cache(env->series_cache_lock);
+}
+
+DRMS_Record_t *drms_record_cache_lookup(DRMS_Env_t *env, const char *hashkey)
+{
+  DRMS_Record_t *rec = NULL;
+
+  drms_lock_cache(env->record_cache_lock, 0);
+  rec = (DRMS_Record_t *)hcon_lookup(&env->record_cache, hashkey);
+  drms_unlock_cache(env->record_cache_lock);
+
+  return rec;
+}
+
+DRMS_Record_t *drms_record_cache_allocslot(DRMS_Env_t *env, const char *hashkey)
+{
+  DRMS_Record_t *rec = NULL;
+
+  drms_lock_cache(env->record_cache_lock, 1);
+  rec = (DRMS_Record_t *)hcon_allocslot(&env->record_cache, hashkey);
+  drms_unlock_cache(env->record_cache_lock);
+
+  return rec;
+}
+
+void drms_record_cache_remove(DRMS_Env_t *env, const char *hashkey)
+{
+  drms_lock_cache(env->record_cache_lock, 1);
+  hcon_remove(&env->record_cache, hashkey);
+  drms_unlock_cache(env->record_cache_lock);
+}
+
 DRMS_Env_t *drms_open (const char *host, const char *user, const char *password, const char *dbname,
     const char *sessionns) {
      /*  NB: the parameters dbname & sessionns are only used if DRMS_CLIENT
@@ -155,6 +288,9 @@ void drms_free_env (DRMS_Env_t *env, int final) {
         env->clientlock = NULL;
     }
 
+    drms_cache_lock_destroy(&env->series_cache_lock);
+    drms_cache_lock_destroy(&env->record_cache_lock);
+
   /* Alloc'd by drms_server_begin_transaction() (server only) */
   if (env->sum_inbox) {
     tqueueDelete (env->sum_inbox);
@@ -48,6 +48,16 @@ void drms_abort_now(DRMS_Env_t *env);
 void drms_free_env(DRMS_Env_t *env, int final);
 long long drms_su_size(DRMS_Env_t *env, char *series);
 
+DRMS_CacheLock_t *drms_cache_lock_create(void);
+void drms_cache_lock_destroy(DRMS_CacheLock_t **lock);
+void drms_lock_cache(DRMS_CacheLock_t *lock, int write);
+void drms_unlock_cache(DRMS_CacheLock_t *lock);
+DRMS_Record_t *drms_series_cache_lookup(DRMS_Env_t *env, const char *series);
+void drms_series_cache_remove(DRMS_Env_t *env, const char *series);
+DRMS_Record_t *drms_record_cache_lookup(DRMS_Env_t *env, const char *hashkey);
+DRMS_Record_t *drms_record_cache_allocslot(DRMS_Env_t *env, const char *hashkey);
+void drms_record_cache_remove(DRMS_Env_t *env, const char *hashkey);
+
 /* Doxygen function documentation */
 
 /**
@@ -102,7 +102,7 @@ void drms_fitsrw_ShootBlanks(DRMS_Array_t *arr, long long blank)
 
       while (nelem > 0)
       {
-	 void *elem = (char *)arr->data + nelem - 1;
+	 void *elem = (char *)arr->data + (nelem - 1) * drms_sizeof(arr->type);
 
 	 DRMS_VAL_SET(arr->type, elem, val);
 	 dataval = conv2longlong(arr->type, &(val.value), NULL);
@@ -566,6 +566,8 @@ int drms_fitsrw_write(DRMS_Env_t *env,
          }
       }
 
+      hiter_free(&hit);
+
       if (keylist)
       {
          cfitsio_free_keys(&keylist);
@@ -1143,7 +1143,7 @@ FCALLSCFUN1(STRING,hiterator_getnext, F_HITERATOR_GETNEXT, f_hiterator_getnext,
 
 void destroy_hiterator( char * hit_hdl) {
   HIterator_t * hit = (HIterator_t *)  _convert_handle(hit_hdl);
-  free(hit);
+  hiter_destroy(&hit);
   return;
 }
 FCALLSCSUB1(destroy_hiterator, F_DESTROY_HITERATOR, f_destroy_hiterator, STRING)
@@ -147,6 +147,7 @@ HContainer_t *drms_create_keyword_prototypes(DRMS_Record_t *target,
     {
         *status = DRMS_SUCCESS;
         HIterator_t hit;
+        drms_keyword_materialize(source);
         hiter_new_sort(&hit, &(source->keywords), drms_keyword_ranksort);
 
         while ((sKey = hiter_getnext(&hit)) != NULL)
@@ -1097,6 +1098,434 @@ int drms_template_keywords(DRMS_Record_t *template)
    return err;
 }
 
+/******** Columnar keyword storage ********/
+
+/* Value of keyword icol of record row. String values are borrowed from the columns (or from the
+ * adopted query result), not copied. */
+static void KeyColumnsLoad(DRMS_KeyColumns_t *cols, int icol, int row, DRMS_Type_Value_t *val)
+{
+   DRMS_Keyword_t *skey = &cols->schema[icol];
+   char *col = (char *)cols->columns[icol];
+   DB_Column_t *dbcol = NULL;
+   int size;
+
+   if (col)
+   {
+      if (skey->info->type == DRMS_TYPE_STRING)
+      {
+         val->string_val = ((char **)col)[row];
+         if (!val->string_val)
+         {
+            val->string_val = skey->value.string_val;
+         }
+      }
+      else
+      {
+         size = drms_sizeof(skey->info->type);
+         memcpy(val, col + (size_t)row * size, size);
+      }
+   }
+   else if (cols->dbcols[icol] >= 0)
+   {
+      /* bound directly to the query result */
+      dbcol = &cols->result->column[cols->dbcols[icol]];
+
+      if (dbcol->is_null[row])
+      {
+         *val = skey->value;
+      }
+      else if (skey->info->type == DRMS_TYPE_STRING)
+      {
+         val->string_val = db_column_field(dbcol, row);
+      }
+      else
+      {
+         memcpy(val, db_column_field(dbcol, row), dbcol->size);
+      }
+   }
+   else
+   {
+      *val = skey->value;
+   }
+}
+
+/* Create the keyword struct for keyword icol of rec in rec->keywords, unless it already exists.
+ * From then on that struct, not the columns, holds the keyword's value. */
+static DRMS_Keyword_t *KeyColumnsMaterialize(DRMS_Record_t *rec, int icol)
+{
+   DRMS_KeyColumns_t *cols = rec->keycols;
+   DRMS_Keyword_t *skey = &cols->schema[icol];
+   DRMS_Keyword_t *key = NULL;
+   DRMS_Type_Value_t val;
+
+   key = hcon_lookup_lower(&rec->keywords, skey->info->name);
+
+   if (!key)
+   {
+      key = hcon_allocslot_lower(&rec->keywords, skey->info->name);
+      key->record = rec;
+      key->info = skey->info;
+      key->value.string_val = NULL;
+      KeyColumnsLoad(cols, icol, rec->keyrow, &val);
+      drms_copy_drms2drms(skey->info->type, &key->value, &val);
+   }
+
+   return key;
+}
+
+static void FreeInterned(const void *v)
+{
+   free(*(char **)v);
+}
+
+/* keywords is a container of DRMS_Keyword_ts (template->keywords, or a subset of it) that defines
+ * the schema. Until drms_keycolumns_bind() is called, every keyword has its template default value. */
+DRMS_KeyColumns_t *drms_keycolumns_create(DRMS_Record_t *template, HContainer_t *keywords, int nrows)
+{
+   DRMS_KeyColumns_t *cols = NULL;
+   HIterator_t hit;
+   DRMS_Keyword_t *tkey = NULL;
+   DRMS_Keyword_t *skey = NULL;
+   DRMS_Keyword_t **ptkey = NULL;
+   const char *alias = NULL;
+   int *pidx = NULL;
+   int icol;
+
+   cols = calloc(1, sizeof(DRMS_KeyColumns_t));
+   XASSERT(cols);
+   cols->nrows = nrows;
+   cols->ncols = keywords ? hcon_size(keywords) : 0;
+   cols->ndbcols = -1;
+   hcon_init(&cols->index, sizeof(int), DRMS_MAXKEYNAMELEN, NULL, NULL);
+   hcon_init(&cols->strings, sizeof(char *), DRMS_MAXNAMELEN, FreeInterned, NULL);
+
+   if (cols->ncols > 0)
+   {
+      cols->schema = calloc(cols->ncols, sizeof(DRMS_Keyword_t));
+      XASSERT(cols->schema);
+      cols->columns = calloc(cols->ncols, sizeof(void *));
+      XASSERT(cols->columns);
+      cols->dbcols = malloc(cols->ncols * sizeof(int));
+      XASSERT(cols->dbcols);
+
+      /* Rank order - the order in which drms_populate_records() consumes the db columns. */
+      icol = 0;
+      hiter_new_sort(&hit, keywords, drms_keyword_ranksort);
+      while ((tkey = (DRMS_Keyword_t *)hiter_getnext(&hit)) != NULL)
+      {
+         skey = &cols->schema[icol];
+         skey->record = template;
+         skey->info = tkey->info;
+         skey->value.string_val = NULL;
+         drms_copy_drms2drms(tkey->info->type, &skey->value, &tkey->value);
+         hcon_insert_lower(&cols->index, tkey->info->name, &icol);
+         cols->dbcols[icol] = -1;
+         icol++;
+      }
+      hiter_free(&hit);
+
+      if (template->keyword_aliases)
+      {
+         hiter_new(&hit, template->keyword_aliases);
+         while ((ptkey = (DRMS_Keyword_t **)hiter_extgetnext(&hit, &alias)) != NULL)
+         {
+            pidx = (int *)hcon_lookup_lower(&cols->index, (*ptkey)->info->name);
+            if (pidx)
+            {
+               icol = *pidx;
+               hcon_insert_lower(&cols->index, alias, &icol);
+            }
+         }
+         hiter_free(&hit);
+      }
+   }
+
+   return cols;
+}
+
+/* Attach the per-record (non-link, non-constant) keywords to consecutive columns of result,
+ * starting at column firstcol. A db column whose type and width match the keyword's own storage
+ * is used in place, so none of its values are copied. Any other keyword gets a column of its own,
+ * filled by drms_keycolumns_setfromdb(). result must stay valid as long as cols - the record set
+ * normally adopts it (cols->ownsresult). Returns the number of db columns consumed. */
+int drms_keycolumns_bind(DRMS_KeyColumns_t *cols, DB_Binary_Result_t *result, int firstcol)
+{
+   DRMS_Keyword_t *skey = NULL;
+   DB_Column_t *dbcol = NULL;
+   DRMS_Type_t type;
+   int icol;
+   int row;
+   int size;
+   int dbcolnum;
+   char *col = NULL;
+
+   if (cols->ndbcols >= 0)
+   {
+      return cols->ndbcols;
+   }
+
+   cols->result = result;
+   dbcolnum = firstcol;
+
+   for (icol = 0; icol < cols->ncols; icol++)
+   {
+      skey = &cols->schema[icol];
+
+      if (skey->info->islink || drms_keyword_isconstant(skey))
+      {
+         continue;
+      }
+
+      XASSERT(dbcolnum < result->num_cols);
+      type = skey->info->type;
+      dbcol = &result->column[dbcolnum];
+      size = drms_sizeof(type);
+      cols->dbcols[icol] = dbcolnum++;
+
+      if (type == DRMS_TYPE_STRING && (dbcol->type == DB_STRING || dbcol->type == DB_VARCHAR))
+      {
+         /* NUL-terminated fields */
+         continue;
+      }
+
+      if (type != DRMS_TYPE_STRING && dbcol->type == drms2dbtype(type) && dbcol->size == size)
+      {
+         continue;
+      }
+
+      /* string columns start out all NULL (default value) */
+      col = calloc(cols->nrows > 0 ? cols->nrows : 1, size);
+      XASSERT(col);
+
+      if (type != DRMS_TYPE_STRING)
+      {
+         for (row = 0; row < cols->nrows; row++)
+         {
+            memcpy(col + (size_t)row * size, &skey->value, size);
+         }
+      }
+
+      cols->columns[icol] = col;
+   }
+
+   cols->ndbcols = dbcolnum - firstcol;
+
+   return cols->ndbcols;
+}
+
+/* Drop one reference to *cols; the columns (and an adopted query result) are freed with the last
+ * reference. */
+void drms_keycolumns_release(DRMS_KeyColumns_t **cols)
+{
+   DRMS_KeyColumns_t *kc = NULL;
+   char **strcol = NULL;
+   int icol;
+   int row;
+
+   if (cols && *cols)
+   {
+      kc = *cols;
+
+      if (--kc->refcount <= 0)
+      {
+         for (icol = 0; icol < kc->ncols; icol++)
+         {
+            if (kc->schema[icol].info->type == DRMS_TYPE_STRING)
+            {
+               if (kc->columns[icol])
+               {
+                  strcol = (char **)kc->columns[icol];
+                  for (row = 0; row < kc->nrows; row++)
+                  {
+                     if (strcol[row])
+                     {
+                        free(strcol[row]);
+                     }
+                  }
+               }
+
+               if (kc->schema[icol].value.string_val)
+               {
+                  free(kc->schema[icol].value.string_val);
+               }
+            }
+
+            if (kc->columns[icol])
+            {
+               free(kc->columns[icol]);
+            }
+         }
+
+         if (kc->columns)
+         {
+            free(kc->columns);
+         }
+
+         if (kc->dbcols)
+         {
+            free(kc->dbcols);
+         }
+
+         if (kc->schema)
+         {
+            free(kc->schema);
+         }
+
+         if (kc->ownsresult)
+         {
+            db_free_binary_result(kc->result);
+         }
+
+         hcon_free(&kc->index);
+         hcon_free(&kc->strings);
+         free(kc);
+      }
+
+      *cols = NULL;
+   }
+}
+
+/* Convert the db value of keyword icol of record row into the keyword's own column; only needed
+ * for keywords that drms_keycolumns_bind() could not bind in place. */
+void drms_keycolumns_setfromdb(DRMS_KeyColumns_t *cols, int icol, int row, DB_Type_t dbtype, char *dbval)
+{
+   DRMS_Type_t type = cols->schema[icol].info->type;
+   char *col = (char *)cols->columns[icol];
+   DRMS_Type_Value_t val;
+   int size;
+
+   val.string_val = NULL;
+
+   if (type == DRMS_TYPE_STRING)
+   {
+      if (((char **)col)[row])
+      {
+         free(((char **)col)[row]);
+      }
+
+      drms_copy_db2drms(type, &val, dbtype, dbval);
+      ((char **)col)[row] = val.string_val;
+   }
+   else
+   {
+      size = drms_sizeof(type);
+      drms_copy_db2drms(type, &val, dbtype, dbval);
+      memcpy(col + (size_t)row * size, &val, size);
+   }
+}
+
+/* Return the shared copy of str. Records of the set point to it rather than owning a copy, so
+ * rows repeating the same value (e.g., sessionns) cost no memory. */
+char *drms_keycolumns_intern(DRMS_KeyColumns_t *cols, const char *str)
+{
+   char **pstr = NULL;
+   char *dup = NULL;
+
+   if (cols->lastinterned && strcmp(cols->lastinterned, str) == 0)
+   {
+      return cols->lastinterned;
+   }
+
+   pstr = (char **)hcon_lookup(&cols->strings, str);
+
+   if (pstr)
+   {
+      dup = *pstr;
+   }
+   else
+   {
+      dup = strdup(str);
+      XASSERT(dup);
+      hcon_insert(&cols->strings, str, &dup);
+   }
+
+   cols->lastinterned = dup;
+
+   return dup;
+}
+
+/* Resolve a plain keyword name (or alias) of a record whose keywords are stored in columns, without
+ * materializing the keyword. If the keyword has been materialized, that struct is returned;
+ * otherwise scratch is filled in and returned, with any string value borrowed from the columns.
+ * Returns NULL if rec is not columnar, key is unknown, or key is a link keyword. */
+DRMS_Keyword_t *drms_keycolumns_peek(DRMS_Record_t *rec, const char *key, DRMS_Keyword_t *scratch)
+{
+   DRMS_KeyColumns_t *cols = rec->keycols;
+   DRMS_Keyword_t *skey = NULL;
+   DRMS_Keyword_t *materialized = NULL;
+   int *pidx = NULL;
+
+   if (!cols || (pidx = (int *)hcon_lookup_lower(&cols->index, key)) == NULL)
+   {
+      return NULL;
+   }
+
+   skey = &cols->schema[*pidx];
+
+   if (skey->info->islink)
+   {
+      return NULL;
+   }
+
+   if (hcon_size(&rec->keywords) > 0)
+   {
+      materialized = hcon_lookup_lower(&rec->keywords, skey->info->name);
+      if (materialized)
+      {
+         return materialized;
+      }
+   }
+
+   scratch->record = rec;
+   scratch->info = skey->info;
+   KeyColumnsLoad(cols, *pidx, rec->keyrow, &scratch->value);
+
+   return scratch;
+}
+
+/* Create keyword structs in rec->keywords for all keywords of a columnar record, so that code
+ * which walks rec->keywords directly sees the complete set. No-op for other records. */
+void drms_keyword_materialize(DRMS_Record_t *rec)
+{
+   int icol;
+
+   if (rec && rec->keycols && hcon_size(&rec->keywords) < rec->keycols->ncols)
+   {
+      for (icol = 0; icol < rec->keycols->ncols; icol++)
+      {
+         KeyColumnsMaterialize(rec, icol);
+      }
+   }
+}
+
+/* Keyword lookup by exact (mangled) name or alias within one record - no link following. */
+static DRMS_Keyword_t *FindKeyword(DRMS_Record_t *rec, const char *key)
+{
+   DRMS_Keyword_t **ptr_key_found = NULL;
+   DRMS_Keyword_t *keyword = NULL;
+   int *pidx = NULL;
+
+   if (rec->keycols)
+   {
+      pidx = (int *)hcon_lookup_lower(&rec->keycols->index, key);
+      return pidx ? KeyColumnsMaterialize(rec, *pidx) : NULL;
+   }
+
+   keyword = hcon_lookup_lower(&rec->keywords, key);
+
+   if (keyword == NULL && rec->keyword_aliases != NULL)
+   {
+      /* try the aliases */
+      ptr_key_found = hcon_lookup_lower(rec->keyword_aliases, key);
+      if (ptr_key_found)
+      {
+         keyword = *ptr_key_found;
+      }
+   }
+
+   return keyword;
+}
+
 /* Wrapper for __drms_keyword_lookup without the recursion depth counter. */
 DRMS_Keyword_t *drms_keyword_lookup(DRMS_Record_t *rec, const char *key, int followlink)
 {
@@ -1107,8 +1536,6 @@ DRMS_Keyword_t *drms_keyword_lookup(DRMS_Record_t *rec, const char *key, int fol
   /* Handle explicit link syntax, <linkname>:<keyname> */
   char tmplink[DRMS_MAXLINKNAMELEN]={0};
   char *colonchar;
-  DRMS_Keyword_t **ptr_key_found = NULL;
-  DRMS_Keyword_t *key_found = NULL;
   int status;
 
   colonchar = strchr(key, ':');
@@ -1145,19 +1572,7 @@ DRMS_Keyword_t *drms_keyword_lookup(DRMS_Record_t *rec, const char *key, int fol
   }
   if (!followlink)
   {
-      key_found = hcon_lookup_lower(&rec->keywords, tmp);
-
-      if (key_found == NULL && rec->keyword_aliases != NULL)
-      {
-          /* try the aliases */
-          ptr_key_found = hcon_lookup_lower(rec->keyword_aliases, tmp);
-          if (ptr_key_found)
-          {
-              key_found = *ptr_key_found;
-          }
-      }
-
-      return key_found;
+      return FindKeyword(rec, tmp);
   }
   return __drms_keyword_lookup(rec, tmp, 0);
 }
@@ -1173,20 +1588,9 @@ static DRMS_Keyword_t * __drms_keyword_lookup(DRMS_Record_t *rec,
 					      const char *key, int depth)
 {
     int stat;
-    DRMS_Keyword_t **ptr_key_found = NULL;
     DRMS_Keyword_t *keyword = NULL;
 
-    keyword = hcon_lookup_lower(&rec->keywords, key);
-
-    if (keyword == NULL && rec->keyword_aliases != NULL)
-    {
-        /* try the aliases */
-        ptr_key_found = hcon_lookup_lower(rec->keyword_aliases, key);
-        if (ptr_key_found)
-        {
-            keyword = *ptr_key_found;
-        }
-    }
+    keyword = FindKeyword(rec, key);
 
     if (keyword!=NULL && depth<DRMS_MAXLINKDEPTH )
     {
@@ -1258,6 +1662,8 @@ HContainer_t *drms_keyword_createinfocon(DRMS_Env_t *drmsEnv,
 			 iKW++;
 		    }
 
+		    hiter_free(&hit);
+
 		    ret = hcon_create(sizeof(DRMS_KeywordInfo_t),
 				      DRMS_MAXKEYNAMELEN,
 				      NULL,
@@ -1328,15 +1734,31 @@ int drms_keyword_keysmatch(DRMS_Keyword_t *k1, DRMS_Keyword_t *k2)
 
 /***************** getkey_<type> family of functions **************/
 
+/* The getkey functions only read the keyword value, so a keyword of a columnar record is
+ * resolved into scratch instead of being materialized. Link syntax (<link>:<key>), per-segment
+ * syntax (<key>[N]), and link keywords go through drms_keyword_lookup(). */
+static inline DRMS_Keyword_t *GetkeyLookup(DRMS_Record_t *rec, const char *key, DRMS_Keyword_t *scratch)
+{
+  DRMS_Keyword_t *keyword = NULL;
+
+  if (rec->keycols && !strpbrk(key, ":["))
+  {
+    keyword = drms_keycolumns_peek(rec, key, scratch);
+  }
+
+  return keyword ? keyword : drms_keyword_lookup(rec, key, 1);
+}
+
 
 /* Slightly less ugly pieces of crap that should be used instead: */
 char drms_getkey_char(DRMS_Record_t *rec, const char *key, int *status)
 {
   DRMS_Keyword_t *keyword;
+  DRMS_Keyword_t scratch;
   int stat;
   char result;
 
-  keyword = drms_keyword_lookup(rec, key, 1);
+  keyword = GetkeyLookup(rec, key, &scratch);
   if (keyword != NULL )
   {
     result = drms2char(keyword->info->type, &keyword->value, &stat);
@@ -1355,10 +1777,11 @@ char drms_getkey_char(DRMS_Record_t *rec, const char *key, int *status)
 short drms_getkey_short(DRMS_Record_t *rec, const char *key, int *status)
 {
   DRMS_Keyword_t *keyword;
+  DRMS_Keyword_t scratch;
   int stat;
   short result;
 
-  keyword = drms_keyword_lookup(rec, key, 1);
+  keyword = GetkeyLookup(rec, key, &scratch);
   if (keyword!=NULL )
   {
     result = drms2short(keyword->info->type, &keyword->value, &stat);
@@ -1377,10 +1800,11 @@ short drms_getkey_short(DRMS_Record_t *rec, const char *key, int *status)
 int drms_getkey_int(DRMS_Record_t *rec, const char *key, int *status)
 {
   DRMS_Keyword_t *keyword;
+  DRMS_Keyword_t scratch;
   int stat;
   int result;
 
-  keyword = drms_keyword_lookup(rec, key, 1);
+  keyword = GetkeyLookup(rec, key, &scratch);
   if (keyword!=NULL )
   {
     result = drms2int(keyword->info->type, &keyword->value, &stat);
@@ -1399,10 +1823,11 @@ int drms_getkey_int(DRMS_Record_t *rec, const char *key, int *status)
 long long drms_getkey_longlong(DRMS_Record_t *rec, const char *key, int *status)
 {
   DRMS_Keyword_t *keyword;
+  DRMS_Keyword_t scratch;
   int stat;
   long long result;
 
-  keyword = drms_keyword_lookup(rec, key, 1);
+  keyword = GetkeyLookup(rec, key, &scratch);
   if (keyword!=NULL )
   {
     result = drms2longlong(keyword->info->type, &keyword->value, &stat);
@@ -1421,10 +1846,11 @@ long long drms_getkey_longlong(DRMS_Record_t *rec, const char *key, int *status)
 float drms_getkey_float(DRMS_Record_t *rec, const char *key, int *status)
 {
   DRMS_Keyword_t *keyword;
+  DRMS_Keyword_t scratch;
   int stat;
   float result;
 
-  keyword = drms_keyword_lookup(rec, key, 1);
+  keyword = GetkeyLookup(rec, key, &scratch);
   if (keyword != NULL )
   {
     result = drms2float(keyword->info->type, &keyword->value, &stat);
@@ -1442,10 +1868,11 @@ float drms_getkey_float(DRMS_Record_t *rec, const char *key, int *status)
 double drms_getkey_double(DRMS_Record_t *rec, const char *key, int *status)
 {
   DRMS_Keyword_t *keyword;
+  DRMS_Keyword_t scratch;
   int stat;
   double result;
 
-  keyword = drms_keyword_lookup(rec, key, 1);
+  keyword = GetkeyLookup(rec, key, &scratch);
 
   if (keyword != NULL)
   {
@@ -1499,10 +1926,11 @@ char *drms_keyword_getstring(DRMS_Keyword_t *keyword, int *status)
 char *drms_getkey_string(DRMS_Record_t *rec, const char *key, int *status)
 {
   DRMS_Keyword_t *keyword;
+  DRMS_Keyword_t scratch;
   int stat;
   char *result=NULL;
 
-  keyword = drms_keyword_lookup(rec, key, 1);
+  keyword = GetkeyLookup(rec, key, &scratch);
   if (keyword!=NULL )
   {
      result = drms_keyword_getstring(keyword, &stat);
@@ -1520,10 +1948,11 @@ char *drms_getkey_string(DRMS_Record_t *rec, const char *key, int *status)
 TIME drms_getkey_time(DRMS_Record_t *rec, const char *key, int *status)
 {
   DRMS_Keyword_t *keyword;
+  DRMS_Keyword_t scratch;
   int stat;
   TIME result=DRMS_MISSING_TIME;
 
-  keyword = drms_keyword_lookup(rec, key, 1);
+  keyword = GetkeyLookup(rec, key, &scratch);
   if (keyword!=NULL )
   {
      result = drms_keyword_gettime(keyword, &stat);
@@ -1554,9 +1983,10 @@ DRMS_Type_Value_t drms_getkey(DRMS_Record_t *rec, const char *key,
 {
   DRMS_Type_Value_t value;
   DRMS_Keyword_t *keyword;
+  DRMS_Keyword_t scratch;
   int stat;
 
-  keyword = drms_keyword_lookup(rec, key, 1);
+  keyword = GetkeyLookup(rec, key, &scratch);
   if (keyword != NULL )
   {
     *type = keyword->info->type;
@@ -1583,9 +2013,10 @@ DRMS_Value_t drms_getkey_p(DRMS_Record_t *rec, const char *key, int *status)
   DRMS_Type_Value_t value;
   DRMS_Value_t retval;
   DRMS_Keyword_t *keyword;
+  DRMS_Keyword_t scratch;
   int stat;
 
-  keyword = drms_keyword_lookup(rec, key, 1);
+  keyword = GetkeyLookup(rec, key, &scratch);
   if (keyword != NULL )
   {
     retval.type = keyword->info->type;
@@ -1946,11 +2377,13 @@ int drms_copykeys(DRMS_Record_t *target,
 
    if (usesrcset)
    {
+      drms_keyword_materialize(source);
       hiter_new_sort(&sethit, &source->keywords, drms_keyword_ranksort);
       lookuprec = target;
    }
    else
    {
+      drms_keyword_materialize(target);
       hiter_new_sort(&sethit, &target->keywords, drms_keyword_ranksort);
       lookuprec = source;
    }
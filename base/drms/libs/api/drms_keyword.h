@@ -19,6 +19,9 @@ void drms_keyword_fprintval2(FILE *keyfile, DRMS_Keyword_t *key, int max_precisi
 void drms_keyword_snprintfval(DRMS_Keyword_t *key, char *buf, int size);
 void drms_keyword_snprintfval2(DRMS_Keyword_t *key, char *buf, int size, int max_precision, int binary);
 DRMS_Keyword_t *drms_keyword_lookup(DRMS_Record_t *rec, const char *key, int followlink);
+/* Records of a columnar record set (DRMS_Env_t::keyword_columns) hold only the keywords that have
+ * been looked up; call this before walking rec->keywords directly. */
+void drms_keyword_materialize(DRMS_Record_t *rec);
 DRMS_Keyword_t *drms_template_keyword_followlink(DRMS_Keyword_t *srckey, int *statret);
 DRMS_Keyword_t *drms_jsd_template_keyword_followlink(DRMS_Keyword_t *srckey, int *statret);
 DRMS_Type_t drms_keyword_type(DRMS_Keyword_t *key);
@@ -24,6 +24,14 @@ HContainer_t *drms_create_keyword_prototypes(DRMS_Record_t *target,
 int drms_template_keywords(DRMS_Record_t *template);
 int drms_template_keywords_int(DRMS_Record_t *template, int expandperseg, const char *cols);
 
+/* Columnar keyword storage (DRMS_KeyColumns_t). */
+DRMS_KeyColumns_t *drms_keycolumns_create(DRMS_Record_t *template, HContainer_t *keywords, int nrows);
+void drms_keycolumns_release(DRMS_KeyColumns_t **cols);
+int drms_keycolumns_bind(DRMS_KeyColumns_t *cols, DB_Binary_Result_t *result, int firstcol);
+void drms_keycolumns_setfromdb(DRMS_KeyColumns_t *cols, int icol, int row, DB_Type_t dbtype, char *dbval);
+char *drms_keycolumns_intern(DRMS_KeyColumns_t *cols, const char *str);
+DRMS_Keyword_t *drms_keycolumns_peek(DRMS_Record_t *rec, const char *key, DRMS_Keyword_t *scratch);
+
 DRMS_Keyword_t *drms_keyword_indexfromslot(DRMS_Keyword_t *slot);
 DRMS_Keyword_t *drms_keyword_epochfromslot(DRMS_Keyword_t *slot);
 DRMS_Keyword_t *drms_keyword_basefromslot(DRMS_Keyword_t *slot);
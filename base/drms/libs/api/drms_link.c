@@ -300,7 +300,7 @@ DRMS_Record_t *drms_link_follow(DRMS_Record_t *rec, const char *linkname, int *s
      */
     drms_make_hashkey(hashkey, link->info->target_series, link->recnum);
 
-    if ((linkedRec = hcon_lookup(&rec->env->record_cache, hashkey)) != NULL)
+    if ((linkedRec = drms_record_cache_lookup(rec->env, hashkey)) != NULL)
     {
         /* Do not increase refcount on linked record. */
         if (status)
@@ -585,7 +585,7 @@ LinkedList_t *drms_link_follow_recordset(DRMS_Env_t *env, DRMS_Record_t *templat
                 drms_make_hashkey(child_hash_key, drms_link->info->target_series, drms_link->recnum);
                 drms_link_make_usable_hashkey(child_usable_hash_key, drms_link->info->target_series, drms_link->recnum);
 
-                if ((child_drms_record = hcon_lookup(&env->record_cache, child_hash_key)) != NULL)
+                if ((child_drms_record = drms_record_cache_lookup(env, child_hash_key)) != NULL)
                 {
                     /* Do not increase refcount on linked record. */
                     if (drms_link->wasFollowed)
@@ -977,6 +977,7 @@ int drms_link_getpidx(DRMS_Record_t *rec)
             if (template == NULL)
             {
                 fprintf(stderr,"ERROR: Couldn't get template for series '%s'.\ndrms_template_record returned status=%d\n", link->info->target_series, status);
+                hiter_free(&hit);
                 return status;
             }
 
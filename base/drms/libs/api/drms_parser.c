@@ -2937,8 +2937,10 @@ void drms_jsd_printfromrec(DRMS_Record_t *rec) {
    hiter_new_sort(&hit, &rec->links, drms_link_ranksort);
    while( (link = (DRMS_Link_t *)hiter_getnext(&hit)) )
      drms_link_print_jsd(link);
+   hiter_free(&hit);
 
    printf("\n#=====Keywords=====\n");
+   drms_keyword_materialize(rec);
    hiter_new_sort(&hit, &rec->keywords, drms_keyword_ranksort);
    while( (key = (DRMS_Keyword_t *)hiter_getnext(&hit)) )
    {
@@ -2947,11 +2949,13 @@ void drms_jsd_printfromrec(DRMS_Record_t *rec) {
          drms_keyword_print_jsd(key);
       }
    }
+   hiter_free(&hit);
 
    printf("\n#=====Segments=====\n");
    hiter_new_sort(&hit, &rec->segments, drms_segment_ranksort);
    while( (seg = (DRMS_Segment_t *)hiter_getnext(&hit)) )
      drms_segment_print_jsd(seg);
+   hiter_free(&hit);
 }
 
 void drms_jsd_print(DRMS_Env_t *drms_env, const char *seriesname) {
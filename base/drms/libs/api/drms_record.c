@@ -820,6 +820,7 @@ static DRMS_Record_t *CacheRecordProto(DRMS_Env_t *env,
     else
     {
         stat = DRMS_SUCCESS; /* ingore drms_template_record status, which might have been 'unknown series' */
+        drms_lock_cache(env->series_cache_lock, 1);
         cached = (DRMS_Record_t *)hcon_allocslot_lower(&(env->series_cache), seriesName);
         drms_copy_record_struct(cached, proto);
 
@@ -830,6 +831,7 @@ static DRMS_Record_t *CacheRecordProto(DRMS_Env_t *env,
                                 proto->seriesinfo->pidx_keywords[i]->info->name,
                                 0);
         }
+        drms_unlock_cache(env->series_cache_lock);
 
         drms_free_record_struct(proto);
         free(proto);
@@ -3300,6 +3302,7 @@ DRMS_RecordSet_t *drms_create_records_fromtemplate(DRMS_Env_t *env, int n,
           if (!virginPtr)
           {
               stat = DRMS_ERROR_FILECREATE;
+              hiter_free(&hit);
               goto failure;
           }
 
@@ -3517,7 +3520,7 @@ void drms_destroy_recproto(DRMS_Record_t **proto)
       DRMS_Env_t *env = prototype->env;
 
       /* This is the definitive way to know if a series has been cached in series_cache. */
-      DRMS_Record_t *rec = hcon_lookup_lower(&(env->series_cache), series);
+      DRMS_Record_t *rec = drms_series_cache_lookup(env, series);
       int deep = 1;
 
       if (rec)
@@ -3858,6 +3861,8 @@ static DRMS_RecordSet_t *drms_clone_records_internal(DRMS_RecordSet_t *rs_in,
 			seg_in->info->name, rec_in->seriesinfo->seriesname,
 			rec_in->recnum);
 		stat = 1;
+		hiter_free(&hit_out);
+		hiter_free(&hit_in);
 		goto failure;
 	      }
 
@@ -3872,6 +3877,8 @@ static DRMS_RecordSet_t *drms_clone_records_internal(DRMS_RecordSet_t *rs_in,
 			seg_out->info->name, rec_out->seriesinfo->seriesname,
 			rec_out->recnum);
 		stat = 1;
+		hiter_free(&hit_out);
+		hiter_free(&hit_in);
 		goto failure;
 	      }
 	      drms_free_array(arr);
@@ -4732,16 +4739,10 @@ static int drms_stage_records_internal(DRMS_RecordSet_t *rs, int retrieve, int d
 
                     if (!fetchLinks)
                     {
-                        /* if the record has a linked keyword, and the fetchLinks flag has not already been set, set it now */
-                        hitKey = hiter_create(&rec->keywords);
-                        if (!hitKey)
-                        {
-                            bail = 1;
-                            status = DRMS_ERROR_OUTOFMEMORY;
-                            break;
-                        }
-
-                        while ((key = (DRMS_Keyword_t *)hiter_getnext(hitKey)) != NULL)
+                        /* if the record has a linked keyword, and the fetchLinks flag has not already been set, set it now;
+                         * drms_record_nextkey() also sees the keywords of a columnar record, which has no keyword
+                         * structs in rec->keywords until they are looked up */
+                        while ((key = drms_record_nextkey(rec, &hitKey, 0)) != NULL)
                         {
                             if (key->info->islink)
                             {
@@ -4750,8 +4751,11 @@ static int drms_stage_records_internal(DRMS_RecordSet_t *rs, int retrieve, int d
                             }
                         }
 
-                        hiter_destroy(&hitKey);
-                        hitKey = NULL;
+                        if (hitKey)
+                        {
+                            hiter_destroy(&hitKey);
+                            hitKey = NULL;
+                        }
                     }
                 }
 
@@ -5368,7 +5372,7 @@ static int IsCachedRecord(DRMS_Env_t *env, DRMS_Record_t *rec)
       char hashkey[DRMS_MAXHASHKEYLEN];
 
       drms_make_hashkey(hashkey, rec->seriesinfo->seriesname, rec->recnum);
-      ans = (hcon_lookup(&env->record_cache, hashkey) != NULL);
+      ans = (drms_record_cache_lookup(env, hashkey) != NULL);
    }
 
    return ans;
@@ -5381,7 +5385,7 @@ static int IsTemplateRecord(DRMS_Record_t *rec)
 
     if (rec && rec->env && rec->seriesinfo && *rec->seriesinfo->seriesname != '\0')
     {
-        template = hcon_lookup_lower(&rec->env->series_cache, rec->seriesinfo->seriesname);
+        template = drms_series_cache_lookup(rec->env, rec->seriesinfo->seriesname);
         if (template)
         {
             answer = (template == rec);
@@ -5417,7 +5421,7 @@ void drms_free_linked_records(DRMS_Env_t *env, DRMS_Record_t *record)
                      * to drm_link_follow(), which means that the linked record may
                      * be in memory */
                     drms_make_hashkey(hash_key, drms_link->info->target_series, drms_link->recnum);
-                    linked_record = hcon_lookup(&env->record_cache, hash_key);
+                    linked_record = drms_record_cache_lookup(env, hash_key);
 
                     /* Only free a linked record if it got in the cache because it was
                      * followed from the original record. */
@@ -5744,6 +5748,8 @@ int drms_closeall_records(DRMS_Env_t *env, int action)
 
   CHECKNULL(env);
   status = 0;
+  /* closing a record removes it from the cache */
+  drms_lock_cache(env->record_cache_lock, 1);
   hiter_new(&hit, &env->record_cache);
   while( (rec = (DRMS_Record_t *)hiter_getnext(&hit)) )
   {
@@ -5756,6 +5762,7 @@ int drms_closeall_records(DRMS_Env_t *env, int action)
   }
 
     hiter_free(&hit);
+  drms_unlock_cache(env->record_cache_lock);
 
   return status;
 }
@@ -5786,7 +5793,7 @@ void drms_free_record(DRMS_Record_t *rec)
             if (rec->refcount == 0)
             {
                 /* calls drms_free_record_struct() */
-                hcon_remove(&rec->env->record_cache, hashkey);
+                drms_record_cache_remove(rec->env, hashkey);
             }
         }
     }
@@ -5840,7 +5847,7 @@ DRMS_Record_t *drms_retrieve_record(DRMS_Env_t *env, const char *seriesname,
 #endif
   drms_make_hashkey(hashkey, seriesname, recnum);
 
-  if ( (rec = hcon_lookup(&env->record_cache, hashkey)) == NULL )
+  if ( (rec = drms_record_cache_lookup(env, hashkey)) == NULL )
   {
     /* Set up data structure for dataset based on series template - puts in record cache */
     if ((rec = drms_alloc_record(env, seriesname, recnum, &stat)) == NULL)
@@ -6262,7 +6269,7 @@ HContainer_t *drms_retrieve_linked_recordset(DRMS_Env_t *env, const char *link,
     {
         sscanf(child_usable_hash_key, "%[^@]@%lld", series, &record_number);
 
-        if ((child_drms_record = hcon_lookup(&env->record_cache, child_hash_key)) == NULL)
+        if ((child_drms_record = drms_record_cache_lookup(env, child_hash_key)) == NULL)
         {
             /* ART - setting up record structs takes a HUGE amount of time; I'm guessing that
              * one of the biggest expenses is going to come from copying hundreds of keyword
@@ -6434,6 +6441,8 @@ static LinkedList_t *faux_record_set_to_list(DRMS_RecordSet_t *faux_record_set)
 
 /* `keys` - an hcontainer of DRMS_Keyword_t pointers (to template keywords)
  * `where` -
+ * `br_override` - if not NULL, the rows have already been retrieved (no query is run); this function takes
+ *   ownership of br_override
  */
 
 /* called ONLY from an `open_records` or `open_recordchunk` function; this implies that
@@ -6470,11 +6479,13 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
     HIterator_t *alias_iter = NULL;
     DRMS_Keyword_t **p_template_keyword = NULL;
     const char *template_alias = NULL;
+    DRMS_KeyColumns_t *keycols = NULL;
 
     CHECKNULL_STAT(env,status);
 
     if ((template = drms_template_record(env,seriesname,status)) == NULL)
     {
+        db_free_binary_result(br_override);
         return NULL;
     }
 
@@ -6488,7 +6499,11 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
 
     char *query = NULL;
 
-    if (qoverride)
+    if (br_override)
+    {
+        /* the caller has already retrieved the rows (e.g., a batch of a streamed query) - there is no query to run */
+    }
+    else if (qoverride)
     {
         query = strdup(qoverride);
 
@@ -6522,6 +6537,13 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
   printf("\nMemory used = %Zu\n\n",xmem_recenthighwater());
 #endif
 
+  if (br_override)
+  {
+    /* this function now owns br_override */
+    qres = br_override;
+  }
+  else
+  {
     /* query may contain more than one SQL command, but drms_query_bin does not
      * support this. If this is the case, then the first command will be a command that
      * creates a temporary table (used by the second command). So, we need to separate the
@@ -6539,12 +6561,13 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
         return NULL;
     }
 
-  TIME(qres = drms_query_bin(env->session, query));
-  if (qres == NULL)
-  {
-    stat = DRMS_ERROR_QUERYFAILED;
-    fprintf(stderr, "Failed in drms_retrieve_records, query = '%s'\n",query);
-    goto bailout1;
+    TIME(qres = drms_query_bin(env->session, query));
+    if (qres == NULL)
+    {
+      stat = DRMS_ERROR_QUERYFAILED;
+      fprintf(stderr, "Failed in drms_retrieve_records, query = '%s'\n",query);
+      goto bailout1;
+    }
   }
 
 #ifdef DEBUG
@@ -6552,7 +6575,7 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
   printf("\nMemory used after query = %Zu\n\n",xmem_recenthighwater());
   printf("number of record returned = %d\n",qres->num_rows);
 #endif
-  throttled = (qres->num_rows == limit);
+  throttled = (!br_override && qres->num_rows == limit);
 
   /* Filter query result and initialize record data structures
      from template. */
@@ -6610,6 +6633,13 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
         hiter_free(&hit);
     }
 
+    if (env->keyword_columns)
+    {
+        /* columnar record set - the records get no keyword structs of their own; their keyword
+         * values are stored in columns shared by all records in the set */
+        keycols = drms_keycolumns_create(template, keys ? template_keywords_subset : &template->keywords, rs->n);
+    }
+
     for (i=0; i<rs->n; i++)
     {
 #ifdef DEBUG
@@ -6624,7 +6654,7 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
        * the db again; if we desire a partial record, though, we should check the cache for the full
        * record first - THAT IS NOT DONE HERE AND SHOULD BE; but for now, we are assuming the full
        * record is not in the cache */
-        if ((links && hcon_size(links) > 0) || (keys && hcon_size(keys) > 0) || (segs && hcon_size(segs) > 0))
+        if (keycols || (links && hcon_size(links) > 0) || (keys && hcon_size(keys) > 0) || (segs && hcon_size(segs) > 0))
         {
             DRMS_Link_t *link = NULL;
             DRMS_Link_t **plink = NULL;
@@ -6662,7 +6692,7 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
              * DRMS_Keyword_ts; so create a new container of keys that stores DRMS_Keyword_ts - we need to do this
              * only once; use a better hashprime for this new container
              */
-            if (keys && hcon_size(keys) == 0)
+            if (keycols || (keys && hcon_size(keys) == 0))
             {
                 hcon_init(&rs->records[i]->keywords, sizeof(DRMS_Keyword_t), DRMS_MAXHASHKEYLEN, (void (*)(const void *))drms_free_keyword_struct, (void (*)(const void *, const void *))drms_copy_keyword_struct);
             }
@@ -6704,7 +6734,14 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
             /* Copy keyword structs from template. If the keyword data type is a string, then we have to deep copy
              * the string value, which then becomes the default value of the keyword instance.
              * keys == 0 ==> all keys, hcon_size(keys) == 0 ==> no keys. */
-            if (!keys)
+            if (keycols)
+            {
+                /* keyword structs are created on demand from the columns */
+                rs->records[i]->keycols = keycols;
+                rs->records[i]->keyrow = i;
+                keycols->refcount++;
+            }
+            else if (!keys)
             {
                 /* Copy all keyword structs. This will perform a deep-copy. */
                 copy_keywords_container(&(rs->records[i]->keywords), &template->keywords);
@@ -6722,7 +6759,7 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
             }
             hiter_free(&hit);
 
-            if (rs->records[i]->keyword_aliases)
+            if (rs->records[i]->keyword_aliases && !keycols)
             {
                 hiter_new(&hit, template->keyword_aliases);
 
@@ -6789,7 +6826,7 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
              * the user explicitly asked to open the record with an `open_records` or `open_recordchunk` call;
              * the cached record could be a partial record (only true if )
              */
-            cached_record = hcon_lookup(&env->record_cache, hashkey);
+            cached_record = drms_record_cache_lookup(env, hashkey);
 
             if (cached_record != NULL)
             {
@@ -6821,8 +6858,11 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
                 hcon_free(&cached_record->keywords);
                 hcon_destroy(&cached_record->keyword_aliases);
 
-                /* create new keywords from the template */
+                /* create new keywords from the template; a cached record is never columnar (columnar records
+                 * are not cached), so after this its keywords container holds all of its keywords, but
+                 * materialize anyway so that the walks below don't depend on that */
                 copy_keywords_container(&cached_record->keywords, &template->keywords);
+                drms_keyword_materialize(cached_record);
 
                 /* re-create aliases */
                 cached_record->keyword_aliases = hcon_create(sizeof(DRMS_Keyword_t *), DRMS_MAXKEYNAMELEN, NULL, NULL, NULL, NULL, 0);
@@ -6864,7 +6904,7 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
             else
             {
                 /* Allocate a slot in the hash indexed record cache. */
-                rs->records[i] = hcon_allocslot(&env->record_cache, hashkey);
+                rs->records[i] = drms_record_cache_allocslot(env, hashkey);
 
                 /* populate the slot with values from the template */
                 drms_copy_record_struct_ext(rs->records[i], template, copy_keywords_container, NULL, NULL, NULL);
@@ -6894,6 +6934,13 @@ DRMS_RecordSet_t *drms_retrieve_records_internal(DRMS_Env_t *env, const char *se
     {
       goto bailout; /* Query result was inconsistent with series template. */
     } );
+
+    if (keycols)
+    {
+        /* the record set now owns the query result - its keyword columns point into it */
+        keycols->ownsresult = 1;
+        qres = NULL;
+    }
 #ifdef DEBUG
     printf("\nMemory used after populate= %Zu\n\n",xmem_recenthighwater());
 #endif
@@ -8134,7 +8181,7 @@ DRMS_Record_t *drms_alloc_record3(DRMS_Env_t *env, const char *series, long long
     drms_make_hashkey(hash_key, series, recnum);
 
     /* Allocate a slot in the hash indexed record cache. */
-    record = (DRMS_Record_t *)hcon_allocslot(&env->record_cache, hash_key);
+    record = drms_record_cache_allocslot(env, hash_key);
 
     /* set refcount to initial value of 1 (because this is in the record cache) */
     if (record)
@@ -8180,7 +8227,7 @@ DRMS_Record_t *drms_alloc_record2(DRMS_Record_t *template, long long recnum, int
   drms_make_hashkey(hashkey, series, recnum);
 
   /* Allocate a slot in the hash indexed record cache. */
-  rec = (DRMS_Record_t *)hcon_allocslot(&env->record_cache, hashkey);
+  rec = drms_record_cache_allocslot(env, hashkey);
 
   rec->su = NULL;
   /* Populate the slot with values from the template. */
@@ -8684,7 +8731,31 @@ static DRMS_Record_t *drms_template_record_int(DRMS_Env_t *env,
 DRMS_Record_t *drms_template_record(DRMS_Env_t *env, const char *seriesname,
                                     int *status)
 {
-   return drms_template_record_int(env, seriesname, 0, status);
+   DRMS_Record_t *template = NULL;
+   int built = 0;
+
+   /* A template that has been built needs only a look-up. Building one changes series_cache, and takes
+    * the lock for writing until the template is complete, so a look-up never sees a partial template. */
+   drms_lock_cache(env->series_cache_lock, 0);
+   template = hcon_lookup_lower(&env->series_cache, seriesname);
+   built = (template && template->init);
+   drms_unlock_cache(env->series_cache_lock);
+
+   if (built)
+   {
+      if (status)
+      {
+         *status = DRMS_SUCCESS;
+      }
+
+      return template;
+   }
+
+   drms_lock_cache(env->series_cache_lock, 1);
+   template = drms_template_record_int(env, seriesname, 0, status);
+   drms_unlock_cache(env->series_cache_lock);
+
+   return template;
 }
 
 /* Caller must free record returned. */
@@ -8692,7 +8763,14 @@ DRMS_Record_t *drms_create_jsdtemplate_record(DRMS_Env_t *env,
                                               const char *seriesname,
                                               int *status)
 {
-   return drms_template_record_int(env, seriesname, 1, status);
+   DRMS_Record_t *template = NULL;
+
+   /* a DSDS template is built in series_cache */
+   drms_lock_cache(env->series_cache_lock, 1);
+   template = drms_template_record_int(env, seriesname, 1, status);
+   drms_unlock_cache(env->series_cache_lock);
+
+   return template;
 }
 
 void drms_destroy_jsdtemplate_record(DRMS_Record_t **rec)
@@ -8753,6 +8831,13 @@ void drms_free_record_struct(DRMS_Record_t *rec)
             hcon_free(&rec->keywords);
             hcon_destroy(&rec->keyword_aliases);
 
+            if (rec->keycols)
+            {
+                /* sessionns is interned in the keyword columns */
+                rec->sessionns = NULL;
+                drms_keycolumns_release(&rec->keycols);
+            }
+
             free(rec->sessionns);
 
             if (rec->suinfo)
@@ -8785,69 +8870,90 @@ void drms_free_record_struct(DRMS_Record_t *rec)
 
 void copy_keywords_container(HContainer_t *dst, HContainer_t*src)
 {
-    Table_t *src_bin = NULL;
-    Table_t *dst_bin = NULL;
-    Entry_t *src_slot = NULL;
-    Entry_t *dst_slot = NULL;
-    int bin_index = -1;
-    int slot_index = -1;
+    HashEntry_t *src_slot = NULL;
+    HashEntry_t *dst_slot = NULL;
+    unsigned int slot_index = 0;
+    int elem_index = -1;
     const HContainerElement_t *src_hcon_element = NULL;
     HContainerElement_t *dst_hcon_element = NULL;
     DRMS_Keyword_t *keyword = NULL;
 
     /* copy all HContainer_t fields */
     *dst = *src;
+    dst->sorted = NULL;
+    dst->sortcomp = NULL;
 
-    /* alloc each hash bin (Table_t) */
-    dst->hash.list = calloc(dst->hash.hashprime, sizeof(Table_t));
+    /* alloc the element vector; `dst` gets the same layout as `src`, holes included, so that each element's
+     * index is the same in `src` and `dst` (`src` is not compacted - an iterator may be walking it) */
+    dst->nelems = src->nelems;
+    dst->szelems = src->nelems;
+    dst->elems = NULL;
 
-    /* initialize each hash bin (Table_t) */
-    for (bin_index = 0; bin_index < dst->hash.hashprime; bin_index++)
+    if (dst->szelems > 0)
     {
-        src_bin = &src->hash.list[bin_index];
-        dst_bin = &dst->hash.list[bin_index];
-
-        table_init(src_bin->maxsize, dst_bin, dst->hash.not_equal);
+        dst->elems = calloc(dst->szelems, sizeof(HContainerElement_t *));
+        XASSERT(dst->elems);
+    }
 
-        /* we are going to create src_table->size Entry_t structs in the dst hash bin */
-        dst_bin->size = src_bin->size;
+    /* for each element, in insertion order, copy key from `src` to `dst` */
+    for (elem_index = 0; elem_index < dst->nelems; elem_index++)
+    {
+        src_hcon_element = src->elems[elem_index];
 
-        /* for each slot (Entry_t) in each bin (Table_t), copy key from `src` to `dst` */
-        for (slot_index = 0; slot_index < dst_bin->size; slot_index++)
+        if (!src_hcon_element)
         {
-            src_slot = &src_bin->data[slot_index];
-            dst_slot = &dst_bin->data[slot_index];
-            XASSERT(src_slot && dst_slot);
+            /* a hole left by hcon_remove() */
+            continue;
+        }
 
-            if (src_slot && src_slot->key && *(char *)src_slot->key != '\0' && dst_slot)
-            {
-                src_hcon_element = src_slot->value;
-                dst_hcon_element = (HContainerElement_t *)calloc(1, sizeof(HContainerElement_t));
+        dst_hcon_element = (HContainerElement_t *)calloc(1, sizeof(HContainerElement_t));
 
-                dst_hcon_element->key = strdup(src_slot->key);
-                dst_hcon_element->val = calloc(dst->datasize, sizeof(char)); /* DRMS_Keyword_t */
+        dst_hcon_element->key = strdup(src_hcon_element->key);
+        dst_hcon_element->val = calloc(dst->datasize, sizeof(char)); /* DRMS_Keyword_t */
+        dst_hcon_element->index = elem_index;
+        dst->elems[elem_index] = dst_hcon_element;
 
-                dst_slot->key = dst_hcon_element->key;
-                dst_slot->value = dst_hcon_element;
+        /* do not copy pointer to record, and do not copy non-constant keyword
+         * values - these will be filled in by drms_populate_records(); copy
+         * the values for constant keywords though (do it for all keyword since
+         * there might be some part of the code that uses these values that
+         * I'm not aware of); if the value to be copied is a string, then that
+         * needs to be duped; copy the info struct ptr */
+        keyword = (DRMS_Keyword_t *)dst_hcon_element->val;
+        keyword->info = ((DRMS_Keyword_t *)src_hcon_element->val)->info;
 
-                /* do not copy pointer to record, and do not copy non-constant keyword
-                 * values - these will be filled in by drms_populate_records(); copy
-                 * the values for constant keywords though (do it for all keyword since
-                 * there might be some part of the code that uses these values that
-                 * I'm not aware of); if the value to be copied is a string, then that
-                 * needs to be duped; copy the info struct ptr */
-                keyword = (DRMS_Keyword_t *)dst_hcon_element->val;
-                keyword->info = ((DRMS_Keyword_t *)src_hcon_element->val)->info;
+        if (keyword->info->type == DRMS_TYPE_STRING)
+        {
+            keyword->value.string_val = strdup(((DRMS_Keyword_t *)src_hcon_element->val)->value.string_val);
+        }
+        else
+        {
+            keyword->value = ((DRMS_Keyword_t *)src_hcon_element->val)->value;
+        }
+    }
 
-                if (keyword->info->type == DRMS_TYPE_STRING)
-                {
-                    keyword->value.string_val = strdup(((DRMS_Keyword_t *)src_hcon_element->val)->value.string_val);
-                }
-                else
-                {
-                    keyword->value = ((DRMS_Keyword_t *)src_hcon_element->val)->value;
-                }
-            }
+    /* alloc the hash slot array; the slot layout (including the cached hash values) is identical
+     * to that of `src`, so no rehashing is needed */
+    if (src->hash.slots)
+    {
+        dst->hash.slots = calloc(src->hash.capacity, sizeof(HashEntry_t));
+        XASSERT(dst->hash.slots);
+    }
+
+    /* for each occupied slot (HashEntry_t), point to the `dst` element at the same index */
+    for (slot_index = 0; slot_index < dst->hash.capacity; slot_index++)
+    {
+        src_slot = &src->hash.slots[slot_index];
+        dst_slot = &dst->hash.slots[slot_index];
+
+        if (src_slot->key)
+        {
+            src_hcon_element = src_slot->value;
+            dst_hcon_element = dst->elems[src_hcon_element->index];
+
+            dst_slot->key = dst_hcon_element->key;
+            dst_slot->value = dst_hcon_element;
+            dst_slot->hashval = src_slot->hashval;
         }
     }
 }
@@ -8866,9 +8972,20 @@ void drms_copy_record_struct_ext(DRMS_Record_t *dst, DRMS_Record_t *src, void (*
   HContainer_t *keyword_source = NULL;
 
   XASSERT(dst && src);
+
+  /* the copy gets ordinary keyword structs, not a reference to the source's columns */
+  drms_keyword_materialize(src);
+
   /* Copy fields in the main structure and
      series info. */
   *dst = *src;
+
+  if (src->keycols)
+  {
+      dst->keycols = NULL;
+      dst->keyrow = 0;
+      dst->sessionns = src->sessionns ? strdup(src->sessionns) : NULL;
+  }
   /* Copy fields in segments, links and keywords. */
 
   /* since there can be many keywords, use a custom number of bins (choose a prime ~200 --> 211);
@@ -9200,6 +9317,10 @@ int drms_populate_records(DRMS_Env_t *env, DRMS_RecordSet_t *rs, DB_Binary_Resul
     int segnum;
     char *record_value;
     HIterator_t *last = NULL;
+    DRMS_KeyColumns_t *keycols = NULL;
+    DRMS_Keyword_t scratchkey;
+    int icol;
+    int ndbcols;
 
     CHECKNULL(rs);
     CHECKNULL(qres);
@@ -9230,7 +9351,14 @@ int drms_populate_records(DRMS_Env_t *env, DRMS_RecordSet_t *rs, DB_Binary_Resul
         rec->sessionid = db_binary_field_getint(qres, row, col++);
 
         /* Session namespace of creating session.*/
-        rec->sessionns = strdup(db_binary_field_get(qres, row, col++));
+        if (rec->keycols)
+        {
+            rec->sessionns = drms_keycolumns_intern(rec->keycols, db_binary_field_get(qres, row, col++));
+        }
+        else
+        {
+            rec->sessionns = strdup(db_binary_field_get(qres, row, col++));
+        }
 
         /* Populate Links. */
         if (openLinks && hcon_size(&rec->links) > 0)
@@ -9266,7 +9394,26 @@ int drms_populate_records(DRMS_Env_t *env, DRMS_RecordSet_t *rs, DB_Binary_Resul
         }
 
         /* populate keywords - keywords not desired have already been excluded from the SQL SELECT statement */
-        if (hcon_size(&rec->keywords) > 0)
+        if (rec->keycols)
+        {
+            /* columnar record set - most keyword columns are bound to the query-result columns
+             * themselves (once, for the first row); only the others need per-row conversion */
+            keycols = rec->keycols;
+            ndbcols = drms_keycolumns_bind(keycols, qres, col);
+
+            for (icol = 0; icol < keycols->ncols; icol++)
+            {
+                if (keycols->columns[icol] && !qres->column[keycols->dbcols[icol]].is_null[row])
+                {
+                    column_type = db_binary_column_type(qres, keycols->dbcols[icol]);
+                    record_value = db_binary_field_get(qres, row, keycols->dbcols[icol]);
+                    drms_keycolumns_setfromdb(keycols, icol, rec->keyrow, column_type, record_value);
+                }
+            }
+
+            col += ndbcols;
+        }
+        else if (hcon_size(&rec->keywords) > 0)
         {
             while ((key = drms_record_nextkey(rec, &last, 0)) )
             {
@@ -9326,7 +9473,7 @@ int drms_populate_records(DRMS_Env_t *env, DRMS_RecordSet_t *rs, DB_Binary_Resul
                      * keywords should have been populated in the keywords section just above. */
                     snprintf(kbuf, sizeof(kbuf), "cparms_sg%03d", segnum);
 
-                    segkey = hcon_lookup_lower(&(rec->keywords), kbuf);
+                    segkey = rec->keycols ? drms_keycolumns_peek(rec, kbuf, &scratchkey) : hcon_lookup_lower(&(rec->keywords), kbuf);
                     if (segkey)
                     {
                         snprintf(seg->cparms, DRMS_MAXCPARMS, "%s", segkey->value.string_val);
@@ -9339,7 +9486,7 @@ int drms_populate_records(DRMS_Env_t *env, DRMS_RecordSet_t *rs, DB_Binary_Resul
                     * the segment structure */
                     snprintf(kbuf, sizeof(kbuf), "%s_bzero", seg->info->name);
 
-                    segkey = hcon_lookup_lower(&(rec->keywords), kbuf);
+                    segkey = rec->keycols ? drms_keycolumns_peek(rec, kbuf, &scratchkey) : hcon_lookup_lower(&(rec->keywords), kbuf);
                     if (segkey)
                     {
                         seg->bzero = segkey->value.double_val;
@@ -9347,7 +9494,7 @@ int drms_populate_records(DRMS_Env_t *env, DRMS_RecordSet_t *rs, DB_Binary_Resul
 
                     snprintf(kbuf, sizeof(kbuf), "%s_bscale", seg->info->name);
 
-                    segkey = hcon_lookup_lower(&(rec->keywords), kbuf);
+                    segkey = rec->keycols ? drms_keycolumns_peek(rec, kbuf, &scratchkey) : hcon_lookup_lower(&(rec->keywords), kbuf);
                     if (segkey)
                     {
                         seg->bscale = segkey->value.double_val;
@@ -10199,12 +10346,14 @@ void drms_fprint_record(FILE *keyfile, DRMS_Record_t *rec)
     fprintf(keyfile, "%-*s %d:\t%s\n",fwidth,"DB index",i,
 	   (rec->seriesinfo->dbidx_keywords[i])->info->name);
 
+  drms_keyword_materialize(rec);
   hiter_new_sort(&hit, &rec->keywords, drms_keyword_ranksort);
   while( (key = (DRMS_Keyword_t *)hiter_getnext(&hit)) )
   {
     fprintf(keyfile, "%-*s '%s':\n",13,"Keyword",key->info->name);
     drms_keyword_fprint(keyfile, key);
   }
+  hiter_free(&hit);
 
   hiter_new_sort(&hit, &rec->links, drms_link_ranksort);
   while( (link = (DRMS_Link_t *)hiter_getnext(&hit)) )
@@ -10212,6 +10361,7 @@ void drms_fprint_record(FILE *keyfile, DRMS_Record_t *rec)
     fprintf(keyfile, "%-*s '%s':\n",13,"Link",link->info->name);
     drms_link_fprint(keyfile, link);
   }
+  hiter_free(&hit);
 
   hiter_new_sort(&hit, &rec->segments, drms_segment_ranksort);
   while( (seg = (DRMS_Segment_t *)hiter_getnext(&hit)) )
@@ -10219,6 +10369,7 @@ void drms_fprint_record(FILE *keyfile, DRMS_Record_t *rec)
     fprintf(keyfile, "%-*s '%s':\n",fwidth,"Segment",seg->info->name);
       drms_segment_fprint(keyfile, seg);
   }
+  hiter_free(&hit);
   fprintf(keyfile, "================================================================================\n");
 }
 
@@ -12992,6 +13143,613 @@ unsigned int drms_recordset_getchunksize()
    /* Defaults to 128. */
    return gRSChunkSize;
 }
+
+/* Returns the next (at most) maxrows rows of record-set subset iset of a streamed record-set. The
+ * subset's query is sent the first time this is called for the subset. Returns NULL, with
+ * *status == DRMS_SUCCESS, once all rows of the subset have been returned. */
+static DB_Binary_Result_t *CursorStreamNext(DRMS_Env_t *env, DRMS_RecSetCursor_t *cursor, int iset, int maxrows, int *status)
+{
+    DB_Binary_Result_t *batch = NULL;
+    int stat = DRMS_SUCCESS;
+
+#ifndef DRMS_CLIENT
+    if (cursor->streamqueries[iset])
+    {
+        if (!cursor->stream)
+        {
+            if (env->verbose)
+            {
+                fprintf(stdout, "Streamed query ==> %s\n", cursor->streamqueries[iset]);
+            }
+
+            cursor->stream = db_stream_open(env->session->db_handle, cursor->streamqueries[iset], cursor->chunksize);
+        }
+
+        if (!cursor->stream)
+        {
+            stat = DRMS_ERROR_QUERYFAILED;
+        }
+        else
+        {
+            batch = db_stream_next(cursor->stream, maxrows);
+
+            if (cursor->stream->failed)
+            {
+                stat = DRMS_ERROR_QUERYFAILED;
+            }
+            else if (!batch)
+            {
+                /* all rows of this subset have been read */
+                db_stream_close(&cursor->stream);
+                free(cursor->streamqueries[iset]);
+                cursor->streamqueries[iset] = NULL;
+            }
+        }
+    }
+#else
+    stat = DRMS_ERROR_INVALIDDATA;
+#endif
+
+    if (status)
+    {
+        *status = stat;
+    }
+
+    return batch;
+}
+
+/* Create the records for rows of record-set subset iset of a cursored record-set, stage them if the
+ * caller asked for the record-set to be staged, and append them to the current chunk (rs->records[*nrecs]).
+ * The rows are those selected by fetchquery or, if fetchquery is NULL, rows (which this function then
+ * owns). *nloaded is the number of records appended, or -1 if no records were created. */
+static int CursorLoadRecords(DRMS_Env_t *env, DRMS_RecordSet_t *rs, int iset, const char *fetchquery, DB_Binary_Result_t *rows, int *nrecs, int *nloaded)
+{
+    int stat = DRMS_SUCCESS;
+    int nrecs_thisset = 0; /* number of recs over the current sets placed into current chunk */
+    char *seriesname = NULL;
+    DRMS_RecordSet_t *fetchedrecs = NULL;
+    const char *what = fetchquery ? fetchquery : "(prefetched or streamed rows)";
+
+    *nloaded = -1;
+    seriesname = drms_recordset_acquireseriesname(rs->ss_queries[iset]);
+
+    if (!seriesname)
+    {
+        db_free_binary_result(rows);
+        return DRMS_ERROR_OUTOFMEMORY;
+    }
+
+    /* Unrequested segments are now filtered out. They didn't used to be filtered out. */
+    fetchedrecs = drms_retrieve_records_internal(env, seriesname, NULL, NULL, NULL, 0, 0, fetchquery, fetchquery ? NULL : rows, rs->cursor->allvers[iset], 0, NULL, NULL, 0, 1, NULL, rs->ss_template_keys[iset], /* hcon of keyword structs */ rs->ss_template_segs[iset], /* hcon of keyword structs */ rs->cursor->openLinks, rs->cursor->cache_full_record, &stat);
+
+    free(seriesname);
+    seriesname = NULL;
+
+    if (stat != DRMS_SUCCESS)
+    {
+        fprintf(stderr, "Cursor query '%s' fetch failure", what);
+        return stat;
+    }
+
+    if (fetchedrecs == 0)
+    {
+        /* No more records in query result - we read them all already. */
+        return stat;
+    }
+
+    /* In this fetchedrecs structure, the only valid fields are n and records; the
+     * others, such as ss_n, ss_queries, etc., have not been set. */
+
+    /* Needed by drms_stage_records() and drms_record_getinfo(), if they are called.
+     * Doesn't hurt to set these if they are not called. */
+    fetchedrecs->ss_starts = (int *)malloc(sizeof(int) * 1);
+    fetchedrecs->ss_starts[0] = 0;
+    fetchedrecs->ss_n = 1;
+    fetchedrecs->current_record = -1;
+
+    /* if staging was requested, stage this chunk; fetchedrecs->linked_records_list has linked
+     * records needed for staging linked records' SUs */
+    if (rs->cursor->staging_needed)
+    {
+        if (rs->cursor->staging_needed == 1)
+        {
+            /* stage, but don't sort records by tapeid/filenum first */
+            stat = drms_stage_records_dontretrievelinks(fetchedrecs, rs->cursor->retrieve);
+        }
+        else if (rs->cursor->staging_needed == 2)
+        {
+            /* Stage, but first sort records by tapeid/filenum. */
+            /* There will be no rec in fetchedrecs that has a non-NULL suinfo field; these
+             * records were just retrieved. The original records in rs will also not have
+             * any SUM_info_t data since these records were never retrieved. */
+            stat = drms_sortandstage_records_dontretrievelinks(fetchedrecs, rs->cursor->retrieve, &rs->cursor->suinfo);
+        }
+        else if (rs->cursor->staging_needed == 3)
+        {
+            stat = drms_stage_records(fetchedrecs, rs->cursor->retrieve, rs->cursor->dontwait);
+        }
+        else if (rs->cursor->staging_needed == 4)
+        {
+            stat = drms_sortandstage_records(fetchedrecs, rs->cursor->retrieve,  rs->cursor->dontwait, &rs->cursor->suinfo);
+        }
+        else
+        {
+            /* Unknown value for staging_needed. */
+        }
+
+        /* if  stat == DRMS_REMOTESUMS_TRYLATER, segment files might be available later. */
+        if (stat != DRMS_SUCCESS && stat != DRMS_REMOTESUMS_TRYLATER && stat != DRMS_ERROR_SUMSTRYLATER)
+        {
+            fprintf(stderr, "Cursor query '%s' record staging failure, status=%d.\n", what, stat);
+            drms_close_records(fetchedrecs, DRMS_FREE_RECORD);
+            return stat;
+        }
+    }
+
+    /* There was a previous request for a SUM_infoEx() on all SUNUMs in the recset. This
+     * request got deferred until now - it should be processed on the newly openend chunk. */
+    /* OK to fetch info if the info was already fetched in drms_sortandstage_records() -
+     * drms_sortandstage_records() will actually change some of the info values (like
+     * online_status). */
+    if (stat == DRMS_SUCCESS)
+    {
+        if (rs->cursor->infoneeded)
+        {
+            stat = drms_record_getinfo(fetchedrecs);
+
+            if (stat != DRMS_SUCCESS)
+            {
+                fprintf(stderr, "Failure calling drms_record_getinfo(), status=%d.\n", stat);
+                drms_close_records(fetchedrecs, DRMS_FREE_RECORD);
+                return stat;
+            }
+        }
+    }
+
+    /* Put the records into rs */
+    for (nrecs_thisset = 0; nrecs_thisset < fetchedrecs->n; nrecs_thisset++)
+    {
+        rs->records[*nrecs] = fetchedrecs->records[nrecs_thisset]; /* assumes ownership */
+        fetchedrecs->records[nrecs_thisset] = NULL;
+        (*nrecs)++;
+    }
+
+    *nloaded = nrecs_thisset;
+
+    /* the list of linked records is not needed after records have been staged */
+    list_llfree(&fetchedrecs->linked_records_list);
+
+    /* Don't free the fetchedrecs that were "taken", but free the
+     * ones not used. Since the ones used were assigned NULL,
+     * the drms_free_records() call will work as desired. */
+    drms_close_records(fetchedrecs, DRMS_FREE_RECORD);
+
+    return stat;
+}
+
+/* Cursor prefetch (DRMS_PREFETCH, drms_recordset_setprefetch()). A thread fetches the rows of the next
+ * chunks of a cursored record-set from the db - and, if the record-set is to be staged, has SUMS bring
+ * their SUs online - while the module works on the current chunk. The records are still created by the
+ * main thread in drms_open_recordchunk(); the record and SU caches are not thread-safe. */
+
+/* The rows of one record chunk. A chunk may span subsets, so it is made of one or more pieces, each
+ * holding rows of one subset. */
+typedef struct DRMS_PrefetchChunk_struct
+{
+    int npieces;
+    int *isets;
+    DB_Binary_Result_t **rows;
+    long long nbytes;
+    struct DRMS_PrefetchChunk_struct *next;
+} DRMS_PrefetchChunk_t;
+
+typedef struct DRMS_RecSetPrefetch_struct
+{
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond; /* signalled when a chunk is queued or dequeued, and when the thread must stop */
+    DRMS_Env_t *env;
+    DRMS_RecordSet_t *rs;
+    DRMS_SeriesInfo_t **seriesinfo; /* series of each subset */
+    int depth;           /* maximum number of chunks queued */
+    long long memcap;    /* maximum number of bytes of rows queued */
+    DRMS_PrefetchChunk_t *head;
+    DRMS_PrefetchChunk_t *tail;
+    int nqueued;
+    long long nbytes;
+    int done;            /* the thread has queued its last chunk */
+    int stop;            /* the main thread wants the thread to exit */
+    int status;
+} DRMS_RecSetPrefetch_t;
+
+static void PrefetchFreeChunk(DRMS_PrefetchChunk_t *chunk)
+{
+    int ipiece;
+
+    if (chunk)
+    {
+        for (ipiece = 0; ipiece < chunk->npieces; ipiece++)
+        {
+            db_free_binary_result(chunk->rows[ipiece]);
+        }
+
+        free(chunk->isets);
+        free(chunk->rows);
+        free(chunk);
+    }
+}
+
+static long long PrefetchRowsMemsize(DB_Binary_Result_t *rows)
+{
+    long long nbytes = 0;
+    unsigned int icol;
+    DB_Column_t *col = NULL;
+
+    for (icol = 0; icol < rows->num_cols; icol++)
+    {
+        col = &rows->column[icol];
+        nbytes += col->offsets ? (long long)col->offsets[col->num_rows] + (col->num_rows + 1) * sizeof(unsigned int) : (long long)col->num_rows * col->size;
+        nbytes += col->num_rows * sizeof(short);
+    }
+
+    return nbytes;
+}
+
+/* Fetch the next (at most) maxrows rows of subset iset. Returns NULL when the subset has no more rows. */
+static DB_Binary_Result_t *PrefetchRows(DRMS_Env_t *env, DRMS_RecSetCursor_t *cursor, int iset, int maxrows, int *status)
+{
+    DB_Binary_Result_t *rows = NULL;
+    char sqlquery[DRMS_MAXQUERYLEN];
+
+    *status = DRMS_SUCCESS;
+
+    if (cursor->streamqueries)
+    {
+        rows = CursorStreamNext(env, cursor, iset, maxrows, status);
+    }
+    else if (cursor->names[iset])
+    {
+        snprintf(sqlquery, sizeof(sqlquery), "FETCH FORWARD %d FROM %s", maxrows, cursor->names[iset]);
+        rows = drms_query_bin(env->session, sqlquery);
+
+        if (!rows)
+        {
+            fprintf(stderr, "Cursor query '%s' prefetch failure.\n", sqlquery);
+            *status = DRMS_ERROR_QUERYFAILED;
+        }
+    }
+
+    return rows;
+}
+
+static int PrefetchCompareSU(const void *a, const void *b)
+{
+    long long sunuma = (*(DRMS_StorageUnit_t **)a)->sunum;
+    long long sunumb = (*(DRMS_StorageUnit_t **)b)->sunum;
+
+    return (sunuma > sunumb) - (sunuma < sunumb);
+}
+
+/* Ask SUMS to bring the SUs of the rows of a chunk online. The SU structs are private to this function
+ * (the env's SU cache is not thread-safe); when the main thread stages the chunk's records, SUMS finds
+ * the SUs online already. Errors are ignored - the main thread's staging will report them. */
+static void PrefetchStage(DRMS_RecSetPrefetch_t *pf, DRMS_PrefetchChunk_t *chunk)
+{
+    DRMS_StorageUnit_t *sus = NULL;
+    DRMS_StorageUnit_t **psus = NULL;
+    DB_Binary_Result_t *rows = NULL;
+    unsigned int irow;
+    int ipiece;
+    int nrows;
+    int nsus;
+    int isu;
+    int jsu;
+
+    nrows = 0;
+    for (ipiece = 0; ipiece < chunk->npieces; ipiece++)
+    {
+        nrows += chunk->rows[ipiece]->num_rows;
+    }
+
+    sus = calloc(nrows > 0 ? nrows : 1, sizeof(DRMS_StorageUnit_t));
+    psus = calloc(nrows > 0 ? nrows : 1, sizeof(DRMS_StorageUnit_t *));
+
+    if (sus && psus)
+    {
+        nsus = 0;
+        for (ipiece = 0; ipiece < chunk->npieces; ipiece++)
+        {
+            rows = chunk->rows[ipiece];
+
+            /* the second column of a record row is the record's SUNUM (see drms_populate_records()) */
+            for (irow = 0; rows->num_cols > 1 && irow < rows->num_rows; irow++)
+            {
+                if (db_binary_field_is_null(rows, irow, 1) || db_binary_field_getlonglong(rows, irow, 1) < 0)
+                {
+                    continue;
+                }
+
+                sus[nsus].seriesinfo = pf->seriesinfo[chunk->isets[ipiece]];
+                sus[nsus].mode = DRMS_READONLY;
+                sus[nsus].sunum = db_binary_field_getlonglong(rows, irow, 1);
+                psus[nsus] = &sus[nsus];
+                nsus++;
+            }
+        }
+
+        /* SUMS wants each SU once */
+        qsort(psus, nsus, sizeof(DRMS_StorageUnit_t *), PrefetchCompareSU);
+        for (isu = 0, jsu = 0; isu < nsus; isu++)
+        {
+            if (jsu == 0 || psus[isu]->sunum != psus[jsu - 1]->sunum)
+            {
+                psus[jsu++] = psus[isu];
+            }
+        }
+
+#ifndef DRMS_CLIENT
+        if (jsu > 0)
+        {
+            drms_su_getsudirs(pf->env, jsu, psus, pf->rs->cursor->retrieve, 0);
+        }
+#endif
+    }
+
+    free(psus);
+    free(sus);
+}
+
+static void *PrefetchThread(void *data)
+{
+    DRMS_RecSetPrefetch_t *pf = (DRMS_RecSetPrefetch_t *)data;
+    DRMS_RecSetCursor_t *cursor = pf->rs->cursor;
+    DRMS_PrefetchChunk_t *chunk = NULL;
+    DB_Binary_Result_t *rows = NULL;
+    int stat = DRMS_SUCCESS;
+    int iset = 0;
+    int nrows;
+    int stop = 0;
+
+    while (stat == DRMS_SUCCESS && !stop && iset < pf->rs->ss_n)
+    {
+        chunk = calloc(1, sizeof(DRMS_PrefetchChunk_t));
+
+        if (chunk)
+        {
+            chunk->isets = calloc(pf->rs->ss_n, sizeof(int));
+            chunk->rows = calloc(pf->rs->ss_n, sizeof(DB_Binary_Result_t *));
+        }
+
+        if (!chunk || !chunk->isets || !chunk->rows)
+        {
+            PrefetchFreeChunk(chunk);
+            stat = DRMS_ERROR_OUTOFMEMORY;
+            break;
+        }
+
+        /* fetch the rows of one chunk - this mirrors the loop in drms_open_recordchunk() */
+        nrows = 0;
+        while (iset < pf->rs->ss_n && nrows < cursor->chunksize)
+        {
+            rows = PrefetchRows(pf->env, cursor, iset, cursor->chunksize - nrows, &stat);
+
+            if (stat != DRMS_SUCCESS)
+            {
+                break;
+            }
+
+            if (!rows || rows->num_rows == 0)
+            {
+                /* no more rows in this subset */
+                db_free_binary_result(rows);
+                iset++;
+                continue;
+            }
+
+            chunk->isets[chunk->npieces] = iset;
+            chunk->rows[chunk->npieces] = rows;
+            chunk->npieces++;
+            chunk->nbytes += PrefetchRowsMemsize(rows);
+            nrows += rows->num_rows;
+        }
+
+        if (stat != DRMS_SUCCESS || chunk->npieces == 0)
+        {
+            PrefetchFreeChunk(chunk);
+            break;
+        }
+
+        if (cursor->staging_needed)
+        {
+            PrefetchStage(pf, chunk);
+        }
+
+        pthread_mutex_lock(&pf->mutex);
+
+        /* wait for room in the queue (a chunk bigger than the memory cap is still queued if the queue is empty) */
+        while (!pf->stop && pf->nqueued > 0 && (pf->nqueued >= pf->depth || pf->nbytes + chunk->nbytes > pf->memcap))
+        {
+            pthread_cond_wait(&pf->cond, &pf->mutex);
+        }
+
+        stop = pf->stop;
+
+        if (!stop)
+        {
+            if (pf->tail)
+            {
+                pf->tail->next = chunk;
+            }
+            else
+            {
+                pf->head = chunk;
+            }
+
+            pf->tail = chunk;
+            pf->nqueued++;
+            pf->nbytes += chunk->nbytes;
+            chunk = NULL;
+            pthread_cond_broadcast(&pf->cond);
+        }
+
+        pthread_mutex_unlock(&pf->mutex);
+        PrefetchFreeChunk(chunk);
+        chunk = NULL;
+    }
+
+    pthread_mutex_lock(&pf->mutex);
+    pf->status = stat;
+    pf->done = 1;
+    pthread_cond_broadcast(&pf->cond);
+    pthread_mutex_unlock(&pf->mutex);
+
+    return NULL;
+}
+
+/* Start the prefetch thread of a cursored record-set. */
+static int PrefetchStart(DRMS_Env_t *env, DRMS_RecordSet_t *rs)
+{
+    DRMS_RecSetPrefetch_t *pf = NULL;
+    DRMS_Record_t *template = NULL;
+    char *seriesname = NULL;
+    int stat = DRMS_SUCCESS;
+    int iset;
+
+    pf = calloc(1, sizeof(DRMS_RecSetPrefetch_t));
+
+    if (pf)
+    {
+        pf->seriesinfo = calloc(rs->ss_n > 0 ? rs->ss_n : 1, sizeof(DRMS_SeriesInfo_t *));
+    }
+
+    if (!pf || !pf->seriesinfo)
+    {
+        stat = DRMS_ERROR_OUTOFMEMORY;
+    }
+    else
+    {
+        /* the template records are looked up here, not in the thread */
+        for (iset = 0; stat == DRMS_SUCCESS && iset < rs->ss_n; iset++)
+        {
+            seriesname = drms_recordset_acquireseriesname(rs->ss_queries[iset]);
+
+            if (!seriesname)
+            {
+                stat = DRMS_ERROR_OUTOFMEMORY;
+            }
+            else if ((template = drms_template_record(env, seriesname, &stat)) != NULL)
+            {
+                pf->seriesinfo[iset] = template->seriesinfo;
+            }
+
+            free(seriesname);
+            seriesname = NULL;
+        }
+    }
+
+    if (stat == DRMS_SUCCESS)
+    {
+        pf->env = env;
+        pf->rs = rs;
+        pf->depth = rs->cursor->prefetchdepth;
+        pf->memcap = (long long)(0.4e6 * env->query_mem); /* same share of DRMS_QUERY_MEM that a single record query may use */
+        pthread_mutex_init(&pf->mutex, NULL);
+        pthread_cond_init(&pf->cond, NULL);
+
+        if (pthread_create(&pf->thread, NULL, PrefetchThread, pf))
+        {
+            fprintf(stderr, "Unable to start the record-chunk prefetch thread.\n");
+            pthread_cond_destroy(&pf->cond);
+            pthread_mutex_destroy(&pf->mutex);
+            stat = DRMS_ERROR_CANTCREATETHREAD;
+        }
+    }
+
+    if (stat == DRMS_SUCCESS)
+    {
+        rs->cursor->prefetch = pf;
+    }
+    else if (pf)
+    {
+        free(pf->seriesinfo);
+        free(pf);
+    }
+
+    return stat;
+}
+
+/* Wait for the next prefetched chunk. Returns NULL once all chunks have been returned, or if the
+ * prefetch thread failed (*status is then set). */
+static DRMS_PrefetchChunk_t *PrefetchNextChunk(DRMS_RecSetPrefetch_t *pf, int *status)
+{
+    DRMS_PrefetchChunk_t *chunk = NULL;
+
+    pthread_mutex_lock(&pf->mutex);
+
+    while (!pf->head && !pf->done)
+    {
+        pthread_cond_wait(&pf->cond, &pf->mutex);
+    }
+
+    chunk = pf->head;
+
+    if (chunk)
+    {
+        pf->head = chunk->next;
+
+        if (!pf->head)
+        {
+            pf->tail = NULL;
+        }
+
+        chunk->next = NULL;
+        pf->nqueued--;
+        pf->nbytes -= chunk->nbytes;
+        pthread_cond_broadcast(&pf->cond);
+        *status = DRMS_SUCCESS;
+    }
+    else
+    {
+        *status = pf->status;
+    }
+
+    pthread_mutex_unlock(&pf->mutex);
+
+    return chunk;
+}
+
+/* Stop the prefetch thread and free the chunks it has queued. */
+static void PrefetchStop(DRMS_RecSetPrefetch_t **ppf)
+{
+    DRMS_RecSetPrefetch_t *pf = NULL;
+    DRMS_PrefetchChunk_t *chunk = NULL;
+
+    if (ppf && *ppf)
+    {
+        pf = *ppf;
+
+        pthread_mutex_lock(&pf->mutex);
+        pf->stop = 1;
+        pthread_cond_broadcast(&pf->cond);
+        pthread_mutex_unlock(&pf->mutex);
+
+        /* the thread exits once its current db or SUMS request completes */
+        pthread_join(pf->thread, NULL);
+
+        while ((chunk = pf->head) != NULL)
+        {
+            pf->head = chunk->next;
+            PrefetchFreeChunk(chunk);
+        }
+
+        pthread_cond_destroy(&pf->cond);
+        pthread_mutex_destroy(&pf->mutex);
+        free(pf->seriesinfo);
+        free(pf);
+        *ppf = NULL;
+    }
+}
+
 /* Returns the number of records in the chunk (which could be less than the
  * chunk size for the last chunk */
 /* pos is chunk index */
@@ -13003,12 +13761,9 @@ int drms_open_recordchunk(DRMS_Env_t *env,
 {
     int stat = DRMS_SUCCESS;
     int nrecs = 0; /* number of recs over all sets placed into current chunk */
-    int nrecs_thisset = 0; /* number of recs over the current sets placed into current chunk */
 
    if (rs && rs->cursor)
    {
-      DRMS_RecordSet_t *fetchedrecs = NULL;
-
       switch (seektype)
        {
            case kRSChunk_Abs:
@@ -13057,158 +13812,116 @@ int drms_open_recordchunk(DRMS_Env_t *env,
 
       if (stat == DRMS_SUCCESS && chunkindex != rs->cursor->currentchunk)
       {
-          /* Create the cursor fetch query that gets chunksize records */
-          /* FETCH FORWARD nrecs <cursorname> */
-
           /* A chunk may span more than one dbase cursor, because it may span
            * more than one recordset subset. */
           int iset;
+          int ipiece;
+          int nloaded;
           char sqlquery[DRMS_MAXQUERYLEN];
-          char *seriesname = NULL;
-          int openLinkedRecords = 0;
-          int cache_full_record = 1;
+          DB_Binary_Result_t *batch = NULL;
+          DRMS_PrefetchChunk_t *chunk = NULL;
 
           nrecs = 0;
 
-          /* Keep fetching from cursors (one per subset), until rs->cursor->chunksize records
-           * have been fetched OR until all available records have been fetched. */
-          for (iset = 0; iset < rs->ss_n; iset++)
+#ifndef DRMS_CLIENT
+          if (rs->cursor->prefetchdepth > 0 && !rs->cursor->prefetch && env->session->db_direct)
           {
-              if (nrecs == rs->cursor->chunksize)
-              {
-                  /* A whole chunk's worth of records have been retrieved from the db. */
-                  break;
-              }
-              else if (nrecs < rs->cursor->chunksize)
+              /* if the thread cannot be started, fall back to fetching the chunks here */
+              PrefetchStart(env, rs);
+          }
+#endif
+
+          if (rs->cursor->prefetch)
+          {
+              /* the rows of this chunk have already been fetched (or are being fetched) by the prefetch thread */
+              chunk = PrefetchNextChunk(rs->cursor->prefetch, &stat);
+
+              if (chunk)
               {
                   if (rs->current_record == -1)
                   {
-                      /* this is the first time a record for this set has been placed in memory - initialize current_record */
                       rs->current_record = 0;
                   }
 
-                  seriesname = drms_recordset_acquireseriesname(rs->ss_queries[iset]);
-
-                  if (!seriesname)
+                  for (ipiece = 0; ipiece < chunk->npieces; ipiece++)
                   {
-                      stat = DRMS_ERROR_OUTOFMEMORY;
-                      break;
-                  }
-
-                  snprintf(sqlquery,
-                           sizeof(sqlquery),
-                           "FETCH FORWARD %d FROM %s",
-                           rs->cursor->chunksize - nrecs,
-                           rs->cursor->names[iset]);
+                      stat = CursorLoadRecords(env, rs, chunk->isets[ipiece], NULL, chunk->rows[ipiece], &nrecs, &nloaded);
+                      chunk->rows[ipiece] = NULL; /* owned by CursorLoadRecords() */
 
-                  /* Unrequested segments are now filtered out. They didn't used to be filtered out. */
-                  openLinkedRecords = rs->cursor->openLinks;
-                  cache_full_record = rs->cursor->cache_full_record;
-
-                  fetchedrecs = drms_retrieve_records_internal(env, seriesname, NULL, NULL, NULL, 0, 0, sqlquery, NULL, rs->cursor->allvers[iset], 0, NULL, NULL, 0, 1, NULL, rs->ss_template_keys[iset], /* hcon of keyword structs */ rs->ss_template_segs[iset], /* hcon of keyword structs */ openLinkedRecords, cache_full_record, &stat);
-
-                  free(seriesname);
-                  seriesname = NULL;
-
-                  if (stat != DRMS_SUCCESS)
-                  {
-                      fprintf(stderr, "Cursor query '%s' fetch failure", sqlquery);
-                      break;
+                      if ((stat != DRMS_SUCCESS && stat != DRMS_REMOTESUMS_TRYLATER && stat != DRMS_ERROR_SUMSTRYLATER) || nloaded < 0)
+                      {
+                          break;
+                      }
                   }
 
-                  if (fetchedrecs == 0)
+                  PrefetchFreeChunk(chunk);
+                  chunk = NULL;
+              }
+          }
+          else
+          {
+              /* Keep fetching from cursors (one per subset), until rs->cursor->chunksize records
+               * have been fetched OR until all available records have been fetched. */
+              for (iset = 0; iset < rs->ss_n; iset++)
+              {
+                  if (nrecs == rs->cursor->chunksize)
                   {
-                      /* No more records in query result - we read them all already. */
+                      /* A whole chunk's worth of records have been retrieved from the db. */
                       break;
                   }
-
-                  /* In this fetchedrecs structure, the only valid fields are n and records; the
-                   * others, such as ss_n, ss_queries, etc., have not been set. */
-
-                  /* Needed by drms_stage_records() and drms_record_getinfo(), if they are called.
-                   * Doesn't hurt to set these if they are not called. */
-                  fetchedrecs->ss_starts = (int *)malloc(sizeof(int) * 1);
-                  fetchedrecs->ss_starts[0] = 0;
-                  fetchedrecs->ss_n = 1;
-                  fetchedrecs->current_record = -1;
-
-                  if (stat == DRMS_SUCCESS)
+                  else if (nrecs < rs->cursor->chunksize)
                   {
-                        /* if staging was requested, stage this chunk; fetchedrecs->linked_records_list has linked
-                         * records needed for staging linked records' SUs */
-                        if (rs->cursor->staging_needed)
-                        {
-                            if (rs->cursor->staging_needed == 1)
-                            {
-                                /* stage, but don't sort records by tapeid/filenum first */
-                                stat = drms_stage_records_dontretrievelinks(fetchedrecs, rs->cursor->retrieve);
-                            }
-                            else if (rs->cursor->staging_needed == 2)
-                            {
-                                /* Stage, but first sort records by tapeid/filenum. */
-                                /* There will be no rec in fetchedrecs that has a non-NULL suinfo field; these
-                                * records were just retrieved. The original records in rs will also not have
-                                * any SUM_info_t data since these records were never retrieved. */
-                                stat = drms_sortandstage_records_dontretrievelinks(fetchedrecs, rs->cursor->retrieve, &rs->cursor->suinfo);
-                            }
-                            else if (rs->cursor->staging_needed == 3)
-                            {
-                                stat = drms_stage_records(fetchedrecs, rs->cursor->retrieve, rs->cursor->dontwait);
-                            }
-                            else if (rs->cursor->staging_needed == 4)
-                            {
-                                stat = drms_sortandstage_records(fetchedrecs, rs->cursor->retrieve,  rs->cursor->dontwait, &rs->cursor->suinfo);
-                            }
-                            else
-                            {
-                              /* Unknown value for staging_needed. */
-                            }
-
-                            /* if  stat == DRMS_REMOTESUMS_TRYLATER, segment files might be available later. */
-                            if (stat != DRMS_SUCCESS && stat != DRMS_REMOTESUMS_TRYLATER && stat != DRMS_ERROR_SUMSTRYLATER)
-                            {
-                              fprintf(stderr, "Cursor query '%s' record staging failure, status=%d.\n", sqlquery, stat);
-                              break;
-                            }
-                        }
-                  }
+                      if (rs->current_record == -1)
+                      {
+                          /* this is the first time a record for this set has been placed in memory - initialize current_record */
+                          rs->current_record = 0;
+                      }
 
-                  /* There was a previous request for a SUM_infoEx() on all SUNUMs in the recset. This
-                   * request got deferred until now - it should be processed on the newly openend chunk. */
-                  /* OK to fetch info if the info was already fetched in drms_sortandstage_records() -
-                   * drms_sortandstage_records() will actually change some of the info values (like
-                   * online_status). */
-                  if (stat == DRMS_SUCCESS)
-                  {
-                      if (rs->cursor->infoneeded)
+                      if (rs->cursor->streamqueries)
                       {
-                          stat = drms_record_getinfo(fetchedrecs);
+                          /* streamed record-set - the rows come from the stream instead of from a FETCH */
+                          snprintf(sqlquery, sizeof(sqlquery), "%s", rs->cursor->streamqueries[iset] ? rs->cursor->streamqueries[iset] : "");
+                          batch = CursorStreamNext(env, rs->cursor, iset, rs->cursor->chunksize - nrecs, &stat);
 
                           if (stat != DRMS_SUCCESS)
                           {
-                              fprintf(stderr, "Failure calling drms_record_getinfo(), status=%d.\n", stat);
+                              fprintf(stderr, "Streamed query '%s' fetch failure", sqlquery);
                               break;
                           }
-                      }
-                  }
 
-                  /* Put the records into rs */
-                  for (nrecs_thisset = 0; nrecs_thisset < fetchedrecs->n; nrecs_thisset++)
-                  {
-                      rs->records[nrecs] = fetchedrecs->records[nrecs_thisset]; /* assumes ownership */
-                      fetchedrecs->records[nrecs_thisset] = NULL;
-                      nrecs++;
-                  }
+                          if (!batch)
+                          {
+                              /* no more rows in this subset */
+                              continue;
+                          }
 
-                  /* the list of linked records is not needed after records have been staged */
-                  list_llfree(&fetchedrecs->linked_records_list);
+                          stat = CursorLoadRecords(env, rs, iset, NULL, batch, &nrecs, &nloaded);
+                      }
+                      else
+                      {
+                          /* FETCH FORWARD nrecs <cursorname> */
+                          snprintf(sqlquery,
+                                   sizeof(sqlquery),
+                                   "FETCH FORWARD %d FROM %s",
+                                   rs->cursor->chunksize - nrecs,
+                                   rs->cursor->names[iset]);
+
+                          stat = CursorLoadRecords(env, rs, iset, sqlquery, NULL, &nrecs, &nloaded);
+                      }
 
-                  /* Don't free the fetchedrecs that were "taken", but free the
-                   * ones not used. Since the ones used were assigned NULL,
-                   * the drms_free_records() call will work as desired. */
-                  drms_close_records(fetchedrecs, DRMS_FREE_RECORD);
-              }
-          } /* for iset */
+                      if (stat != DRMS_SUCCESS && stat != DRMS_REMOTESUMS_TRYLATER && stat != DRMS_ERROR_SUMSTRYLATER)
+                      {
+                          break;
+                      }
+
+                      if (nloaded < 0)
+                      {
+                          /* No more records in query result - we read them all already. */
+                          break;
+                      }
+                  }
+              } /* for iset */
+          }
 
           if (nrecs > 0)
           {
@@ -13390,6 +14103,18 @@ DRMS_RecordSet_t *drms_open_recordset_internal(DRMS_Env_t *env, const char *rsqu
             rs->cursor->suinfo = NULL;
             rs->cursor->openLinks = openLinks;
             rs->cursor->cache_full_record = cache_full_record;
+            rs->cursor->streamqueries = NULL;
+            rs->cursor->stream = NULL;
+            rs->cursor->prefetchdepth = env->prefetch_depth;
+            rs->cursor->prefetch = NULL;
+
+#ifndef DRMS_CLIENT
+            /* streaming needs a direct db connection (drms_server does not relay streamed queries) */
+            if (env->query_stream && env->session->db_direct && !env->print_sql_only)
+            {
+                rs->cursor->streamqueries = (char **)calloc(rs->ss_n, sizeof(char *));
+            }
+#endif
 
             iset = 0;
             list_llreset(querylist);
@@ -13452,46 +14177,60 @@ DRMS_RecordSet_t *drms_open_recordset_internal(DRMS_Env_t *env, const char *rsqu
                                 *pLimit = '\0';
                             }
 
-                            querylen = sizeof(char) * (strlen(cursorname) + strlen(cursorselect) + 128);
-                            cursorquery = malloc(querylen);
-
-                            if (!cursorquery)
+                            if (rs->cursor->streamqueries)
                             {
-                                stat = DRMS_ERROR_OUTOFMEMORY;
+                                /* the rows of this subset will be streamed instead of fetched from a cursor; the
+                                 * query is not sent until the subset's first chunk is opened */
+                                rs->cursor->streamqueries[iset] = strdup(cursorselect);
+
+                                if (!rs->cursor->streamqueries[iset])
+                                {
+                                    stat = DRMS_ERROR_OUTOFMEMORY;
+                                }
                             }
                             else
                             {
-                                snprintf(cursorquery,
-                                         querylen,
-                                         "DECLARE %s NO SCROLL CURSOR FOR (%s) FOR READ ONLY",
-                                         cursorname,
-                                         cursorselect);
-
-                                /* Now, create cursor in psql */
-                                if (env->verbose)
-                                {
-                                    fprintf(stdout, "Cursor declaration ==> %s\n", cursorquery);
-                                }
+                                querylen = sizeof(char) * (strlen(cursorname) + strlen(cursorselect) + 128);
+                                cursorquery = malloc(querylen);
 
-                                if (env->print_sql_only)
+                                if (!cursorquery)
                                 {
-                                    printf("%s;\n", cursorquery);
+                                    stat = DRMS_ERROR_OUTOFMEMORY;
                                 }
                                 else
                                 {
-                                    if (drms_dms(env->session, NULL, cursorquery))
+                                    snprintf(cursorquery,
+                                             querylen,
+                                             "DECLARE %s NO SCROLL CURSOR FOR (%s) FOR READ ONLY",
+                                             cursorname,
+                                             cursorselect);
+
+                                    /* Now, create cursor in psql */
+                                    if (env->verbose)
                                     {
-                                        stat = DRMS_ERROR_QUERYFAILED;
+                                        fprintf(stdout, "Cursor declaration ==> %s\n", cursorquery);
                                     }
-                                }
 
-                                if (stat == DRMS_SUCCESS)
-                                {
-                                    rs->cursor->names[iset] = strdup(cursorname);
-                                }
+                                    if (env->print_sql_only)
+                                    {
+                                        printf("%s;\n", cursorquery);
+                                    }
+                                    else
+                                    {
+                                        if (drms_dms(env->session, NULL, cursorquery))
+                                        {
+                                            stat = DRMS_ERROR_QUERYFAILED;
+                                        }
+                                    }
+
+                                    if (stat == DRMS_SUCCESS)
+                                    {
+                                        rs->cursor->names[iset] = strdup(cursorname);
+                                    }
 
-                                free(cursorquery);
-                                cursorquery = NULL;
+                                    free(cursorquery);
+                                    cursorquery = NULL;
+                                }
                             }
                         }
 
@@ -13773,6 +14512,27 @@ void drms_recordset_fetchnext_setcurrent(DRMS_RecordSet_t *rset, int current)
     }
 }
 
+/* Set the number of record chunks of cursored record-set rs that are fetched ahead, on a separate thread,
+ * while the caller works on the current chunk. A depth of 0 turns prefetching off. The depth must be set
+ * before the first record of the record-set is fetched. Prefetching requires a direct db connection. */
+int drms_recordset_setprefetch(DRMS_RecordSet_t *rs, int depth)
+{
+    if (!rs || !rs->cursor || depth < 0)
+    {
+        return DRMS_ERROR_INVALIDDATA;
+    }
+
+    if (rs->cursor->currentchunk != -1 || rs->cursor->prefetch)
+    {
+        fprintf(stderr, "Cannot change the prefetch depth of a record-set that has been iterated over.\n");
+        return DRMS_ERROR_INVALIDDATA;
+    }
+
+    rs->cursor->prefetchdepth = depth;
+
+    return DRMS_SUCCESS;
+}
+
 void drms_free_cursor(DRMS_RecSetCursor_t **cursor)
 {
    int iname;
@@ -13782,6 +14542,9 @@ void drms_free_cursor(DRMS_RecSetCursor_t **cursor)
    {
       if (*cursor)
       {
+         /* the prefetch thread uses the db cursors and the stream - stop it first */
+         PrefetchStop(&(*cursor)->prefetch);
+
          if ((*cursor)->names)
          {
             for (iname = 0; iname < (*cursor)->parent->ss_n; iname++)
@@ -13822,6 +14585,25 @@ void drms_free_cursor(DRMS_RecSetCursor_t **cursor)
             hcon_destroy(&((*cursor)->suinfo));
          }
 
+#ifndef DRMS_CLIENT
+         /* discards any rows of the streamed query that have not been read */
+         db_stream_close(&((*cursor)->stream));
+#endif
+
+         if ((*cursor)->streamqueries)
+         {
+            for (iname = 0; iname < (*cursor)->parent->ss_n; iname++)
+            {
+               if ((*cursor)->streamqueries[iname])
+               {
+                  free((*cursor)->streamqueries[iname]);
+               }
+            }
+
+            free((*cursor)->streamqueries);
+            (*cursor)->streamqueries = NULL;
+         }
+
          free(*cursor);
       }
 
@@ -14142,7 +14924,7 @@ DRMS_Array_t *drms_record_getvector(DRMS_Env_t *env,
                         for (row=0; row<count; row++)
                         {
                             int8_t *val = (int8_t *)(vectors->data) + (count * col + row) * drms_sizeof(type);
-                            char *db_src = bres->column[col].data + row * bres->column[col].size;
+                            char *db_src = db_column_field(&bres->column[col], row);
                             if (!bres->column[col].is_null[row])
                                 switch(type)
                             {
@@ -14377,6 +15159,7 @@ DRMS_Keyword_t *drms_record_nextkey(DRMS_Record_t *rec, HIterator_t **last, int
       }
       else
       {
+         drms_keyword_materialize(rec);
          hit = *last = (HIterator_t *)malloc(sizeof(HIterator_t));
          if (hit != NULL)
          {
@@ -208,6 +208,7 @@ DRMS_Record_t *drms_recordset_fetchnext(DRMS_Env_t *env,
                                         int *newchunk);
 int drms_recordset_fetchnext_getcurrent(DRMS_RecordSet_t *rset);
 void drms_recordset_fetchnext_setcurrent(DRMS_RecordSet_t *rset, int current);
+int drms_recordset_setprefetch(DRMS_RecordSet_t *rs, int depth);
 
 void drms_free_cursor(DRMS_RecSetCursor_t **cursor);
 
@@ -485,6 +486,11 @@ int drms_is_manifest_specification(const char *query, char **manifest_table_out,
    record in the sequence.  When ::drms_recordset_fetchnext returns NULL, no more
    records remain in the record-set.
 
+   To overlap database (and SUMS staging) latency with the processing of the current
+   chunk, the caller can have the next chunks fetched on a background thread by
+   calling ::drms_recordset_setprefetch (or by running the module with
+   DRMS_PREFETCH=<depth>) before the first call to ::drms_recordset_fetchnext.
+
    @param env DRMS session information.
    @param rsquery A string that specifies a database query. It
    includes a series name and clauses to extract a subset of records from that series.
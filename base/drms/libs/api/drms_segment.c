@@ -18,6 +18,11 @@
  *      drms_segment_lookup
  *      drms_segment_lookupnum
  *      drms_segment_read
+ *      drms_segment_read_mapped
+ *      drms_segment_reader_create
+ *      drms_segment_reader_next
+ *      drms_segment_reader_destroy
+ *      drms_segment_read_many
  *      drms_segment_readslice
  *      drms_segment_write
  *      drms_segment_write_from_file
@@ -33,6 +38,8 @@
 #include "drms_priv.h"
 #include <float.h>
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include "xmem.h"
 #include "drms_dsdsapi.h"
 #include "cfitsio.h"
@@ -558,6 +565,8 @@ HContainer_t *drms_segment_createinfocon(DRMS_Env_t *drmsEnv,
 			 iSeg++;
 		    }
 
+		    hiter_free(&hit);
+
 		    ret = hcon_create(sizeof(DRMS_SegmentInfo_t),
 				      DRMS_MAXSEGNAMELEN,
 				      NULL,
@@ -718,18 +727,14 @@ DRMS_Segment_t *drms_segment_lookupnum(DRMS_Record_t *rec, int segnum)
    HIterator_t hit;
    DRMS_Segment_t *seg = NULL;
 
-   hiter_new_sort(&hit, &rec->segments, drms_segment_ranksort);
+   /* segnums are unique, so there is no need to walk the segments in rank order */
+   hiter_new(&hit, &rec->segments);
    while ((seg = (DRMS_Segment_t *)hiter_getnext(&hit)) != NULL)
    {
       if (seg->info->segnum == segnum)
       {
          break;
       }
-      else if (seg->info->segnum > segnum)
-      {
-         seg = NULL;
-         break;
-      }
    }
 
    if (seg)
@@ -970,6 +975,250 @@ int drms_segment_fclose(FILE *fptr)
    return ret;
 }
 
+/* How drms_segment_read() maps a segment file into memory (see SegmentMapFile()). */
+enum SegMapMode_enum
+{
+    kSegMapNone = 0,  /* read the file */
+    kSegMapConvert,   /* map the file, and convert (or copy) the data out of the mapping */
+    kSegMapKeep       /* map the file, and return the mapping as the array's data */
+};
+
+typedef enum SegMapMode_enum SegMapMode_t;
+
+/* Number of elements at a time that are fixed up and converted out of a mapped segment file. */
+#define kSegMapChunk 65536
+
+/* Default read-ahead of drms_segment_reader_next() - files, and bytes. */
+#define kSegReadAheadDepth 4
+#define kSegReadAheadBytes (256LL * 1024 * 1024)
+
+/* How the data of a mapped segment file differ from what drms_segment_read() returns. */
+typedef struct SegMapLayout_struct
+{
+    int mapped;       /* the array's data are the mapped file */
+    int swap;         /* the data are not in host byte order */
+    int ubyte;        /* FITS BYTE_IMG - the data are unsigned bytes */
+    int hasblank;     /* integer data whose blank value must be set to DRMS missing */
+    long long blank;
+} SegMapLayout_t;
+
+/* Maps the data of an uncompressed DRMS_BINARY, DRMS_FITS, or DRMS_FITZ file into memory. *arrout is an
+ * array whose data are the data in the file, as stored; layout says what must be done to them. Returns
+ * an error if the file cannot be mapped (e.g., it is tile-compressed), in which case the caller should read it. */
+static int SegmentMapFile(int verbose, DRMS_Protocol_t protocol, char *filename, DRMS_Array_t **arrout, SegMapLayout_t *layout)
+{
+    DRMS_Array_t *arr = NULL;
+    long long offset = 0;
+    int statint = DRMS_SUCCESS;
+
+    memset(layout, 0, sizeof(SegMapLayout_t));
+
+    if (protocol == DRMS_BINARY)
+    {
+        arr = calloc(1, sizeof(DRMS_Array_t));
+        XASSERT(arr);
+
+        if (drms_binfile_readlayout(filename, arr, &offset) != DRMS_SUCCESS)
+        {
+            statint = DRMS_ERROR_INVALIDFILE;
+        }
+        else if (arr->type == DRMS_TYPE_STRING || offset % drms_sizeof(arr->type) != 0)
+        {
+            /* Strings aren't stored as an array of elements, and unaligned data can't be used in place. */
+            statint = DRMS_ERROR_NOTIMPLEMENTED;
+        }
+        else
+        {
+            statint = drms_array_mapfile(arr, filename, offset, drms_array_size(arr));
+        }
+
+        if (statint != DRMS_SUCCESS)
+        {
+            free(arr);
+            arr = NULL;
+        }
+#if __BYTE_ORDER == __BIG_ENDIAN
+        /* binary segment files are little-endian */
+        layout->swap = 1;
+#endif
+    }
+    else
+    {
+        CFITSIO_IMAGE_INFO *info = NULL;
+        DRMS_Array_t map;
+        long long npix;
+        int iaxis;
+
+        if (fitsrw_readintfile_layout(verbose, filename, &info, &offset) != CFITSIO_SUCCESS)
+        {
+            /* Tile-compressed images can't be mapped. */
+            return DRMS_ERROR_NOTIMPLEMENTED;
+        }
+
+        for (iaxis = 0, npix = 1; iaxis < info->naxis; iaxis++)
+        {
+            npix *= info->naxes[iaxis];
+        }
+
+        memset(&map, 0, sizeof(map));
+        statint = drms_array_mapfile(&map, filename, offset, npix * (abs(info->bitpix) / 8));
+
+        if (statint == DRMS_SUCCESS)
+        {
+            if (info->bitpix == 8)
+            {
+                /* BYTE_IMG - shift the unsigned bytes into the signed-char range, as fitsrw_readintfile() does */
+                layout->ubyte = 1;
+                info->bzero = 128.0 * info->bscale + info->bzero;
+                info->blank = info->blank - 128;
+            }
+
+            if (info->bitpix > 0 && (info->bitfield & kInfoPresent_BLANK))
+            {
+                /* The blanks are set to missing when the data are fixed up, not by drms_fitsrw_CreateDRMSArray(). */
+                layout->hasblank = 1;
+                layout->blank = info->blank;
+                info->bitfield &= ~kInfoPresent_BLANK;
+            }
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+            /* FITS files are big-endian */
+            layout->swap = 1;
+#endif
+            if (drms_fitsrw_CreateDRMSArray(info, map.data, &arr))
+            {
+                drms_array_freedata(&map);
+                arr = NULL;
+                statint = DRMS_ERROR_ARRAYCREATEFAILED;
+            }
+            else
+            {
+                arr->mapaddr = map.mapaddr;
+                arr->maplen = map.maplen;
+            }
+        }
+
+        cfitsio_free_these(&info, NULL, NULL);
+    }
+
+    if (statint == DRMS_SUCCESS)
+    {
+        layout->mapped = 1;
+        *arrout = arr;
+    }
+
+    return statint;
+}
+
+/* Puts n elements of mapped segment data into the form drms_segment_read() returns them in. */
+static void SegmentFixChunk(DRMS_Type_t type, arraylen_t n, void *data, const SegMapLayout_t *layout)
+{
+    DRMS_Array_t chunk;
+    arraylen_t ielem;
+
+    if (layout->swap)
+    {
+        drms_byteswap(type, (int)n, (char *)data);
+    }
+
+    if (layout->ubyte)
+    {
+        unsigned char *in = (unsigned char *)data;
+        signed char *out = (signed char *)data;
+
+        for (ielem = 0; ielem < n; ielem++)
+        {
+            out[ielem] = (signed char)(in[ielem] - 128);
+        }
+    }
+
+    if (layout->hasblank)
+    {
+        memset(&chunk, 0, sizeof(chunk));
+        chunk.type = type;
+        chunk.naxis = 1;
+        chunk.axis[0] = (int)n;
+        chunk.data = data;
+        drms_fitsrw_ShootBlanks(&chunk, layout->blank);
+    }
+}
+
+/* Finishes drms_segment_read() of a mapped segment file. If the data are to be converted, they are converted
+ * a chunk at a time straight out of the mapping into a new array, and the file is unmapped. Otherwise, if keepmap,
+ * the data are fixed up in place (the mapping is private, so the file is not modified), or else they are copied into
+ * a new array. */
+static int SegmentFinishMapped(DRMS_Array_t *arr, const SegMapLayout_t *layout, DRMS_Type_t type, int keepmap)
+{
+    int convert = (type != DRMS_TYPE_RAW && (arr->type != type || arr->bscale != 1.0 || arr->bzero != 0.0));
+    DRMS_Type_t dsttype = convert ? type : arr->type;
+    arraylen_t nelem = drms_array_count(arr);
+    int srcsize = drms_sizeof(arr->type);
+    int dstsize = drms_sizeof(dsttype);
+    arraylen_t start;
+    arraylen_t count;
+    char *src = (char *)arr->data;
+    char *dst = NULL;
+    char *scratch = NULL;
+
+    if (!convert && keepmap)
+    {
+        for (start = 0; start < nelem; start += count)
+        {
+            count = nelem - start < kSegMapChunk ? nelem - start : kSegMapChunk;
+            SegmentFixChunk(arr->type, count, src + start * srcsize, layout);
+        }
+    }
+    else
+    {
+        dst = malloc(nelem * dstsize);
+        if (convert)
+        {
+            scratch = malloc(kSegMapChunk * srcsize);
+        }
+
+        if (!dst || (convert && !scratch))
+        {
+            free(dst);
+            free(scratch);
+            return DRMS_ERROR_OUTOFMEMORY;
+        }
+
+        for (start = 0; start < nelem; start += count)
+        {
+            count = nelem - start < kSegMapChunk ? nelem - start : kSegMapChunk;
+
+            if (convert)
+            {
+                memcpy(scratch, src + start * srcsize, count * srcsize);
+                SegmentFixChunk(arr->type, count, scratch, layout);
+                drms_array_rawconvert(count, dsttype, arr->bzero, arr->bscale, dst + start * dstsize, arr->type, scratch);
+            }
+            else
+            {
+                memcpy(dst + start * dstsize, src + start * srcsize, count * srcsize);
+                SegmentFixChunk(arr->type, count, dst + start * dstsize, layout);
+            }
+        }
+
+        free(scratch);
+
+        /* unmap the file */
+        drms_array_freedata(arr);
+        arr->data = dst;
+        arr->type = dsttype;
+    }
+
+    if (type == DRMS_TYPE_RAW)
+    {
+        arr->israw = 1;
+    }
+    else if (convert)
+    {
+        arr->israw = 0;
+    }
+
+    return DRMS_SUCCESS;
+}
+
 /* Open an array data segment.
 
    a) If the corresponding data file exists, read the
@@ -984,13 +1233,15 @@ int drms_segment_fclose(FILE *fptr)
 */
 
 
-DRMS_Array_t *drms_segment_read(DRMS_Segment_t *seg, DRMS_Type_t type,
-				int *status)
+static DRMS_Array_t *SegmentRead(DRMS_Segment_t *seg, DRMS_Type_t type, SegMapMode_t mapmode, int *status)
 {
     int statint=0,i;
     DRMS_Array_t *arr = NULL;
     char filename[DRMS_MAXPATHLEN];
     DRMS_Record_t *rec;
+    SegMapLayout_t maplayout;
+
+    memset(&maplayout, 0, sizeof(maplayout));
 
     CHECKNULL_STAT(seg,status);
 
@@ -1240,7 +1491,12 @@ DRMS_Array_t *drms_segment_read(DRMS_Segment_t *seg, DRMS_Type_t type,
             goto bailout1;
             break;
             case DRMS_BINARY:
-            arr = malloc(sizeof(DRMS_Array_t));
+            if (mapmode != kSegMapNone && SegmentMapFile(rec->env->verbose, DRMS_BINARY, filename, &arr, &maplayout) == DRMS_SUCCESS)
+            {
+                break;
+            }
+
+            arr = calloc(1, sizeof(DRMS_Array_t));
             XASSERT(arr);
             if ((statint = drms_binfile_read(filename, 0, arr)))
             {
@@ -1250,7 +1506,7 @@ DRMS_Array_t *drms_segment_read(DRMS_Segment_t *seg, DRMS_Type_t type,
             }
             break;
             case DRMS_BINZIP:
-            arr = malloc(sizeof(DRMS_Array_t));
+            arr = calloc(1, sizeof(DRMS_Array_t));
             XASSERT(arr);
             if ((statint = drms_zipfile_read(filename, 0, arr)))
             {
@@ -1265,7 +1521,13 @@ DRMS_Array_t *drms_segment_read(DRMS_Segment_t *seg, DRMS_Type_t type,
                 CFITSIO_IMAGE_INFO *info = NULL;
                 void *image = NULL;
 
-                /* Call Tim's function to read data */
+                if (mapmode != kSegMapNone && SegmentMapFile(rec->env->verbose, seg->info->protocol, filename, &arr, &maplayout) == DRMS_SUCCESS)
+                {
+                    break;
+                }
+
+                /* Call Tim's function to read data (tile-compressed images are uncompressed by env->fits_threads threads) */
+                fitsrw_set_threads(rec->env->fits_threads);
                 if (fitsrw_readintfile(rec->env->verbose, filename, &info, &image, NULL) == CFITSIO_SUCCESS)
                 {
                     if (drms_fitsrw_CreateDRMSArray(info, image, &arr))
@@ -1358,7 +1620,14 @@ DRMS_Array_t *drms_segment_read(DRMS_Segment_t *seg, DRMS_Type_t type,
     arr->parent_segment = seg;
 
     /* Scale and convert to desired type. */
-    if (type == DRMS_TYPE_RAW)
+    if (maplayout.mapped)
+    {
+        if ((statint = SegmentFinishMapped(arr, &maplayout, type, mapmode == kSegMapKeep)) != DRMS_SUCCESS)
+        {
+            goto bailout;
+        }
+    }
+    else if (type == DRMS_TYPE_RAW)
     {
         arr->israw = 1;
     }
@@ -1378,8 +1647,7 @@ DRMS_Array_t *drms_segment_read(DRMS_Segment_t *seg, DRMS_Type_t type,
     return arr;
 
 bailout:
-    free(arr->data);
-    free(arr);
+    drms_free_array(arr);
 bailout1:
 #ifdef DEBUG
     printf("Segment = \n");
@@ -1390,6 +1658,333 @@ bailout1:
     return NULL;
 }
 
+DRMS_Array_t *drms_segment_read(DRMS_Segment_t *seg, DRMS_Type_t type,
+				int *status)
+{
+    int segment_mmap = seg && seg->record && seg->record->env->segment_mmap;
+
+    return SegmentRead(seg, type, segment_mmap ? kSegMapConvert : kSegMapNone, status);
+}
+
+DRMS_Array_t *drms_segment_read_mapped(DRMS_Segment_t *seg, DRMS_Type_t type, int *status)
+{
+    return SegmentRead(seg, type, kSegMapKeep, status);
+}
+
+/* Read-ahead for drms_segment_reader_next(). Records whose segment files have been advised to the kernel
+ * (posix_fadvise(POSIX_FADV_WILLNEED), which starts reading the file into the page cache and returns), but
+ * not yet read. */
+typedef struct
+{
+    DRMS_Record_t *rec;
+    long long nbytes;
+} SegReadAhead_t;
+
+struct DRMS_SegReader_struct
+{
+    DRMS_RecordSet_t *rs;
+    char segname[DRMS_MAXSEGNAMELEN];
+    DRMS_Type_t type;
+    int depth;                /* at most this many records are read ahead */
+    long long maxbytes;       /* at most this many bytes are read ahead (but always at least one record) */
+    long long inflight;       /* bytes advised, but not yet read */
+    SegReadAhead_t *ahead;    /* ring of depth advised records, oldest first */
+    int head;
+    int count;
+    int nextahead;            /* index in rs->records of the next record to advise */
+};
+
+/* Advises the kernel that seg's file will be read soon. Returns the size of the file (0 if seg has no
+ * file of its own that drms_segment_read() reads whole, or if its SU has not been fetched from SUMS -
+ * fetching it could block on a tape read, so read-ahead skips it). */
+static long long SegmentAdvise(DRMS_Segment_t *seg)
+{
+    char filename[DRMS_MAXPATHLEN];
+    struct stat stbuf;
+    long long nbytes = 0;
+    int fd;
+
+    switch (seg->info->protocol)
+    {
+        case DRMS_BINARY:
+        case DRMS_BINZIP:
+        case DRMS_FITZ:
+        case DRMS_FITS:
+          break;
+        default:
+          /* TAS files hold the segments of many records; other protocols aren't read from a file */
+          return 0;
+    }
+
+    if (seg->record->sunum != -1LL && (seg->record->su == NULL || *seg->record->su->sudir == '\0'))
+    {
+        /* not online yet; drms_segment_filename() would call drms_getunit() and wait for SUMS */
+        return 0;
+    }
+
+    drms_segment_filename(seg, filename);
+
+    if (*filename && (fd = open(filename, O_RDONLY)) != -1)
+    {
+        if (fstat(fd, &stbuf) == 0)
+        {
+            nbytes = (long long)stbuf.st_size;
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        }
+
+        close(fd);
+    }
+
+    return nbytes;
+}
+
+/* Advises the records that follow the current record of reader->rs, while the read-ahead budget allows. */
+static void SegmentReadAhead(DRMS_SegReader_t *reader)
+{
+    DRMS_RecordSet_t *rs = reader->rs;
+    DRMS_Segment_t *seg = NULL;
+    SegReadAhead_t *slot = NULL;
+    int current;
+    int last;
+
+    if (rs->cursor)
+    {
+        /* only the current chunk is in rs->records */
+        current = rs->cursor->currentrec;
+        last = (rs->cursor->lastrec >= 0) ? rs->cursor->lastrec : rs->cursor->chunksize - 1;
+    }
+    else
+    {
+        /* current_record is the index of the next record */
+        current = rs->current_record - 1;
+        last = rs->n - 1;
+    }
+
+    if (reader->nextahead <= current)
+    {
+        reader->nextahead = current + 1;
+    }
+
+    while (reader->count < reader->depth && reader->nextahead <= last && (reader->count == 0 || reader->inflight < reader->maxbytes))
+    {
+        slot = &reader->ahead[(reader->head + reader->count) % reader->depth];
+        slot->rec = rs->records[reader->nextahead];
+        slot->nbytes = 0;
+
+        if (slot->rec && (seg = drms_segment_lookup(slot->rec, reader->segname)) != NULL)
+        {
+            slot->nbytes = SegmentAdvise(seg);
+        }
+
+        reader->inflight += slot->nbytes;
+        reader->count++;
+        reader->nextahead++;
+    }
+}
+
+DRMS_SegReader_t *drms_segment_reader_create(DRMS_RecordSet_t *rs, const char *segname, DRMS_Type_t type, int depth, long long maxbytes, int *status)
+{
+    DRMS_SegReader_t *reader = NULL;
+    int statint = DRMS_SUCCESS;
+
+    if (!rs || !segname)
+    {
+        statint = DRMS_ERROR_INVALIDDATA;
+    }
+    else
+    {
+        reader = calloc(1, sizeof(DRMS_SegReader_t));
+        if (reader)
+        {
+            reader->depth = (depth > 0) ? depth : kSegReadAheadDepth;
+            reader->ahead = calloc(reader->depth, sizeof(SegReadAhead_t));
+        }
+
+        if (!reader || !reader->ahead)
+        {
+            if (reader)
+            {
+                free(reader);
+                reader = NULL;
+            }
+
+            statint = DRMS_ERROR_OUTOFMEMORY;
+        }
+        else
+        {
+            reader->rs = rs;
+            snprintf(reader->segname, sizeof(reader->segname), "%s", segname);
+            reader->type = type;
+            reader->maxbytes = (maxbytes > 0) ? maxbytes : kSegReadAheadBytes;
+        }
+    }
+
+    if (status)
+    {
+        *status = statint;
+    }
+
+    return reader;
+}
+
+DRMS_Array_t *drms_segment_reader_next(DRMS_SegReader_t *reader, DRMS_Record_t **recout, int *status)
+{
+    DRMS_Record_t *rec = NULL;
+    DRMS_Segment_t *seg = NULL;
+    DRMS_Array_t *arr = NULL;
+    DRMS_Env_t *env = NULL;
+    int newchunk = 0;
+    int statint = DRMS_SUCCESS;
+
+    if (recout)
+    {
+        *recout = NULL;
+    }
+
+    if (!reader)
+    {
+        statint = DRMS_ERROR_INVALIDDATA;
+    }
+    else
+    {
+        env = reader->rs->cursor ? reader->rs->cursor->env : NULL;
+        rec = drms_recordset_fetchnext(env, reader->rs, &statint, NULL, &newchunk);
+
+        if (newchunk)
+        {
+            /* the records read ahead belonged to the previous chunk, which has been freed */
+            reader->head = 0;
+            reader->count = 0;
+            reader->inflight = 0;
+            reader->nextahead = 0;
+        }
+        else if (reader->count > 0 && reader->ahead[reader->head].rec == rec)
+        {
+            reader->inflight -= reader->ahead[reader->head].nbytes;
+            reader->head = (reader->head + 1) % reader->depth;
+            reader->count--;
+        }
+
+        if (rec)
+        {
+            /* start reading the next files before reading this one */
+            SegmentReadAhead(reader);
+
+            if (recout)
+            {
+                *recout = rec;
+            }
+
+            if ((seg = drms_segment_lookup(rec, reader->segname)) == NULL)
+            {
+                statint = DRMS_ERROR_UNKNOWNSEGMENT;
+            }
+            else
+            {
+                arr = drms_segment_read(seg, reader->type, &statint);
+            }
+        }
+        else if (statint == DRMS_REMOTESUMS_TRYLATER || statint == DRMS_ERROR_SUMSTRYLATER)
+        {
+            statint = DRMS_SUCCESS;
+        }
+    }
+
+    if (status)
+    {
+        *status = statint;
+    }
+
+    return arr;
+}
+
+void drms_segment_reader_destroy(DRMS_SegReader_t **reader)
+{
+    if (reader && *reader)
+    {
+        free((*reader)->ahead);
+        free(*reader);
+        *reader = NULL;
+    }
+}
+
+DRMS_Array_t **drms_segment_read_many(DRMS_RecordSet_t *rs, const char *segname, DRMS_Type_t type, int *narrays, int *status)
+{
+    DRMS_SegReader_t *reader = NULL;
+    DRMS_Record_t *rec = NULL;
+    DRMS_Array_t *arr = NULL;
+    DRMS_Array_t **arrays = NULL;
+    DRMS_Array_t **newarrays = NULL;
+    int nalloc = 0;
+    int narr = 0;
+    int statint = DRMS_SUCCESS;
+    int readstat = DRMS_SUCCESS;
+
+    reader = drms_segment_reader_create(rs, segname, type, 0, 0, &statint);
+
+    while (reader)
+    {
+        arr = drms_segment_reader_next(reader, &rec, &readstat);
+
+        if (!rec)
+        {
+            /* no more records */
+            if (readstat != DRMS_SUCCESS && statint == DRMS_SUCCESS)
+            {
+                statint = readstat;
+            }
+            break;
+        }
+
+        if (narr == nalloc)
+        {
+            nalloc = (nalloc > 0) ? nalloc * 2 : (rs->n > 0 ? rs->n : 64);
+            newarrays = realloc(arrays, nalloc * sizeof(DRMS_Array_t *));
+            if (!newarrays)
+            {
+                drms_free_array(arr);
+                statint = DRMS_ERROR_OUTOFMEMORY;
+                break;
+            }
+
+            arrays = newarrays;
+        }
+
+        /* a record whose segment can't be read gets a NULL array */
+        arrays[narr++] = arr;
+
+        if (readstat != DRMS_SUCCESS && statint == DRMS_SUCCESS)
+        {
+            statint = readstat;
+        }
+    }
+
+    drms_segment_reader_destroy(&reader);
+
+    if (statint == DRMS_ERROR_OUTOFMEMORY)
+    {
+        while (narr > 0)
+        {
+            drms_free_array(arrays[--narr]);
+        }
+
+        free(arrays);
+        arrays = NULL;
+    }
+
+    if (narrays)
+    {
+        *narrays = narr;
+    }
+
+    if (status)
+    {
+        *status = statint;
+    }
+
+    return arrays;
+}
+
 
 /* The dimensionality of start, end, and seg must all match.
  *
@@ -1487,7 +2082,7 @@ DRMS_Array_t *drms_segment_readslice(DRMS_Segment_t *seg, DRMS_Type_t type,
      switch(seg->info->protocol)
      {
         case DRMS_BINARY:
-          arr = malloc(sizeof(DRMS_Array_t));
+          arr = calloc(1, sizeof(DRMS_Array_t));
           XASSERT(arr);
           if ((statint = drms_binfile_read(filename, 0, arr)))
           {
@@ -1497,7 +2092,7 @@ DRMS_Array_t *drms_segment_readslice(DRMS_Segment_t *seg, DRMS_Type_t type,
           }
           break;
         case DRMS_BINZIP:
-          arr = malloc(sizeof(DRMS_Array_t));
+          arr = calloc(1, sizeof(DRMS_Array_t));
           XASSERT(arr);
           if ((statint = drms_zipfile_read(filename, 0, arr)))
           {
@@ -1879,6 +2474,7 @@ static int drms_segment_writeinternal(DRMS_Segment_t *seg, DRMS_Array_t *arr, in
 	 {
          /* Need to change the compression parameter to something meaningful
           * (although new users should just use the DRMS_FITS protocol )*/
+         fitsrw_set_threads(seg->record->env->fits_threads);
          if (fitsrw_writeintfile(seg->record->env->verbose, filename, &imginfo, out->data, seg->cparms, fitskeys) != CFITSIO_SUCCESS)
          {
              status = DRMS_ERROR_FITSRW;
@@ -1936,6 +2532,7 @@ static int drms_segment_writeinternal(DRMS_Segment_t *seg, DRMS_Array_t *arr, in
 
 	 if (!drms_fitsrw_SetImageInfo(out, &imginfo))
 	 {
+	    fitsrw_set_threads(seg->record->env->fits_threads);
 	    if (fitsrw_writeintfile(seg->record->env->verbose, filename, &imginfo, out->data, seg->cparms, fitskeys) != CFITSIO_SUCCESS)
             {
                status = DRMS_ERROR_FITSRW;
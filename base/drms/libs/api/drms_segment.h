@@ -331,6 +331,81 @@ FILE *drms_segment_fopen(DRMS_Segment_t *seg, const char *newfilename, int appen
 */
 DRMS_Array_t *drms_segment_read(DRMS_Segment_t *seg, DRMS_Type_t type,
 				int *status);
+/**
+   Similar to ::drms_segment_read, except that the data of an uncompressed DRMS_BINARY, DRMS_FITS, or
+   DRMS_FITZ segment file are not read. The file is mapped into memory instead, and, if no conversion
+   is needed (@a type is ::DRMS_TYPE_RAW, or the file's type with no scaling), the returned array's data
+   are the mapping. The mapping is private - changes to the array's data are not written to the file.
+   Such an array must be freed with ::drms_free_array; its data must not be freed or reallocated.
+   Data that need fixing up are fixed up in place before this function returns, which reads every page
+   and turns it into a private copy. FITS data are big-endian, so on little-endian hosts they are always
+   byte-swapped this way (as are DRMS_BINARY data on big-endian hosts); 8-bit FITS data and data with
+   BLANK values are fixed up too. Only data that need no fixing up have their pages loaded lazily, when
+   they are first accessed. If a conversion is needed, the data are converted out of the mapping into a
+   new array, and the file is unmapped. If the file cannot be mapped (e.g., it is tile-compressed), it
+   is read as ::drms_segment_read reads it.
+
+    @param seg The segment whose file is to be mapped into memory.
+    @param type The type to which the data of @seg is converted.
+    @param status DRMS status (see drms_statuscodes.h). 0 if successful, non-0 otherwise.
+    @return The created DRMS array struct.
+*/
+DRMS_Array_t *drms_segment_read_mapped(DRMS_Segment_t *seg, DRMS_Type_t type, int *status);
+
+/** \brief Opaque iterator that reads one segment of each record of a record set - see ::drms_segment_reader_create. */
+typedef struct DRMS_SegReader_struct DRMS_SegReader_t;
+
+/**
+   Creates an iterator that reads the segment @a segname of each record of @a rs, in order, starting
+   with the record after the one last returned by ::drms_recordset_fetchnext (the iterator uses
+   ::drms_recordset_fetchnext, so it works with cursored record sets too). While the caller processes
+   one record's array, the segment files of the next records are read ahead into the page cache,
+   so that reading them does not wait on the disk. Segment files of TAS segments are not read ahead,
+   nor are those of records whose storage units have not yet been fetched from SUMS (the read ahead
+   never waits on SUMS). To stage the storage units of all records in one SUMS request, so that
+   their files are read ahead, call ::drms_stage_records first.
+
+   @param rs The record set whose records' segments are read.
+   @param segname The name of the segment to read.
+   @param type The type to which the data are converted (as in ::drms_segment_read).
+   @param depth The maximum number of files read ahead (if <= 0, then 4).
+   @param maxbytes The maximum number of bytes read ahead (if <= 0, then 256 MB); at least one
+   file is read ahead, regardless of its size.
+   @param status DRMS status (see drms_statuscodes.h). 0 if successful, non-0 otherwise.
+   @return The iterator, which must be freed with ::drms_segment_reader_destroy.
+*/
+DRMS_SegReader_t *drms_segment_reader_create(DRMS_RecordSet_t *rs, const char *segname, DRMS_Type_t type, int depth, long long maxbytes, int *status);
+
+/**
+   Reads the segment of the next record of the iterator's record set. At the end of the record set,
+   NULL is returned, and @a rec is set to NULL. If the segment of a record cannot be read, NULL is
+   returned, @a rec is set to the record, and @a status is set to the error.
+
+   @param reader The iterator.
+   @param rec The record whose segment was read, returned by reference.
+   @param status DRMS status (see drms_statuscodes.h). 0 if successful, non-0 otherwise.
+   @return The array of the segment, which the caller must free with ::drms_free_array.
+*/
+DRMS_Array_t *drms_segment_reader_next(DRMS_SegReader_t *reader, DRMS_Record_t **rec, int *status);
+
+/**
+   Frees the iterator @a reader, and sets it to NULL.
+*/
+void drms_segment_reader_destroy(DRMS_SegReader_t **reader);
+
+/**
+   Reads the segment @a segname of all (remaining) records of @a rs with a ::DRMS_SegReader_t.
+   Returns an array of @a narrays arrays, one per record, in record-set order; the array of a record
+   whose segment could not be read is NULL, and @a status is set to the first error.
+
+   @param rs The record set whose records' segments are read.
+   @param segname The name of the segment to read.
+   @param type The type to which the data are converted (as in ::drms_segment_read).
+   @param narrays The number of records read, returned by reference.
+   @param status DRMS status (see drms_statuscodes.h). 0 if successful, non-0 otherwise.
+   @return The arrays; the caller must free each with ::drms_free_array, and then the array of arrays with free().
+*/
+DRMS_Array_t **drms_segment_read_many(DRMS_RecordSet_t *rs, const char *segname, DRMS_Type_t type, int *narrays, int *status);
 /**
    Similar to ::drms_segment_read, except
    that only the data between the @a start[n] and @a end[n] values in each
@@ -3619,7 +3619,7 @@ int drms_delete_series(DRMS_Env_t *env, const char *series, int cascade, int kee
            /* Since we are now caching series on-demand, this series may not be in the
             * series_cache, but hcon_remove handles this fine. */
 
-           hcon_remove(&env->series_cache,series_lower);
+           drms_series_cache_remove(env, series_lower);
         }
         else
         {
@@ -36,7 +36,18 @@ DRMS_Shutdown_State_t gShutdown; /* shudown state following receipt by DRMS of a
                                  * causes module termination */
 
 pthread_mutex_t *gSUMSbusyMtx = NULL;
-int gSUMSbusy = 0;
+int gSUMSbusy = 0; /* number of SUMS workers polling SUMS for the completion of a tape read */
+
+/* The SUMS client library keeps per-process state (RPC client handles, the list of open SUMS sessions,
+ * the last RPC client used), so only one SUMS worker at a time may be inside the library. The lock is
+ * held for a single SUMS API call, except for an RPC SUM_get(): while its tape read is pending, sum_svc's
+ * reply to it is the next message the library takes (getanymsg() takes whichever reply arrives), so no
+ * other SUMS call may be made until SUM_poll() has it. The worker serving the SUM_get() holds the lock
+ * from the SUM_get() call until the tape read completes (SumsLibHold()/SumsLibRelease()). */
+static pthread_mutex_t gSUMSlibMtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t gSUMSlibHoldMtx = PTHREAD_MUTEX_INITIALIZER; /* guards the two below */
+static int gSUMSlibHeld = 0;
+static pthread_t gSUMSlibHolder;
 
 /* 0, unless a SIGPIPE signal was CAUGHT. */
 static volatile sig_atomic_t gGotPipe = 0;
@@ -48,10 +59,384 @@ static volatile sig_atomic_t gGotPipe = 0;
  * that session.
  */
 HContainer_t *gSgPending = NULL;
+static pthread_mutex_t gSgPendingMtx = PTHREAD_MUTEX_INITIALIZER; /* SUMS workers share gSgPending */
+
+/* Read-only db connections (see DRMS_Env_t::db_nreadconns). Server threads run client queries
+ * (DRMS_TXTQUERY, DRMS_BINQUERY, ...) on one of these instead of waiting for db_handle, as long as the
+ * result is the same as it would be on db_handle:
+ *   - if the server transaction is REPEATABLE READ (drms_server's default), each read connection runs a
+ *     read-only transaction that imports the server transaction's snapshot (pg_export_snapshot());
+ *   - otherwise (READ COMMITTED, noshare mode), each query runs in its own read-only transaction.
+ * An exported snapshot does not include the exporting transaction's own changes, so once a client has sent
+ * anything that might modify the database (or a query fails on a read connection and is re-run on
+ * db_handle), the pool is marked dirty, and all queries go to db_handle until the server transaction
+ * ends. */
+typedef struct DRMS_ReadConn_struct
+{
+    DB_Handle_t *dbh;
+    struct DRMS_ReadPool_struct *pool;
+    unsigned int generation; /* the server transaction whose snapshot dbh's transaction has imported */
+    int intrans;             /* 1 if dbh is in a transaction */
+    struct DRMS_ReadConn_struct *next; /* free list */
+} DRMS_ReadConn_t;
+
+typedef struct DRMS_ReadPool_struct
+{
+    pthread_mutex_t lock;
+    DRMS_ReadConn_t *conns;
+    int nconns;
+    DRMS_ReadConn_t *freeconns;
+    int nborrowed;
+    int closed;                /* the pool is being destroyed; the last borrower frees it */
+    int sharesnapshot;         /* 1 if the connections import the server transaction's snapshot */
+    unsigned int generation;   /* incremented every time the server starts a new transaction */
+    char snapshot[64];         /* the server transaction's exported snapshot ("" - not exported yet) */
+    int dirty;                 /* 1 if the server transaction might have modified the database */
+    long nqueries;             /* queries run on read connections */
+    long nfallbacks;           /* queries that failed on a read connection and were re-run on db_handle */
+} DRMS_ReadPool_t;
 
 /******************* Main server thread(s) functions ************************/
 static void drms_delete_temporaries(DRMS_Env_t *env);
 
+/* Opens a db connection to the server's database whose transactions are read-only. */
+static DB_Handle_t *ReadConnOpen(DRMS_Env_t *env)
+{
+    DB_Handle_t *dbh = NULL;
+    DB_Handle_t *srvdbh = env->session->db_handle;
+    char hostbuf[1024];
+
+    snprintf(hostbuf, sizeof(hostbuf), "%s:%s", srvdbh->dbhost, srvdbh->dbport);
+
+    if ((dbh = db_connect(hostbuf, srvdbh->dbuser, env->dbpasswd, srvdbh->dbname, 1)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (db_isolation_level(dbh, DB_TRANS_READONLY))
+    {
+        db_disconnect(&dbh);
+        return NULL;
+    }
+
+    if (env->dbtimeout != INT_MIN)
+    {
+        if (db_settimeout(dbh, env->dbtimeout))
+        {
+            fprintf(stderr, "Failed to modify db-statement time-out to %d.\n", env->dbtimeout);
+        }
+    }
+
+    if (env->dbutf8clientencoding != 0)
+    {
+        if (db_setutf8clientencoding(dbh))
+        {
+            fprintf(stderr, "failed to set UTF8 client encoding\n");
+        }
+    }
+
+    return dbh;
+}
+
+/* Opens env->db_nreadconns read connections. Failing to open some (or all) of them is not an error - clients
+ * queries just run on db_handle. */
+static void ReadPoolCreate(DRMS_Env_t *env)
+{
+    DRMS_ReadPool_t *pool = NULL;
+    int iconn;
+
+    if (env->db_nreadconns <= 0 || env->readpool)
+    {
+        return;
+    }
+
+    pool = calloc(1, sizeof(DRMS_ReadPool_t));
+    XASSERT(pool);
+    pool->conns = calloc(env->db_nreadconns, sizeof(DRMS_ReadConn_t));
+    XASSERT(pool->conns);
+    pthread_mutex_init(&pool->lock, NULL);
+
+    for (iconn = 0; iconn < env->db_nreadconns; iconn++)
+    {
+        if ((pool->conns[pool->nconns].dbh = ReadConnOpen(env)) == NULL)
+        {
+            fprintf(stderr, "Couldn't open read-only db connection %d.\n", iconn);
+            continue;
+        }
+
+        pool->conns[pool->nconns].pool = pool;
+        pool->conns[pool->nconns].next = pool->freeconns;
+        pool->freeconns = &pool->conns[pool->nconns];
+        pool->nconns++;
+    }
+
+    if (pool->nconns == 0)
+    {
+        fprintf(stderr, "No read-only db connections - all client queries will share the server's db connection.\n");
+        pthread_mutex_destroy(&pool->lock);
+        free(pool->conns);
+        free(pool);
+        return;
+    }
+
+    pool->sharesnapshot = (env->session->db_handle->isolation_level == DB_TRANS_REPEATABLEREAD || env->session->db_handle->isolation_level == DB_TRANS_SERIALIZABLE);
+    env->readpool = pool;
+
+    if (env->verbose)
+    {
+        printf("Opened %d read-only db connections.\n", pool->nconns);
+    }
+}
+
+static void ReadPoolFree(DRMS_ReadPool_t *pool)
+{
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->conns);
+    free(pool);
+}
+
+/* Closes the connections that are not in use; a server thread closes the one it is using when it is done. */
+static void ReadPoolDestroy(DRMS_Env_t *env)
+{
+    DRMS_ReadPool_t *pool = env->readpool;
+    DRMS_ReadConn_t *conn = NULL;
+    int inuse;
+
+    if (!pool)
+    {
+        return;
+    }
+
+    env->readpool = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->closed = 1;
+
+    while ((conn = pool->freeconns) != NULL)
+    {
+        pool->freeconns = conn->next;
+        db_disconnect(&conn->dbh);
+    }
+
+    if (env->verbose)
+    {
+        printf("Read-only db connections ran %ld queries (%ld re-run on the server's connection).\n", pool->nqueries, pool->nfallbacks);
+    }
+
+    inuse = pool->nborrowed;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (!inuse)
+    {
+        ReadPoolFree(pool);
+    }
+}
+
+/* Called whenever the server starts a new transaction on db_handle. */
+static void ReadPoolNewTransaction(DRMS_Env_t *env)
+{
+    DRMS_ReadPool_t *pool = env->readpool;
+
+    if (pool)
+    {
+        pthread_mutex_lock(&pool->lock);
+        pool->generation++;
+        *pool->snapshot = '\0';
+        pool->dirty = 0;
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/* Called before any client request that might modify the database. */
+static void ReadPoolSetDirty(DRMS_Env_t *env)
+{
+    DRMS_ReadPool_t *pool = env->readpool;
+
+    if (pool)
+    {
+        pthread_mutex_lock(&pool->lock);
+        pool->dirty = 1;
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/* Returns 1 if command might modify the database in the server transaction. */
+static int ReadPoolCommandWrites(int command)
+{
+    switch (command)
+    {
+        case DRMS_DISCONNECT:
+        case DRMS_ROLLBACK:
+        case DRMS_COMMIT:
+        case DRMS_TXTQUERY:
+        case DRMS_BINQUERY:
+        case DRMS_BINQUERY_ARRAY:
+        case DRMS_BINQUERY_NTUPLE:
+        case DRMS_SEQUENCE_GETNEXT: /* sequences are not transactional */
+        case DRMS_SEQUENCE_GETCURRENT:
+        case DRMS_SEQUENCE_GETLAST:
+        case DRMS_ALLOC_RECNUM:
+        case DRMS_GETUNIT:
+        case DRMS_GETUNITS:
+        case DRMS_GETSUDIR:
+        case DRMS_GETSUDIRS:
+        case DRMS_GETSUINFO:
+        case DRMS_GETTMPGUID:
+        case DRMS_SITEINFO:
+        case DRMS_LOCALSITEINFO:
+        case DRMS_GETDBUSER:
+          return 0;
+        default:
+          return 1;
+    }
+}
+
+/* Returns a read connection whose queries see what they would see on db_handle, or NULL if the
+ * query must run on db_handle (no pool, pool dirty, or all read connections in use). */
+static DRMS_ReadConn_t *ReadPoolBorrow(DRMS_Env_t *env)
+{
+    DRMS_ReadPool_t *pool = env->readpool;
+    DRMS_ReadConn_t *conn = NULL;
+    DB_Text_Result_t *qres = NULL;
+    unsigned int generation;
+    char snapshot[64];
+    char stmnt[128];
+
+    if (!pool)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (pool->closed || pool->dirty || !pool->freeconns)
+    {
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+    }
+
+    if (pool->sharesnapshot && *pool->snapshot == '\0')
+    {
+        /* first query of this server transaction to run on a read connection */
+        qres = db_query_txt(env->session->db_handle, "SELECT pg_export_snapshot()");
+
+        if (qres && qres->num_rows == 1 && qres->num_cols == 1)
+        {
+            snprintf(pool->snapshot, sizeof(pool->snapshot), "%s", qres->field[0][0]);
+        }
+
+        if (qres)
+        {
+            db_free_text_result(qres);
+        }
+
+        if (*pool->snapshot == '\0')
+        {
+            /* can't share the snapshot - don't try again until the next transaction */
+            pool->dirty = 1;
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+    }
+
+    conn = pool->freeconns;
+    pool->freeconns = conn->next;
+    pool->nborrowed++;
+    generation = pool->generation;
+    snprintf(snapshot, sizeof(snapshot), "%s", pool->snapshot);
+    pthread_mutex_unlock(&pool->lock);
+
+    if (pool->sharesnapshot && (!conn->intrans || conn->generation != generation))
+    {
+        if (conn->intrans)
+        {
+            db_rollback(conn->dbh);
+            conn->intrans = 0;
+        }
+
+        snprintf(stmnt, sizeof(stmnt), "SET TRANSACTION SNAPSHOT '%s'", snapshot);
+
+        if (db_dms(conn->dbh, NULL, "BEGIN ISOLATION LEVEL REPEATABLE READ") == 0)
+        {
+            conn->intrans = 1;
+
+            if (db_dms(conn->dbh, NULL, stmnt) == 0)
+            {
+                conn->generation = generation;
+            }
+            else
+            {
+                /* the server transaction ended after it exported the snapshot */
+                db_rollback(conn->dbh);
+                conn->intrans = 0;
+            }
+        }
+
+        if (!conn->intrans)
+        {
+            pthread_mutex_lock(&pool->lock);
+            conn->next = pool->freeconns;
+            pool->freeconns = conn;
+            pool->nborrowed--;
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+    }
+
+    return conn;
+}
+
+/* Returns conn (which may be NULL) to its pool. rofailed is 1 if a query failed on conn and
+ * was re-run on db_handle. */
+static void ReadPoolReturn(DRMS_ReadConn_t *conn, int rofailed)
+{
+    DRMS_ReadPool_t *pool = NULL;
+    int freepool = 0;
+
+    if (!conn)
+    {
+        return;
+    }
+
+    pool = conn->pool;
+
+    if (rofailed && conn->intrans)
+    {
+        /* the error aborted conn's transaction */
+        db_rollback(conn->dbh);
+        conn->intrans = 0;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->nqueries++;
+    pool->nborrowed--;
+
+    if (rofailed)
+    {
+        /* the query may have modified the database on db_handle */
+        pool->nfallbacks++;
+        pool->dirty = 1;
+    }
+
+    if (pool->closed)
+    {
+        db_disconnect(&conn->dbh);
+        freepool = (pool->nborrowed == 0);
+    }
+    else
+    {
+        conn->next = pool->freeconns;
+        pool->freeconns = conn;
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    if (freepool)
+    {
+        ReadPoolFree(pool);
+    }
+}
+
 /* Check if the current SUMS request is a request destined for the MT server, or for the RPC server. */
 static int IsMTSums(int opcode)
 {
@@ -110,6 +495,53 @@ static int IsMTSums(int opcode)
     return isMTSums;
 }
 
+/* 1 if this thread holds the SUMS library for a whole SUM_get() */
+static int SumsLibHolding(void)
+{
+    int holding;
+
+    pthread_mutex_lock(&gSUMSlibHoldMtx);
+    holding = gSUMSlibHeld && pthread_equal(gSUMSlibHolder, pthread_self());
+    pthread_mutex_unlock(&gSUMSlibHoldMtx);
+
+    return holding;
+}
+
+/* lock the SUMS library for one call (a no-op if this thread is holding it) */
+static void SumsLibLock(void)
+{
+    if (!SumsLibHolding())
+    {
+        pthread_mutex_lock(&gSUMSlibMtx);
+    }
+}
+
+static void SumsLibUnlock(void)
+{
+    if (!SumsLibHolding())
+    {
+        pthread_mutex_unlock(&gSUMSlibMtx);
+    }
+}
+
+/* lock the SUMS library until SumsLibRelease() - the SUMS calls made in between do not lock it again */
+static void SumsLibHold(void)
+{
+    pthread_mutex_lock(&gSUMSlibMtx);
+    pthread_mutex_lock(&gSUMSlibHoldMtx);
+    gSUMSlibHeld = 1;
+    gSUMSlibHolder = pthread_self();
+    pthread_mutex_unlock(&gSUMSlibHoldMtx);
+}
+
+static void SumsLibRelease(void)
+{
+    pthread_mutex_lock(&gSUMSlibHoldMtx);
+    gSUMSlibHeld = 0;
+    pthread_mutex_unlock(&gSUMSlibHoldMtx);
+    pthread_mutex_unlock(&gSUMSlibMtx);
+}
+
 /* returns the SUMS opcode, or -99 if a broken-pipe error occurred, or -1 if opcode is NA,
  * or -2 if SUMS cannot be called again because DRMS timed-out waiting for SUMS. */
 static int MakeSumsCall(DRMS_Env_t *env, int calltype, SUM_t **sumt, int (*history)(const char *fmt, ...), ...)
@@ -135,6 +567,7 @@ static int MakeSumsCall(DRMS_Env_t *env, int calltype, SUM_t **sumt, int (*histo
         return opcode;
     }
 
+    SumsLibLock();
     gGotPipe = 0;
 
     switch (calltype)
@@ -186,7 +619,10 @@ static int MakeSumsCall(DRMS_Env_t *env, int calltype, SUM_t **sumt, int (*histo
         case DRMS_SUMCLOSE:
         {
             opcode = SUM_close(*sumt, history);
-            nsumsconn = 0;
+            if (nsumsconn > 0)
+            {
+                --nsumsconn;
+            }
         }
             break;
         case DRMS_SUMDELETESERIES:
@@ -233,9 +669,34 @@ static int MakeSumsCall(DRMS_Env_t *env, int calltype, SUM_t **sumt, int (*histo
         opcode = kBrokenPipe;
     }
 
+    SumsLibUnlock();
+
     return opcode;
 }
 
+/* SUM_poll() and SUM_nop() are called outside of MakeSumsCall(). */
+static int SumsPoll(SUM_t *sum)
+{
+    int rv;
+
+    SumsLibLock();
+    rv = SUM_poll(sum);
+    SumsLibUnlock();
+
+    return rv;
+}
+
+static int SumsNop(SUM_t *sum, int (*history)(const char *fmt, ...))
+{
+    int rv;
+
+    SumsLibLock();
+    rv = SUM_nop(sum, history);
+    SumsLibUnlock();
+
+    return rv;
+}
+
 static DRMS_SumRequest_t *drms_process_sums_request(DRMS_Env_t  *env,
 						    SUM_t **sum,
 						    DRMS_SumRequest_t *request,
@@ -388,6 +849,9 @@ int drms_server_begin_transaction(DRMS_Env_t *env) {
             printf("set UTF8 database client encoding\n");
         }
     }
+
+    ReadPoolCreate(env);
+    ReadPoolNewTransaction(env);
   }
 
   /* It is possible that the user has previously called drms_server_end_transaction(),
@@ -415,6 +879,10 @@ int drms_server_begin_transaction(DRMS_Env_t *env) {
      XASSERT(env->clientlock);
      pthread_mutex_init(env->clientlock, NULL);
 
+     /* so that server threads can use the series and record caches without clientlock */
+     env->series_cache_lock = drms_cache_lock_create();
+     env->record_cache_lock = drms_cache_lock_create();
+
      drms_lock_server(env);
      if (drms_cache_init(env))
      {
@@ -909,12 +1377,11 @@ void drms_server_abort(DRMS_Env_t *env, int final)
   // Either a sums thread or a server thread might be waiting on
   // either sum_inbox or sum_outbox. Need to put something into the
   // respective queue to release the mutex and conditional variables
-  // in order to destroy them in drms_free_env().  Given the
-  // head-of-line blocking queue design, there is at most one
-  // outstanding request.
+  // in order to destroy them in drms_free_env(). The sums thread
+  // replies DRMS_ERROR_ABORT to every requestor whose request has
+  // not been sent to SUMS yet; the SUMS workers complete the requests
+  // they are serving.
   if (env->sum_thread) {
-    // a server thread might be waiting for reply on sum_outbox, tell
-    // it we are aborting.
 #if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_CONNECTION) && SUMS_USEMTSUMS_CONNECTION
      DRMS_MtSumsRequest_t *request = NULL;
      request = calloc(1, sizeof(DRMS_MtSumsRequest_t));
@@ -925,42 +1392,22 @@ void drms_server_abort(DRMS_Env_t *env, int final)
  #endif
      XASSERT(request);
 
-    if (env->sum_tag)
-    {
-      // has to be dynamically allocated since it's going to be freed.
-       /* This code simply tells the thread that made an unprocessed
-        * SUMS request that there was an error (abort is happening). */
-
-        /* This doesn't make sense. How do we know that the calling thread did
-         * not already get a reply? */
+    request->opcode = DRMS_SUMABORT;
 
-#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_CONNECTION) && SUMS_USEMTSUMS_CONNECTION
-      DRMS_MtSumsRequest_t *reply = NULL;
-      reply = calloc(1, sizeof(DRMS_MtSumsRequest_t));
-#else
-      DRMS_SumRequest_t *reply;
-      reply = malloc(sizeof(DRMS_SumRequest_t));
-#endif
-      XASSERT(reply);
-      reply->opcode = DRMS_ERROR_ABORT;
-      tqueueAdd(env->sum_outbox, env->sum_tag, (char *)reply);
-      request->opcode = DRMS_SUMABORT;
-    }
-    else
-    {
-      request->opcode = DRMS_SUMCLOSE;
-    }
     // a sums thread might be waiting for requests on sum_inbox, tell
     // it we are aborting.
     /* tell the sums thread to finish up. */
-    // looks like all requests are not dyanmically allocated.
     tqueueAdd(env->sum_inbox, (long)pthread_self(), (char *)request);
 
+    /* A SUMS worker may need drms_lock_server() to finish its request (see drms_server_commit()). */
+    drms_unlock_server(env);
     pthread_join(env->sum_thread, NULL);
+    drms_lock_server(env);
     env->sum_thread = 0;
   }
 
   db_disconnect(&env->session->stat_conn);
+  ReadPoolDestroy(env);
 
   /* Close DB connection and set abort flag... */
   db_disconnect(&env->session->db_handle);
@@ -1095,6 +1542,7 @@ void drms_server_commit(DRMS_Env_t *env, int final)
   }
 
   if (final) {
+    ReadPoolDestroy(env);
     db_disconnect(&env->session->db_handle);
   }
 
@@ -1135,6 +1583,8 @@ void *drms_server_thread(void *arg)
   int command,status,disconnect;
   DRMS_Env_t *env;
   DB_Handle_t *db_handle;
+  DRMS_ReadConn_t *readconn;
+  int rofailed;
 
   /* Detach child thread  - let it go about its merry way. */
   if (pthread_detach(pthread_self()))
@@ -1183,6 +1633,8 @@ void *drms_server_thread(void *arg)
       goto bail;
     }
 
+      ReadPoolNewTransaction(env);
+
       if (drms_session_setread(env) != DRMS_SUCCESS)
       {
           goto bail;
@@ -1199,6 +1651,12 @@ void *drms_server_thread(void *arg)
     /* Echo the command code to client to avoid delayed ACK problem. */
     Writeint(sockfd, command);
 
+    /* From now on, client queries must see this command's changes - run them on db_handle. */
+    if (ReadPoolCommandWrites(command))
+    {
+      ReadPoolSetDirty(env);
+    }
+
     switch(command)
     {
     case DRMS_DISCONNECT:
@@ -1220,6 +1678,7 @@ void *drms_server_thread(void *arg)
 
       if (!status)
       {
+          ReadPoolNewTransaction(env);
           status = drms_session_setread(env);
       }
 
@@ -1239,6 +1698,7 @@ void *drms_server_thread(void *arg)
 
       if (!status)
       {
+          ReadPoolNewTransaction(env);
           status = drms_session_setread(env);
       }
 
@@ -1248,12 +1708,18 @@ void *drms_server_thread(void *arg)
     case DRMS_TXTQUERY:
       if (env->verbose)
 	printf("thread %d: Executing DRMS_TXTQUERY.\n",tnum);
-      status = db_server_query_txt(sockfd, db_handle);
+      readconn = ReadPoolBorrow(env);
+      rofailed = 0;
+      status = db_server_query_txt_ro(sockfd, readconn ? readconn->dbh : NULL, db_handle, &rofailed);
+      ReadPoolReturn(readconn, rofailed);
       break;
     case DRMS_BINQUERY:
       if (env->verbose)
 	printf("thread %d: Executing DRMS_BINQUERY.\n",tnum);
-      status = db_server_query_bin(sockfd, db_handle);
+      readconn = ReadPoolBorrow(env);
+      rofailed = 0;
+      status = db_server_query_bin_ro(sockfd, readconn ? readconn->dbh : NULL, db_handle, &rofailed);
+      ReadPoolReturn(readconn, rofailed);
       break;
     case DRMS_DMS:
       if (env->verbose)
@@ -1298,7 +1764,10 @@ void *drms_server_thread(void *arg)
     case  DRMS_BINQUERY_ARRAY:
       if (env->verbose)
 	printf("thread %d: Executing DRMS_BINQUERY_ARRAY.\n",tnum);
-      status = db_server_query_bin_array(sockfd, db_handle);
+      readconn = ReadPoolBorrow(env);
+      rofailed = 0;
+      status = db_server_query_bin_array_ro(sockfd, readconn ? readconn->dbh : NULL, db_handle, &rofailed);
+      ReadPoolReturn(readconn, rofailed);
       break;
         case DRMS_BINQUERY_NTUPLE:
         {
@@ -1307,7 +1776,10 @@ void *drms_server_thread(void *arg)
                 printf("thread %d: Executing DRMS_BINQUERY_NTUPLE.\n", tnum);
             }
 
-            status = db_server_query_bin_ntuple(sockfd, db_handle);
+            readconn = ReadPoolBorrow(env);
+            rofailed = 0;
+            status = db_server_query_bin_ntuple_ro(sockfd, readconn ? readconn->dbh : NULL, db_handle, &rofailed);
+            ReadPoolReturn(readconn, rofailed);
             break;
         }
     case  DRMS_ALLOC_RECNUM:
@@ -1344,29 +1816,23 @@ void *drms_server_thread(void *arg)
       status = drms_server_getunits(env, sockfd);
       pthread_mutex_unlock(env->clientlock);
       break;
+    /* GETSUDIR and GETSUDIRS fill in the client's storage units, not ones in the storage-unit cache, and
+     * drms_su_getsudir(s)() synchronize with the SUMS thread themselves. */
     case DRMS_GETSUDIR:
       if (env->verbose)
 	printf("thread %d: Executing DRMS_GETSUDIR.\n",tnum);
-      /* XXX Don't lock environment at this level - too high; but use a new lock
-       * to synchronize server threads */
-      pthread_mutex_lock(env->clientlock);
       status = drms_server_getsudir(env, sockfd);
-      pthread_mutex_unlock(env->clientlock);
       break;
     case DRMS_GETSUDIRS:
       if (env->verbose)
         printf("thread %d: Executing DRMS_GETSUDIRS.\n",tnum);
-      /* XXX - Need a new lock to synchronize among server threads (possibly) */
-      pthread_mutex_lock(env->clientlock);
       status = drms_server_getsudirs(env, sockfd);
-      pthread_mutex_unlock(env->clientlock);
       break;
+    /* NEWSERIES changes only series_cache, which has its own lock. */
     case DRMS_NEWSERIES:
       if (env->verbose)
 	printf("thread %d: Executing DRMS_NEWSERIES.\n",tnum);
-      pthread_mutex_lock(env->clientlock);
       status = drms_server_newseries(env, sockfd);
-      pthread_mutex_unlock(env->clientlock);
       break;
     case DRMS_DROPSERIES:
       if (env->verbose)
@@ -1375,35 +1841,26 @@ void *drms_server_thread(void *arg)
       status = drms_server_dropseries(env, sockfd);
       pthread_mutex_unlock(env->clientlock);
       break;
+    /* These do not use the DRMS library's caches, so they do not need clientlock. db_handle
+     * serializes the site-info queries, and drms_su_getinfo() and drms_su_setretention() synchronize
+     * with the SUMS thread themselves. */
     case DRMS_GETTMPGUID:
-      pthread_mutex_lock(env->clientlock);
       drms_server_gettmpguid(&sockfd);
-      pthread_mutex_unlock(env->clientlock);
       break;
     case DRMS_SITEINFO:
-      pthread_mutex_lock(env->clientlock);
       drmssite_server_siteinfo(sockfd, db_handle);
-      pthread_mutex_unlock(env->clientlock);
       break;
     case DRMS_LOCALSITEINFO:
-      pthread_mutex_lock(env->clientlock);
       drmssite_server_localsiteinfo(sockfd, db_handle);
-      pthread_mutex_unlock(env->clientlock);
       break;
     case DRMS_GETSUINFO:
-      pthread_mutex_lock(env->clientlock);
       drms_server_getsuinfo(env, sockfd);
-      pthread_mutex_unlock(env->clientlock);
       break;
     case DRMS_GETDBUSER:
-      pthread_mutex_lock(env->clientlock);
       drms_server_getdbuser(env, sockfd);
-      pthread_mutex_unlock(env->clientlock);
       break;
     case DRMS_SETRETENTION:
-        pthread_mutex_lock(env->clientlock);
         status = drms_server_setretention(env, sockfd);
-        pthread_mutex_unlock(env->clientlock);
         break;
     case DRMS_MAKESESSIONWRITABLE:
         pthread_mutex_lock(env->clientlock);
@@ -1487,6 +1944,8 @@ void *drms_server_thread(void *arg)
     }
     else
     {
+        ReadPoolNewTransaction(env);
+
         /* drms_session_setread() will lock the server, so unlock it here. */
         drms_unlock_server(env);
         if (drms_session_setread(env) != DRMS_SUCCESS)
@@ -2117,9 +2576,11 @@ int drms_server_newseries(DRMS_Env_t *env, int sockfd)
 
   /* even though we're typically caching series on-demand now, it is okay to cache this one now,
    * because in fact you probably will use this newly created series. */
+  drms_lock_cache(env->series_cache_lock, 1);
   template = (DRMS_Record_t *)hcon_allocslot_lower(&env->series_cache, series);
   memset(template,0,sizeof(DRMS_Record_t));
   template->init = 0;
+  drms_unlock_cache(env->series_cache_lock);
 
   free(series);
   return 0;
@@ -2162,7 +2623,7 @@ int drms_server_dropseries(DRMS_Env_t *env, int sockfd)
 
      /* Since we are now caching series on-demand, this series may not be in the
       * series_cache, but hcon_remove handles this fine. */
-     hcon_remove(&env->series_cache, series_lower);
+     drms_series_cache_remove(env, series_lower);
   }
 
   if (vec)
@@ -2181,13 +2642,17 @@ int drms_server_dropseries_su(DRMS_Env_t *env, const char *tn, DRMS_Array_t *arr
   int status = 0;
   int drmsstatus = DRMS_SUCCESS;
 
+  /* server threads that don't hold clientlock also start the SUMS thread, under the env lock */
+  drms_lock_server(env);
   if (!env->sum_thread) {
     if((status = pthread_create(&env->sum_thread, NULL, &drms_sums_thread,
 			      (void *) env))) {
       fprintf(stderr,"Thread creation failed: %d\n", status);
+      drms_unlock_server(env);
       return 1;
     }
   }
+  drms_unlock_server(env);
 
 #if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_DELETESUS) && SUMS_USEMTSUMS_DELETESUS
     char commentbuf[DRMS_MAXSERIESNAMELEN * 2];
@@ -2411,14 +2876,17 @@ int drms_trylock_server(DRMS_Env_t *env)
 long long drms_server_gettmpguid(int *sockfd)
 {
    static long long GUID = 1;
+   long long guid;
+
+   /* server threads call this without holding clientlock */
+   guid = __sync_fetch_and_add(&GUID, 1);
 
    if (sockfd)
    {
-      Writelonglong(*sockfd, GUID);
+      Writelonglong(*sockfd, guid);
    }
 
-   GUID++;
-   return GUID - 1;
+   return guid;
 }
 
 /* Loop though all open storage units and delete temporary records
@@ -2467,53 +2935,763 @@ static void SigPipeHndlr(int signum)
    gGotPipe = 1;
 }
 
-/* This is the thread in the DRMS server which is responsible for
-   forwarding requests to the SUM server. It receives requests from the
-   ordinary drms_server_thread(s) in env->sum_inbox (a FIFO), forwards them
-   to SUMS via the SUMS RPC protocol, and puts the reply into
-   env->sum_outbox (also a FIFO) for the drms_server_thread to pick it up.
-   Messages are tagged by the drms_server_thread(s) with the value
-   pthread_self() to make sure messages from different requesters are not
-   mixed. */
-void *drms_sums_thread(void *arg)
+/* SUMS worker pool.
+ *
+ * drms_sums_thread() receives SUMS requests from the drms_server_thread(s) (or from the module's
+ * threads, if the module is connected directly to the db) in env->sum_inbox (a FIFO), and queues each
+ * request in one of several lanes, by opcode. A pool of worker threads, each with its own SUMS connection,
+ * serves the lanes in priority order and puts the replies into env->sum_outbox for the requestors to pick
+ * up. Messages are tagged by the requestors with the value pthread_self() to make sure messages from
+ * different requestors are not mixed.
+ *
+ * - A SUM_info(), SUM_alloc(), or SUM_put() request is never queued behind a SUM_get() that has to
+ *   read from tape: SUM_get()s that may read from tape are served by the last worker only, one at a
+ *   time. With MT SUMS serving SUM_get(), the other workers keep calling SUMS while it waits for the
+ *   tape read. With RPC SUMS, they wait for the read to complete before calling SUMS (see
+ *   gSUMSlibMtx), but requests still reach SUMS by priority rather than in arrival order.
+ * - SUM_alloc(), SUM_alloc2(), SUM_put(), and SUM_delete_series() are served by worker 0 only, so
+ *   they all share one SUMS session, as they did when a single thread served all requests. Worker 0
+ *   does not serve tape reads, unless it is the only worker.
+ * - The requests of one requestor are served in the order they were made.
+ * - Workers connect to SUMS when they serve their first request. */
+#define kSUMSNWorkersDef  4
+
+typedef enum
 {
-  int status;
-  DRMS_Env_t *env;
-  SUM_t *sum=NULL;
+   kSUMSLaneWrite = 0,  /* SUM_alloc(), SUM_alloc2(), SUM_put(), SUM_delete_series() */
+   kSUMSLaneInfo,       /* SUM_infoArray() */
+   kSUMSLaneGet,        /* SUM_get() of SUs that are not to be retrieved from tape */
+   kSUMSLaneRetrieve,   /* SUM_get() that may retrieve SUs from tape */
+   kSUMSLaneN
+} SUMSLane_t;
 
-  /* ACK! Horrible hack to get around SUMS limiting the #SUs per request. For API functions that
-   * use the MT SUMS daemon, we need to use the DRMS_MtSumsRequest_t request/reply struct, not
-   * the DRMS_SumRequest_t struct. */
-  void *request = NULL;
-  void *reply = NULL;
+static const char *kSUMSLaneNames[kSUMSLaneN] = { "write", "info", "get", "retrieve" };
 
-  long stop, empty;
-  int connected = 0;
-  char *ptmp;
-  TIMER_t *timer = NULL;
-  int tryagain;
-  int sleepiness;
-  int tryconnect;
-  int shuttingdown;
-  sem_t *sdsem = drms_server_getsdsem();
-  int sumscallret;
-  int rv;
-  int mtRequest = 0;
-  int opcode;
-  int dontwait;
-  int reqcnt;
+#define kSUMSNOpcodes (DRMS_SUMOPEN + 1)
 
+typedef struct SUMSItem_struct
+{
+   long tag;            /* the requestor */
+   void *request;
+   int opcode;
+   int mtRequest;
+   int dontwait;
+   int reqcnt;
+   SUMSLane_t lane;
+   unsigned long long seq;
+   double queued;       /* time the request was queued */
+   struct SUMSItem_struct *next;
+} SUMSItem_t;
 
-  env = (DRMS_Env_t *) arg;
+struct SUMSPool_struct;
 
-  /* Block signals. */
-  /* There are several signals that must be handled by the signal thread only, and one
-   * signal, SIGUSR2, that must be handled by the main thread only.
-   */
-  if( (status = pthread_sigmask(SIG_BLOCK, &env->signal_mask, NULL)))
-  {
-    fprintf(stderr,"pthread_sigmask call failed with status = %d\n", status);
-    Exit(1);
+typedef struct SUMSWorker_struct
+{
+   struct SUMSPool_struct *pool;
+   int iworker;
+   pthread_t thread;
+   long tag;            /* the requestor whose request is being served (0 - idle) */
+} SUMSWorker_t;
+
+typedef struct SUMSPool_struct
+{
+   DRMS_Env_t *env;
+   pthread_mutex_t mutex;
+   pthread_cond_t cond;       /* signalled when a request is queued or served, and when the pool stops */
+   SUMSItem_t *head[kSUMSLaneN];
+   SUMSItem_t *tail[kSUMSLaneN];
+   int nworkers;
+   SUMSWorker_t *workers;
+   unsigned long long seq;
+   int stop;                  /* serve the queued requests, then exit */
+   int noconnect;             /* a worker failed to connect to SUMS - reply DRMS_ERROR_SUMOPEN to all requests */
+
+   /* metrics */
+   int depth[kSUMSLaneN];     /* number of requests queued */
+   int maxdepth[kSUMSLaneN];
+   long long nserved[kSUMSNOpcodes];
+   double waittime[kSUMSNOpcodes];   /* total seconds requests spent queued */
+   double servetime[kSUMSNOpcodes];  /* total seconds workers spent serving requests */
+   double maxlatency[kSUMSNOpcodes]; /* longest time from queueing to reply */
+} SUMSPool_t;
+
+static double SUMSNow(void)
+{
+   struct timeval tv;
+
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1.0e6;
+}
+
+static SUMSLane_t SUMSLaneOf(void *request, int opcode, int mtRequest)
+{
+   int mode;
+
+   switch (opcode)
+   {
+      case DRMS_SUMINFO:
+        return kSUMSLaneInfo;
+      case DRMS_SUMGET:
+#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
+        if (mtRequest)
+        {
+           mode = ((DRMS_MtSumsRequest_t *)request)->mode;
+        }
+        else
+        {
+#endif
+           mode = ((DRMS_SumRequest_t *)request)->mode;
+#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
+        }
+#endif
+        return (mode & RETRIEVE) ? kSUMSLaneRetrieve : kSUMSLaneGet;
+      default:
+        return kSUMSLaneWrite;
+   }
+}
+
+static int SUMSWorkerServesLane(SUMSPool_t *pool, int iworker, SUMSLane_t lane)
+{
+   if (lane == kSUMSLaneWrite)
+   {
+      return iworker == 0;
+   }
+   else if (lane == kSUMSLaneRetrieve)
+   {
+      return iworker == pool->nworkers - 1;
+   }
+
+   return 1;
+}
+
+/* Must be called with pool->mutex held. Returns the highest-priority request that worker iworker can serve
+ * now, and removes it from its lane. A request cannot be served while its requestor has an earlier request
+ * that is queued or being served. */
+static SUMSItem_t *SUMSPoolTake(SUMSPool_t *pool, int iworker)
+{
+   SUMSItem_t *item = NULL;
+   SUMSItem_t *prev = NULL;
+   SUMSItem_t *other = NULL;
+   int ilane;
+   int jlane;
+   int iw;
+   int blocked;
+
+   for (ilane = 0; ilane < kSUMSLaneN; ilane++)
+   {
+      if (!SUMSWorkerServesLane(pool, iworker, (SUMSLane_t)ilane))
+      {
+         continue;
+      }
+
+      for (prev = NULL, item = pool->head[ilane]; item; prev = item, item = item->next)
+      {
+         blocked = 0;
+
+         for (iw = 0; !blocked && iw < pool->nworkers; iw++)
+         {
+            blocked = (pool->workers[iw].tag == item->tag);
+         }
+
+         for (jlane = 0; !blocked && jlane < kSUMSLaneN; jlane++)
+         {
+            for (other = pool->head[jlane]; !blocked && other && other->seq < item->seq; other = other->next)
+            {
+               blocked = (other->tag == item->tag);
+            }
+         }
+
+         if (!blocked)
+         {
+            if (prev)
+            {
+               prev->next = item->next;
+            }
+            else
+            {
+               pool->head[ilane] = item->next;
+            }
+
+            if (pool->tail[ilane] == item)
+            {
+               pool->tail[ilane] = prev;
+            }
+
+            item->next = NULL;
+            pool->depth[ilane]--;
+            return item;
+         }
+      }
+   }
+
+   return NULL;
+}
+
+static int SUMSPoolEmpty(SUMSPool_t *pool)
+{
+   int ilane;
+
+   for (ilane = 0; ilane < kSUMSLaneN; ilane++)
+   {
+      if (pool->head[ilane])
+      {
+         return 0;
+      }
+   }
+
+   return 1;
+}
+
+/* Note: request is only shallow-freed. The is the requestor's responsiblity
+ * to free any memory allocated for the dsname, comment, and sudir fields. */
+static void SUMSFreeRequest(void *request, int mtRequest)
+{
+#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
+    if (mtRequest)
+    {
+        if (((DRMS_MtSumsRequest_t *)request)->sunum)
+        {
+            /* If the request is handled by the multi-threaded SUMS, then DRMS allocated the list of SUNUMs (for SUM_info(), SUM_get(),
+             * SUM_put(), etc.). Free those here. */
+            free(((DRMS_MtSumsRequest_t *)request)->sunum);
+            ((DRMS_MtSumsRequest_t *)request)->sunum = NULL;
+        }
+
+        if (((DRMS_MtSumsRequest_t *)request)->sudir)
+        {
+            /* If the request is handled by the multi-threaded SUMS, then DRMS allocated the list of dirs (for SUM_put()). Free those here. */
+            free(((DRMS_MtSumsRequest_t *)request)->sudir);
+            ((DRMS_MtSumsRequest_t *)request)->sudir = NULL;
+        }
+    }
+#endif
+
+    free(request);
+}
+
+/* A reply that holds only a status (e.g., DRMS_ERROR_SUMOPEN). */
+static void *SUMSStatusReply(int mtRequest, int status)
+{
+    void *reply = NULL;
+
+#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
+    if (mtRequest)
+    {
+        reply = calloc(1, sizeof(DRMS_MtSumsRequest_t));
+        XASSERT(reply);
+        ((DRMS_MtSumsRequest_t *)reply)->opcode = status;
+    }
+    else
+    {
+#endif
+        reply = calloc(1, sizeof(DRMS_SumRequest_t));
+        XASSERT(reply);
+        ((DRMS_SumRequest_t *)reply)->opcode = status;
+#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
+    }
+#endif
+
+    return reply;
+}
+
+/* Put the reply in the outbox, or free it if the requestor does not want it. */
+static void SUMSDeliverReply(DRMS_Env_t *env, int iworker, SUMSItem_t *item, void *reply)
+{
+    if (env->verbose)
+    {
+        /* The opcode is accessible from either type of request struct. */
+        printf("sums worker %d: A reply was returned from SUMS, return code %d.\n", iworker, ((DRMS_SumRequest_t *)reply)->opcode);
+    }
+
+    if (!item->dontwait)
+    {
+        /* Client is waiting for reply. */
+        if (env->verbose)
+        {
+            printf("sums worker %d: Requestor wants the reply, queueing reply.\n", iworker);
+        }
+
+        tqueueAdd(env->sum_outbox, item->tag, (char *)reply);
+    }
+    else
+    {
+        if (env->verbose)
+        {
+            printf("sums worker %d: Requestor does not want the reply.\n", iworker);
+        }
+
+        /* If the calling thread waits for the reply, then it is the caller's responsibility
+         * to clean up. Otherwise, clean up here. */
+#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
+        if (item->mtRequest)
+        {
+            if (((DRMS_MtSumsRequest_t *)reply)->sunum)
+            {
+                free(((DRMS_MtSumsRequest_t *)reply)->sunum);
+                ((DRMS_MtSumsRequest_t *)reply)->sunum = NULL;
+            }
+
+            if (((DRMS_MtSumsRequest_t *)reply)->sudir)
+            {
+                for (int i = 0; i < item->reqcnt; i++)
+                {
+                    if ((((DRMS_MtSumsRequest_t *)reply)->sudir)[i])
+                    {
+                        free((((DRMS_MtSumsRequest_t *)reply)->sudir)[i]);
+                    }
+                }
+
+                free(((DRMS_MtSumsRequest_t *)reply)->sudir);
+                ((DRMS_MtSumsRequest_t *)reply)->sudir = NULL;
+            }
+        }
+        else
+        {
+#endif
+            for (int i = 0; i < item->reqcnt; i++)
+            {
+                if ((((DRMS_SumRequest_t *)reply)->sudir)[i])
+                {
+                    free((((DRMS_SumRequest_t *)reply)->sudir)[i]);
+                }
+            }
+#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
+        }
+#endif
+
+        free(reply);
+    }
+}
+
+/* Connect worker iworker to SUMS. Returns 1 if connected. If SUMS cannot be reached (and the module was not
+ * told to keep trying), all SUMS requests fail from now on, and the module is told to terminate. */
+static int SUMSConnect(SUMSPool_t *pool, int iworker, SUM_t **sum)
+{
+    DRMS_Env_t *env = pool->env;
+    TIMER_t *timer = NULL;
+    sem_t *sdsem = drms_server_getsdsem();
+    int firstSumOpen = 1;
+    int tryagain = 1;
+    int sleepiness = 1;
+    int shuttingdown = 0;
+    int sumscallret;
+    int giveup = 0;
+
+    while (tryagain && !*sum)
+    {
+        tryagain = 0;
+
+        /* SUMS not there - try to connect. */
+        if (env->verbose)
+        {
+            timer = CreateTimer();
+            printf("sums worker %d: No SUMS connection, calling SUM_open(). First SUM_open()?: %d.\n", iworker, firstSumOpen);
+        }
+
+        sumscallret = MakeSumsCall(env, DRMS_SUMOPEN, sum, printkerr, NULL, NULL);
+
+        firstSumOpen = 0;
+
+        if (sumscallret == kBrokenPipe || sumscallret == kSUMSDead || sumscallret == kTooManySumsOpen)
+        {
+            /* free a non-null sum? */
+            if (env->verbose)
+            {
+                printf("sums worker %d: SUM_open() failed. MakeSumsCall() returned %d.\n", iworker, sumscallret);
+            }
+
+            *sum = NULL;
+        }
+
+        if (env->verbose && timer)
+        {
+            fprintf(stdout, "to call SUM_open: %f seconds.\n", GetElapsedTime(timer));
+            DestroyTimer(&timer);
+        }
+
+        if (!*sum)
+        {
+            if (env->loopconn && sumscallret != kSUMSDead && sumscallret != kTooManySumsOpen)
+            {
+                fprintf(stderr, "Failed to connect to SUMS; trying again in %d seconds.\n", sleepiness);
+                tryagain = 1;
+                sleep(sleepiness);
+                GettingSleepier(&sleepiness);
+            }
+            else
+            {
+                /* Default behavior - don't try again, just send message to clients to terminate. */
+                giveup = 1;
+            }
+        }
+
+        /* check for user interrupting module. */
+        if (sdsem)
+        {
+            sem_wait(sdsem);
+            shuttingdown = (drms_server_getsd() != kSHUTDOWN_UNINITIATED);
+            sem_post(sdsem);
+        }
+
+        if (shuttingdown)
+        {
+            if (env->verbose)
+            {
+                printf("sums worker %d: Shutting down.\n", iworker);
+            }
+
+            tryagain = 0;
+        }
+    } /* loop SUM_open() */
+
+    if (giveup)
+    {
+        pthread_mutex_lock(&pool->mutex);
+        giveup = !pool->noconnect;
+        pool->noconnect = 1;
+        pthread_mutex_unlock(&pool->mutex);
+
+        if (giveup)
+        {
+            fprintf(stderr,"Failed to connect to SUMS; terminating.\n");
+            fflush(stdout);
+
+            sleep(1);
+            pthread_kill(env->signal_thread, SIGTERM); /* the signal thread will cause a DRMS_SUMCLOSE
+                                                        * SUMS request to be issued, which will terminate
+                                                        * the SUMS threads. */
+        }
+    }
+
+#ifdef DEBUG
+    if (*sum)
+    {
+        printf("sums worker %d connected to SUMS. SUMID = %llu\n", iworker, (*sum)->uid);
+        fflush(stdout);
+    }
+#endif
+
+    return (*sum != NULL);
+}
+
+static void *SUMSWorker(void *arg)
+{
+    SUMSWorker_t *worker = (SUMSWorker_t *)arg;
+    SUMSPool_t *pool = worker->pool;
+    DRMS_Env_t *env = pool->env;
+    SUMSItem_t *item = NULL;
+    SUM_t *sum = NULL;
+    void *reply = NULL;
+    int connected = 0;
+    int noconnect = 0;
+    int sumscallret;
+    double started;
+    double finished;
+
+    while (1)
+    {
+        pthread_mutex_lock(&pool->mutex);
+
+        while ((item = SUMSPoolTake(pool, worker->iworker)) == NULL && !(pool->stop && SUMSPoolEmpty(pool)))
+        {
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+        }
+
+        if (item)
+        {
+            worker->tag = item->tag;
+        }
+
+        noconnect = pool->noconnect;
+        pthread_mutex_unlock(&pool->mutex);
+
+        if (!item)
+        {
+            /* the pool is stopping, and there are no more requests */
+            break;
+        }
+
+        started = SUMSNow();
+
+        if (env->verbose)
+        {
+            printf("sums worker %d: Got request %d (%s lane) from thread %ld.\n", worker->iworker, item->opcode, kSUMSLaneNames[item->lane], item->tag);
+        }
+
+        if (!connected && !noconnect)
+        {
+            connected = SUMSConnect(pool, worker->iworker, &sum);
+        }
+
+        if (connected)
+        {
+            /* Send the request to SUMS. sum_svc could die while processing is happening.
+             * If that is the case drms_process_sums_request() will attempt to re-open
+             * sum_svc with a SUM_open() call. If that happens, drms_process_sums_request()
+             * will return the new SUM_t. */
+            reply = drms_process_sums_request(env, &sum, (DRMS_SumRequest_t *)item->request, item->opcode, item->mtRequest);
+
+            if (!reply)
+            {
+                fprintf(stderr, "sums worker %d: drms_process_sums_request() returned NULL. Thread making the request (ID): %ld. Request (ID): %d\n", worker->iworker, item->tag, item->opcode);
+            }
+
+            XASSERT(reply); /* If there is no reply, then the calling thread will hang (since it will
+                             * be blocked on env->sum_outbox). */
+        }
+        else
+        {
+            if (env->verbose)
+            {
+                printf("sums worker %d: Not connected to SUMS. Replying with a DRMS_ERROR_SUMOPEN code.\n", worker->iworker);
+            }
+
+            /* Send a reply to the client saying that SUM_open() failed. */
+            reply = SUMSStatusReply(item->mtRequest, DRMS_ERROR_SUMOPEN);
+        }
+
+        if (reply)
+        {
+            SUMSDeliverReply(env, worker->iworker, item, reply);
+            reply = NULL;
+        }
+
+        SUMSFreeRequest(item->request, item->mtRequest);
+        item->request = NULL;
+        finished = SUMSNow();
+
+        pthread_mutex_lock(&pool->mutex);
+        worker->tag = 0; /* done processing */
+
+        if (item->opcode >= 0 && item->opcode < kSUMSNOpcodes)
+        {
+            pool->nserved[item->opcode]++;
+            pool->waittime[item->opcode] += started - item->queued;
+            pool->servetime[item->opcode] += finished - started;
+
+            if (finished - item->queued > pool->maxlatency[item->opcode])
+            {
+                pool->maxlatency[item->opcode] = finished - item->queued;
+            }
+        }
+
+        /* the requestor's next request can now be served */
+        pthread_cond_broadcast(&pool->cond);
+        pthread_mutex_unlock(&pool->mutex);
+
+        free(item);
+        item = NULL;
+    }
+
+    if (connected && sum)
+    {
+        /* Disconnect from SUMS. */
+        sumscallret = MakeSumsCall(env, DRMS_SUMCLOSE, &sum, printkerr);
+        if (sumscallret == kBrokenPipe)
+        {
+            fprintf(stderr, "Unable to call SUM_close(); broken pipe; not retrying.\n");
+        }
+    }
+
+    return NULL;
+}
+
+static void SUMSPoolQueue(SUMSPool_t *pool, long tag, void *request, int opcode, int mtRequest, int dontwait, int reqcnt)
+{
+    SUMSItem_t *item = NULL;
+
+    item = calloc(1, sizeof(SUMSItem_t));
+    XASSERT(item);
+    item->tag = tag;
+    item->request = request;
+    item->opcode = opcode;
+    item->mtRequest = mtRequest;
+    item->dontwait = dontwait;
+    item->reqcnt = reqcnt;
+    item->lane = SUMSLaneOf(request, opcode, mtRequest);
+    item->queued = SUMSNow();
+
+    pthread_mutex_lock(&pool->mutex);
+    item->seq = pool->seq++;
+
+    if (pool->tail[item->lane])
+    {
+        pool->tail[item->lane]->next = item;
+    }
+    else
+    {
+        pool->head[item->lane] = item;
+    }
+
+    pool->tail[item->lane] = item;
+
+    if (++pool->depth[item->lane] > pool->maxdepth[item->lane])
+    {
+        pool->maxdepth[item->lane] = pool->depth[item->lane];
+    }
+
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void SUMSPoolPrintStats(SUMSPool_t *pool, FILE *fp)
+{
+    static const char *opnames[kSUMSNOpcodes] = { "SUM_alloc", "SUM_get", "SUM_put", "SUM_close", "SUM_delete_series", "SUM_alloc2", "SUM_export", "SUM_info", "SUM_open" };
+    int iop;
+    int ilane;
+
+    fprintf(fp, "SUMS workers: %d\n", pool->nworkers);
+
+    for (ilane = 0; ilane < kSUMSLaneN; ilane++)
+    {
+        fprintf(fp, "  %-8s lane: max queue depth %d\n", kSUMSLaneNames[ilane], pool->maxdepth[ilane]);
+    }
+
+    for (iop = 0; iop < kSUMSNOpcodes; iop++)
+    {
+        if (pool->nserved[iop] > 0)
+        {
+            fprintf(fp, "  %-17s %lld requests, mean wait %.3f s, mean service %.3f s, max latency %.3f s\n", opnames[iop], pool->nserved[iop], pool->waittime[iop] / pool->nserved[iop], pool->servetime[iop] / pool->nserved[iop], pool->maxlatency[iop]);
+        }
+    }
+}
+
+/* Start nworkers SUMS workers. */
+static SUMSPool_t *SUMSPoolStart(DRMS_Env_t *env, int nworkers)
+{
+    SUMSPool_t *pool = NULL;
+    int iworker;
+
+    pool = calloc(1, sizeof(SUMSPool_t));
+    XASSERT(pool);
+    pool->env = env;
+    pool->workers = calloc(nworkers, sizeof(SUMSWorker_t));
+    XASSERT(pool->workers);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+
+    for (iworker = 0; iworker < nworkers; iworker++)
+    {
+        pool->workers[iworker].pool = pool;
+        pool->workers[iworker].iworker = iworker;
+
+        if (pthread_create(&pool->workers[iworker].thread, NULL, SUMSWorker, &pool->workers[iworker]))
+        {
+            fprintf(stderr, "Unable to start SUMS worker %d.\n", iworker);
+            break;
+        }
+
+        /* a worker that has started takes part in SUMSPoolTake() */
+        pthread_mutex_lock(&pool->mutex);
+        pool->nworkers++;
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    /* worker 0 serves the SUM_alloc()/SUM_put() requests */
+    XASSERT(pool->nworkers > 0);
+
+    return pool;
+}
+
+/* Stop the SUMS workers. If aborting is 0, the queued requests are served first; otherwise,
+ * their requestors receive DRMS_ERROR_ABORT replies. The requests being served are completed. */
+static void SUMSPoolStop(SUMSPool_t **ppool, int aborting)
+{
+    SUMSPool_t *pool = *ppool;
+    SUMSItem_t *unserved = NULL;
+    SUMSItem_t *item = NULL;
+    int ilane;
+    int iworker;
+
+    pthread_mutex_lock(&pool->mutex);
+
+    if (aborting)
+    {
+        for (ilane = 0; ilane < kSUMSLaneN; ilane++)
+        {
+            while ((item = pool->head[ilane]) != NULL)
+            {
+                pool->head[ilane] = item->next;
+                item->next = unserved;
+                unserved = item;
+            }
+
+            pool->tail[ilane] = NULL;
+            pool->depth[ilane] = 0;
+        }
+    }
+
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    while ((item = unserved) != NULL)
+    {
+        unserved = item->next;
+
+        if (!item->dontwait)
+        {
+            tqueueAdd(pool->env->sum_outbox, item->tag, (char *)SUMSStatusReply(item->mtRequest, DRMS_ERROR_ABORT));
+        }
+
+        SUMSFreeRequest(item->request, item->mtRequest);
+        free(item);
+    }
+
+    for (iworker = 0; iworker < pool->nworkers; iworker++)
+    {
+        pthread_join(pool->workers[iworker].thread, NULL);
+    }
+
+    if (pool->env->verbose)
+    {
+        SUMSPoolPrintStats(pool, stdout);
+    }
+
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->workers);
+    free(pool);
+    *ppool = NULL;
+}
+
+/* This is the thread in the DRMS server which is responsible for
+   forwarding requests to the SUM server. It receives requests from the
+   ordinary drms_server_thread(s) in env->sum_inbox (a FIFO), and dispatches
+   them to the SUMS workers (see SUMSPoolTake()), which forward them to SUMS
+   via the SUMS RPC protocol, and put the replies into env->sum_outbox (also
+   a FIFO) for the drms_server_thread to pick it up. Messages are tagged by
+   the drms_server_thread(s) with the value pthread_self() to make sure
+   messages from different requesters are not mixed. */
+void *drms_sums_thread(void *arg)
+{
+  int status;
+  DRMS_Env_t *env;
+  SUMSPool_t *pool = NULL;
+  void *request = NULL;
+  long tag;
+  long stop, empty;
+  char *ptmp;
+  int rv;
+  int mtRequest = 0;
+  int opcode;
+  int dontwait;
+  int reqcnt;
+  int nworkers;
+  int aborting = 0;
+
+
+  env = (DRMS_Env_t *) arg;
+
+  /* Block signals. */
+  /* There are several signals that must be handled by the signal thread only, and one
+   * signal, SIGUSR2, that must be handled by the main thread only. The SUMS workers
+   * inherit this mask.
+   */
+  if( (status = pthread_sigmask(SIG_BLOCK, &env->signal_mask, NULL)))
+  {
+    fprintf(stderr,"pthread_sigmask call failed with status = %d\n", status);
+    Exit(1);
   }
 
   /* Set up signal-handler - just to handle SIGPIPE, which could be sent when DRMS tries to
@@ -2540,15 +3718,23 @@ void *drms_sums_thread(void *arg)
      pthread_mutex_init(gSUMSbusyMtx, NULL);
   }
 
+  /* Each worker has its own SUMS connection. */
+  nworkers = env->sums_nworkers > 0 ? env->sums_nworkers : kSUMSNWorkersDef;
+  if (nworkers > MAXSUMOPEN)
+  {
+     nworkers = MAXSUMOPEN;
+  }
+
+  pool = SUMSPoolStart(env, nworkers);
+
   /* Main processing loop. */
   stop = 0;
   empty = 0;
-  tryconnect = 1;
 
   while ( !stop || !empty)
   {
-     /* if stop == 1, the the queue is corked, accepting no new items. So then we want
-      * to process any remaining items in the queue before breaking out of this while loop.
+     /* if stop == 1, the the queue is corked. So then we want to process any remaining
+      * items in the queue (including any added since the cork) before breaking out of this while loop.
       * If the queue has been corked (and stop == 1), then tqueueDelAny() will return
       * whether or not the queue is empty (unless there was an error in tqueueDelAny() -
       * this is a bug - this function shouldn't mix up "status" with "emptiness"). But
@@ -2562,11 +3748,9 @@ void *drms_sums_thread(void *arg)
       * ART - 10/21/2011 */
 
      /* Wait for the next SUMS request to arrive in the inbox. */
-     /* sum_tag is the thread id of the thread who made the original SUMS request */
-
-     /* Whoa! We're modifying env, but we haven't acquired the env lock. */
-    env->sum_tag = 0;
-    rv = tqueueDelAny(env->sum_inbox, &env->sum_tag,  &ptmp );
+     /* tag is the thread id of the thread who made the original SUMS request */
+    tag = 0;
+    rv = tqueueDelAny(env->sum_inbox, &tag,  &ptmp );
 
     if (stop == 1)
     {
@@ -2603,112 +3787,7 @@ void *drms_sums_thread(void *arg)
 
     if (env->verbose)
     {
-        printf("sums thread: Got request %d from thread %ld.\n", opcode, env->sum_tag);
-    }
-
-    if (tryconnect && !connected && opcode!=DRMS_SUMCLOSE)
-    {
-        int firstSumOpen = 1;
-
-        /* Connect to SUMS. */
-        tryagain = 1;
-        sleepiness = 1;
-
-        while (tryagain)
-        {
-            tryagain = 0;
-
-            if (!sum)
-            {
-                /* SUMS not there - try to connect. */
-                if (env->verbose)
-                {
-                    timer = CreateTimer();
-                }
-
-                if (env->verbose)
-                {
-                    printf("sums thread: No SUMS connection, calling SUM_open(). First SUM_open()?: %d.\n", firstSumOpen);
-                }
-
-                sumscallret = MakeSumsCall(env, DRMS_SUMOPEN, &sum, printkerr, NULL, NULL);
-
-                firstSumOpen = 0;
-
-                if (sumscallret == kBrokenPipe || sumscallret == kSUMSDead || sumscallret == kTooManySumsOpen)
-                {
-                    /* free a non-null sum? */
-                    if (env->verbose)
-                    {
-                        printf("sums thread: SUM_open() failed. MakeSumsCall() returned %d.\n", sumscallret);
-                    }
-
-                    sum = NULL;
-                }
-
-                if (env->verbose && timer)
-                {
-                    fprintf(stdout, "to call SUM_open: %f seconds.\n", GetElapsedTime(timer));
-                    DestroyTimer(&timer);
-                }
-
-                if (!sum)
-                {
-                    if (env->loopconn && sumscallret != kSUMSDead && sumscallret != kTooManySumsOpen)
-                    {
-                        fprintf(stderr, "Failed to connect to SUMS; trying again in %d seconds.\n", sleepiness);
-                        tryagain = 1;
-                        sleep(sleepiness);
-                        GettingSleepier(&sleepiness);
-                    }
-                    else
-                    {
-                        /* Default behavior - don't try again, just send message to clients to terminate, and let this
-                         * thread terminate as well. */
-                        stop = 1; /* exit main loop, after queue is empty (otherwise, keep going until queue is empty). */
-                        tryconnect = 0; /* don't try connecting to SUMS again. */
-                        empty = tqueueCork(env->sum_inbox); /* Don't allow new sums requests. */
-
-                        fprintf(stderr,"Failed to connect to SUMS; terminating.\n");
-                        fflush(stdout);
-
-                        sleep(1);
-                        pthread_kill(env->signal_thread, SIGTERM); /* the signal thread will cause a DRMS_SUMCLOSE
-                                                                    * SUMS request to be issued, which will terminate
-                                                                    * this thread. */
-                    }
-                }
-                else
-                {
-                    connected = 1;
-                }
-            }
-
-            /* check for user interrupting module. */
-            if (sdsem)
-            {
-                sem_wait(sdsem);
-                shuttingdown = (drms_server_getsd() != kSHUTDOWN_UNINITIATED);
-                sem_post(sdsem);
-            }
-
-            if (shuttingdown)
-            {
-                if (env->verbose)
-                {
-                    printf("sums thread: Shutting down.\n");
-                }
-
-                tryagain = 0;
-                tryconnect = 0;
-            }
-
-        } /* loop SUM_open() */
-
-#ifdef DEBUG
-        printf("drms_sums_thread connected to SUMS. SUMID = %llu\n",sum->uid);
-        fflush(stdout);
-#endif
+        printf("sums thread: Got request %d from thread %ld.\n", opcode, tag);
     }
 
     /* Check for special CLOSE or ABORT codes. */
@@ -2726,8 +3805,6 @@ void *drms_sums_thread(void *arg)
               printf("sums thread: stopping request loop.\n");
           }
 
-         /* if stop == 1, then the first SUM_open() failed, so we already corked the queue.
-          * Don't try to cork a corked queue. */
          stop = 1;
 
          /* tqueueCork() does, when no error happens, return whether or not the
@@ -2735,17 +3812,18 @@ void *drms_sums_thread(void *arg)
           * it should always return one thing, either whether or not the queue
           * is empty, or a status, not both.
           *
-          * There is actually no race condition with empty
-          * because a corked queue cannot accept new items. Even as tqueueDelAny()
-          * is called, there is no race condition, because no new items can
-          * be added to the queue. This is only true if stop == 1 (and the queue is
-          * corked).
+          * There is actually no race condition with empty: a corked queue still
+          * accepts new items (a producer may hold drms_lock_server(), which the
+          * workers need, so it must not block on the cork), but empty is set only
+          * by the tqueueDelAny() call that actually empties the queue. This is only
+          * true if stop == 1 (and the queue is corked).
           *
           * ART - 10/21/2011 */
-         empty = tqueueCork(env->sum_inbox); /* Do not accept any more requests, but keep
-                                                processing all the requests already in
-                                                the queue.*/
+         empty = tqueueCork(env->sum_inbox); /* Keep processing requests until the
+                                                queue is empty, then stop. */
       }
+
+      SUMSFreeRequest(request, mtRequest);
     }
     else if (opcode == DRMS_SUMABORT)
     {
@@ -2754,183 +3832,18 @@ void *drms_sums_thread(void *arg)
             printf("sums thread: DRMS_SUMABORT requested.\n");
         }
 
+      SUMSFreeRequest(request, mtRequest);
+      aborting = 1;
       break;
     }
-    else /* A regular request. */
-    {
-        int requestID = opcode;
-
-        if (env->verbose)
-        {
-            printf("sums thread: Processing a non-close/abort DRMS request. request (ID): %d\n", requestID);
-        }
-
-        if (connected)
-        {
-            if (env->verbose)
-            {
-                printf("sums thread: Already connected to SUMS.\n");
-            }
-
-            /* Send the request to SUMS. sum_svc could die while processing is happening.
-             * If that is the case drms_process_sums_request() will attempt to re-open
-             * sum_svc with a SUM_open() call. If that happens, drms_process_sums_request()
-             * will return the new SUM_t. */
-
-            reply = drms_process_sums_request(env, &sum, (DRMS_SumRequest_t *)request, opcode, mtRequest);
-            if (!reply)
-            {
-                fprintf(stderr, "sums thread: drms_process_sums_request() returned NULL. Thread making the request (ID): %ld. Request (ID): %d\n", env->sum_tag, requestID);
-            }
-
-            XASSERT(reply); /* If there is no reply, then the calling thread will hang (since it will
-                             * be blocked on env->sum_outbox). */
-        }
-        else
-        {
-            if (env->verbose)
-            {
-                printf("sums thread: Not connected to SUMS. Replying to main thread with a DRMS_ERROR_SUMOPEN code.\n");
-            }
-
-            /* Send a reply to the client saying that SUM_open() failed. */
-#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
-            if (mtRequest)
-            {
-                reply = calloc(1, sizeof(DRMS_MtSumsRequest_t));
-                XASSERT(reply);
-                ((DRMS_MtSumsRequest_t *)reply)->opcode = DRMS_ERROR_SUMOPEN;
-            }
-            else
-            {
-#endif
-                reply = malloc(sizeof(DRMS_SumRequest_t));
-                XASSERT(reply);
-                ((DRMS_SumRequest_t *)reply)->opcode = DRMS_ERROR_SUMOPEN;
-#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
-            }
-#endif
-        }
-
-        if (reply)
-        {
-            if (env->verbose)
-            {
-                /* The opcode is accessible from either type of request struct. */
-                printf("sums thread: A reply was returned from SUMS, return code %d.\n", ((DRMS_SumRequest_t *)reply)->opcode);
-            }
-
-            if (!dontwait)
-            {
-                /* Client is waiting for reply. */
-                if (env->verbose)
-                {
-                    printf("sums thread: Requestor wants the reply, queueing reply.\n");
-                }
-
-                /* Put the reply in the outbox. */
-                tqueueAdd(env->sum_outbox, env->sum_tag, (char *) reply);
-            }
-            else
-            {
-                if (env->verbose)
-                {
-                    printf("sums thread: Requestor does not want the reply.\n");
-                }
-
-                /* If the calling thread waits for the reply, then it is the caller's responsibility
-                 * to clean up. Otherwise, clean up here. */
- #if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
-                if (mtRequest)
-                {
-                    if (((DRMS_MtSumsRequest_t *)reply)->sunum)
-                    {
-                        free(((DRMS_MtSumsRequest_t *)reply)->sunum);
-                        ((DRMS_MtSumsRequest_t *)reply)->sunum = NULL;
-                    }
-
-                    for (int i = 0; i < reqcnt; i++)
-                    {
-                        if ((((DRMS_MtSumsRequest_t *)reply)->sudir)[i])
-                        {
-                            free((((DRMS_MtSumsRequest_t *)reply)->sudir)[i]);
-                        }
-                    }
-
-                    if (((DRMS_MtSumsRequest_t *)reply)->sudir)
-                    {
-                        free(((DRMS_MtSumsRequest_t *)reply)->sudir);
-                        ((DRMS_MtSumsRequest_t *)reply)->sudir = NULL;
-                    }
-                }
-                else
-                {
-#endif
-                    for (int i = 0; i < reqcnt; i++)
-                    {
-                        if ((((DRMS_SumRequest_t *)reply)->sudir)[i])
-                        {
-                            free((((DRMS_SumRequest_t *)reply)->sudir)[i]);
-                        }
-                    }
-#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
-                }
-#endif
-
-                free(reply);
-            }
-        }
-        else
-        {
-            if (env->verbose)
-            {
-                printf("sums thread: A reply was NOT returned from SUMS.\n");
-            }
-
-            if (!dontwait)
-            {
-                /* This shouldn't happen. The client is waiting for a reply, but no reply is available to return to the client. */
-                fprintf(stderr, "ERROR: The client has requested a reply from SUMS, but no such reply is available.\n");
-            }
-        }
-
-        env->sum_tag = 0; // done processing
-    }
-
-    /* Note: request is only shallow-freed. The is the requestor's responsiblity
-     * to free any memory allocated for the dsname, comment, and sudir fields. */
-#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
-    if (mtRequest)
+    else /* A regular request - the workers own it now. */
     {
-        if (((DRMS_MtSumsRequest_t *)request)->sunum)
-        {
-            /* If the request is handled by the multi-threaded SUMS, then DRMS allocated the list of SUNUMs (for SUM_info(), SUM_get(),
-             * SUM_put(), etc.). Free those here. */
-            free(((DRMS_MtSumsRequest_t *)request)->sunum);
-            ((DRMS_MtSumsRequest_t *)request)->sunum = NULL;
-        }
-
-        if (((DRMS_MtSumsRequest_t *)request)->sudir)
-        {
-            /* If the request is handled by the multi-threaded SUMS, then DRMS allocated the list of dirs (for SUM_put()). Free those here. */
-            free(((DRMS_MtSumsRequest_t *)request)->sudir);
-            ((DRMS_MtSumsRequest_t *)request)->sudir = NULL;
-        }
+        SUMSPoolQueue(pool, tag, request, opcode, mtRequest, dontwait, reqcnt);
     }
-#endif
-
-    free(request);
   } /* main loop on queue. */
 
-  if (connected && sum)
-  {
-    /* Disconnect from SUMS. */
-     sumscallret = MakeSumsCall(env, DRMS_SUMCLOSE, &sum, printkerr);
-     if (sumscallret == kBrokenPipe)
-     {
-        fprintf(stderr, "Unable to call SUM_close(); broken pipe; not retrying.\n");
-     }
-  }
+  /* Wait for the workers to finish (serving the queued requests, unless aborting) and disconnect from SUMS. */
+  SUMSPoolStop(&pool, aborting);
 
   if (gSUMSbusyMtx)
   {
@@ -2960,6 +3873,7 @@ static int IsSgPending(SUMID_t id, uint64_t *sunums, int nsunums)
     HContainer_t *idH = NULL;
 
     ans = 0;
+    pthread_mutex_lock(&gSgPendingMtx);
 
     if (gSgPending)
     {
@@ -2979,6 +3893,8 @@ static int IsSgPending(SUMID_t id, uint64_t *sunums, int nsunums)
         }
     }
 
+    pthread_mutex_unlock(&gSgPendingMtx);
+
     return ans;
 }
 
@@ -2991,6 +3907,7 @@ static int SetSgPending(SUMID_t id, uint64_t *sunums, int nsunums)
     HContainer_t *idH = NULL;
 
     err = 0;
+    pthread_mutex_lock(&gSgPendingMtx);
 
     /* First, see if the container of pending SUs exists. */
     snprintf(idstr, sizeof(idstr), "%u", id); /* id is a uint32_t */
@@ -3038,6 +3955,8 @@ static int SetSgPending(SUMID_t id, uint64_t *sunums, int nsunums)
         }
     }
 
+    pthread_mutex_unlock(&gSgPendingMtx);
+
     return err;
 }
 
@@ -3047,6 +3966,7 @@ static int UnsetSgPending(SUMID_t id)
     char idstr[32];
 
     err = 0;
+    pthread_mutex_lock(&gSgPendingMtx);
 
     if (gSgPending)
     {
@@ -3073,6 +3993,8 @@ static int UnsetSgPending(SUMID_t id)
         }
     }
 
+    pthread_mutex_unlock(&gSgPendingMtx);
+
     return err;
 }
 
@@ -3338,6 +4260,11 @@ static DRMS_SumRequest_t *drms_process_sums_request(DRMS_Env_t  *env,
     tryagain = 1;
     sleepiness = 1;
 
+#if !defined(SUMS_USEMTSUMS) || !SUMS_USEMTSUMS || !defined(SUMS_USEMTSUMS_GET) || !SUMS_USEMTSUMS_GET
+    /* RPC SUM_get() - no other SUMS call until its tape read (if any) completes */
+    SumsLibHold();
+#endif
+
     while (tryagain)
     {
         tryagain = 0;
@@ -3470,7 +4397,7 @@ static DRMS_SumRequest_t *drms_process_sums_request(DRMS_Env_t  *env,
                 if (gSUMSbusyMtx)
                 {
                     pthread_mutex_lock(gSUMSbusyMtx);
-                    gSUMSbusy = 1;
+                    gSUMSbusy++;
                     pthread_mutex_unlock(gSUMSbusyMtx);
                 }
 
@@ -3478,7 +4405,7 @@ static DRMS_SumRequest_t *drms_process_sums_request(DRMS_Env_t  *env,
                  * then SUM_poll() will never return anything but TIMEOUTMSG. */
                 if (nloop <= 0)
                 {
-                    pollrv = SUM_poll(sum);
+                    pollrv = SumsPoll(sum);
                     nloop = 10;
                 }
                 else
@@ -3486,7 +4413,7 @@ static DRMS_SumRequest_t *drms_process_sums_request(DRMS_Env_t  *env,
                     if (gSUMSbusyMtx)
                     {
                         pthread_mutex_lock(gSUMSbusyMtx);
-                        gSUMSbusy = 0;
+                        gSUMSbusy--;
                         pthread_mutex_unlock(gSUMSbusyMtx);
                     }
 
@@ -3504,7 +4431,7 @@ static DRMS_SumRequest_t *drms_process_sums_request(DRMS_Env_t  *env,
                 if (gSUMSbusyMtx)
                 {
                     pthread_mutex_lock(gSUMSbusyMtx);
-                    gSUMSbusy = 0;
+                    gSUMSbusy--;
                     pthread_mutex_unlock(gSUMSbusyMtx);
                 }
 
@@ -3534,7 +4461,7 @@ static DRMS_SumRequest_t *drms_process_sums_request(DRMS_Env_t  *env,
                      *
                      * If sum_svc has crashed or restarted, then SUM_open() needs to be called again. Otherwise, if
                      * tape_svc or driveX_svc has crashed or restarted, then SUM_get() needs to be called again. */
-                    sumnoop = SUM_nop(sum, printkerr);
+                    sumnoop = SumsNop(sum, printkerr);
 
                     if (env->verbose)
                     {
@@ -3608,7 +4535,7 @@ static DRMS_SumRequest_t *drms_process_sums_request(DRMS_Env_t  *env,
         }
         else if (replyOp != 0)
         {
-            sumnoop = SUM_nop(sum, printkerr);
+            sumnoop = SumsNop(sum, printkerr);
             sumscrashed = (sumnoop == 4 || replyOp == kBrokenPipe);
             if (sumnoop >= 4 || replyOp == kBrokenPipe)
             {
@@ -3635,6 +4562,10 @@ static DRMS_SumRequest_t *drms_process_sums_request(DRMS_Env_t  *env,
         }
     } /* tryagain (outer) loop */
 
+#if !defined(SUMS_USEMTSUMS) || !SUMS_USEMTSUMS || !defined(SUMS_USEMTSUMS_GET) || !SUMS_USEMTSUMS_GET
+    SumsLibRelease();
+#endif
+
 #if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_GET) && SUMS_USEMTSUMS_GET
         ((DRMS_MtSumsRequest_t *)reply)->opcode = replyOp;
 
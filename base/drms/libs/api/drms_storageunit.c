@@ -1457,6 +1457,131 @@ int drms_su_getsudir(DRMS_Env_t *env, DRMS_StorageUnit_t *su, int retrieve)
 #endif
 
 
+/* SUMS request pipelining (depth 2).
+ *
+ * A SUMS request holds at most maxNoSus SUs (MAXSUMREQCNT for RPC SUMS, MAX_MTSUMS_NSUS for MT SUMS), so
+ * drms_su_getsudirs(), drms_su_getinfo(), and drms_commit_all_units() split their SUs into batches, and make
+ * one SUMS request per batch - this does not change the number of requests or the SUMS protocol. The SUMS
+ * workers serve the requests of one requestor one at a time, in the order they were queued, and the replies
+ * arrive in the requestor's env->sum_outbox mailbox in that order (see drms_server.c). So these functions
+ * queue the request for the next batch before they wait for the reply to the current one - SUMS serves
+ * batch k + 1 while DRMS processes the reply to batch k, instead of DRMS and SUMS taking turns. At most
+ * kSUMSPipeDepth requests of a caller are outstanding. A caller that stops early (on an error) must take the
+ * outstanding replies with SumsPipeDrain() so they are not mistaken for the replies to its next SUMS request. */
+#ifndef DRMS_CLIENT
+#define kSUMSPipeDepth 2
+
+typedef struct DRMS_SumsPipe_struct
+{
+   DRMS_Env_t *env;
+   int unlock;                  /* release the env lock while waiting for a reply */
+   int nqueued;                 /* requests queued whose replies have not been taken */
+   int head;
+   void *data[kSUMSPipeDepth];  /* the caller's data for each queued request, in queue order */
+} DRMS_SumsPipe_t;
+
+static void SumsPipeInit(DRMS_SumsPipe_t *sp, DRMS_Env_t *env, int unlock)
+{
+   memset(sp, 0, sizeof(DRMS_SumsPipe_t));
+   sp->env = env;
+   sp->unlock = unlock;
+}
+
+static void SumsPipeSubmit(DRMS_SumsPipe_t *sp, void *request, void *data)
+{
+   XASSERT(sp->nqueued < kSUMSPipeDepth);
+   sp->data[(sp->head + sp->nqueued) % kSUMSPipeDepth] = data;
+   sp->nqueued++;
+
+   /* Submit request to sums server thread. */
+   tqueueAdd(sp->env->sum_inbox, (long)pthread_self(), (char *)request);
+}
+
+/* Wait for the reply to the oldest outstanding request. Returns the reply, and in *data the data submitted with the request. */
+static void *SumsPipeReply(DRMS_SumsPipe_t *sp, void **data)
+{
+   void *reply = NULL;
+
+   XASSERT(sp->nqueued > 0);
+
+   /* Could take a while for SUMS to respond (it it has to fetch from tape), so release env lock temporarily. */
+   if (sp->unlock)
+   {
+      drms_unlock_server(sp->env);
+   }
+
+   tqueueDel(sp->env->sum_outbox, (long)pthread_self(), (char **)&reply);
+
+   if (sp->unlock)
+   {
+      drms_lock_server(sp->env);
+   }
+
+   if (data)
+   {
+      *data = sp->data[sp->head];
+   }
+
+   sp->head = (sp->head + 1) % kSUMSPipeDepth;
+   sp->nqueued--;
+
+   return reply;
+}
+
+/* Free a SUM_get() or SUM_info() reply and the reqcnt sudirs (or SUM_info_ts) it holds. mtRequest - the reply
+ * is a DRMS_MtSumsRequest_t. */
+static void SUFreeSudirReply(void *reply, int mtRequest)
+{
+   char **sudir = NULL;
+   int reqcnt;
+
+#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
+   if (mtRequest)
+   {
+      sudir = ((DRMS_MtSumsRequest_t *)reply)->sudir;
+      reqcnt = ((DRMS_MtSumsRequest_t *)reply)->reqcnt;
+   }
+   else
+   {
+#endif
+      sudir = ((DRMS_SumRequest_t *)reply)->sudir;
+      reqcnt = ((DRMS_SumRequest_t *)reply)->reqcnt;
+#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
+   }
+#endif
+
+   if (sudir)
+   {
+      for (int i = 0; i < reqcnt; i++)
+      {
+         if (sudir[i])
+         {
+            free(sudir[i]);
+            sudir[i] = NULL;
+         }
+      }
+
+#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS
+      if (mtRequest)
+      {
+         free(sudir);
+      }
+#endif
+   }
+
+   free(reply);
+}
+
+/* Take and free the replies to the outstanding SUM_get() or SUM_info() requests. */
+static void SumsPipeDrain(DRMS_SumsPipe_t *sp, int mtRequest)
+{
+   while (sp->nqueued > 0)
+   {
+      SUFreeSudirReply(SumsPipeReply(sp, NULL), mtRequest);
+   }
+}
+#endif
+
 /* Get the actual storage unit directory from SUMS. */
 #ifndef DRMS_CLIENT
 int drms_su_getsudirs(DRMS_Env_t *env, int n, DRMS_StorageUnit_t **su, int retrieve, int dontwait)
@@ -1473,11 +1598,16 @@ int drms_su_getsudirs(DRMS_Env_t *env, int n, DRMS_StorageUnit_t **su, int retri
   int16_t maxRet;
   int16_t stagingRet = INT16_MIN;
   int maxNoSus = 0;
+  int mtRequest = 0;
+  DRMS_SumsPipe_t sumspipe;
+  int qstart = 0;
+  int qend = 0;
 
 #if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_GET) && SUMS_USEMTSUMS_GET
     DRMS_MtSumsRequest_t *request = NULL;
     DRMS_MtSumsRequest_t *reply = NULL;
     maxNoSus = MAX_MTSUMS_NSUS;
+    mtRequest = 1;
 #else
     DRMS_SumRequest_t *request = NULL;
     DRMS_SumRequest_t *reply = NULL;
@@ -1562,9 +1692,18 @@ int drms_su_getsudirs(DRMS_Env_t *env, int n, DRMS_StorageUnit_t **su, int retri
   {
      tryagain = 0;
 
-     /* Ask SUMS for ALL SUS in workingsus (in chunks of MAXSUMREQCNT/MAX_MTSUMS_NSUS) */
+     /* Ask SUMS for ALL SUS in workingsus (in chunks of MAXSUMREQCNT/MAX_MTSUMS_NSUS). The request for the
+      * next chunk is queued before the reply to the current one is processed (see DRMS_SumsPipe_t). */
+     SumsPipeInit(&sumspipe, env, 1);
+     qstart = start;
+
      while (start < workingn)
      {
+      /* Keep up to kSUMSPipeDepth chunks queued. */
+      while (qstart < workingn && sumspipe.nqueued < kSUMSPipeDepth)
+      {
+        qend = SUMIN(maxNoSus + qstart, workingn);
+
         /* create SUMS request (apparently, SUMS frees this request) */
 #if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_GET) && SUMS_USEMTSUMS_GET
         request = calloc(1, sizeof(DRMS_MtSumsRequest_t));
@@ -1577,9 +1716,9 @@ int drms_su_getsudirs(DRMS_Env_t *env, int n, DRMS_StorageUnit_t **su, int retri
 #endif
 
         request->opcode = DRMS_SUMGET;
-        request->reqcnt = end - start;
+        request->reqcnt = qend - qstart;
 
-        for (isu = start, iSUMSsunum = 0; isu < end; isu++, iSUMSsunum++)
+        for (isu = qstart, iSUMSsunum = 0; isu < qend; isu++, iSUMSsunum++)
         {
            request->sunum[iSUMSsunum] = workingsus[isu]->sunum;
            if (maxRet == -1)
@@ -1622,21 +1761,24 @@ int drms_su_getsudirs(DRMS_Env_t *env, int n, DRMS_StorageUnit_t **su, int retri
         }
 
         /* Submit request to sums server thread. */
-        tqueueAdd(env->sum_inbox, (long) pthread_self(), (char *) request);
+        SumsPipeSubmit(&sumspipe, request, NULL);
+        qstart = qend;
+      }
 
         /* Wait for reply. FIXME: add timeout. */
         if (!dontwait)
         {
            /* If and only if user wants to wait for the reply, then return back
-            * to user all SUDIRs found. */
-           /* Could take a while for SUMS to respond (it it has to fetch from tape),
-            * so release env lock temporarily. */
-           drms_unlock_server(env);
-           tqueueDel(env->sum_outbox,  (long) pthread_self(), (char **)&reply);
-           drms_lock_server(env);
+            * to user all SUDIRs found. SumsPipeReply() releases the env lock while
+            * waiting - it could take a while for SUMS to respond (it it has to fetch
+            * from tape). */
+           reply = SumsPipeReply(&sumspipe, NULL);
 
            if (reply->opcode != 0)
            {
+               /* The reply to the next chunk is of no use now. */
+               SumsPipeDrain(&sumspipe, mtRequest);
+
                if (reply->opcode == 3)
                {
                     if (reply->sudir)
@@ -2260,9 +2402,12 @@ int drms_su_getinfo(DRMS_Env_t *env, long long *sunums, int nsunums, SUM_info_t
    SUM_info_t *nulladdr = NULL;
    SUM_info_t **pinfo = NULL;
    int maxNoSus = 0;
+   int mtRequest = 0;
+   DRMS_SumsPipe_t sumspipe;
 
 #if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_INFO) && SUMS_USEMTSUMS_INFO
     maxNoSus = MAX_MTSUMS_NSUS;
+    mtRequest = 1;
     DRMS_MtSumsRequest_t *request = NULL;
     DRMS_MtSumsRequest_t *reply = NULL;
 #else
@@ -2289,9 +2434,13 @@ int drms_su_getinfo(DRMS_Env_t *env, long long *sunums, int nsunums, SUM_info_t
     * Store unique values. */
    map = hcon_create(sizeof(SUM_info_t *), 128, SUFreeInfo, NULL, NULL, NULL, 0);
 
+   /* The request for the next chunk of sunums is queued before the reply to the current one
+    * is processed (see DRMS_SumsPipe_t). */
+   SumsPipeInit(&sumspipe, env, 1);
+
    for (nReqs = 0, isunum = 0; isunum < nsunums; isunum++)
    {
-      if (nReqs == 0)
+      if (!request)
       {
 #if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_INFO) && SUMS_USEMTSUMS_INFO
         request = (DRMS_MtSumsRequest_t *)calloc(1, sizeof(DRMS_MtSumsRequest_t));
@@ -2318,17 +2467,21 @@ int drms_su_getinfo(DRMS_Env_t *env, long long *sunums, int nsunums, SUM_info_t
          nReqs++;
       }
 
-      /* ART - Although SUMS will handle up to maxNoSus SUNUMs, the keylist
-       * code used by SUMS is inefficient - the optimal batch size is 64. */
       if (nReqs == maxNoSus || (isunum + 1 == nsunums && nReqs > 0))
       {
          request->reqcnt = nReqs;
 
-         /* Submit request to sums server thread. */
-         tqueueAdd(env->sum_inbox, (long)pthread_self(), (char *)request);
-         drms_unlock_server(env);
-         tqueueDel(env->sum_outbox,  (long)pthread_self(), (char **)&reply);
-         drms_lock_server(env);
+         /* Submit request to sums server thread. The sums thread frees it. */
+         SumsPipeSubmit(&sumspipe, request, NULL);
+         request = NULL;
+         nReqs = 0;
+      }
+
+      /* Process the reply to the oldest request once kSUMSPipeDepth requests are queued, and all the
+       * replies once the last request is queued. */
+      while (sumspipe.nqueued == kSUMSPipeDepth || (isunum + 1 == nsunums && sumspipe.nqueued > 0))
+      {
+         reply = SumsPipeReply(&sumspipe, NULL);
 
          if (reply->opcode != 0)
          {
@@ -2337,63 +2490,26 @@ int drms_su_getinfo(DRMS_Env_t *env, long long *sunums, int nsunums, SUM_info_t
              if (reply->opcode == -2)
              {
                  fprintf(stderr, "Cannot access SUMS in this DRMS session - a tape read is pending.\n");
-                 if (reply)
-                 {
-                    if (reply->sudir)
-                    {
-                        /* Client is waiting for reply, so client must clean-up sudirs. */
-                        for (int i = 0; i < reply->reqcnt; i++)
-                        {
-                            if ((reply->sudir)[i])
-                            {
-                                free((reply->sudir)[i]);
-                                (reply->sudir)[i] = NULL;
-                            }
-                        }
-#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_INFO) && SUMS_USEMTSUMS_INFO
-                        free(reply->sudir);
-                        reply->sudir = NULL;
-#endif
-                    }
-
-                     free(reply);
-                 }
-                 drms_unlock_server(env);
-                 return DRMS_ERROR_PENDINGTAPEREAD;
+                 status = DRMS_ERROR_PENDINGTAPEREAD;
              }
-
-             fprintf(stderr, "SUMINFO failed with error code %d.\n", reply->opcode);
-
-             if (reply)
+             else
              {
-                if (reply->sudir)
-                {
-                    for (int i = 0; i < reply->reqcnt; i++)
-                    {
-                        if ((reply->sudir)[i])
-                        {
-                            free((reply->sudir)[i]);
-                            (reply->sudir)[i] = NULL;
-                        }
-                    }
-#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_INFO) && SUMS_USEMTSUMS_INFO
-                    free(reply->sudir);
-                    reply->sudir = NULL;
-#endif
-                }
-
-                 free(reply);
+                 fprintf(stderr, "SUMINFO failed with error code %d.\n", reply->opcode);
+                 status = 1;
              }
 
+             /* Client is waiting for reply, so client must clean-up sudirs. */
+             SUFreeSudirReply(reply, mtRequest);
+             SumsPipeDrain(&sumspipe, mtRequest);
              drms_unlock_server(env);
-             return 1;
+             return status;
          }
          else
          {
             SUM_info_t *retinfo = NULL;
 
             /* reply->surdir now has pointers to the SUM_info_t structs */
-            for (iinfo = 0; iinfo < nReqs; iinfo++)
+            for (iinfo = 0; iinfo < reply->reqcnt; iinfo++)
             {
                /* NOTE - if an SUNUM is unknown, the SUM_info_t returned from SUM_infoEx() will have the sunum set
                 * to -1.  But drms_server.c will overwrite that -1 with the SUNUM requested. BUT, there could have
@@ -2430,11 +2546,19 @@ int drms_su_getinfo(DRMS_Env_t *env, long long *sunums, int nsunums, SUM_info_t
             free(reply);
             reply = NULL;
          }
-
-         nReqs = 0;
       }
    } /* loop over original sunums */
 
+   if (request)
+   {
+      /* The last sunums were all duplicates. */
+#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_INFO) && SUMS_USEMTSUMS_INFO
+      free(request->sunum);
+#endif
+      free(request);
+      request = NULL;
+   }
+
    if (status == DRMS_SUCCESS)
    {
       /* Copy all the SUM_info_t returned by SUMS into the info parameter (for return to caller). */
@@ -2616,7 +2740,64 @@ int drms_commitunit(DRMS_Env_t *env, DRMS_StorageUnit_t *su)
   return 0;
 }
 
+/* A SUM_put() request that CommitUnits() has queued - the SUs to mark read-only once SUMS owns them. */
+typedef struct DRMS_SumPut_struct
+{
+   DRMS_StorageUnit_t **punits;
+   int nsus;
+} DRMS_SumPut_t;
+
+/* Wait for the reply to the oldest SUM_put() request queued by CommitUnits(). */
+static int CommitUnitsReply(DRMS_SumsPipe_t *sumspipe)
+{
+   DRMS_SumPut_t *put = NULL;
+   int statint = DRMS_SUCCESS;
+   int isu;
+
+#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_PUT) && SUMS_USEMTSUMS_PUT
+    DRMS_MtSumsRequest_t *reply = NULL;
+#else
+    DRMS_SumRequest_t *reply = NULL;
+#endif
+
+   /* Wait for reply. FIXME: add timeout. */
+   reply = SumsPipeReply(sumspipe, (void **)&put);
+
+   if (reply->opcode != 0)
+   {
+       if (reply->opcode == -2)
+       {
+           fprintf(stderr, "Cannot access SUMS in this DRMS session - a tape read is pending.\n");
+           statint = DRMS_ERROR_PENDINGTAPEREAD;
+       }
+       else
+       {
+           fprintf(stderr, "ERROR in drms_commitunit: SUM PUT failed with "
+                   "error code %d.\n",reply->opcode);
+           statint = DRMS_ERROR_SUMPUT;
+       }
+   }
+   else
+   {
+      /* Now the SUs are owned by SUMS, mark them read-only. */
+      for (isu = 0; isu < put->nsus; isu++)
+      {
+         put->punits[isu]->mode = DRMS_READONLY;
+      }
+   }
+
+   free(reply);
+   free(put->punits);
+   free(put);
+
+   return statint;
+}
+
+/* Queue a SUM_put() request for the SUs in ll. The reply is taken by CommitUnitsReply(), once kSUMSPipeDepth
+ * requests are queued (so DRMS writes the Records.txt files of the next SUs while SUMS serves the previous
+ * SUM_put()), or by the caller when it is done. */
 static int CommitUnits(DRMS_Env_t *env,
+                       DRMS_SumsPipe_t *sumspipe,
                        LinkedList_t *ll,
                        const char *seriesName,
                        int seriesArch,
@@ -2631,25 +2812,31 @@ static int CommitUnits(DRMS_Env_t *env,
    FILE *fp = NULL;
    int nsus;
    int statint;
-   int isu;
    int islot;
+   DRMS_StorageUnit_t **punits = NULL; /* hold pointers to submitted SUs. */
+   DRMS_SumPut_t *put = NULL;
+   int maxNoSus = 0;
 
 
 #if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_PUT) && SUMS_USEMTSUMS_PUT
     DRMS_MtSumsRequest_t *request = NULL;
-    DRMS_MtSumsRequest_t *reply = NULL;
-    DRMS_StorageUnit_t **punits = NULL; /* hold pointers to submitted SUs. */
+    maxNoSus = MAX_MTSUMS_NSUS;
 #else
     DRMS_SumRequest_t *request = NULL;
-    DRMS_SumRequest_t *reply = NULL;
-    DRMS_StorageUnit_t *punits[DRMS_MAX_REQCNT]; /* hold pointers to submitted SUs. */
+    maxNoSus = DRMS_MAX_REQCNT;
 #endif
 
    actualarchive = 0;
 
    statint = DRMS_SUCCESS;
 
-   if (ll->nitems > 0)
+   if (sumspipe->nqueued == kSUMSPipeDepth)
+   {
+      /* Make room for this request. */
+      statint = CommitUnitsReply(sumspipe);
+   }
+
+   if (ll->nitems > 0 && statint == DRMS_SUCCESS)
    {
         /* Use series archive flag, but override with cmd-line flag. */
         if (env->archive != INT_MIN)
@@ -2675,16 +2862,15 @@ static int CommitUnits(DRMS_Env_t *env,
 
       nsus = 0;
       list_llreset(ll);
-#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_PUT) && SUMS_USEMTSUMS_PUT
       punits = calloc(list_llgetnitems(ll), sizeof(DRMS_StorageUnit_t *));
-#endif
+      XASSERT(punits);
       while ((node = list_llnext(ll)) != NULL)
       {
          sunit = *((DRMS_StorageUnit_t **)(node->data));
 
          if (!EmptyDir(sunit->sudir, 0))
          {
-            if (nsus == DRMS_MAX_REQCNT)
+            if (nsus == maxNoSus)
             {
                /* There was at least one additional SU to process, but there are more SUs
                 * to process than this function can handle. */
@@ -2740,8 +2926,14 @@ static int CommitUnits(DRMS_Env_t *env,
 
       if (nsus == 0 || statint != DRMS_SUCCESS)
       {
+#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_PUT) && SUMS_USEMTSUMS_PUT
+         free(request->sunum);
+         free(request->sudir);
+#endif
          free(request);
          request = NULL;
+         free(punits);
+         punits = NULL;
       }
       else
       {
@@ -2767,46 +2959,14 @@ static int CommitUnits(DRMS_Env_t *env,
          // must have sum_thread running already
          XASSERT(env->sum_thread);
 
-         /* Submit request to sums server thread. */
-         tqueueAdd(env->sum_inbox, (long) pthread_self(), (char *)request);
-
-         /* Wait for reply. FIXME: add timeout. */
-         tqueueDel(env->sum_outbox,  (long) pthread_self(), (char **)&reply);
-
-         if (reply->opcode != 0)
-         {
-             if (reply->opcode == -2)
-             {
-                 fprintf(stderr, "Cannot access SUMS in this DRMS session - a tape read is pending.\n");
-                 statint = DRMS_ERROR_PENDINGTAPEREAD;
-             }
-             else
-             {
-                 fprintf(stderr, "ERROR in drms_commitunit: SUM PUT failed with "
-                         "error code %d.\n",reply->opcode);
-                 statint = DRMS_ERROR_SUMPUT;
-             }
-         }
-         else
-         {
-            /* Now the SUs are owned by SUMS, mark them read-only. */
-            for (isu = 0; isu < nsus; isu++)
-            {
-               sunit = punits[isu];
-               sunit->mode = DRMS_READONLY;
-            }
-         }
+         put = malloc(sizeof(DRMS_SumPut_t));
+         XASSERT(put);
+         put->punits = punits;
+         put->nsus = nsus;
 
-         free(reply);
-         /* No need to free request - sums thread does that. */
+         /* Submit request to sums server thread. No need to free request - sums thread does that. */
+         SumsPipeSubmit(sumspipe, request, put);
       }
-#if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_PUT) && SUMS_USEMTSUMS_PUT
-      if (punits)
-      {
-        free(punits);
-        punits = NULL;
-      }
-#endif
    }
 
    return statint;
@@ -2836,6 +2996,8 @@ int drms_commit_all_units(DRMS_Env_t *env, int *archive, int *status)
     int16_t newSuRetention = INT16_MIN;
     int16_t maxNewSuRetention = INT16_MIN;
     int maxNoSus = 0;
+    DRMS_SumsPipe_t sumspipe;
+    int putstat;
 
 #if defined(SUMS_USEMTSUMS) && SUMS_USEMTSUMS && defined(SUMS_USEMTSUMS_PUT) && SUMS_USEMTSUMS_PUT
     maxNoSus = MAX_MTSUMS_NSUS;
@@ -2844,6 +3006,10 @@ int drms_commit_all_units(DRMS_Env_t *env, int *archive, int *status)
 #endif
 
     XASSERT(env->session->db_direct==1);
+
+    /* The SUM_put() of the next batch of SUs is queued before the reply to the previous one is taken
+     * (see DRMS_SumsPipe_t). */
+    SumsPipeInit(&sumspipe, env, 0);
     hiter_new(&hit_outer, &env->storageunit_cache);
     if (archive)
         *archive = 0;
@@ -2936,7 +3102,7 @@ int drms_commit_all_units(DRMS_Env_t *env, int *archive, int *status)
                  * is an optimal batch size. */
                 if (nsus == maxNoSus)
                 {
-                    statint = CommitUnits(env, sulist, seriesName, si->archive, si->unitsize, si->tapegroup, maxNewSuRetention);
+                    statint = CommitUnits(env, &sumspipe, sulist, seriesName, si->archive, si->unitsize, si->tapegroup, maxNewSuRetention);
                     list_llfree(&sulist);
                     nsus = 0;
 
@@ -2953,7 +3119,7 @@ int drms_commit_all_units(DRMS_Env_t *env, int *archive, int *status)
         /* May be some SUs in sulist not yet committed (because there are fewer than 64). */
         if (nsus > 0)
         {
-            statint = CommitUnits(env, sulist, seriesName, si->archive, si->unitsize, si->tapegroup, maxNewSuRetention);
+            statint = CommitUnits(env, &sumspipe, sulist, seriesName, si->archive, si->unitsize, si->tapegroup, maxNewSuRetention);
             list_llfree(&sulist);
             nsus = 0;
         }
@@ -2961,6 +3127,17 @@ int drms_commit_all_units(DRMS_Env_t *env, int *archive, int *status)
 
     hiter_free(&hit_outer);
 
+    /* Wait for the SUM_put()s still outstanding. */
+    while (sumspipe.nqueued > 0)
+    {
+        putstat = CommitUnitsReply(&sumspipe);
+
+        if (statint == DRMS_SUCCESS)
+        {
+            statint = putstat;
+        }
+    }
+
     /* If the caller set the archive flag on the cmd-line, then override what the series' jsds say. */
     if (archive && *archive == 0 && env->archive == 1)
         *archive = 1;
@@ -3004,6 +3181,8 @@ DRMS_StorageUnit_t *drms_su_lookup(DRMS_Env_t *env, char *series, long long sunu
                 break;
             }
         }
+
+        hiter_free(&hit);
     }
     else
     {
@@ -3545,6 +3724,8 @@ size_t create_post_msg(HContainer_t *postmap, char **ptrr)
       }
    }
 
+   hiter_free(&hit);
+
    return size_count;
 }
 
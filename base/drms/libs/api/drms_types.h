@@ -375,6 +375,19 @@ struct CleanerData_struct
 
 typedef struct CleanerData_struct CleanerData_t;
 
+/* A lock on one of drms_server's caches (see drms_lock_cache()). Lookups take it for reading, and changes for
+ * writing; the thread that holds it for writing may take it again, in either mode, since building a series
+ * template can need other series' templates. */
+struct DRMS_CacheLock_struct
+{
+  pthread_rwlock_t lock;
+  pthread_mutex_t writermtx; /* guards writer and nwrite */
+  pthread_t writer;
+  int nwrite;                /* number of times writer has taken lock for writing (0 - no writer) */
+};
+
+typedef struct DRMS_CacheLock_struct DRMS_CacheLock_t;
+
 /** \brief DRMS environment struct */
 struct DRMS_Env_struct
 {
@@ -415,15 +428,23 @@ struct DRMS_Env_struct
   pthread_mutex_t *drms_lock; /* To synchronize the environment (which can be accessed/
                                * modified by signal thread, sums thread, and main thread during shutdown) */
   pthread_mutex_t *clientlock; /* To synchronize between server threads (one per client connected to
-                                * drms_server). The policy is to allow only one client at a time
-                                * inside drms_server's DRMS library. */
+                                * drms_server). Only requests that change drms_server's transaction or its
+                                * storage-unit cache take it; queries, SUMS look-ups, and series creation do not. */
+  DRMS_CacheLock_t *series_cache_lock; /* Server only - guards series_cache. */
+  DRMS_CacheLock_t *record_cache_lock; /* Server only - guards record_cache (the container, not the records
+                                        * in it, which belong to the thread that opened them). */
 
   /* SUM service thread. */
   pthread_t sum_thread;
   /* Tagged FIFOs for communicating with the SUM service thread. */
   tqueue_t *sum_inbox;
   tqueue_t *sum_outbox;
-  long sum_tag; // tag of the request currently being served.
+  int sums_nworkers; /* number of SUMS worker threads (each with its own SUMS connection) that the SUM service
+                      * thread dispatches requests to; 0 - the default */
+
+  int db_nreadconns; /* number of extra, read-only db connections that server threads run client queries on while
+                      * the server's transaction has not modified the database; 0 - none (all queries share db_handle) */
+  struct DRMS_ReadPool_struct *readpool;
 
   /* Signal catching thread: */
   pthread_t signal_thread;
@@ -451,6 +472,16 @@ struct DRMS_Env_struct
   int createshadows;  /* 1 if it is okay for module code to attempt to create shadow tables. */
   int dbutf8clientencoding;
   int print_sql_only; /* if 1, then the SQL used to retrieve DRMS records is printed, and then program execution ends */
+  int keyword_columns; /* if 1, then record sets retrieved from the db store their keyword values in columns shared
+                        * by all records of the set (see DRMS_KeyColumns_t), instead of in per-record keyword containers */
+  int query_stream; /* if 1, then record sets opened with drms_open_recordset() stream their rows from the db (see
+                     * db_stream_open()) instead of fetching them chunk by chunk from a db cursor */
+  int prefetch_depth; /* default number of record chunks that drms_recordset_fetchnext() fetches ahead of the module (0 - no prefetch);
+                       * see drms_recordset_setprefetch() */
+  int segment_mmap; /* if 1, then drms_segment_read() maps uncompressed FITS and DRMS_BINARY segment files into memory and
+                     * converts the data straight from the mapping, instead of reading the file into a buffer first */
+  int fits_threads; /* number of threads drms_segment_read() and drms_segment_write() use to uncompress and compress
+                     * tile-compressed FITS images (0 or 1 - no extra threads) */
 };
 
 /** \brief DRMS environment struct reference */
@@ -597,6 +628,17 @@ struct DRMS_RecSetCursor_struct
   int openLinks; /* set in drms_open_recordset_internal(); passed into drms_open_recordset_internal() by client (e.g., show_info) */
 
   int cache_full_record; /* set in drms_open_recordset_internal(); passed into drms_open_recordset_internal() by client (e.g., show_info) */
+
+  /** \brief For each record-set subset, the SELECT statement whose rows are streamed (instead of FETCHed from the cursor in names); NULL
+   * once all rows of the subset have been read. NULL if the record-set is not streamed. */
+  char **streamqueries;
+  /** \brief The streamed query currently being read (at most one subset is streamed at a time). */
+  DB_Stream_t *stream;
+
+  /** \brief Number of chunks to fetch ahead of the module on a background thread (0 - no prefetch). */
+  int prefetchdepth;
+  /** \brief State of the prefetch thread (NULL until the first chunk is opened). */
+  struct DRMS_RecSetPrefetch_struct *prefetch;
 };
 
 /** \brief DRMS cursor struct reference */
@@ -735,6 +777,10 @@ struct DRMS_Record_struct
   HContainer_t *keyword_aliases; /* Each keyword can have an arbitrary number of aliases
                                   * (as long as there are no duplicate key names)
                                   */
+  struct DRMS_KeyColumns_struct *keycols; /* If not NULL, the keyword values of this record live in
+                                           * row keyrow of these shared columns, and keywords holds only
+                                           * the keywords that have been looked up (materialized). */
+  int keyrow;
 };
 
 /** DRMS record struct reference */
@@ -986,6 +1032,33 @@ struct DRMS_Keyword_struct
 /** \brief DRMS keyword struct reference */
 typedef struct DRMS_Keyword_struct DRMS_Keyword_t;
 
+/* Columnar keyword storage for a record set (struct of arrays). All records of the set share one
+ * schema, copied from the series template, and the value of keyword icol of record keyrow is
+ * element keyrow of that keyword's column. Where the type allows, the column is the db column of
+ * the query result itself, which the record set adopts instead of copying. A record's keyword
+ * struct is created in its keywords container only when the keyword is looked up by name. */
+struct DRMS_KeyColumns_struct
+{
+  int nrows;                /* Number of records sharing the columns. */
+  int ncols;                /* Number of keywords in the schema. */
+  DRMS_Keyword_t *schema;   /* ncols template keywords, in rank order; value holds the default value. */
+  void **columns;           /* Per keyword, NULL or an array of nrows values of the keyword's type
+                             * (char * for strings; a NULL string means the default value), used
+                             * when the db column cannot be used in place. */
+  int *dbcols;              /* Per keyword, the column of result holding its values, or -1 for
+                             * link and constant keywords, which are never stored per record. */
+  int ndbcols;              /* Number of result columns bound; -1 until bound. */
+  DB_Binary_Result_t *result; /* Query result the columns are bound to. */
+  int ownsresult;           /* If 1, result is freed with the columns. */
+  HContainer_t index;       /* Lower-case keyword name or alias -> int index into schema. */
+  HContainer_t strings;     /* Interned per-record strings (sessionns) -> char *. */
+  char *lastinterned;
+  int refcount;             /* Number of records referring to the columns. */
+};
+
+/** \brief DRMS keyword columns reference */
+typedef struct DRMS_KeyColumns_struct DRMS_KeyColumns_t;
+
 /**************************** Links ***************************/
 
 /* Links to other objects from which keyword values can be inherited.
@@ -1129,6 +1202,12 @@ struct DRMS_Array_struct
   char *strbuf;
   /** \brief Size of string buffer. */
   long long buflen;
+
+  /* Private fields used for arrays whose data are part of a memory-mapped file. */
+  /** \brief Start of the mapping (NULL if data were allocated with malloc()). */
+  void *mapaddr;
+  /** \brief Length of the mapping. */
+  size_t maplen;
 };
 
 /** \brief DRMS array struct reference*/
@@ -364,7 +364,7 @@ int JSOCMAIN_Main(int argc, char **argv, const char *module_name, int (*CallDoIt
     char *dbport = NULL;
     char dbHostAndPort[64];
   int printrel = 0;
-  char reservebuf[256];
+  char reservebuf[512];
   int16_t retention;
   int16_t newsuretention;
 
@@ -375,7 +375,7 @@ int JSOCMAIN_Main(int argc, char **argv, const char *module_name, int (*CallDoIt
   xmem_config(1,1,1,1,1000000,1,0,0);
 #endif
   /* Parse command line parameters. */
-  snprintf(reservebuf, sizeof(reservebuf), "%s,%s,%s,%s,%s,%s,%s,%s,%s,%s", "L,Q,V,jsocmodver", kARCHIVEARG, kRETENTIONARG, kNewSuRetention, kQUERYMEMARG, kLoopConn, kDBTimeOut, kCreateShadows, kDBUtf8ClientEncoding, DRMS_ARG_PRINT_SQL);
+  snprintf(reservebuf, sizeof(reservebuf), "%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s", "L,Q,V,jsocmodver", kARCHIVEARG, kRETENTIONARG, kNewSuRetention, kQUERYMEMARG, kLoopConn, kDBTimeOut, kCreateShadows, kDBUtf8ClientEncoding, DRMS_ARG_PRINT_SQL, DRMS_ARG_KEYWORD_COLUMNS, DRMS_ARG_QUERY_STREAM, DRMS_ARG_PREFETCH, DRMS_ARG_SEGMENT_MMAP, DRMS_ARG_FITS_THREADS);
   cmdparams_reserve(&cmdparams, reservebuf, "jsocmain");
 
   status = cmdparams_parse (&cmdparams, argc, argv);
@@ -580,6 +580,24 @@ int JSOCMAIN_Main(int argc, char **argv, const char *module_name, int (*CallDoIt
 
     int print_sql_only = cmdparams_isflagset(&cmdparams, DRMS_ARG_PRINT_SQL);
 
+    int keyword_columns = cmdparams_isflagset(&cmdparams, DRMS_ARG_KEYWORD_COLUMNS);
+
+    int query_stream = cmdparams_isflagset(&cmdparams, DRMS_ARG_QUERY_STREAM);
+
+    int prefetch_depth = 0;
+    if (drms_cmdparams_exists(&cmdparams, DRMS_ARG_PREFETCH))
+    {
+        prefetch_depth = drms_cmdparams_get_int(&cmdparams, DRMS_ARG_PREFETCH, NULL);
+    }
+
+    int segment_mmap = cmdparams_isflagset(&cmdparams, DRMS_ARG_SEGMENT_MMAP);
+
+    int fits_threads = 0;
+    if (drms_cmdparams_exists(&cmdparams, DRMS_ARG_FITS_THREADS))
+    {
+        fits_threads = drms_cmdparams_get_int(&cmdparams, DRMS_ARG_FITS_THREADS, NULL);
+    }
+
   /* Initialize server's own DRMS environment and connect to
      DRMS database server. */
   if ((drms_env = drms_open(dbHostAndPort, dbuser,dbpasswd,dbname,sessionns)) == NULL)
@@ -668,6 +686,11 @@ int JSOCMAIN_Main(int argc, char **argv, const char *module_name, int (*CallDoIt
   drms_env->loopconn = loopconn;
     drms_env->createshadows = createshadows;
     drms_env->print_sql_only = print_sql_only;
+    drms_env->keyword_columns = keyword_columns;
+    drms_env->query_stream = query_stream;
+    drms_env->prefetch_depth = prefetch_depth;
+    drms_env->segment_mmap = segment_mmap;
+    drms_env->fits_threads = fits_threads;
 
   int abort_flag = 1;
 
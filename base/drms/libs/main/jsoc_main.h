@@ -42,6 +42,11 @@ parsing, and default-parameter initialization.
 #define kCreateShadows "DRMS_SHADOW"
 #define kDBUtf8ClientEncoding "DRMS_DBUTF8CLIENTENCODING"
 #define DRMS_ARG_PRINT_SQL "DRMS_PRINT_SQL"
+#define DRMS_ARG_KEYWORD_COLUMNS "DRMS_KEYWORD_COLUMNS"
+#define DRMS_ARG_QUERY_STREAM "DRMS_QUERY_STREAM"
+#define DRMS_ARG_PREFETCH "DRMS_PREFETCH"
+#define DRMS_ARG_SEGMENT_MMAP "DRMS_SEGMENT_MMAP"
+#define DRMS_ARG_FITS_THREADS "DRMS_FITS_THREADS"
 
 extern CmdParams_t cmdparams;
 /* Global DRMS Environment handle. */
@@ -69,7 +69,7 @@ int JSOCMAIN_Init(int argc,
    int status;
    int quiet;
    int printrel = 0;
-   char reservebuf[128];
+   char reservebuf[256];
    int selfstart = 0;
 
    if (cont)
@@ -83,7 +83,7 @@ int JSOCMAIN_Init(int argc,
    xmem_config (1, 1, 1, 1, 1000000, 1,0, 0);
 #endif
    /* Parse command line parameters */
-   snprintf(reservebuf, sizeof(reservebuf), "%s,%s,%s,%s,%s,%s,%s,%s,%s,%s", "L,Q,V,jsocmodver", kARCHIVEARG, kRETENTIONARG, kNewSuRetention, kQUERYMEMARG, kLoopConn, kDBTimeOut, kCreateShadows, kDBUtf8ClientEncoding, DRMS_ARG_PRINT_SQL);
+   snprintf(reservebuf, sizeof(reservebuf), "%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s", "L,Q,V,jsocmodver", kARCHIVEARG, kRETENTIONARG, kNewSuRetention, kQUERYMEMARG, kLoopConn, kDBTimeOut, kCreateShadows, kDBUtf8ClientEncoding, DRMS_ARG_PRINT_SQL, DRMS_ARG_KEYWORD_COLUMNS);
    cmdparams_reserve(&cmdparams, reservebuf, "jsocmain");
 
    status = cmdparams_parse (&cmdparams, argc, argv);
@@ -150,6 +150,7 @@ int JSOCMAIN_Init(int argc,
 
       drms_env->selfstart = selfstart;
       drms_env->query_mem = cmdparams_get_int (&cmdparams, kQUERYMEMARG, NULL);
+      drms_env->keyword_columns = cmdparams_isflagset (&cmdparams, DRMS_ARG_KEYWORD_COLUMNS);
 
       if (*dolog) {
 	 if (save_stdeo()) {
@@ -0,0 +1,271 @@
+/* benchtarstream.c
+ * Times the tar output of drms-export-to-stdout. nfiles files of filesize bytes are made in a temp dir and
+ * each is written as a tar-file object to out, with
+ *   old - what drms-export-to-stdout used to do: the header is made field by field through a pipe (and the
+ *         user and group are looked up for each file), and the file is read with fread() into a bufsize
+ *         buffer and written with fprintf()
+ *   new - tarstream.c: an in-memory header and sendfile()
+ * and the MB/s of each is reported. With out a regular file, the two tar files can be checked with tar tvf.
+ *
+ * usage: benchtarstream [nfiles] [filesize] [bufsize] [out]
+ *    eg: benchtarstream 10000 65536 96 /dev/null
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pwd.h>
+#include <grp.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include "tarstream.h"
+
+static double dtime()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec / 1.0e6;
+}
+
+static void OldOctal(FILE *stream, long long value, size_t fieldWidth)
+{
+    char field[32];
+
+    snprintf(field, sizeof(field), "%0*llo", (int)fieldWidth - 1, value);
+    fwrite(field, 1, fieldWidth, stream);
+}
+
+static void OldPad(FILE *stream, const char *str, size_t total)
+{
+    char *buf = calloc(total, 1);
+
+    if (str)
+    {
+        memcpy(buf, str, strlen(str) < total ? strlen(str) : total);
+    }
+
+    fwrite(buf, 1, total, stream);
+    free(buf);
+}
+
+/* the old DumpTarFileObjectHeader() */
+static void OldHeader(FILE *stream, const char *fileName, size_t fileSize)
+{
+    struct passwd pwd;
+    struct passwd *resultPwd = NULL;
+    struct group grp;
+    struct group *resultGrp = NULL;
+    char idBuf[16384];
+    int pipefds[2];
+    char header[TARSTREAM_BLOCK_SIZE];
+    FILE *writeStream = NULL;
+    FILE *readStream = NULL;
+    unsigned long long chksum = 0;
+    size_t num = 0;
+    int i;
+
+    if (pipe(pipefds))
+    {
+        exit(1);
+    }
+
+    writeStream = fdopen(pipefds[1], "w");
+    readStream = fdopen(pipefds[0], "r");
+    getpwuid_r(getuid(), &pwd, idBuf, sizeof(idBuf), &resultPwd);
+    OldPad(writeStream, fileName, 100);
+    OldOctal(writeStream, 436, 8);
+    OldOctal(writeStream, pwd.pw_uid, 8);
+    OldOctal(writeStream, pwd.pw_gid, 8);
+    OldOctal(writeStream, fileSize, 12);
+    OldOctal(writeStream, time(NULL), 12);
+    fwrite("        ", 1, 8, writeStream);
+    OldOctal(writeStream, 0, 1);
+    OldPad(writeStream, NULL, 100);
+    OldPad(writeStream, "ustar", 6);
+    fwrite("00", 1, 2, writeStream);
+    OldPad(writeStream, pwd.pw_name, 32);
+    getgrgid_r(pwd.pw_gid, &grp, idBuf, sizeof(idBuf), &resultGrp);
+    OldPad(writeStream, resultGrp ? grp.gr_name : NULL, 32);
+    OldPad(writeStream, NULL, 8);
+    OldPad(writeStream, NULL, 8);
+    OldPad(writeStream, NULL, 155);
+    fflush(writeStream);
+    fclose(writeStream);
+
+    memset(header, 0, sizeof(header));
+    while (num < sizeof(header) && (i = fread(header + num, 1, sizeof(header) - num, readStream)) > 0)
+    {
+        num += i;
+    }
+
+    fclose(readStream);
+
+    for (i = 0; i < sizeof(header); i++)
+    {
+        chksum += (int)header[i];
+    }
+
+    fwrite(header, 1, 148, stream);
+    OldOctal(stream, chksum, 7);
+    fwrite(" ", 1, 1, stream);
+    fwrite(header + 156, 1, sizeof(header) - 156, stream);
+}
+
+/* the old WriteFile() */
+static void OldFile(FILE *stream, const char *path, const char *name, size_t bufSize)
+{
+    struct stat stBuf;
+    FILE *readStream = NULL;
+    char *readBuffer = NULL;
+    size_t numBytesRead;
+
+    lstat(path, &stBuf);
+    OldHeader(stream, name, stBuf.st_size);
+    readStream = fopen(path, "r");
+    readBuffer = calloc(sizeof(char), bufSize);
+
+    while ((numBytesRead = fread(readBuffer, sizeof(char), bufSize - 1, readStream)) > 0)
+    {
+        readBuffer[numBytesRead] = '\0';
+        fprintf(stream, "%s", readBuffer);
+    }
+
+    free(readBuffer);
+    fclose(readStream);
+
+    if (stBuf.st_size % TARSTREAM_BLOCK_SIZE)
+    {
+        OldPad(stream, NULL, TARSTREAM_BLOCK_SIZE - stBuf.st_size % TARSTREAM_BLOCK_SIZE);
+    }
+
+    fflush(stream);
+}
+
+int main(int argc, char *argv[])
+{
+    int nfiles = argc > 1 ? atoi(argv[1]) : 10000;
+    size_t filesize = argc > 2 ? strtoul(argv[2], NULL, 10) : 65536;
+    size_t bufsize = argc > 3 ? strtoul(argv[3], NULL, 10) : 96;
+    const char *out = argc > 4 ? argv[4] : "/dev/null";
+    char dir[] = "/tmp/benchtarstreamXXXXXX";
+    char path[PATH_MAX];
+    char name[64];
+    char outpath[PATH_MAX];
+    char *content = NULL;
+    FILE *stream = NULL;
+    TarStream_t ts;
+    double t;
+    double told = 0;
+    double tnew = 0;
+    size_t i;
+    int fd;
+    int old;
+
+    if (!mkdtemp(dir))
+    {
+        fprintf(stderr, "Can't make a temp dir\n");
+        return 1;
+    }
+
+    /* printable, with no '%' (the old path wrote it as a format) */
+    content = malloc(filesize);
+    for (i = 0; i < filesize; i++)
+    {
+        content[i] = (i % 64 == 63) ? '\n' : 'A' + (i * 7 + i / 64) % 26;
+    }
+
+    for (i = 0; i < nfiles; i++)
+    {
+        snprintf(path, sizeof(path), "%s/f%06zu.fits", dir, i);
+        fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0664);
+        if (fd == -1 || write(fd, content, filesize) != filesize)
+        {
+            fprintf(stderr, "Can't make %s\n", path);
+            return 1;
+        }
+
+        close(fd);
+    }
+
+    for (old = 1; old >= 0; old--)
+    {
+        /* a regular-file out gets a .old and a .new tar */
+        snprintf(outpath, sizeof(outpath), "%s", out);
+        if (strcmp(out, "/dev/null"))
+        {
+            snprintf(outpath, sizeof(outpath), "%s.%s", out, old ? "old" : "new");
+        }
+
+        stream = fopen(outpath, "w");
+        if (!stream)
+        {
+            fprintf(stderr, "Can't open %s\n", outpath);
+            return 1;
+        }
+
+        t = dtime();
+        if (!old)
+        {
+            tarstream_init(&ts, fileno(stream));
+        }
+
+        for (i = 0; i < nfiles; i++)
+        {
+            snprintf(path, sizeof(path), "%s/f%06zu.fits", dir, i);
+            snprintf(name, sizeof(name), "f%06zu.fits", i);
+
+            if (old)
+            {
+                OldFile(stream, path, name, bufsize);
+            }
+            else if (tarstream_file(&ts, path, name) != kTarStreamStat_Success)
+            {
+                fprintf(stderr, "tarstream_file() failed on %s\n", path);
+                return 1;
+            }
+        }
+
+        if (old)
+        {
+            OldPad(stream, NULL, TARSTREAM_BLOCK_SIZE * 2);
+            fflush(stream);
+        }
+        else
+        {
+            tarstream_end(&ts);
+            tarstream_free(&ts);
+        }
+
+        fclose(stream);
+        t = dtime() - t;
+
+        if (old)
+        {
+            told = t;
+        }
+        else
+        {
+            tnew = t;
+        }
+    }
+
+    printf("%d files of %zu bytes: old %.3f s (%.1f MB/s), new %.3f s (%.1f MB/s) (%.1fx)\n",
+           nfiles, filesize, told, nfiles * (double)filesize / told / 1.0e6,
+           tnew, nfiles * (double)filesize / tnew / 1.0e6, told / tnew);
+
+    for (i = 0; i < nfiles; i++)
+    {
+        snprintf(path, sizeof(path), "%s/f%06zu.fits", dir, i);
+        unlink(path);
+    }
+
+    rmdir(dir);
+    free(content);
+
+    return 0;
+}
@@ -15,11 +15,13 @@
   * to be saved to a local path; this module ONLY writes to stdout; the STAGE_CGI feature of drms_export_cgi
   * was not used - should we need that feature, the caller of this module can redirect to a local file.
   */
-#include <pwd.h>
-#include <grp.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <signal.h>
 #include "json.h"
 #include "jsoc_main.h"
 #include "exputil.h"
+#include "tarstream.h"
 #include "fitsexport.h"
 
 
@@ -38,6 +40,7 @@ char *module_name = "drms-export-to-stdout";
 #define ARG_DUMP_FILE_NAME "d" /* if not making a tar, then dump the name of the FITS file at the beginning of the stream */
 #define ARG_SUPPRESS_STDERR "e" /* if set, then do not print error messages and warnings to stderr */
 #define ARG_EXPORT_FROM_MANIFEST "m" /* if set, then `spec` is a manifest-table specification */
+#define ARG_NUM_WORKERS "workers" /* the number of FITS files made at the same time (tar file only) */
 
 #define FILE_LIST_PATH "jsoc/file_list.json"
 #define ERROR_LIST_PATH "jsoc/error_list.json"
@@ -47,8 +50,6 @@ char *module_name = "drms-export-to-stdout";
 #define DEFAULT_MAX_TAR_FILE_SIZE "4294967296" /* 4 GB*/
 #define MAX_MAX_TAR_FILE_SIZE 53687091200 /* 50 GB - the maxfilesize argument cannot be larger than this */
 #define TAR_BLOCK_SIZE 512
-#define TAR_HEADER_SIZE 512
-#define ACK_FILE_BUFFER 96
 #define FILE_NAME_SIZE 256 /* the size of the buffer for the name of the file exported */
 
 /* status codes */
@@ -98,6 +99,7 @@ ModuleArgs_t module_args[] =
     { ARG_FLAG, ARG_DUMP_FILE_NAME, NULL, "dump the name of the FITS file at the beginning of the stream" },
     { ARG_FLAG, ARG_SUPPRESS_STDERR, NULL, "do not print error messages to stdout (if not making a tar file)" },
     { ARG_FLAG, ARG_EXPORT_FROM_MANIFEST, NULL, "`spec` is a manifest-table specification" },
+    { ARG_INT, ARG_NUM_WORKERS, "1", "the number of processes that make FITS files at the same time; the tar file content and order do not change" },
     { ARG_END }
 };
 
@@ -264,336 +266,57 @@ static ExpToStdoutStatus_t DumpAndPad(FILE *stream, const char *buf, size_t numB
     return expStatus;
 }
 
-static ExpToStdoutStatus_t DumpOctal(FILE *stream, long long value, size_t fieldWidth, size_t *numBytesDumped)
+/* all tar-file objects are written straight to the stdout fd by tarstream; headers are made in memory, and file bodies are
+ * moved with sendfile(); anything written to stream with stdio (the FITS files dumped by cfitsio) must be flushed before
+ * calling tarstream */
+static TarStream_t *GetTarStream(FILE *stream)
 {
-    ExpToStdoutStatus_t expStatus = ExpToStdoutStatus_Success;
-    size_t numDumped = 0;
+    static TarStream_t tarStream;
+    static int initialized = 0;
 
-    char *field = NULL;
-
-    field = calloc(1, fieldWidth + 1);
-    if (field)
-    {
-        snprintf(field, fieldWidth + 1, "%0*llo\0", (int)fieldWidth - 1, value); /* trailing NUL ('\0') char */
-        expStatus = Dump(stream, field, fieldWidth, &numDumped);
-    }
+    fflush(stream);
 
-    if (numBytesDumped)
+    if (!initialized || tarStream.fd != fileno(stream))
     {
-        if (expStatus == ExpToStdoutStatus_Success)
+        if (tarstream_init(&tarStream, fileno(stream)) != kTarStreamStat_Success)
         {
-            *numBytesDumped = *numBytesDumped + numDumped;
-        }
-        else
-        {
-            *numBytesDumped = *numBytesDumped + 0;
+            /* the uname/gname fields are left empty */
+            fprintf(stderr, "unable to get the user and group names for the tar file\n");
         }
+
+        initialized = 1;
     }
 
-    return expStatus;
+    return &tarStream;
 }
 
-/* header must consist of all ascii chars */
-static ExpToStdoutStatus_t DumpTarFileObjectHeader(FILE *stream, const char *fileName, size_t fileSize)
+static ExpToStdoutStatus_t TarStreamStatus(TarStreamStat_t tsStatus)
 {
-    ExpToStdoutStatus_t expStatus = ExpToStdoutStatus_Success;
-
-    struct passwd pwd;
-    struct passwd *resultPwd = NULL;
-    struct group grp;
-    struct group *resultGrp = NULL;
-    uid_t uid;
-    gid_t gid;
-    char *idBuf = NULL;
-    size_t idBufSize;
-    int pipefds[2];  /* stupid checksum - we cannot dump bytes on stdout in one pass */
-    char header[TAR_HEADER_SIZE];
-    FILE *writeStream = NULL;
-    FILE *readStream = NULL;
-    unsigned long long chksum = 0;
-    size_t numBytesDumped = 0;
-
-    if (pipe(pipefds))
-    {
-        expStatus = ExpToStdoutStatus_IO;
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* open write end */
-        writeStream = fdopen(pipefds[1], "w");
-        if (!writeStream)
-        {
-            expStatus = ExpToStdoutStatus_IO;
-        }
-        else
-        {
-            /* open read end */
-            readStream = fdopen(pipefds[0], "r");
-            if (!readStream)
-            {
-                expStatus = ExpToStdoutStatus_IO;
-            }
-        }
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* file name - left-justified string will all trailing '\0' bytes */
-        expStatus = DumpAndPad(writeStream, fileName, strlen(fileName), 100, NULL);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* file mode - octal */
-        expStatus = DumpOctal(writeStream, 436, 8, NULL); /* O0664 */
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* uid - octal */
-        idBufSize = (size_t)sysconf(_SC_GETPW_R_SIZE_MAX);
-
-        if (idBufSize == -1)
-        {
-            idBufSize = 16384;
-        }
-
-        idBuf = malloc(idBufSize);
-        if (!idBuf )
-        {
-            expStatus = ExpToStdoutStatus_OutOfMemory;
-        }
-        else
-        {
-            uid = getuid();
-            getpwuid_r(uid, &pwd, idBuf, idBufSize, &resultPwd);
-
-            if (!resultPwd)
-            {
-                /* not found or failure */
-                fprintf(stderr, "user id %u not found\n", uid);
-                expStatus = ExpToStdoutStatus_GetUser;
-            }
-        }
-
-        expStatus = DumpOctal(writeStream, pwd.pw_uid, 8, NULL);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* gid - octal */
-        gid = pwd.pw_gid;
-        expStatus = DumpOctal(writeStream, gid, 8, NULL);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* size - octal */
-        expStatus = DumpOctal(writeStream, fileSize, 12, NULL);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* mtime - octal */
-        expStatus = DumpOctal(writeStream, time(NULL), 12, NULL);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* chksum - sum of unsigned byte values of all other fields in header */
-
-        /* for now, pretend that the checksum is 8 spaces, because the spec says
-         * to set this field to all spaces when calculating the checksum
-         */
-         expStatus = Dump(writeStream, "        ", 8, NULL);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* file type (regular) */
-        expStatus = DumpOctal(writeStream, 0, 1, NULL);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* linkname - string (unused) */
-        expStatus = DumpPadding(writeStream, 0, 100, NULL);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* magic - "ustar" */
-        expStatus = DumpAndPad(writeStream, "ustar", 5, 6, NULL);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* version - "00" with NO terminating NUL char */
-        expStatus = DumpAndPad(writeStream, "00", 2, 2, NULL);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* uname */
-        expStatus = DumpAndPad(writeStream, pwd.pw_name, strlen(pwd.pw_name), 32, NULL);
-
-        /* no longer need pwd - we need gid, but we copied that already */
-        if (idBuf)
-        {
-            free(idBuf);
-            idBuf = NULL;
-        }
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* gname */
-
-        /* sigh */
-        idBufSize = (size_t)sysconf(_SC_GETGR_R_SIZE_MAX);
-
-        if (idBufSize == -1)
-        {
-            idBufSize = 16384;
-        }
-
-        idBuf = malloc(idBufSize);
-        if (!idBuf)
-        {
-            expStatus = ExpToStdoutStatus_OutOfMemory;
-        }
-        else
-        {
-            getgrgid_r(gid, &grp, idBuf, idBufSize, &resultGrp);
-
-            if (!resultGrp)
-            {
-                /* not found or failure */
-                fprintf(stderr, "group id %u not found\n", gid);
-                expStatus = ExpToStdoutStatus_GetGroup;
-            }
-            else
-            {
-                expStatus = DumpAndPad(writeStream, grp.gr_name, strlen(grp.gr_name), 32, NULL);
-            }
-        }
-
-        /* no longer need grp */
-        if (idBuf)
-        {
-            free(idBuf);
-            idBuf = NULL;
-        }
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* device major */
-        expStatus = DumpPadding(writeStream, 0, 8, NULL);
+    switch (tsStatus)
+    {
+        case kTarStreamStat_Success:
+            return ExpToStdoutStatus_Success;
+        case kTarStreamStat_OutOfMemory:
+            return ExpToStdoutStatus_OutOfMemory;
+        case kTarStreamStat_GetUser:
+            return ExpToStdoutStatus_GetUser;
+        case kTarStreamStat_GetGroup:
+            return ExpToStdoutStatus_GetGroup;
+        default:
+            return ExpToStdoutStatus_IO;
     }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* device minor */
-        expStatus = DumpPadding(writeStream, 0, 8, NULL);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* prefix - path to file (just a base name) */
-        expStatus = DumpPadding(writeStream, 0, 155, NULL);
-    }
-
-    /* now we have to read back the header */
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        char *ptr = NULL;
-        size_t num = 0;
-
-        /* flush, close the write-end of the pipe */
-        fflush(writeStream);
-        fclose(writeStream);
-        close(pipefds[1]); /* necessary so that reading from the read end does not block */
-
-        /* read the read end of the pipe */
-        memset(header, 0, sizeof(header));
-        ptr = header;
-        while (1)
-        {
-            num = fread(ptr, sizeof(char), TAR_HEADER_SIZE - num, readStream);
-            if (num <= 0)
-            {
-                break;
-            }
-            else
-            {
-                ptr += num;
-            }
-        }
-
-        fclose(readStream);
-        close(pipefds[0]);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        char *ptr;
-
-        /* calculate the checksum */
-        ptr = header;
-        while (ptr < header + sizeof(header))
-        {
-            chksum += (int)*ptr;
-            ptr++;
-        }
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* now dump all the bytes before the checksum */
-        numBytesDumped = 0;
-        expStatus = Dump(stream, header, 148, &numBytesDumped);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* dump the checksum - dump 6 octal numbers, followed by NUL, ...*/
-        expStatus = DumpOctal(stream, chksum, 7, &numBytesDumped);
-
-        /* and then followed by a space char */
-        if (expStatus == ExpToStdoutStatus_Success)
-        {
-            expStatus = Dump(stream, " ", 1, &numBytesDumped);
-        }
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* finally, dump the rest */
-        expStatus = Dump(stream, &header[numBytesDumped], sizeof(header) - numBytesDumped, &numBytesDumped);
-    }
-
-    /* on error, this might not have gotten cleaned up */
-    if (idBuf)
-    {
-        free(idBuf);
-        idBuf = NULL;
-    }
-
-    return expStatus;
 }
 
-static ExpToStdoutStatus_t FillBlock(FILE *stream, int blockSize, int writeSize)
+/* header must consist of all ascii chars */
+static ExpToStdoutStatus_t DumpTarFileObjectHeader(FILE *stream, const char *fileName, size_t fileSize)
 {
-    int remainder = writeSize % blockSize;
-
-    if (remainder != 0)
-    {
-        return DumpPadding(stream, 0, blockSize - remainder, NULL);
-    }
+    return TarStreamStatus(tarstream_header(GetTarStream(stream), fileName, fileSize));
+}
 
-    return ExpToStdoutStatus_Success;
+static ExpToStdoutStatus_t FillBlock(FILE *stream, int blockSize, size_t writeSize)
+{
+    /* blockSize is always TAR_BLOCK_SIZE */
+    return TarStreamStatus(tarstream_pad(GetTarStream(stream), writeSize));
 }
 
 /* filePath - path of the file to be stored in the TAR file
@@ -602,107 +325,24 @@ static ExpToStdoutStatus_t FillBlock(FILE *stream, int blockSize, int writeSize)
  */
 static ExpToStdoutStatus_t WriteFileBuffer(FILE *stream, const char *filePath, const char *buffer, size_t size)
 {
-    ExpToStdoutStatus_t expStatus = ExpToStdoutStatus_Success;
-
-    /* dump TAR header */
-    expStatus = DumpTarFileObjectHeader(stream, filePath, size);
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* dump buffer */
-        fprintf(stream, buffer);
-
-        /* pad - fill up last 512 block with zeroes */
-        expStatus = FillBlock(stream, TAR_BLOCK_SIZE, size);
-    }
-
-    fflush(stream);
-
-    return expStatus;
+    /* dump TAR header, buffer, and 0-pad the last 512 block */
+    return TarStreamStatus(tarstream_buffer(GetTarStream(stream), filePath, buffer, size));
 }
 
-static ExpToStdoutStatus_t WriteFile(FILE *writeStream, const char *filePath, size_t bufSize)
+static ExpToStdoutStatus_t WriteFile(FILE *writeStream, const char *filePath)
 {
-    ExpToStdoutStatus_t expStatus = ExpToStdoutStatus_Success;
     const char *baseName = NULL;
-    struct stat stBuf;
-    char *readBuffer = NULL;
-    size_t numBytesRead;
-    char *ptr = NULL;
-    FILE *readStream = NULL;
-
-
-    if (lstat(filePath, &stBuf) != 0)
-    {
-        fprintf(stderr, "cannot get %s file status\n", filePath);
-        expStatus = ExpToStdoutStatus_IO;
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* dump TAR header */
-        baseName = strrchr(filePath, '/');
-        baseName = baseName ? baseName + 1 : filePath;
-        expStatus = DumpTarFileObjectHeader(writeStream, baseName, stBuf.st_size);
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        readStream = fopen(filePath, "r");
-        if (readStream == NULL)
-        {
-            fprintf(stderr, "cannot open file %s for reading\n", filePath);
-            expStatus = ExpToStdoutStatus_IO;
-        }
-    }
 
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        readBuffer = calloc(sizeof(char), bufSize);
-        if (!readBuffer)
-        {
-            expStatus = ExpToStdoutStatus_OutOfMemory;
-        }
-    }
+    baseName = strrchr(filePath, '/');
+    baseName = baseName ? baseName + 1 : filePath;
 
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* read file contents */
-        while (1)
-        {
-            numBytesRead = fread(readBuffer, sizeof(char), bufSize - 1, readStream);
-            if (numBytesRead <= 0)
-            {
-                break;
-            }
-            else
-            {
-                readBuffer[numBytesRead] = '\0';
-                fprintf(writeStream, readBuffer);
-            }
-        }
-
-        free(readBuffer);
-        readBuffer = NULL;
-
-        fclose(readStream);
-        readStream = NULL;
-    }
-
-    if (expStatus == ExpToStdoutStatus_Success)
-    {
-        /* pad - fill up last 512 block with zeroes */
-        expStatus = FillBlock(writeStream, TAR_BLOCK_SIZE, stBuf.st_size);
-    }
-
-    fflush(writeStream);
-
-    return expStatus;
+    /* dump TAR header, file content (sendfile), and 0-pad the last 512 block */
+    return TarStreamStatus(tarstream_file(GetTarStream(writeStream), filePath, baseName));
 }
 
 static ExpToStdoutStatus_t WriteAckFile(FILE *writeStream, const char *path)
 {
-    return WriteFile(writeStream, path, ACK_FILE_BUFFER);
+    return WriteFile(writeStream, path);
 }
 
 static ExpToStdoutStatus_t Capture_stderr(int saved_pipes[2], int *saved_stderr, FILE **read_stream)
@@ -913,6 +553,460 @@ static void Restore_stderr_on_error(int saved_pipes[2], int *saved_stderr, FILE
     }
 }
 
+/* Parallel FITS-file generation (makeTar and workers > 1). For each segment, ExportRecordToStdout() does the DRMS
+ * part on this process (file-name template, segment file, keyword mapping - fitsexport_mapexport_prepare()), and
+ * forks a worker process that does the CFITSIO part (copy, re-compression, checksums) into an unlinked temporary file,
+ * then goes on to the next segment. When all workers are busy, the oldest job is waited for and written to the tar file
+ * (sendfile()), so the FITS files, error and info messages, and manifest entries are in the same order as when the
+ * files are made one at a time. Workers are processes, not threads, because the FITSIO wrappers redirect stdout and
+ * stderr, and use the process-wide fitsfile cache; a worker never uses DRMS or the database connection.
+ */
+typedef enum
+{
+    ExpFitsJobStatus_Success = 0,
+    ExpFitsJobStatus_NoData = 1,
+    ExpFitsJobStatus_CantCreate = 2,
+    ExpFitsJobStatus_Chksum = 3,
+    ExpFitsJobStatus_NoFile = 4,
+    ExpFitsJobStatus_CantCompressFloat = 5,
+    ExpFitsJobStatus_Failure = 6,
+    ExpFitsJobStatus_Stream = 7
+} ExpFitsJobStatus_t;
+
+typedef struct ExpFitsJob_struct
+{
+    pid_t pid; /* 0 - no worker (the job failed before one was started, or it was run on this process) */
+    ExpFitsJobStatus_t status; /* if pid == 0 */
+    FILE *fitsFile; /* unlinked temporary file - the FITS file the worker made */
+    FILE *errFile; /* unlinked temporary file - the worker's stderr (suppress_stderr only) */
+    char *errText; /* stderr captured while the job was prepared (suppress_stderr only) */
+    char recordSpec[DRMS_MAXQUERYLEN];
+    char segName[DRMS_MAXSEGNAMELEN];
+    char fitsName[DRMS_MAXPATHLEN];
+    char drmsId[128];
+} ExpFitsJob_t;
+
+typedef struct ExpFitsPipe_struct
+{
+    int nworkers;
+    int njobs; /* jobs started, but not yet written to the tar file */
+    int head; /* oldest job */
+    ExpFitsJob_t *jobs; /* nworkers of them, used round-robin */
+} ExpFitsPipe_t;
+
+static ExpFitsPipe_t gExpFitsPipe = { 1, 0, 0, NULL };
+
+static void ExpFitsPipeInit(int nworkers)
+{
+    gExpFitsPipe.nworkers = 1;
+
+    if (nworkers > 1)
+    {
+        gExpFitsPipe.jobs = calloc(nworkers, sizeof(ExpFitsJob_t));
+        if (gExpFitsPipe.jobs)
+        {
+            gExpFitsPipe.nworkers = nworkers;
+        }
+    }
+}
+
+static void ExpFitsPipeTerm(void)
+{
+    if (gExpFitsPipe.jobs)
+    {
+        free(gExpFitsPipe.jobs);
+        gExpFitsPipe.jobs = NULL;
+    }
+
+    gExpFitsPipe.nworkers = 1;
+}
+
+/* runs on the worker process; stdout (where the in-memory FITS file is streamed on close) is the job's fitsFile */
+static ExpFitsJobStatus_t ExpFitsJobRun(const char *filename, DRMS_Protocol_t protocol, CFITSIO_KEYWORD *fitskeys, int setCompression, CFITSIO_COMPRESSION_TYPE compression)
+{
+    ExpFitsJobStatus_t jobStatus = ExpFitsJobStatus_Success;
+    CFITSIO_FILE *cfitsio_file = NULL;
+    long long numBytesFitsFile = 0;
+    int drmsStatus = DRMS_SUCCESS;
+
+    if (cfitsio_create_file(&cfitsio_file, "-", CFITSIO_FILE_TYPE_IMAGE, NULL, NULL, NULL))
+    {
+        return ExpFitsJobStatus_CantCreate;
+    }
+
+    if (setCompression && cfitsio_set_export_compression_type(cfitsio_file, compression) != CFITSIO_SUCCESS)
+    {
+        jobStatus = ExpFitsJobStatus_CantCreate;
+    }
+
+    if (jobStatus == ExpFitsJobStatus_Success)
+    {
+        drmsStatus = fitsexport_export_prepared_to_cfitsio_file(cfitsio_file, filename, protocol, fitskeys);
+        if (drmsStatus == DRMS_ERROR_INVALIDFILE)
+        {
+            jobStatus = ExpFitsJobStatus_NoFile;
+        }
+        else if (drmsStatus == DRMS_ERROR_CANTCOMPRESSFLOAT)
+        {
+            jobStatus = ExpFitsJobStatus_CantCompressFloat;
+        }
+        else if (drmsStatus != DRMS_SUCCESS)
+        {
+            jobStatus = ExpFitsJobStatus_Failure;
+        }
+    }
+
+    if (jobStatus == ExpFitsJobStatus_Success)
+    {
+        if (cfitsio_write_chksum(cfitsio_file) != CFITSIO_SUCCESS)
+        {
+            jobStatus = ExpFitsJobStatus_Chksum;
+        }
+    }
+
+    if (jobStatus == ExpFitsJobStatus_Success)
+    {
+        cfitsio_get_size(cfitsio_file, &numBytesFitsFile);
+
+        if (numBytesFitsFile <= 0)
+        {
+            jobStatus = ExpFitsJobStatus_NoData;
+        }
+    }
+
+    if (jobStatus == ExpFitsJobStatus_Success)
+    {
+        if (cfitsio_stream_and_close_file(&cfitsio_file) != CFITSIO_SUCCESS)
+        {
+            jobStatus = ExpFitsJobStatus_Stream;
+        }
+
+        fflush(stdout);
+    }
+
+    if (cfitsio_file)
+    {
+        /* in-memory file - content is discarded */
+        cfitsio_close_file(&cfitsio_file);
+    }
+
+    return jobStatus;
+}
+
+static void ExpFitsJobFree(ExpFitsJob_t *job)
+{
+    if (job->fitsFile)
+    {
+        fclose(job->fitsFile);
+    }
+
+    if (job->errFile)
+    {
+        fclose(job->errFile);
+    }
+
+    if (job->errText)
+    {
+        free(job->errText);
+    }
+
+    memset(job, 0, sizeof(ExpFitsJob_t));
+}
+
+/* an error for the job's segment, as ExportRecordToStdout() reports one */
+static void ExpFitsJobError(ExpFitsJob_t *job, const char *msg, int export_from_manifest, json_t *errorDataArr)
+{
+    char errMsg[512];
+
+    if (job->errText)
+    {
+        /* implies suppress_stderr */
+        if (*job->errText != '\0' && !export_from_manifest && errorDataArr)
+        {
+            snprintf(errMsg, sizeof(errMsg), "%s", job->errText);
+            Insert_error_msg(job->recordSpec, job->segName, job->fitsName, errMsg, errorDataArr);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "%s\n", msg);
+    }
+}
+
+/* wait for the oldest job and write its FITS file to the tar file; *totalBytes and *totalFiles are for the
+ * whole tar file */
+static ExpToStdoutStatus_t ExpFitsPipeComplete(int export_from_manifest, size_t maxTarFileSize, size_t *totalBytes, size_t *totalFiles, json_t *infoDataArr, json_t *errorDataArr, char **manifest_buf, size_t *sz_manifest_buf)
+{
+    ExpToStdoutStatus_t expStatus = ExpToStdoutStatus_Success;
+    ExpFitsJob_t *job = &gExpFitsPipe.jobs[gExpFitsPipe.head];
+    ExpFitsJobStatus_t jobStatus = job->status;
+    struct stat stBuf;
+    char buffer[1025];
+    size_t sz_errText = 2048;
+    size_t num_bytes = 0;
+    int wstatus = 0;
+    char msg[256];
+
+    if (job->pid > 0)
+    {
+        while (waitpid(job->pid, &wstatus, 0) == -1 && errno == EINTR);
+        jobStatus = (WIFEXITED(wstatus) ? (ExpFitsJobStatus_t)WEXITSTATUS(wstatus) : ExpFitsJobStatus_Failure);
+    }
+
+    if (job->errFile)
+    {
+        /* the worker's stderr follows what was captured while the job was prepared */
+        rewind(job->errFile);
+        while ((num_bytes = fread(buffer, sizeof(char), sizeof(buffer) - 1, job->errFile)) > 0)
+        {
+            buffer[num_bytes] = '\0';
+            job->errText = base_strcatalloc(job->errText, buffer, &sz_errText);
+        }
+    }
+
+    switch (jobStatus)
+    {
+        case ExpFitsJobStatus_Success:
+            break;
+        case ExpFitsJobStatus_NoData:
+            if (errorDataArr)
+            {
+                Insert_error_msg(job->recordSpec, job->segName, job->fitsName, "no data in segment, so no FITS file was produced", errorDataArr);
+            }
+            break;
+        case ExpFitsJobStatus_CantCreate:
+            ExpFitsJobError(job, "cannot create FITS file", export_from_manifest, errorDataArr);
+            break;
+        case ExpFitsJobStatus_Chksum:
+            ExpFitsJobError(job, "unable to write FITS file checksum", export_from_manifest, errorDataArr);
+            break;
+        case ExpFitsJobStatus_NoFile:
+            snprintf(msg, sizeof(msg), "no segment file (segment %s) for this record", job->segName);
+            ExpFitsJobError(job, msg, export_from_manifest, errorDataArr);
+            break;
+        case ExpFitsJobStatus_CantCompressFloat:
+            ExpFitsJobError(job, "cannot export Rice-compressed floating-point images", export_from_manifest, errorDataArr);
+            break;
+        case ExpFitsJobStatus_Stream:
+            ExpFitsJobError(job, "cannot write FITS file to stream", export_from_manifest, errorDataArr);
+            break;
+        default:
+            snprintf(msg, sizeof(msg), "failure exporting segment %s", job->segName);
+            ExpFitsJobError(job, msg, export_from_manifest, errorDataArr);
+            break;
+    }
+
+    if (jobStatus == ExpFitsJobStatus_Success)
+    {
+        fflush(job->fitsFile);
+
+        if (fstat(fileno(job->fitsFile), &stBuf) != 0 || stBuf.st_size == 0)
+        {
+            ExpFitsJobError(job, "cannot write FITS file to stream", export_from_manifest, errorDataArr);
+        }
+        else if (stBuf.st_size + *totalBytes > maxTarFileSize)
+        {
+            /* tar file is too big */
+            snprintf(msg, sizeof(msg), "the tar file size has exceeded the maximum size of %zu bytes; please consider requesting data for fewer records and Rice-compressing images", maxTarFileSize);
+            ExpFitsJobError(job, msg, export_from_manifest, errorDataArr);
+            expStatus = ExpToStdoutStatus_TarTooLarge;
+        }
+        else
+        {
+            /* the header, the FITS file (sendfile()), and the 0-padding of the last block */
+            expStatus = TarStreamStatus(tarstream_fd(GetTarStream(stdout), fileno(job->fitsFile), job->fitsName, stBuf.st_size, time(NULL)));
+
+            if (job->errText && *job->errText != '\0' && errorDataArr)
+            {
+                Insert_error_msg(job->recordSpec, job->segName, job->fitsName, job->errText, errorDataArr);
+            }
+
+            *totalBytes += stBuf.st_size;
+            (*totalFiles)++;
+
+            if (infoDataArr)
+            {
+                Insert_info_msg(job->recordSpec, job->segName, job->fitsName, infoDataArr);
+            }
+            else if (export_from_manifest && manifest_buf)
+            {
+                if (!*manifest_buf)
+                {
+                    *manifest_buf = calloc(*sz_manifest_buf, sizeof(char));
+                }
+
+                insert_into_manifest(job->drmsId, job->fitsName, manifest_buf, sz_manifest_buf);
+            }
+        }
+    }
+
+    ExpFitsJobFree(job);
+    gExpFitsPipe.head = (gExpFitsPipe.head + 1) % gExpFitsPipe.nworkers;
+    gExpFitsPipe.njobs--;
+
+    return expStatus;
+}
+
+/* write all outstanding jobs to the tar file, in order; once the tar file is too large, the remaining jobs are
+ * stopped and dropped */
+static ExpToStdoutStatus_t ExpFitsPipeDrain(int abort, int export_from_manifest, size_t maxTarFileSize, size_t *totalBytes, size_t *totalFiles, json_t *infoDataArr, json_t *errorDataArr, char **manifest_buf, size_t *sz_manifest_buf)
+{
+    ExpToStdoutStatus_t expStatus = ExpToStdoutStatus_Success;
+    ExpFitsJob_t *job = NULL;
+
+    while (gExpFitsPipe.njobs > 0)
+    {
+        if (abort)
+        {
+            job = &gExpFitsPipe.jobs[gExpFitsPipe.head];
+
+            if (job->pid > 0)
+            {
+                kill(job->pid, SIGKILL);
+                while (waitpid(job->pid, NULL, 0) == -1 && errno == EINTR);
+            }
+
+            ExpFitsJobFree(job);
+            gExpFitsPipe.head = (gExpFitsPipe.head + 1) % gExpFitsPipe.nworkers;
+            gExpFitsPipe.njobs--;
+        }
+        else
+        {
+            expStatus = ExpFitsPipeComplete(export_from_manifest, maxTarFileSize, totalBytes, totalFiles, infoDataArr, errorDataArr, manifest_buf, sz_manifest_buf);
+            abort = (expStatus == ExpToStdoutStatus_TarTooLarge);
+        }
+    }
+
+    return expStatus;
+}
+
+/* start a job for segIn; if all workers are busy, the oldest job is first written to the tar file */
+static ExpToStdoutStatus_t ExpFitsPipeSubmit(DRMS_Segment_t *segIn, const char *recordSpec, const char *fitsName, const char *drmsId, int setCompression, CFITSIO_COMPRESSION_TYPE compression, const char *classname, const char *mapfile, int suppress_stderr, int export_from_manifest, size_t maxTarFileSize, size_t *totalBytes, size_t *totalFiles, json_t *infoDataArr, json_t *errorDataArr, char **manifest_buf, size_t *sz_manifest_buf)
+{
+    ExpToStdoutStatus_t expStatus = ExpToStdoutStatus_Success;
+    ExpFitsJob_t *job = NULL;
+    char filename[DRMS_MAXPATHLEN];
+    DRMS_Protocol_t protocol = DRMS_FITS;
+    CFITSIO_KEYWORD *fitskeys = NULL;
+    int drmsStatus = DRMS_SUCCESS;
+    int saved_pipes[2] = {-1, -1};
+    int saved_stderr = -1;
+    int saved_stdout = -1;
+    FILE *read_stream = NULL;
+    int restore_stderr = 0;
+
+    if (gExpFitsPipe.njobs == gExpFitsPipe.nworkers)
+    {
+        expStatus = ExpFitsPipeComplete(export_from_manifest, maxTarFileSize, totalBytes, totalFiles, infoDataArr, errorDataArr, manifest_buf, sz_manifest_buf);
+        if (expStatus != ExpToStdoutStatus_Success)
+        {
+            return expStatus;
+        }
+    }
+
+    job = &gExpFitsPipe.jobs[(gExpFitsPipe.head + gExpFitsPipe.njobs) % gExpFitsPipe.nworkers];
+    memset(job, 0, sizeof(ExpFitsJob_t));
+    snprintf(job->recordSpec, sizeof(job->recordSpec), "%s", recordSpec);
+    snprintf(job->segName, sizeof(job->segName), "%s", segIn->info->name);
+    snprintf(job->fitsName, sizeof(job->fitsName), "%s", fitsName);
+    snprintf(job->drmsId, sizeof(job->drmsId), "%s", drmsId);
+    gExpFitsPipe.njobs++;
+
+    if (suppress_stderr)
+    {
+        /* capture any stderr from the DRMS part */
+        if (Capture_stderr(saved_pipes, &saved_stderr, &read_stream) != ExpToStdoutStatus_Success)
+        {
+            job->status = ExpFitsJobStatus_CantCreate;
+            return ExpToStdoutStatus_Success;
+        }
+
+        restore_stderr = 1;
+    }
+
+    drmsStatus = fitsexport_mapexport_prepare(segIn, classname, mapfile, filename, &protocol, &fitskeys);
+
+    if (restore_stderr)
+    {
+        Restore_stderr(saved_pipes, &saved_stderr, &read_stream, &job->errText);
+    }
+
+    if (drmsStatus != DRMS_SUCCESS)
+    {
+        job->status = (drmsStatus == DRMS_ERROR_INVALIDFILE ? ExpFitsJobStatus_NoFile : ExpFitsJobStatus_Failure);
+        return ExpToStdoutStatus_Success;
+    }
+
+    job->fitsFile = tmpfile();
+    if (suppress_stderr)
+    {
+        job->errFile = tmpfile();
+    }
+
+    if (!job->fitsFile || (suppress_stderr && !job->errFile))
+    {
+        job->status = ExpFitsJobStatus_CantCreate;
+    }
+    else
+    {
+        /* nothing buffered may be copied to the worker */
+        fflush(stdout);
+        fflush(stderr);
+
+        job->pid = fork();
+        if (job->pid == 0)
+        {
+            /* worker - only CFITSIO from here on, and no exit handlers (they belong to the DRMS process) */
+            dup2(fileno(job->fitsFile), STDOUT_FILENO);
+            if (job->errFile)
+            {
+                dup2(fileno(job->errFile), STDERR_FILENO);
+            }
+
+            _exit(ExpFitsJobRun(filename, protocol, fitskeys, setCompression, compression));
+        }
+        else if (job->pid == -1)
+        {
+            /* no worker - make the file on this process, with stdout (and stderr) pointing to the job's files */
+            job->pid = 0;
+            saved_stdout = dup(STDOUT_FILENO);
+            saved_stderr = (job->errFile ? dup(STDERR_FILENO) : -1);
+
+            if (saved_stdout == -1 || (job->errFile && saved_stderr == -1))
+            {
+                job->status = ExpFitsJobStatus_CantCreate;
+            }
+            else
+            {
+                dup2(fileno(job->fitsFile), STDOUT_FILENO);
+                if (job->errFile)
+                {
+                    dup2(fileno(job->errFile), STDERR_FILENO);
+                }
+
+                job->status = ExpFitsJobRun(filename, protocol, fitskeys, setCompression, compression);
+                fflush(stderr);
+            }
+
+            if (saved_stdout != -1)
+            {
+                dup2(saved_stdout, STDOUT_FILENO);
+                close(saved_stdout);
+            }
+
+            if (saved_stderr != -1)
+            {
+                dup2(saved_stderr, STDERR_FILENO);
+                close(saved_stderr);
+            }
+        }
+    }
+
+    cfitsio_free_keys(&fitskeys);
+
+    return ExpToStdoutStatus_Success;
+}
+
 /* subset should be a set of records in a single series */
 /* generates a single FITS file from all records in subset */
 static ExpToStdoutStatus_t ExportRecordSetKeywordsToStdout(DRMS_RecordSet_t *subset, const char *series, int make_tar, int export_from_manifest, int dump_file_name, int suppress_stderr, const char *ffmt, const char *class_name, const char *map_file, size_t *bytes_exported, size_t max_tar_file_size, int *num_records_exported, json_t *info_data_arr, json_t *error_data_arr, char **error_buf, char **manifest_buf, size_t *sz_manifest_buf)
@@ -1387,6 +1481,21 @@ static ExpToStdoutStatus_t ExportRecordToStdout(int makeTar, int export_from_man
     char *series_lower = NULL;
     char *segment_lower = NULL;
     char segment_id[64] = {0};
+    int setCompression = 0;
+    CFITSIO_COMPRESSION_TYPE compression = CFITSIO_COMPRESSION_NONE;
+
+    /* the totals are for the whole tar file, so maxTarFileSize limits the tar file, not each record */
+    if (bytesExported)
+    {
+        totalBytes = *bytesExported;
+    }
+
+    if (numFilesExported)
+    {
+        totalFiles = *numFilesExported;
+    }
+
+    *recordSpec = '\0';
 
     if (makeTar)
     {
@@ -1500,6 +1609,57 @@ static ExpToStdoutStatus_t ExportRecordToStdout(int makeTar, int export_from_man
             continue;
         }
 
+        if (makeTar && gExpFitsPipe.nworkers > 1)
+        {
+            /* a worker makes the FITS file; it is written to the tar file (in order) when a later segment needs the worker,
+             * or by ExportRecordSetToStdout() after the last record */
+            setCompression = 1;
+            compression = CFITSIO_COMPRESSION_RICE;
+
+            if (segCompression)
+            {
+                if (compressAllSegs && (segCompression[0] != CFITSIO_COMPRESSION_NONE))
+                {
+                    compression = segCompression[0];
+                }
+                else if (segCompression[iSeg] >= 0)
+                {
+                    compression = segCompression[iSeg];
+                }
+                else
+                {
+                    setCompression = 0;
+                }
+            }
+
+            *drms_id = '\0';
+            if (export_from_manifest)
+            {
+                series_lower = strdup(expRec->seriesinfo->seriesname);
+                strtolower(series_lower);
+                segment_lower = strdup(segIn->info->name);
+                strtolower(segment_lower);
+
+                /* make keyword-only DRMS_ID */
+                snprintf(drms_id, sizeof(drms_id), "%s:%lld:%s", series_lower, expRec->recnum, segment_lower);
+
+                free(segment_lower);
+                segment_lower = NULL;
+                free(series_lower);
+                series_lower = NULL;
+            }
+
+            expStatus = ExpFitsPipeSubmit(segIn, recordSpec, formattedFitsName, drms_id, setCompression, compression, classname, mapfile, suppress_stderr, export_from_manifest, maxTarFileSize, &totalBytes, &totalFiles, infoDataArr, errorDataArr, manifest_buf, sz_manifest_buf);
+
+            if (expStatus != ExpToStdoutStatus_Success)
+            {
+                break;
+            }
+
+            iSeg++;
+            continue;
+        }
+
         if (suppress_stderr)
         {
             /* capture any stderr and create a recobj from it; read_stream will contain stderr */
@@ -2035,6 +2195,17 @@ static ExpToStdoutStatus_t ExportRecordSetToStdout(DRMS_Env_t *env, int makeTar,
                          * ExpToStdoutStatus_Success */
                          expStatus = ExpToStdoutStatus_Success;
                     }
+
+                    /* write the FITS files the workers are still making (if any); once the tar file is too large,
+                     * the rest are dropped */
+                    if (expStatus == ExpToStdoutStatus_TarTooLarge)
+                    {
+                        ExpFitsPipeDrain(1, export_from_manifest, maxTarFileSize, bytesExported, numFilesExported, infoDataArr, errorDataArr, manifest_buf, sz_manifest_buf);
+                    }
+                    else if (ExpFitsPipeDrain(0, export_from_manifest, maxTarFileSize, bytesExported, numFilesExported, infoDataArr, errorDataArr, manifest_buf, sz_manifest_buf) == ExpToStdoutStatus_TarTooLarge)
+                    {
+                        expStatus = ExpToStdoutStatus_TarTooLarge;
+                    }
                 }
             }
         }
@@ -2160,8 +2331,12 @@ int DoIt(void)
     char *jsonFileContent = NULL;
     json_t *recobj = NULL;
     char specbuf[1024];
-    char numbuf[16];
+    char numbuf[32];
     HContainer_t *export_filter = NULL;
+    struct timeval exportStart;
+    struct timeval exportEnd;
+    double exportSecs = 0;
+    long long numWorkers = 1;
 
     /* read and process arguments */
     rsSpec = params_get_str(&cmdparams, ARG_RS_SPEC);
@@ -2177,6 +2352,7 @@ int DoIt(void)
     GetOptionValue(ARG_FLAG, ARG_DUMP_FILE_NAME, (void *)&dumpFileName);
     GetOptionValue(ARG_FLAG, ARG_SUPPRESS_STDERR, (void *)&suppress_stderr);
     GetOptionValue(ARG_FLAG, ARG_EXPORT_FROM_MANIFEST, (void *)&export_from_manifest);
+    GetOptionValue(ARG_INT, ARG_NUM_WORKERS, (void *)&numWorkers);
 
     memset(generalErrorBuf, '\0', sizeof(generalErrorBuf));
 
@@ -2330,7 +2506,16 @@ int DoIt(void)
 
         /* since the following call dives into lib DRMS, it could print error and warnings messages to stderr; capture those if we are
          * suppressing writing to stderr */
+        if (makeTar)
+        {
+            ExpFitsPipeInit((int)numWorkers);
+        }
+
+        gettimeofday(&exportStart, NULL);
         expStatus = ExportRecordSetToStdout(drms_env, makeTar, export_from_manifest, dumpFileName, suppress_stderr, expRS, fileTemplate, segCompression, compressAllSegs, dump_keywords_only, mapClass, mapFile, &bytesExported, maxTarFileSize, &numFilesExported, infoDataArr, errorDataArr, &error_buf_tmp, &manifest_buf, &sz_manifest_buf, export_filter);
+        gettimeofday(&exportEnd, NULL);
+        exportSecs = (exportEnd.tv_sec - exportStart.tv_sec) + (exportEnd.tv_usec - exportStart.tv_usec) / 1.0e6;
+        ExpFitsPipeTerm();
 
         /* -- ART -- */
         if (!manifest_buf)
@@ -2414,6 +2599,12 @@ int DoIt(void)
         json_insert_pair_into_object(infoRoot, "dir", json_new_null());
         json_insert_pair_into_object(infoRoot, "wait", json_new_number(numbuf));
 
+        /* export throughput */
+        snprintf(numbuf, sizeof(numbuf), "%zu", bytesExported);
+        json_insert_pair_into_object(infoRoot, "bytes", json_new_number(numbuf));
+        snprintf(numbuf, sizeof(numbuf), "%.0f", exportSecs > 0 ? bytesExported / exportSecs : 0);
+        json_insert_pair_into_object(infoRoot, "bytes_per_second", json_new_number(numbuf));
+
         json_tree_to_string(infoRoot, &infoJson);
         jsonFileContent = calloc(1, strlen(infoJson) + 2);
         strcat(jsonFileContent, infoJson);
@@ -2496,8 +2687,7 @@ int DoIt(void)
     if (makeTar)
     {
         /* write the end-of-archive marker (1024 zero bytes) */
-        /* pad - fill up last 512 block with zeroes */
-        dump_status = DumpPadding(stdout, 0, TAR_BLOCK_SIZE * 2, NULL);
+        dump_status = TarStreamStatus(tarstream_end(GetTarStream(stdout)));
     }
 
     /* if expStatus != ExpToStdoutStatus_Success, there was some error before dumping the tar file content; if not,
@@ -2,7 +2,9 @@
 #include "drms_types.h"
 #include "drms_storageunit.h"
 #include "exputil.h"
+#include "expcache.h"
 #include "fitsexport.h"
+#include "qDecoder.h"
 
 #include "defs.h"
 REGISTERSTRINGSPREFIX
@@ -21,7 +23,7 @@ stand-alone mode:
 jsoc_export_as_fits rsquery=<recset query> n=<limit> reqid=<export request id> expversion=<version>
      method=<exp method> protocol=<output-file protocol> path=<output path&gt
      { ffmt=<filename format> } { kmclass=<keymap class> } { kmfile=<keymap file> }
-     { cparms=<compression string list> }
+     { cparms=<compression string list> } { cachedir=<cache dir> } { cachesize=<cache MB> }
 
 or
 
@@ -106,6 +108,15 @@ the packing list contains a two-column table of output files. The first column
 is a record-set query, and the second column is a single exported file. The
 record-set query uniquely identifies the output file.
 
+If @a cachedir is provided, the exported FITS files are also kept in a content-addressed cache in that
+directory, shared by all exports. A file's cache key is the MD5 of everything the file's content depends on - the
+internal segment file (path, size, and mtime), the compression string, and the FITS keywords made from the
+DRMS keywords. The output-file name is not part of the key, so overlapping requests, with different filename
+formats, reuse each other's files. A file found in the cache is hard-linked (or copied) to the export directory
+instead of being made again. At the end of the run the least-recently-used files are removed from the cache until
+it holds at most @a cachesize MB. The packing list then has cache_hits, cache_misses, and cache_bytes_saved
+metadata, which jsoc_fetch reports in the status of the completed request.
+
 @par Flags:
 This module has no flags.
 
@@ -133,6 +144,8 @@ keyword map which is then used to map the DRMS keywords to FITS keywords.
 to FITS keywords.
 @param cparms A comma-separated list of strings. Each string is either
 a CFITSIO compression string or the string "**NONE**".
+@param cachedir The export-cache directory; if not provided, there is no caching.
+@param cachesize The export-cache size limit in MB (0 means no limit).
 
 @par Exit_Status:
 @c 0 success<br>
@@ -192,6 +205,8 @@ typedef enum
 #define kArg_clname      "kmclass"
 #define kArg_kmfile      "kmfile"
 #define kArg_cparms      "cparms"
+#define kArg_cachedir    "cachedir"
+#define kArg_cachesize   "cachesize"
 
 
 #define kDef_expSeries   "jsoc.export"
@@ -202,6 +217,10 @@ typedef enum
 
 #define kMB              (1048576)
 
+/* bump when a change to the export code changes the FITS files made from the same input, so that
+ * files cached by older code are not used */
+#define kCacheKeyVersion "1"
+
 /* If rsquery is provided as a cmd-line argument, then jsoc_export does not
  * save the output data files to an export series.  Instead the caller
  * MUST provide a filename format string (which is a template that
@@ -229,6 +248,8 @@ ModuleArgs_t module_args[] =
      {ARG_STRING, kArg_kmfile, kNotSpecified, "Export key map file."},
      {ARG_STRING, kArg_cparms, kNotSpecified, "FITS-standard compression string used to compress exported image."},
      {ARG_INT, kArg_n, "0", "Record count limit."},
+     {ARG_STRING, kArg_cachedir, kNotSpecified, "Export-cache directory."},
+     {ARG_INT, kArg_cachesize, "102400", "Export-cache size limit in MB."},
      {ARG_END}
 };
 
@@ -282,9 +303,139 @@ MymodError_t WritePListRecord(PLRecType_t rectype, FILE *pkfile, const char *f1,
    return err;
 }
 
+static int AppendKeyStr(char **buf, size_t *len, size_t *size, const char *fmt, ...)
+{
+    va_list ap;
+    int num;
+    char *tmp = NULL;
+
+    while (1)
+    {
+        va_start(ap, fmt);
+        num = vsnprintf(*buf + *len, *size - *len, fmt, ap);
+        va_end(ap);
+
+        if (num < 0)
+        {
+            return 1;
+        }
+
+        if (*len + num < *size)
+        {
+            *len += num;
+            return 0;
+        }
+
+        tmp = realloc(*buf, *size * 2 + num);
+        if (!tmp)
+        {
+            return 1;
+        }
+
+        *buf = tmp;
+        *size = *size * 2 + num;
+    }
+}
+
+/* The export-cache key of the FITS file made from segin - the MD5 of the inputs to the FITS file: the internal
+ * segment file (path, size, mtime), the compression string, and the mapped FITS keywords. Returns NULL if segin
+ * cannot be cached (its file is not made by ExportFITSImage(), or is missing). The caller frees the key. The
+ * segment file (filename must be DRMS_MAXPATHLEN bytes), its protocol, and the mapped keywords are returned for
+ * fitsexport_export_prepared_tofile() on a miss; the caller frees *fitskeys (which is NULL if the key is NULL). */
+static char *MkCacheKey(DRMS_Segment_t *segin, DRMS_Segment_t *tgtseg, const char *cparms, const char *classname, const char *mapfile, char *filename, DRMS_Protocol_t *protocol, CFITSIO_KEYWORD **fitskeys)
+{
+    CFITSIO_KEYWORD *fitskey = NULL;
+    struct stat stBuf;
+    char *buf = NULL;
+    size_t len = 0;
+    size_t size = 8192;
+    int err = 0;
+    char *key = NULL;
+
+    switch (tgtseg->info->protocol)
+    {
+        case DRMS_BINARY:
+        case DRMS_BINZIP:
+        case DRMS_FITZ:
+        case DRMS_FITS:
+        case DRMS_DSDS:
+        case DRMS_LOCAL:
+          break;
+        default:
+          /* TAS files are renamed, and generic files are copied as is (and can be directories) */
+          return NULL;
+    }
+
+    if (fitsexport_mapexport_prepare(segin, classname, mapfile, filename, protocol, fitskeys) != DRMS_SUCCESS)
+    {
+        return NULL;
+    }
+
+    if (stat(filename, &stBuf) != 0 || !S_ISREG(stBuf.st_mode))
+    {
+        cfitsio_free_keys(fitskeys);
+        return NULL;
+    }
+
+    buf = malloc(size);
+    err = (buf == NULL);
+
+    if (!err)
+    {
+        *buf = '\0';
+        err = AppendKeyStr(&buf, &len, &size, "v%s\n%s\n%lld\n%lld\n%s\n", kCacheKeyVersion, filename, (long long)stBuf.st_size, (long long)stBuf.st_mtime, cparms ? cparms : "");
+    }
+
+    for (fitskey = *fitskeys; !err && fitskey; fitskey = fitskey->next)
+    {
+        err = AppendKeyStr(&buf, &len, &size, "%s\t%c\t%d\t", fitskey->key_name, fitskey->key_type, fitskey->is_missing);
+
+        if (!err)
+        {
+            switch (fitskey->key_type)
+            {
+                case CFITSIO_KEYWORD_DATATYPE_LOGICAL:
+                  err = AppendKeyStr(&buf, &len, &size, "%d", fitskey->key_value.vl);
+                  break;
+                case CFITSIO_KEYWORD_DATATYPE_INTEGER:
+                  err = AppendKeyStr(&buf, &len, &size, "%lld", fitskey->key_value.vi);
+                  break;
+                case CFITSIO_KEYWORD_DATATYPE_FLOAT:
+                  err = AppendKeyStr(&buf, &len, &size, "%.17g", fitskey->key_value.vf);
+                  break;
+                default:
+                  /* strings and complex numbers */
+                  err = AppendKeyStr(&buf, &len, &size, "%s", fitskey->key_value.vs ? fitskey->key_value.vs : "");
+            }
+        }
+
+        if (!err)
+        {
+            err = AppendKeyStr(&buf, &len, &size, "\t%s\t%s\t%s\n", fitskey->key_format, fitskey->key_comment, fitskey->key_unit);
+        }
+    }
+
+    if (!err)
+    {
+        key = qHashMd5Str(buf, len);
+    }
+
+    if (buf)
+    {
+        free(buf);
+    }
+
+    if (!key)
+    {
+        cfitsio_free_keys(fitskeys);
+    }
+
+    return key;
+}
+
 /* Assumes tcount is zero on the first call.  This function adds
  * the number of files exported to tcount on each call. */
-static unsigned long long MapexportRecordToDir(DRMS_Record_t *recin, const char *ffmt, const char *outpath, FILE *pklist, const char *classname, const char *mapfile, int *tcount, const char **cparms, MymodError_t *status, char **errmsg)
+static unsigned long long MapexportRecordToDir(DRMS_Record_t *recin, const char *ffmt, const char *outpath, FILE *pklist, const char *classname, const char *mapfile, int *tcount, const char **cparms, ExpCache_t *cache, MymodError_t *status, char **errmsg)
 {
    int drmsstat = DRMS_SUCCESS;
    MymodError_t modstat = kMymodErr_Success;
@@ -293,6 +444,11 @@ static unsigned long long MapexportRecordToDir(DRMS_Record_t *recin, const char
    unsigned long long tsize = 0;
     unsigned long long expsize = 0;
     char *actualfname = NULL;
+    char *cachekey = NULL;
+    char segfile[DRMS_MAXPATHLEN];
+    DRMS_Protocol_t protocol = DRMS_FITS;
+    CFITSIO_KEYWORD *fitskeys = NULL;
+    struct stat stBuf;
    char dir[DRMS_MAXPATHLEN];
    char fmtname[DRMS_MAXPATHLEN];
    char fullfname[DRMS_MAXPATHLEN];
@@ -362,8 +518,45 @@ static unsigned long long MapexportRecordToDir(DRMS_Record_t *recin, const char
       /* if we end up not having to perform an export, because the file to be exported has an up-to-date header, then
        * actualfname will be a link to the original up-to-date internal FITS file
        */
-      drmsstat = fitsexport_mapexport_tofile(segin, !lastcparms ? cparms[iseg] : NULL, classname, mapfile, fullfname, &actualfname, &expsize);
-      //       JEAFPrintLocalTime(stdout, "Done calling fitsexport_mapexport_tofile() from MapexportRecordToDir().");
+      if (cache)
+      {
+         cachekey = MkCacheKey(segin, tgtseg, !lastcparms ? cparms[iseg] : NULL, classname, mapfile, segfile, &protocol, &fitskeys);
+      }
+
+      if (cachekey && expcache_get(cache, cachekey, fullfname, &expsize) == kExpCacheStat_Success)
+      {
+         if (actualfname)
+         {
+            free(actualfname);
+         }
+
+         actualfname = strdup(fmtname);
+         drmsstat = DRMS_SUCCESS;
+      }
+      else if (cachekey)
+      {
+         /* a miss - the keywords were mapped for the key */
+         drmsstat = fitsexport_export_prepared_tofile(segfile, protocol, fitskeys, tgtseg, !lastcparms ? cparms[iseg] : NULL, fullfname, &actualfname, &expsize);
+
+         /* not a link to an up-to-date internal file - that costs nothing to make again */
+         if (drmsstat == DRMS_SUCCESS && strcmp(actualfname, fmtname) == 0 && lstat(fullfname, &stBuf) == 0 && S_ISREG(stBuf.st_mode))
+         {
+            expcache_put(cache, cachekey, fullfname);
+         }
+      }
+      else
+      {
+         drmsstat = fitsexport_mapexport_tofile(segin, !lastcparms ? cparms[iseg] : NULL, classname, mapfile, fullfname, &actualfname, &expsize);
+         //       JEAFPrintLocalTime(stdout, "Done calling fitsexport_mapexport_tofile() from MapexportRecordToDir().");
+      }
+
+      if (cachekey)
+      {
+         free(cachekey);
+         cachekey = NULL;
+         cfitsio_free_keys(&fitskeys);
+      }
+
       if (drmsstat == DRMS_ERROR_INVALIDFILE)
       {
          /* No input segment file. */
@@ -616,7 +809,7 @@ static int fetch_linked_segments(DRMS_Env_t *env, DRMS_Record_t *template_record
     return b_fetch_linked_segments;
 }
 
-static unsigned long long MapexportToDir(DRMS_Env_t *env, const char *rsinquery, const char *ffmt, const char *outpath, FILE *pklist, const char *classname, const char *mapfile, int *tcount, TIME *exptime, const char **cparms, MymodError_t *status)
+static unsigned long long MapexportToDir(DRMS_Env_t *env, const char *rsinquery, const char *ffmt, const char *outpath, FILE *pklist, const char *classname, const char *mapfile, int *tcount, TIME *exptime, const char **cparms, ExpCache_t *cache, MymodError_t *status)
 {
     int stat = DRMS_SUCCESS;
     MymodError_t modstat = kMymodErr_Success;
@@ -694,7 +887,7 @@ static unsigned long long MapexportToDir(DRMS_Env_t *env, const char *rsinquery,
                     }
 
                     count = 0;
-                    tsize += MapexportRecordToDir(recin, ffmt, outpath, pklist, classname, mapfile, &count, cparms, &modstat, NULL);
+                    tsize += MapexportRecordToDir(recin, ffmt, outpath, pklist, classname, mapfile, &count, cparms, cache, &modstat, NULL);
 
                     if (modstat == kMymodErr_Success)
                     {
@@ -833,6 +1026,10 @@ int DoIt(void)
     const char *cparmsarg = NULL;
     const char **cparms = NULL;
     int RecordLimit = 0;
+    const char *cachedir = NULL;
+    int cachesize = 0;
+    ExpCache_t cachebuf;
+    ExpCache_t *cache = NULL;
 
     /* "packing list" header/metadata */
     char *md_version = NULL;
@@ -846,6 +1043,9 @@ int DoIt(void)
                          * before they are downloaded by the user */
     char *md_status = NULL;
     char *md_error = NULL;
+    char md_cachehits[64];
+    char md_cachemisses[64];
+    char md_cachebytessaved[64];
 
     RecordLimit = cmdparams_get_int(&cmdparams, kArg_n, &drmsstat);
 
@@ -919,6 +1119,22 @@ int DoIt(void)
         }
     }
 
+    cachedir = cmdparams_get_str(&cmdparams, kArg_cachedir, &drmsstat);
+    if (drmsstat == DRMS_SUCCESS && strcmp(cachedir, kNotSpecified) != 0 && *cachedir != '\0')
+    {
+        cachesize = cmdparams_get_int(&cmdparams, kArg_cachesize, &drmsstat);
+
+        if (expcache_init(&cachebuf, cachedir, cachesize > 0 ? (unsigned long long)cachesize * kMB : 0) == kExpCacheStat_Success)
+        {
+            cache = &cachebuf;
+        }
+        else
+        {
+            /* not fatal - export without the cache */
+            fprintf(stderr, "Unable to use export cache '%s'.\n", cachedir);
+        }
+    }
+
     md_version = strdup(version);   /* Could be "NOT SPECIFIED". */
     md_reqid = strdup(reqid);       /* Could be "NOT SPECIFIED". */
     md_method = strdup(method);     /* Could be "NOT SPECIFIED". */
@@ -955,7 +1171,7 @@ int DoIt(void)
     {
         /* Call export code, filling in tsize, tcount, and exptime */
         tcount = RecordLimit;
-        tsize = MapexportToDir(drms_env, rsquery, ffmt, outpath, pklistTMP, clname, mapfile, &tcount, &exptime, cparms, &err);
+        tsize = MapexportToDir(drms_env, rsquery, ffmt, outpath, pklistTMP, clname, mapfile, &tcount, &exptime, cparms, cache, &err);
     }
     else
     {
@@ -993,6 +1209,18 @@ int DoIt(void)
 
     fprintf(stdout, "%lld megabytes exported.\n", tsizeMB);
 
+    if (cache)
+    {
+        fprintf(stdout, "export cache: %llu hits, %llu misses (hit ratio %.2f), %llu bytes saved, %llu bytes added.\n", cache->hits, cache->misses, expcache_hitratio(cache), cache->bytessaved, cache->bytesstored);
+
+        /* the files this export got from the cache are now the most recently used */
+        expcache_trim(cache);
+
+        snprintf(md_cachehits, sizeof(md_cachehits), "%llu", cache->hits);
+        snprintf(md_cachemisses, sizeof(md_cachemisses), "%llu", cache->misses);
+        snprintf(md_cachebytessaved, sizeof(md_cachebytessaved), "%llu", cache->bytessaved);
+    }
+
     /* open 'real' pack list */
     if (strcmp(reqid, kNotSpecified) != 0)
     {
@@ -1047,6 +1275,13 @@ int DoIt(void)
             WritePListRecord(kPL_metadata, pklist, drms_defs_getval("kMD_Dir"), md_dir ? md_dir : "");
             WritePListRecord(kPL_metadata, pklist, drms_defs_getval("kMD_Status"), md_status);
 
+            if (cache)
+            {
+                WritePListRecord(kPL_metadata, pklist, drms_defs_getval("kMD_CacheHits"), md_cachehits);
+                WritePListRecord(kPL_metadata, pklist, drms_defs_getval("kMD_CacheMisses"), md_cachemisses);
+                WritePListRecord(kPL_metadata, pklist, drms_defs_getval("kMD_CacheBytesSaved"), md_cachebytessaved);
+            }
+
             /* If the proc-steps.txt file exists, put the contents in the packing list. */
             snprintf(procSteps, sizeof(procSteps), "%s/proc-steps.txt", md_dir);
             if (stat(procSteps, &stBuf) == 0)
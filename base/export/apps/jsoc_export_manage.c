@@ -88,6 +88,18 @@
 
   --> a request is complete at the end of the qsub script
 
+  LOCAL RUNNER (runner=local):
+  The qsub script is not submitted to the cluster - it is run on this host, detached from jsoc_export_manage, with its
+  output appended to the same runlog. The scripts and the status lifecycle above are unchanged, so no qsub is needed
+  to run exports on a single host. A <RequestID>.lrun file in logdir holds the pid of each running script and its
+  requestor; on each pass, at most maxjobs requests run at a time, and at most maxuserjobs of one requestor. Requests
+  over these limits are left in jsoc.export_new (status 2) for a later pass, in their original order.
+
+  EXPORT CACHE (cachedir=<dir>):
+  The jsoc_export_as_fits commands get cachedir and cachesize, so the FITS files they make are kept in, and reused
+  from, a cache shared by all requests (see jsoc_export_as_fits). The cache directory must be writable by the
+  export scripts, and on the same file system as the export SUs so that cached files are hard-linked, not copied.
+
   DEVELOPMENT:
   1. Ensure you have run jsoc_fetch with the -t flag so that the row in jsoc.export_new has status == 12 (to create a dev row);
   2. Run jsoc_export_manage AS LINUX USER production like this:
@@ -100,6 +112,10 @@
 #include "drms_names.h"
 #include "json.h"
 #include "serverdefs.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
 
 #define EXPORT_SERIES "jsoc.export"
 #define EXPORT_SERIES_NEW "jsoc.export_new"
@@ -115,6 +131,15 @@
 
 #define kArgQsubInitScript "q-init-script"
 #define kArgValQsubInitScript "/SGE2/default/common/settings.sh"
+#define kArgRunner "runner"
+#define kArgValRunnerQsub "qsub"
+#define kArgValRunnerLocal "local"
+#define kArgMaxJobs "maxjobs"
+#define kArgMaxUserJobs "maxuserjobs"
+#define kArgExpCacheDir "cachedir"
+#define kArgExpCacheSize "cachesize"
+
+#define kLocalRunSuffix ".lrun"
 
 #define kMaxProcNameLen 128
 #define kMaxIntVar 64
@@ -219,6 +244,11 @@ ModuleArgs_t module_args[] =
     {ARG_STRING, kArgTestConvQuotes, kArgValNotUsed, "Put a record-set query in here to test the code that converts double-quoted strings to single-quoted strings."},
     {ARG_STRING, kArgLogDir, "/home/jsoc/exports/tmp", "The temporary directory for the jsoc_export_manage processing log for the requests."},
     {ARG_STRING, kArgQsubInitScript, kArgValQsubInitScript, "Run this script to initialize the enviornment for qsub-script submission."},
+    {ARG_STRING, kArgRunner, kArgValRunnerQsub, "How the export scripts are run: qsub - submitted to the cluster; local - run on this host."},
+    {ARG_INT, kArgMaxJobs, "8", "runner=local only - the maximum number of export requests running at a time."},
+    {ARG_INT, kArgMaxUserJobs, "2", "runner=local only - the maximum number of export requests of a single requestor running at a time."},
+    {ARG_STRING, kArgExpCacheDir, kArgValNotUsed, "The export cache jsoc_export_as_fits keeps exported FITS files in; by default there is no cache."},
+    {ARG_INT, kArgExpCacheSize, "102400", "The export-cache size limit in MB."},
     {ARG_FLAG, kArgTestmode, NULL, "if set, then operates on new requests with status 12 (not 2)"},
     {ARG_FLAG, "h", "0", "help - show usage"},
     {ARG_END}
@@ -231,6 +261,9 @@ char *module_name = "jsoc_export_manage";
 HContainer_t *gIntVars = NULL;
 HContainer_t *gShVars = NULL;
 
+/* the export-cache arguments appended to the jsoc_export_as_fits command line, or "" */
+char gExpCacheArgs[PATH_MAX + 64] = {0};
+
 #define WriteLog(fh, ...) __WriteLog(__FILE__, __LINE__, fh, __VA_ARGS__)
 
 static void __WriteLog(const char *file, int lineno, FILE *fh, ...)
@@ -885,6 +918,193 @@ static void make_qsub_call(char *requestid, /* like JSOC_20120906_199_IN*/
     chmod(qsubscript, 0555);
   }
 
+/* requests being run by the local runner, in total and by requestor */
+struct LocalRuns_struct
+{
+    int total;
+    HContainer_t *byuser; /* requestor id -> number of running requests (int) */
+};
+
+typedef struct LocalRuns_struct LocalRuns_t;
+
+static int LocalRunsFor(LocalRuns_t *runs, int requestorid)
+{
+    char key[32];
+    int *count = NULL;
+
+    snprintf(key, sizeof(key), "%d", requestorid);
+    count = runs->byuser ? (int *)hcon_lookup(runs->byuser, key) : NULL;
+
+    return count ? *count : 0;
+}
+
+static void AddLocalRun(LocalRuns_t *runs, int requestorid)
+{
+    char key[32];
+    int *count = NULL;
+
+    if (!runs->byuser)
+    {
+        runs->byuser = hcon_create(sizeof(int), sizeof(key), NULL, NULL, NULL, NULL, 0);
+    }
+
+    runs->total++;
+
+    if (runs->byuser)
+    {
+        snprintf(key, sizeof(key), "%d", requestorid);
+        if ((count = (int *)hcon_lookup(runs->byuser, key)) != NULL)
+        {
+            (*count)++;
+        }
+        else
+        {
+            count = (int *)hcon_allocslot(runs->byuser, key);
+            *count = 1;
+        }
+    }
+}
+
+static void FreeLocalRuns(LocalRuns_t *runs)
+{
+    if (runs->byuser)
+    {
+        hcon_destroy(&runs->byuser);
+    }
+
+    runs->total = 0;
+}
+
+/* count the requests still running from earlier passes - the <requestid>.lrun files in logdir whose process is
+ * alive; the files of finished requests are removed */
+static void CountLocalRuns(const char *logdir, LocalRuns_t *runs)
+{
+    DIR *dirp = NULL;
+    struct dirent *dp = NULL;
+    char path[PATH_MAX];
+    size_t len;
+    FILE *fp = NULL;
+    long pid;
+    int requestorid;
+    int nread;
+
+    if ((dirp = opendir(logdir)) == NULL)
+    {
+        return;
+    }
+
+    while ((dp = readdir(dirp)) != NULL)
+    {
+        len = strlen(dp->d_name);
+        if (len <= strlen(kLocalRunSuffix) || strcmp(dp->d_name + len - strlen(kLocalRunSuffix), kLocalRunSuffix) != 0)
+        {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "%s/%s", logdir, dp->d_name);
+        nread = 0;
+        if ((fp = fopen(path, "r")) != NULL)
+        {
+            nread = fscanf(fp, "%ld %d", &pid, &requestorid);
+            fclose(fp);
+        }
+
+        if (nread == 2 && pid > 0 && (kill((pid_t)pid, 0) == 0 || errno == EPERM))
+        {
+            AddLocalRun(runs, requestorid);
+        }
+        else
+        {
+            unlink(path);
+        }
+    }
+
+    closedir(dirp);
+}
+
+/* run REQDIR/<requestid>.qsub on this host, in its own session, with stdout and stderr appended to the runlog the
+ * qsub command would have used; the pid of the script is written to logdir/<requestid>.lrun before this returns;
+ * returns 1 on error */
+static int RunLocal(const char *logdir, const char *requestid, const char *reqdir, int requestorid, const char *jsocroot)
+{
+    char script[DRMS_MAXPATHLEN];
+    char runlog[DRMS_MAXPATHLEN];
+    char lrun[PATH_MAX];
+    pid_t pid;
+    pid_t runpid;
+    int fd;
+    int wstatus = 0;
+    FILE *fp = NULL;
+
+    snprintf(script, sizeof(script), "%s/%s.qsub", reqdir, requestid);
+    snprintf(runlog, sizeof(runlog), "/home/jsoc/exports/tmp/%s.runlog", requestid);
+    snprintf(lrun, sizeof(lrun), "%s/%s%s", logdir, requestid, kLocalRunSuffix);
+
+    fflush(stdout);
+    fflush(stderr);
+
+    pid = fork();
+    if (pid == -1)
+    {
+        fprintf(stderr, "unable to start local export run for %s\n", requestid);
+        return 1;
+    }
+
+    if (pid == 0)
+    {
+        /* detach from jsoc_export_manage (which exits before the script is done); the intermediate process exits
+         * right away, so the script is never a child of jsoc_export_manage */
+        setsid();
+
+        runpid = fork();
+        if (runpid == 0)
+        {
+            fd = open("/dev/null", O_RDONLY);
+            if (fd != -1)
+            {
+                dup2(fd, STDIN_FILENO);
+                close(fd);
+            }
+
+            fd = open(runlog, O_WRONLY | O_CREAT | O_APPEND, 0644);
+            if (fd != -1)
+            {
+                dup2(fd, STDOUT_FILENO);
+                dup2(fd, STDERR_FILENO);
+                close(fd);
+            }
+
+            /* what qsub -v does */
+            if (jsocroot)
+            {
+                setenv("JSOCROOT_EXPORT", jsocroot, 1);
+            }
+
+            execl(script, script, (char *)NULL);
+            fprintf(stderr, "unable to run %s\n", script);
+            _exit(1);
+        }
+
+        if (runpid > 0 && (fp = fopen(lrun, "w")) != NULL)
+        {
+            fprintf(fp, "%ld %d\n", (long)runpid, requestorid);
+            fclose(fp);
+        }
+
+        _exit(runpid > 0 ? 0 : 1);
+    }
+
+    while (waitpid(pid, &wstatus, 0) == -1 && errno == EINTR);
+
+    if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0)
+    {
+        fprintf(stderr, "unable to start local export run for %s\n", requestid);
+        return 1;
+    }
+
+    return 0;
+}
+
 // Security testing.  Make sure DataSet does not contain attempt to run program
 //   example: look out for chars that end dataset spec and give command.
 int isbadDataSet()
@@ -3313,7 +3533,7 @@ static int GenExpFitsCmd(FILE *fptr,
             rssArgEsc = escapeArgument(rssArgConv);
             if (rssArgEsc)
             {
-                fprintf(fptr, "jsoc_export_as_fits JSOC_DBHOST=%s reqid='%s' expversion=%s rsquery=%s n=%s path=$REQDIR ffmt='%s' method='%s' protocol='%s' %s\n", dbmainhost, requestid, PACKLIST_VER, rssArgEsc, RecordLimit, filenamefmt, method, protos[kProto_FITS], dbids);
+                fprintf(fptr, "jsoc_export_as_fits JSOC_DBHOST=%s reqid='%s' expversion=%s rsquery=%s n=%s path=$REQDIR ffmt='%s' method='%s' protocol='%s' %s%s\n", dbmainhost, requestid, PACKLIST_VER, rssArgEsc, RecordLimit, filenamefmt, method, protos[kProto_FITS], dbids, gExpCacheArgs);
                 free(rssArgEsc);
             }
             else
@@ -3682,6 +3902,12 @@ int DoIt(void)
     char logdir[PATH_MAX];
     const char *logdirArg = NULL;
     const char *qsubInitScript = NULL;
+    const char *runner = NULL;
+    int runLocal = 0;
+    int maxJobs = 0;
+    int maxUserJobs = 0;
+    const char *expCacheDir = NULL;
+    LocalRuns_t localRuns = {0, NULL};
     const char *testQuotes = NULL;
     FILE *emLogFH = NULL;
     char *quoted = NULL;
@@ -3702,6 +3928,26 @@ int DoIt(void)
 
     qsubInitScript = cmdparams_get_str(&cmdparams, kArgQsubInitScript, NULL);
 
+    runner = cmdparams_get_str(&cmdparams, kArgRunner, NULL);
+    if (strcasecmp(runner, kArgValRunnerLocal) == 0)
+    {
+        runLocal = 1;
+    }
+    else if (strcasecmp(runner, kArgValRunnerQsub) != 0)
+    {
+        fprintf(stderr, "invalid runner '%s'\n", runner);
+        return 1;
+    }
+
+    maxJobs = cmdparams_get_int(&cmdparams, kArgMaxJobs, NULL);
+    maxUserJobs = cmdparams_get_int(&cmdparams, kArgMaxUserJobs, NULL);
+
+    expCacheDir = cmdparams_get_str(&cmdparams, kArgExpCacheDir, NULL);
+    if (strcmp(expCacheDir, kArgValNotUsed) != 0 && *expCacheDir != '\0')
+    {
+        snprintf(gExpCacheArgs, sizeof(gExpCacheArgs), " cachedir='%s' cachesize=%d", expCacheDir, cmdparams_get_int(&cmdparams, kArgExpCacheSize, NULL));
+    }
+
     testQuotes = cmdparams_get_str(&cmdparams, kArgTestConvQuotes, NULL);
     if (testQuotes)
     {
@@ -3818,6 +4064,11 @@ int DoIt(void)
 
             drms_close_records(exports_new_orig, DRMS_FREE_RECORD);
 
+            if (runLocal)
+            {
+                CountLocalRuns(logdir, &localRuns);
+            }
+
             for (irec=0; irec < exports_new->n; irec++)
             {
                 now = timenow();
@@ -3856,6 +4107,22 @@ int DoIt(void)
                 printf("New Request #%d/%d: %s, Status=%d, Processing=%s, DataSet=%s, Protocol=%s, Method=%s\n", irec, exports_new->n, requestid, status, process, dataset, protocol, method);
                 fflush(stdout);
 
+                if (runLocal)
+                {
+                    /* requests over the limits stay in jsoc.export_new, untouched, for a later pass */
+                    if (localRuns.total >= maxJobs)
+                    {
+                        printf("%d requests running; request %s and the ones after it wait for a later pass\n", localRuns.total, requestid);
+                        break;
+                    }
+
+                    if (LocalRunsFor(&localRuns, requestorid) >= maxUserJobs)
+                    {
+                        printf("requestor %d has %d requests running; request %s waits for a later pass\n", requestorid, LocalRunsFor(&localRuns, requestorid), requestid);
+                        continue;
+                    }
+                }
+
 
                 /* open log file for writing */
                 snprintf(logfile, sizeof(logfile), "%s/%s.emlog", logdir, requestid);
@@ -4713,10 +4980,13 @@ int DoIt(void)
           chmod(runscript, 0555);
 
           // SU now contains both qsub script and drms_run script, ready to execute and lock the record.
-          snprintf(command, sizeof(command), "source %s; qsub -q exp.q -v %s -o /home/jsoc/exports/tmp/%s.runlog -e /home/jsoc/exports/tmp/%s.runlog %s/%s.qsub", qsubInitScript, jsocrootstr, requestid, requestid, reqdir, requestid);
+          if (!runLocal)
+          {
+              snprintf(command, sizeof(command), "source %s; qsub -q exp.q -v %s -o /home/jsoc/exports/tmp/%s.runlog -e /home/jsoc/exports/tmp/%s.runlog %s/%s.qsub", qsubInitScript, jsocrootstr, requestid, requestid, reqdir, requestid);
 
-          printf(command);
-          printf("\n");
+              printf(command);
+              printf("\n");
+          }
       /*
       	"  >>& /home/jsoc/exports/tmp/%s.runlog",
       */
@@ -4726,8 +4996,19 @@ int DoIt(void)
            */
           CloseWriteLog(emLogFH);
 
+          if (runLocal)
+          {
+              /* RUN qsub SCRIPT ON THIS HOST */
+              if (RunLocal(logdir, requestid, reqdir, requestorid, jsocroot))
+              {
+                  return DBCOMM(&export_rec, "Start of local export run failed", 4);
+                  // Cannot get here.
+              }
+
+              AddLocalRun(&localRuns, requestorid);
+          }
           /* SUBMIT qsub SCRIPT */
-          if (system(command))
+          else if (system(command))
           {
               return DBCOMM(&export_rec, "Submission of qsub command failed", 4);
               // Cannot get here.
@@ -4766,6 +5047,7 @@ int DoIt(void)
 
             // Free all jsoc.export_new records that never got inserted (the remainder had failures).
             drms_close_records(exports_new, DRMS_FREE_RECORD); // jsoc.export_new
+            FreeLocalRuns(&localRuns);
 
             return(0); /* normal, good exit */
             break;
@@ -277,7 +277,7 @@ int quick_export_rs( json_t *jroot, DRMS_RecordSet_t *rs, int online,  long long
       free(jsonstr);
       json_insert_child(data, recobj);
       }
-    free(hit);
+    hiter_destroy(&hit);
     }
   if (jroot) // i.e. if dojson, else will be NULL for the dotxt case.
     {
@@ -491,238 +491,282 @@ FE_Keyword_ExtType_t fitsexport_get_external_type(const char *cast_str)
     return type;
 }
 
-/* parse a DRMS_Keyword_t into pieces that can be used to construct a CFITSIO_KEYWORD; the resulting
- * CFITSIO_KEYWORD is for export purposes only; the DRMS_Keyword_t::description will be shortened
- * so that it will fit on a FITS card and returned in `short_comment_out` */
-static int DRMSKeyValToFITSKeyVal(DRMS_Keyword_t *key, const char *braced_informaton, const char *comment_external_in, cfitsio_keyword_datatype_t *fitstype, int *number_bytes, void **fitsval, char **format, char **short_comment_out, char **unit)
+/* the value-independent part of DRMSKeyValToFITSKeyVal() - the FITS type, size, format, and short comment of key, and the
+ * type that the value is cast to */
+static int DescribeFITSKey(DRMS_Keyword_t *key, const char *braced_informaton, const char *comment_external_in, cfitsio_keyword_datatype_t *fitstype, int *number_bytes, FE_Keyword_ExtType_t *external_type_out, char **format, char **short_comment_out)
 {
    int err = 0;
    const char *comment_to_parse = NULL;
    char *cast_type = NULL;
-   DRMS_Type_Value_t *valin = &key->value;
-   DRMS_Value_t type_and_value;
-   char unit_new[CFITSIO_MAX_COMMENT] = {0};
-   void *res = NULL;
-   int status = DRMS_SUCCESS;
    FE_Keyword_ExtType_t external_type = kFE_Keyword_ExtType_None;
 
-    if (valin && fitstype && format)
+    if (format)
     {
-        if (format)
+        *format = strdup(key->info->format);
+        if (!*format)
         {
-            *format = strdup(key->info->format);
-            if (!*format)
-            {
-                err = 1;
-                fprintf(stderr, "[ DRMSKeyValToFITSKeyVal() ] out of memory\n");
-            }
+            err = 1;
+            fprintf(stderr, "[ DRMSKeyValToFITSKeyVal() ] out of memory\n");
         }
+    }
 
-        if (!err)
+    if (!err)
+    {
+        if (comment_external_in && *comment_external_in != '\0')
         {
-            if (comment_external_in && *comment_external_in != '\0')
-            {
-                comment_to_parse = comment_external_in;
-            }
-            else
-            {
-                comment_to_parse = key->info->description;
-            }
-
-            err = parse_keyword_description(comment_to_parse, NULL, NULL, NULL, &cast_type);
+            comment_to_parse = comment_external_in;
+        }
+        else
+        {
+            comment_to_parse = key->info->description;
         }
 
-        if (!err)
+        err = parse_keyword_description(comment_to_parse, NULL, NULL, NULL, &cast_type);
+    }
+
+    if (!err)
+    {
+        if (cast_type && *cast_type != '\0')
         {
-            if (cast_type && *cast_type != '\0')
-            {
-                external_type = fitsexport_get_external_type(cast_type);
-            }
+            external_type = fitsexport_get_external_type(cast_type);
         }
+    }
 
-        if (!err)
+    if (!err)
+    {
+        if (short_comment_out)
         {
-            if (short_comment_out)
+            if (*comment_to_parse != '\0')
             {
-                if (*comment_to_parse != '\0')
-                {
-                    /* allocs *short_comment_out */
-                    err = parse_short_comment(comment_to_parse, braced_informaton, short_comment_out);
-                }
-                else
-                {
-                    *short_comment_out = NULL;
-                }
+                /* allocs *short_comment_out */
+                err = parse_short_comment(comment_to_parse, braced_informaton, short_comment_out);
+            }
+            else
+            {
+                *short_comment_out = NULL;
             }
         }
+    }
 
-        if (!err)
+    if (!err)
+    {
+        /* determine number of bytes for value */
+        if (fitstype)
         {
-            /* determine number of bytes for value */
-            if (fitstype)
+            if (external_type == kFE_Keyword_ExtType_None)
             {
-                if (external_type == kFE_Keyword_ExtType_None)
+                err = DRMSKeyTypeToFITSKeyType(key->info->type, fitstype);
+                if (!err)
                 {
-                    err = DRMSKeyTypeToFITSKeyType(key->info->type, fitstype);
-                    if (!err)
+                    if (number_bytes)
                     {
-                        if (number_bytes)
+                        if (key->info->type == DRMS_TYPE_CHAR)
                         {
-                            if (key->info->type == DRMS_TYPE_CHAR)
-                            {
-                                *number_bytes = 1;
-                            }
-                            else if (key->info->type == DRMS_TYPE_SHORT)
-                            {
-                                *number_bytes = 2;
-                            }
-                            else if (key->info->type == DRMS_TYPE_INT)
-                            {
-                                *number_bytes = 4;
-                            }
-                            else if (key->info->type == DRMS_TYPE_LONGLONG)
-                            {
-                                *number_bytes = 8;
-                            }
-                            else if (key->info->type == DRMS_TYPE_FLOAT)
-                            {
-                                *number_bytes = 4;
-                            }
-                            else if (key->info->type == DRMS_TYPE_DOUBLE)
-                            {
-                                *number_bytes = 8;
-                            }
-                            else if (key->info->type == DRMS_TYPE_TIME)
-                            {
-                                *number_bytes = 8;
-                            }
+                            *number_bytes = 1;
                         }
-                    }
-                }
-                else
-                {
-                    err = FE_cast_type_to_fits_key_type(external_type, fitstype);
-
-                    if (!err)
-                    {
-                        /* if we casted to an int or float type, use max bytes */
-                        if (*fitstype == CFITSIO_KEYWORD_DATATYPE_INTEGER || *fitstype == CFITSIO_KEYWORD_DATATYPE_FLOAT)
+                        else if (key->info->type == DRMS_TYPE_SHORT)
+                        {
+                            *number_bytes = 2;
+                        }
+                        else if (key->info->type == DRMS_TYPE_INT)
+                        {
+                            *number_bytes = 4;
+                        }
+                        else if (key->info->type == DRMS_TYPE_LONGLONG)
+                        {
+                            *number_bytes = 8;
+                        }
+                        else if (key->info->type == DRMS_TYPE_FLOAT)
+                        {
+                            *number_bytes = 4;
+                        }
+                        else if (key->info->type == DRMS_TYPE_DOUBLE)
+                        {
+                            *number_bytes = 8;
+                        }
+                        else if (key->info->type == DRMS_TYPE_TIME)
                         {
                             *number_bytes = 8;
                         }
                     }
                 }
             }
-        }
-
-        if (!err)
-        {
-            /* determine FITS keyword value */
-            /* if valin is the missing value, then the output value should be NULL */
-            type_and_value.type = key->info->type;
-            type_and_value.value = *valin;
-
-            if (valin && drms_ismissing(&type_and_value))
-            {
-                res = NULL;
-            }
             else
             {
-                /* If the keyword being exported to FITS is a reserved keyword, then
-                 * drop into specialized code to handle that reserved keyword. */
-                if (external_type != kFE_Keyword_ExtType_None)
+                err = FE_cast_type_to_fits_key_type(external_type, fitstype);
+
+                if (!err)
                 {
-                    /* cast specified in key's description field */
-                    if (key->info->type != DRMS_TYPE_RAW)
-                    {
-                        switch (external_type)
-                        {
-                           case kFE_Keyword_ExtType_Integer:
-                             res = malloc(sizeof(long long));
-                             *(long long *)res = drms2int(key->info->type, valin, &status);
-                             break;
-                           case kFE_Keyword_ExtType_Float:
-                             res = malloc(sizeof(double));
-                             *(double *)res = drms2double(key->info->type, valin, &status);
-                             break;
-                           case kFE_Keyword_ExtType_String:
-                           {
-                              char tbuf[1024];
-                              drms_keyword_snprintfval(key, tbuf, sizeof(tbuf));
-                              res = (void *)strdup(tbuf);
-                           }
-                           break;
-                           case kFE_Keyword_ExtType_Logical:
-                             res = malloc(sizeof(long long));
-
-                             if (drms2longlong(key->info->type, valin, &status))
-                             {
-                                *(long long *)res = 0;
-                             }
-                             else
-                             {
-                                *(long long *)res = 1;
-                             }
-                             break;
-                           default:
-                             fprintf(stderr, "[ DRMSKeyValToFITSKeyVal() ] unsupported FITS type '%d'\n", (int)external_type);
-                             err = 1;
-                             break;
-                        }
-                    }
-                    else
+                    /* if we casted to an int or float type, use max bytes */
+                    if (*fitstype == CFITSIO_KEYWORD_DATATYPE_INTEGER || *fitstype == CFITSIO_KEYWORD_DATATYPE_FLOAT)
                     {
-                        /* This shouldn't happen, unless somebody mucked with key->info->description. */
-                        fprintf(stderr, "[ DRMSKeyValToFITSKeyVal() ] DRMS_TYPE_RAW is not supported.\n");
-                        err = 1;
+                        *number_bytes = 8;
                     }
                 }
-                else
+            }
+        }
+    }
+
+    if (cast_type)
+    {
+        free(cast_type);
+        cast_type = NULL;
+    }
+
+    if (!err && external_type_out)
+    {
+        *external_type_out = external_type;
+    }
+
+    return err;
+}
+
+/* the per-record part of DRMSKeyValToFITSKeyVal() - key's value converted to the FITS type (NULL if the value is missing);
+ * unit_new is set if the value implies a unit other than key's */
+static int FITSKeyValue(DRMS_Keyword_t *key, FE_Keyword_ExtType_t external_type, void **fitsval, char *unit_new, size_t sz_unit_new)
+{
+   int err = 0;
+   DRMS_Type_Value_t *valin = &key->value;
+   DRMS_Value_t type_and_value;
+   void *res = NULL;
+   int status = DRMS_SUCCESS;
+
+    /* determine FITS keyword value */
+    /* if valin is the missing value, then the output value should be NULL */
+    type_and_value.type = key->info->type;
+    type_and_value.value = *valin;
+
+    if (valin && drms_ismissing(&type_and_value))
+    {
+        res = NULL;
+    }
+    else
+    {
+        /* If the keyword being exported to FITS is a reserved keyword, then
+         * drop into specialized code to handle that reserved keyword. */
+        if (external_type != kFE_Keyword_ExtType_None)
+        {
+            /* cast specified in key's description field */
+            if (key->info->type != DRMS_TYPE_RAW)
+            {
+                switch (external_type)
                 {
-                    /* default conversion */
-                    switch (key->info->type)
-                    {
-                      case DRMS_TYPE_CHAR:
-                        res = malloc(sizeof(long long));
-                        *(long long *)res = (long long)(valin->char_val);
-                        break;
-                      case DRMS_TYPE_SHORT:
-                        res = malloc(sizeof(long long));
-                        *(long long *)res = (long long)(valin->short_val);
-                        break;
-                      case DRMS_TYPE_INT:
-                        res = malloc(sizeof(long long));
-                        *(long long *)res = (long long)(valin->int_val);
-                        break;
-                      case DRMS_TYPE_LONGLONG:
-                        res = malloc(sizeof(long long));
-                        *(long long *)res = valin->longlong_val;
-                        break;
-                      case DRMS_TYPE_FLOAT:
-                        res = malloc(sizeof(double));
-                        *(double *)res = (double)(valin->float_val);
-                        break;
-                      case DRMS_TYPE_DOUBLE:
-                        res = malloc(sizeof(double));
-                        *(double *)res = valin->double_val;
-                        break;
-                      case DRMS_TYPE_TIME:
-                      {
-                         char tbuf[1024];
-                         FE_print_time_keyword(key, tbuf, sizeof(tbuf), unit_new, sizeof(unit_new));
-                         res = (void *)strdup(tbuf);
-                      }
-                      break;
-                      case DRMS_TYPE_STRING:
-                        res = (void *)strdup(valin->string_val);
-                        break;
-                      default:
-                        fprintf(stderr, "[ DRMSKeyValToFITSKeyVal() ] unsupported DRMS type '%d'\n", (int)key->info->type);
-                        err = 1;
-                        break;
-                    }
+                   case kFE_Keyword_ExtType_Integer:
+                     res = malloc(sizeof(long long));
+                     *(long long *)res = drms2int(key->info->type, valin, &status);
+                     break;
+                   case kFE_Keyword_ExtType_Float:
+                     res = malloc(sizeof(double));
+                     *(double *)res = drms2double(key->info->type, valin, &status);
+                     break;
+                   case kFE_Keyword_ExtType_String:
+                   {
+                      char tbuf[1024];
+                      drms_keyword_snprintfval(key, tbuf, sizeof(tbuf));
+                      res = (void *)strdup(tbuf);
+                   }
+                   break;
+                   case kFE_Keyword_ExtType_Logical:
+                     res = malloc(sizeof(long long));
+
+                     if (drms2longlong(key->info->type, valin, &status))
+                     {
+                        *(long long *)res = 0;
+                     }
+                     else
+                     {
+                        *(long long *)res = 1;
+                     }
+                     break;
+                   default:
+                     fprintf(stderr, "[ DRMSKeyValToFITSKeyVal() ] unsupported FITS type '%d'\n", (int)external_type);
+                     err = 1;
+                     break;
                 }
             }
+            else
+            {
+                /* This shouldn't happen, unless somebody mucked with key->info->description. */
+                fprintf(stderr, "[ DRMSKeyValToFITSKeyVal() ] DRMS_TYPE_RAW is not supported.\n");
+                err = 1;
+            }
+        }
+        else
+        {
+            /* default conversion */
+            switch (key->info->type)
+            {
+              case DRMS_TYPE_CHAR:
+                res = malloc(sizeof(long long));
+                *(long long *)res = (long long)(valin->char_val);
+                break;
+              case DRMS_TYPE_SHORT:
+                res = malloc(sizeof(long long));
+                *(long long *)res = (long long)(valin->short_val);
+                break;
+              case DRMS_TYPE_INT:
+                res = malloc(sizeof(long long));
+                *(long long *)res = (long long)(valin->int_val);
+                break;
+              case DRMS_TYPE_LONGLONG:
+                res = malloc(sizeof(long long));
+                *(long long *)res = valin->longlong_val;
+                break;
+              case DRMS_TYPE_FLOAT:
+                res = malloc(sizeof(double));
+                *(double *)res = (double)(valin->float_val);
+                break;
+              case DRMS_TYPE_DOUBLE:
+                res = malloc(sizeof(double));
+                *(double *)res = valin->double_val;
+                break;
+              case DRMS_TYPE_TIME:
+              {
+                 char tbuf[1024];
+                 FE_print_time_keyword(key, tbuf, sizeof(tbuf), unit_new, sz_unit_new);
+                 res = (void *)strdup(tbuf);
+              }
+              break;
+              case DRMS_TYPE_STRING:
+                res = (void *)strdup(valin->string_val);
+                break;
+              default:
+                fprintf(stderr, "[ DRMSKeyValToFITSKeyVal() ] unsupported DRMS type '%d'\n", (int)key->info->type);
+                err = 1;
+                break;
+            }
+        }
+    }
+
+    if (!err)
+    {
+        *fitsval = res;
+    }
+    else if (res)
+    {
+        free(res);
+    }
+
+    return err;
+}
+
+/* parse a DRMS_Keyword_t into pieces that can be used to construct a CFITSIO_KEYWORD; the resulting
+ * CFITSIO_KEYWORD is for export purposes only; the DRMS_Keyword_t::description will be shortened
+ * so that it will fit on a FITS card and returned in `short_comment_out` */
+static int DRMSKeyValToFITSKeyVal(DRMS_Keyword_t *key, const char *braced_informaton, const char *comment_external_in, cfitsio_keyword_datatype_t *fitstype, int *number_bytes, void **fitsval, char **format, char **short_comment_out, char **unit)
+{
+   int err = 0;
+   DRMS_Type_Value_t *valin = &key->value;
+   char unit_new[CFITSIO_MAX_COMMENT] = {0};
+   FE_Keyword_ExtType_t external_type = kFE_Keyword_ExtType_None;
+
+    if (valin && fitstype && format)
+    {
+        err = DescribeFITSKey(key, braced_informaton, comment_external_in, fitstype, number_bytes, &external_type, format, short_comment_out);
+
+        if (!err)
+        {
+            err = FITSKeyValue(key, external_type, fitsval, unit_new, sizeof(unit_new));
 
             if (!err)
             {
@@ -756,12 +800,6 @@ static int DRMSKeyValToFITSKeyVal(DRMS_Keyword_t *key, const char *braced_inform
         err = 1;
     }
 
-
-    if (!err)
-    {
-        *fitsval = res;
-    }
-
     return err;
 }
 
@@ -1731,497 +1769,527 @@ int fitsexport_mapexport_data_tofile(DRMS_Segment_t *output_segment, DRMS_Array_
     return drms_status;
 }
 
-int fitsexport_mapexport_tofile2(DRMS_Record_t *rec, DRMS_Segment_t *seg, long long row_number, const char *cparms, /* NULL for stdout */ const char *clname, const char *mapfile, const char *fileout, /* "-" for stdout */ char **actualfname, /* NULL for stdout */ unsigned long long *expsize, /* NULL for stdout */ export_callback_func_t callback) //ISS fly-tar - fitsfile * for stdout
+/* The FITS-image part of fitsexport_mapexport_tofile2(): combines the image in the segment file filename with the
+ * FITS keywords fitskeys, and writes the result to realfileout, to the callback's fitsfile, or, if streaming, to the
+ * in-memory CFITSIO_FILE that is callback. Uses only CFITSIO, not DRMS. */
+static int ExportFITSImage(const char *filename, CFITSIO_KEYWORD *fitskeys, const char *cparms, DRMS_Segment_t *actualSeg, const char *realfileout, int streaming, export_callback_func_t callback)
 {
     int status = DRMS_SUCCESS;
-    CFITSIO_KEYWORD *fitskeys = NULL; int num_keys = 0;
-    LinkedList_t *ttypes = NULL;
-    LinkedList_t *tforms = NULL;
-    char *ttype = NULL;
-    char *tform = NULL;
-    char filename[DRMS_MAXPATHLEN];
-    struct stat stbuf;
-    DRMS_Segment_t *tgtseg = NULL;
-    DRMS_Segment_t *actualSeg = NULL;
-    char realfileout[DRMS_MAXPATHLEN];
     char file_specification[DRMS_MAXPATHLEN]; /* <fits file> [ '[' <fits compression specification> ']' ] */
     CFITSIO_FILE *out_file = NULL; /* exported fitsfile; if streaming, then this is also in-memory-only, otherwise
                                     * when closed, the fitsfile will be written to disk (to realfileout) */
     int close_out_file = 0; /* if we are streaming or using the callback method, then do not close out_file */
-    struct stat filestat;
-    int streaming = 0;
-    int keywords_only = 0;
-    int swval;
-    CFITSIO_BINTABLE_INFO *bintable_info = NULL;
-    LinkedList_t *bintable_rows = NULL;
-    long long column_index = -1;
-    ListNode_t *node = NULL;
-
-    streaming = (strcmp(fileout, "-") == 0);
-    keywords_only = (seg == NULL);
 
-    if (!keywords_only)
+    /* If the segment file is compressed, and will be exported in compressed
+     * format, don't uncompress it (which is what drms_segment_read() will do).
+     * Instead, use the cfitsio routines to read the image into memory, as is -
+     * so compressed image data will remain compressed in memory. Then
+     * combine the header and image into a new FITS file and write it to
+     * the fileout. Steps:
+     *   1. Use CopyFile() to copy the input segment file to fileout.
+     *   2. Call fits_open_image() to open the file for writing. This does not
+     *      read the image into memory.
+     *   3. Call cfitsio_key_to_card()/fits_write_record() to write keywords.
+     *   4. Call fits_write_img().
+     * It is probably best to use some modified version of fitsrw_write() that
+     * simply replaces keywords - it deletes all existing keywords and
+     * takes a keylist of keys to add to the image.
+     *
+     * Try to use the libfitsrw routines which automatically cache open
+     * fitsfile pointers and calculate checksums, etc. */
+    int file_is_up_to_date = 0;
+    char sums_file[PATH_MAX];
+    int has_longwarn = 0;
+    int has_headsum = 0;
+    char *old_headsum = NULL;
+    char *new_headsum = NULL;
+    CFITSIO_FILE *disk_file = NULL; /* in-memory-only fitsfile of existing file on disk */
+    CFITSIO_HEADER *oldFitsHeader = NULL; /* in-memory-only fitsfile header of existing file on disk (no image) */
+    CFITSIO_HEADER *newFitsHeader = NULL; /* in-memory-only fitsfile header of file formed from fitskeys (no image) */
+
+    snprintf(sums_file, sizeof(sums_file), "%s", filename);
+
+    /* this must be open read-only since it is in SUMS */
+    if (cfitsio_open_file(sums_file, &disk_file, 0))
     {
-        if (seg->info->islink)
+        /* if we can't open the file for some reason, do not error out, just pretend the existing file
+         * does not exist */
+        fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] WARNING: unable to open internal FITS file '%s'\n", sums_file);
+        status = DRMS_ERROR_INVALIDFILE;
+    }
+    else
+    {
+        if (cfitsio_read_headsum(disk_file, &old_headsum))
         {
-            if ((tgtseg = drms_segment_lookup(seg->record, seg->info->name)) == NULL)
-            {
-                fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] unable to locate target segment %s file\n", seg->info->name);
-                status = DRMS_ERROR_INVALIDFILE;
-            }
-
-            actualSeg = tgtseg;
+            fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] WARNING: unable to read HEADSUM from internal FITS file '%s'\n", sums_file);
         }
-        else
+        else if (old_headsum)
         {
-            actualSeg = seg;
+            has_headsum = 1;
         }
 
-        if (status == DRMS_SUCCESS)
+        if (!old_headsum)
         {
-            drms_segment_filename(actualSeg, filename); /* full, absolute path to segment file */
+            /* there was no HEADSUM keyword in the internal FITS file, which is OK since files were not
+             * initially created with HEADSUM keywords; it is not clear if the disk_file header has
+             * a complete set of keywords */
+
+
+            /* XXX - I THINK we have to close the in-mem header to flush buffers, then we can capture
+             * the FITS file output on stdout with a pipe to ANOTHER cfitsio_open_file(); SO...
+             * 1. create a pipe
+             * 2. redirect stdout to the pipe write end
+             * 3. redirect stdin to the read end of the pipe
+             */
+            if (cfitsio_create_file((CFITSIO_FILE **)&oldFitsHeader, "-", CFITSIO_FILE_TYPE_HEADER, NULL, NULL, NULL))
+            {
+                fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] unable to create empty FITS file\n");
+                status = DRMS_ERROR_EXPORT;
+            }
 
-            if (*filename == '\0' || stat(filename, &stbuf))
+            if (status == DRMS_SUCCESS)
             {
-                /* file filename is missing */
-                snprintf(seg->filename, sizeof(seg->filename), "%s", filename); /* so caller has access to file name */
-                status = DRMS_ERROR_INVALIDFILE;
+                /* copy keywords in fitskeys from disk_file to oldFitsHeader */
+                if (cfitsio_copy_header_keywords(disk_file, (CFITSIO_FILE *)oldFitsHeader, fitskeys))
+                {
+                    fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] unable to copy internal header to empty FITS file\n");
+                    status = DRMS_ERROR_EXPORT;
+                }
+            }
+
+            if (status == DRMS_SUCCESS)
+            {
+                /* oldFitsHeader has the header of the fits file we are exporting; fitskeys is a list
+                 * of fits keywords that we expect to be in fits file we are exporting; old_headsum
+                 * will contain the checksum of the keys listed in fitskeys that exist in oldFitsHeader */
+                if (cfitsio_generate_checksum(&oldFitsHeader, NULL, &old_headsum))
+                {
+                    fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] unable to calculate header checksum\n");
+                    status = DRMS_ERROR_EXPORT;
+                }
             }
         }
     }
 
+    /* disk_file might be NULL, in which case we bail below with a DRMS_ERROR_INVALIDFILE status  */
+
+    if (oldFitsHeader)
+    {
+        /* ART - need to NOT flush to stdout, but oldFitsHeader is an in-memory file */
+        cfitsio_close_header(&oldFitsHeader);
+    }
+
     if (status == DRMS_SUCCESS)
     {
-        snprintf(realfileout, sizeof(realfileout), "%s", fileout);
+        /* makes `newFitsHeader` CFITSIO_HEADER that contains metadata contained in `fitskeys`; must free newFitsHeader;
+         * generates checksum from CFITSIO_HEADER, placing it in `new_headsum` */
+        if (cfitsio_generate_checksum(&newFitsHeader, fitskeys, &new_headsum))
+        {
+            fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] unable to calculate header checksum\n");
+            status = DRMS_ERROR_EXPORT;
+        }
 
-        if (!keywords_only)
+        if (status == DRMS_SUCCESS)
         {
-            /* must be source segment if the segment is a linked segment */
-            fitskeys = fitsexport_mapkeys(NULL, seg, clname, mapfile, &num_keys, NULL, NULL, &status);
+            /* the segment SUMS file is present and readable (and in disk_file) */
+            file_is_up_to_date = has_longwarn && has_headsum && old_headsum && new_headsum && strcmp(old_headsum, new_headsum) == 0;
 
-            if (tgtseg)
+            if (file_is_up_to_date && !streaming)
             {
-                swval = tgtseg->info->protocol;
+                /* no need to export - existing header is up-to-date; if we are not streaming to stdout,
+                 * make a link from filenameout to the internal FITS file; if we are streaming to stdout,
+                 * dump to */
+                if (symlink(sums_file, realfileout) == -1)
+                {
+                    status = DRMS_ERROR_INVALIDFILE;
+                }
             }
             else
             {
-                swval = seg->info->protocol;
-            }
-
-            switch (swval)
-            {
-                case DRMS_TAS:
+                /* must export - existing header is NOT up-to-date; send new FITSIO header instead of
+                 * the fitskeys list (to avoid creating the FITS header a second time), and
+                 * existing image data to ExportFITS3()
+                 */
+
+                /* we've decided not to actually update any series if this is the case; all we care about is
+                 * fixing the metadata on EXPORT in the case where somebody modified the metadata in
+                 * the database (i.e., they bypassed DRMS and used psql to modify metadata without creating
+                 * new records); the code here will produce consistent exported files; generally, we expect the
+                 * record-generating modules to create new records that contain FITS files with up-to-date
+                 * metadata */
+
+                /* ExportFITS3 will make a link from fileout to the keyword-updated internal FITS file */
+
+                /* extract image from existing disk_file (the internal fitsfile which may have metadata) */
+
+
+                /* send image data (fitsData) and metadata (fitsHeader) to ExportFITS3, which will either:
+                 * 1. combine them into a new FITS file with a path defined by fileout; this is the non-streaming
+                 *    case;
+                 * 2. combine them into a new in-memory FITS file, and dump them on stdout; this is the
+                 *    streaming case
+                 */
+
+                /* newFitsHeader is CLOSE to being correct - it has the wrong BITPIX and NAXIS and NAXISn; BUT the correct
+                 * values for those keywords exists in the disk_file; we need to grab the values for fitsKeys from newFitsHeader and
+                 * union them with the keywords in disk_file that has been stripped of the fitsKeys values; we can accomplish this
+                 * by starting with disk_file and then copying/updating the keys in fitsKeys that exist in newFitsHeader */
+                if (status == DRMS_SUCCESS)
                 {
-                    if (!streaming)
+                    if (callback != NULL)
                     {
-                        /* If we are reading a single record from a TAS file, this means that we're
-                         * reading a single slice. fileout will have a .tas extension, since
-                         * the output file name is derived from the input file name. We need to
-                         * substitute .fits for .tas. */
-                        size_t len = strlen(realfileout) + 64;
-                        size_t lenstr;
-                        char *dup = malloc(len);
-                        snprintf(dup, len, "%s", realfileout);
-
-                        if (dup)
+                        /* writing to an */
+                        if (streaming)
+                        {
+                            /* `out_file` IS the in-memory file created by the caller; when streaming
+                             * write directly to the fptr inside callback and do not close the CFITSIO_FILE */
+                            out_file = (CFITSIO_FILE *)callback;
+                        }
+                        else
                         {
-                            lenstr = strlen(dup);
-                            if (lenstr > 0 &&
-                             (dup[lenstr - 1] == 's' || dup[lenstr - 1] == 'S') &&
-                             (dup[lenstr - 2] == 'a' || dup[lenstr - 2] == 'A') &&
-                             (dup[lenstr - 3] == 't' || dup[lenstr - 3] == 'T') &&
-                              dup[lenstr - 4] == '.')
+                            CFITSIO_FITSFILE fptr = NULL; /* the fitsfile * inside (CFITSIO_FILE *)callback (if streaming), or produced by callback (if not streaming) */
+                            cfitsio_file_type_t callback_file_type = CFITSIO_FILE_TYPE_UNKNOWN;
+
+                            /* we are not initializing fptr since we will be using a fitsfile generated by a different
+                             * block of code (streaming --> callback is the fptr; !streaming --> callback will create the fptr) */
+                            if (cfitsio_create_file(&out_file, NULL, CFITSIO_FILE_TYPE_UNKNOWN, NULL, NULL, NULL))
+                            {
+                                status = DRMS_ERROR_FITSRW;
+                            }
+                            /* do not cache this fitsfile; in the streaming case, the fitsfile is in-memory-only, so don't need to cache;
+                             * in the VSO "create" case, the VSO drms_export_cgi.c handles the fitsfile */
+
+                            /* not stdout */
+                            int retVal = 0;
+                            int cfiostat = 0;
+
+                            /* use ISS callback to create the fitsfile */
+                            /* NOTE - there is no reason to call the "setarrout" callback any more; the DRMS_Array_t is no longer
+                             * used by drms_export_cgi.c; cfitsio_copy_file() will copy the image into out_file->fptr, which is then
+                             * used by drms_export_cgi.c */
+                            /* DO NOT CLOSE THIS FILE */
+
+                            (*callback)("create", &fptr, realfileout, cparms, &cfiostat, &retVal);
+                            if (cfiostat || retVal != CFITSIO_SUCCESS)
                             {
-                             *(dup + lenstr - 3) = '\0';
-                             snprintf(realfileout, sizeof(realfileout), "%sfits", dup);
+                                status = DRMS_ERROR_FILECREATE;
                             }
                             else
                             {
-                             fprintf(stderr, "Unexpected export file name '%s'.\n", dup);
-                             free(dup);
-                             status = DRMS_ERROR_EXPORT;
-                             break;
+                                /* hard code this - we don't have a way to receive flle-type info from
+                                 * drms_export_cgi */
+                                callback_file_type = CFITSIO_FILE_TYPE_IMAGE;
+                                cfitsio_set_fitsfile(out_file, fptr, 1, NULL, &callback_file_type);
                             }
 
-                            free(dup);
-                        }
-                        else
-                        {
-                            status = DRMS_ERROR_OUTOFMEMORY;
+                            if (status == DRMS_SUCCESS)
+                            {
+
+                            }
                         }
-                     }
-                }
 
-                    /* intentional fall-through */
-                case DRMS_BINARY:
-                    /* intentional fall-through */
-                case DRMS_BINZIP:
-                    /* intentional fall-through */
-                case DRMS_FITZ:
-                    /* intentional fall-through */
-                case DRMS_FITS:
-                    /* intentional fall-through */
-                case DRMS_DSDS:
-                    /* intentional fall-through */
-                case DRMS_LOCAL:
-                {
-                    /* If the segment file is compressed, and will be exported in compressed
-                     * format, don't uncompress it (which is what drms_segment_read() will do).
-                     * Instead, use the cfitsio routines to read the image into memory, as is -
-                     * so compressed image data will remain compressed in memory. Then
-                     * combine the header and image into a new FITS file and write it to
-                     * the fileout. Steps:
-                     *   1. Use CopyFile() to copy the input segment file to fileout.
-                     *   2. Call fits_open_image() to open the file for writing. This does not
-                     *      read the image into memory.
-                     *   3. Call cfitsio_key_to_card()/fits_write_record() to write keywords.
-                     *   4. Call fits_write_img().
-                     * It is probably best to use some modified version of fitsrw_write() that
-                     * simply replaces keywords - it deletes all existing keywords and
-                     * takes a keylist of keys to add to the image.
-                     *
-                     * Try to use the libfitsrw routines which automatically cache open
-                     * fitsfile pointers and calculate checksums, etc. */
-                    int file_is_up_to_date = 0;
-                    char sums_file[PATH_MAX];
-                    int has_longwarn = 0;
-                    int has_headsum = 0;
-                    char *old_headsum = NULL;
-                    char *new_headsum = NULL;
-                    CFITSIO_FILE *disk_file = NULL; /* in-memory-only fitsfile of existing file on disk */
-                    CFITSIO_HEADER *oldFitsHeader = NULL; /* in-memory-only fitsfile header of existing file on disk (no image) */
-                    CFITSIO_HEADER *newFitsHeader = NULL; /* in-memory-only fitsfile header of file formed from fitskeys (no image) */
-
-                    snprintf(sums_file, sizeof(sums_file), "%s", filename);
-
-                    /* this must be open read-only since it is in SUMS */
-                    if (cfitsio_open_file(sums_file, &disk_file, 0))
-                    {
-                        /* if we can't open the file for some reason, do not error out, just pretend the existing file
-                         * does not exist */
-                        fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] WARNING: unable to open internal FITS file '%s'\n", sums_file);
-                        status = DRMS_ERROR_INVALIDFILE;
+                        close_out_file = 0;
                     }
                     else
                     {
-                        if (cfitsio_read_headsum(disk_file, &old_headsum))
+                        /* NO callback, and NO streaming - create a fits file on disk */
+                        /* create a new file - `realfileout` is the file to export onto disk (not streaming); the fitsfile
+                         * will be cached; use the FITS compression-string specification in `cparms`, if it exists,
+                         * otherwise */
+                        if (cparms)
+                        {
+                            if (*cparms == '\0')
+                            {
+                                /* way to indicate no compression */
+                                snprintf(file_specification, sizeof(file_specification), "%s", realfileout);
+                            }
+                            else
+                            {
+                                snprintf(file_specification, sizeof(file_specification), "%s[%s]", realfileout, cparms);
+                            }
+                        }
+                        else if (actualSeg && actualSeg->cparms && *actualSeg->cparms != '\0')
+                        {
+                            snprintf(file_specification, sizeof(file_specification), "%s[%s]", realfileout, actualSeg->cparms);
+                        }
+                        else
                         {
-                            fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] WARNING: unable to read HEADSUM from internal FITS file '%s'\n", sums_file);
+                            snprintf(file_specification, sizeof(file_specification), "%s", realfileout);
                         }
-                        else if (old_headsum)
+
+                        /* create the fptr, but do not write any keywords (no bitpipx, naxis, naxes) */
+                        if (cfitsio_create_file(&out_file, file_specification, CFITSIO_FILE_TYPE_IMAGE, NULL, NULL, NULL))
+                        {
+                            status = DRMS_ERROR_FITSRW;
+                        }
+                        else
+                        {
+                            close_out_file = 1;
+                        }
+                    }
+
+                    /* out_file has been properly created */
+                    if (status == DRMS_SUCCESS)
+                    {
+                        /* we need to copy the internal input fitsfile so we can edit the header; copy the image too;
+                         * copy compression type too */
+                        //PushTimer();
+                        if (cfitsio_copy_file(disk_file, out_file, 0))
                         {
-                            has_headsum = 1;
+                            status = DRMS_ERROR_FITSRW;
                         }
 
-                        if (!old_headsum)
+                        //fprintf(stderr, "Time to copy one fits file = %f\n", PopTimer());
+                    }
+
+                    if (!file_is_up_to_date)
+                    {
+                        if (status == DRMS_SUCCESS)
                         {
-                            /* there was no HEADSUM keyword in the internal FITS file, which is OK since files were not
-                             * initially created with HEADSUM keywords; it is not clear if the disk_file header has
-                             * a complete set of keywords */
-
-
-                            /* XXX - I THINK we have to close the in-mem header to flush buffers, then we can capture
-                             * the FITS file output on stdout with a pipe to ANOTHER cfitsio_open_file(); SO...
-                             * 1. create a pipe
-                             * 2. redirect stdout to the pipe write end
-                             * 3. redirect stdin to the read end of the pipe
-                             */
-                            if (cfitsio_create_file((CFITSIO_FILE **)&oldFitsHeader, "-", CFITSIO_FILE_TYPE_HEADER, NULL, NULL, NULL))
+                            if (cfitsio_update_header_keywords(out_file, newFitsHeader, fitskeys))
                             {
-                                fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] unable to create empty FITS file\n");
-                                status = DRMS_ERROR_EXPORT;
+                                status = DRMS_ERROR_FITSRW;
                             }
+                        }
 
-                            if (status == DRMS_SUCCESS)
+                        /* write the HEADSUM keyword; this is a checksum of just the FITS keywords that map to
+                         * the DRMS keywords for this image */
+                        if (status == DRMS_SUCCESS)
+                        {
+                            if (cfitsio_write_headsum(out_file, new_headsum))
                             {
-                                /* copy keywords in fitskeys from disk_file to oldFitsHeader */
-                                if (cfitsio_copy_header_keywords(disk_file, (CFITSIO_FILE *)oldFitsHeader, fitskeys))
-                                {
-                                    fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] unable to copy internal header to empty FITS file\n");
-                                    status = DRMS_ERROR_EXPORT;
-                                }
+                                status = DRMS_ERROR_FITSRW;
                             }
+                        }
 
-                            if (status == DRMS_SUCCESS)
+                        /*
+                         * WRITE LONGWARN KEYWORD LAST! All keys written after LONGWARN will silently disappear.
+                         *
+                         */
+                        if (status == DRMS_SUCCESS)
+                        {
+                            /* write the LONGSTRN keyword to inform FITS readers that the long string convention may be used;
+                             * no harm if this keyword already exists (it will be written to out_file only once) */
+                            if (cfitsio_write_longwarn(out_file))
                             {
-                                /* oldFitsHeader has the header of the fits file we are exporting; fitskeys is a list
-                                 * of fits keywords that we expect to be in fits file we are exporting; old_headsum
-                                 * will contain the checksum of the keys listed in fitskeys that exist in oldFitsHeader */
-                                if (cfitsio_generate_checksum(&oldFitsHeader, NULL, &old_headsum))
-                                {
-                                    fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] unable to calculate header checksum\n");
-                                    status = DRMS_ERROR_EXPORT;
-                                }
+                                status = DRMS_ERROR_FITSRW;
                             }
                         }
                     }
+                }
 
-                    /* disk_file might be NULL, in which case we bail below with a DRMS_ERROR_INVALIDFILE status  */
+                if (status == DRMS_SUCCESS)
+                {
+                    /* close the original SUMS file */
+                    cfitsio_close_file(&disk_file);
 
-                    if (oldFitsHeader)
+                    if (close_out_file)
                     {
-                        /* ART - need to NOT flush to stdout, but oldFitsHeader is an in-memory file */
-                        cfitsio_close_header(&oldFitsHeader);
+                        /* flush to disk or stdout (if streaming, do not flush to stdout) */
+                        cfitsio_close_file(&out_file);
                     }
+                }
+            }
+        }
+    }
 
-                    if (status == DRMS_SUCCESS)
-                    {
-                        /* makes `newFitsHeader` CFITSIO_HEADER that contains metadata contained in `fitskeys`; must free newFitsHeader;
-                         * generates checksum from CFITSIO_HEADER, placing it in `new_headsum` */
-                        if (cfitsio_generate_checksum(&newFitsHeader, fitskeys, &new_headsum))
-                        {
-                            fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] unable to calculate header checksum\n");
-                            status = DRMS_ERROR_EXPORT;
-                        }
+    if (new_headsum)
+    {
+        free(new_headsum);
+        new_headsum = NULL;
+    }
 
-                        if (status == DRMS_SUCCESS)
-                        {
-                            /* the segment SUMS file is present and readable (and in disk_file) */
-                            file_is_up_to_date = has_longwarn && has_headsum && old_headsum && new_headsum && strcmp(old_headsum, new_headsum) == 0;
+    if (newFitsHeader)
+    {
+        cfitsio_close_header(&newFitsHeader);
+    }
 
-                            if (file_is_up_to_date && !streaming)
-                            {
-                                /* no need to export - existing header is up-to-date; if we are not streaming to stdout,
-                                 * make a link from filenameout to the internal FITS file; if we are streaming to stdout,
-                                 * dump to */
-                                if (symlink(sums_file, realfileout) == -1)
-                                {
-                                    status = DRMS_ERROR_INVALIDFILE;
-                                }
-                            }
-                            else
-                            {
-                                /* must export - existing header is NOT up-to-date; send new FITSIO header instead of
-                                 * the fitskeys list (to avoid creating the FITS header a second time), and
-                                 * existing image data to ExportFITS3()
-                                 */
+    if (old_headsum)
+    {
+        free(old_headsum);
+        old_headsum = NULL;
+    }
 
-                                /* we've decided not to actually update any series if this is the case; all we care about is
-                                 * fixing the metadata on EXPORT in the case where somebody modified the metadata in
-                                 * the database (i.e., they bypassed DRMS and used psql to modify metadata without creating
-                                 * new records); the code here will produce consistent exported files; generally, we expect the
-                                 * record-generating modules to create new records that contain FITS files with up-to-date
-                                 * metadata */
+    return status;
+}
 
-                                /* ExportFITS3 will make a link from fileout to the keyword-updated internal FITS file */
+/* exports the segment file filename, whose protocol is protocol, to realfileout (or, if streaming, to the CFITSIO_FILE
+ * callback); FITS-like protocols get the FITS keywords fitskeys, and generic files are copied as is */
+static int ExportSegmentFile(const char *filename, DRMS_Protocol_t protocol, CFITSIO_KEYWORD *fitskeys, const char *cparms, DRMS_Segment_t *actualSeg, const char *realfileout, int streaming, export_callback_func_t callback)
+{
+    int status = DRMS_SUCCESS;
 
-                                /* extract image from existing disk_file (the internal fitsfile which may have metadata) */
+    switch (protocol)
+    {
+        case DRMS_TAS:
+            /* intentional fall-through */
+        case DRMS_BINARY:
+            /* intentional fall-through */
+        case DRMS_BINZIP:
+            /* intentional fall-through */
+        case DRMS_FITZ:
+            /* intentional fall-through */
+        case DRMS_FITS:
+            /* intentional fall-through */
+        case DRMS_DSDS:
+            /* intentional fall-through */
+        case DRMS_LOCAL:
+        {
+            status = ExportFITSImage(filename, fitskeys, cparms, actualSeg, realfileout, streaming, callback);
+        }
+        break;
+        case DRMS_GENERIC:
+        {
+            struct stat stbuf;
+            int ioerr;
 
+            /* Simply copy the file from the segment's data-file path
+            * to fileout, no keywords to worry about. */
 
-                                /* send image data (fitsData) and metadata (fitsHeader) to ExportFITS3, which will either:
-                                 * 1. combine them into a new FITS file with a path defined by fileout; this is the non-streaming
-                                 *    case;
-                                 * 2. combine them into a new in-memory FITS file, and dump them on stdout; this is the
-                                 *    streaming case
-                                 */
+            /* filename could be a directory. If that is the case, then copy the entire tree to realfileout. Art made a change
+             * to exputl_mk_expfilename() so that if a generic segment has no seg->filename to use for realfileout, then
+             * one is made from <su dir>/<slot dir>/<seg name>. He also changed CopyFile() to handle tree copies. */
+            if (stat(filename, &stbuf))
+            {
+                status = DRMS_ERROR_INVALIDFILE;
+            }
+            else if (CopyFile(filename, realfileout, &ioerr) != stbuf.st_size)
+            {
+                if (!S_ISDIR(stbuf.st_mode))
+                {
+                    /* For a directory, CopyFile will return the number of bytes of all the files copied within the directory at any level.
+                     * This will not match stbuf.st_size, the size of the directory, which is 0.
+                     */
+                    fprintf(stderr, "Unable to export file '%s' to '%s'.\n", filename, realfileout);
+                    status = DRMS_ERROR_FILECOPY;
+                }
+            }
+        }
+        break;
+        default:
+          fprintf(stderr, "data export does not support data segment protocol '%s'\n", drms_prot2str(protocol));
+    } /* segment protocol switch */
 
-                                /* newFitsHeader is CLOSE to being correct - it has the wrong BITPIX and NAXIS and NAXISn; BUT the correct
-                                 * values for those keywords exists in the disk_file; we need to grab the values for fitsKeys from newFitsHeader and
-                                 * union them with the keywords in disk_file that has been stripped of the fitsKeys values; we can accomplish this
-                                 * by starting with disk_file and then copying/updating the keys in fitsKeys that exist in newFitsHeader */
-                                if (status == DRMS_SUCCESS)
-                                {
-                                    if (callback != NULL)
-                                    {
-                                        /* writing to an */
-                                        if (streaming)
-                                        {
-                                            /* `out_file` IS the in-memory file created by the caller; when streaming
-                                             * write directly to the fptr inside callback and do not close the CFITSIO_FILE */
-                                            out_file = (CFITSIO_FILE *)callback;
-                                        }
-                                        else
-                                        {
-                                            CFITSIO_FITSFILE fptr = NULL; /* the fitsfile * inside (CFITSIO_FILE *)callback (if streaming), or produced by callback (if not streaming) */
-                                            cfitsio_file_type_t callback_file_type = CFITSIO_FILE_TYPE_UNKNOWN;
-
-                                            /* we are not initializing fptr since we will be using a fitsfile generated by a different
-                                             * block of code (streaming --> callback is the fptr; !streaming --> callback will create the fptr) */
-                                            if (cfitsio_create_file(&out_file, NULL, CFITSIO_FILE_TYPE_UNKNOWN, NULL, NULL, NULL))
-                                            {
-                                                status = DRMS_ERROR_FITSRW;
-                                            }
-                                            /* do not cache this fitsfile; in the streaming case, the fitsfile is in-memory-only, so don't need to cache;
-                                             * in the VSO "create" case, the VSO drms_export_cgi.c handles the fitsfile */
-
-                                            /* not stdout */
-                                            int retVal = 0;
-                                            int cfiostat = 0;
-
-                                            /* use ISS callback to create the fitsfile */
-                                            /* NOTE - there is no reason to call the "setarrout" callback any more; the DRMS_Array_t is no longer
-                                             * used by drms_export_cgi.c; cfitsio_copy_file() will copy the image into out_file->fptr, which is then
-                                             * used by drms_export_cgi.c */
-                                            /* DO NOT CLOSE THIS FILE */
-
-                                            (*callback)("create", &fptr, realfileout, cparms, &cfiostat, &retVal);
-                                            if (cfiostat || retVal != CFITSIO_SUCCESS)
-                                            {
-                                                status = DRMS_ERROR_FILECREATE;
-                                            }
-                                            else
-                                            {
-                                                /* hard code this - we don't have a way to receive flle-type info from
-                                                 * drms_export_cgi */
-                                                callback_file_type = CFITSIO_FILE_TYPE_IMAGE;
-                                                cfitsio_set_fitsfile(out_file, fptr, 1, NULL, &callback_file_type);
-                                            }
-
-                                            if (status == DRMS_SUCCESS)
-                                            {
-
-                                            }
-                                        }
-
-                                        close_out_file = 0;
-                                    }
-                                    else
-                                    {
-                                        /* NO callback, and NO streaming - create a fits file on disk */
-                                        /* create a new file - `realfileout` is the file to export onto disk (not streaming); the fitsfile
-                                         * will be cached; use the FITS compression-string specification in `cparms`, if it exists,
-                                         * otherwise */
-                                        if (cparms)
-                                        {
-                                            if (*cparms == '\0')
-                                            {
-                                                /* way to indicate no compression */
-                                                snprintf(file_specification, sizeof(file_specification), "%s", realfileout);
-                                            }
-                                            else
-                                            {
-                                                snprintf(file_specification, sizeof(file_specification), "%s[%s]", realfileout, cparms);
-                                            }
-                                        }
-                                        else if (actualSeg && actualSeg->cparms && *actualSeg->cparms != '\0')
-                                        {
-                                            snprintf(file_specification, sizeof(file_specification), "%s[%s]", realfileout, actualSeg->cparms);
-                                        }
-                                        else
-                                        {
-                                            snprintf(file_specification, sizeof(file_specification), "%s", realfileout);
-                                        }
-
-                                        /* create the fptr, but do not write any keywords (no bitpipx, naxis, naxes) */
-                                        if (cfitsio_create_file(&out_file, file_specification, CFITSIO_FILE_TYPE_IMAGE, NULL, NULL, NULL))
-                                        {
-                                            status = DRMS_ERROR_FITSRW;
-                                        }
-                                        else
-                                        {
-                                            close_out_file = 1;
-                                        }
-                                    }
+    return status;
+}
 
-                                    /* out_file has been properly created */
-                                    if (status == DRMS_SUCCESS)
-                                    {
-                                        /* we need to copy the internal input fitsfile so we can edit the header; copy the image too;
-                                         * copy compression type too */
-                                        //PushTimer();
-                                        if (cfitsio_copy_file(disk_file, out_file, 0))
-                                        {
-                                            status = DRMS_ERROR_FITSRW;
-                                        }
-
-                                        //fprintf(stderr, "Time to copy one fits file = %f\n", PopTimer());
-                                    }
+int fitsexport_mapexport_tofile2(DRMS_Record_t *rec, DRMS_Segment_t *seg, long long row_number, const char *cparms, /* NULL for stdout */ const char *clname, const char *mapfile, const char *fileout, /* "-" for stdout */ char **actualfname, /* NULL for stdout */ unsigned long long *expsize, /* NULL for stdout */ export_callback_func_t callback) //ISS fly-tar - fitsfile * for stdout
+{
+    int status = DRMS_SUCCESS;
+    CFITSIO_KEYWORD *fitskeys = NULL; int num_keys = 0;
+    LinkedList_t *ttypes = NULL;
+    LinkedList_t *tforms = NULL;
+    char *ttype = NULL;
+    char *tform = NULL;
+    char filename[DRMS_MAXPATHLEN];
+    struct stat stbuf;
+    DRMS_Segment_t *tgtseg = NULL;
+    DRMS_Segment_t *actualSeg = NULL;
+    char realfileout[DRMS_MAXPATHLEN];
+    CFITSIO_FILE *out_file = NULL; /* exported fitsfile; if streaming, then this is also in-memory-only, otherwise
+                                    * when closed, the fitsfile will be written to disk (to realfileout) */
+    int close_out_file = 0; /* if we are streaming or using the callback method, then do not close out_file */
+    struct stat filestat;
+    int streaming = 0;
+    int keywords_only = 0;
+    int swval;
+    CFITSIO_BINTABLE_INFO *bintable_info = NULL;
+    LinkedList_t *bintable_rows = NULL;
+    long long column_index = -1;
+    ListNode_t *node = NULL;
 
-                                    if (!file_is_up_to_date)
-                                    {
-                                        if (status == DRMS_SUCCESS)
-                                        {
-                                            if (cfitsio_update_header_keywords(out_file, newFitsHeader, fitskeys))
-                                            {
-                                                status = DRMS_ERROR_FITSRW;
-                                            }
-                                        }
-
-                                        /* write the HEADSUM keyword; this is a checksum of just the FITS keywords that map to
-                                         * the DRMS keywords for this image */
-                                        if (status == DRMS_SUCCESS)
-                                        {
-                                            if (cfitsio_write_headsum(out_file, new_headsum))
-                                            {
-                                                status = DRMS_ERROR_FITSRW;
-                                            }
-                                        }
-
-                                        /*
-                                         * WRITE LONGWARN KEYWORD LAST! All keys written after LONGWARN will silently disappear.
-                                         *
-                                         */
-                                        if (status == DRMS_SUCCESS)
-                                        {
-                                            /* write the LONGSTRN keyword to inform FITS readers that the long string convention may be used;
-                                             * no harm if this keyword already exists (it will be written to out_file only once) */
-                                            if (cfitsio_write_longwarn(out_file))
-                                            {
-                                                status = DRMS_ERROR_FITSRW;
-                                            }
-                                        }
-                                    }
-                                }
+    streaming = (strcmp(fileout, "-") == 0);
+    keywords_only = (seg == NULL);
 
-                                if (status == DRMS_SUCCESS)
-                                {
-                                    /* close the original SUMS file */
-                                    cfitsio_close_file(&disk_file);
+    if (!keywords_only)
+    {
+        if (seg->info->islink)
+        {
+            if ((tgtseg = drms_segment_lookup(seg->record, seg->info->name)) == NULL)
+            {
+                fprintf(stderr, "[ fitsexport_mapexport_tofile2() ] unable to locate target segment %s file\n", seg->info->name);
+                status = DRMS_ERROR_INVALIDFILE;
+            }
 
-                                    if (close_out_file)
-                                    {
-                                        /* flush to disk or stdout (if streaming, do not flush to stdout) */
-                                        cfitsio_close_file(&out_file);
-                                    }
-                                }
-                            }
-                        }
-                    }
+            actualSeg = tgtseg;
+        }
+        else
+        {
+            actualSeg = seg;
+        }
 
-                    if (new_headsum)
-                    {
-                        free(new_headsum);
-                        new_headsum = NULL;
-                    }
+        if (status == DRMS_SUCCESS)
+        {
+            drms_segment_filename(actualSeg, filename); /* full, absolute path to segment file */
+
+            if (*filename == '\0' || stat(filename, &stbuf))
+            {
+                /* file filename is missing */
+                snprintf(seg->filename, sizeof(seg->filename), "%s", filename); /* so caller has access to file name */
+                status = DRMS_ERROR_INVALIDFILE;
+            }
+        }
+    }
+
+    if (status == DRMS_SUCCESS)
+    {
+        snprintf(realfileout, sizeof(realfileout), "%s", fileout);
+
+        if (!keywords_only)
+        {
+            /* must be source segment if the segment is a linked segment */
+            fitskeys = fitsexport_mapkeys(NULL, seg, clname, mapfile, &num_keys, NULL, NULL, &status);
+
+            if (tgtseg)
+            {
+                swval = tgtseg->info->protocol;
+            }
+            else
+            {
+                swval = seg->info->protocol;
+            }
 
-                    if (newFitsHeader)
+            if (swval == DRMS_TAS && !streaming)
+            {
+                /* If we are reading a single record from a TAS file, this means that we're
+                 * reading a single slice. fileout will have a .tas extension, since
+                 * the output file name is derived from the input file name. We need to
+                 * substitute .fits for .tas. */
+                size_t len = strlen(realfileout) + 64;
+                size_t lenstr;
+                char *dup = malloc(len);
+
+                if (dup)
+                {
+                    snprintf(dup, len, "%s", realfileout);
+                    lenstr = strlen(dup);
+                    if (lenstr > 0 &&
+                     (dup[lenstr - 1] == 's' || dup[lenstr - 1] == 'S') &&
+                     (dup[lenstr - 2] == 'a' || dup[lenstr - 2] == 'A') &&
+                     (dup[lenstr - 3] == 't' || dup[lenstr - 3] == 'T') &&
+                      dup[lenstr - 4] == '.')
                     {
-                        cfitsio_close_header(&newFitsHeader);
+                     *(dup + lenstr - 3) = '\0';
+                     snprintf(realfileout, sizeof(realfileout), "%sfits", dup);
                     }
-
-                    if (old_headsum)
+                    else
                     {
-                        free(old_headsum);
-                        old_headsum = NULL;
+                     fprintf(stderr, "Unexpected export file name '%s'.\n", dup);
+                     status = DRMS_ERROR_EXPORT;
                     }
+
+                    free(dup);
                 }
-                break;
-                case DRMS_GENERIC:
+                else
                 {
-                    int ioerr;
-
-                    /* Simply copy the file from the segment's data-file path
-                    * to fileout, no keywords to worry about. */
-
-                    /* filename could be a directory. If that is the case, then copy the entire tree to realfileout. Art made a change
-                     * to exputl_mk_expfilename() so that if a generic segment has no seg->filename to use for realfileout, then
-                     * one is made from <su dir>/<slot dir>/<seg name>. He also changed CopyFile() to handle tree copies. */
-                    if (CopyFile(filename, realfileout, &ioerr) != stbuf.st_size)
-                    {
-                        if (!S_ISDIR(stbuf.st_mode))
-                        {
-                            /* For a directory, CopyFile will return the number of bytes of all the files copied within the directory at any level.
-                             * This will not match stbuf.st_size, the size of the directory, which is 0.
-                             */
-                            fprintf(stderr, "Unable to export file '%s' to '%s'.\n", filename, realfileout);
-                            status = DRMS_ERROR_FILECOPY;
-                        }
-                    }
+                    status = DRMS_ERROR_OUTOFMEMORY;
                 }
-                break;
-                default:
-                  fprintf(stderr, "data export does not support data segment protocol '%s'\n", drms_prot2str(seg->info->protocol));
-            } /* segment protocol switch */
+            }
+
+            if (status == DRMS_SUCCESS)
+            {
+                status = ExportSegmentFile(filename, (DRMS_Protocol_t)swval, fitskeys, cparms, actualSeg, realfileout, streaming, callback);
+            }
         }
         else
         {
@@ -2441,119 +2509,663 @@ int fitsexport_mapexport_to_cfitsio_file(CFITSIO_FILE *file, DRMS_Segment_t *seg
     return fitsexport_mapexport_tofile2(seg->record, seg, 0, NULL, clname, mapfile, "-", NULL, NULL, (export_callback_func_t)file);
 }
 
-int fitsexport_mapexport_keywords_to_cfitsio_file(CFITSIO_FILE *file, DRMS_Record_t *rec, long long row_number, const char *clname, const char *mapfile)
+/* the DRMS part of fitsexport_mapexport_to_cfitsio_file() - finds the segment file (filename must be DRMS_MAXPATHLEN
+ * bytes) and its protocol (*protocol, if protocol is not NULL), and maps the record's keywords to FITS keywords
+ * (*fitskeys, which the caller frees with cfitsio_free_keys()); this must run on the thread that owns the DRMS env */
+int fitsexport_mapexport_prepare(DRMS_Segment_t *seg, const char *clname, const char *mapfile, char *filename, DRMS_Protocol_t *protocol, CFITSIO_KEYWORD **fitskeys)
 {
-    /* no segment - export FITS file with no image */
-    return fitsexport_mapexport_tofile2(rec, NULL, row_number, NULL, clname, mapfile, "-", NULL, NULL, (export_callback_func_t)file);
-}
-
-/* Map keys that are specific to a segment to fits keywords.  User must free.
- * Follows keyword links and ensures that per-segment keywords are relevant
- * to this seg's keywords. */
+    int status = DRMS_SUCCESS;
+    DRMS_Segment_t *actualSeg = NULL;
+    struct stat stbuf;
+    int num_keys = 0;
 
-/* Input seg must be the src seg, not the target seg, if the input seg is a linked segment. */
-CFITSIO_KEYWORD *fitsexport_mapkeys(DRMS_Record_t *rec, DRMS_Segment_t *seg, const char *clname, const char *mapfile, int *num_keys, LinkedList_t *ttypes, LinkedList_t *tforms, int *status)
-{
-    CFITSIO_KEYWORD *fitskeys = NULL;
-    CFITSIO_KEYWORD *fits_key = NULL;
-    int total_keys = 0;
-    HIterator_t *last = NULL;
-    int statint = DRMS_SUCCESS;
-    DRMS_Keyword_t *key = NULL;
-    const char *keyname = NULL;
-    char segnum[4];
-    DRMS_Record_t *recin = (seg ? seg->record : rec);
-    Exputl_KeyMap_t *map = NULL;
-    FILE *fptr = NULL;
-    char drms_id[CFITSIO_MAX_COMMENT];
-    char *primary_key = NULL;
-    size_t sz_primary_key = 64;
-    int npkeys = 0;
-    int pkey = -1;
-    char **ext_pkeys = NULL;
-    int fitsrwRet = 0;
-    CFITSIO_BINTABLE_TTYPE *ttype = NULL;
-    CFITSIO_BINTABLE_TFORM *tform = NULL;
+    *fitskeys = NULL;
+    *filename = '\0';
 
-    total_keys = 0;
-    while ((key = drms_record_nextkey(recin, &last, 0)) != NULL)
+    if (seg->info->islink)
     {
-        keyname = drms_keyword_getname(key);
-
-        if (!drms_keyword_getimplicit(key))
+        if ((actualSeg = drms_segment_lookup(seg->record, seg->info->name)) == NULL)
         {
-            if (seg)
-            {
-                /* do not look for per-segment keywords if the record belongs to a series that has no segments */
-                if (drms_keyword_getperseg(key))
-                {
-                    snprintf(segnum, sizeof(segnum), "%03d", seg->info->segnum);
-
-                    /* Ensure that this keyword is relevant to this segment. */
-                    if (!strstr(keyname, segnum))
-                    {
-                        continue;
-                    }
-                }
+            fprintf(stderr, "[ fitsexport_mapexport_prepare() ] unable to locate target segment %s file\n", seg->info->name);
+            status = DRMS_ERROR_INVALIDFILE;
+        }
+    }
+    else
+    {
+        actualSeg = seg;
+    }
+
+    if (status == DRMS_SUCCESS)
+    {
+        drms_segment_filename(actualSeg, filename); /* full, absolute path to segment file */
+
+        if (*filename == '\0' || stat(filename, &stbuf))
+        {
+            /* file filename is missing */
+            snprintf(seg->filename, sizeof(seg->filename), "%s", filename); /* so caller has access to file name */
+            status = DRMS_ERROR_INVALIDFILE;
+        }
+        else if (protocol)
+        {
+            *protocol = actualSeg->info->protocol;
+        }
+    }
+
+    if (status == DRMS_SUCCESS)
+    {
+        /* must be source segment if the segment is a linked segment */
+        *fitskeys = fitsexport_mapkeys(NULL, seg, clname, mapfile, &num_keys, NULL, NULL, &status);
+    }
+
+    if (status != DRMS_SUCCESS && *fitskeys)
+    {
+        cfitsio_free_keys(fitskeys);
+    }
+
+    return status;
+}
+
+/* the CFITSIO part of fitsexport_mapexport_to_cfitsio_file() - exports the segment file filename, of protocol protocol,
+ * with the keywords fitskeys, all from fitsexport_mapexport_prepare(), to the in-memory file, as
+ * fitsexport_mapexport_to_cfitsio_file() does; this does not use DRMS */
+int fitsexport_export_prepared_to_cfitsio_file(CFITSIO_FILE *file, const char *filename, DRMS_Protocol_t protocol, CFITSIO_KEYWORD *fitskeys)
+{
+    return ExportSegmentFile(filename, protocol, fitskeys, NULL, NULL, "-", 1, (export_callback_func_t)file);
+}
+
+/* fitsexport_mapexport_tofile() with the segment file and keywords from fitsexport_mapexport_prepare() - exports
+ * filename, of protocol protocol, with the keywords fitskeys, to the file fileout; actualSeg is the (target) segment
+ * whose file filename is; TAS slices are not supported (fitsexport_mapexport_tofile() renames them) */
+int fitsexport_export_prepared_tofile(const char *filename, DRMS_Protocol_t protocol, CFITSIO_KEYWORD *fitskeys, DRMS_Segment_t *actualSeg, const char *cparms, const char *fileout, char **actualfname, unsigned long long *expsize)
+{
+    int status = DRMS_SUCCESS;
+    char realfileout[DRMS_MAXPATHLEN];
+    struct stat filestat;
+
+    if (protocol == DRMS_TAS)
+    {
+        fprintf(stderr, "[ fitsexport_export_prepared_tofile() ] cannot export TAS file '%s'\n", filename);
+        return DRMS_ERROR_EXPORT;
+    }
+
+    snprintf(realfileout, sizeof(realfileout), "%s", fileout);
+    status = ExportSegmentFile(filename, protocol, fitskeys, cparms, actualSeg, realfileout, 0, NULL);
+
+    if (status == DRMS_SUCCESS)
+    {
+        /* Ensure file got created. */
+        if (stat(realfileout, &filestat))
+        {
+            status = DRMS_ERROR_EXPORT;
+        }
+        else if (expsize)
+        {
+            *actualfname = strdup(basename(realfileout));
+            *expsize = filestat.st_size;
+        }
+    }
+
+    return status;
+}
+
+int fitsexport_mapexport_keywords_to_cfitsio_file(CFITSIO_FILE *file, DRMS_Record_t *rec, long long row_number, const char *clname, const char *mapfile)
+{
+    /* no segment - export FITS file with no image */
+    return fitsexport_mapexport_tofile2(rec, NULL, row_number, NULL, clname, mapfile, "-", NULL, NULL, (export_callback_func_t)file);
+}
+
+/* the reserved FITS keyword that key exports as, if any (*ikey is NULL if none); WCS keywords can be indexed, so
+ * keyword_stem is set to key's name minus any index */
+static int ReservedKeyLookup(DRMS_Keyword_t *key, char *keyword_stem, size_t sz_keyword_stem, FE_ReservedKeys_t **ikey)
+{
+    int stat = DRMS_SUCCESS;
+    static regex_t *reg_expression = NULL;
+    const char *indexed_keyword_pattern = "^([A-Za-z])+[0-9]+$";
+    regmatch_t matches[2]; /* index 0 is the entire string */
+
+    *ikey = NULL;
+
+    /* ART - this does not get freed! */
+    if (!reg_expression)
+    {
+        reg_expression = calloc(1, sizeof(regex_t));
+        if (regcomp(reg_expression, indexed_keyword_pattern, REG_EXTENDED) != 0)
+        {
+            stat = DRMS_ERROR_FITSRW;
+        }
+    }
+
+    if (stat == DRMS_SUCCESS)
+    {
+        snprintf(keyword_stem, sz_keyword_stem, "%s", key->info->name);
+        if (regexec(reg_expression, keyword_stem, sizeof(matches) / sizeof(matches[0]), matches, 0) == 0)
+        {
+            /* match, indexed */
+            keyword_stem[matches[1].rm_eo] = '\0';
+        }
+
+        /* since WCS keywords can be indexed, remove the index part before checking for a handler */
+        if (gReservedFits)
+        {
+            *ikey = (FE_ReservedKeys_t *)hcon_lookup_lower(gReservedFits, keyword_stem);
+        }
+    }
+
+    return stat;
+}
+
+/* A FITS header template - what fitsexport_mapkeys() makes for every record of a series (for one segment, keyword-map class,
+ * and keyword map) minus the keyword values. It is made from the first record exported and kept in gHeaderTemplates
+ * for the rest of the process, so each keyword description is parsed, and each FITS name made and checked, once per
+ * series, not once per exported file. A record whose keyword info is not the info the template was made from (the
+ * info is shared by all records of a series) is mapped as before, one keyword at a time. */
+typedef enum
+{
+    kFE_HeaderSlot_Mapped = 0,  /* fitsexport_mapexportkey() for each record */
+    kFE_HeaderSlot_Value,       /* default conversion - only the value is per record */
+    kFE_HeaderSlot_Handler      /* reserved keyword with an export handler */
+} FE_HeaderSlotType_t;
+
+typedef struct FE_HeaderSlot_struct
+{
+    FE_HeaderSlotType_t type;
+    char *keyname;
+    DRMS_KeywordInfo_t *info;
+    DRMS_KeywordInfo_t *value_info; /* the info of the keyword the value comes from - the target of a linked keyword */
+    char nameout[16];
+    char *comment_external;
+    char keyword_stem[16];
+    FE_ReservedKeys_t reserved;
+    cfitsio_keyword_datatype_t fitstype;
+    int number_bytes;
+    FE_Keyword_ExtType_t external_type;
+    char *format;
+    char *short_comment;
+} FE_HeaderSlot_t;
+
+typedef struct FE_HeaderTemplate_struct
+{
+    FE_HeaderSlot_t *slots;
+    int nslots;
+    Exputl_KeyMap_t *map;
+    char *primary_key;
+} FE_HeaderTemplate_t;
+
+HContainer_t *gHeaderTemplates = NULL;
+
+static void DestroyHeaderTemplate(FE_HeaderTemplate_t **template)
+{
+    int islot;
+
+    if (template && *template)
+    {
+        for (islot = 0; islot < (*template)->nslots; islot++)
+        {
+            free((*template)->slots[islot].keyname);
+
+            if ((*template)->slots[islot].comment_external)
+            {
+                free((*template)->slots[islot].comment_external);
             }
 
-            if (mapfile && !map)
+            if ((*template)->slots[islot].format)
             {
-                map = exputl_keymap_create();
+                free((*template)->slots[islot].format);
+            }
 
-                /* Allow for mapfile to actually be newline-separated key-value pairs. */
-                fptr = fopen(mapfile, "r");
-                if (fptr)
-                {
-                    if (!exputl_keymap_parsefile(map, fptr))
-                    {
-                        exputl_keymap_destroy(&map);
-                    }
+            if ((*template)->slots[islot].short_comment)
+            {
+                free((*template)->slots[islot].short_comment);
+            }
+        }
 
-                    fclose(fptr);
-                }
-                else if (!exputl_keymap_parsetable(map, mapfile))
+        if ((*template)->slots)
+        {
+            free((*template)->slots);
+        }
+
+        if ((*template)->map)
+        {
+            exputl_keymap_destroy(&(*template)->map);
+        }
+
+        if ((*template)->primary_key)
+        {
+            free((*template)->primary_key);
+        }
+
+        free(*template);
+        *template = NULL;
+    }
+}
+
+static void FreeHeaderTemplate(const void *value)
+{
+    FE_HeaderTemplate_t *template = *(FE_HeaderTemplate_t **)value;
+
+    DestroyHeaderTemplate(&template);
+}
+
+static void FreeHeaderTemplates(void *data)
+{
+   if (gHeaderTemplates != (HContainer_t *)data)
+   {
+      fprintf(stderr, "Unexpected argument to FreeHeaderTemplates(); bailing.\n");
+      return;
+   }
+
+   hcon_destroy(&gHeaderTemplates);
+}
+
+/* fills in slot for key - a slot that cannot be compiled stays a kFE_HeaderSlot_Mapped slot */
+static void CompileHeaderSlot(FE_HeaderSlot_t *slot, DRMS_Keyword_t *key, const char *clname, Exputl_KeyMap_t *map)
+{
+    char comment_external[DRMS_MAXCOMMENTLEN] = {0};
+    DRMS_Keyword_t *keywval = NULL;
+    FE_ReservedKeys_t *ikey = NULL;
+
+    slot->type = kFE_HeaderSlot_Mapped;
+
+    if (!fitsexport_getmappedextkeyname(key, clname, map, slot->nameout, sizeof(slot->nameout), comment_external, sizeof(comment_external), NULL))
+    {
+        return;
+    }
+
+    /* follow link if key is a linked keyword, otherwise, use key */
+    keywval = drms_keyword_lookup(key->record, key->info->name, 1);
+    if (!keywval || ReservedKeyLookup(key, slot->keyword_stem, sizeof(slot->keyword_stem), &ikey) != DRMS_SUCCESS)
+    {
+        return;
+    }
+
+    slot->value_info = keywval->info;
+    slot->comment_external = strdup(comment_external);
+    if (!slot->comment_external)
+    {
+        return;
+    }
+
+    if (ikey)
+    {
+        /* a reserved keyword with no handler is not exported - leave the message to fitsexport_mapexportkey() */
+        if (ExportHandlers[*ikey])
+        {
+            slot->reserved = *ikey;
+            slot->type = kFE_HeaderSlot_Handler;
+        }
+    }
+    else if (DescribeFITSKey(keywval, strcasecmp(key->info->name, slot->nameout) == 0 ? NULL : key->info->name, slot->comment_external, &slot->fitstype, &slot->number_bytes, &slot->external_type, &slot->format, &slot->short_comment) == 0)
+    {
+        slot->type = kFE_HeaderSlot_Value;
+    }
+}
+
+static FE_HeaderTemplate_t *CreateHeaderTemplate(DRMS_Record_t *recin, DRMS_Segment_t *seg, const char *clname, const char *mapfile)
+{
+    FE_HeaderTemplate_t *template = NULL;
+    FE_HeaderSlot_t *slots = NULL;
+    int nalloc = 0;
+    HIterator_t *last = NULL;
+    DRMS_Keyword_t *key = NULL;
+    const char *keyname = NULL;
+    char segnum[4];
+    FILE *fptr = NULL;
+    size_t sz_primary_key = 64;
+    int npkeys = 0;
+    int pkey = -1;
+    char **ext_pkeys = NULL;
+    int err = 0;
+
+    template = calloc(1, sizeof(FE_HeaderTemplate_t));
+    if (!template)
+    {
+        return NULL;
+    }
+
+    if (mapfile)
+    {
+        template->map = exputl_keymap_create();
+
+        /* Allow for mapfile to actually be newline-separated key-value pairs. */
+        fptr = fopen(mapfile, "r");
+        if (fptr)
+        {
+            if (!exputl_keymap_parsefile(template->map, fptr))
+            {
+                exputl_keymap_destroy(&template->map);
+            }
+
+            fclose(fptr);
+        }
+        else if (!exputl_keymap_parsetable(template->map, mapfile))
+        {
+            /* Bad mapfile or map string - print a warning. */
+            fprintf(stderr, "drms_keyword_mapexport() - warning, keyword map file or string '%s' is invalid.\n", mapfile);
+            exputl_keymap_destroy(&template->map);
+        }
+    }
+
+    while (!err && (key = drms_record_nextkey(recin, &last, 0)) != NULL)
+    {
+        keyname = drms_keyword_getname(key);
+
+        if (drms_keyword_getimplicit(key))
+        {
+            continue;
+        }
+
+        if (seg)
+        {
+            /* do not look for per-segment keywords if the record belongs to a series that has no segments */
+            if (drms_keyword_getperseg(key))
+            {
+                snprintf(segnum, sizeof(segnum), "%03d", seg->info->segnum);
+
+                /* Ensure that this keyword is relevant to this segment. */
+                if (!strstr(keyname, segnum))
                 {
-                    /* Bad mapfile or map string - print a warning. */
-                    fprintf(stderr, "drms_keyword_mapexport() - warning, keyword map file or string '%s' is invalid.\n", mapfile);
-                    exputl_keymap_destroy(&map);
-                    mapfile = NULL;
+                    continue;
                 }
             }
+        }
 
-            /* calls cfitsio_append_header_key() */
-            if (fitsexport_mapexportkey(key, clname, map, &fitskeys, &fits_key))
+        if (template->nslots == nalloc)
+        {
+            nalloc = nalloc ? nalloc * 2 : 256;
+            slots = realloc(template->slots, nalloc * sizeof(FE_HeaderSlot_t));
+            if (!slots)
             {
-                fprintf(stderr, "Couldn't export keyword '%s'.\n", keyname);
-                statint = DRMS_ERROR_EXPORT;
+                err = 1;
+                break;
             }
-            else
+
+            template->slots = slots;
+        }
+
+        memset(&template->slots[template->nslots], 0, sizeof(FE_HeaderSlot_t));
+        template->slots[template->nslots].keyname = strdup(keyname);
+        if (!template->slots[template->nslots].keyname)
+        {
+            err = 1;
+            break;
+        }
+
+        template->slots[template->nslots].info = key->info;
+        CompileHeaderSlot(&template->slots[template->nslots], key, clname, template->map);
+        template->nslots++;
+    }
+
+    if (last)
+    {
+        hiter_destroy(&last);
+    }
+
+    /* series prime-key keywords */
+    if (!err)
+    {
+        ext_pkeys = drms_series_createpkeyarray(recin->env, recin->seriesinfo->seriesname, &npkeys, NULL);
+        if (ext_pkeys)
+        {
+            if (npkeys > 0)
             {
-                total_keys++;
-                if (ttypes)
-                {
-                    ttype = (CFITSIO_BINTABLE_TTYPE *)(fits_key->key_name);
-                    list_llinserttail(ttypes, &ttype);
-                }
+                template->primary_key = calloc(1, sz_primary_key);
+                template->primary_key = base_strcatalloc(template->primary_key, ext_pkeys[0], &sz_primary_key);
 
-                if (tforms)
+                for (pkey = 1; pkey < npkeys; pkey++)
                 {
-                    tform = (CFITSIO_BINTABLE_TFORM *)(fits_key->key_tform);
-                    list_llinserttail(tforms, &tform);
+                    template->primary_key = base_strcatalloc(template->primary_key, ", ", &sz_primary_key);
+                    template->primary_key = base_strcatalloc(template->primary_key, ext_pkeys[pkey], &sz_primary_key);
                 }
             }
+
+            drms_series_destroypkeyarray(&ext_pkeys, npkeys);
+        }
+    }
+
+    if (err)
+    {
+        DestroyHeaderTemplate(&template);
+    }
+
+    return template;
+}
+
+/* the template for recin's series; *temporary is set if the caller must destroy the template (it could not be kept) */
+static FE_HeaderTemplate_t *GetHeaderTemplate(DRMS_Record_t *recin, DRMS_Segment_t *seg, const char *clname, const char *mapfile, int *temporary)
+{
+    FE_HeaderTemplate_t *template = NULL;
+    FE_HeaderTemplate_t **ptemplate = NULL;
+    char *hashkey = NULL;
+    size_t sz_hashkey;
+
+    *temporary = 1;
+
+    if (!gHeaderTemplates)
+    {
+        gHeaderTemplates = hcon_create(sizeof(FE_HeaderTemplate_t *), DRMS_MAXHASHKEYLEN, FreeHeaderTemplate, NULL, NULL, NULL, 0);
+
+        if (gHeaderTemplates)
+        {
+            /* Register for clean up (also in the misc library) */
+            BASE_Cleanup_t cu;
+            cu.item = gHeaderTemplates;
+            cu.free = FreeHeaderTemplates;
+            base_cleanup_register("fitsheadertemplates", &cu);
+        }
+    }
+
+    sz_hashkey = strlen(recin->seriesinfo->seriesname) + (clname ? strlen(clname) : 0) + (mapfile ? strlen(mapfile) : 0) + 32;
+    hashkey = malloc(sz_hashkey);
+
+    if (gHeaderTemplates && hashkey)
+    {
+        snprintf(hashkey, sz_hashkey, "%s:%d:%s:%s", recin->seriesinfo->seriesname, seg ? seg->info->segnum : -1, clname ? clname : "", mapfile ? mapfile : "");
+        ptemplate = (FE_HeaderTemplate_t **)hcon_lookup(gHeaderTemplates, hashkey);
+
+        if (ptemplate)
+        {
+            template = *ptemplate;
+            *temporary = 0;
         }
     }
 
+    if (!template)
+    {
+        template = CreateHeaderTemplate(recin, seg, clname, mapfile);
+
+        if (template && gHeaderTemplates && hashkey)
+        {
+            if (hcon_insert(gHeaderTemplates, hashkey, &template) == 0)
+            {
+                *temporary = 0;
+            }
+        }
+    }
+
+    if (hashkey)
+    {
+        free(hashkey);
+    }
+
+    return template;
+}
+
+/* maps the record's value of the keyword in slot; the FITS keywords made are returned in *fitskeys_out (not appended to a
+ * list, which would be a walk of the list for each keyword), and the last one in *fits_key */
+static int MapHeaderSlot(FE_HeaderTemplate_t *template, FE_HeaderSlot_t *slot, DRMS_Keyword_t *key, const char *clname, CFITSIO_KEYWORD **fitskeys_out, CFITSIO_KEYWORD **fits_key)
+{
+    int stat = DRMS_SUCCESS;
+    DRMS_Keyword_t *keywval = NULL;
+    void *fitskwval = NULL;
+    char unit_new[CFITSIO_MAX_COMMENT] = {0};
+    void *extra = NULL;
+    char *wcs_extra[2];
+    int fitsrwRet = 0;
+    int rv = 0;
+
+    if (slot->type != kFE_HeaderSlot_Mapped && key->info == slot->info)
+    {
+        /* follow link if key is a linked keyword, otherwise, use key */
+        keywval = drms_keyword_lookup(key->record, key->info->name, 1);
+    }
+
+    if (!keywval || keywval->info != slot->value_info)
+    {
+        return fitsexport_mapexportkey(key, clname, template->map, fitskeys_out, fits_key);
+    }
+
+    if (slot->type == kFE_HeaderSlot_Handler)
+    {
+        if (ExportHandlers[slot->reserved] == DateHndlr)
+        {
+            /* comment has no internal info */
+            extra = slot->comment_external;
+        }
+        else if (ExportHandlers[slot->reserved] == WCSHandler)
+        {
+            /* comment has no internal info */
+            wcs_extra[0] = slot->comment_external;
+            wcs_extra[1] = slot->keyword_stem;
+            extra = wcs_extra;
+        }
+
+        rv = (*(ExportHandlers[slot->reserved]))(keywval, (void **)fitskeys_out, (void *)fits_key, (void *)slot->nameout, extra);
+
+        if (rv == 2)
+        {
+            stat = DRMS_ERROR_FITSRW;
+        }
+        else if (rv == 1)
+        {
+            stat = DRMS_ERROR_INVALIDDATA;
+        }
+    }
+    else if (FITSKeyValue(keywval, slot->external_type, &fitskwval, unit_new, sizeof(unit_new)) == 0)
+    {
+        if (CFITSIO_SUCCESS != (fitsrwRet = cfitsio_append_header_key(NULL, slot->nameout, slot->fitstype, slot->number_bytes, fitskwval, slot->format, slot->short_comment, *unit_new != '\0' ? unit_new : keywval->info->unit, fits_key)))
+        {
+            fprintf(stderr, "FITSRW returned '%d'.\n", fitsrwRet);
+            stat = DRMS_ERROR_FITSRW;
+        }
+        else
+        {
+            *fitskeys_out = *fits_key;
+        }
+
+        if (fitskwval)
+        {
+            free(fitskwval);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Could not convert DRMS keyword '%s' to FITS keyword.\n", key->info->name);
+        stat = DRMS_ERROR_INVALIDDATA;
+    }
+
+    return stat;
+}
+
+/* appends the list keys to the list whose head is *fitskeys and whose last element is *tail */
+static void SpliceKeys(CFITSIO_KEYWORD **fitskeys, CFITSIO_KEYWORD **tail, CFITSIO_KEYWORD *keys)
+{
+    if (keys)
+    {
+        if (*tail)
+        {
+            (*tail)->next = keys;
+        }
+        else
+        {
+            *fitskeys = keys;
+        }
+
+        for (*tail = keys; (*tail)->next; *tail = (*tail)->next);
+    }
+}
+
+/* Map keys that are specific to a segment to fits keywords.  User must free.
+ * Follows keyword links and ensures that per-segment keywords are relevant
+ * to this seg's keywords. */
+
+/* Input seg must be the src seg, not the target seg, if the input seg is a linked segment. */
+CFITSIO_KEYWORD *fitsexport_mapkeys(DRMS_Record_t *rec, DRMS_Segment_t *seg, const char *clname, const char *mapfile, int *num_keys, LinkedList_t *ttypes, LinkedList_t *tforms, int *status)
+{
+    CFITSIO_KEYWORD *fitskeys = NULL;
+    CFITSIO_KEYWORD *fitskeys_tail = NULL;
+    CFITSIO_KEYWORD *slot_keys = NULL;
+    CFITSIO_KEYWORD *fits_key = NULL;
+    int total_keys = 0;
+    int statint = DRMS_SUCCESS;
+    DRMS_Keyword_t *key = NULL;
+    DRMS_Record_t *recin = (seg ? seg->record : rec);
+    FE_HeaderTemplate_t *template = NULL;
+    int temporary = 0;
+    int islot;
+    char drms_id[CFITSIO_MAX_COMMENT];
+    int fitsrwRet = 0;
+    CFITSIO_BINTABLE_TTYPE *ttype = NULL;
+    CFITSIO_BINTABLE_TFORM *tform = NULL;
+
+    template = GetHeaderTemplate(recin, seg, clname, mapfile, &temporary);
+    if (!template)
+    {
+        fprintf(stderr, "[ fitsexport_mapkeys() ] out of memory\n");
+
+        if (status)
+        {
+            *status = DRMS_ERROR_OUTOFMEMORY;
+        }
+
+        return NULL;
+    }
+
+    total_keys = 0;
+    for (islot = 0; islot < template->nslots; islot++)
+    {
+        key = drms_keyword_lookup(recin, template->slots[islot].keyname, 0);
+        if (!key)
+        {
+            continue;
+        }
+
+        /* calls cfitsio_append_header_key() */
+        slot_keys = NULL;
+        if (MapHeaderSlot(template, &template->slots[islot], key, clname, &slot_keys, &fits_key))
+        {
+            fprintf(stderr, "Couldn't export keyword '%s'.\n", template->slots[islot].keyname);
+            statint = DRMS_ERROR_EXPORT;
+        }
+        else
+        {
+            total_keys++;
+            if (ttypes)
+            {
+                ttype = (CFITSIO_BINTABLE_TTYPE *)(fits_key->key_name);
+                list_llinserttail(ttypes, &ttype);
+            }
+
+            if (tforms)
+            {
+                tform = (CFITSIO_BINTABLE_TFORM *)(fits_key->key_tform);
+                list_llinserttail(tforms, &tform);
+            }
+        }
+
+        SpliceKeys(&fitskeys, &fitskeys_tail, slot_keys);
+    }
+
     /* Export recnum to facilitate the association between an exported FITS file and its record of origin. */
     long long recnum = recin->recnum;
-    if (CFITSIO_SUCCESS != (fitsrwRet = cfitsio_append_header_key(&fitskeys, kFERecnum, kFITSRW_Type_Integer, 8, (void *)&recnum, kFERecnumFormat, kFERecnumCommentShort, NULL, &fits_key)))
+    if (CFITSIO_SUCCESS != (fitsrwRet = cfitsio_append_header_key(NULL, kFERecnum, kFITSRW_Type_Integer, 8, (void *)&recnum, kFERecnumFormat, kFERecnumCommentShort, NULL, &fits_key)))
     {
         fprintf(stderr, "FITSRW returned '%d'.\n", fitsrwRet);
         statint = DRMS_ERROR_FITSRW;
     }
     else
     {
+        SpliceKeys(&fitskeys, &fitskeys_tail, fits_key);
+
         total_keys++;
         if (ttypes)
         {
@@ -2570,13 +3182,15 @@ CFITSIO_KEYWORD *fitsexport_mapkeys(DRMS_Record_t *rec, DRMS_Segment_t *seg, con
 
     /* recnum is nice, but to uniquely ID every image, we need series/recnum/[segment] (segment is optional, since there might not be a segment) */
     snprintf(drms_id, sizeof(drms_id), "%s:%lld:%s", recin->seriesinfo->seriesname, recnum, seg ? seg->info->name : "no_segment");
-    if (CFITSIO_SUCCESS != (fitsrwRet = cfitsio_append_header_key(&fitskeys, kFE_DRMS_ID, kFITSRW_Type_String, 0, (void *)drms_id, kFE_DRMS_ID_FORMAT, kFE_DRMS_ID_COMMENT_SHORT, NULL, &fits_key)))
+    if (CFITSIO_SUCCESS != (fitsrwRet = cfitsio_append_header_key(NULL, kFE_DRMS_ID, kFITSRW_Type_String, 0, (void *)drms_id, kFE_DRMS_ID_FORMAT, kFE_DRMS_ID_COMMENT_SHORT, NULL, &fits_key)))
     {
         fprintf(stderr, "FITSRW returned '%d'\n", fitsrwRet);
         statint = DRMS_ERROR_FITSRW;
     }
     else
     {
+        SpliceKeys(&fitskeys, &fitskeys_tail, fits_key);
+
         total_keys++;
         if (ttypes)
         {
@@ -2592,31 +3206,15 @@ CFITSIO_KEYWORD *fitsexport_mapkeys(DRMS_Record_t *rec, DRMS_Segment_t *seg, con
     }
 
     /* add series prime-key keywords */
-    ext_pkeys = drms_series_createpkeyarray(recin->env, recin->seriesinfo->seriesname, &npkeys, NULL);
-    if (ext_pkeys)
-    {
-        if (npkeys > 0)
-        {
-            primary_key = calloc(1, sz_primary_key);
-            primary_key = base_strcatalloc(primary_key, ext_pkeys[0], &sz_primary_key);
-
-            for (pkey = 1; pkey < npkeys; pkey++)
-            {
-                primary_key = base_strcatalloc(primary_key, ", ", &sz_primary_key);
-                primary_key = base_strcatalloc(primary_key, ext_pkeys[pkey], &sz_primary_key);
-            }
-        }
-
-        drms_series_destroypkeyarray(&ext_pkeys, npkeys);
-    }
-
-    if (CFITSIO_SUCCESS != (fitsrwRet = cfitsio_append_header_key(&fitskeys, kFE_PRIMARY_KEY, kFITSRW_Type_String, 0, (void *)primary_key, kFE_PRIMARY_KEY_FORMAT, kFE_PRIMARY_KEY_SHORT, NULL, &fits_key)))
+    if (CFITSIO_SUCCESS != (fitsrwRet = cfitsio_append_header_key(NULL, kFE_PRIMARY_KEY, kFITSRW_Type_String, 0, (void *)template->primary_key, kFE_PRIMARY_KEY_FORMAT, kFE_PRIMARY_KEY_SHORT, NULL, &fits_key)))
     {
         fprintf(stderr, "FITSRW returned '%d'\n", fitsrwRet);
         statint = DRMS_ERROR_FITSRW;
     }
     else
     {
+        SpliceKeys(&fitskeys, &fitskeys_tail, fits_key);
+
         total_keys++;
         if (ttypes)
         {
@@ -2631,13 +3229,15 @@ CFITSIO_KEYWORD *fitsexport_mapkeys(DRMS_Record_t *rec, DRMS_Segment_t *seg, con
         }
     }
 
-    if (CFITSIO_SUCCESS != (fitsrwRet = cfitsio_append_header_key(&fitskeys, kFE_LICENSE, kFITSRW_Type_String, 0, (void *)kFE_LICENSE, kFE_LICENSE_FORMAT, kFE_LICENSE_SHORT, NULL, &fits_key)))
+    if (CFITSIO_SUCCESS != (fitsrwRet = cfitsio_append_header_key(NULL, kFE_LICENSE, kFITSRW_Type_String, 0, (void *)kFE_LICENSE, kFE_LICENSE_FORMAT, kFE_LICENSE_SHORT, NULL, &fits_key)))
     {
         fprintf(stderr, "FITSRW returned '%d'\n", fitsrwRet);
         statint = DRMS_ERROR_FITSRW;
     }
     else
     {
+        SpliceKeys(&fitskeys, &fitskeys_tail, fits_key);
+
         total_keys++;
         if (ttypes)
         {
@@ -2652,20 +3252,9 @@ CFITSIO_KEYWORD *fitsexport_mapkeys(DRMS_Record_t *rec, DRMS_Segment_t *seg, con
         }
     }
 
-    if (primary_key)
-    {
-        free(primary_key);
-        primary_key = NULL;
-    }
-
-    if (map)
+    if (temporary)
     {
-        exputl_keymap_destroy(&map);
-    }
-
-    if (last)
-    {
-        hiter_destroy(&last);
+        DestroyHeaderTemplate(&template);
     }
 
     if (num_keys)
@@ -2723,31 +3312,12 @@ int fitsexport_mapexportkey(DRMS_Keyword_t *key, const char *clname, Exputl_KeyM
             {
                 FE_ReservedKeys_t *ikey = NULL;
                 char keyword_stem[16] = {0};
-                static regex_t *reg_expression = NULL;
-                const char *indexed_keyword_pattern = "^([A-Za-z])+[0-9]+$";
-                regmatch_t matches[2]; /* index 0 is the entire string */
 
-                /* ART - this does not get freed! */
-                if (!reg_expression)
-                {
-                    reg_expression = calloc(1, sizeof(regex_t));
-                    if (regcomp(reg_expression, indexed_keyword_pattern, REG_EXTENDED) != 0)
-                    {
-                        stat = DRMS_ERROR_FITSRW;
-                    }
-                }
+                stat = ReservedKeyLookup(key, keyword_stem, sizeof(keyword_stem), &ikey);
 
                 if (stat == DRMS_SUCCESS)
                 {
-                    snprintf(keyword_stem, sizeof(keyword_stem), "%s", key->info->name);
-                    if (regexec(reg_expression, keyword_stem, sizeof(matches) / sizeof(matches[0]), matches, 0) == 0)
-                    {
-                        /* match, indexed */
-                        keyword_stem[matches[1].rm_eo] = '\0';
-                    }
-
-                    /* since WCS keywords can be indexed, remove the index part before checking for a handler */
-                    if (gReservedFits && (ikey = (FE_ReservedKeys_t *)hcon_lookup_lower(gReservedFits, keyword_stem)))
+                    if (ikey)
                     {
                         if (ExportHandlers[*ikey])
                         {
@@ -42,6 +42,15 @@ int fitsexport_mapexport_tofile2(DRMS_Record_t *rec, DRMS_Segment_t *seg, long l
 
 int fitsexport_mapexport_to_cfitsio_file(CFITSIO_FILE *file, DRMS_Segment_t *seg, const char *clname, const char *mapfile);
 
+/* fitsexport_mapexport_to_cfitsio_file() in two steps, so that the CFITSIO work (re-compression, checksums) can be done
+ * off the DRMS thread: fitsexport_mapexport_prepare() does the DRMS part, and fitsexport_export_prepared_to_cfitsio_file()
+ * the rest */
+int fitsexport_mapexport_prepare(DRMS_Segment_t *seg, const char *clname, const char *mapfile, char *filename, DRMS_Protocol_t *protocol, CFITSIO_KEYWORD **fitskeys);
+
+int fitsexport_export_prepared_to_cfitsio_file(CFITSIO_FILE *file, const char *filename, DRMS_Protocol_t protocol, CFITSIO_KEYWORD *fitskeys);
+
+int fitsexport_export_prepared_tofile(const char *filename, DRMS_Protocol_t protocol, CFITSIO_KEYWORD *fitskeys, DRMS_Segment_t *actualSeg, const char *cparms, const char *fileout, char **actualfname, unsigned long long *expsize);
+
 int fitsexport_mapexport_keywords_to_cfitsio_file(CFITSIO_FILE *file, DRMS_Record_t *rec, long long row_number, const char *clname, const char *mapfile);
 
 int fitsexport_mapexport_data_tofile(DRMS_Segment_t *output_segment, DRMS_Array_t *image_array, const char *output_path, const char *file_name_format);
@@ -6,7 +6,7 @@ d		:= $(dir)
 # Local variables
 LIBEXPUTL	:= $(d)/libexputl.a
 
-OBJ_$(d)	:= $(addprefix $(d)/, exputil.o keymap.o)
+OBJ_$(d)	:= $(addprefix $(d)/, exputil.o keymap.o tarstream.o expcache.o)
 
 LIBEXPUTL_OBJ	:= $(OBJ_$(d))
 
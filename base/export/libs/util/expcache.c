@@ -0,0 +1,458 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include "expcache.h"
+
+#define EXPCACHE_BUFSIZE (1024 * 1024)
+#define EXPCACHE_STALE_TMP 3600 /* a tmp file this many seconds old was left by a process that died */
+
+typedef struct ExpCacheEntry_struct
+{
+    char path[PATH_MAX];
+    unsigned long long size;
+    time_t mtime;
+} ExpCacheEntry_t;
+
+static int MkDir(const char *dir)
+{
+    if (mkdir(dir, 02775) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "cannot create cache directory %s: %s\n", dir, strerror(errno));
+        return 1;
+    }
+
+    return 0;
+}
+
+/* keys are hex digests - nothing that could step out of the cache directory */
+static int KeyOK(const char *key)
+{
+    const char *pch = NULL;
+
+    if (!key || strlen(key) < 3 || strlen(key) > 128)
+    {
+        return 0;
+    }
+
+    for (pch = key; *pch; pch++)
+    {
+        if (!isxdigit((unsigned char)*pch))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void CachePath(ExpCache_t *cache, const char *key, char *subdir, size_t szsubdir, char *path, size_t szpath)
+{
+    snprintf(subdir, szsubdir, "%s/%.2s", cache->dir, key);
+    snprintf(path, szpath, "%s/%s", subdir, key);
+}
+
+/* copy src to a new file dst (for a cache on another file system than the export); kExpCacheStat_Miss if src does
+ * not exist */
+static ExpCacheStat_t CopyFile(const char *src, const char *dst)
+{
+    ExpCacheStat_t status = kExpCacheStat_Success;
+    char *buf = NULL;
+    char *pbuf = NULL;
+    ssize_t nread;
+    ssize_t nwritten;
+    int fdin = -1;
+    int fdout = -1;
+
+    buf = malloc(EXPCACHE_BUFSIZE);
+    if (!buf)
+    {
+        return kExpCacheStat_OutOfMemory;
+    }
+
+    fdin = open(src, O_RDONLY);
+    if (fdin == -1)
+    {
+        status = (errno == ENOENT) ? kExpCacheStat_Miss : kExpCacheStat_IO;
+    }
+    else
+    {
+        fdout = open(dst, O_WRONLY | O_CREAT | O_EXCL, 0664);
+        if (fdout == -1)
+        {
+            status = kExpCacheStat_IO;
+        }
+    }
+
+    while (status == kExpCacheStat_Success && (nread = read(fdin, buf, EXPCACHE_BUFSIZE)) != 0)
+    {
+        if (nread < 0)
+        {
+            if (errno != EINTR)
+            {
+                status = kExpCacheStat_IO;
+            }
+
+            continue;
+        }
+
+        for (pbuf = buf; status == kExpCacheStat_Success && nread > 0; )
+        {
+            nwritten = write(fdout, pbuf, nread);
+            if (nwritten < 0)
+            {
+                if (errno != EINTR)
+                {
+                    status = kExpCacheStat_IO;
+                }
+            }
+            else
+            {
+                pbuf += nwritten;
+                nread -= nwritten;
+            }
+        }
+    }
+
+    if (fdin != -1)
+    {
+        close(fdin);
+    }
+
+    if (fdout != -1)
+    {
+        if (close(fdout) != 0)
+        {
+            status = kExpCacheStat_IO;
+        }
+
+        if (status != kExpCacheStat_Success)
+        {
+            unlink(dst);
+        }
+    }
+
+    if (status != kExpCacheStat_Success && status != kExpCacheStat_Miss)
+    {
+        fprintf(stderr, "cannot copy %s to %s: %s\n", src, dst, strerror(errno));
+    }
+
+    free(buf);
+
+    return status;
+}
+
+/* a hard link if possible, else a copy; kExpCacheStat_Miss if src does not exist (it was removed by another process) */
+static ExpCacheStat_t LinkOrCopy(const char *src, const char *dst)
+{
+    struct stat stBuf;
+
+    if (link(src, dst) == 0)
+    {
+        return kExpCacheStat_Success;
+    }
+
+    if (errno == EXDEV || errno == EPERM || errno == EMLINK)
+    {
+        return CopyFile(src, dst);
+    }
+
+    /* ENOENT is also the error for a missing directory in dst */
+    if (errno == ENOENT && lstat(src, &stBuf) != 0 && errno == ENOENT)
+    {
+        return kExpCacheStat_Miss;
+    }
+
+    fprintf(stderr, "cannot link %s to %s: %s\n", src, dst, strerror(errno));
+    return kExpCacheStat_IO;
+}
+
+ExpCacheStat_t expcache_init(ExpCache_t *cache, const char *dir, unsigned long long maxbytes)
+{
+    memset(cache, 0, sizeof(ExpCache_t));
+
+    if (!dir || !*dir || strlen(dir) >= sizeof(cache->dir) - 256)
+    {
+        fprintf(stderr, "invalid cache directory\n");
+        return kExpCacheStat_IO;
+    }
+
+    snprintf(cache->dir, sizeof(cache->dir), "%s", dir);
+    cache->maxbytes = maxbytes;
+
+    return MkDir(cache->dir) ? kExpCacheStat_IO : kExpCacheStat_Success;
+}
+
+ExpCacheStat_t expcache_get(ExpCache_t *cache, const char *key, const char *path, unsigned long long *size)
+{
+    ExpCacheStat_t status = kExpCacheStat_Success;
+    char subdir[PATH_MAX];
+    char cpath[PATH_MAX];
+    struct stat stBuf;
+
+    if (!KeyOK(key))
+    {
+        return kExpCacheStat_BadKey;
+    }
+
+    CachePath(cache, key, subdir, sizeof(subdir), cpath, sizeof(cpath));
+
+    if (stat(cpath, &stBuf) != 0 || !S_ISREG(stBuf.st_mode))
+    {
+        cache->misses++;
+        return kExpCacheStat_Miss;
+    }
+
+    /* path may be a link left by an earlier try of this export */
+    if (unlink(path) != 0 && errno != ENOENT)
+    {
+        fprintf(stderr, "cannot remove %s: %s\n", path, strerror(errno));
+        return kExpCacheStat_IO;
+    }
+
+    status = LinkOrCopy(cpath, path);
+
+    if (status == kExpCacheStat_Success)
+    {
+        /* most recently used; a failure here only makes the file look older to expcache_trim() */
+        utimes(cpath, NULL);
+
+        cache->hits++;
+        cache->bytessaved += stBuf.st_size;
+
+        if (size)
+        {
+            *size = stBuf.st_size;
+        }
+    }
+    else if (status == kExpCacheStat_Miss)
+    {
+        /* trimmed by another process since the stat() */
+        cache->misses++;
+    }
+
+    return status;
+}
+
+ExpCacheStat_t expcache_put(ExpCache_t *cache, const char *key, const char *path)
+{
+    ExpCacheStat_t status = kExpCacheStat_Success;
+    char subdir[PATH_MAX];
+    char cpath[PATH_MAX];
+    char tmppath[PATH_MAX];
+    struct stat stBuf;
+
+    if (!KeyOK(key))
+    {
+        return kExpCacheStat_BadKey;
+    }
+
+    if (lstat(path, &stBuf) != 0 || !S_ISREG(stBuf.st_mode))
+    {
+        fprintf(stderr, "%s is not a regular file - not cached\n", path);
+        return kExpCacheStat_IO;
+    }
+
+    if (cache->maxbytes > 0 && (unsigned long long)stBuf.st_size > cache->maxbytes)
+    {
+        /* would be trimmed right away */
+        return kExpCacheStat_Success;
+    }
+
+    CachePath(cache, key, subdir, sizeof(subdir), cpath, sizeof(cpath));
+
+    if (access(cpath, F_OK) == 0)
+    {
+        /* another export made it */
+        return kExpCacheStat_Success;
+    }
+
+    if (MkDir(subdir))
+    {
+        return kExpCacheStat_IO;
+    }
+
+    /* readers never see a partial file - it appears under key with rename() */
+    snprintf(tmppath, sizeof(tmppath), "%s/.%s.%d", subdir, key, (int)getpid());
+    unlink(tmppath);
+    status = LinkOrCopy(path, tmppath);
+
+    if (status == kExpCacheStat_Miss)
+    {
+        fprintf(stderr, "%s was removed - not cached\n", path);
+        status = kExpCacheStat_IO;
+    }
+    else if (status == kExpCacheStat_Success)
+    {
+        if (rename(tmppath, cpath) != 0)
+        {
+            fprintf(stderr, "cannot rename %s to %s: %s\n", tmppath, cpath, strerror(errno));
+            unlink(tmppath);
+            status = kExpCacheStat_IO;
+        }
+        else
+        {
+            cache->bytesstored += stBuf.st_size;
+        }
+    }
+
+    return status;
+}
+
+static int CmpEntryMtime(const void *a, const void *b)
+{
+    const ExpCacheEntry_t *ea = (const ExpCacheEntry_t *)a;
+    const ExpCacheEntry_t *eb = (const ExpCacheEntry_t *)b;
+
+    return (ea->mtime > eb->mtime) - (ea->mtime < eb->mtime);
+}
+
+/* removes DIR/xx/.tmp files that are old enough to be abandoned, and returns the cached files in entries */
+static ExpCacheStat_t ListEntries(ExpCache_t *cache, ExpCacheEntry_t **entries, size_t *nentries, unsigned long long *total)
+{
+    ExpCacheStat_t status = kExpCacheStat_Success;
+    DIR *dir = NULL;
+    DIR *subdir = NULL;
+    struct dirent *dirEntry = NULL;
+    struct dirent *subdirEntry = NULL;
+    char subdirpath[PATH_MAX];
+    char path[PATH_MAX];
+    struct stat stBuf;
+    ExpCacheEntry_t *list = NULL;
+    ExpCacheEntry_t *newlist = NULL;
+    size_t nalloc = 0;
+    size_t num = 0;
+    time_t now = time(NULL);
+
+    *total = 0;
+
+    dir = opendir(cache->dir);
+    if (!dir)
+    {
+        fprintf(stderr, "cannot open cache directory %s: %s\n", cache->dir, strerror(errno));
+        return kExpCacheStat_IO;
+    }
+
+    while (status == kExpCacheStat_Success && (dirEntry = readdir(dir)) != NULL)
+    {
+        if (*dirEntry->d_name == '.')
+        {
+            continue;
+        }
+
+        snprintf(subdirpath, sizeof(subdirpath), "%s/%s", cache->dir, dirEntry->d_name);
+        subdir = opendir(subdirpath);
+        if (!subdir)
+        {
+            continue;
+        }
+
+        while (status == kExpCacheStat_Success && (subdirEntry = readdir(subdir)) != NULL)
+        {
+            if (strcmp(subdirEntry->d_name, ".") == 0 || strcmp(subdirEntry->d_name, "..") == 0)
+            {
+                continue;
+            }
+
+            snprintf(path, sizeof(path), "%s/%s", subdirpath, subdirEntry->d_name);
+            if (lstat(path, &stBuf) != 0 || !S_ISREG(stBuf.st_mode))
+            {
+                continue;
+            }
+
+            if (*subdirEntry->d_name == '.')
+            {
+                if (now - stBuf.st_mtime > EXPCACHE_STALE_TMP)
+                {
+                    unlink(path);
+                }
+
+                continue;
+            }
+
+            if (num == nalloc)
+            {
+                nalloc = nalloc ? nalloc * 2 : 1024;
+                newlist = realloc(list, nalloc * sizeof(ExpCacheEntry_t));
+                if (!newlist)
+                {
+                    status = kExpCacheStat_OutOfMemory;
+                    break;
+                }
+
+                list = newlist;
+            }
+
+            snprintf(list[num].path, sizeof(list[num].path), "%s", path);
+            list[num].size = stBuf.st_size;
+            list[num].mtime = stBuf.st_mtime;
+            *total += stBuf.st_size;
+            num++;
+        }
+
+        closedir(subdir);
+    }
+
+    closedir(dir);
+
+    if (status != kExpCacheStat_Success)
+    {
+        free(list);
+        list = NULL;
+        num = 0;
+    }
+
+    *entries = list;
+    *nentries = num;
+
+    return status;
+}
+
+ExpCacheStat_t expcache_trim(ExpCache_t *cache)
+{
+    ExpCacheStat_t status = kExpCacheStat_Success;
+    ExpCacheEntry_t *entries = NULL;
+    size_t nentries = 0;
+    size_t iEntry;
+    unsigned long long total = 0;
+
+    if (cache->maxbytes == 0)
+    {
+        /* no limit */
+        return kExpCacheStat_Success;
+    }
+
+    status = ListEntries(cache, &entries, &nentries, &total);
+
+    if (status == kExpCacheStat_Success && total > cache->maxbytes)
+    {
+        qsort(entries, nentries, sizeof(ExpCacheEntry_t), CmpEntryMtime);
+
+        /* a file another process is linking to stays readable through the export's link */
+        for (iEntry = 0; iEntry < nentries && total > cache->maxbytes; iEntry++)
+        {
+            if (unlink(entries[iEntry].path) == 0 || errno == ENOENT)
+            {
+                total -= entries[iEntry].size;
+            }
+        }
+    }
+
+    free(entries);
+
+    return status;
+}
+
+double expcache_hitratio(ExpCache_t *cache)
+{
+    unsigned long long lookups = cache->hits + cache->misses;
+
+    return lookups > 0 ? (double)cache->hits / lookups : 0;
+}
@@ -0,0 +1,47 @@
+#ifndef _EXPUTL_EXPCACHE_H
+#define _EXPUTL_EXPCACHE_H
+
+#include <limits.h>
+
+/* A content-addressed cache of exported files. An exported file is stored under a key - a hex digest of everything
+ * the file's content depends on - as DIR/<first 2 chars of key>/<key>. A later export with the same key gets a hard
+ * link to the cached file (a copy if the cache is on another file system) instead of making the file again. A hit
+ * sets the cached file's mtime to now, and expcache_trim() removes the files with the oldest mtimes until the cache
+ * holds at most maxbytes (LRU). Several processes can share a cache directory; files are added with rename().
+ */
+
+typedef enum
+{
+   kExpCacheStat_Success,
+   kExpCacheStat_Miss,
+   kExpCacheStat_BadKey,
+   kExpCacheStat_IO,
+   kExpCacheStat_OutOfMemory
+} ExpCacheStat_t;
+
+typedef struct ExpCache_struct
+{
+    char dir[PATH_MAX];
+    unsigned long long maxbytes;
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long bytessaved; /* total size of the files got from the cache */
+    unsigned long long bytesstored; /* total size of the files added to the cache */
+} ExpCache_t;
+
+/* dir is created if it does not exist */
+ExpCacheStat_t expcache_init(ExpCache_t *cache, const char *dir, unsigned long long maxbytes);
+
+/* make path the cached file for key; kExpCacheStat_Miss if there is none (path is then not touched) */
+ExpCacheStat_t expcache_get(ExpCache_t *cache, const char *key, const char *path, unsigned long long *size);
+
+/* add the regular file at path to the cache as key */
+ExpCacheStat_t expcache_put(ExpCache_t *cache, const char *key, const char *path);
+
+/* remove least-recently-used files until the cache holds at most maxbytes */
+ExpCacheStat_t expcache_trim(ExpCache_t *cache);
+
+/* hits / (hits + misses), or 0 if there were no lookups */
+double expcache_hitratio(ExpCache_t *cache);
+
+#endif /* _EXPUTL_EXPCACHE_H */
@@ -0,0 +1,385 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pwd.h>
+#include <grp.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include "tarstream.h"
+
+#define TARSTREAM_BUFSIZE (1024 * 1024)
+#define TARSTREAM_SENDFILE_CHUNK (64 * 1024 * 1024) /* bytes per sendfile() call */
+#define TARSTREAM_MAX_OCTAL_SIZE 077777777777ULL /* the largest size that fits the 11 octal digits */
+
+static const char sZeroBlock[TARSTREAM_BLOCK_SIZE * 2];
+
+static void FillOctal(char *field, size_t width, unsigned long long value)
+{
+    char buf[32];
+
+    /* width - 1 digits then a NUL */
+    snprintf(buf, sizeof(buf), "%0*llo", (int)width - 1, value);
+    memcpy(field, buf, width - 1);
+    field[width - 1] = '\0';
+}
+
+static void FillString(char *field, size_t width, const char *value)
+{
+    size_t len = strlen(value);
+
+    memcpy(field, value, len < width ? len : width);
+}
+
+TarStreamStat_t tarstream_init(TarStream_t *ts, int fd)
+{
+    TarStreamStat_t status = kTarStreamStat_Success;
+    struct passwd pwd;
+    struct passwd *resultPwd = NULL;
+    struct group grp;
+    struct group *resultGrp = NULL;
+    char *idBuf = NULL;
+    long idBufSize;
+
+    memset(ts, 0, sizeof(TarStream_t));
+    ts->fd = fd;
+    gettimeofday(&ts->start, NULL);
+
+    idBufSize = sysconf(_SC_GETPW_R_SIZE_MAX);
+    if (idBufSize < 16384)
+    {
+        idBufSize = 16384;
+    }
+
+    idBuf = malloc(idBufSize);
+    if (!idBuf)
+    {
+        return kTarStreamStat_OutOfMemory;
+    }
+
+    ts->uid = getuid();
+    getpwuid_r(ts->uid, &pwd, idBuf, idBufSize, &resultPwd);
+    if (!resultPwd)
+    {
+        fprintf(stderr, "user id %u not found\n", (unsigned int)ts->uid);
+        status = kTarStreamStat_GetUser;
+    }
+    else
+    {
+        ts->gid = pwd.pw_gid;
+        snprintf(ts->uname, sizeof(ts->uname), "%s", pwd.pw_name);
+
+        getgrgid_r(ts->gid, &grp, idBuf, idBufSize, &resultGrp);
+        if (!resultGrp)
+        {
+            fprintf(stderr, "group id %u not found\n", (unsigned int)ts->gid);
+            status = kTarStreamStat_GetGroup;
+        }
+        else
+        {
+            snprintf(ts->gname, sizeof(ts->gname), "%s", grp.gr_name);
+        }
+    }
+
+    free(idBuf);
+
+    return status;
+}
+
+void tarstream_free(TarStream_t *ts)
+{
+    if (ts->buf)
+    {
+        free(ts->buf);
+        ts->buf = NULL;
+    }
+
+    ts->bufsize = 0;
+}
+
+/* layout (offset, width): name 0 100, mode 100 8, uid 108 8, gid 116 8, size 124 12, mtime 136 12,
+ * chksum 148 8, typeflag 156 1, linkname 157 100, magic 257 6, version 263 2, uname 265 32,
+ * gname 297 32, devmajor 329 8, devminor 337 8, prefix 345 155 */
+void tarstream_mkheader(TarStream_t *ts, const char *name, unsigned long long size, time_t mtime, char *header)
+{
+    size_t len = strlen(name);
+    const char *slash = NULL;
+    unsigned long long chksum = 0;
+    int iByte;
+
+    memset(header, 0, TARSTREAM_BLOCK_SIZE);
+
+    if (len > 100)
+    {
+        /* the first '/' that leaves at most 100 chars of name (the prefix can have at most 155) */
+        for (slash = name + len - 101; *slash && *slash != '/'; slash++);
+
+        if (*slash == '/' && slash - name <= 155 && slash[1] != '\0')
+        {
+            memcpy(header + 345, name, slash - name);
+            name = slash + 1;
+        }
+    }
+
+    FillString(header, 100, name);
+    FillOctal(header + 100, 8, 0664);
+    FillOctal(header + 108, 8, ts->uid);
+    FillOctal(header + 116, 8, ts->gid);
+
+    if (size > TARSTREAM_MAX_OCTAL_SIZE)
+    {
+        /* GNU/star base-256: high bit of the first byte set, then the big-endian value */
+        header[124] = (char)0x80;
+        for (iByte = 11; iByte > 0; iByte--, size >>= 8)
+        {
+            header[124 + iByte] = (char)(size & 0xff);
+        }
+    }
+    else
+    {
+        FillOctal(header + 124, 12, size);
+    }
+
+    FillOctal(header + 136, 12, (unsigned long long)mtime);
+
+    /* the checksum is computed with its own field set to spaces */
+    memset(header + 148, ' ', 8);
+    header[156] = '0';
+    memcpy(header + 257, "ustar", 6);
+    memcpy(header + 263, "00", 2);
+    FillString(header + 265, 32, ts->uname);
+    FillString(header + 297, 32, ts->gname);
+
+    for (iByte = 0; iByte < TARSTREAM_BLOCK_SIZE; iByte++)
+    {
+        chksum += (unsigned char)header[iByte];
+    }
+
+    /* 6 octal digits, NUL, space */
+    FillOctal(header + 148, 7, chksum);
+    header[155] = ' ';
+}
+
+TarStreamStat_t tarstream_write(TarStream_t *ts, const char *buf, size_t size)
+{
+    ssize_t num;
+
+    while (size > 0)
+    {
+        num = write(ts->fd, buf, size);
+        if (num < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            fprintf(stderr, "unable to write to tar stream: %s\n", strerror(errno));
+            return kTarStreamStat_IO;
+        }
+
+        buf += num;
+        size -= num;
+        ts->nbytes += num;
+    }
+
+    return kTarStreamStat_Success;
+}
+
+/* 0-fill the last block of a member of size bytes */
+TarStreamStat_t tarstream_pad(TarStream_t *ts, unsigned long long size)
+{
+    size_t remainder = size % TARSTREAM_BLOCK_SIZE;
+
+    if (remainder != 0)
+    {
+        return tarstream_write(ts, sZeroBlock, TARSTREAM_BLOCK_SIZE - remainder);
+    }
+
+    return kTarStreamStat_Success;
+}
+
+TarStreamStat_t tarstream_header(TarStream_t *ts, const char *name, unsigned long long size)
+{
+    char header[TARSTREAM_BLOCK_SIZE];
+
+    tarstream_mkheader(ts, name, size, time(NULL), header);
+    ts->nfiles++;
+
+    return tarstream_write(ts, header, sizeof(header));
+}
+
+TarStreamStat_t tarstream_buffer(TarStream_t *ts, const char *name, const char *buf, size_t size)
+{
+    TarStreamStat_t status = kTarStreamStat_Success;
+
+    status = tarstream_header(ts, name, size);
+
+    if (status == kTarStreamStat_Success)
+    {
+        status = tarstream_write(ts, buf, size);
+    }
+
+    if (status == kTarStreamStat_Success)
+    {
+        status = tarstream_pad(ts, size);
+    }
+
+    return status;
+}
+
+/* copy size bytes of fd, from offset *copied, with pread()/write() */
+static TarStreamStat_t CopyFile(TarStream_t *ts, int fd, unsigned long long size, unsigned long long *copied)
+{
+    TarStreamStat_t status = kTarStreamStat_Success;
+    ssize_t num;
+
+    if (!ts->buf)
+    {
+        if (posix_memalign((void **)&ts->buf, sysconf(_SC_PAGESIZE), TARSTREAM_BUFSIZE))
+        {
+            ts->buf = NULL;
+            return kTarStreamStat_OutOfMemory;
+        }
+
+        ts->bufsize = TARSTREAM_BUFSIZE;
+    }
+
+    while (status == kTarStreamStat_Success && *copied < size)
+    {
+        num = pread(fd, ts->buf, size - *copied < ts->bufsize ? size - *copied : ts->bufsize, (off_t)*copied);
+        if (num < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            status = kTarStreamStat_IO;
+        }
+        else if (num == 0)
+        {
+            /* the file got shorter */
+            break;
+        }
+        else
+        {
+            status = tarstream_write(ts, ts->buf, num);
+            *copied += num;
+        }
+    }
+
+    return status;
+}
+
+/* store the first size bytes of the open file fd (from offset 0, whatever the fd's offset is) as member name - if the
+ * file has fewer bytes, the rest is 0-filled, so the archive stays readable */
+TarStreamStat_t tarstream_fd(TarStream_t *ts, int fd, const char *name, unsigned long long size, time_t mtime)
+{
+    TarStreamStat_t status = kTarStreamStat_Success;
+    char header[TARSTREAM_BLOCK_SIZE];
+    unsigned long long copied = 0;
+    off_t offset = 0;
+    ssize_t num;
+
+    tarstream_mkheader(ts, name, size, mtime, header);
+    ts->nfiles++;
+    status = tarstream_write(ts, header, sizeof(header));
+
+    while (status == kTarStreamStat_Success && !ts->nosendfile && copied < size)
+    {
+        num = sendfile(ts->fd, fd, &offset, size - copied < TARSTREAM_SENDFILE_CHUNK ? size - copied : TARSTREAM_SENDFILE_CHUNK);
+        if (num < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+            {
+                continue;
+            }
+
+            if (errno == EINVAL || errno == ENOSYS)
+            {
+                /* fd or ts->fd cannot be used with sendfile(); nothing was written */
+                ts->nosendfile = 1;
+                break;
+            }
+
+            fprintf(stderr, "unable to send %s to tar stream: %s\n", name, strerror(errno));
+            status = kTarStreamStat_IO;
+        }
+        else if (num == 0)
+        {
+            break;
+        }
+        else
+        {
+            copied += num;
+            ts->nbytes += num;
+        }
+    }
+
+    if (status == kTarStreamStat_Success && ts->nosendfile && copied < size)
+    {
+        status = CopyFile(ts, fd, size, &copied);
+    }
+
+    while (status == kTarStreamStat_Success && copied < size)
+    {
+        num = size - copied < sizeof(sZeroBlock) ? size - copied : sizeof(sZeroBlock);
+        status = tarstream_write(ts, sZeroBlock, num);
+        copied += num;
+    }
+
+    if (status == kTarStreamStat_Success)
+    {
+        status = tarstream_pad(ts, size);
+    }
+
+    return status;
+}
+
+/* store the file at path as member name; the size written in the header is the size when the file was opened */
+TarStreamStat_t tarstream_file(TarStream_t *ts, const char *path, const char *name)
+{
+    TarStreamStat_t status = kTarStreamStat_Success;
+    struct stat stBuf;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        fprintf(stderr, "cannot open file %s for reading\n", path);
+        return kTarStreamStat_IO;
+    }
+
+    if (fstat(fd, &stBuf) != 0 || !S_ISREG(stBuf.st_mode))
+    {
+        fprintf(stderr, "cannot get %s file status\n", path);
+        close(fd);
+        return kTarStreamStat_IO;
+    }
+
+    status = tarstream_fd(ts, fd, name, stBuf.st_size, stBuf.st_mtime);
+    close(fd);
+
+    return status;
+}
+
+/* end-of-archive marker - two 0 blocks */
+TarStreamStat_t tarstream_end(TarStream_t *ts)
+{
+    return tarstream_write(ts, sZeroBlock, sizeof(sZeroBlock));
+}
+
+double tarstream_rate(TarStream_t *ts)
+{
+    struct timeval now;
+    double secs;
+
+    gettimeofday(&now, NULL);
+    secs = (now.tv_sec - ts->start.tv_sec) + (now.tv_usec - ts->start.tv_usec) / 1.0e6;
+
+    return secs > 0 ? ts->nbytes / secs : 0;
+}
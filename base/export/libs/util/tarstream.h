@@ -0,0 +1,61 @@
+#ifndef _EXPUTL_TARSTREAM_H
+#define _EXPUTL_TARSTREAM_H
+
+#include <sys/types.h>
+#include <sys/time.h>
+
+/* Writes a ustar archive straight to a file descriptor. Headers are built in memory, and the bodies of
+ * on-disk files are moved to the descriptor with sendfile() (no copy through user space); if the descriptor
+ * or the file does not support that, large aligned read()/write() calls are used instead. Every member is
+ * 0-padded to a whole 512-byte block.
+ *
+ * A caller that also writes to the descriptor through a FILE stream must fflush() that stream before each
+ * tarstream_*() call.
+ */
+
+#define TARSTREAM_BLOCK_SIZE 512
+
+typedef enum
+{
+   kTarStreamStat_Success,
+   kTarStreamStat_IO,
+   kTarStreamStat_OutOfMemory,
+   kTarStreamStat_GetUser,
+   kTarStreamStat_GetGroup
+} TarStreamStat_t;
+
+typedef struct TarStream_struct
+{
+    int fd;
+    uid_t uid;
+    gid_t gid;
+    char uname[32];
+    char gname[32];
+    int nosendfile; /* sendfile() failed with EINVAL/ENOSYS once - do not try again */
+    char *buf; /* aligned buffer for the read()/write() fallback */
+    size_t bufsize;
+    unsigned long long nbytes; /* bytes written to fd */
+    unsigned long long nfiles; /* members written */
+    struct timeval start;
+} TarStream_t;
+
+/* user and group are looked up once, here, not for every member */
+TarStreamStat_t tarstream_init(TarStream_t *ts, int fd);
+void tarstream_free(TarStream_t *ts);
+
+/* fills header (TARSTREAM_BLOCK_SIZE bytes) for a regular file; a name longer than 100 chars is split into
+ * the ustar prefix at a '/' if possible, else it is truncated */
+void tarstream_mkheader(TarStream_t *ts, const char *name, unsigned long long size, time_t mtime, char *header);
+
+TarStreamStat_t tarstream_header(TarStream_t *ts, const char *name, unsigned long long size);
+TarStreamStat_t tarstream_write(TarStream_t *ts, const char *buf, size_t size);
+TarStreamStat_t tarstream_pad(TarStream_t *ts, unsigned long long size);
+TarStreamStat_t tarstream_buffer(TarStream_t *ts, const char *name, const char *buf, size_t size);
+TarStreamStat_t tarstream_file(TarStream_t *ts, const char *path, const char *name);
+TarStreamStat_t tarstream_fd(TarStream_t *ts, int fd, const char *name, unsigned long long size, time_t mtime);
+TarStreamStat_t tarstream_end(TarStream_t *ts);
+
+/* bytes per second written since tarstream_init() */
+double tarstream_rate(TarStream_t *ts);
+
+#endif /* _EXPUTL_TARSTREAM_H */
@@ -72,6 +72,8 @@ typedef struct DB_Handle_struct
   int isolation_level;      /* Transaction isolation level. */
   char dbport[1024];  /* Port on host connected to */
   char errmsg[4096]; /* Error message of last command. */
+  struct DB_Stream_struct *stream; /* Streamed query whose rows are still arriving on
+                                      the connection (NULL if none). */
 } DB_Handle_t;
 
 static inline void DB_ResetErrmsg(DB_Handle_t *dbh)
@@ -122,9 +124,15 @@ typedef struct DB_Column_struct
   unsigned int num_rows; /* Number of rows in the column.  */
   unsigned int size;     /* Size of data type. */
   char *data;            /* Array of type "type" holding the column data.
-			    The total length of *column_data is num_rows*size.  */
+			    The total length of *column_data is num_rows*size,
+			    unless offsets is set. */
   short *is_null;        /* An array of flags indicating if the field
 			    contained a NULL value. */
+  unsigned int *offsets; /* String columns only (NULL otherwise): num_rows+1
+			    offsets into data. Field i is the NUL-terminated
+			    string at data+offsets[i], and offsets[num_rows] is
+			    the length of data. size is then the width of the
+			    widest field (including the NUL). */
 } DB_Column_t;
 
 /* Binary query result table. */
@@ -148,6 +156,29 @@ typedef struct DB_Text_Result_struct
 			     and j'th column of the result. */
 } DB_Text_Result_t;
 
+/* Streamed binary query. Rows are received from the server a few at a time
+   (libpq single-row or chunked-rows mode) and handed out in batches by
+   db_stream_next(), so the whole result never has to be held in memory at
+   once. Only one streamed query can be in progress on a connection; if any
+   other statement is issued on the connection, the rows the stream has not
+   received yet are read into memory first ("parked"). */
+typedef struct DB_Stream_struct
+{
+  DB_Handle_t *dbh;
+  void **pending;          /* Results (PGresult *) received but not yet
+			      completely returned by db_stream_next() are
+			      pending[head] ... pending[npending - 1]. */
+  unsigned int head;
+  unsigned int npending;
+  unsigned int szpending;
+  unsigned int firstrow;   /* Rows of pending[head] already returned. */
+  unsigned int navail;     /* Rows received but not yet returned. */
+  int done;                /* 1 once the last row has been received. */
+  int failed;              /* 1 if the query failed. */
+  int discard;             /* 1 if db_stream_close() is throwing away the
+			      rows that are still arriving. */
+} DB_Stream_t;
+
 
 
 
@@ -199,6 +230,12 @@ DB_Binary_Result_t *db_query_binv(DB_Handle_t *dbin, const char *query, ...);
 DB_Binary_Result_t *db_query_bin_array(DB_Handle_t  *dbin, const char *query, int n_args, DB_Type_t *intype, void **argin);
 DB_Binary_Result_t **db_query_bin_ntuple(DB_Handle_t *dbin, const char *stmnt, unsigned int nelems, unsigned int nargs, DB_Type_t *dbtypes, void **values);
 
+/* Streamed binary queries. */
+DB_Stream_t *db_stream_open(DB_Handle_t *dbin, const char *query, unsigned int chunkrows);
+DB_Binary_Result_t *db_stream_next(DB_Stream_t *stream, unsigned int maxrows);
+void db_stream_close(DB_Stream_t **stream);
+int db_query_bin_stream(DB_Handle_t *dbin, const char *query, unsigned int batchrows, int (*batchfn)(DB_Binary_Result_t *batch, void *data), void *data);
+
 
 /* Functions for extraction the field values from a binary table. */
 /*char *db_binary_field_get(DB_Binary_Result_t *res, unsigned int row,
@@ -318,6 +355,12 @@ int db_server_query_txt(int sockfd, DB_Handle_t *db_handle);
 int db_server_query_bin(int sockfd, DB_Handle_t *db_handle);
 int db_server_query_bin_array(int sockfd, DB_Handle_t *db_handle);
 int db_server_query_bin_ntuple(int sockfd, DB_Handle_t *db_handle);
+/* The _ro variants run the query on ro_handle (if it is not NULL), and fall back to db_handle
+   (setting *rofailed to 1) if it fails there - e.g., because the query modifies the database. */
+int db_server_query_txt_ro(int sockfd, DB_Handle_t *ro_handle, DB_Handle_t *db_handle, int *rofailed);
+int db_server_query_bin_ro(int sockfd, DB_Handle_t *ro_handle, DB_Handle_t *db_handle, int *rofailed);
+int db_server_query_bin_array_ro(int sockfd, DB_Handle_t *ro_handle, DB_Handle_t *db_handle, int *rofailed);
+int db_server_query_bin_ntuple_ro(int sockfd, DB_Handle_t *ro_handle, DB_Handle_t *db_handle, int *rofailed);
 int db_server_dms(int sockfd, DB_Handle_t *db_handle);
 int db_server_dms_array(int sockfd, DB_Handle_t *db_handle);
 int db_server_bulk_insert_array(int sockfd, DB_Handle_t *db_handle);
@@ -383,12 +426,21 @@ static inline DB_Type_t db_binary_column_type(DB_Binary_Result_t *res,
 }
 
 
+/* Address of field row of a column, for either column layout. */
+static inline char *db_column_field(DB_Column_t *col, unsigned int row)
+{
+  if (col->offsets)
+    return col->data + col->offsets[row];
+  else
+    return col->data + (size_t)row * col->size;
+}
+
 static inline char *db_binary_field_get(DB_Binary_Result_t *res,
 					unsigned int row,
 					unsigned int col)
 {
   if ( row<res->num_rows && col<res->num_cols )
-    return (res->column[col].data+row*res->column[col].size);
+    return db_column_field(&res->column[col], row);
   else
     return NULL;
 }
@@ -186,6 +186,7 @@ DB_Binary_Result_t *db_recv_binary_query(int sockfd, int comp, char **errmsg)
 {
   //  uint64_t size=0;
   int i, anynull, nrows;
+  unsigned int datalen;
   DB_Column_t *col;
   DB_Binary_Result_t *result;
 
@@ -223,12 +224,29 @@ DB_Binary_Result_t *db_recv_binary_query(int sockfd, int comp, char **errmsg)
     /* Column data size. */
     col->size = Readint(sockfd);
     //size+=4;
-    /* Column data. */
-    col->data = malloc(result->num_rows*col->size);
-    XASSERT(col->data);
-    Readn(sockfd, col->data, result->num_rows*col->size);
-    //size += result->num_rows*col->size;
-    db_ntoh(col->type, result->num_rows, col->data);
+    /* Column layout - 1 if offsets + blob, 0 if fixed width. */
+    if (Readint(sockfd))
+    {
+      datalen = (unsigned int) Readint(sockfd);
+      col->offsets = malloc((result->num_rows+1)*sizeof(unsigned int));
+      XASSERT(col->offsets);
+      Readn(sockfd, col->offsets, result->num_rows*sizeof(unsigned int));
+      db_ntoh(DB_INT4, result->num_rows, (void *)col->offsets);
+      col->offsets[result->num_rows] = datalen;
+      col->data = malloc(datalen > 0 ? datalen : 1);
+      XASSERT(col->data);
+      Readn(sockfd, col->data, datalen);
+    }
+    else
+    {
+      col->offsets = NULL;
+      /* Column data. */
+      col->data = malloc(result->num_rows*col->size);
+      XASSERT(col->data);
+      Readn(sockfd, col->data, result->num_rows*col->size);
+      //size += result->num_rows*col->size;
+      db_ntoh(col->type, result->num_rows, col->data);
+    }
     /* Anynull - if FALSE then the null indicator array is not sent. */
     anynull = Readint(sockfd);
     /* Null indicator array. */
@@ -207,7 +207,7 @@ char db_binary_field_getchar(DB_Binary_Result_t *res, unsigned int row,
 {  
   if ( row<res->num_rows && col<res->num_cols)
     return dbtype2char(res->column[col].type,
-		      res->column[col].data+row*res->column[col].size);
+		      db_column_field(&res->column[col], row));
   else
   {
     fprintf(stderr,"ERROR: Invalid (row,col) index > (0..%d,0..%d)\n",
@@ -222,7 +222,7 @@ int db_binary_field_getint(DB_Binary_Result_t *res, unsigned int row,
 {  
   if ( row<res->num_rows && col<res->num_cols)
     return dbtype2int(res->column[col].type,
-		      res->column[col].data+row*res->column[col].size);
+		      db_column_field(&res->column[col], row));
   else
   {
     fprintf(stderr,"ERROR: Invalid (row,col) index > (0..%d,0..%d)\n",
@@ -238,7 +238,7 @@ long long db_binary_field_getlonglong(DB_Binary_Result_t *res, unsigned int row,
 {  
   if ( row<res->num_rows && col<res->num_cols)
     return dbtype2longlong(res->column[col].type,
-		      res->column[col].data+row*res->column[col].size);
+		      db_column_field(&res->column[col], row));
   else
   {
     fprintf(stderr,"ERROR: Invalid (row,col) index > (0..%d,0..%d)\n",
@@ -253,7 +253,7 @@ float db_binary_field_getfloat(DB_Binary_Result_t *res, unsigned int row,
 {  
   if ( row<res->num_rows && col<res->num_cols)
     return dbtype2float(res->column[col].type,
-		      res->column[col].data+row*res->column[col].size);
+		      db_column_field(&res->column[col], row));
   else
   {
     fprintf(stderr,"ERROR: Invalid (row,col) index > (0..%d,0..%d)\n",
@@ -268,7 +268,7 @@ double db_binary_field_getdouble(DB_Binary_Result_t *res, unsigned int row,
 {  
   if ( row<res->num_rows && col<res->num_cols)
     return dbtype2double(res->column[col].type,
-		      res->column[col].data+row*res->column[col].size);
+		      db_column_field(&res->column[col], row));
   else
   {
     fprintf(stderr,"ERROR: Invalid (row,col) index > (0..%d,0..%d)\n",
@@ -283,7 +283,7 @@ void db_binary_field_getstr(DB_Binary_Result_t *res, unsigned int row,
 {  
   if ( row<res->num_rows && col<res->num_cols)
     dbtype2str(res->column[col].type,
-	       res->column[col].data+row*res->column[col].size,
+	       db_column_field(&res->column[col], row),
 	       len,str);
   else
   {
@@ -347,7 +347,7 @@ void db_print_binary_result(DB_Binary_Result_t *res)
       column_width[j] = 0;
       for (i=0; i<res->num_rows; i++)
       {
-	len = strlen(res->column[j].data+i*res->column[j].size);
+	len = strlen(db_column_field(&res->column[j], i));
 	if (len>column_width[j])
 	  column_width[j] = len;
       }
@@ -386,7 +386,7 @@ void db_print_binary_result(DB_Binary_Result_t *res)
 	printf("%*s",column_width[j],"NULL");
       else
 	db_print_binary_field(res->column[j].type, column_width[j],
-			      res->column[j].data+i*res->column[j].size);
+			      db_column_field(&res->column[j], i));
       if (j<res->num_cols-1)
 	printf(" | ");
     }
@@ -517,6 +517,8 @@ void db_free_binary_result(DB_Binary_Result_t *db_result)
 	  free(db_result->column[i].data);
 	if (db_result->column[i].is_null)
 	  free(db_result->column[i].is_null);
+	if (db_result->column[i].offsets)
+	  free(db_result->column[i].offsets);
       }
       free(db_result->column);
     }
@@ -893,7 +895,7 @@ DB_Text_Result_t *db_binary_to_text(DB_Binary_Result_t *binres)
       result->column_width[j] = 0;
       for (i=0; i<binres->num_rows; i++)
       {
-	len = strlen(binres->column[j].data+i*binres->column[j].size);
+	len = strlen(db_column_field(&binres->column[j], i));
 	if (len>result->column_width[j])
 	  result->column_width[j] = len;
       }
@@ -971,7 +973,7 @@ DB_Text_Result_t *db_binary_to_text(DB_Binary_Result_t *binres)
 	n = db_sprint_binary_field(binres->column[j].type, 
 				   /*				     result->column_width[j], */
 				   0, 
-				   binres->column[j].data+i*binres->column[j].size,
+				   db_column_field(&binres->column[j], i),
 				   p);
       
       /*	if (n!=result->column_width[j])
@@ -24,6 +24,8 @@
 
 //#define DEBUG
 
+static void db_stream_park(DB_Handle_t *dbin);
+
 
 
 static int db2pgsql_type(DB_Type_t dbtype)
@@ -159,6 +161,7 @@ DB_Handle_t *db_connect(const char *host, const char *user,
   handle->abort_now = 0;
   handle->stmt_num = 0;
   handle->isolation_level = DB_TRANS_READCOMMIT;
+  handle->stream = NULL;
   if (lock)
   {
     handle->db_lock = malloc(sizeof(pthread_mutex_t));
@@ -190,6 +193,14 @@ void db_disconnect(DB_Handle_t **db)
     DB_Handle_t *dbin = *db;
     db_lock(dbin); /* If db_lock == NULL, then nop */
 
+    if (dbin->stream)
+    {
+       /* The rows the stream already has can still be read, but no more will arrive. */
+       dbin->stream->done = 1;
+       dbin->stream->dbh = NULL;
+       dbin->stream = NULL;
+    }
+
     PQfinish(dbin->db_connection);
     dbin->db_connection = NULL; /* make it easier to spot use after free. */
 
@@ -223,6 +234,7 @@ DB_Text_Result_t *db_query_txt(DB_Handle_t  *dbin, const char *query_string)
 
    /* Lock database connection if in multi threaded mode. */
   db_lock(dbin);
+  db_stream_park(dbin);
   if (dbin->abort_now)
     goto failure;
 
@@ -328,13 +340,246 @@ DB_Text_Result_t *db_query_txt(DB_Handle_t  *dbin, const char *query_string)
 
 
 
-DB_Binary_Result_t *db_query_bin(DB_Handle_t *dbin, const char *query_string)
+/* A run of rows of one PG result. A column of a binary query result can be assembled from
+ * several runs (a streamed query receives its rows in many small results). */
+typedef struct DB_PGRows_struct
 {
-  PGconn *db;
   PGresult *res;
+  unsigned int first;
+  unsigned int n;
+} DB_PGRows_t;
+
+/* Copy column icol of the PG binary-format rows in runs into col (the column name and type are
+ * taken from runs[0]). A string column is stored as offsets + blob: every field is
+ * NUL-terminated and occupies only its own length, instead of the width of the widest field in
+ * the column. Returns 0 on success, 1 if out of memory. */
+static int db_fill_column(const DB_PGRows_t *runs, unsigned int nruns, unsigned int icol, DB_Column_t *col)
+{
+  unsigned int nrows;
+  unsigned int irun;
+  unsigned int irow;
+  unsigned int jrow;
+  unsigned int width;
+  size_t total;
+  PGresult *res;
+
+  nrows = 0;
+  for (irun = 0; irun < nruns; irun++)
+    nrows += runs[irun].n;
+
+  memset(col, 0, sizeof(DB_Column_t));
+  col->column_name = strdup(PQfname(runs[0].res, icol));
+  col->type = pgsql2db_type(PQftype(runs[0].res, icol));
+  col->num_rows = nrows;
+  col->is_null = malloc((nrows > 0 ? nrows : 1) * sizeof(short));
+  if (!col->column_name || !col->is_null)
+    return 1;
+
+  col->size = 0;
+  total = 0;
+  for (irun = 0; irun < nruns; irun++)
+  {
+    res = runs[irun].res;
+    for (irow = runs[irun].first; irow < runs[irun].first + runs[irun].n; irow++)
+    {
+      width = PQgetlength(res, irow, icol);
+      if (width > col->size)
+        col->size = width;
+      total += width + 1;
+    }
+  }
+
+  if (col->type == DB_STRING || col->type == DB_VARCHAR)
+  {
+    /* The database does NOT store the trailing '\0' as part of the
+       string. Add it manually by setting size one larger. */
+    (col->size)++;
+
+    col->offsets = malloc((nrows + 1) * sizeof(unsigned int));
+    col->data = malloc(total > 0 ? total : 1);
+    if (!col->offsets || !col->data)
+      return 1;
+
+    total = 0;
+    jrow = 0;
+    for (irun = 0; irun < nruns; irun++)
+    {
+      res = runs[irun].res;
+      for (irow = runs[irun].first; irow < runs[irun].first + runs[irun].n; irow++, jrow++)
+      {
+        col->offsets[jrow] = total;
+        col->is_null[jrow] = PQgetisnull(res, irow, icol);
+        width = col->is_null[jrow] ? 0 : PQgetlength(res, irow, icol);
+        memcpy(col->data + total, PQgetvalue(res, irow, icol), width);
+        col->data[total + width] = '\0';
+        total += width + 1;
+      }
+    }
+    col->offsets[nrows] = total;
+  }
+  else
+  {
+    /* size == 0 if the column is all NULL - use the width of the type so
+       that every field still has room for its value. */
+    if (col->size == 0)
+      col->size = db_sizeof(col->type);
+
+    col->data = calloc(nrows > 0 ? nrows : 1, col->size);
+    if (!col->data)
+      return 1;
+
+    jrow = 0;
+    for (irun = 0; irun < nruns; irun++)
+    {
+      res = runs[irun].res;
+      for (irow = runs[irun].first; irow < runs[irun].first + runs[irun].n; irow++, jrow++)
+      {
+        col->is_null[jrow] = PQgetisnull(res, irow, icol);
+        if (!col->is_null[jrow])
+          memcpy(col->data + (size_t)jrow * col->size, PQgetvalue(res, irow, icol),
+                 PQgetlength(res, irow, icol));
+      }
+    }
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+    db_byteswap(col->type, nrows, col->data);
+#endif
+  }
+
+  return 0;
+}
+
+/* Convert rows of one or more PG results into a binary query result. */
+static DB_Binary_Result_t *db_binary_result_from_pg(const DB_PGRows_t *runs, unsigned int nruns)
+{
   DB_Binary_Result_t *db_res;
-  int colname_length;
-  unsigned int i,j, width;
+  unsigned int irun;
+  unsigned int i;
+  int status;
+
+  db_res = (DB_Binary_Result_t *)malloc(sizeof(DB_Binary_Result_t));
+  XASSERT(db_res);
+  memset(db_res,0,sizeof(DB_Binary_Result_t));
+  for (irun = 0; irun < nruns; irun++)
+    db_res->num_rows += runs[irun].n;
+  db_res->num_cols = nruns > 0 ? PQnfields(runs[0].res) : 0;
+
+  if (db_res->num_cols>0)  // there are rows
+  {
+    db_res->column = (DB_Column_t *)calloc(db_res->num_cols, sizeof(DB_Column_t));
+    XASSERT(db_res->column);
+    for (i=0; i<db_res->num_cols; i++)
+    {
+      status = db_fill_column(runs, nruns, i, &db_res->column[i]);
+      XASSERT(status == 0);
+#ifdef DEBUG
+      printf("sizeof column %d = %d\n",i,db_res->column[i].size);
+#endif
+    }
+  }
+
+  return db_res;
+}
+
+/* Streamed queries. The rows of the query are received with libpq's chunked-rows mode (libpq 17
+ * and later) or single-row mode, so they can be converted and used while the rest are still
+ * arriving. */
+
+/* Append a result to the stream's list of pending results. */
+static void db_stream_push(DB_Stream_t *stream, PGresult *res)
+{
+  if (stream->npending == stream->szpending)
+  {
+    if (stream->head > 0)
+    {
+      /* Reuse the slots of the results that have already been returned. */
+      memmove(stream->pending, stream->pending + stream->head, (stream->npending - stream->head) * sizeof(void *));
+      stream->npending -= stream->head;
+      stream->head = 0;
+    }
+
+    if (stream->npending == stream->szpending)
+    {
+      stream->szpending = stream->szpending > 0 ? 2 * stream->szpending : 64;
+      stream->pending = realloc(stream->pending, stream->szpending * sizeof(void *));
+      XASSERT(stream->pending);
+    }
+  }
+
+  stream->pending[stream->npending++] = res;
+  stream->navail += PQntuples(res);
+}
+
+/* Receive the next result of the stream's query (blocks until it arrives). Once the last one has
+ * been received, the connection is released for other statements. The connection must be locked. */
+static void db_stream_receive(DB_Stream_t *stream)
+{
+  DB_Handle_t *dbin = stream->dbh;
+  PGconn *db = dbin->db_connection;
+  PGresult *res;
+
+  res = PQgetResult(db);
+  if (res)
+  {
+    switch (PQresultStatus(res))
+    {
+      case PGRES_SINGLE_TUPLE:
+#ifdef LIBPQ_HAS_CHUNK_MODE
+      case PGRES_TUPLES_CHUNK:
+#endif
+        if (stream->discard)
+          PQclear(res);
+        else
+          db_stream_push(stream, res);
+        return;
+      case PGRES_TUPLES_OK:
+      case PGRES_COMMAND_OK:
+        /* End of the rows. This result has no rows, unless the row mode could not be set - then
+           it has all of them. */
+        if (PQntuples(res) > 0 && !stream->discard)
+        {
+          db_stream_push(stream, res);
+          res = NULL;
+        }
+        break;
+      default:
+        DB_SetErrmsg(dbin, PQerrorMessage(db));
+        fprintf(stderr, "query failed: %s", DB_GetErrmsg(dbin));
+        stream->failed = 1;
+        break;
+    }
+
+    if (res)
+      PQclear(res);
+
+    /* Read the NULL result that ends the query. */
+    while ((res = PQgetResult(db)) != NULL)
+      PQclear(res);
+  }
+
+  stream->done = 1;
+  dbin->stream = NULL;
+}
+
+/* If a streamed query is in progress on the connection, read the rest of its rows into memory so
+ * that another statement can be sent. The connection must be locked. */
+static void db_stream_park(DB_Handle_t *dbin)
+{
+  DB_Stream_t *stream = dbin->stream;
+
+  if (stream)
+  {
+    while (!stream->done)
+      db_stream_receive(stream);
+  }
+}
+
+/* Send query and return without waiting for its rows; read them with db_stream_next(). chunkrows
+ * is the number of rows libpq collects before handing them over (libpq 17 and later - otherwise
+ * rows are handed over one at a time). */
+DB_Stream_t *db_stream_open(DB_Handle_t *dbin, const char *query, unsigned int chunkrows)
+{
+  PGconn *db;
+  DB_Stream_t *stream;
 
   if (dbin==NULL)
     return NULL;
@@ -342,106 +587,207 @@ DB_Binary_Result_t *db_query_bin(DB_Handle_t *dbin, const char *query_string)
 
    /* Lock database connection if in multi threaded mode. */
   db_lock(dbin);
+  db_stream_park(dbin);
   if (dbin->abort_now)
     goto failure;
 
 #ifdef DEBUG
-  printf("db_query_bin: query = %s\n",query_string);
+  printf("db_stream_open: query = %s\n",query);
 #endif
-  res = PQexecParams(db,query_string, 0, NULL,
-		     NULL, NULL, NULL, 1);
-
-    DB_ResetErrmsg(dbin);
-  if (PQresultStatus(res) != PGRES_TUPLES_OK)
+  DB_ResetErrmsg(dbin);
+  if (!PQsendQueryParams(db, query, 0, NULL, NULL, NULL, NULL, 1))
   {
-      DB_SetErrmsg(dbin, PQerrorMessage(db));
+    DB_SetErrmsg(dbin, PQerrorMessage(db));
     fprintf(stderr, "query failed: %s", DB_GetErrmsg(dbin));
-    PQclear(res);
     goto failure;
   }
 
-  // query succeeded, process any data returned by it
-  db_res = (DB_Binary_Result_t *)malloc(sizeof(DB_Binary_Result_t));
-  XASSERT(db_res);
-  memset(db_res,0,sizeof(DB_Binary_Result_t));
-  db_res->num_rows = PQntuples(res);
-  db_res->num_cols = PQnfields(res);
+#ifdef LIBPQ_HAS_CHUNK_MODE
+  if (!PQsetChunkedRowsMode(db, chunkrows > 0 ? chunkrows : 1))
+  {
+    PQsetSingleRowMode(db);
+  }
+#else
+  PQsetSingleRowMode(db);
+#endif
 
-  if (db_res->num_cols>0)  // there are rows
+  stream = (DB_Stream_t *)calloc(1, sizeof(DB_Stream_t));
+  XASSERT(stream);
+  stream->dbh = dbin;
+  dbin->stream = stream;
+  db_unlock(dbin);
+  return stream;
+failure:
+  QUERY_ERROR(query);
+  db_unlock(dbin);
+  return NULL;
+}
+
+/* Return the next maxrows rows of a streamed query (fewer for the last batch), waiting for them
+ * to arrive if necessary. Returns NULL when all rows have been returned, or if the query failed
+ * (stream->failed is then set). The caller owns the returned result. */
+DB_Binary_Result_t *db_stream_next(DB_Stream_t *stream, unsigned int maxrows)
+{
+  DB_Handle_t *dbin;
+  DB_Binary_Result_t *db_res = NULL;
+  DB_PGRows_t *runs;
+  unsigned int nruns;
+  unsigned int nrows;
+  unsigned int ipend;
+  unsigned int ntuples;
+  PGresult *res;
+
+  if (!stream || maxrows == 0)
+    return NULL;
+
+  dbin = stream->dbh;
+  if (dbin)
+    db_lock(dbin);
+
+  while (!stream->done && stream->navail < maxrows)
+    db_stream_receive(stream);
+
+  if (!stream->failed && stream->navail > 0)
   {
-    db_res->column = (DB_Column_t *)malloc(db_res->num_cols * sizeof(DB_Column_t));
-    XASSERT(db_res->column);
-    //    printf("num_rows=%d, num_cols=%d\n",db_res->num_rows,db_res->num_cols);
-    for (i=0; i<db_res->num_cols; i++)
+    runs = (DB_PGRows_t *)malloc((stream->npending - stream->head) * sizeof(DB_PGRows_t));
+    XASSERT(runs);
+
+    nruns = 0;
+    nrows = 0;
+    for (ipend = stream->head; ipend < stream->npending && nrows < maxrows; ipend++)
     {
-      //      printf("Column %d:\n",i);
-      colname_length = strlen(PQfname(res,i))+1;
-      db_res->column[i].column_name = malloc(colname_length);
-      XASSERT(db_res->column[i].column_name);
-      strcpy(db_res->column[i].column_name,PQfname(res,i));
-      //printf("name = %s (%s)\n",db_res->column[i].column_name,PQfname(res,i));
-      db_res->column[i].type = pgsql2db_type(PQftype(res,i));
-      //printf("type = %d (%d)\n",db_res->column[i].type,PQftype(res,i));
-      db_res->column[i].num_rows = db_res->num_rows;
-      db_res->column[i].is_null =  malloc(db_res->num_rows*sizeof(int));
-      XASSERT(db_res->column[i].is_null);
-      db_res->column[i].size = 0;
-
-      /* Get the maximum (over all rows) value length */
-      for (j=0; j<db_res->num_rows; j++)
-      {
-	width = PQgetlength(res,j,i);
-	if (width>db_res->column[i].size)
-	  db_res->column[i].size = width;
-      }
+      res = (PGresult *)stream->pending[ipend];
+      runs[nruns].res = res;
+      runs[nruns].first = ipend == stream->head ? stream->firstrow : 0;
+      runs[nruns].n = PQntuples(res) - runs[nruns].first;
+      if (runs[nruns].n > maxrows - nrows)
+        runs[nruns].n = maxrows - nrows;
+      nrows += runs[nruns].n;
+      nruns++;
+    }
 
-      /* The database does NOT store the trailing '\0' as part of the
-	 string. Add it manually by setting size one larger. */
-      if ( db_res->column[i].type == DB_STRING ||
-	   db_res->column[i].type == DB_VARCHAR )
-	(db_res->column[i].size)++;
+    db_res = db_binary_result_from_pg(runs, nruns);
+    stream->navail -= nrows;
 
-      if (db_res->column[i].size == 0)
+    /* Free the results all of whose rows have now been returned. */
+    for (ipend = stream->head; ipend < stream->head + nruns; ipend++)
+    {
+      res = (PGresult *)stream->pending[ipend];
+      ntuples = PQntuples(res);
+      if (ipend == stream->head + nruns - 1 && runs[nruns - 1].first + runs[nruns - 1].n < ntuples)
       {
-         /* If you malloc(0), then free() the resulting pointer, you get a crash,
-          * so make the size at least 1 (even though it won't be used).
-          * This is the simplest fix for something that should happen
-          * very often.
-          *
-          * size == 0 if the columns of data are all NULL, which can happen
-          * since we don't have the 'not null' modifier set on our table columns.
-          */
-         db_res->column[i].size = db_sizeof(db_res->column[i].type);
+        stream->firstrow = runs[nruns - 1].first + runs[nruns - 1].n;
+        break;
       }
 
-      db_res->column[i].data = malloc(db_res->num_rows * db_res->column[i].size);
-      XASSERT(db_res->column[i].data);
+      PQclear(res);
+      stream->pending[ipend] = NULL;
+      stream->firstrow = 0;
+    }
+    stream->head = ipend;
 
-      /* set entire column to NULLS, then fill in non-0 parts. This will
-       * take care of string values too - their PQgetlength() length will
-       * be at least one smaller than db_res->column[i].size. */
-      memset(db_res->column[i].data, 0, db_res->num_rows * db_res->column[i].size);
+    free(runs);
+  }
 
-#ifdef DEBUG
-      printf("sizeof column %d = %d\n",i,db_res->column[i].size);
-#endif
-    }
+  if (dbin)
+    db_unlock(dbin);
 
-    for (i=0; i<db_res->num_cols; i++)
+  return db_res;
+}
+
+/* Free a streamed query. Rows that have not been returned yet are discarded. Cancelling the query
+ * would abort the enclosing transaction, so instead the rows still on their way are read and
+ * thrown away. */
+void db_stream_close(DB_Stream_t **stream)
+{
+  DB_Stream_t *st;
+  DB_Handle_t *dbin;
+  unsigned int ipend;
+
+  if (stream && *stream)
+  {
+    st = *stream;
+    dbin = st->dbh;
+    if (dbin)
     {
-      for (j=0; j<db_res->num_rows; j++)
-      {
-	db_res->column[i].is_null[j] = PQgetisnull(res,j,i);
-	if (!db_res->column[i].is_null[j])
-	  memcpy(&db_res->column[i].data[j*db_res->column[i].size],
-		 PQgetvalue(res,j,i), PQgetlength(res,j,i));
-      }
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-      db_byteswap(db_res->column[i].type, db_res->num_rows,
-		  db_res->column[i].data);
-#endif
+      db_lock(dbin);
+      st->discard = 1;
+      while (!st->done)
+        db_stream_receive(st);
+      db_unlock(dbin);
     }
+
+    for (ipend = st->head; ipend < st->npending; ipend++)
+      PQclear((PGresult *)st->pending[ipend]);
+
+    if (st->pending)
+      free(st->pending);
+    free(st);
+    *stream = NULL;
+  }
+}
+
+/* Run query, passing its rows to batchfn, at most batchrows (> 0) at a time, as they arrive from
+ * the server. batchfn owns each batch (it frees it with db_free_binary_result()); if it returns
+ * non-zero, the rest of the rows are discarded. Returns 0 on success, 1 if the query failed. */
+int db_query_bin_stream(DB_Handle_t *dbin, const char *query, unsigned int batchrows, int (*batchfn)(DB_Binary_Result_t *batch, void *data), void *data)
+{
+  DB_Stream_t *stream;
+  DB_Binary_Result_t *batch;
+  int failed;
+
+  stream = db_stream_open(dbin, query, batchrows);
+  if (!stream)
+    return 1;
+
+  while ((batch = db_stream_next(stream, batchrows)) != NULL)
+  {
+    if ((*batchfn)(batch, data))
+      break;
+  }
+
+  failed = stream->failed;
+  db_stream_close(&stream);
+  return failed;
+}
+
+DB_Binary_Result_t *db_query_bin(DB_Handle_t *dbin, const char *query_string)
+{
+  PGconn *db;
+  PGresult *res;
+  DB_Binary_Result_t *db_res;
+  DB_PGRows_t rows;
+
+  if (dbin==NULL)
+    return NULL;
+  db = dbin->db_connection;
+
+   /* Lock database connection if in multi threaded mode. */
+  db_lock(dbin);
+  db_stream_park(dbin);
+  if (dbin->abort_now)
+    goto failure;
+
+#ifdef DEBUG
+  printf("db_query_bin: query = %s\n",query_string);
+#endif
+  res = PQexecParams(db,query_string, 0, NULL,
+		     NULL, NULL, NULL, 1);
+
+    DB_ResetErrmsg(dbin);
+  if (PQresultStatus(res) != PGRES_TUPLES_OK)
+  {
+      DB_SetErrmsg(dbin, PQerrorMessage(db));
+    fprintf(stderr, "query failed: %s", DB_GetErrmsg(dbin));
+    PQclear(res);
+    goto failure;
   }
+
+  // query succeeded, process any data returned by it
+  rows.res = res;
+  rows.first = 0;
+  rows.n = PQntuples(res);
+  db_res = db_binary_result_from_pg(&rows, 1);
   PQclear(res);
   db_unlock(dbin);
   return db_res;
@@ -471,8 +817,8 @@ DB_Binary_Result_t *db_query_bin_array(DB_Handle_t  *dbin, const char *query, in
   PGconn *db;
   PGresult *res;
   DB_Binary_Result_t *db_res;
-  int colname_length, buflen;
-  unsigned int i,j, width;
+  DB_PGRows_t rows;
+  int buflen, i;
   char *p, *pquery, *op,*q;
   int paramLengths[MAXARG], paramFormats[MAXARG],n;
   Oid paramTypes[MAXARG];
@@ -488,6 +834,7 @@ DB_Binary_Result_t *db_query_bin_array(DB_Handle_t  *dbin, const char *query, in
 
    /* Lock database connection if in multi-threaded mode. */
   db_lock(dbin);
+  db_stream_park(dbin);
   if (dbin->abort_now)
     goto failure;
 
@@ -567,79 +914,10 @@ DB_Binary_Result_t *db_query_bin_array(DB_Handle_t  *dbin, const char *query, in
   }
 
   // query succeeded, process any data returned by it
-  db_res = (DB_Binary_Result_t *)malloc(sizeof(DB_Binary_Result_t));
-  XASSERT(db_res);
-  memset(db_res,0,sizeof(DB_Binary_Result_t));
-  db_res->num_rows = PQntuples(res);
-  db_res->num_cols = PQnfields(res);
-
-  if (db_res->num_cols>0)  // there are rows
-  {
-     db_res->column = (DB_Column_t *)malloc(db_res->num_cols * sizeof(DB_Column_t));
-    XASSERT(db_res->column);
-    //    printf("num_rows=%d, num_cols=%d\n",db_res->num_rows,db_res->num_cols);
-    for (i=0; i<db_res->num_cols; i++)
-    {
-      //      printf("Column %d:\n",i);
-      colname_length = strlen(PQfname(res,i))+1;
-      db_res->column[i].column_name = malloc(colname_length);
-      XASSERT(db_res->column[i].column_name);
-      strcpy(db_res->column[i].column_name,PQfname(res,i));
-      //printf("name = %s (%s)\n",db_res->column[i].column_name,PQfname(res,i));
-      db_res->column[i].type = pgsql2db_type(PQftype(res,i));
-      //printf("type = %d (%d)\n",db_res->column[i].type,PQftype(res,i));
-      db_res->column[i].num_rows = db_res->num_rows;
-      db_res->column[i].is_null =  malloc(db_res->num_rows*sizeof(int));
-      XASSERT(db_res->column[i].is_null);
-      db_res->column[i].size = 0;
-      for (j=0; j<db_res->num_rows; j++)
-      {
-	width = PQgetlength(res,j,i);
-	if (width>db_res->column[i].size)
-	  db_res->column[i].size = width;
-      }
-
-      /* The database does NOT store the trailing '\0' as part of the
-	 string. Add it manually by setting size one larger. */
-      if ( db_res->column[i].type == DB_STRING ||
-	   db_res->column[i].type == DB_VARCHAR )
-        {
-            (db_res->column[i].size)++;
-        }
-        else
-        {
-            /* Make sure that db_res->column[i].size != 0. */
-            if (db_res->column[i].size == 0)
-            {
-                db_res->column[i].size = db_sizeof(db_res->column[i].type);
-            }
-        }
-
-      db_res->column[i].data = malloc(db_res->num_rows * db_res->column[i].size);
-      XASSERT(db_res->column[i].data);
-#ifdef DEBUG
-      printf("sizeof column %d = %d\n",i,db_res->column[i].size);
-#endif
-    }
-
-    for (i=0; i<db_res->num_cols; i++)
-    {
-      for (j=0; j<db_res->num_rows; j++)
-      {
-	db_res->column[i].is_null[j] = PQgetisnull(res,j,i);
-	if (!db_res->column[i].is_null[j])
-	  memcpy(&db_res->column[i].data[j*db_res->column[i].size],
-		 PQgetvalue(res,j,i), db_res->column[i].size);
-	else
-	  memset(&db_res->column[i].data[j*db_res->column[i].size], 0,
-		 db_res->column[i].size);
-      }
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-      db_byteswap(db_res->column[i].type, db_res->num_rows,
-		  db_res->column[i].data);
-#endif
-    }
-  }
+  rows.res = res;
+  rows.first = 0;
+  rows.n = PQntuples(res);
+  db_res = db_binary_result_from_pg(&rows, 1);
   free(pquery);
   PQclear(res);
   db_unlock(dbin);
@@ -698,10 +976,8 @@ DB_Binary_Result_t **db_query_bin_ntuple(DB_Handle_t *dbin, const char *stmnt, u
     PGresult *pgres = NULL;
     DB_Binary_Result_t *dbres = NULL;
     DB_Binary_Result_t **dbresults = NULL;
+    DB_PGRows_t rows;
     int icol;
-    int irow;
-    int colnameLength;
-    unsigned int width;
     int err;
 
     err =  0;
@@ -710,6 +986,7 @@ DB_Binary_Result_t **db_query_bin_ntuple(DB_Handle_t *dbin, const char *stmnt, u
     {
         /* Lock database connection if in multi-threaded mode. */
         db_lock(dbin);
+        db_stream_park(dbin);
         if (!dbin->abort_now)
         {
             if (nargs > MAXARG)
@@ -837,6 +1114,7 @@ DB_Binary_Result_t **db_query_bin_ntuple(DB_Handle_t *dbin, const char *stmnt, u
                 }
 
                 db_lock(dbin);
+                db_stream_park(dbin);
 
                 free(prepareStmnt);
                 prepareStmnt = NULL;
@@ -914,10 +1192,13 @@ DB_Binary_Result_t **db_query_bin_ntuple(DB_Handle_t *dbin, const char *stmnt, u
 
                         dbres->num_rows = PQntuples(pgres);
                         dbres->num_cols = PQnfields(pgres);
+                        rows.res = pgres;
+                        rows.first = 0;
+                        rows.n = dbres->num_rows;
 
                         if (dbres->num_cols > 0)
                         {
-                            dbres->column = (DB_Column_t *)malloc(dbres->num_cols * sizeof(DB_Column_t));
+                            dbres->column = (DB_Column_t *)calloc(dbres->num_cols, sizeof(DB_Column_t));
                             if (!dbres->column)
                             {
                                 /* Out of memory. */
@@ -927,105 +1208,12 @@ DB_Binary_Result_t **db_query_bin_ntuple(DB_Handle_t *dbin, const char *stmnt, u
 
                             for (icol = 0; icol < dbres->num_cols; icol++)
                             {
-                                colnameLength = strlen(PQfname(pgres, icol)) + 1;
-                                dbres->column[icol].column_name = malloc(colnameLength);
-                                if (!dbres->column[icol].column_name)
+                                if (db_fill_column(&rows, 1, icol, &dbres->column[icol]))
                                 {
                                     /* Out of memory. */
                                     err = 1;
                                     break;
                                 }
-
-                                strcpy(dbres->column[icol].column_name, PQfname(pgres,icol));
-                                dbres->column[icol].type = pgsql2db_type(PQftype(pgres, icol));
-                                dbres->column[icol].num_rows = dbres->num_rows;
-                                dbres->column[icol].is_null = malloc(dbres->num_rows * sizeof(int));
-                                if (!dbres->column[icol].is_null)
-                                {
-                                    /* Out of memory. */
-                                    err = 1;
-                                    break;
-                                }
-
-                                /* The column size is the max(width of row). */
-
-                                /* I grabbed this code from db_query_bin_array(), and apparently it has a bug. This method
-                                 * for determining the width of a column should apply to strings only. For numbers,
-                                 * the width of a column is determined by the data type. For example, if the data type
-                                 * is char, then size == 1 and if it is int, then size = 4.
-                                 *
-                                 * Ah, I found this code/comment in db_query_bin():
-                                 *
-                                 if (db_res->column[i].size == 0)
-                                 {
-                                   / If you malloc(0), then free() the resulting pointer, you get a crash,
-                                   * so make the size at least 1 (even though it won't be used).
-                                   * This is the simplest fix for something that should happen
-                                   * very often.
-                                   *
-                                   * size == 0 if the columns of data are all NULL, which can happen
-                                   * since we don't have the 'not null' modifier set on our table columns.
-                                   /
-                                   db_res->column[i].size = db_sizeof(db_res->column[i].type);
-                                 }
-                                 *
-                                 * The comment itself isn't 100% correct, but the gist of it agrees with my comment.
-                                 * The problem can happen with numbers only.
-                                 *
-                                 * -Art 2014/01/28
-                                 */
-
-                                dbres->column[icol].size = 0;
-                                for (irow = 0; irow < dbres->num_rows; irow++)
-                                {
-                                    width = PQgetlength(pgres, irow, icol);
-                                    if (width > dbres->column[icol].size)
-                                    {
-                                        dbres->column[icol].size = width;
-                                    }
-                                }
-
-                                /* The database does NOT store the trailing '\0' as part of the
-                                 string. Add it manually by setting size one larger. */
-                                if (dbres->column[icol].type == DB_STRING || dbres->column[icol].type == DB_VARCHAR)
-                                {
-                                    (dbres->column[icol].size)++;
-                                }
-                                else
-                                {
-                                    /* Make sure that dbres->column[icol].size != 0. */
-                                    if (dbres->column[icol].size == 0)
-                                    {
-                                        dbres->column[icol].size = db_sizeof(dbres->column[icol].type);
-                                    }
-                                }
-
-                                dbres->column[icol].data = malloc(dbres->num_rows * dbres->column[icol].size);
-                                if (!dbres->column[icol].data)
-                                {
-                                    /* Out of memory. */
-                                    err = 1;
-                                    break;
-                                }
-                            }
-
-                            for (icol = 0; icol < dbres->num_cols; icol++)
-                            {
-                                for (irow = 0; irow < dbres->num_rows; irow++)
-                                {
-                                    dbres->column[icol].is_null[irow] = PQgetisnull(pgres, irow, icol);
-                                    if (!dbres->column[icol].is_null[irow])
-                                    {
-                                        memcpy(&dbres->column[icol].data[irow * dbres->column[icol].size], PQgetvalue(pgres, irow, icol), dbres->column[icol].size);
-                                    }
-                                    else
-                                    {
-                                        memset(&dbres->column[icol].data[irow * dbres->column[icol].size], 0, dbres->column[icol].size);
-                                    }
-                                }
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-                                db_byteswap(dbres->column[icol].type, dbres->num_rows, dbres->column[icol].data);
-#endif
                             }
                         }
                     }
@@ -1091,6 +1279,7 @@ static int db_dms_internal(DB_Handle_t *dbin, int *row_count, const char *query_
 
      /* Lock database connection if in multi threaded mode. */
     db_lock(dbin);
+    db_stream_park(dbin);
     if (dbin->abort_now)
     {
         goto failure;
@@ -1242,6 +1431,7 @@ int db_dms_array(DB_Handle_t  *dbin, int *row_count, const char *query, int n_ro
   if (n_rows>1)
   {
     db_lock(dbin);
+    db_stream_park(dbin);
     if (dbin->abort_now) {
       db_unlock(dbin);
       goto failure;
@@ -1279,6 +1469,7 @@ int db_dms_array(DB_Handle_t  *dbin, int *row_count, const char *query, int n_ro
       *row_count=0;
     /* Lock the database connection. */
     db_lock(dbin);
+    db_stream_park(dbin);
     if (dbin->abort_now) {
       db_unlock(dbin);
       goto failure;
@@ -1340,6 +1531,7 @@ int db_dms_array(DB_Handle_t  *dbin, int *row_count, const char *query, int n_ro
 	paramValues[j] = p;
     }
     db_lock(dbin);
+    db_stream_park(dbin);
     if (dbin->abort_now) {
       db_unlock(dbin);
       goto failure;
@@ -1481,6 +1673,7 @@ int db_bulk_insert_array(DB_Handle_t  *dbin, char *table, int n_rows, int n_args
 
   /* Do the actual database operations. */
   db_lock(dbin);
+  db_stream_park(dbin);
   if (dbin->abort_now) {
     status = 1;
     goto failure;
@@ -1582,7 +1775,7 @@ int db_isolation_level(DB_Handle_t  *dbin, int level)
     break;
   case DB_TRANS_READONLY:
     dbin->isolation_level = DB_TRANS_READONLY;
-    return db_dms(dbin, NULL, "SET SESSION CHARACTERISTICS AS TRANSACTION ISOLATION LEVEL READ ONLY");
+    return db_dms(dbin, NULL, "SET SESSION CHARACTERISTICS AS TRANSACTION READ ONLY");
     break;
     case DB_TRANS_REPEATABLEREAD:
         dbin->isolation_level = DB_TRANS_REPEATABLEREAD;
@@ -85,7 +85,7 @@ int db_binary_record_compare(DB_Binary_Result_t *res, int num_cols, int *cols,
 			     int i1, int i2)
 {
   int i;
-  int col, comp, size;
+  int col, comp;
   DB_Type_t type;
 
   if (i1==i2)
@@ -94,10 +94,9 @@ int db_binary_record_compare(DB_Binary_Result_t *res, int num_cols, int *cols,
   {
     col = cols[i];
     type = res->column[col].type;
-    size = res->column[col].size; 
     comp = db_type_compare(type, 
-			   res->column[col].data+i1*size,
-			   res->column[col].data+i2*size);
+			   db_column_field(&res->column[col], i1),
+			   db_column_field(&res->column[col], i2));
     if (comp)
       return comp;
   }
@@ -172,10 +171,25 @@ static void db_permute(DB_Binary_Result_t *res, int n, int *p)
 {
   int i,j;
   char *buf;
+  unsigned int *offsets;
 
   /* Permute rows according to indices in p. */
   for (i=0;i<res->num_cols; i++)
   {
+    if (res->column[i].offsets)
+    {
+      /* Offsets + blob column - only the offsets move. */
+      offsets = malloc((n+1)*sizeof(unsigned int));
+      XASSERT(offsets);
+      for (j=0; j<n; j++)
+        offsets[j] = res->column[i].offsets[p[j]];
+      offsets[n] = res->column[i].offsets[res->column[i].num_rows];
+      free(res->column[i].offsets);
+      res->column[i].offsets = offsets;
+      res->column[i].num_rows = n;
+      continue;
+    }
+
     buf = malloc(res->column[i].size*n);
     XASSERT(buf);
     for (j=0; j<n; j++)
@@ -183,9 +183,9 @@ int db_send_binary_result(int sockfd, DB_Binary_Result_t *result, int comp)
 
   if (result)
   {
-    vec = malloc((3+7*result->num_cols)*sizeof(struct iovec));
+    vec = malloc((3+9*result->num_cols)*sizeof(struct iovec));
     XASSERT(vec);
-    tmp = malloc((3+7*result->num_cols)*sizeof(int));
+    tmp = malloc((3+9*result->num_cols)*sizeof(int));
     XASSERT(tmp);
 
     /* Byteswap arrays and test . */
@@ -230,10 +230,35 @@ int db_send_binary_result(int sockfd, DB_Binary_Result_t *result, int comp)
       vec[vc].iov_len = sizeof(tmp[tc]);
       vec[vc].iov_base = &tmp[tc];
       ++tc; ++vc;
-      /* Column Data */
-      vec[vc].iov_len = result->num_rows*col->size;
-      vec[vc].iov_base = col->data;
-      ++vc;
+      /* Column layout - 1 if offsets + blob, 0 if fixed width. */
+      tmp[tc] = htonl(col->offsets != NULL);
+      vec[vc].iov_len = sizeof(tmp[tc]);
+      vec[vc].iov_base = &tmp[tc];
+      ++tc; ++vc;
+      if (col->offsets)
+      {
+	/* Length of data. */
+	tmp[tc] = htonl(col->offsets[result->num_rows]);
+	vec[vc].iov_len = sizeof(tmp[tc]);
+	vec[vc].iov_base = &tmp[tc];
+	vec[vc+2].iov_len = col->offsets[result->num_rows];
+	++tc; ++vc;
+	/* Field offsets. */
+	db_hton(DB_INT4, result->num_rows, col->offsets);
+	vec[vc].iov_len = result->num_rows*sizeof(unsigned int);
+	vec[vc].iov_base = col->offsets;
+	++vc;
+	/* Column Data */
+	vec[vc].iov_base = col->data;
+	++vc;
+      }
+      else
+      {
+	/* Column Data */
+	vec[vc].iov_len = result->num_rows*col->size;
+	vec[vc].iov_base = col->data;
+	++vc;
+      }
 
       /* Check if there are any NULL values in this column. */
       anynull = 0;
@@ -262,6 +287,8 @@ int db_send_binary_result(int sockfd, DB_Binary_Result_t *result, int comp)
       col = &result->column[i];
       db_hton(col->type, result->num_rows, col->data);
       db_hton(DB_INT2, result->num_rows, col->is_null);
+      if (col->offsets)
+	db_hton(DB_INT4, result->num_rows, col->offsets);
     }
     free(vec);
     free(tmp);
@@ -270,6 +297,13 @@ int db_send_binary_result(int sockfd, DB_Binary_Result_t *result, int comp)
 }
 
 int db_server_query_bin(int sockfd, DB_Handle_t *db_handle)
+{
+  return db_server_query_bin_ro(sockfd, NULL, db_handle, NULL);
+}
+
+/* Like db_server_query_bin(), but try the query on ro_handle (a read-only connection) first. If
+   that fails, set *rofailed and run the query again on db_handle. */
+int db_server_query_bin_ro(int sockfd, DB_Handle_t *ro_handle, DB_Handle_t *db_handle, int *rofailed)
 {
   int tmp, len,status, comp;
   char *query;
@@ -289,7 +323,16 @@ int db_server_query_bin(int sockfd, DB_Handle_t *db_handle)
     comp = Readint(sockfd);
 
     /* Query database. */
-    result = db_query_bin(db_handle, query);
+    result = NULL;
+    if (ro_handle)
+    {
+      result = db_query_bin(ro_handle, query);
+      if (!result)
+        *rofailed = 1;
+    }
+
+    if (!result)
+      result = db_query_bin(db_handle, query);
 
     /* Send result to client. */
     if (result)
@@ -326,6 +369,11 @@ int db_server_query_bin(int sockfd, DB_Handle_t *db_handle)
 
 
 int db_server_query_bin_array(int sockfd, DB_Handle_t *db_handle)
+{
+  return db_server_query_bin_array_ro(sockfd, NULL, db_handle, NULL);
+}
+
+int db_server_query_bin_array_ro(int sockfd, DB_Handle_t *ro_handle, DB_Handle_t *db_handle, int *rofailed)
 {
   int i, tmp, len,status, comp, n_args;
   char *query;
@@ -354,7 +402,16 @@ int db_server_query_bin_array(int sockfd, DB_Handle_t *db_handle)
     }
 
     /* Query database. */
-    result = db_query_bin_array(db_handle, query, n_args, intype, argin);
+    result = NULL;
+    if (ro_handle)
+    {
+      result = db_query_bin_array(ro_handle, query, n_args, intype, argin);
+      if (!result)
+        *rofailed = 1;
+    }
+
+    if (!result)
+      result = db_query_bin_array(db_handle, query, n_args, intype, argin);
 
     /* Free arguments. */
     for (i=0; i<n_args; i++)
@@ -389,6 +446,11 @@ int db_server_query_bin_array(int sockfd, DB_Handle_t *db_handle)
 }
 
 int db_server_query_bin_ntuple(int sockfd, DB_Handle_t *db_handle)
+{
+    return db_server_query_bin_ntuple_ro(sockfd, NULL, db_handle, NULL);
+}
+
+int db_server_query_bin_ntuple_ro(int sockfd, DB_Handle_t *ro_handle, DB_Handle_t *db_handle, int *rofailed)
 {
     DB_Binary_Result_t **result = NULL;
     DB_Binary_Result_t *exeResult = NULL;
@@ -468,7 +530,19 @@ int db_server_query_bin_ntuple(int sockfd, DB_Handle_t *db_handle)
             }
         }
 
-        result = db_query_bin_ntuple(db_handle, stmnt, nexes, nargs, dbtypes, values);
+        if (ro_handle)
+        {
+            result = db_query_bin_ntuple(ro_handle, stmnt, nexes, nargs, dbtypes, values);
+            if (!result)
+            {
+                *rofailed = 1;
+            }
+        }
+
+        if (!result)
+        {
+            result = db_query_bin_ntuple(db_handle, stmnt, nexes, nargs, dbtypes, values);
+        }
 
         if (result)
         {
@@ -525,6 +599,11 @@ int db_server_query_bin_ntuple(int sockfd, DB_Handle_t *db_handle)
 
 
 int db_server_query_txt(int sockfd, DB_Handle_t *db_handle)
+{
+  return db_server_query_txt_ro(sockfd, NULL, db_handle, NULL);
+}
+
+int db_server_query_txt_ro(int sockfd, DB_Handle_t *ro_handle, DB_Handle_t *db_handle, int *rofailed)
 {
   int tmp, len, status;
   char *query;
@@ -544,7 +623,16 @@ int db_server_query_txt(int sockfd, DB_Handle_t *db_handle)
     comp = Readint(sockfd);
 
     /* Query database. */
-    result = db_query_txt(db_handle, query);
+    result = NULL;
+    if (ro_handle)
+    {
+      result = db_query_txt(ro_handle, query);
+      if (!result)
+        *rofailed = 1;
+    }
+
+    if (!result)
+      result = db_query_txt(db_handle, query);
 
     /* Send result to client. */
     if (result)
@@ -0,0 +1,142 @@
+/* Microbenchmark for the hash table underneath HContainer_t. For each table size from 1e2 to 1e7
+ * keys it reports insert, hit-lookup, miss-lookup, and remove throughput, both for the raw
+ * Hash_Table_t API and for HContainer_t.
+ *
+ * usage: benchhash-table [maxkeys]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hash_table.h"
+#include "hcontainer.h"
+#include "timer.h"
+
+#define KEYLEN 32
+
+static double Rate(long n, float secs)
+{
+   return secs > 0 ? (double)n / secs / 1.0e6 : 0.0;
+}
+
+/* Keys resemble the DRMS cache keys (series name + record number). Truncated keys could collide, so
+ * a key that doesn't fit in KEYLEN is an error. */
+static char *MakeKeys(long nkeys, const char *prefix)
+{
+   char *keys = malloc(nkeys * KEYLEN);
+   long ikey;
+
+   for (ikey = 0; ikey < nkeys; ikey++)
+   {
+      if (snprintf(&keys[ikey * KEYLEN], KEYLEN, "%s.m_45s:%ld", prefix, ikey * 7919) >= KEYLEN)
+      {
+         fprintf(stderr, "key %ld for prefix '%s' is longer than %d bytes\n", ikey, prefix, KEYLEN - 1);
+         free(keys);
+         return NULL;
+      }
+   }
+
+   return keys;
+}
+
+static void BenchHash(long nkeys, const char *keys, const char *misses)
+{
+   Hash_Table_t h;
+   long ikey;
+   long found = 0;
+   float tins, thit, tmiss, trem;
+
+   hash_init(&h, 47, 0, (int (*)(const void *, const void *))strcmp, hash_universal_hash);
+
+   StartTimer(1);
+   for (ikey = 0; ikey < nkeys; ikey++)
+      hash_insert(&h, &keys[ikey * KEYLEN], &keys[ikey * KEYLEN]);
+   tins = StopTimer(1);
+
+   StartTimer(1);
+   for (ikey = 0; ikey < nkeys; ikey++)
+      found += (hash_lookup(&h, &keys[ikey * KEYLEN]) != NULL);
+   thit = StopTimer(1);
+
+   StartTimer(1);
+   for (ikey = 0; ikey < nkeys; ikey++)
+      found += (hash_lookup(&h, &misses[ikey * KEYLEN]) != NULL);
+   tmiss = StopTimer(1);
+
+   StartTimer(1);
+   for (ikey = 0; ikey < nkeys; ikey++)
+      hash_remove(&h, &keys[ikey * KEYLEN]);
+   trem = StopTimer(1);
+
+   if (found != nkeys || hash_size(&h) != 0)
+      fprintf(stderr, "hash: expected %ld hits, got %ld (%d left)\n", nkeys, found, hash_size(&h));
+
+   printf("hash  %9ld  insert %8.2f  hit %8.2f  miss %8.2f  remove %8.2f  Mops/s\n",
+          nkeys, Rate(nkeys, tins), Rate(nkeys, thit), Rate(nkeys, tmiss), Rate(nkeys, trem));
+
+   hash_free(&h);
+}
+
+static void BenchHcon(long nkeys, const char *keys)
+{
+   HContainer_t hc;
+   HIterator_t hit;
+   long ikey;
+   long found = 0;
+   float tins, thit, titer;
+
+   hcon_init(&hc, sizeof(long), KEYLEN, NULL, NULL);
+
+   StartTimer(1);
+   for (ikey = 0; ikey < nkeys; ikey++)
+      *(long *)hcon_allocslot(&hc, &keys[ikey * KEYLEN]) = ikey;
+   tins = StopTimer(1);
+
+   StartTimer(1);
+   for (ikey = 0; ikey < nkeys; ikey++)
+      found += (hcon_lookup(&hc, &keys[ikey * KEYLEN]) != NULL);
+   thit = StopTimer(1);
+
+   StartTimer(1);
+   hiter_new(&hit, &hc);
+   while (hiter_getnext(&hit))
+      found++;
+   hiter_free(&hit);
+   titer = StopTimer(1);
+
+   if (found != 2 * nkeys)
+      fprintf(stderr, "hcon: expected %ld hits, got %ld\n", 2 * nkeys, found);
+
+   printf("hcon  %9ld  insert %8.2f  hit %8.2f  iterate %8.2f  Mops/s\n",
+          nkeys, Rate(nkeys, tins), Rate(nkeys, thit), Rate(nkeys, titer));
+
+   hcon_free(&hc);
+}
+
+int main(int argc, char *argv[])
+{
+   long maxkeys = argc > 1 ? atol(argv[1]) : 10000000;
+   long nkeys;
+   char *keys = NULL;
+   char *misses = NULL;
+
+   for (nkeys = 100; nkeys <= maxkeys; nkeys *= 10)
+   {
+      keys = MakeKeys(nkeys, "hmi.v_45s");
+      misses = MakeKeys(nkeys, "aia.lev1");
+
+      if (!keys || !misses)
+      {
+         free(keys);
+         free(misses);
+         return 1;
+      }
+
+      BenchHash(nkeys, keys, misses);
+      BenchHcon(nkeys, keys);
+
+      free(keys);
+      free(misses);
+   }
+
+   return 0;
+}
@@ -1,133 +1,412 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
 #include "hash_table.h"
-#include "table.h"
 #include "xassert.h"
 #include "xmem.h"
 
+/* Multiplier for mapping a 64-bit hash onto a power-of-2 slot array (Fibonacci hashing). This
+ * spreads the high-order bits into the slot index, so weak caller-supplied hash functions
+ * (e.g., ones that leave the low bits constant) still probe reasonably. */
+#define HASH_FIBMULT 0x9e3779b97f4a7c15ULL
+
+/* Constants for the string hash (wyhash family). */
+#define HASH_P0 0xa0761d6478bd642fULL
+#define HASH_P1 0xe7037ed1a0b428dbULL
+#define HASH_P2 0x8ebc6af09c88c6e3ULL
+#define HASH_P3 0x589965cc75374cc3ULL
+
+/* 64x64 -> 128-bit multiply, folded back to 64 bits. */
+static inline uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+   __uint128_t r = (__uint128_t)a * b;
+
+   return (uint64_t)(r >> 64) ^ (uint64_t)r;
+#else
+   uint64_t ha = a >> 32;
+   uint64_t hb = b >> 32;
+   uint64_t la = (uint32_t)a;
+   uint64_t lb = (uint32_t)b;
+   uint64_t rh = ha * hb;
+   uint64_t rm0 = ha * lb;
+   uint64_t rm1 = hb * la;
+   uint64_t rl = la * lb;
+   uint64_t t = rl + (rm0 << 32);
+   uint64_t c = t < rl;
+   uint64_t lo = t + (rm1 << 32);
+   uint64_t hi = 0;
+
+   c += lo < t;
+   hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+
+   return hi ^ lo;
+#endif
+}
+
+static inline uint64_t hash_read8(const unsigned char *p)
+{
+   uint64_t v;
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+static inline uint64_t hash_read4(const unsigned char *p)
+{
+   uint32_t v;
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+/* Hash function for NUL-terminated strings. This replaces the old multiplicative sum (which
+ * divided by 17 on overflow and therefore clustered long keys) with a wyhash-style hash that
+ * consumes 8 bytes per step. The value is only ever used in memory, so it does not need to be
+ * stable across machines or releases. */
 unsigned long long hash_universal_hash(const void *v)
 {
-   char *c = (char *) v;
-   unsigned long long sum = 0;
+   const unsigned char *p = (const unsigned char *)v;
+   uint64_t seed = HASH_P0;
+   uint64_t a = 0;
+   uint64_t b = 0;
+   size_t len = 0;
+   size_t i = 0;
+
+   if (!p)
+   {
+      return 0;
+   }
+
+   len = strlen((const char *)p);
+
+   if (len <= 16)
+   {
+      if (len >= 4)
+      {
+         a = (hash_read4(p) << 32) | hash_read4(p + ((len >> 3) << 2));
+         b = (hash_read4(p + len - 4) << 32) | hash_read4(p + len - 4 - ((len >> 3) << 2));
+      }
+      else if (len > 0)
+      {
+         a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+      }
+   }
+   else
+   {
+      i = len;
+
+      if (i > 48)
+      {
+         uint64_t see1 = seed;
+         uint64_t see2 = seed;
+
+         do
+         {
+            seed = hash_mix(hash_read8(p) ^ HASH_P1, hash_read8(p + 8) ^ seed);
+            see1 = hash_mix(hash_read8(p + 16) ^ HASH_P2, hash_read8(p + 24) ^ see1);
+            see2 = hash_mix(hash_read8(p + 32) ^ HASH_P3, hash_read8(p + 40) ^ see2);
+            p += 48;
+            i -= 48;
+         } while (i > 48);
+
+         seed ^= see1 ^ see2;
+      }
+
+      while (i > 16)
+      {
+         seed = hash_mix(hash_read8(p) ^ HASH_P1, hash_read8(p + 8) ^ seed);
+         i -= 16;
+         p += 16;
+      }
+
+      a = hash_read8(p + i - 16);
+      b = hash_read8(p + i - 8);
+   }
+
+   return hash_mix(HASH_P1 ^ len, hash_mix(a ^ HASH_P1, b ^ seed));
+}
+
+/* Home slot of a hash value; shift is 64 - log2(number of slots). */
+static inline unsigned int hash_home(unsigned int shift, unsigned long long hashval)
+{
+   return (unsigned int)((hashval * HASH_FIBMULT) >> shift);
+}
+
+static unsigned int hash_roundup(unsigned long long n)
+{
+   unsigned int cap = HASH_MINCAPACITY;
+
+   while (cap < n && cap < HASH_MAXCAPACITY)
+   {
+      cap <<= 1;
+   }
+
+   return cap;
+}
+
+/* Place an entry into a slot array that is known not to contain its key. */
+static void hash_place(HashEntry_t *slots, unsigned int capacity, unsigned int shift, const HashEntry_t *entry)
+{
+   unsigned int mask = capacity - 1;
+   unsigned int islot = hash_home(shift, entry->hashval);
+
+   while (slots[islot].key)
+   {
+      islot = (islot + 1) & mask;
+   }
+
+   slots[islot] = *entry;
+}
+
+/* Reallocate the slot array. The cached hash values are reused, so neither the hash function nor
+ * the key comparison function is called. */
+static void hash_resize(Hash_Table_t *h, unsigned int capacity)
+{
+   HashEntry_t *oslots = h->slots;
+   unsigned int ocapacity = h->capacity;
+   unsigned int islot;
+
+   h->slots = (HashEntry_t *)calloc(capacity, sizeof(HashEntry_t));
+   XASSERT(h->slots);
+   h->capacity = capacity;
+
+   for (h->shift = 64; capacity > 1; capacity >>= 1)
+   {
+      h->shift--;
+   }
+
+   if (oslots)
+   {
+      for (islot = 0; islot < ocapacity; islot++)
+      {
+         if (oslots[islot].key)
+         {
+            hash_place(h->slots, h->capacity, h->shift, &oslots[islot]);
+         }
+      }
+
+      free(oslots);
+   }
+}
+
+/* Returns the slot index holding key, or -1 if key is not in the table. */
+static long hash_find(Hash_Table_t *h, const void *key, unsigned long long hashval)
+{
+   unsigned int mask;
+   unsigned int islot;
 
-   while ( c && *c ) 
+   if (!h->slots || h->count == 0)
    {
-      if (sum > ULLONG_MAX / 13)
+      return -1;
+   }
+
+   mask = h->capacity - 1;
+   islot = hash_home(h->shift, hashval);
+
+   while (h->slots[islot].key)
+   {
+      if (h->slots[islot].hashval == hashval && !(*h->not_equal)(key, h->slots[islot].key))
       {
-         /* handle overflow! */
-         sum /= 17;
+         return (long)islot;
       }
 
-      sum += ((unsigned long long) *c++) + 13*sum;
+      islot = (islot + 1) & mask;
    }
 
-   return sum;
+   return -1;
 }
 
-void hash_init(Hash_Table_t *h, const unsigned int hashprime, 
-	       const int initbinsize, 
-	       int (*not_equal)(const void *, const void *), 
+/* "hashprime" and "initbinsize" used to be the number of bins and the initial size of each bin.
+ * They are now combined into a hint for the initial number of slots. No memory is allocated
+ * until the first insert, so empty tables are cheap. */
+void hash_init(Hash_Table_t *h, const unsigned int hashprime,
+	       const int initbinsize,
+	       int (*not_equal)(const void *, const void *),
 	       unsigned long long (*hash)(const void *))
 {
-  unsigned int i;
-  
-  h->hashprime = hashprime;
+  unsigned long long hint = (unsigned long long)hashprime * (initbinsize > 1 ? initbinsize : 1);
+
+  h->hashprime = (hint > UINT_MAX) ? UINT_MAX : (unsigned int)hint;
   h->hash = hash;
   h->not_equal = not_equal;
-  h->list = (Table_t *) malloc(hashprime*sizeof(Table_t));
-  XASSERT(h->list);
-  for(i=0; i<hashprime; i++)  
-    table_init(initbinsize,&(h->list[i]),not_equal);
+  h->capacity = 0;
+  h->shift = 64;
+  h->count = 0;
+  h->slots = NULL;
 }
 
 
 /* Deep copy of hash table. */
 void hash_copy(Hash_Table_t *dst, Hash_Table_t *src)
 {
-  unsigned int i;
+  *dst = *src;
 
-  dst->hashprime = src->hashprime;
-  dst->not_equal = src->not_equal;
-  dst->hash = src->hash;
-  dst->list = (Table_t *) malloc(dst->hashprime*sizeof(Table_t));
-  XASSERT(dst->list);
-  for(i=0; i<dst->hashprime; i++) 
-    table_copy(&(dst->list[i]), &(src->list[i]));    
+  if (src->slots)
+  {
+    dst->slots = (HashEntry_t *)malloc(src->capacity * sizeof(HashEntry_t));
+    XASSERT(dst->slots);
+    memcpy(dst->slots, src->slots, src->capacity * sizeof(HashEntry_t));
+  }
 }
 
 void hash_free(Hash_Table_t *h)
 {
-  unsigned int i;
-  if (h->list)
+  if (h->slots)
   {
-    for(i=0; i<h->hashprime; i++) 
-      table_free(&(h->list[i]));
-    free(h->list);
-    h->list = NULL;
+    free(h->slots);
+    h->slots = NULL;
   }
+
+  h->capacity = 0;
+  h->shift = 64;
+  h->count = 0;
 }
 
-void hash_insert(Hash_Table_t *h, const void *key, const void *contents) 
+void hash_insert(Hash_Table_t *h, const void *key, const void *contents)
 {
-  table_insert(&(h->list[h->hash(key) % h->hashprime]),key,contents);
+  unsigned long long hashval = h->hash(key);
+  long islot = hash_find(h, key, hashval);
+  HashEntry_t entry;
+
+  if (islot >= 0)
+  {
+    /* Overwrite existing entry - the key pointer is replaced too. */
+    h->slots[islot].key = key;
+    h->slots[islot].value = contents;
+    return;
+  }
+
+  if (!h->slots)
+  {
+    hash_resize(h, hash_roundup(((unsigned long long)h->hashprime * HASH_MAXLOAD_DEN) / HASH_MAXLOAD_NUM));
+  }
+  else if ((unsigned long long)(h->count + 1) * HASH_MAXLOAD_DEN > (unsigned long long)h->capacity * HASH_MAXLOAD_NUM)
+  {
+    hash_resize(h, h->capacity << 1);
+  }
+
+  entry.key = key;
+  entry.value = contents;
+  entry.hashval = hashval;
+  hash_place(h->slots, h->capacity, h->shift, &entry);
+  h->count++;
 }
 
-void hash_remove(Hash_Table_t *h, const void *key) 
+void hash_remove(Hash_Table_t *h, const void *key)
 {
-  table_remove(&(h->list[h->hash(key) % h->hashprime]),key);
+  long found = hash_find(h, key, h->hash(key));
+  unsigned int mask;
+  unsigned int islot;
+  unsigned int jslot;
+  unsigned int home;
+
+  if (found < 0)
+  {
+    return;
+  }
+
+  /* Backward-shift deletion: move later members of the probe run into the hole so that lookups
+   * never need tombstones. */
+  mask = h->capacity - 1;
+  islot = (unsigned int)found;
+  jslot = islot;
+
+  for (;;)
+  {
+    jslot = (jslot + 1) & mask;
+
+    if (!h->slots[jslot].key)
+    {
+      break;
+    }
+
+    home = hash_home(h->shift, h->slots[jslot].hashval);
+
+    /* Move the entry at jslot only if its home is not cyclically within (islot, jslot]. */
+    if ((jslot > islot && (home <= islot || home > jslot)) ||
+        (jslot < islot && (home <= islot && home > jslot)))
+    {
+      h->slots[islot] = h->slots[jslot];
+      islot = jslot;
+    }
+  }
+
+  h->slots[islot].key = NULL;
+  h->slots[islot].value = NULL;
+  h->slots[islot].hashval = 0;
+  h->count--;
 }
 
-int hash_member(Hash_Table_t *h, const void *key) 
+int hash_member(Hash_Table_t *h, const void *key)
 {
-  return table_member(&(h->list[h->hash(key) % h->hashprime]),key);
+  return hash_find(h, key, h->hash(key)) >= 0;
 }
 
-const void *hash_lookup(Hash_Table_t *h, const void *key) 
+const void *hash_lookup(Hash_Table_t *h, const void *key)
 {
-  return table_lookup(&(h->list[h->hash(key) % h->hashprime]),key);
+  long islot = hash_find(h, key, h->hash(key));
+
+  return islot >= 0 ? h->slots[islot].value : NULL;
 }
 
 int hash_size(Hash_Table_t *h)
 {
-  unsigned int i,size;
-  for(i=0,size=0; i<h->hashprime; i++)
-    size += table_len(&(h->list[i]));
-  return size;
+  return (int)h->count;
 }
 
 void hash_stat(Hash_Table_t *h)
 {
-  unsigned int i, len;
-  for(i=0; i<h->hashprime; i++) {
-    len = table_len(&(h->list[i]));
-    if ( len > 0)
-      printf("%4u: %4u\n",i,len);
+  unsigned int islot;
+  unsigned int dist;
+  unsigned int maxdist = 0;
+  unsigned long long totdist = 0;
+
+  for (islot = 0; islot < h->capacity; islot++)
+  {
+    if (h->slots[islot].key)
+    {
+      dist = (islot - hash_home(h->shift, h->slots[islot].hashval)) & (h->capacity - 1);
+      totdist += dist;
+      if (dist > maxdist)
+        maxdist = dist;
+    }
   }
+
+  printf("slots: %u, entries: %u, load: %.3f, mean probe: %.3f, max probe: %u\n",
+         h->capacity, h->count, h->capacity ? (double)h->count / h->capacity : 0.0,
+         h->count ? (double)totdist / h->count : 0.0, maxdist);
 }
 
+/* hash_remove() shifts later entries of a probe run back into the freed slot, and hash_insert()
+ * can move every entry, so f must not insert into or remove from h - the walk would skip or repeat
+ * entries. Either would change the count. */
 void hash_map(Hash_Table_t *h, void (*f)(const void *, const void *))
 {
-  unsigned int i, len;  
-  for(i=0; i<h->hashprime; i++)
+  unsigned int islot;
+  unsigned int count = h->count;
+
+  for (islot = 0; islot < h->capacity; islot++)
   {
-    len = table_len(&(h->list[i]));
-    if ( len > 0 ) 
+    if (h->slots[islot].key)
     {
-      //      printf("==== HASH bin no. %5d ====\n",i);
-      table_map(&(h->list[i]),f);
+      f(h->slots[islot].key, h->slots[islot].value);
+      XASSERT(h->count == count);
     }
   }
 }
 
 void hash_map_data(Hash_Table_t *h, void (*f)(const void *, const void *, const void *data), const void *data)
 {
-  unsigned int i, len;  
-  for(i=0; i<h->hashprime; i++)
+  unsigned int islot;
+  unsigned int count = h->count;
+
+  for (islot = 0; islot < h->capacity; islot++)
   {
-    len = table_len(&(h->list[i]));
-    if ( len > 0 ) 
+    if (h->slots[islot].key)
     {
-       table_map_data(&(h->list[i]),f,data);
+      f(h->slots[islot].key, h->slots[islot].value, data);
+      XASSERT(h->count == count);
     }
   }
 }
@@ -4,24 +4,43 @@
 #include "table.h"
 #include "jsoc.h"
 
+/* Open-addressing hash table (linear probing, backward-shift deletion). Each slot caches the
+ * full hash of its key so that probing can skip most key comparisons and so that rehashing
+ * never has to call the hash function again. An empty slot has key == NULL. */
+typedef struct HashEntry_struct {
+  const void *key;
+  const void *value;
+  unsigned long long hashval;
+} HashEntry_t;
+
 typedef struct Hash_Table_struct {
-  unsigned int hashprime;
+  unsigned int hashprime;  /* initial-capacity hint passed to hash_init() (no longer a bin count) */
   int (*not_equal)(const void *, const void *);
   unsigned long long (*hash)(const void *);
-  Table_t *list;
+  unsigned int capacity;   /* number of slots (power of 2); 0 until the first insert */
+  unsigned int shift;      /* 64 - log2(capacity); maps a hash value onto its home slot */
+  unsigned int count;      /* number of occupied slots */
+  HashEntry_t *slots;
 } Hash_Table_t;
 
-void hash_init(Hash_Table_t *h, const unsigned int hashprime, const int initbinsize, 
-	       int (*not_equal)(const void *, const void *), 
+/* Grow when count / capacity would exceed HASH_MAXLOAD_NUM / HASH_MAXLOAD_DEN. */
+#define HASH_MAXLOAD_NUM 3
+#define HASH_MAXLOAD_DEN 4
+#define HASH_MINCAPACITY 8
+#define HASH_MAXCAPACITY 0x80000000U /* largest power of 2 in an unsigned int */
+
+void hash_init(Hash_Table_t *h, const unsigned int hashprime, const int initbinsize,
+	       int (*not_equal)(const void *, const void *),
 	       unsigned long long (*hash)(const void *));
 void hash_free(Hash_Table_t *h);
 void hash_copy(Hash_Table_t *dst, Hash_Table_t *src);
 void hash_insert(Hash_Table_t *h, const void *key, const void *value );
-void hash_remove(Hash_Table_t *h, const void *key); 
+void hash_remove(Hash_Table_t *h, const void *key);
 int hash_member(Hash_Table_t *h, const void *key);
 const void *hash_lookup(Hash_Table_t *h, const void *key);
 int hash_size(Hash_Table_t *h);
 void hash_stat(Hash_Table_t *h);
+/* f must not insert into or remove from h. */
 void hash_map(Hash_Table_t *h, void (*f)(const void *, const void *));
 void hash_map_data(Hash_Table_t *h, void (*f)(const void *, const void *, const void *data), const void *data);
 unsigned long long hash_universal_hash(const void *v);
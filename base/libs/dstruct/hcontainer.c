@@ -12,6 +12,78 @@
 #define TABLESIZE (0) /* Initial number of slots allocated in each hash bin. */
 #define HASH_PRIME (47)  /* Number of hash bins. */
 
+static void hcon_initelems(HContainer_t *hc)
+{
+  hc->elems = NULL;
+  hc->nelems = 0;
+  hc->szelems = 0;
+  hc->sorted = NULL;
+  hc->sortcomp = NULL;
+  hc->niters = 0;
+}
+
+/* Let go of a sorted order; the last holder frees it. */
+static void hcon_releasesorted(HContainerSorted_t **sorted)
+{
+  if (*sorted)
+  {
+    if (--(*sorted)->refs == 0)
+    {
+      free(*sorted);
+    }
+
+    *sorted = NULL;
+  }
+}
+
+/* Squeeze the holes left by hcon_remove() out of the element vector, preserving insertion order.
+ * Does nothing while a hiter_new() iterator is live - it walks the vector by position. */
+void hcon_compact(HContainer_t *hc)
+{
+  int ielem;
+  int jelem;
+
+  if (hc->nelems == hc->num_total || hc->niters > 0)
+  {
+    return;
+  }
+
+  for (ielem = 0, jelem = 0; ielem < hc->nelems; ielem++)
+  {
+    if (hc->elems[ielem])
+    {
+      hc->elems[jelem] = hc->elems[ielem];
+      hc->elems[jelem]->index = jelem;
+      jelem++;
+    }
+  }
+
+  hc->nelems = jelem;
+}
+
+/* Append a new element to the element vector. */
+static void hcon_appendelem(HContainer_t *hc, HContainerElement_t *elem)
+{
+  if (hc->nelems == hc->szelems)
+  {
+    if (hc->nelems - hc->num_total >= hc->nelems / 2 && hc->nelems > 0 && hc->niters == 0)
+    {
+      /* at least half of the vector is holes - reuse it */
+      hcon_compact(hc);
+    }
+    else
+    {
+      hc->szelems = hc->szelems > 0 ? 2 * hc->szelems : HCON_INITSIZE;
+      hc->elems = realloc(hc->elems, hc->szelems * sizeof(HContainerElement_t *));
+      XASSERT(hc->elems);
+    }
+  }
+
+  elem->index = hc->nelems;
+  hc->elems[hc->nelems++] = elem;
+  hc->sortcomp = NULL;
+}
+
 /*
   Initialize the container.
 
@@ -34,6 +106,7 @@ void hcon_init(HContainer_t *hc, int datasize, int keysize,
   hc->deep_copy = deep_copy;
   hash_init(&hc->hash, HASH_PRIME, TABLESIZE,
 	    (int (*)(const void *, const void *))strcmp, hash_universal_hash);
+  hcon_initelems(hc);
 }
 
 void hcon_init_ext(HContainer_t *hc, unsigned int hashprime, int datasize, int keysize,
@@ -47,6 +120,7 @@ void hcon_init_ext(HContainer_t *hc, unsigned int hashprime, int datasize, int k
   hc->deep_copy = deep_copy;
   hash_init(&hc->hash, hashprime, TABLESIZE,
 	    (int (*)(const void *, const void *))strcmp, hash_universal_hash);
+  hcon_initelems(hc);
 }
 
 void hcon_init_ext2(HContainer_t *hc, unsigned int hashprime, unsigned int initial_bin_size, int datasize, int keysize, void (*deep_free)(const void *value), void (*deep_copy)(const void *dst, const void *src))
@@ -57,6 +131,7 @@ void hcon_init_ext2(HContainer_t *hc, unsigned int hashprime, unsigned int initi
   hc->deep_free = deep_free;
   hc->deep_copy = deep_copy;
   hash_init(&hc->hash, hashprime, initial_bin_size, (int (*)(const void *, const void *))strcmp, hash_universal_hash);
+  hcon_initelems(hc);
 }
 
 void *hcon_allocslot_lower(HContainer_t *hc, const char *key)
@@ -102,6 +177,7 @@ void *hcon_allocslot(HContainer_t *hc, const char *key)
          * all point to memory allocated in this function */
 
         hash_insert(&hc->hash, elem->key, (void *)(elem));
+        hcon_appendelem(hc, elem);
         ++hc->num_total;
      }
   }
@@ -155,25 +231,31 @@ void *hcon_lookup_ext(HContainer_t *hc, const char *keyin, const char **keyout)
    }
 }
 
+/* Return the value of the n-th element (0-based, in insertion order). */
 void *hcon_getn(HContainer_t *hcon, unsigned int n)
 {
-   HContainerElement_t *elem = NULL; /* Pointer to allocated elem struct */
-   HIterator_t *hit = hiter_create(hcon);
+   int ielem;
 
-   if (hit && n < hit->nelems)
+   if (n >= (unsigned int)hcon->num_total)
    {
-      elem = hit->elems[n];
-      hiter_destroy(&hit);
+      return NULL;
    }
 
-   if (elem)
+   if (hcon->nelems == hcon->num_total)
    {
-      return elem->val;
+      return hcon->elems[n]->val;
    }
-   else
+
+   /* Skip the holes rather than compact the vector - an iterator may be walking it. */
+   for (ielem = 0; ielem < hcon->nelems; ielem++)
    {
-      return NULL;
+      if (hcon->elems[ielem] && n-- == 0)
+      {
+         return hcon->elems[ielem]->val;
+      }
    }
+
+   return NULL;
 }
 
 /*
@@ -195,50 +277,55 @@ int hcon_member(HContainer_t *hc, const char *key)
   return (hash_lookup(&hc->hash, key) != NULL);
 }
 
-static void hconfreemap(const void *key, const void *value, const void *data)
+static void hconfreeelem(HContainer_t *hcon, HContainerElement_t *elem)
 {
-   HContainer_t *hcon = (HContainer_t *)data;
-   HContainerElement_t *elem = NULL;
-
-   /* Don't free key - the memory it allocates (if any) wasn't allocated by
-    * hcon code. */
+   XASSERT(elem && elem->val);
 
-   if (value)
+   if (hcon->deep_free && elem->val)
    {
-      elem = (HContainerElement_t *)value;
-      XASSERT(elem && elem->val);
-
-      if (hcon->deep_free && elem->val)
-      {
-         (*hcon->deep_free)(elem->val);
-      }
-
-      /* Need to deep-free key and val */
-      if (elem->key)
-      {
-         free(elem->key);
-      }
+      (*hcon->deep_free)(elem->val);
+   }
 
-      if (elem->val)
-      {
-         free(elem->val);
-      }
+   /* Need to deep-free key and val */
+   if (elem->key)
+   {
+      free(elem->key);
+   }
 
-      /* Free the hcon elem itself. */
-      free((void *)value);
+   if (elem->val)
+   {
+      free(elem->val);
    }
+
+   /* Free the hcon elem itself. */
+   free(elem);
 }
 
 /* Free container. If "deep_free" is not NULL it is applied to every value in the container. */
 void hcon_free(HContainer_t *hc)
 {
-    /* Apply a function that will free the keys and value (and also deep-free the values, if a deep-free
-     * function was provided). After this call, the hash table will contain garbage for keys and values. */
-    if (hc->num_total > 0)
+    int ielem;
+
+    /* Free the keys and values (and also deep-free the values, if a deep-free function was provided).
+     * After this loop, the hash table will contain garbage for keys and values. */
+    for (ielem = 0; ielem < hc->nelems; ielem++)
     {
-        hash_map_data(&hc->hash, hconfreemap, hc);
+        if (hc->elems[ielem])
+        {
+            hconfreeelem(hc, hc->elems[ielem]);
+        }
     }
 
+    if (hc->elems)
+    {
+        free(hc->elems);
+    }
+
+    /* an iterator still walking the sorted order keeps it (but not the elements) */
+    hcon_releasesorted(&hc->sorted);
+
+    hcon_initelems(hc);
+
     hc->num_total = 0;
     hc->datasize = 0;
     hc->keysize = 0;
@@ -246,7 +333,7 @@ void hcon_free(HContainer_t *hc)
     hc->deep_copy = NULL;
 
     /* Free hash table - this frees an array of key-value structures; the actual key and value fields
-     * are freed by hconfreemap. */
+     * are freed above. */
     hash_free(&hc->hash);
 }
 
@@ -269,6 +356,16 @@ void hcon_remove(HContainer_t *hc, const char *key)
       /* Remove the key-value entries from the underlying hash table - does not free key or value. */
       hash_remove(&hc->hash, key);
 
+      /* Leave a hole in the element vector; it is squeezed out lazily. */
+      hc->elems[elem->index] = NULL;
+      hc->sortcomp = NULL;
+
+      /* and in the sorted order, which sorted iterators may be walking */
+      if (hc->sorted && elem->sortindex >= 0 && elem->sortindex < hc->sorted->nelems && hc->sorted->elems[elem->sortindex] == elem)
+      {
+         hc->sorted->elems[elem->sortindex] = NULL;
+      }
+
       if (elem->key)
       {
          free(elem->key);
@@ -297,11 +394,14 @@ void hcon_print(HContainer_t *hc)
    const char *key;
    void *data = NULL;
 
-   HIterator_t *hit = hiter_create(hc);
-   while((data = hiter_extgetnext(hit, &key)) != NULL)
+   HIterator_t hit;
+
+   hiter_new(&hit, hc);
+   while((data = hiter_extgetnext(&hit, &key)) != NULL)
    {
       fprintf(stdout, "%s\n", key);
    }
+   hiter_free(&hit);
 }
 
 void hcon_printf(FILE *fp, HContainer_t *hc)
@@ -309,91 +409,69 @@ void hcon_printf(FILE *fp, HContainer_t *hc)
    const char *key;
    void *data = NULL;
 
-   HIterator_t *hit = hiter_create(hc);
-   while((data = hiter_extgetnext(hit, &key)) != NULL)
+   HIterator_t hit;
+
+   hiter_new(&hit, hc);
+   while((data = hiter_extgetnext(&hit, &key)) != NULL)
    {
       fprintf(fp, "%s\n", key);
    }
+   hiter_free(&hit);
 }
 
 /*
-  Apply the function fmap to every element in the container.
+  Apply the function fmap to every element in the container, in insertion order.
 */
-static void hconmapmap(const void *key, const void *value, const void *data)
+void hcon_map(HContainer_t *hc, void (*fmap)(const void *value))
 {
-   void (*fmap)(const void *value) = (void (*)(const void *value))data;
+   int ielem;
 
-   if (value)
+   for (ielem = 0; ielem < hc->nelems; ielem++)
    {
-      (*fmap)(((HContainerElement_t *)value)->val); /* Apply fmap to every value in the hcontainer element (which is value). */
+      if (hc->elems[ielem])
+      {
+         (*fmap)(hc->elems[ielem]->val);
+      }
    }
 }
 
-static void hconmapmap_ext(const void *key, const void *value, const void *bundle)
+void hcon_map_ext(HContainer_t *hc, void (*fmap)(const void *value, void *data), void *data)
 {
-   HContainerBundle_t *bundlearg = (HContainerBundle_t *)bundle;
-   void (*fmap)(const void *value, void *data) = bundlearg->fmap;
-   void *data = bundlearg->data;
+   int ielem;
 
-   /* hash value */
-   if (value)
+   for (ielem = 0; ielem < hc->nelems; ielem++)
    {
-      (*fmap)(((HContainerElement_t *)value)->val, data); /* Apply fmap to every value in the hcontainer element (which is value);
-                                                           * this version of the function also takes an additional argument
-                                                           * to be used for virtually unlimited purposes. */
+      if (hc->elems[ielem])
+      {
+         /* this version of the function also takes an additional argument
+          * to be used for virtually unlimited purposes. */
+         (*fmap)(hc->elems[ielem]->val, data);
+      }
    }
 }
 
-void hcon_map(HContainer_t *hc, void (*fmap)(const void *value))
-{
-   hash_map_data(&hc->hash, hconmapmap, fmap);
-}
-
-void hcon_map_ext(HContainer_t *hc, void (*fmap)(const void *value, void *data), void *data)
-{
-   HContainerBundle_t bundle;
-
-   bundle.fmap = fmap;
-   bundle.data = data;
-
-   hash_map_data(&hc->hash, hconmapmap_ext, &bundle);
-}
-
 /*
   Do a deep copy of the entire container. If "deep_copy" is not NULL it is applied to every hcontainer-element value.
+  Elements are inserted into dst in src's insertion order.
 */
-static void hconcopymap(const void *key, const void *value, const void *data)
-{
-   HContainer_t *dst = (HContainer_t *)(data);
-   HContainerElement_t *elem = (HContainerElement_t *)value;
-
-   /* Can't use hash_copy() since in new implementation, the hash table stores pointers
-    * to hcontainer elements (not indices). Instead, just insert a copy of each item into
-    * the dst hcontainer. */
-
-   /* Should do deep copy, if deep_copy was provided. */
-   hcon_insert(dst, key, elem->val);
-}
-
 void hcon_copy(HContainer_t *dst, HContainer_t *src)
 {
     hcon_init(dst, src->datasize, src->keysize, src->deep_free, src->deep_copy);
-
-    /* Apply a function that inserts into the dst hcontainer a key-value pair from the src hcontainer. This will
-     * deep-copy if src->deep_free != NULL. */
-    if (src->num_total > 0)
-    {
-        hash_map_data(&src->hash, hconcopymap, dst);
-    }
+    hcon_copy_to_initialized(dst, src);
 }
 
 void hcon_copy_to_initialized(HContainer_t *dst, HContainer_t *src)
 {
-    /* Apply a function that inserts into the dst hcontainer a key-value pair from the src hcontainer. This will
-     * deep-copy if src->deep_free != NULL. */
-    if (src->num_total > 0)
+    int ielem;
+
+    /* Insert into the dst hcontainer a key-value pair from the src hcontainer. This will
+     * deep-copy if src->deep_copy != NULL. */
+    for (ielem = 0; ielem < src->nelems; ielem++)
     {
-        hash_map_data(&src->hash, hconcopymap, dst);
+        if (src->elems[ielem])
+        {
+            hcon_insert(dst, src->elems[ielem]->key, src->elems[ielem]->val);
+        }
     }
 }
 
@@ -420,52 +498,123 @@ void hcon_stat(HContainer_t *hc)
 
 /* Iterator object allows (forwards) looping over contents of
    HContainer. */
+static void hiter_init(HIterator_t *hit, HContainer_t *hc)
+{
+  hit->hc = hc;
+  hit->curr = -1;
+  hit->elems = NULL;
+  hit->nelems = 0;
+  hit->sorted = NULL;
+  hit->live = 0;
+}
 
-static void hconelemmap(const void *key, const void *value, const void *data)
+/* The walk is bounded by the vector's length now, so elements inserted during the walk are not
+ * visited, and the container holds off compacting until the iterator is freed. */
+void hiter_new(HIterator_t *hit, HContainer_t *hc)
 {
-   HIterator_t *hit = (HIterator_t *)(data);
+  hiter_init(hit, hc);
+  hit->nelems = hc->nelems;
+  hit->live = 1;
+  hc->niters++;
+}
 
-   /* May need to resize array. */
-   if (hit->nelems + 1 > hit->szelems)
+void hiter_free(HIterator_t *hit)
+{
+   if (hit)
    {
-      /* expand argarr buffer */
-      int origsz = hit->szelems;
+      if (hit->live)
+      {
+         /* hcon_free() resets the count, so don't let it go negative */
+         if (hit->hc->niters > 0)
+         {
+            hit->hc->niters--;
+         }
 
-      hit->szelems *= 2;
-      hit->elems = realloc(hit->elems, hit->szelems * sizeof(HContainerElement_t *));
-      memset(&hit->elems[origsz], 0, (hit->szelems - origsz) * sizeof(HContainerElement_t *));
-   }
+         hit->live = 0;
+      }
 
-   hit->elems[hit->nelems++] = (HContainerElement_t *)value;
+      hcon_releasesorted(&hit->sorted);
+      hit->elems = NULL;
+      hit->nelems = 0;
+   }
 }
 
-void hiter_new(HIterator_t *hit, HContainer_t *hc)
+static int hcon_issorted(HContainerElement_t **elems, int nelems, int (*comp)(const void *, const void *))
 {
-  hit->hc = hc;
-  hit->curr = -1;
-  hit->nelems = 0;
-  hit->szelems = 16;
-  hit->elems = (HContainerElement_t **)malloc(hit->szelems * sizeof(HContainerElement_t *));
-  memset(hit->elems, 0, hit->szelems * sizeof(HContainerElement_t *));
-
-  /* Need to assign the hcontainer elements to hit->elems. */
-  hash_map_data(&hit->hc->hash, hconelemmap, hit);
-}
+   int ielem;
 
-void hiter_free(HIterator_t *hit)
-{
-   if (hit && hit->elems)
+   for (ielem = 1; ielem < nelems; ielem++)
    {
-      free(hit->elems);
+      if (!elems[ielem - 1] || !elems[ielem] || (*comp)(&elems[ielem - 1], &elems[ielem]) > 0)
+      {
+         return 0;
+      }
    }
+
+   return 1;
 }
 
+/* The sorted order is kept in the container until the next insert or remove, and sorted iterators walk
+ * it in place, so repeated sorted walks allocate nothing and do no qsort. Since comparison functions look
+ * at the values, which can be modified in place, the kept order is re-checked (a linear pass) before it is
+ * reused. A new order is made in place, unless a live sorted iterator is still walking the old one. */
 void hiter_new_sort(HIterator_t *hit, HContainer_t *hc, int (*comp)(const void *, const void *))
 {
-   hiter_new(hit, hc);
+   HContainerSorted_t *sorted = NULL;
+   int ielem;
+   int jelem;
+
+   /* a sorted iterator walks its own order, so it doesn't hold off compaction */
+   hiter_init(hit, hc);
+
+   if (hc->num_total == 0)
+   {
+      return;
+   }
 
-   /* Now sort */
-   qsort(hit->elems, hit->nelems, sizeof(HContainerElement_t *), comp);
+   if (hc->sortcomp != comp || !hcon_issorted(hc->sorted->elems, hc->sorted->nelems, comp))
+   {
+      sorted = hc->sorted;
+
+      if (!sorted || sorted->refs > 1 || sorted->szelems < hc->num_total)
+      {
+         hcon_releasesorted(&hc->sorted);
+         sorted = malloc(sizeof(HContainerSorted_t) + hc->szelems * sizeof(HContainerElement_t *));
+         XASSERT(sorted);
+         sorted->refs = 1;
+         sorted->szelems = hc->szelems;
+         hc->sorted = sorted;
+      }
+
+      for (ielem = 0, jelem = 0; ielem < hc->nelems; ielem++)
+      {
+         if (hc->elems[ielem])
+         {
+            sorted->elems[jelem++] = hc->elems[ielem];
+         }
+      }
+
+      sorted->nelems = jelem;
+
+      /* containers are usually filled in sort order (e.g., keywords in rank order), and copies
+       * preserve insertion order, so this check usually avoids the qsort altogether */
+      if (!hcon_issorted(sorted->elems, sorted->nelems, comp))
+      {
+         qsort(sorted->elems, sorted->nelems, sizeof(HContainerElement_t *), comp);
+      }
+
+      for (ielem = 0; ielem < sorted->nelems; ielem++)
+      {
+         sorted->elems[ielem]->sortindex = ielem;
+      }
+
+      hc->sortcomp = comp;
+   }
+
+   hit->sorted = hc->sorted;
+   hit->sorted->refs++;
+   hit->elems = hit->sorted->elems;
+   hit->nelems = hit->sorted->nelems;
 }
 
 void hiter_rewind(HIterator_t *hit)
@@ -572,12 +721,8 @@ void hiter_destroy(HIterator_t **iter)
 {
    if (*iter != NULL)
    {
-      /* Free elems array, but not the hcontainer elements the elems elements point to. */
-      if ((*iter)->elems)
-      {
-         free((*iter)->elems);
-      }
-
+      /* Release the sorted order, but not the hcontainer elements it points to. */
+      hiter_free(*iter);
       free(*iter);
       *iter = NULL;
    }
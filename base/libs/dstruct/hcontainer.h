@@ -15,10 +15,24 @@ struct HContainerElement_struct
 {
   char *key;
   void *val;
+  int index;   /* position of this element in the container's elems vector */
+  int sortindex; /* position of this element in the container's sorted order, if it has one */
 };
 
 typedef struct HContainerElement_struct HContainerElement_t;
 
+/* A sorted order of a container's elements. It is shared by the container (while it is the container's
+ * current order) and by every iterator walking it, and is freed when the last of them lets go. */
+struct HContainerSorted_struct
+{
+  int refs;                     /* number of holders - the container and iterators */
+  int nelems;                   /* number of used slots in elems */
+  int szelems;                  /* number of allocated slots in elems */
+  HContainerElement_t *elems[]; /* the elements in sort order; hcon_remove() leaves a NULL hole */
+};
+
+typedef struct HContainerSorted_struct HContainerSorted_t;
+
 /** \brief HContainer struct */
 struct HContainer_struct {
   int num_total;          /* Number of items in container. */
@@ -27,18 +41,39 @@ struct HContainer_struct {
   Hash_Table_t hash;      /* Hash table pointing into buffer. */
   void (*deep_free)(const void *value);               /* Function for deep freeing items. */
   void (*deep_copy)(const void *dst, const void *src); /* Function for deep copy. */
+  HContainerElement_t **elems; /* Elements in insertion order. hcon_remove() leaves a NULL hole that is
+                                * squeezed out when an insert needs room. */
+  int nelems;                  /* Number of used slots in elems (live elements + holes). */
+  int szelems;                 /* Number of allocated slots in elems. */
+  HContainerSorted_t *sorted;                  /* Order produced by the last hiter_new_sort(). */
+  int (*sortcomp)(const void *, const void *); /* Comparison function that produced sorted;
+                                                * NULL if sorted is stale. */
+  int niters;                  /* Number of live hiter_new() iterators; elems is not compacted while
+                                * there are any. */
 };
 
 /** \brief HContainer struct reference */
 typedef struct HContainer_struct HContainer_t;
 
+/* An iterator created by hiter_new() walks the container's own element vector in insertion order,
+ * so it allocates nothing. The container counts it as live until it is released with hiter_free()
+ * (or hiter_destroy()), and does not compact the vector while any iterator is live, so elements never
+ * move under a walk. Elements removed during the walk are skipped; elements inserted during the walk
+ * are not visited. An iterator that is never released only stops the container from reclaiming holes.
+ * An iterator created by hiter_new_sort() walks the container's sorted order (sorted != NULL),
+ * which it shares with the container and with other sorted iterators; the order does not change under
+ * the iterator - if the container needs a different order while the iterator is live, it makes a new one.
+ * Elements removed during a sorted walk are skipped, unless the container has since made a new order.
+ * A sorted iterator must be released with hiter_free() (or hiter_destroy()), or the order leaks.
+ * Every iterator must be released before hiter_new() or hiter_new_sort() is called on it again, and
+ * before its container is freed. */
 typedef struct HIterator_struct {
   HContainer_t *hc;
-  int curr;                    /* index of current element in elems */
-  HContainerElement_t **elems; /* array of all hcontainer elements; assigned when
-                                * iterator is created */
-  int nelems;                  /* number of elements in elems (number of used elem slots in array) */
-  int szelems;                 /* number of elem slots allocated in elems */
+  int curr;                    /* index of current element in elems (or hc->elems) */
+  HContainerElement_t **elems; /* sorted->elems, or NULL to walk hc->elems */
+  int nelems;                  /* number of elements in elems (or slots of hc->elems) to walk */
+  HContainerSorted_t *sorted;  /* the sorted order walked, or NULL */
+  int live;                    /* 1 if counted in hc->niters */
 } HIterator_t;
 
 struct Bundle_struct
@@ -77,6 +112,9 @@ void hcon_copy_to_initialized(HContainer_t *dst, HContainer_t *src);
 //int hcon_size(HContainer_t *hc);
 void hcon_stat(HContainer_t *hc);
 
+/* Remove the holes that hcon_remove() leaves in the element vector. */
+void hcon_compact(HContainer_t *hc);
+
 
 void hiter_new(HIterator_t *hit, HContainer_t *hc);
 void hiter_new_sort(HIterator_t *hit, HContainer_t *hc, int (*comp)(const void *, const void *));
@@ -95,44 +133,67 @@ static inline int hcon_size(HContainer_t *hc)
 
 /* Iterator object allows (forwards) looping over contents of
    HContainer. */
-static inline void *hiter_getcurrent(HIterator_t *hit)
+static inline HContainerElement_t *hiter_getcurrentelem(HIterator_t *hit)
 {
    if (hit->curr == -1)
      return NULL;
+   else if (hit->elems)
+     return hit->elems[hit->curr];
    else
-     return (hit->elems[hit->curr])->val;
+     return hit->curr < hit->nelems ? hit->hc->elems[hit->curr] : NULL;
 }
 
-/* This just traverses all the buffers, looking for the next non-free slot. */
-static inline void *hiter_getnext(HIterator_t *hit)
+static inline void *hiter_getcurrent(HIterator_t *hit)
 {
-   void *value = NULL;
+   HContainerElement_t *elem = hiter_getcurrentelem(hit);
+
+   return elem ? elem->val : NULL;
+}
 
-   if (hit->curr + 1 < hit->hc->num_total)
+/* Advance to the next element; holes left by hcon_remove() are skipped. */
+static inline HContainerElement_t *hiter_getnextelem(HIterator_t *hit)
+{
+   HContainerElement_t **elems = NULL;
+   int nelems;
+
+   /* an insert during the walk can move hc->elems, but never the elements in it */
+   elems = hit->elems ? hit->elems : hit->hc->elems;
+   nelems = hit->nelems;
+
+   while (hit->curr + 1 < nelems)
    {
       hit->curr++;
-      value = (hit->elems[hit->curr])->val;
+      if (elems[hit->curr])
+      {
+         return elems[hit->curr];
+      }
    }
 
-   return value;
+   return NULL;
+}
+
+static inline void *hiter_getnext(HIterator_t *hit)
+{
+   HContainerElement_t *elem = hiter_getnextelem(hit);
+
+   return elem ? elem->val : NULL;
 }
 
 static inline void *hiter_extgetnext(HIterator_t *hit, const char **key)
 {
-   void *value = NULL;
+   HContainerElement_t *elem = hiter_getnextelem(hit);
 
-   if (hit->curr + 1 < hit->hc->num_total)
+   if (elem)
    {
-      hit->curr++;
-      value = (hit->elems[hit->curr])->val;
       if (key)
       {
-         *key = (hit->elems[hit->curr])->key;
+         *key = elem->key;
       }
-   }
 
-   return value;
+      return elem->val;
+   }
 
+   return NULL;
 }
 
 static inline void *hcon_getval(HContainerElement_t *elem)
@@ -125,6 +125,35 @@ main()
     print(ptr);
   }
   printf("Count = %d\n",count);
+  hiter_free(&hit);
+
+  /* Insert while walking. Thin hc1 out to mostly holes first, so these
+     inserts would compact it if no iterator were live. The walk must visit
+     every old element exactly once, and none of the new ones. */
+  for (i=0; i<NUM_INSERT; i+=2)
+  {
+    sprintf(key,"key%06d",i);
+    hcon_remove(&hc1,key);
+  }
+  j = hc1.num_total;
+  hiter_new(&hit, &hc1);
+  count = 0;
+  while( (ptr=hiter_getnext(&hit)) != NULL )
+  {
+    assert(ptr->x < NUM_INSERT);
+    if (count < NUM_INSERT)
+    {
+      sprintf(key,"key%06d",NUM_INSERT + count);
+      ptr2 = hcon_allocslot(&hc1, key);
+      ptr2->x = NUM_INSERT + count;
+      ptr2->y = 0.0;
+      ptr2->z = (float *)calloc(10, sizeof(float));
+    }
+    count++;
+  }
+  hiter_free(&hit);
+  assert(count == j);
+  assert(hc1.num_total == 2 * j);
 
   hcon_free(&hc1);
 }
@@ -0,0 +1,167 @@
+/* Benchmark for the tile-parallel codec of fitsrw_writeintfile() and fitsrw_readintfile(). It writes a
+ * tile-compressed image of shorts (a smooth pattern plus noise, like a solar image) with 1, 2, 4, ...
+ * maxthreads threads, reads it back with as many, and reports the rate of each (MB/s of uncompressed pixels).
+ * It checks that every file is identical to the one written by one thread, and that the pixels read back
+ * are the ones written. The CHECKSUM and DATASUM comments have the time the file was written, so files are
+ * compared a FITS card (80 bytes) at a time: CHECKSUM cards are skipped, and DATASUM cards are compared up
+ * to the end of the value.
+ *
+ * usage: benchfitsrw [dir] [compspec] [npix per side] [maxthreads]
+ *    eg: benchfitsrw /tmp "compress Rice" 4096 16
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include "cfitsio.h"
+#include "tasrw.h"
+
+static double Now(void)
+{
+   struct timeval tv;
+
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1.0e6;
+}
+
+static int SameFile(const char *file1, const char *file2)
+{
+   FILE *fp1 = fopen(file1, "r");
+   FILE *fp2 = fopen(file2, "r");
+   char card1[80];
+   char card2[80];
+   size_t n1 = 0;
+   size_t n2 = 0;
+   int same = 0;
+
+   if (fp1 && fp2)
+   {
+      do
+      {
+         n1 = fread(card1, 1, sizeof(card1), fp1);
+         n2 = fread(card2, 1, sizeof(card2), fp2);
+
+         if (n1 != n2)
+         {
+            same = 0;
+         }
+         else if (n1 == sizeof(card1) && strncmp(card1, "CHECKSUM= ", 10) == 0 && strncmp(card2, "CHECKSUM= ", 10) == 0)
+         {
+            same = 1;
+         }
+         else if (n1 == sizeof(card1) && strncmp(card1, "DATASUM = ", 10) == 0)
+         {
+            same = (memcmp(card1, card2, 30) == 0);
+         }
+         else
+         {
+            same = (memcmp(card1, card2, n1) == 0);
+         }
+      } while (same && n1 == sizeof(card1));
+   }
+
+   if (fp1)
+   {
+      fclose(fp1);
+   }
+
+   if (fp2)
+   {
+      fclose(fp2);
+   }
+
+   return same;
+}
+
+int main(int argc, char *argv[])
+{
+   const char *dir = argc > 1 ? argv[1] : "/tmp";
+   const char *compspec = argc > 2 ? argv[2] : "compress Rice";
+   long side = argc > 3 ? atol(argv[3]) : 4096;
+   int maxthreads = argc > 4 ? atoi(argv[4]) : 16;
+   CFITSIO_IMAGE_INFO info;
+   CFITSIO_IMAGE_INFO *rinfo = NULL;
+   short *image = NULL;
+   void *rimage = NULL;
+   char reffile[PATH_MAX];
+   char file[PATH_MAX];
+   double mbytes;
+   double twrite;
+   double tread;
+   long ipix;
+   int nthreads;
+   int same;
+   int status = 0;
+
+   image = malloc(side * side * sizeof(short));
+   if (!image)
+   {
+      fprintf(stderr, "Out of memory.\n");
+      return 1;
+   }
+
+   srandom(17);
+   for (ipix = 0; ipix < side * side; ipix++)
+   {
+      image[ipix] = (short)(1000.0 * sin((ipix % side) / 300.0) * cos((ipix / side) / 200.0) + random() % 64);
+   }
+
+   memset(&info, 0, sizeof(info));
+   info.bitpix = 16;
+   info.naxis = 2;
+   info.naxes[0] = side;
+   info.naxes[1] = side;
+
+   mbytes = side * side * sizeof(short) / 1.0e6;
+   snprintf(reffile, sizeof(reffile), "%s/benchfitsrw.1.fits", dir);
+
+   printf("%8s %12s %12s %6s %6s\n", "threads", "write MB/s", "read MB/s", "same", "pixels");
+
+   for (nthreads = 1; nthreads <= maxthreads; nthreads *= 2)
+   {
+      snprintf(file, sizeof(file), "%s/benchfitsrw.%d.fits", dir, nthreads);
+      fitsrw_set_threads(nthreads);
+
+      twrite = Now();
+      if (fitsrw_writeintfile(0, file, &info, image, compspec, NULL) != CFITSIO_SUCCESS)
+      {
+         fprintf(stderr, "Couldn't write '%s'.\n", file);
+         status = 1;
+         break;
+      }
+      fitsrw_closefptrs(0);
+      twrite = Now() - twrite;
+
+      tread = Now();
+      if (fitsrw_readintfile(0, file, &rinfo, &rimage, NULL) != CFITSIO_SUCCESS)
+      {
+         fprintf(stderr, "Couldn't read '%s'.\n", file);
+         status = 1;
+         break;
+      }
+      fitsrw_closefptrs(0);
+      tread = Now() - tread;
+
+      same = SameFile(reffile, file);
+      printf("%8d %12.1f %12.1f %6s %6s\n", nthreads, mbytes / twrite, mbytes / tread, same ? "yes" : "NO", memcmp(image, rimage, side * side * sizeof(short)) ? "NO" : "yes");
+
+      if (!same || memcmp(image, rimage, side * side * sizeof(short)))
+      {
+         status = 1;
+      }
+
+      cfitsio_free_these(&rinfo, &rimage, NULL);
+
+      if (nthreads > 1)
+      {
+         unlink(file);
+      }
+   }
+
+   unlink(reffile);
+   free(image);
+
+   return status;
+}
@@ -10,6 +10,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <regex.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "fitsio.h"
 #include "cfitsio.h"
 #include "jsoc.h"
@@ -4432,6 +4437,501 @@ int fitsrw_read_keylist_and_image_info(FITSRW_fhandle fhandle,
    return cfitsio_read_keylist_and_image_info((fitsfile *)fhandle, keylistout, image_info);
 }
 
+/* Tile-parallel codec for tile-compressed images. CFITSIO compresses and uncompresses an image a tile at
+ * a time, and a fitsfile can be used by only one thread at a time. So, to put more than one core to work,
+ * fitsrw_readintfile() and fitsrw_writeintfile() split a compressed image into bands of whole tiles along
+ * its last axis, and give each band to a thread with its own fitsfile. fits_open_file() can't provide that
+ * fitsfile - it shares the FITSfile of a file that is already open, so every band would use the caller's.
+ * A reader instead maps the file and opens the mapping with fits_open_memfile(), which always makes a new
+ * FITSfile, then reads its band with fits_read_img(). A writer compresses its band into an in-memory file,
+ * and the calling thread then copies the bands' compressed tiles, in order, into the output file's table,
+ * which leaves the output identical, byte for byte, to one written by a single fits_write_img(). Threads are
+ * used only if fitsrw_set_threads() was called with a value greater than 1, and CFITSIO was built thread-safe. */
+
+static int gFitsrwThreads = 1;
+
+void fitsrw_set_threads(int nthreads)
+{
+   gFitsrwThreads = (nthreads > 1) ? nthreads : 1;
+}
+
+int fitsrw_get_threads(void)
+{
+   return gFitsrwThreads;
+}
+
+typedef struct
+{
+   pthread_t thread;
+   int started;
+   fitsfile *fptr;           /* the band's own fitsfile */
+   void *mem;                /* reader - the mapped file, and its size (CFITSIO keeps pointers to both) */
+   size_t memsize;
+   int hdunum;               /* reader - the HDU of the image in the file */
+   int data_type;            /* the in-memory data type of the pixels */
+   int img_type;             /* writer - the BITPIX of the image */
+   double bzero;             /* the zero passed to fits_set_bscale() */
+   int naxis;
+   long naxes[CFITSIO_MAX_DIM]; /* writer - the dimensions of the band */
+   int comp_type;            /* writer - the compression parameters of the output */
+   long tile[CFITSIO_MAX_DIM];
+   float hcomp_scale;
+   int hcomp_smooth;
+   LONGLONG firstpix;        /* 0-based index, in the image, of the band's first pixel */
+   LONGLONG npixels;
+   void *pixels;             /* the band's pixels */
+   int status;
+} CfBand_t;
+
+/* Gets the tile dimensions of the compressed image fptr from its ZTILEn keywords. A missing ZTILE1 means
+ * a tile is a whole row, and any other missing ZTILEn a length of 1. */
+static int CfGetTileDims(fitsfile *fptr, int naxis, const long *naxes, long *tile, int *status)
+{
+   char keyname[FLEN_KEYWORD];
+   int i;
+
+   for (i = 0; i < naxis && !*status; i++)
+   {
+      snprintf(keyname, sizeof(keyname), "ZTILE%d", i + 1);
+      if (fits_read_key(fptr, TLONG, keyname, &tile[i], NULL, status) == KEY_NO_EXIST)
+      {
+         *status = 0;
+         tile[i] = (i == 0) ? naxes[0] : 1;
+      }
+   }
+
+   return *status;
+}
+
+/* Returns the number of bands (at most gFitsrwThreads) into which a compressed image of naxis dimensions,
+ * whose tiles are tileheight long in the last dimension, can be split; sets *bandheight to the length (in the
+ * last dimension) of every band but the last one. Returns 1 if the image should be read or written serially. */
+static int CfGetBands(int naxis, const long *naxes, long tileheight, long *bandheight)
+{
+   long ntilerows;
+   int nbands;
+
+   if (gFitsrwThreads <= 1 || naxis < 2 || !fits_is_reentrant())
+   {
+      return 1;
+   }
+
+   if (tileheight < 1)
+   {
+      tileheight = 1;
+   }
+
+   ntilerows = (naxes[naxis - 1] + tileheight - 1) / tileheight;
+   nbands = ntilerows < gFitsrwThreads ? (int)ntilerows : gFitsrwThreads;
+
+   if (nbands > 1)
+   {
+      *bandheight = ((ntilerows + nbands - 1) / nbands) * tileheight;
+
+      /* rounding up the band height can leave fewer bands */
+      nbands = (int)((naxes[naxis - 1] + *bandheight - 1) / *bandheight);
+   }
+
+   return nbands;
+}
+
+static void *CfReadBand(void *data)
+{
+   CfBand_t *band = (CfBand_t *)data;
+
+   /* the name is only a label - it must not hold an extended-filename suffix */
+   if (!fits_open_memfile(&band->fptr, "fitsrw-band", READONLY, &band->mem, &band->memsize, 0, NULL, &band->status))
+   {
+      fits_movabs_hdu(band->fptr, band->hdunum, NULL, &band->status);
+      fits_set_bscale(band->fptr, 1.0, band->bzero, &band->status);
+      fits_set_imgnull(band->fptr, 0, &band->status);
+      fits_read_img(band->fptr, band->data_type, band->firstpix + 1, band->npixels, NULL, band->pixels, NULL, &band->status);
+      fits_close_file(band->fptr, &band->status);
+      band->fptr = NULL;
+   }
+
+   return NULL;
+}
+
+static void *CfWriteBand(void *data)
+{
+   CfBand_t *band = (CfBand_t *)data;
+
+   if (!fits_create_file(&band->fptr, "mem://", &band->status))
+   {
+      fits_set_compression_type(band->fptr, band->comp_type, &band->status);
+      fits_set_tile_dim(band->fptr, band->naxis, band->tile, &band->status);
+      if (band->comp_type == HCOMPRESS_1)
+      {
+         fits_set_hcomp_scale(band->fptr, band->hcomp_scale, &band->status);
+         fits_set_hcomp_smooth(band->fptr, band->hcomp_smooth, &band->status);
+      }
+
+      fits_create_img(band->fptr, band->img_type, band->naxis, band->naxes, &band->status);
+      fits_set_bscale(band->fptr, 1.0, band->bzero, &band->status);
+      fits_set_imgnull(band->fptr, 0, &band->status);
+      fits_write_img(band->fptr, band->data_type, 1, band->npixels, band->pixels, &band->status);
+
+      /* the calling thread copies the compressed tiles out of band->fptr, then closes it */
+      if (band->status)
+      {
+         int ignore = 0;
+
+         fits_close_file(band->fptr, &ignore);
+         band->fptr = NULL;
+      }
+   }
+
+   return NULL;
+}
+
+/* Starts nbands threads, each running fn on one of the bands. If a thread cannot be created, the band is
+ * processed by the calling thread. */
+static void CfStartBands(CfBand_t *bands, int nbands, void *(*fn)(void *))
+{
+   int iband;
+
+   for (iband = 0; iband < nbands; iband++)
+   {
+      bands[iband].started = (pthread_create(&bands[iband].thread, NULL, fn, &bands[iband]) == 0);
+      if (!bands[iband].started)
+      {
+         (*fn)(&bands[iband]);
+      }
+   }
+}
+
+static void CfJoinBand(CfBand_t *band)
+{
+   if (band->started)
+   {
+      pthread_join(band->thread, NULL);
+      band->started = 0;
+   }
+}
+
+/* Reads the pixels of the compressed image fptr (positioned at the image) into pixels, nbands bands at a time.
+ * The caller has already set the raw-pixel scaling (fits_set_bscale()) and null value (fits_set_imgnull()) on fptr;
+ * each band uses the same. */
+static int CfReadCompressedBands(fitsfile *fptr, const char *filename, int data_type, int bytepix, int naxis, const long *naxes, int nbands, long bandheight, void *pixels, int *status)
+{
+   CfBand_t *bands = NULL;
+   LONGLONG bandpixels = bandheight;
+   LONGLONG npixels = 1;
+   struct stat stbuf;
+   void *mem = MAP_FAILED;
+   int fd = -1;
+   int hdunum = 0;
+   int iband;
+   int i;
+
+   for (i = 0; i < naxis - 1; i++)
+   {
+      bandpixels *= naxes[i];
+   }
+
+   for (i = 0; i < naxis; i++)
+   {
+      npixels *= naxes[i];
+   }
+
+   /* the bands read the file as it is on disk, so it must not have unflushed changes */
+   fits_get_hdu_num(fptr, &hdunum);
+   if (fits_flush_file(fptr, status))
+   {
+      return *status;
+   }
+
+   fd = open(filename, O_RDONLY);
+   if (fd == -1 || fstat(fd, &stbuf) == -1 || stbuf.st_size == 0 || (mem = mmap(NULL, stbuf.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+   {
+      *status = FILE_NOT_OPENED;
+   }
+
+   if (fd != -1)
+   {
+      /* the mapping stays valid after the descriptor is closed */
+      close(fd);
+   }
+
+   if (*status)
+   {
+      return *status;
+   }
+
+   bands = calloc(nbands, sizeof(CfBand_t));
+   if (!bands)
+   {
+      munmap(mem, stbuf.st_size);
+      *status = MEMORY_ALLOCATION;
+      return *status;
+   }
+
+   for (iband = 0; iband < nbands; iband++)
+   {
+      bands[iband].mem = mem;
+      bands[iband].memsize = stbuf.st_size;
+      bands[iband].hdunum = hdunum;
+      bands[iband].data_type = data_type;
+      bands[iband].bzero = 0.0;
+      bands[iband].firstpix = iband * bandpixels;
+      bands[iband].npixels = (iband < nbands - 1) ? bandpixels : npixels - bands[iband].firstpix;
+      bands[iband].pixels = (char *)pixels + bands[iband].firstpix * bytepix;
+   }
+
+   CfStartBands(bands, nbands, CfReadBand);
+
+   for (iband = 0; iband < nbands; iband++)
+   {
+      CfJoinBand(&bands[iband]);
+      if (bands[iband].status && !*status)
+      {
+         *status = bands[iband].status;
+      }
+   }
+
+   free(bands);
+   munmap(mem, stbuf.st_size);
+
+   return *status;
+}
+
+/* Returns 1 if the table of the compressed image fptr holds its tiles in a single COMPRESSED_DATA column - the
+ * only layout CfCopyBandTiles() can copy. CFITSIO adds other columns (GZIP_COMPRESSED_DATA, UNCOMPRESSED_DATA,
+ * ZBLANK, ZSCALE, ZZERO) when a tile needs them. */
+static int CfTilesCopyable(fitsfile *fptr)
+{
+   int ncols = 0;
+   int colnum = 0;
+   int cfiostat = 0;
+
+   fits_get_num_cols(fptr, &ncols, &cfiostat);
+   fits_get_colnum(fptr, CASEINSEN, "COMPRESSED_DATA", &colnum, &cfiostat);
+
+   return (!cfiostat && ncols == 1 && colnum == 1);
+}
+
+/* Returns 1 if keyname has the same value in the current HDUs of fptr1 and fptr2, or is in neither. */
+static int CfSameKey(fitsfile *fptr1, fitsfile *fptr2, const char *keyname)
+{
+   char value1[FLEN_VALUE];
+   char value2[FLEN_VALUE];
+   int stat1 = 0;
+   int stat2 = 0;
+
+   fits_read_keyword(fptr1, keyname, value1, NULL, &stat1);
+   fits_read_keyword(fptr2, keyname, value2, NULL, &stat2);
+
+   if (stat1 || stat2)
+   {
+      return (stat1 == KEY_NO_EXIST && stat2 == KEY_NO_EXIST);
+   }
+
+   return (strcmp(value1, value2) == 0);
+}
+
+/* Returns 1 if the tiles of band can be copied into the table of the compressed image fptr: the band's table must
+ * have the output's layout, and its tiles must have been compressed the same way. */
+static int CfBandMatches(fitsfile *fptr, CfBand_t *band)
+{
+   const char *keys[] = { "ZCMPTYPE", "ZNAME1", "ZVAL1", "ZNAME2", "ZVAL2", NULL };
+   int ikey;
+
+   if (!CfTilesCopyable(band->fptr))
+   {
+      return 0;
+   }
+
+   for (ikey = 0; keys[ikey]; ikey++)
+   {
+      if (!CfSameKey(fptr, band->fptr, keys[ikey]))
+      {
+         return 0;
+      }
+   }
+
+   return 1;
+}
+
+/* Copies the compressed tiles of band (the rows of its table) into the table of the compressed image fptr,
+ * starting at row firstrow. Both tables must pass CfTilesCopyable(). The tiles are copied as elements of the
+ * column's own type - PLIO_1 tiles are arrays of shorts (a 1PI column), the others arrays of bytes (1PB). */
+static int CfCopyBandTiles(fitsfile *fptr, CfBand_t *band, LONGLONG firstrow, int *status)
+{
+   unsigned char *buf = NULL;
+   LONGLONG bufsize = 0;
+   LONGLONG nrows = 0;
+   LONGLONG irow;
+   LONGLONG repeat;
+   LONGLONG offset;
+   int typecode = 0;
+   int elemsize = 0;
+   int anynul = 0;
+
+   if (fits_get_num_rowsll(band->fptr, &nrows, status) || fits_get_coltype(band->fptr, 1, &typecode, NULL, NULL, status))
+   {
+      return *status;
+   }
+
+   /* a variable-length column has a negative type code */
+   typecode = abs(typecode);
+   switch (typecode)
+   {
+      case TBYTE:
+        elemsize = 1;
+        break;
+      case TSHORT:
+        elemsize = 2;
+        break;
+      case TLONG:
+        typecode = TINT;
+        elemsize = 4;
+        break;
+      default:
+        *status = BAD_TFORM;
+        return *status;
+   }
+
+   for (irow = 1; irow <= nrows && !*status; irow++)
+   {
+      fits_read_descriptll(band->fptr, 1, irow, &repeat, &offset, status);
+
+      if (!*status && repeat * elemsize > bufsize)
+      {
+         free(buf);
+         bufsize = repeat * elemsize;
+         buf = malloc(bufsize);
+         if (!buf)
+         {
+            *status = MEMORY_ALLOCATION;
+         }
+      }
+
+      if (!*status && repeat > 0)
+      {
+         fits_read_col(band->fptr, typecode, 1, irow, 1, repeat, NULL, buf, &anynul, status);
+         fits_write_col(fptr, typecode, 1, firstrow + irow - 1, 1, repeat, buf, status);
+      }
+   }
+
+   free(buf);
+
+   return *status;
+}
+
+/* Writes the pixels of the compressed image fptr (just created with fits_create_img(), with scaling and null value
+ * already set), nbands bands at a time. Returns -1, having written nothing, if the tiles can't be copied - the output
+ * table or a band's table has anything but a single COMPRESSED_DATA column, or a band was compressed differently
+ * from the output; the caller then writes the image serially. */
+static int CfWriteCompressedBands(fitsfile *fptr, int img_type, int data_type, double bzero, int bytepix, int naxis, const long *naxes, int nbands, long bandheight, void *pixels, int *status)
+{
+   CfBand_t *bands = NULL;
+   LONGLONG bandpixels = bandheight;
+   LONGLONG npixels = 1;
+   LONGLONG tilesperband = 1;
+   long tile[CFITSIO_MAX_DIM];
+   int comp_type = 0;
+   float hcomp_scale = 0;
+   int hcomp_smooth = 0;
+   int copyable = 1;
+   int iband;
+   int i;
+
+   if (!CfTilesCopyable(fptr))
+   {
+      return -1;
+   }
+
+   /* the compression parameters the caller requested for fptr, which fits_create_img() used */
+   CfGetTileDims(fptr, naxis, naxes, tile, status);
+   fits_get_compression_type(fptr, &comp_type, status);
+   fits_get_hcomp_scale(fptr, &hcomp_scale, status);
+   fits_get_hcomp_smooth(fptr, &hcomp_smooth, status);
+   if (*status)
+   {
+      return *status;
+   }
+
+   for (i = 0; i < naxis; i++)
+   {
+      npixels *= naxes[i];
+      if (i < naxis - 1)
+      {
+         bandpixels *= naxes[i];
+         tilesperband *= (naxes[i] + tile[i] - 1) / tile[i];
+      }
+   }
+
+   tilesperband *= bandheight / tile[naxis - 1];
+
+   bands = calloc(nbands, sizeof(CfBand_t));
+   if (!bands)
+   {
+      *status = MEMORY_ALLOCATION;
+      return *status;
+   }
+
+   for (iband = 0; iband < nbands; iband++)
+   {
+      bands[iband].data_type = data_type;
+      bands[iband].img_type = img_type;
+      bands[iband].bzero = bzero;
+      bands[iband].naxis = naxis;
+      for (i = 0; i < naxis; i++)
+      {
+         bands[iband].naxes[i] = naxes[i];
+         bands[iband].tile[i] = tile[i];
+      }
+      bands[iband].comp_type = comp_type;
+      bands[iband].hcomp_scale = hcomp_scale;
+      bands[iband].hcomp_smooth = hcomp_smooth;
+      bands[iband].firstpix = iband * bandpixels;
+      bands[iband].npixels = (iband < nbands - 1) ? bandpixels : npixels - bands[iband].firstpix;
+      bands[iband].naxes[naxis - 1] = bands[iband].npixels / (bandpixels / bandheight);
+      bands[iband].pixels = (char *)pixels + bands[iband].firstpix * bytepix;
+   }
+
+   CfStartBands(bands, nbands, CfWriteBand);
+
+   /* every band must be checked before any tile is copied, so that a band that can't be copied leaves the
+    * output untouched for the serial write */
+   for (iband = 0; iband < nbands; iband++)
+   {
+      CfJoinBand(&bands[iband]);
+
+      if (bands[iband].status && !*status)
+      {
+         *status = bands[iband].status;
+      }
+
+      if (!*status && copyable && !CfBandMatches(fptr, &bands[iband]))
+      {
+         copyable = 0;
+      }
+   }
+
+   /* the heap must be written in tile order */
+   for (iband = 0; iband < nbands; iband++)
+   {
+      if (bands[iband].fptr)
+      {
+         int ignore = 0;
+
+         if (!*status && copyable)
+         {
+            CfCopyBandTiles(fptr, &bands[iband], iband * tilesperband + 1, status);
+         }
+
+         fits_close_file(bands[iband].fptr, &ignore);
+         bands[iband].fptr = NULL;
+      }
+   }
+
+   free(bands);
+
+   return (*status || copyable) ? *status : -1;
+}
+
 /****************************************************************************/
 
 /* `keylist` is never used by any caller (since the up-to-date keyword data is in the DRMS DB for all SUMS files) */
@@ -4448,6 +4948,9 @@ int fitsrw_readintfile(int verbose,
 
    int  data_type, bytepix, i;
    long	npixels;
+   int nbands;
+   long bandheight = 0;
+   long tile[CFITSIO_MAX_DIM];
 
    void* pixels = NULL;
 
@@ -4529,7 +5032,15 @@ int fitsrw_readintfile(int verbose,
     * not the image HDU.
     */
 
-   if(fits_read_img(fptr, data_type, 1, npixels, NULL, pixels, NULL, &status))
+   if (fits_is_compressed_image(fptr, &status) && !CfGetTileDims(fptr, (*image_info)->naxis, (*image_info)->naxes, tile, &status) && (nbands = CfGetBands((*image_info)->naxis, (*image_info)->naxes, tile[(*image_info)->naxis - 1], &bandheight)) > 1)
+   {
+      if (CfReadCompressedBands(fptr, fits_filename, data_type, bytepix, (*image_info)->naxis, (*image_info)->naxes, nbands, bandheight, pixels, &status))
+      {
+         error_code = CFITSIO_ERROR_LIBRARY;
+         goto error_exit;
+      }
+   }
+   else if(status || fits_read_img(fptr, data_type, 1, npixels, NULL, pixels, NULL, &status))
    {
       error_code = CFITSIO_ERROR_LIBRARY;
       goto error_exit;
@@ -4612,6 +5123,83 @@ error_exit:
    return error_code;
 }
 
+/* Like fitsrw_readintfile(), but instead of reading the image, returns the offset in the file of its
+ * data unit, so that the caller can map the file into memory. The pixels in the data unit are raw (unscaled,
+ * BYTE_IMG pixels are unsigned) and big-endian. Fails with CFITSIO_ERROR_ALREADY_COMPRESSED if the image
+ * is tile-compressed (its data unit is a binary table, not the image). */
+int fitsrw_readintfile_layout(int verbose,
+                              char* fits_filename,
+                              CFITSIO_IMAGE_INFO** image_info,
+                              long long* dataoffset)
+{
+   fitsfile *fptr=NULL;
+   int status = 0;
+   int error_code = CFITSIO_FAIL;
+   int fileCreated = 0;
+   LONGLONG headstart;
+   LONGLONG datastart;
+   LONGLONG dataend;
+   LONGLONG npixels;
+   int i;
+   char cfitsiostat[FLEN_STATUS];
+
+   fptr = (fitsfile *)fitsrw_getfptr(verbose, fits_filename, 0, &status, &fileCreated);
+
+   XASSERT(!fileCreated);
+
+   if (!fptr)
+   {
+      error_code = CFITSIO_ERROR_FILE_DOESNT_EXIST;
+      goto error_exit;
+   }
+
+   if (fits_is_compressed_image(fptr, &status))
+   {
+      error_code = CFITSIO_ERROR_ALREADY_COMPRESSED;
+      goto error_exit;
+   }
+
+   error_code = cfitsio_read_keylist_and_image_info(fptr, NULL, image_info);
+   if(error_code != CFITSIO_SUCCESS) goto error_exit;
+
+   if (fits_get_hduaddrll(fptr, &headstart, &datastart, &dataend, &status))
+   {
+      error_code = CFITSIO_ERROR_LIBRARY;
+      goto error_exit;
+   }
+
+   npixels = 1;
+   for(i=0;i<(*image_info)->naxis;i++) npixels *= (*image_info)->naxes[i];
+
+   if (dataend - datastart < npixels * (abs((*image_info)->bitpix) / 8))
+   {
+      error_code = CFITSIO_ERROR_INVALIDFILE;
+      goto error_exit;
+   }
+
+   fitsrw_closefptr(verbose, (TASRW_FilePtr_t)fptr);
+
+   *dataoffset = (long long)datastart;
+   return CFITSIO_SUCCESS;
+
+error_exit:
+
+   if (status)
+   {
+      fits_get_errstatus(status, cfitsiostat);
+      fprintf(stderr, "cfitsio error '%s'.\n", cfitsiostat);
+   }
+
+   cfitsio_free_these(image_info, NULL, NULL);
+
+   if (fptr)
+   {
+       fitsrw_closefptr(verbose, (TASRW_FilePtr_t)fptr);
+   }
+
+   return error_code;
+}
+
 /******************************************************************************/
 
 
@@ -4690,6 +5278,9 @@ int fitsrw_writeintfile(int verbose,
 
    int fileCreated = 0;
    long long imgSize = 0;
+   int nbands;
+   long bandheight = 0;
+   long tile[CFITSIO_MAX_DIM];
 
    // image_info contain the image dimensions, can not be missing
    if(image_info == NULL) return CFITSIO_ERROR_ARGS;
@@ -4881,7 +5472,23 @@ int fitsrw_writeintfile(int verbose,
 
    if (image)
    {
-      if(fits_write_img(fptr, data_type, 1, npixels, image, &status))
+      int wrote = 0;
+
+      if (fits_is_compressed_image(fptr, &status) && !CfGetTileDims(fptr, image_info->naxis, image_info->naxes, tile, &status) && (nbands = CfGetBands(image_info->naxis, image_info->naxes, tile[image_info->naxis - 1], &bandheight)) > 1)
+      {
+         /* CfWriteCompressedBands() returns -1 if it can't split this image */
+         int bandstat = CfWriteCompressedBands(fptr, img_type, data_type, image_info->bitpix == BYTE_IMG ? -128.0 : 0.0, abs(img_type) / 8, image_info->naxis, image_info->naxes, nbands, bandheight, image, &status);
+
+         if (bandstat > 0)
+         {
+            error_code = CFITSIO_ERROR_LIBRARY;
+            goto error_exit;
+         }
+
+         wrote = (bandstat == 0);
+      }
+
+      if(!wrote && (status || fits_write_img(fptr, data_type, 1, npixels, image, &status)))
       {
          error_code = CFITSIO_ERROR_LIBRARY;
          goto error_exit;
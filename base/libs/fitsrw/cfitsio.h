@@ -193,6 +193,11 @@ int fitsrw_readintfile(int verbose,
                        void** image,
                        CFITSIO_KEYWORD** keylist);
 
+int fitsrw_readintfile_layout(int verbose,
+                              char* fits_filename,
+                              CFITSIO_IMAGE_INFO** image_info,
+                              long long* dataoffset);
+
 int fitsrw_writeintfile(int verbose,
                         const char* fits_filename,
                         CFITSIO_IMAGE_INFO* info,
@@ -200,6 +205,12 @@ int fitsrw_writeintfile(int verbose,
                         const char* compspecs,
                         CFITSIO_KEYWORD* keylist); //keylist == NULL if not needed
 
+/* The number of threads fitsrw_readintfile() and fitsrw_writeintfile() use to uncompress and compress
+ * tile-compressed images (default 1). Images are split into bands of whole tiles; the output is the same
+ * whatever the number of threads. */
+void fitsrw_set_threads(int nthreads);
+int fitsrw_get_threads(void);
+
 void cfitsio_free_these(CFITSIO_IMAGE_INFO** image_info, void** image, CFITSIO_KEYWORD** keylist);
 
 int cfitsio_create_header_key(const char *name, cfitsio_keyword_datatype_t type, int number_bytes, const void *value, const char *format, const char *comment, const char *unit, CFITSIO_KEYWORD **key_out);
@@ -110,6 +110,236 @@ static int fitsrw_setfpinfo(fitsfile *fptr, TASRW_FILE_PTR_INFO *info)
    return err;
 }
 
+/* Each cached fitsfile. fptr must be the first field - code that looks up gFFiles treats the value
+ * as a fitsfile **. */
+typedef struct
+{
+   fitsfile *fptr;
+   unsigned long long lastuse; /* value of gFFTick when the fitsfile was last handed out */
+   int nusers;                 /* number of callers the fitsfile has been handed to, less the ones that have
+                                * released it (with fitsrw_closefptr(), or at the end of a tasrw call that
+                                * uses it only for the call); a fitsfile with users is never evicted */
+} TASRW_FFile_t;
+
+static unsigned long long gFFTick = 0;
+static long long gFFHits = 0;
+static long long gFFMisses = 0;
+static long long gFFEvictions = 0;
+
+/* Writes the checksum of (and first shrinks the image of, if it is dirty) a writeable fitsfile, then closes it.
+ * Removes the fitsfile's info from gFFPtrInfo, but not the fitsfile from gFFiles. Used by every path that
+ * closes a cached fitsfile - eviction, fitsrw_closefptr(), and fitsrw_closefptrs(). */
+static int CloseCachedFile(int verbose, const char *fhkey, fitsfile *fptr)
+{
+   int stat = 0;
+   int fiostat = 0;
+   char fileinfokey[64];
+   char cfitsiostat[FLEN_STATUS];
+   TASRW_FILE_PTR_INFO finfo;
+
+   if (IsWriteable(fhkey))
+   {
+      /* Before removing the file info, get the dirty flag value and the value of NAXISn. */
+      stat = fitsrw_getfpinfo(fptr, &finfo);
+
+      if (stat)
+      {
+         /* we need info in gFFPtrInfo so we can resize the image */
+         fprintf(stderr, "missing file info for fits file '%s'\n", fhkey);
+         stat = CFITSIO_ERROR_CANT_GET_FILEINFO;
+      }
+      else if (finfo.bitfield & kInfoPresent_Dirt)
+      {
+         /* If this is a writable fits file AND the dirty flag is set (which means that
+          * since the file was first created, the NAXISn length has changed due to
+          * slice writing), then resize the image before closing the fits file; fits_resize_imgll()
+          * also updates NAXISn. */
+         int imgType;
+         long long *axes = NULL;
+         int iaxis;
+
+         axes = calloc(finfo.naxis, sizeof(long long));
+
+         if (!axes)
+         {
+            stat = CFITSIO_ERROR_OUT_OF_MEMORY;
+         }
+         else
+         {
+            for (iaxis = 0; iaxis < finfo.naxis; iaxis++)
+            {
+               axes[iaxis] = finfo.naxes[iaxis];
+            }
+
+            switch(finfo.bitpix)
+            {
+               case(BYTE_IMG): imgType = SBYTE_IMG; break;
+               case(SHORT_IMG): imgType = SHORT_IMG; break;
+               case(LONG_IMG): imgType = LONG_IMG; break;
+               case(LONGLONG_IMG): imgType = LONGLONG_IMG; break;
+               case(FLOAT_IMG): imgType = FLOAT_IMG; break;
+               case(DOUBLE_IMG): imgType = DOUBLE_IMG; break;
+            }
+
+            fiostat = 0;
+            fits_resize_imgll(fptr, imgType, finfo.naxis, axes, &fiostat);
+
+            if (fiostat)
+            {
+               fprintf(stderr, "FITSIO error: %d\n", fiostat);
+               fprintf(stderr, "unable to resize image in fits file %s\n", fhkey);
+               stat = CFITSIO_ERROR_LIBRARY;
+            }
+
+            free(axes);
+            axes = NULL;
+         }
+      }
+
+      if (!stat)
+      {
+         /* we are closing a file, so write its checksum */
+         if (verbose)
+         {
+            PushTimer();
+         }
+
+         fiostat = 0;
+         fits_write_chksum(fptr, &fiostat);
+
+         if (fiostat)
+         {
+            fits_get_errstatus(fiostat, cfitsiostat);
+            fprintf(stderr, "Closing fitsfile: error calculating and writing checksum for fitsfile '%s'.\n", fhkey);
+            fprintf(stderr, "CFITSIO error '%s'\n", cfitsiostat);
+            stat = CFITSIO_ERROR_LIBRARY;
+         }
+
+         if (verbose)
+         {
+            fprintf(stdout, "Time to write checksum on fitsfile '%s' = %f sec.\n", fhkey, PopTimer());
+         }
+      }
+   }
+
+   /* remove fileptr from gFFPtrInfo; this needs to be done regardless of write-status  */
+   snprintf(fileinfokey, sizeof(fileinfokey), "%p", (void *)fptr);
+   hcon_remove(gFFPtrInfo, fileinfokey);
+
+   if (verbose)
+   {
+      PushTimer();
+   }
+
+   fiostat = 0;
+   fits_close_file(fptr, &fiostat);
+
+   if (fiostat == 0)
+   {
+      if (verbose)
+      {
+         fprintf(stdout, "Closing fits file '%s'.\n", fhkey);
+      }
+   }
+   else
+   {
+      fits_get_errstatus(fiostat, cfitsiostat);
+      fprintf(stderr, "Closing fitsfile: error closing fitsfile '%s'.\n", fhkey);
+      fprintf(stderr, "CFITSIO error '%s'\n", cfitsiostat);
+      perror("CloseCachedFile() system error");
+
+      if (!stat)
+      {
+         stat = CFITSIO_ERROR_FILE_IO;
+      }
+   }
+
+   if (verbose)
+   {
+      fprintf(stdout, "Time to close fitsfile '%s' = %f sec.\n", fhkey, PopTimer());
+   }
+
+   return stat;
+}
+
+/* Closes the least-recently used fitsfile in gFFiles that no caller holds (writing its checksum if it is
+ * writeable) and removes it from the cache. Sets *evicted to 0 if every cached fitsfile is in use. */
+static int EvictLRUFile(int verbose, int *evicted)
+{
+   HIterator_t *hit = NULL;
+   TASRW_FFile_t *ffile = NULL;
+   TASRW_FFile_t *lru = NULL;
+   const char *fhkey = NULL;
+   char lrukey[PATH_MAX + 2];
+   int stat = 0;
+
+   *evicted = 0;
+
+   hit = hiter_create(gFFiles);
+   if (!hit)
+   {
+      return CFITSIO_ERROR_OUT_OF_MEMORY;
+   }
+
+   while ((ffile = (TASRW_FFile_t *)hiter_extgetnext(hit, &fhkey)) != NULL)
+   {
+      if (ffile->nusers > 0 && ffile->fptr)
+      {
+         /* a caller still has this fitsfile */
+         continue;
+      }
+
+      if (!lru || ffile->lastuse < lru->lastuse)
+      {
+         lru = ffile;
+         snprintf(lrukey, sizeof(lrukey), "%s", fhkey);
+      }
+   }
+
+   hiter_destroy(&hit);
+
+   if (lru)
+   {
+      if (lru->fptr)
+      {
+         stat = CloseCachedFile(verbose, lrukey, lru->fptr);
+      }
+
+      hcon_remove(gFFiles, lrukey);
+      gFFEvictions++;
+      *evicted = 1;
+   }
+
+   return stat;
+}
+
+/* Marks a cached fitsfile as just used, and as handed to one more caller. */
+static void TouchFile(fitsfile **pfptr)
+{
+   TASRW_FFile_t *ffile = (TASRW_FFile_t *)pfptr;
+
+   ffile->lastuse = ++gFFTick;
+   ffile->nusers++;
+   gFFHits++;
+}
+
+/* Releases a fitsfile that a tasrw function got from the cache for the duration of the call. The fitsfile
+ * stays open in the cache, and can be evicted once no caller holds it. */
+static void ReleaseFile(fitsfile *fptr)
+{
+   TASRW_FILE_PTR_INFO fpinfo;
+   TASRW_FFile_t *ffile = NULL;
+
+   if (fptr && gFFiles && !fitsrw_getfpinfo(fptr, &fpinfo))
+   {
+      ffile = (TASRW_FFile_t *)hcon_lookup(gFFiles, fpinfo.fhash);
+      if (ffile && ffile->fptr == fptr && ffile->nusers > 0)
+      {
+         ffile->nusers--;
+      }
+   }
+}
+
 /* fitsfiles can be opened either READWRITE or READONLY. If a request for a READONLY pointer
  * is made, and the fitsfile has already been opened, then regardless of the fitsfile write mode
  * it is okay to return the opened pointer. But, if the request is for a READWRITE pointer
@@ -120,6 +350,10 @@ static int fitsrw_setfpinfo(fitsfile *fptr, TASRW_FILE_PTR_INFO *info)
  * readwrite.
  *
  * fileCreated is set to 1 if fits_create_file() was called successfully.
+ *
+ * At most MAXFFILES - 1 fitsfiles are kept open; to make room for a new one, the least-recently used
+ * one that no caller holds is closed (a writeable one gets its image resized, if needed, and its checksum
+ * written first). If every cached fitsfile is held, the cache grows past MAXFFILES - 1 instead.
  */
 TASRW_FilePtr_t fitsrw_getfptr_internal(int verbose, const char *filename, int writeable, int verchksum, int *status, int *fileCreated)
 {
@@ -133,7 +367,6 @@ TASRW_FilePtr_t fitsrw_getfptr_internal(int verbose, const char *filename, int w
    int datachk;
    int hduchk;
    int newfile = 0;
-   char cfitsiostat[FLEN_STATUS];
    int exit_code = CFITSIO_SUCCESS;
 
    if (fileCreated)
@@ -143,7 +376,7 @@ TASRW_FilePtr_t fitsrw_getfptr_internal(int verbose, const char *filename, int w
 
    if (!gFFiles)
    {
-      gFFiles = hcon_create(sizeof(fitsfile *), sizeof(filehashkey), NULL, NULL, NULL, NULL, 0);
+      gFFiles = hcon_create(sizeof(TASRW_FFile_t), sizeof(filehashkey), NULL, NULL, NULL, NULL, 0);
    }
 
    if (!gFFPtrInfo)
@@ -164,6 +397,7 @@ TASRW_FilePtr_t fitsrw_getfptr_internal(int verbose, const char *filename, int w
     if (pfptr != NULL)
     {
         fptr = *pfptr;
+        TouchFile(pfptr);
     }
     else if (!writeable)
     {
@@ -179,11 +413,14 @@ TASRW_FilePtr_t fitsrw_getfptr_internal(int verbose, const char *filename, int w
         {
             /* caller requested readonly fitsfile, but the writeable one exists - just return that one */
             fptr = *pfptr;
+            TouchFile(pfptr);
         }
     }
 
     if (!fptr)
     {
+        gFFMisses++;
+
         if (writeable)
         {
             snprintf(tmpfilehashkey, sizeof(tmpfilehashkey), "%s:r", filename);
@@ -307,195 +544,25 @@ TASRW_FilePtr_t fitsrw_getfptr_internal(int verbose, const char *filename, int w
 
         exit_code = stat;
 
-        if (!stat && gFFiles->num_total >= MAXFFILES - 1)
+        if (!stat)
         {
-            /* Must close some open files */
-            int ifile = 0;
-            HIterator_t *hit = hiter_create(gFFiles);
-            LinkedList_t *llist = list_llcreate(sizeof(char *), NULL);
-            const char *fhkey = NULL;
-            ListNode_t *node = NULL;
-            char *onefile = NULL;
-            TASRW_FILE_PTR_INFO finfo;
+            /* Make room for the new fitsfile by closing the least-recently used ones. */
+            int evicted = 1;
 
-            if (hit)
+            while (gFFiles->num_total >= MAXFFILES - 1 && evicted)
             {
-                while (ifile < MAXFFILES / 2)
+                stat = EvictLRUFile(verbose, &evicted);
+                if (stat)
                 {
-                    stat = 0; /* keep on purging files, even if we fail on one; report the first error encountered */
-                    pfptr = (fitsfile **)hiter_extgetnext(hit, &fhkey);
-
-                    if (pfptr)
-                    {
-                        if (*pfptr)
-                        {
-                            if (IsWriteable(fhkey))
-                            {
-                                /* Before removing the file info, get the dirty flag value and the value of NAXISn. */
-                                stat = fitsrw_getfpinfo(*pfptr, &finfo);
-
-                                if (stat)
-                                {
-                                    /* we need info in gFFPtrInfo so we can resize the image */
-                                    fprintf(stderr, "missing file info for fits file '%s'\n", fhkey);
-                                    stat = CFITSIO_ERROR_CANT_GET_FILEINFO;
-                                }
-                                else
-                                {
-                                    /* file is present in both gFFiles and gFFPtrInfo */
-                                    if (finfo.bitfield & kInfoPresent_Dirt)
-                                    {
-                                        /* If this is a writable fits file AND the dirty flag is set (which means that
-                                        * since the file was first created, the NAXISn length has changed due to
-                                        * slice writing), then update the NAXISn keyword value before closing the
-                                        * fits file. */
-
-                                        /* It is not sufficient to simply change the NAXISn keyword value. Although this WILL
-                                        * make FITSIO think the image is smaller, the actual image data does not get removed
-                                        * from the FITS file. So, we ALSO have to call fits_resize_imgll().
-                                        */
-                                        int dimlen;
-                                        int imgType;
-                                        long long *axes = NULL;
-                                        int iaxis;
-
-                                        axes = calloc(finfo.naxis, sizeof(long long));
-
-                                        if (!axes)
-                                        {
-                                            stat = CFITSIO_ERROR_OUT_OF_MEMORY;
-                                        }
-                                        else
-                                        {
-                                            for (iaxis = 0; iaxis < finfo.naxis; iaxis++)
-                                            {
-                                                axes[iaxis] = finfo.naxes[iaxis];
-                                            }
-
-                                            switch(finfo.bitpix)
-                                            {
-                                                case(BYTE_IMG): imgType = SBYTE_IMG; break;
-                                                case(SHORT_IMG): imgType = SHORT_IMG; break;
-                                                case(LONG_IMG): imgType = LONG_IMG; break;
-                                                case(LONGLONG_IMG): imgType = LONGLONG_IMG; break;
-                                                case(FLOAT_IMG): imgType = FLOAT_IMG; break;
-                                                case(DOUBLE_IMG): imgType = DOUBLE_IMG; break;
-                                            }
-
-                                            fiostat = 0;
-                                            fits_resize_imgll(*pfptr, imgType, finfo.naxis, axes, &fiostat);
-
-                                            if (fiostat)
-                                            {
-                                                fprintf(stderr, "FITSIO error: %d\n", fiostat);
-                                                fprintf(stderr, "unable to resize image in fits file %s\n", filename);
-                                                stat = CFITSIO_ERROR_LIBRARY;
-                                            }
-
-                                            /* no need to manually modify NAXISn (the value of the slice dimension);
-                                            * fits_resize_imgll() does this
-                                            */
-
-                                            free(axes);
-                                            axes = NULL;
-                                        }
-                                    }
-                                }
-
-                                if (!stat)
-                                {
-                                    /* we are closing a file, so write its checksum */
-                                    if (verbose)
-                                    {
-                                        PushTimer();
-                                    }
-
-                                    fiostat = 0;
-                                    fits_write_chksum(*pfptr, &fiostat);
-
-                                    if (fiostat)
-                                    {
-                                        fits_get_errstatus(fiostat, cfitsiostat);
-                                        fprintf(stderr, "Purging cache: error calculating and writing checksum for fitsfile '%s'.\n", fhkey);
-                                        fprintf(stderr, "CFITSIO error '%s'\n", cfitsiostat);
-                                        stat = CFITSIO_ERROR_LIBRARY;
-                                    }
-
-                                    if (verbose)
-                                    {
-                                        fprintf(stdout, "Time to write checksum on fitsfile '%s' = %f sec.\n", fhkey, PopTimer());
-                                    }
-                                }
-                            }
-
-                            /* remove fileptr from gFFPtrInfo; this needs to be done regardless of write-status  */
-                            snprintf(fileinfokey, sizeof(fileinfokey), "%p", (void *)*pfptr);
-                            hcon_remove(gFFPtrInfo, fileinfokey);
-
-                            if (verbose)
-                            {
-                                PushTimer();
-                            }
-
-                            fiostat = 0;
-                            fits_close_file(*pfptr, &fiostat);
-
-                            if (fiostat == 0)
-                            {
-                                if (verbose)
-                                {
-                                    fprintf(stderr, "Closing fits file '%s'.\n", fhkey);
-                                }
-                            }
-                            else
-                            {
-                                fits_get_errstatus(fiostat, cfitsiostat);
-                                fprintf(stderr, "Purging cache: error closing fitsfile '%s'.\n", fhkey);
-                                fprintf(stderr, "CFITSIO error '%s'\n", cfitsiostat);
-                                perror("fitsrw_getfptr_internal() system error");
-
-                                if (!stat)
-                                {
-                                    stat = CFITSIO_ERROR_FILE_IO;
-                                }
-                            }
-
-                            if (verbose)
-                            {
-                                fprintf(stdout, "Time to close fitsfile '%s' = %f sec.\n", fhkey, PopTimer());
-                            }
-                        }
-
-                        /* Save the filehashkey for each file being removed from the cache -
-                        * must remove from gFFiles AFTER exiting the loop that is iterating
-                        * over gFFiles. */
-                        list_llinserttail(llist, (void *)&fhkey);
-                        ifile++;
-                    }
-                    else
-                    {
-                        break;
-                    }
-
-                    if (stat && exit_code == CFITSIO_SUCCESS)
-                    {
-                        exit_code = stat;
-                    }
-
-                } /* loop over files being purged */
-
-                hiter_destroy(&hit);
-            }
+                    exit_code = stat;
+                    break;
+                }
 
-            /* free all the file pointers saved in gFFiles */
-            list_llreset(llist);
-            while ((node = list_llnext(llist)) != NULL)
-            {
-                onefile = *((char **)node->data);
-                hcon_remove(gFFiles, onefile);
+                if (!evicted && verbose)
+                {
+                    fprintf(stdout, "All %d cached fitsfiles are in use; not closing any.\n", gFFiles->num_total);
+                }
             }
-
-            list_llfree(&llist);
         }
 
         if (!exit_code)
@@ -529,7 +596,12 @@ TASRW_FilePtr_t fitsrw_getfptr_internal(int verbose, const char *filename, int w
                 snprintf(imginfo->fhash, sizeof(imginfo->fhash), "%s", filehashkey);
                 hcon_insert(gFFPtrInfo, fileinfokey, imginfo);
 
-                hcon_insert(gFFiles, filehashkey, &fptr);
+                TASRW_FFile_t ffile;
+
+                ffile.fptr = fptr;
+                ffile.lastuse = ++gFFTick;
+                ffile.nusers = 1;
+                hcon_insert(gFFiles, filehashkey, &ffile);
             }
 
             if (imginfo)
@@ -786,6 +858,9 @@ int fitsrw_readslice(int verbose, const char *filename, int *fpixel, int *lpixel
         pixels = NULL;
     }
 
+   /* done with the fitsfile - leave it open in the cache */
+   ReleaseFile(fptr);
+
    return CFITSIO_SUCCESS;
 
   error_exit:
@@ -798,7 +873,8 @@ int fitsrw_readslice(int verbose, const char *filename, int *fpixel, int *lpixel
 
    if (fptr)
    {
-      /* Must call fitsrw_closefptr() to free the readonly fitsfile */
+      /* Must call fitsrw_closefptr() to free the readonly fitsfile; it closes the fitsfile only if no other
+       * caller holds it, and otherwise releases this call's hold */
        /* There was some other error, so don't worry about failures having to do with closing the file. */
       fitsrw_closefptr(verbose, (TASRW_FilePtr_t)fptr);
    }
@@ -1023,6 +1099,9 @@ int fitsrw_writeslice(int verbose, const char *filename, int *fpixel, int *lpixe
    fprintf(stdout, "Time to write subset: %f\n", StopTimer(26));
 #endif
 
+   /* done with the fitsfile - leave it open in the cache */
+   ReleaseFile(fptr);
+
    return CFITSIO_SUCCESS;
 
  error_exit:
@@ -1045,15 +1124,12 @@ int fitsrw_writeslice(int verbose, const char *filename, int *fpixel, int *lpixe
 
 int fitsrw_closefptr(int verbose, TASRW_FilePtr_t fptr)
 {
-    char fileinfokey[64];
-    int fiostat = 0; /* fitsio status */
     TASRW_FILE_PTR_INFO fpinfo;
-    char cfitsiostat[FLEN_STATUS];
     int error_code = CFITSIO_SUCCESS;
 
     if (fptr)
     {
-        /* Before removing the file info, get the dirty flag value and the value of NAXISn. */
+        /* get the fitsfile's cache key */
         if (fitsrw_getfpinfo((fitsfile *)fptr, &fpinfo))
         {
             fprintf(stderr, "Invalid fitsfile pointer '%p'.\n", fptr);
@@ -1061,130 +1137,17 @@ int fitsrw_closefptr(int verbose, TASRW_FilePtr_t fptr)
         }
         else if (gFFiles)
         {
-            if (hcon_lookup(gFFiles, fpinfo.fhash))
-            {
-                snprintf(fileinfokey, sizeof(fileinfokey), "%p", (void *)fptr);
-                hcon_remove(gFFPtrInfo, fileinfokey);
-
-                if (IsWriteable(fpinfo.fhash))
-                {
-                    if (fpinfo.bitfield & kInfoPresent_Dirt)
-                    {
-                        /* If this is a writable fits file AND the dirty flag is set (which means that
-                         * since the file was first created, the NAXISn length has changed due to
-                         * slice writing), then update the NAXISn keyword value before closing the
-                         * fits file. */
-
-                        /* It is not sufficient to simply change the NAXISn keyword value. Although this WILL
-                         * make FITSIO think the image is smaller, the actual image data does not get removed
-                         * from the FITS file. So, we ALSO have to call fits_resize_imgll().
-                         */
-                        int dimlen;
-                        int imgType;
-                        long long *axes = NULL;
-                        int iaxis;
-
-                        axes = calloc(fpinfo.naxis, sizeof(long long));
-
-                        if (!axes)
-                        {
-                            error_code = CFITSIO_ERROR_OUT_OF_MEMORY;
-                        }
-                        else
-                        {
-                            for (iaxis = 0; iaxis < fpinfo.naxis; iaxis++)
-                            {
-                                axes[iaxis] = fpinfo.naxes[iaxis];
-                            }
-
-                            switch(fpinfo.bitpix)
-                            {
-                                case(BYTE_IMG): imgType = SBYTE_IMG; break;
-                                case(SHORT_IMG): imgType = SHORT_IMG; break;
-                                case(LONG_IMG): imgType = LONG_IMG; break;
-                                case(LONGLONG_IMG): imgType = LONGLONG_IMG; break;
-                                case(FLOAT_IMG): imgType = FLOAT_IMG; break;
-                                case(DOUBLE_IMG): imgType = DOUBLE_IMG; break;
-                            }
-
-                            fiostat = 0;
-                            fits_resize_imgll((fitsfile *)fptr, imgType, fpinfo.naxis, axes, &fiostat);
-
-                            if (fiostat)
-                            {
-                                fprintf(stderr, "FITSIO error: %d\n", fiostat);
-                                fprintf(stderr, "unable to resize image in fits file\n");
-                                error_code = CFITSIO_ERROR_LIBRARY;
-                            }
-
-                            /* no need to manually modify NAXISn (the value of the slice dimension);
-                             * fits_resize_imgll() does this
-                             */
-
-                            free(axes);
-                            axes = NULL;
-                         }
-                    }
-
-                    if (!error_code)
-                    {
-                        if (verbose)
-                        {
-                            PushTimer();
-                        }
-
-                        fiostat = 0;
-                        fits_write_chksum((fitsfile *)fptr, &fiostat);
-
-                        if (fiostat)
-                        {
-                            fits_get_errstatus(fiostat, cfitsiostat);
-                            fprintf(stderr, "Closing fitsfile: error calculating and writing checksum for fitsfile '%s'.\n", fpinfo.fhash);
-                            fprintf(stderr, "CFITSIO error '%s'\n", cfitsiostat);
-                            fits_report_error(stderr, fiostat);
-                            error_code = CFITSIO_ERROR_LIBRARY;
-                        }
-
-                        if (verbose)
-                        {
-                            fprintf(stdout, "Time to write checksum on fitsfile '%s' = %f sec.\n", fpinfo.fhash, PopTimer());
-                        }
-                    }
-                }
-
-                if (verbose)
-                {
-                    PushTimer();
-                }
-
-                fiostat = 0;
-                fits_close_file((fitsfile *)fptr, &fiostat);
-
-                if (fiostat == 0)
-                {
-                    if (verbose)
-                    {
-                        fprintf(stdout, "Closing fits file '%s'.\n",  fpinfo.fhash);
-                    }
-                }
-                else
-                {
-                    fits_get_errstatus(fiostat, cfitsiostat);
-                    fprintf(stderr, "Closing fitsfile: error closing fitsfile '%s'.\n", fpinfo.fhash);
-                    fprintf(stderr, "CFITSIO error '%s'\n", cfitsiostat);
-                    perror("fitsrw_closefptr() system error");
-
-                    if (!error_code)
-                    {
-                        error_code = CFITSIO_ERROR_FILE_IO;
-                    }
-                }
-
-                if (verbose)
-                {
-                    fprintf(stdout, "Time to close fitsfile '%s' = %f sec.\n", fpinfo.fhash, PopTimer());
-                }
+            TASRW_FFile_t *ffile = (TASRW_FFile_t *)hcon_lookup(gFFiles, fpinfo.fhash);
 
+            if (ffile && !IsWriteable(fpinfo.fhash) && ffile->nusers > 1)
+            {
+                /* other callers still use this read-only fitsfile - leave it open */
+                ffile->nusers--;
+            }
+            else if (ffile)
+            {
+                /* fpinfo is a copy, so fpinfo.fhash outlives the removal of the fitsfile's info */
+                error_code = CloseCachedFile(verbose, fpinfo.fhash, (fitsfile *)fptr);
                 hcon_remove(gFFiles, fpinfo.fhash);
             }
             else
@@ -1240,12 +1203,8 @@ int fitsrw_closefptrs(int verbose)
             HIterator_t *hit = NULL;
             fitsfile **pfptr = NULL;
             int stat = 0; /* fitsrw error code. */
-            int fiostat = 0; /* fitsio error code. */
             const char *filehashkey = NULL;
-            char fileinfokey[64];
             int ifile;
-            char cfitsiostat[FLEN_STATUS];
-            TASRW_FILE_PTR_INFO fpinfo;
             LinkedList_t *llist = NULL;
             ListNode_t *node = NULL;
             char *onefile = NULL;
@@ -1290,141 +1249,9 @@ int fitsrw_closefptrs(int verbose)
 
                     if (pfptr && *pfptr)
                     {
-                        /* remove fileptr info structure */
-                        snprintf(fileinfokey, sizeof(fileinfokey), "%p", (void *)*pfptr);
-
-                        hcon_remove(gFFPtrInfo, fileinfokey);
-
-                        if (IsWriteable(onefile))
-                        {
-                            /* Before removing the file info, get the dirty flag value and the value of NAXISn. */
-
-                            /* it is OK to overwrite stat from previous iterations; the previous iteration
-                             * stat value was saved in exit_code */
-                            stat = fitsrw_getfpinfo(*pfptr, &fpinfo);
-
-                            if (stat)
-                            {
-                                fprintf(stderr, "Missing file info for fits file '%s'.\n", onefile);
-                                /* keep going - we just skip the removal of the file info from the global container */
-                            }
-                            else
-                            {
-                                if (fpinfo.bitfield & kInfoPresent_Dirt)
-                                {
-                                    /* If this is a writable fits file AND the dirty flag is set (which means that
-                                     * since the file was first created, the NAXISn length has changed due to
-                                     * slice writing), then update the NAXISn keyword value before closing the
-                                     * fits file. */
-
-                                    /* It is not sufficient to simply change the NAXISn keyword value. Although this WILL
-                                     * make FITSIO think the image is smaller, the actual image data does not get removed
-                                     * from the FITS file. So, we ALSO have to call fits_resize_imgll().
-                                     */
-                                    int dimlen;
-                                    int imgType;
-                                    long long *axes = NULL;
-                                    int iaxis;
-
-                                    axes = calloc(fpinfo.naxis, sizeof(long long));
-
-                                    if (!axes)
-                                    {
-                                        stat = CFITSIO_ERROR_OUT_OF_MEMORY;
-                                    }
-                                    else
-                                    {
-                                        for (iaxis = 0; iaxis < fpinfo.naxis; iaxis++)
-                                        {
-                                            axes[iaxis] = fpinfo.naxes[iaxis];
-                                        }
-
-                                        switch(fpinfo.bitpix)
-                                        {
-                                            case(BYTE_IMG): imgType = SBYTE_IMG; break;
-                                            case(SHORT_IMG): imgType = SHORT_IMG; break;
-                                            case(LONG_IMG): imgType = LONG_IMG; break;
-                                            case(LONGLONG_IMG): imgType = LONGLONG_IMG; break;
-                                            case(FLOAT_IMG): imgType = FLOAT_IMG; break;
-                                            case(DOUBLE_IMG): imgType = DOUBLE_IMG; break;
-                                        }
-
-                                        fiostat = 0;
-                                        fits_resize_imgll(*pfptr, imgType, fpinfo.naxis, axes, &fiostat);
-
-                                        if (fiostat)
-                                        {
-                                            fprintf(stderr, "FITSIO error: %d.\n", fiostat);
-                                            fprintf(stderr, "unable to resize image in fits file\n");
-                                            stat = CFITSIO_ERROR_LIBRARY;
-                                        }
-
-                                        /* no need to manually modify NAXISn (the value of the slice dimension);
-                                         * fits_resize_imgll() does this
-                                         */
-
-                                        free(axes);
-                                        axes = NULL;
-                                     }
-                                }
-                            }
-
-                            if (!stat)
-                            {
-                                if (verbose)
-                                {
-                                    PushTimer();
-                                }
-
-                                fiostat = 0;
-                                fits_write_chksum(*pfptr, &fiostat);
-
-                                if (fiostat)
-                                {
-                                    fits_get_errstatus(fiostat, cfitsiostat);
-                                    fprintf(stderr, "Closing all fitsfiles: error calculating and writing checksum for fitsfile '%s'.\n", onefile);
-                                    fprintf(stderr, "CFITSIO error '%s'\n", cfitsiostat);
-                                    stat = CFITSIO_ERROR_LIBRARY;
-                                }
-
-                                if (verbose)
-                                {
-                                    fprintf(stdout, "Time to write checksum on fitsfile '%s' = %f sec.\n", onefile, PopTimer());
-                                }
-                            }
-                        }
-
-                        if (verbose)
-                        {
-                            PushTimer();
-                        }
-
-                        fiostat = 0;
-                        fits_close_file(*pfptr, &fiostat);
-
-                        if (fiostat == 0)
-                        {
-                            if (verbose)
-                            {
-                                fprintf(stdout, "Closing fits file '%s'.\n", onefile);
-                            }
-                        }
-                        else
-                        {
-                            fits_get_errstatus(fiostat, cfitsiostat);
-                            fprintf(stderr, "Closing all fitsfiles: error closing fitsfile '%s'.\n", onefile);
-                            fprintf(stderr, "CFITSIO error '%s'\n", cfitsiostat);
-                            perror("fitsrw_closefptrs() system error");
-                            if (!stat)
-                            {
-                                stat = CFITSIO_ERROR_FILE_IO;
-                            }
-                        }
-
-                        if (verbose)
-                        {
-                            fprintf(stdout, "Time to close fitsfile '%s' = %f sec.\n", onefile, PopTimer());
-                        }
+                        /* it is OK to overwrite stat from previous iterations; the previous iteration
+                         * stat value was saved in exit_code */
+                        stat = CloseCachedFile(verbose, onefile, *pfptr);
                     }
                     else
                     {   if (!stat)
@@ -1456,6 +1283,11 @@ int fitsrw_closefptrs(int verbose)
             }
         }
 
+        if (verbose)
+        {
+            fprintf(stdout, "fitsfile cache: %lld hits, %lld misses, %lld evictions.\n", gFFHits, gFFMisses, gFFEvictions);
+        }
+
         hcon_destroy(&gFFPtrInfo);
         hcon_destroy(&gFFiles);
     }
@@ -1463,6 +1295,24 @@ int fitsrw_closefptrs(int verbose)
     return exit_code;
 }
 
+void fitsrw_getcachestats(long long *hits, long long *misses, long long *evictions)
+{
+    if (hits)
+    {
+        *hits = gFFHits;
+    }
+
+    if (misses)
+    {
+        *misses = gFFMisses;
+    }
+
+    if (evictions)
+    {
+        *evictions = gFFEvictions;
+    }
+}
+
 int fitsrw_getfpinfo_ext(TASRW_FilePtr_t fptr, TASRW_FilePtrInfo_t info)
 {
    return fitsrw_getfpinfo((fitsfile *)fptr, (TASRW_FILE_PTR_INFO *)info);
@@ -1530,6 +1380,8 @@ int fitsrw_initializeTAS(int verbose, const char *filename)
                 fitsrwErr = CFITSIO_ERROR_FILE_IO;
             }
         }
+
+        ReleaseFile(fptr);
     }
 
     return fitsrwErr;
@@ -34,6 +34,10 @@ TASRW_FilePtr_t fitsrw_getfptr_nochksum(int verbose, const char *filename, int w
 int fitsrw_closefptr(int verbose, TASRW_FilePtr_t fptr);
 int fitsrw_closefptrByName(int verbose, const char *filename);
 int fitsrw_closefptrs(int verbose);
+/* Open fitsfiles are cached (at most MAXFFILES, in tasrw.c); when the cache is full, the least-recently used one is closed.
+ * These are the numbers of fitsrw_getfptr() calls that found their file in the cache (hits) and that had to open
+ * it (misses), and of fitsfiles closed to make room (evictions). */
+void fitsrw_getcachestats(long long *hits, long long *misses, long long *evictions);
 int fitsrw_getfpinfo_ext(TASRW_FilePtr_t fptr, TASRW_FilePtrInfo_t info);
 int fitsrw_setfpinfo_ext(TASRW_FilePtr_t fptr, TASRW_FilePtrInfo_t info);
 int fitsrw_iscompressed(const char *cparms);
@@ -0,0 +1,152 @@
+/* Contention benchmark for the tagged FIFO. It mimics drms_server: nclients threads each send
+ * a request to an inbox (tagged with pthread_self()) and wait for the reply in an outbox; one server
+ * thread takes requests from the inbox with tqueueDelAny(), and replies to a batch of them in
+ * reverse order, so that most replies are not for the thread at the head of the outbox. It reports
+ * round trips per second and the CPU time used per round trip (waiting clients should use none).
+ *
+ * usage: benchtagfifo [nrounds] [maxclients]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "tagfifo.h"
+
+#define QSIZE 100
+#define BATCH 16
+
+typedef struct
+{
+   tqueue_t *inbox;
+   tqueue_t *outbox;
+   int nrounds;
+   long errors;
+} Bench_t;
+
+static double Now(void)
+{
+   struct timeval tv;
+
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + tv.tv_usec / 1.0e6;
+}
+
+static double CPUTime(void)
+{
+   struct rusage ru;
+
+   getrusage(RUSAGE_SELF, &ru);
+   return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1.0e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1.0e6;
+}
+
+static void *Client(void *data)
+{
+   Bench_t *bench = (Bench_t *)data;
+   long self = (long)pthread_self();
+   long request;
+   char *reply = NULL;
+   int iround;
+
+   for (iround = 0; iround < bench->nrounds; iround++)
+   {
+      request = self ^ iround;
+      tqueueAdd(bench->inbox, self, (char *)request);
+      tqueueDel(bench->outbox, self, &reply);
+
+      if ((long)reply != request)
+      {
+         /* another thread's reply - the mailbox is broken */
+         __sync_fetch_and_add(&bench->errors, 1);
+      }
+   }
+
+   return NULL;
+}
+
+static void Serve(Bench_t *bench, long nrequests)
+{
+   long tags[BATCH];
+   char *bufs[BATCH];
+   int nbatch;
+   int ibatch;
+   int drained;
+
+   while (nrequests > 0)
+   {
+      /* Wait for a request, then take (up to BATCH of) the others that have arrived. The cork makes
+       * tqueueDelAny() report when the inbox has been drained. */
+      nbatch = 0;
+      tqueueDelAny(bench->inbox, &tags[nbatch], &bufs[nbatch]);
+      nbatch++;
+
+      drained = tqueueCork(bench->inbox);
+      while (!drained && nbatch < BATCH)
+      {
+         drained = tqueueDelAny(bench->inbox, &tags[nbatch], &bufs[nbatch]);
+         nbatch++;
+      }
+
+      /* reply newest first */
+      for (ibatch = nbatch - 1; ibatch >= 0; ibatch--)
+      {
+         tqueueAdd(bench->outbox, tags[ibatch], bufs[ibatch]);
+      }
+
+      nrequests -= nbatch;
+   }
+}
+
+static void Run(int nclients, int nrounds)
+{
+   Bench_t bench;
+   pthread_t *clients = malloc(nclients * sizeof(pthread_t));
+   double wall;
+   double cpu;
+   int iclient;
+
+   bench.inbox = tqueueInit(QSIZE);
+   bench.outbox = tqueueInit(QSIZE);
+   bench.nrounds = nrounds;
+   bench.errors = 0;
+
+   wall = Now();
+   cpu = CPUTime();
+
+   for (iclient = 0; iclient < nclients; iclient++)
+   {
+      pthread_create(&clients[iclient], NULL, Client, &bench);
+   }
+
+   Serve(&bench, (long)nclients * nrounds);
+
+   for (iclient = 0; iclient < nclients; iclient++)
+   {
+      pthread_join(clients[iclient], NULL);
+   }
+
+   wall = Now() - wall;
+   cpu = CPUTime() - cpu;
+
+   printf("%8d %12.0f %14.2f %8ld\n", nclients, (double)nclients * nrounds / wall, cpu / ((double)nclients * nrounds) * 1.0e6, bench.errors);
+
+   tqueueDelete(bench.inbox);
+   tqueueDelete(bench.outbox);
+   free(clients);
+}
+
+int main(int argc, char *argv[])
+{
+   int nrounds = argc > 1 ? atoi(argv[1]) : 2000;
+   int maxclients = argc > 2 ? atoi(argv[2]) : 256;
+   int nclients;
+
+   printf("%8s %12s %14s %8s\n", "clients", "roundtrips/s", "cpu us/rtrip", "errors");
+
+   for (nclients = 1; nclients <= maxclients; nclients *= 4)
+   {
+      Run(nclients, nrounds);
+   }
+
+   return 0;
+}
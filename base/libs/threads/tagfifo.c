@@ -1,117 +1,387 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
 #include "tagfifo.h"
-#include "fifo.h"
 
-typedef struct {
-  long tag;
-  char *buf;
-} tagitem_t;
+/***************************************************************************
+ tqueueXXXX: A FIFO queue of tagged items. Each tag has a mailbox - the list
+ of queued items with that tag, plus a condition variable that threads
+ waiting for that tag sleep on - so tqueueAdd() wakes only a thread waiting
+ for the new item's tag, and tqueueDel() never has to look at (or wait
+ behind) items for other tags. The items live in an array allocated by
+ tqueueInit(); mailboxes are recycled through a free list.
+**************************************************************************/
 
 #define TRY(__try__,__catch__) if ((status = (__try__))) { \
  fprintf(stderr,"Error at %s, line %d: '"#__try__"' failed with status = %d\n", \
   __FILE__, __LINE__,status); \
     __catch__; \
-} 
+}
+
+#define NIL (-1)
+#define NBUCKETS_LOG2 (8)
+
+typedef struct {
+  long tag;
+  char *buf;
+  int prev, next;  /* queue order (free items: next is the free list) */
+  int tnext;       /* queue order of the items with the same tag */
+} tagitem_t;
+
+typedef struct tagbox_struct {
+  long tag;
+  int head, tail;      /* items with this tag */
+  int nwaiting;        /* threads sleeping in tqueueDel() for this tag */
+  pthread_cond_t ready;
+  struct tagbox_struct *next; /* hash chain (or free list) */
+} tagbox_t;
+
+struct tqueue_struct {
+  pthread_mutex_t mut;
+  pthread_cond_t notFull, notEmpty;
+  tagitem_t *items;
+  int qsize;
+  int count;
+  int head, tail;      /* queue order */
+  int freeitem;
+  int flush;           /* corked - see tqueueCork() */
+  tagbox_t *boxes[1 << NBUCKETS_LOG2];
+  tagbox_t *freebox;
+};
+
+static unsigned int TagHash(long tag)
+{
+  return (unsigned int)(((unsigned long long)tag * 0x9E3779B97F4A7C15ULL) >> (64 - NBUCKETS_LOG2));
+}
+
+/* Returns the mailbox for tag, creating one if create != 0. */
+static tagbox_t *TagBox(tqueue_t *q, long tag, int create)
+{
+  tagbox_t *box;
+  unsigned int bucket = TagHash(tag);
+
+  for (box = q->boxes[bucket]; box; box = box->next)
+  {
+    if (box->tag == tag)
+      return box;
+  }
+
+  if (!create)
+    return NULL;
+
+  if (q->freebox)
+  {
+    box = q->freebox;
+    q->freebox = box->next;
+  }
+  else
+  {
+    box = (tagbox_t *)malloc(sizeof(tagbox_t));
+    if (!box || pthread_cond_init(&box->ready, NULL))
+    {
+      free(box);
+      return NULL;
+    }
+  }
+
+  box->tag = tag;
+  box->head = box->tail = NIL;
+  box->nwaiting = 0;
+  box->next = q->boxes[bucket];
+  q->boxes[bucket] = box;
+  return box;
+}
+
+/* Moves box to the free list if it holds no items and no thread waits on it. */
+static void TagBoxRelease(tqueue_t *q, tagbox_t *box)
+{
+  tagbox_t **pbox;
+
+  if (box->head != NIL || box->nwaiting > 0)
+    return;
+
+  for (pbox = &q->boxes[TagHash(box->tag)]; *pbox; pbox = &(*pbox)->next)
+  {
+    if (*pbox == box)
+    {
+      *pbox = box->next;
+      break;
+    }
+  }
+
+  box->next = q->freebox;
+  q->freebox = box;
+}
+
+/* Removes the oldest item of box (which must not be empty) from the queue. Returns 1 if
+   this emptied a corked queue (and uncorked it). */
+static int TakeItem(tqueue_t *q, tagbox_t *box, char **out)
+{
+  int iitem = box->head;
+  tagitem_t *item = &q->items[iitem];
 
+  *out = item->buf;
+
+  box->head = item->tnext;
+  if (box->head == NIL)
+    box->tail = NIL;
+
+  if (item->prev != NIL)
+    q->items[item->prev].next = item->next;
+  else
+    q->head = item->next;
+  if (item->next != NIL)
+    q->items[item->next].prev = item->prev;
+  else
+    q->tail = item->prev;
+
+  item->buf = NULL;
+  item->next = q->freeitem;
+  q->freeitem = iitem;
+  q->count--;
+
+  TagBoxRelease(q, box);
+
+  /* Signal the producer(s) to wake up. */
+  pthread_cond_signal(&q->notFull);
+
+  if (q->flush && q->count == 0)
+  {
+    q->flush = 0;
+    return 1;
+  }
+
+  return 0;
+}
+
+/* Initialize a new queue with capacity qsize. */
 tqueue_t *tqueueInit(int qsize)
 {
-  return (tqueue_t *) queueInit(qsize);
+  tqueue_t *q;
+  int i;
+
+  q = (tqueue_t *)calloc(1, sizeof(tqueue_t));
+  if (q == NULL) return (NULL);
+  q->items = (tagitem_t *)malloc(qsize * sizeof(tagitem_t));
+  if (q->items == NULL)
+  {
+    free(q);
+    return NULL;
+  }
+
+  q->qsize = qsize;
+  q->head = q->tail = NIL;
+  for (i = 0; i < qsize; i++)
+    q->items[i].next = (i + 1 < qsize) ? i + 1 : NIL;
+  q->freeitem = qsize > 0 ? 0 : NIL;
+
+  if (pthread_mutex_init(&q->mut, NULL) ||
+      pthread_cond_init(&q->notFull, NULL) ||
+      pthread_cond_init(&q->notEmpty, NULL))
+  {
+    fprintf(stderr, "Error at %s, line %d: unable to initialize the queue's mutex or condition variables.\n", __FILE__, __LINE__);
+    free(q->items);
+    free(q);
+    return NULL;
+  }
+
+  return q;
 }
 
+/* Put a cork in to the queue to start flush: the tqueueDel*() call that empties
+   the queue returns 1 and removes the cork. The queue still accepts inserts -
+   producers may hold locks that whoever drains the queue needs, so they must not
+   block on the cork - and items added while it is corked are drained too.
+   Returns 1 if the queue is empty. */
 int tqueueCork(tqueue_t *q)
 {
-  return queueCork((queue_t *) q);
+  int empty;
+  int status;
+  TRY( pthread_mutex_lock (&q->mut), return status);
+  if (q->count == 0)
+    empty = 1;
+  else
+  {
+    q->flush = 1;
+    empty = 0;
+  }
+  TRY( pthread_mutex_unlock (&q->mut), return status);
+  return empty;
 }
 
+/* Destroy a queue and free memory allocated for it. */
 int tqueueDelete(tqueue_t *q)
 {
-  return queueDelete(q);
+  int status = 0;
+  int bucket;
+  tagbox_t *box;
+
+  for (bucket = 0; bucket < (1 << NBUCKETS_LOG2); bucket++)
+  {
+    while ((box = q->boxes[bucket]) != NULL)
+    {
+      q->boxes[bucket] = box->next;
+      pthread_cond_destroy(&box->ready);
+      free(box);
+    }
+  }
+
+  while ((box = q->freebox) != NULL)
+  {
+    q->freebox = box->next;
+    pthread_cond_destroy(&box->ready);
+    free(box);
+  }
+
+  TRY( pthread_mutex_destroy(&q->mut), return status);
+  TRY( pthread_cond_destroy(&q->notFull), return status);
+  TRY( pthread_cond_destroy(&q->notEmpty), return status);
+  free(q->items);
+  free(q);
+  return 0;
 }
 
+/* Add a new item to the tail of the queue. */
 int tqueueAdd(tqueue_t *q, long tag, char *in)
 {
   int status = 0;
+  int iitem;
   tagitem_t *item;
-  item = malloc(sizeof(tagitem_t));
+  tagbox_t *box;
+
+  /* Wait for room in the queue (but not for a cork to be removed - see tqueueCork()). */
+  TRY( pthread_mutex_lock (&q->mut), return status);
+  while (q->freeitem == NIL)
+    TRY( pthread_cond_wait (&q->notFull, &q->mut), pthread_mutex_unlock(&q->mut); return status);
+
+  box = TagBox(q, tag, 1);
+  if (!box)
+  {
+    pthread_mutex_unlock(&q->mut);
+    fprintf(stderr, "Error at %s, line %d: out of memory.\n", __FILE__, __LINE__);
+    return ENOMEM;
+  }
+
+  /* Add the new item to the queue, and to its tag's mailbox. */
+  iitem = q->freeitem;
+  item = &q->items[iitem];
+  q->freeitem = item->next;
+
   item->tag = tag;
   item->buf = in;
+  item->next = NIL;
+  item->prev = q->tail;
+  item->tnext = NIL;
+  if (q->tail != NIL)
+    q->items[q->tail].next = iitem;
+  else
+    q->head = iitem;
+  q->tail = iitem;
+  q->count++;
+
+  if (box->tail != NIL)
+    q->items[box->tail].tnext = iitem;
+  else
+    box->head = iitem;
+  box->tail = iitem;
+
+  /* Wake a thread waiting for this tag, and a consumer waiting for any tag. */
+  if (box->nwaiting > 0)
+    pthread_cond_signal(&box->ready);
+  pthread_cond_signal(&q->notEmpty);
 
-  /* Wait for room in the queue. */
-  TRY( pthread_mutex_lock (q->mut), return status);
-  while (q->full)
-    TRY( pthread_cond_wait (q->notFull, q->mut), return status);
-
-  /* Add the new item to the queue. */
-  q->buf[q->tail] = (char *)item;
-  q->tail++;
-  if (q->tail == q->qsize)
-    q->tail = 0;
-  if (q->tail == q->head)
-    q->full = 1;
-  q->empty = 0;
-  
-  /* Unlock and signal the consumer(s) to wake up. */
-  TRY( pthread_mutex_unlock (q->mut), return status);
-  status = pthread_cond_broadcast (q->notEmpty);
-  return status;  
+  TRY( pthread_mutex_unlock (&q->mut), return status);
+  return status;
 }
 
-int tqueueDel(tqueue_t *q, long tag, char **out)
+/* Remove the oldest item with the given tag, waiting at most msecs milliseconds
+   (forever if msecs < 0) for one to arrive. */
+static int DelTagged(tqueue_t *q, long tag, char **out, int msecs)
 {
   int status = 0;
-  int stop;
-  tagitem_t *item;
+  int waitstat = 0;
+  tagbox_t *box;
+  struct timespec abstime;
 
-  stop = 0;
-  while (!stop)
+  if (msecs >= 0)
   {
-    /* Wait for something to be put into the queue. */
-    TRY( pthread_mutex_lock (q->mut), return status);
-    while (q->empty) 
-      TRY( pthread_cond_wait (q->notEmpty, q->mut), return status);
-
-    item = (tagitem_t *) q->buf[q->head];
-    if (item->tag == tag)
+    clock_gettime(CLOCK_REALTIME, &abstime);
+    abstime.tv_sec += msecs / 1000;
+    abstime.tv_nsec += (long)(msecs % 1000) * 1000000L;
+    if (abstime.tv_nsec >= 1000000000L)
     {
-      /* The message at the head of the queue matched the tag.
-	 Grab it. */
-      stop = 1;
-      *out = item->buf;
-      free(item);
-      q->head++;
-      if (q->head == q->qsize)
-	q->head = 0;
-      if (q->head == q->tail)
-	q->empty = 1;
-      q->full = 0;
-      /* Unlock and signal the producer(s) to wake up. */
-      TRY( pthread_mutex_unlock (q->mut), return status);
-      TRY( pthread_cond_signal (q->notFull), return status);  
+      abstime.tv_sec++;
+      abstime.tv_nsec -= 1000000000L;
     }
+  }
+
+  TRY( pthread_mutex_lock (&q->mut), return status);
+
+  box = TagBox(q, tag, 1);
+  if (!box)
+  {
+    pthread_mutex_unlock(&q->mut);
+    fprintf(stderr, "Error at %s, line %d: out of memory.\n", __FILE__, __LINE__);
+    return ENOMEM;
+  }
+
+  /* Wait for an item with this tag to be put into the queue. */
+  box->nwaiting++;
+  while (box->head == NIL && waitstat == 0)
+  {
+    if (msecs >= 0)
+      waitstat = pthread_cond_timedwait(&box->ready, &q->mut, &abstime);
     else
-    {
-      /* The item at the head of the queue did not belong to this
-	 thread. Unlock, signal and  and yield the timeslice so
-	 another thread can try to claim the item. */
-      TRY( pthread_mutex_unlock (q->mut), return status);
-      sched_yield();
-    }
+      waitstat = pthread_cond_wait(&box->ready, &q->mut);
+  }
+  box->nwaiting--;
+
+  if (box->head != NIL)
+  {
+    TakeItem(q, box, out);
+  }
+  else
+  {
+    TagBoxRelease(q, box);
+    status = waitstat;
+    if (status != ETIMEDOUT)
+      fprintf(stderr, "Error at %s, line %d: waiting for tag %ld failed with status = %d\n", __FILE__, __LINE__, tag, status);
   }
+
+  pthread_mutex_unlock(&q->mut);
   return status;
 }
 
+int tqueueDel(tqueue_t *q, long tag, char **out)
+{
+  return DelTagged(q, tag, out, -1);
+}
+
+int tqueueDelTimed(tqueue_t *q, long tag, char **out, int msecs)
+{
+  return DelTagged(q, tag, out, msecs < 0 ? 0 : msecs);
+}
+
+/* Remove the item at the head of the queue, whatever its tag. Returns 1 if this
+   emptied a corked queue (see queueDel()). */
 int tqueueDelAny(tqueue_t *q, long *tag, char **out)
 {
   int status = 0;
-  char *ptr;
-  tagitem_t *item;
-  status = queueDel((queue_t *) q, &ptr);
-  item = (tagitem_t *) ptr;
-  *tag = item->tag;
-  *out = item->buf;
-  free(item);
-  return status;
-}
+  int emptied;
+  tagbox_t *box;
+
+  /* Wait for something to be put into the queue. */
+  TRY( pthread_mutex_lock (&q->mut), return status);
+  while (q->count == 0)
+    TRY( pthread_cond_wait (&q->notEmpty, &q->mut), pthread_mutex_unlock(&q->mut); return status);
 
+  *tag = q->items[q->head].tag;
+  box = TagBox(q, *tag, 0);
+  /* The head of the queue is the oldest item with its tag - the head of its mailbox. */
+  emptied = TakeItem(q, box, out);
 
+  TRY( pthread_mutex_unlock (&q->mut), return status);
+  return emptied;
+}
@@ -1,13 +1,20 @@
 #ifndef __TAGFIFO_H
 #define __TAGFIFO_H
-#include "fifo.h"
+#include <pthread.h>
 
-typedef queue_t tqueue_t;
+/* A FIFO of items tagged by the thread that is to receive them. tqueueDel() returns the
+   oldest item with the caller's tag, regardless of what is ahead of it in the queue, and
+   sleeps on a condition variable of its own until such an item arrives.
+   tqueueDelAny() returns the oldest item with any tag. Items are stored in an array of
+   qsize slots allocated by tqueueInit(); tqueueAdd() waits while all slots are in use. */
+typedef struct tqueue_struct tqueue_t;
 
 tqueue_t *tqueueInit(int qsize);
 int tqueueDelete(tqueue_t *q);
 int tqueueAdd(tqueue_t *q, long tag, char *in);
 int tqueueDel(tqueue_t *q, long tag, char **out);
+/* Like tqueueDel(), but gives up after msecs milliseconds and returns ETIMEDOUT. */
+int tqueueDelTimed(tqueue_t *q, long tag, char **out, int msecs);
 int tqueueDelAny(tqueue_t *q, long *tag, char **out);
 int tqueueCork(tqueue_t *q);
 
@@ -309,21 +309,18 @@ static void purgeVDSCache()
     int initSize;
     HIterator_t iter;
     const char *key = NULL;
-    int ielem;
     
     if (gHandleVDSCache)
     {
         initSize = hcon_size(gHandleVDSCache);
         hiter_new(&iter, gHandleVDSCache);
-        ielem = 0;
         
-        while (hcon_size(gHandleVDSCache) > initSize / 2)
+        while (hcon_size(gHandleVDSCache) > initSize / 2 && hiter_extgetnext(&iter, &key))
         {
-            /* hacky, hacky! */
-            key = iter.elems[ielem]->key;
             hcon_remove(gHandleVDSCache, key);
-            ielem++;
         }
+
+        hiter_free(&iter);
     }
 }
 
@@ -12,8 +12,9 @@ sum_svc_comm_obj_$(d)	:= $(addprefix $(d)/, sum_init.o du_dir.o)
 sum_svc_obj_$(d)	:= $(addprefix $(d)/, sum_svc_proc.o)
 # xsum_svc_obj_$(d)	:= $(addprefix $(d)/, xsum_svc_proc.o)
 xsum_svc_obj_$(d)	:= 
-tape_svc_obj_$(d)	:= $(addprefix $(d)/, tape_svc_proc.o tapeutil.o tape_inventory.o)
+tape_svc_obj_$(d)	:= $(addprefix $(d)/, tape_svc_proc.o tapeutil.o tape_inventory.o tapesched.o)
 tapearc_obj_$(d)	:= $(addprefix $(d)/, padata.o)
+drive_svc_obj_$(d)	:= $(addprefix $(d)/, tapetar.o)
 
 CF_TGT_$(d)	:= -O0 -Wno-parentheses -fno-strict-aliasing
 # ART - We haven't used SUMT120 in years. Let's make the default what we use at Stanford (since nobody else even uses our tape system/code).
@@ -88,7 +89,7 @@ TGT_$(d)        := $(BINTGT_$(d)) $(BINTGT_2_$(d)) $(BINTGT_3_$(d))
 # SUMS_BIN contains a list of applications that get built when 'make sums' is invoked
 SUMS_BIN	:= $(SUMS_BIN) $(TGT_$(d)) $(XSUMSVC_$(d)) $(TAPESVC_$(d)) $(TARCINFO_$(d)) $(TAPEARCX_$(d)) $(MULTI_SUMS_$(d))
 
-OBJ_$(d)	:= $(sum_svc_comm_obj_$(d)) $(sum_svc_obj_$(d)) $(xsum_svc_obj_$(d)) $(tape_svc_obj_$(d)) $(tapearc_obj_$(d)) $(TGT_$(d):%=%.o) $(XSUMSVC_$(d):%=%.o) $(TAPESVC_$(d):%=%.o) $(TARCINFO_$(d):%:%.o) $(TAPEARCX_$(d):%:%.o) $(MULTI_SUMS_$(d):%=%.o)
+OBJ_$(d)	:= $(sum_svc_comm_obj_$(d)) $(sum_svc_obj_$(d)) $(xsum_svc_obj_$(d)) $(tape_svc_obj_$(d)) $(tapearc_obj_$(d)) $(drive_svc_obj_$(d)) $(TGT_$(d):%=%.o) $(XSUMSVC_$(d):%=%.o) $(TAPESVC_$(d):%=%.o) $(TARCINFO_$(d):%:%.o) $(TAPEARCX_$(d):%:%.o) $(MULTI_SUMS_$(d):%=%.o)
 
 DEP_$(d)	:= $(OBJ_$(d):%=%.d)
 
@@ -116,6 +117,9 @@ $(d)/drive10_svc.o:	CF_TGT := $(CF_TGT_$(d)) -DDRIVE_10
 $(d)/drive11_svc.o:	CF_TGT := $(CF_TGT_$(d)) -DDRIVE_11
 $(d)/drive%_svc.o:	$(d)/driven_svc.c
 			$(SUMSCOMP)
+
+# driveX_svc write tape files with tapetar.o (instead of gtar)
+$(filter $(d)/drive%_svc, $(BINTGT_3_$(d))):	$(drive_svc_obj_$(d))
 endif
 
 # Special rules for building robotX_svc.o, X=0,1,2,3 from from driven_svc.c
@@ -0,0 +1,192 @@
+/* benchkey.c
+ * Times the KEY list handling of a SUM_get() of reqcnt SUs (default
+ * MAXSUMREQCNT) as done by the SUMS API and sum_svc. The client makes the
+ * dsix_0..dsix_N request list, it is XDR encoded and decoded (xdr_Rkey()),
+ * sum_svc looks up each dsix_i and makes the wd_i/dsix_i response list, and
+ * that is encoded and decoded back for the client to look up each wd_i.
+ * This is done with key.c (hash index on long lists) and with the list
+ * walk key.c used before (old), and the XDR bytes of both must be the same.
+ *
+ * usage: benchkey [reqcnt] [loops]
+ *    eg: benchkey 512 200
+*/
+
+#include <SUM.h>
+#include <sum_rpc.h>
+#include <soi_key.h>
+#include <sys/time.h>
+
+#define XDRBUFSZ (4*1024*1024)
+
+static char xdrbuf[2][XDRBUFSZ];
+static u_int xdrlen[2];
+static char oldbuf[2][XDRBUFSZ];
+static u_int oldlen[2];
+
+static double dtime()
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return((double)tv.tv_sec + (double)tv.tv_usec / 1.0e6);
+}
+
+/* findkey() and setkey_any() as they were, a walk of the list */
+static KEY *oldfindkey(KEY *list, char *key)
+{
+  for(; list; list = list->next) {
+    if(!strcmp(list->name, key)) return(list);
+  }
+  return(NULL);
+}
+
+static void oldsetkey(KEY **list, char *key, void *val, int type)
+{
+  if(oldfindkey(*list, key)) {		/* no key is set twice here */
+    fprintf(stderr, "%s set twice\n", key);
+    exit(1);
+  }
+  addkey(list, key, val, type);
+}
+
+static void setk(int old, KEY **list, char *key, void *val, int type)
+{
+  if(old) oldsetkey(list, key, val, type);
+  else setkey_any(list, key, val, type);
+}
+
+static KEY *findk(int old, KEY *list, char *key)
+{
+  if(old) return(oldfindkey(list, key));
+  return(findkey(list, key));
+}
+
+/* XDR encode list to xdrbuf[n] and decode it to a new list */
+static KEY *xdrtrip(KEY *list, int n)
+{
+  XDR xdrs;
+  Rkey *rkey;
+
+  xdrmem_create(&xdrs, xdrbuf[n], XDRBUFSZ, XDR_ENCODE);
+  if(!xdr_Rkey(&xdrs, (Rkey *)list)) {
+    fprintf(stderr, "xdr_Rkey() encode failed\n");
+    exit(1);
+  }
+  xdrlen[n] = xdr_getpos(&xdrs);
+  xdr_destroy(&xdrs);
+  rkey = (Rkey *)calloc(1, sizeof(Rkey));
+  xdrmem_create(&xdrs, xdrbuf[n], xdrlen[n], XDR_DECODE);
+  if(!xdr_Rkey(&xdrs, rkey)) {
+    fprintf(stderr, "xdr_Rkey() decode failed\n");
+    exit(1);
+  }
+  xdr_destroy(&xdrs);
+  return((KEY *)rkey);
+}
+
+static void xdrfree(KEY *list)
+{
+  xdr_free((xdrproc_t)xdr_Rkey, (char *)list);
+  free(list);
+}
+
+/* One SUM_get() of reqcnt SUs. Returns the sum of the sunums the client
+ * got back (to check old and new agree).
+*/
+static uint64_t sumget(int old, int reqcnt)
+{
+  KEY *klist = newkeylist();
+  KEY *params, *rlist, *results, *p;
+  char name[64], wd[80];
+  uint64_t sunum, sum = 0;
+  int i, cnt, n;
+
+  n = 10;
+  setk(old, &klist, "uid", &sum, KEYTYP_UINT64);
+  setk(old, &klist, "mode", &n, KEYTYP_INT);
+  setk(old, &klist, "tdays", &n, KEYTYP_INT);
+  setk(old, &klist, "reqcnt", &reqcnt, KEYTYP_INT);
+  setk(old, &klist, "username", "production", KEYTYP_STRING);
+  for(i = 0; i < reqcnt; i++) {
+    sprintf(name, "dsix_%d", i);
+    sunum = 100000000 + i;
+    setk(old, &klist, name, &sunum, KEYTYP_UINT64);
+  }
+  params = xdrtrip(klist, 0);		/* to sum_svc */
+  freekeylist(&klist);
+
+  rlist = newkeylist();
+  p = findk(old, params, "reqcnt");
+  cnt = *(int *)p->val;
+  setk(old, &rlist, "uid", findk(old, params, "uid")->val, KEYTYP_UINT64);
+  setk(old, &rlist, "reqcnt", &cnt, KEYTYP_INT);
+  for(i = 0; i < cnt; i++) {
+    sprintf(name, "dsix_%d", i);
+    sunum = *(uint64_t *)findk(old, params, name)->val;
+    setk(old, &rlist, name, &sunum, KEYTYP_UINT64);
+    sprintf(name, "wd_%d", i);
+    sprintf(wd, "/SUM%d/D%llu", i % 40, (unsigned long long)sunum);
+    setk(old, &rlist, name, wd, KEYTYP_STRING);
+  }
+  setk(old, &rlist, "status", &n, KEYTYP_INT);
+  xdrfree(params);
+  results = xdrtrip(rlist, 1);		/* back to the client */
+  freekeylist(&rlist);
+
+  for(i = 0; i < cnt; i++) {
+    sprintf(name, "wd_%d", i);
+    if(!(p = findk(old, results, name))) {
+      fprintf(stderr, "No %s in the results\n", name);
+      exit(1);
+    }
+    sunum = strtoull(strrchr((char *)p->val, 'D') + 1, NULL, 10);
+    sprintf(name, "dsix_%d", i);
+    if(sunum != *(uint64_t *)findk(old, results, name)->val) {
+      fprintf(stderr, "Wrong %s in the results\n", name);
+      exit(1);
+    }
+    sum += sunum;
+  }
+  xdrfree(results);
+  return(sum);
+}
+
+int main(int argc, char *argv[])
+{
+  int reqcnt = argc > 1 ? atoi(argv[1]) : MAXSUMREQCNT;
+  int loops = argc > 2 ? atoi(argv[2]) : 200;
+  uint64_t oldsum = 0, newsum = 0;
+  double t, told = 0, tnew = 0;
+  int i, old;
+
+  for(old = 1; old >= 0; old--) {
+    t = dtime();
+    for(i = 0; i < loops; i++) {
+      if(old) oldsum = sumget(old, reqcnt);
+      else newsum = sumget(old, reqcnt);
+    }
+    t = (dtime() - t) / loops;
+    if(old) {
+      told = t;
+      memcpy(oldbuf, xdrbuf, sizeof(oldbuf));
+      memcpy(oldlen, xdrlen, sizeof(oldlen));
+    }
+    else tnew = t;
+  }
+  printf("reqcnt %d: old %.3f ms, new %.3f ms per SUM_get() (%.1fx)\n",
+	reqcnt, told * 1000.0, tnew * 1000.0, told / tnew);
+  if(oldsum != newsum) {
+    fprintf(stderr, "old and new results differ\n");
+    return(1);
+  }
+  for(i = 0; i < 2; i++) {
+    if(oldlen[i] != xdrlen[i] || memcmp(oldbuf[i], xdrbuf[i], xdrlen[i])) {
+      fprintf(stderr, "XDR of the %s list differs from the old one\n",
+		i ? "response" : "request");
+      return(1);
+    }
+  }
+  printf("XDR of the request (%u bytes) and response (%u bytes) as before\n",
+	xdrlen[0], xdrlen[1]);
+  return(0);
+}
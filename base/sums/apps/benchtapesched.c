@@ -0,0 +1,278 @@
+/* benchtapesched.c
+ * Tape read scheduling simulator. It replays a log of tape read requests
+ * against a simulated robot and ndrives drives (simulated time: a robot
+ * move takes ROBOTMOVE secs, a tape positions at SEEKFILE secs per file
+ * plus LOCATE, and reads at READRATE bytes/sec). The rd Q is kept with the
+ * same tapeutil.c routines tape_svc uses, and it is served by
+ *   old - the order kick_next_entry_rd() used to use: rd Q (file#) order
+ *         for mounted tapes, then mount the tape of the first entry
+ *   new - the tapesched.c routines kick_next_entry_rd() now uses
+ * For each it reports robot mounts per GB read, files per mount, the mean,
+ * 95th percentile and max time a request waited, and the hours it took to
+ * serve the log (makespan).
+ *
+ * A log line is: secs uid tapeid filenum bytes
+ * (secs since the start, sorted). With no log a random one is made.
+ *
+ * usage: benchtapesched [log|-] [ndrives] [nrequests]
+ *    eg: benchtapesched - 4 5000
+*/
+
+#include <SUM.h>
+#include <tape.h>
+#include <sum_rpc.h>
+#include <math.h>
+
+#define ROBOTMOVE 40.0		/* secs to load or unload a tape */
+#define LOCATE 20.0		/* secs to start positioning */
+#define SEEKFILE 1.5		/* secs to space over one tape file */
+#define READRATE 140.0e6	/* bytes/sec */
+#define MAXREQ 200000
+
+extern void insert_tq_entry_rd_sort();
+extern TQ *delete_q_rd();
+extern time_t tapesched_rd_starve();
+extern TQ *tapesched_rd_mounted();
+extern TQ *tapesched_rd_mount();
+
+/* what tapeutil.c needs from tape_svc */
+SLOT slots[MAX_SLOTS];
+DRIVE drives[MAX_DRIVES];
+TQ *q_rd_front = NULL;
+TQ *q_rd_rear = NULL;
+TQ *q_wrt_front = NULL;
+TQ *q_wrt_rear = NULL;
+TQ *q_rd_need_front = NULL;
+TQ *q_rd_need_rear = NULL;
+TQ *q_wrt_need_front = NULL;
+TQ *q_wrt_need_rear = NULL;
+
+int write_log(const char *fmt, ...)
+{
+  return(0);
+}
+
+typedef struct {
+  double t;
+  uint64_t uid;
+  char tapeid[20];
+  int filenum;
+  double bytes;
+} REQ;
+
+typedef struct {
+  double until;		/* busy until */
+  TQ *p;		/* entry being read (after a mount when robot) */
+} OP;
+
+static REQ reqs[MAXREQ];
+static double waits[MAXREQ];
+static OP drop[MAX_DRIVES];
+static OP robot;
+static int ndrives;
+static int robotdrive;	/* drive the robot is loading */
+
+static double seektime(int from, int to)
+{
+  if(to > from) return(LOCATE + (to - from - 1) * SEEKFILE);
+  return(LOCATE + (from - to + 1) * SEEKFILE);	/* back up */
+}
+
+static int cmpwait(const void *a, const void *b)
+{
+  double wa = *(const double *)a, wb = *(const double *)b;
+
+  return((wa > wb) - (wa < wb));
+}
+
+static void startread(int d, TQ *p, double now, double *bytes)
+{
+  REQ *r = (REQ *)p->list;
+
+  drives[d].busy = 1;
+  drop[d].p = p;
+  drop[d].until = now + seektime(drives[d].filenum, p->filenum) + r->bytes / READRATE;
+  drives[d].filenum = p->filenum;
+  *bytes += r->bytes;
+}
+
+/* start what the old or new kick_next_entry_rd() would */
+static void kick(int new, double now, int *mounts, double *bytes)
+{
+  TQ *p, *pnext;
+  time_t starve = 0;
+  int d, e, victim;
+  static int nxtscan = 0;
+
+  if(new) {
+    starve = tapesched_rd_starve(q_rd_front, drives, ndrives, (time_t)now, &victim);
+    for(d=0; d < ndrives; d++) {
+      if(drives[d].busy) continue;
+      if((p = tapesched_rd_mounted(q_rd_front, &drives[d], d == victim ? starve : 0))) {
+        delete_q_rd(p);
+        startread(d, p, now, bytes);
+      }
+    }
+    p = tapesched_rd_mount(q_rd_front, drives, ndrives, starve, (time_t)now);
+  }
+  else {
+    for(p = q_rd_front; p; p = pnext) {
+      pnext = p->next;
+      for(d=0; d < ndrives; d++) {
+        if(drives[d].tapeid && !strcmp(drives[d].tapeid, p->tapeid)) break;
+      }
+      if(d < ndrives && !drives[d].busy) {
+        delete_q_rd(p);
+        startread(d, p, now, bytes);
+      }
+    }
+    for(p = q_rd_front; p; p = p->next) {
+      for(d=0; d < ndrives; d++) {
+        if(drives[d].tapeid && !strcmp(drives[d].tapeid, p->tapeid)) break;
+      }
+      if(d == ndrives) break;
+    }
+  }
+  if(!p || robot.p) return;
+
+  /* a free drive, first w/no tape and then not busy (as tape_svc) */
+  for(d=0; d < ndrives; d++) {
+    if(!drives[d].busy && !drives[d].tapeid) break;
+  }
+  if(d == ndrives) {
+    for(e=0; e < ndrives; e++) {
+      d = nxtscan++ % ndrives;
+      if(!drives[d].busy) break;
+    }
+    if(e == ndrives) return;
+  }
+  delete_q_rd(p);
+  drives[d].busy = 1;
+  robot.p = p;
+  robot.until = now + (drives[d].tapeid ? 2 : 1) * ROBOTMOVE;
+  robotdrive = d;
+  (*mounts)++;
+}
+
+static void run(int new, int nreq)
+{
+  REQ *r;
+  TQ *p;
+  double now = 0, next, bytes = 0, wait, waitsum = 0, waitmax = 0;
+  int ireq = 0, ndone = 0, mounts = 0, d;
+
+  memset(drives, 0, sizeof(drives));
+  memset(drop, 0, sizeof(drop));
+  memset(&robot, 0, sizeof(robot));
+  for(d=0; d < ndrives; d++) drives[d].filenum = -1;
+
+  while(ndone < nreq) {
+    /* next event: an arrival, a read done or a mount done */
+    next = ireq < nreq ? reqs[ireq].t : 1.0e30;
+    for(d=0; d < ndrives; d++) {
+      if(drop[d].p && drop[d].until < next) next = drop[d].until;
+    }
+    if(robot.p && robot.until < next) next = robot.until;
+    now = next;
+
+    for(; ireq < nreq && reqs[ireq].t <= now; ireq++) {
+      r = &reqs[ireq];
+      p = (TQ *)calloc(1, sizeof(TQ));
+      p->uid = r->uid;
+      p->tapeid = r->tapeid;
+      p->filenum = r->filenum;
+      p->qtime = (time_t)r->t;
+      p->list = (KEY *)r;		/* the sim keeps its REQ here */
+      insert_tq_entry_rd_sort(p);
+    }
+    for(d=0; d < ndrives; d++) {
+      if(drop[d].p && drop[d].until <= now) {
+        r = (REQ *)drop[d].p->list;
+        wait = now - r->t;
+        waitsum += wait;
+        if(wait > waitmax) waitmax = wait;
+        waits[ndone] = wait;
+        free(drop[d].p);
+        drop[d].p = NULL;
+        drives[d].busy = 0;
+        ndone++;
+      }
+    }
+    if(robot.p && robot.until <= now) {
+      d = robotdrive;
+      drives[d].tapeid = robot.p->tapeid;
+      drives[d].filenum = -1;		/* rewound */
+      startread(d, robot.p, now, &bytes);
+      robot.p = NULL;
+    }
+    kick(new, now, &mounts, &bytes);
+  }
+  qsort(waits, nreq, sizeof(double), cmpwait);
+  printf("%-4s %8d %10.1f %10.3f %12.1f %12.0f %12.0f %12.0f %10.1f\n",
+	new ? "new" : "old", mounts, bytes / 1.0e9, mounts / (bytes / 1.0e9),
+	(double)nreq / mounts, waitsum / nreq, waits[(int)(0.95 * (nreq - 1))],
+	waitmax, now / 3600.0);
+}
+
+/* random log: clients ask for runs of files from a few hundred tapes,
+ * some tapes much more often than others */
+static int makelog(int nreq)
+{
+  double t = 0;
+  int i = 0, run, fn, tape;
+  uint64_t uid = 1;
+
+  srandom(17);
+  while(i < nreq) {
+    t += (random() % 300);
+    tape = (int)(300.0 * pow((random() % 10000) / 10000.0, 3.0));
+    fn = 1 + random() % 400;
+    run = 1 + (random() % 4 == 0 ? random() % 40 : 0);
+    for(; run > 0 && i < nreq; run--, i++, fn += 1 + random() % 3) {
+      reqs[i].t = t;
+      reqs[i].uid = uid;
+      sprintf(reqs[i].tapeid, "%06dL4", tape);
+      reqs[i].filenum = fn;
+      reqs[i].bytes = 100.0e6 + random() % 900000000;
+    }
+    uid++;
+  }
+  return(i);
+}
+
+int main(int argc, char *argv[])
+{
+  FILE *fp;
+  char line[256];
+  int nreq = 0;
+
+  ndrives = argc > 2 ? atoi(argv[2]) : 4;
+  if(ndrives > MAX_DRIVES) ndrives = MAX_DRIVES;
+  if(argc > 1 && strcmp(argv[1], "-")) {
+    if(!(fp = fopen(argv[1], "r"))) {
+      fprintf(stderr, "Can't open %s\n", argv[1]);
+      return(1);
+    }
+    while(nreq < MAXREQ && fgets(line, sizeof(line), fp)) {
+      if(sscanf(line, "%lf %lu %19s %d %lf", &reqs[nreq].t, &reqs[nreq].uid,
+		reqs[nreq].tapeid, &reqs[nreq].filenum, &reqs[nreq].bytes) == 5)
+        nreq++;
+    }
+    fclose(fp);
+  }
+  else {
+    nreq = makelog(argc > 3 ? atoi(argv[3]) : 5000);
+  }
+  if(nreq == 0) {
+    fprintf(stderr, "No requests\n");
+    return(1);
+  }
+
+  printf("%d requests, %d drives\n", nreq, ndrives);
+  printf("%-4s %8s %10s %10s %12s %12s %12s %12s %10s\n", "", "mounts", "GB",
+	"mounts/GB", "files/mount", "mean wait s", "p95 wait s", "max wait s",
+	"hours");
+  run(0, nreq);
+  run(1, nreq);
+  return(0);
+}
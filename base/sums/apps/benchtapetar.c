@@ -0,0 +1,118 @@
+/* benchtapetar.c
+ * End-to-end test of tapetar_write() without a tape drive. It makes nsu
+ * SU dirs (Dnnn/S00000/file.fits, with a few subdirs, empty files, long names
+ * and symlinks) under dir/SUM, writes them to the sim drive file dir/sim.tar
+ * (as driven_svc does in sim mode), and reports the rate. It then checks that
+ * 'tar -xf' of the file gives back the same tree, and that md5sum of the file
+ * is the md5 cksum reported for the write.
+ *
+ * usage: benchtapetar [dir] [nsu] [MB per SU]
+ *    eg: benchtapetar /tmp 16 64
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "tapetar.h"
+
+#define BLOCKING 256		/* GTARBLOCK in tape.h */
+
+static int make_su(const char *sumdir, int isu, long bytes)
+{
+  char path[512];
+  char *buf;
+  long i;
+  int fd;
+
+  sprintf(path, "%s/D%d/S00000", sumdir, 1000 + isu);
+  mkdir(path, 0755);		/* parent made by caller */
+  sprintf(path + strlen(path), "/file.fits");
+  if(!(buf = malloc(bytes)) || (fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644)) == -1)
+    return(1);
+  srandom(isu);
+  for(i = 0; i < bytes; i++)
+    buf[i] = (char)(random() >> 4);
+  write(fd, buf, bytes - isu);	/* sizes not multiples of 512 */
+  close(fd);
+  free(buf);
+
+  sprintf(path, "%s/D%d/Records.txt", sumdir, 1000 + isu);
+  close(open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644));
+  if(isu == 0) {
+    sprintf(path, "%s/D%d/S00000/a_file_name_longer_than_the_one_hundred_bytes_of_a_tar_header_name_field_so_it_needs_a_gnu_longlink.fits", sumdir, 1000 + isu);
+    close(open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644));
+    sprintf(path, "%s/D%d/S00000/link.fits", sumdir, 1000 + isu);
+    symlink("file.fits", path);
+  }
+  return(0);
+}
+
+int main(int argc, char *argv[])
+{
+  const char *dir = argc > 1 ? argv[1] : "/tmp";
+  int nsu = argc > 2 ? atoi(argv[2]) : 16;
+  long bytes = (argc > 3 ? atol(argv[3]) : 64) * 1024 * 1024;
+  TapeTarStat_t stat;
+  char **roots, **members;
+  char sumdir[256], simfile[256], cmd[1024], md5[64];
+  FILE *fp;
+  int isu, fd, status;
+
+  sprintf(sumdir, "%s/benchtapetar/SUM", dir);
+  sprintf(simfile, "%s/benchtapetar/sim.tar", dir);
+  sprintf(cmd, "rm -rf %s/benchtapetar; mkdir -p %s", dir, sumdir);
+  system(cmd);
+
+  roots = (char **)malloc(nsu * sizeof(char *));
+  members = (char **)malloc(nsu * sizeof(char *));
+  for(isu = 0; isu < nsu; isu++) {
+    roots[isu] = sumdir;
+    members[isu] = (char *)malloc(32);
+    sprintf(members[isu], "D%d", 1000 + isu);
+    sprintf(cmd, "%s/%s", sumdir, members[isu]);
+    mkdir(cmd, 0755);
+    if(make_su(sumdir, isu, bytes)) {
+      fprintf(stderr, "Can't make SU %s\n", cmd);
+      return(1);
+    }
+  }
+  system("sync");
+
+  if((fd = open(simfile, O_WRONLY|O_CREAT|O_TRUNC, 0644)) == -1) {
+    fprintf(stderr, "Can't open %s\n", simfile);
+    return(1);
+  }
+  status = tapetar_write(fd, BLOCKING, nsu, roots, members, &stat);
+  close(fd);
+  if(status) {
+    fprintf(stderr, "tapetar_write() failed: %s\n", stat.errmsg);
+    return(1);
+  }
+  printf("%llu bytes, %llu files in %.2f s (%.1f MB/s); waited %.2f s for reads, %.2f s for writes\n",
+	(unsigned long long)stat.bytes, (unsigned long long)stat.nfiles, stat.seconds,
+	stat.bytes / stat.seconds / 1.0e6, stat.readwait, stat.writewait);
+
+  /* the file must be a tar file of the SU dirs, in whole records */
+  sprintf(cmd, "cd %s/benchtapetar && mkdir x && tar -xf sim.tar -C x && diff -r --no-dereference SUM x && test $((`stat -c %%s sim.tar` %% %d)) -eq 0", dir, BLOCKING * 512);
+  if(system(cmd)) {
+    fprintf(stderr, "Extracted tree differs from %s\n", sumdir);
+    return(1);
+  }
+  sprintf(cmd, "md5sum %s", simfile);
+  if(!(fp = popen(cmd, "r")) || fscanf(fp, "%63s", md5) != 1 || pclose(fp)) {
+    fprintf(stderr, "Can't run %s\n", cmd);
+    return(1);
+  }
+  if(strcmp(md5, stat.md5str)) {
+    fprintf(stderr, "md5 %s != md5sum %s\n", stat.md5str, md5);
+    return(1);
+  }
+  printf("tar -xf and md5sum ok (%s)\n", md5);
+
+  sprintf(cmd, "rm -rf %s/benchtapetar", dir);
+  system(cmd);
+  return(0);
+}
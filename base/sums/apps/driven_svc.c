@@ -25,16 +25,18 @@
 //#include <stropts.h>
 #include <sys/mtio.h>
 #include <dirent.h>
-#include <openssl/md5.h>
+#include "tapetar.h"
 
 #define RETAINDAY 3  /* #of days to retain "accidental" file read fr tape*/
 #define MAX_WAIT 20  /* max times to wait for rdy in get_tape_fnum_rdy() */
-#define BLOCK_SIZE GTARBLOCK*512
 #define CMDLENWRT 24576
 #define GTARLOGDIR "/var/logs/SUM/gtar"
+#define SIMDRIVEDIR "/usr/local/logs/SUM/simdrive" /* sim mode tape files */
 #define GTAR "/usr/local/bin/gtar"	/* gtar 1.16 on 29May2007 */
 static char errstr[256];
 int write_wd_to_drive();
+int tar_to_drive();
+void sim_drive_file();
 int write_hdr_to_drive();
 int position_tape_eod();
 int position_tape_bot();
@@ -1483,26 +1485,21 @@ uint64_t tell_blocks(int sim, int dnum)
 */
 int write_wd_to_drive(int sim, KEY *params, int drive, int fnum, char *logname)
 {
-  FILE *fptar;
-  MD5_CTX md5ctx;
-  size_t bytesread;
-  ssize_t byteswrite;
-  unsigned char md5val[16];
-  char buf[BLOCK_SIZE];
-  char cmd[CMDLENWRT], dname[64], tmpname[64], wdroot[64], wdD[64];
+  char cmd[CMDLENWRT], dname[64], oname[MAX_STR], tmpname[64];
+  char **roots, **members;
   char *cptr, *wd, *cptr2;
-  int status, cnt, i, len, tapefilenum, fd;
+  int status, cnt, i, len, tapefilenum;
 
   sprintf(dname, "%s%d", SUMDR, drive);
-  sprintf(md5file, "/usr/local/logs/SUM/md5/cksum%d", drive); 
-  sprintf(cmd, "touch %s", logname);	/* put a 0 len file there */
-  if(status = system(cmd)) { 
-      write_log("***Dr%d:wt:Err: %s\n", drive, cmd);
-      return(-1);
-  }
-  /*sprintf(cmd, "tar -cvf %s -b %d ", dname, GTARBLOCK);*/
-  sprintf(cmd, "%s -cf - -b %d ", GTAR, GTARBLOCK); /* output to stdout */
+  if(sim)
+    sim_drive_file(oname, GETKEY_str(params, "tapeid"), fnum);
+  else
+    strcpy(oname, dname);
   cnt = getkey_int(params, "reqcnt");
+  roots = (char **)malloc(cnt * sizeof(char *));
+  members = (char **)malloc(cnt * sizeof(char *));
+  /* cmd is the equivalent gtar cmd, for the log */
+  sprintf(cmd, "tar -cf %s -b %d", oname, GTARBLOCK);
   for(i = 0; i < cnt; i++) {
     sprintf(tmpname, "wd_%i", i);
     wd = GETKEY_str(params, tmpname);
@@ -1513,81 +1510,24 @@ int write_wd_to_drive(int sim, KEY *params, int drive, int fnum, char *logname)
     if (cptr2)			// found /Dzzzz
 	cptr = cptr2;
 
-    strcpy(wdD, cptr+1);
-    strcpy(wdroot, wd);
-    //cptr = strstr(wdroot, "/D");
-    cptr = wdroot + (cptr - wd);
-    *cptr = (char)NULL;
-    len = strlen(cmd) + strlen(wdroot) + strlen(wdD) + 8;
-    if(len > CMDLENWRT) {
-      write_log("***Error: cmd too long: %s\n", cmd);
-      return(-1);
-    }
-    sprintf(cmd, "%s -C %s %s", cmd, wdroot, wdD);
+    members[i] = strdup(cptr+1);
+    roots[i] = strdup(wd);
+    roots[i][cptr - wd] = 0;
+    len = strlen(cmd) + strlen(roots[i]) + strlen(members[i]) + 8;
+    if(len < CMDLENWRT)
+      sprintf(cmd+strlen(cmd), " -C %s %s", roots[i], members[i]);
   }
-  sprintf(cmd, "%s 2>%s", cmd, logname);
-/**************************orig pipe******************************************
-  sprintf(cmd, "%s 2>%s | %s %d %s 2>> %s | dd of=%s bs=%db 2>> %s", 
-	cmd, logname, md5filter, GTARBLOCK, md5file, logname, dname, GTARBLOCK, logname);
-**************************end orig pipe**************************************/
   write_time();
   write_log("*Dr%d:wt: %s\n", drive, cmd);
-  if(sim) {                             /* simulation mode only */
-    sleep(2);
+  status = tar_to_drive(sim, drive, oname, cnt, roots, members, logname);
+  for(i = 0; i < cnt; i++) {
+    free(roots[i]);
+    free(members[i]);
   }
-  else {
-    /***********************orig pipe cmd execution**********************
-    if(status = system(cmd)) { // status applies only to last cmd in pipe
-      write_log("***Dr%d:wt:Error. exit status=%d\n",drive,WEXITSTATUS(status));
-      drive_reset(dname);
-      return(-1);
-    }
-    ***********************end orig pipe cmd execution******************/
-    if(!(fptar = popen(cmd, "r"))) {
-      write_log("***Dr%d:wt:Error. Can't popen() cmd\n", drive);
-      drive_reset(dname);
-      return(-1);
-    }
-    if((fd = open(dname, O_WRONLY)) == -1) {
-      pclose(fptar);
-      write_log("***Dr%d:wt:Error. Can't open(%s) cmd\n", drive, dname);
-      drive_reset(dname);
-      return(-1);
-    }
-    MD5_Init(&md5ctx);
-    errno = 0;
-    while(bytesread = fread(buf, 1, BLOCK_SIZE, fptar)) {
-      MD5_Update(&md5ctx, buf, bytesread);
-      while(bytesread > 0) {
-        if((byteswrite = write(fd, buf, bytesread)) == -1) {
-          pclose(fptar);
-          close(fd);
-          write_log("***Dr%d:wt:Error. Can't write(%s). errno=%d\n", 
-			drive, dname, errno);
-          drive_reset(dname);
-          return(-1);
-        }
-        bytesread -= byteswrite;
-      }
-    }
-    close(fd);
-    if(!feof(fptar)) {
-      pclose(fptar);
-      write_log("***Dr%d:wt:Error. Not at eof on popen cmd. errno=%d\n", 
-			drive, errno);
-      drive_reset(dname);
-      return(-1);
-    }
-    MD5_Final(md5val, &md5ctx);
-    if(status = pclose(fptar)) {	//exit status of cmd
-      write_log("***Dr%d:wt:Error. popen cmd status=%d. errno=%d\n", 
-			drive, status, errno);
-      drive_reset(dname);
-      return(-1);
-    }
-    md5str[32] = 0;
-    for(i=0; i < 16; i++)
-      sprintf(md5str+2*i, "%02x", md5val[i]);
+  free(roots);
+  free(members);
+  if(status == -1) {
+    return(-1);
   }
   if((tapefilenum = get_tape_fnum_rdy(sim, dname)) == -1) {
     write_log("***Error: can't get file # on drive %d\n", drive);
@@ -1614,14 +1554,68 @@ int write_wd_to_drive(int sim, KEY *params, int drive, int fnum, char *logname)
   return(tapefilenum);
 }
 
+/* Give the name of the file that stands in for tape file fnum of tapeid
+ * in sim mode. A sim "tape" is the files SIMDRIVEDIR/tapeid_*.tar.
+*/
+void sim_drive_file(char *oname, char *tapeid, int fnum)
+{
+  mkdir(SIMDRIVEDIR, 0755);
+  sprintf(oname, "%s/%s_%d.tar", SIMDRIVEDIR, tapeid, fnum);
+}
+
+/* Write a tar file of members[i] (relative to roots[i]) to the drive or 
+ * sim file oname with tapetar_write(), which computes the md5 cksum 
+ * (into the global md5str) as it writes. Replaces the 
+ * gtar | md5filter popen() cmd. Errors also go to logname.
+ * Return -1 on error, else 0.
+*/
+int tar_to_drive(int sim, int drive, char *oname, int cnt, char **roots,
+			char **members, char *logname)
+{
+  FILE *lfp;
+  TapeTarStat_t tstat;
+  int fd, status;
+
+  if(sim)
+    fd = open(oname, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  else
+    fd = open(oname, O_WRONLY);
+  if(fd == -1) {
+    write_log("***Dr%d:wt:Error. Can't open(%s). errno=%d\n", drive, oname, errno);
+    if(!sim) drive_reset(oname);
+    return(-1);
+  }
+  status = tapetar_write(fd, GTARBLOCK, cnt, roots, members, &tstat);
+  if(close(fd) == -1 && status == 0) {
+    sprintf(tstat.errmsg, "Can't close %s: errno=%d", oname, errno);
+    status = -1;
+  }
+  if(status == -1) {
+    write_log("***Dr%d:wt:Error. %s\n", drive, tstat.errmsg);
+    if((lfp = fopen(logname, "w"))) {	/* kept for errors, like gtar's */
+      fprintf(lfp, "%s\n", tstat.errmsg);
+      fclose(lfp);
+    }
+    if(!sim) drive_reset(oname);
+    return(-1);
+  }
+  strcpy(md5str, tstat.md5str);
+  write_log("Dr%d:wt:%llu bytes, %llu files in %.1f sec (%.1f MB/s, waited %.1f sec for reads, %.1f sec for writes) md5=%s\n",
+		drive, (unsigned long long)tstat.bytes, 
+		(unsigned long long)tstat.nfiles, tstat.seconds, 
+		tstat.seconds > 0 ? tstat.bytes / tstat.seconds / 1.0e6 : 0.0,
+		tstat.readwait, tstat.writewait, md5str);
+  return(0);
+}
+
 /* The tape is at bot. Write a label at the file 0 on any tape that needs 
  * to be initialized.
 */
 int write_hdr_to_drive(int sim, char *tapeid, int group, int drive, char *log)
 {
   FILE *lfp;
-  char cmd[1024], dname[64], tmpname[64], dirname[64];
-  int status;
+  char cmd[1024], dname[MAX_STR], tmpname[64], dirbuf[64];
+  char *dirname = dirbuf, *member = "TAPELABEL";
 
   /* NOTE: a label can be done by multiple drives simultaneously */
   sprintf(dirname, "/usr/local/logs/SUM/%d", drive);
@@ -1639,20 +1633,16 @@ int write_hdr_to_drive(int sim, char *tapeid, int group, int drive, char *log)
     write_log("***Error: Can't close %s errno=%d\n", tmpname, errno);
     return(-1);
   }
-  sprintf(dname, "%s%d", SUMDR, drive);
-  sprintf(cmd, "%s -cvf %s -b %d -C %s TAPELABEL 1> %s 2>&1", 
-		GTAR, dname, GTARBLOCK, dirname, log);
+  if(sim)
+    sim_drive_file(dname, tapeid, 0);
+  else
+    sprintf(dname, "%s%d", SUMDR, drive);
+  sprintf(cmd, "tar -cf %s -b %d -C %s %s", 
+		dname, GTARBLOCK, dirname, member);
   write_time();
   write_log("*Dr%d:wt: %s\n", drivenum, cmd);
-  if(sim) {				/* simulation mode only */
-    sleep(2);
-  }
-  else {
-    if(status = system(cmd)) {
-      write_log("***Dr%d:wt:Error. exit status=%d\n",drivenum,WEXITSTATUS(status));
-      drive_reset(dname);
-      return(-1);
-    }
+  if(tar_to_drive(sim, drivenum, dname, 1, &dirname, &member, log) == -1) {
+    return(-1);
   }
   write_log("***Dr%d:wt:success\n", drivenum);/*must be this form for t120 gui*/
   return(drive);
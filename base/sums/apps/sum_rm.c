@@ -39,6 +39,11 @@
  *	NORUN_START=7
  *	#start running again when the hour first hits NORUN_STOP
  *	NORUN_STOP=7
+ *	#threads removing dirs (from all the partitions at once)
+ *	RM_THREADS=8
+ *	#max files+dirs removed a second by all of them (0 = no limit,
+ *	#the default; set it if the removal slows the SUMS clients down)
+ *	RM_OPS_PER_SEC=0
  *
  * sum_rm deletes the delete pending dirs in the sum_partn_alloc table
  * that have expired. The deletion is from the oldest effective_date forward.
@@ -96,6 +101,8 @@ int norun_stop;		/* start running again when the hour first hits this */
 char xlogfile[256];	/* log file name */
 char mailto[256];	/* mail recipient(s) */
 char userrun[256];	/* user name who can run sum_rm */
+int rm_threads;		/* # threads removing dirs */
+int rm_opspersec;	/* max unlinks+rmdirs a sec, 0 = no limit */
 double max_free_set_need[MAX_PART];    // bytes to keep free for each SUM part
 double max_free_set_current[MAX_PART]; // bytes now free for each SUM part
 double max_free_set_percent[MAXSUMSETS];  // % to keep free for each % SUM set
@@ -201,11 +208,14 @@ void alrm_sig(int sig)
 int stat_storage()
 {
   PART *pptr;
+  RmStat_t rmstat;
   int i, status;
   int updated = 0;
   double df_avail, df_total, df_del, total, upercent;
   struct statvfs vfs;
 
+  if(rmdirs_start(rm_threads, rm_opspersec))
+    printk("Can't start rm threads. Removing dirs one at a time\n");
   for(i=0; i<MAX_PART-1; i++) {
     pptr=(PART *)&ptab[i];
     if(pptr->name == NULL) break;
@@ -242,6 +252,16 @@ int stat_storage()
         }
     }
   }
+  rmdirs_wait(&rmstat);		/* dirs queued by DS_RmDoX() */
+  if(rmstat.sus || rmstat.errs) {
+    printk("Removed %d dirs, %llu files, %e bytes in %.1f sec (%.1f MB/sec)\n",
+	rmstat.sus, (unsigned long long)rmstat.files, (double)rmstat.bytes,
+	rmstat.seconds, rmstat.seconds > 0.0 ?
+	(double)rmstat.bytes / rmstat.seconds / 1.0e6 : 0.0);
+  }
+  if(rmstat.errs) {
+    printk("**Err: Cannot rm %d dirs (first %s)\n", rmstat.errs, rmstat.errwd);
+  }
   return(updated);
 }
 
@@ -267,6 +287,10 @@ int stat_storage()
  *	   NORUN_START=7
  *	   #start running again when the hour first hits NORUN_STOP
  *	   NORUN_STOP=13
+ *	   #threads removing dirs (from all the partitions at once)
+ *	   RM_THREADS=8
+ *	   #max files+dirs removed a second by all of them (0 = no limit)
+ *	   RM_OPS_PER_SEC=0
  * Default values are first set in case none given in the cfg file.
 */
 void get_cfg()
@@ -295,6 +319,8 @@ void get_cfg()
   strcpy(xlogfile, "/tmp/sum_rm.log");
   strcpy(mailto, "sys2@solar2");
   strcpy(userrun, "production");
+  rm_threads = 8;
+  rm_opspersec = 0;
 #ifdef __LOCALIZED_DEFS__
   sprintf (cfgfile, "%s/sum_rm.cfg", SUMLOG_BASEDIR);
 #else
@@ -359,6 +385,18 @@ void get_cfg()
         norun_stop=atoi(token);
       }
     }
+    else if(strstr(line, "RM_THREADS=")) {
+      token=(char *)strtok(line, "=\n");
+      if(token=(char *)strtok(NULL, "\n")) {
+        rm_threads=atoi(token);
+      }
+    }
+    else if(strstr(line, "RM_OPS_PER_SEC=")) {
+      token=(char *)strtok(line, "=\n");
+      if(token=(char *)strtok(NULL, "\n")) {
+        rm_opspersec=atoi(token);
+      }
+    }
   }
   if(norun_stop < norun_start) {
     write_log("Error in config file %s\nNORUN_STOP < NORUN_START\n", cfgfile);
@@ -26,6 +26,9 @@ extern void insert_tq_entry_wrt_need();
 extern int find_empty_impexp_slot();
 extern TQ *delete_q_rd_need_front();
 extern TQ *delete_q_wrt_need_front();
+extern time_t tapesched_rd_starve();
+extern TQ *tapesched_rd_mounted();
+extern TQ *tapesched_rd_mount();
 extern CLIENT *current_client, *clntsum, *clntdrv0, *clntdrv1;
 extern CLIENT *clntdrv2, *clntdrv3;
 extern CLIENT *clntdrv[];
@@ -170,8 +173,9 @@ void send_ack()
 /************************************************************************/
 
 /* Trys to start an entry on the rd queue.
- * Starts with the top entry of the read queue and works down to see if 
- * it can start one.
+ * First starts the next file (in tape position order) on every non-busy 
+ * drive that has a tape with entries in the rd Q. Then, if the robot is
+ * free, mounts the tape with the most entries (see tapesched.c).
  *
  *  0 = can't process entry now. remains on the q
  *  1 = an entry has been successfully started and removed from q 
@@ -182,7 +186,8 @@ void send_ack()
 int kick_next_entry_rd() {
   TQ *p, *ptmp;
   uint32_t driveback, robotback;
-  int d, e, snum, sback;
+  int d, e, snum, sback, victim;
+  time_t starve;
   char cmd[80];
   char *call_err, *tapeid;
   enum clnt_stat status;
@@ -191,89 +196,10 @@ int kick_next_entry_rd() {
   poff = NULL;
   sback = 0;
   robotback = 0;
+  /* any entry for a tape not in a slot or drive goes to the need rd Q */
   p = q_rd_front;
-  /* scan the rd Q to try to find a tape in a non-busy drive */
-  while(p) {
-    if((d=tapeindrive(p->tapeid)) != -1) {  /* tape in drive# d */
-      if(drives[d].busy || drives[d].offline) {
-        p = p->next;
-        continue;
-      }
-      //skip if drive timeout is active and not the previous uid for the drive
-      if(drives[d].to && (drives[d].sumid != p->uid)) {
-        p = p->next;
-        continue;
-      }
-      else {            //ok, can use this drive
-        if(poff) {      /* free any preceeding p. last freed elsewhere */
-          free(poff->tapeid);
-          free(poff->username);
-          freekeylist((KEY **)&poff->list);
-          free(poff);
-        }
-        setkey_int(&p->list, "dnum", d);   /* tape is in drive d */
-        poff = delete_q_rd(p);    /* remove from q */
-        write_log("*Tp:RdQdel: dsix=%lu drv=%d\n", poff->ds_index, d);
-        drives[d].busy = 1;       /* set drive busy */
-        drives[d].sumid = p->uid;
-        write_log("*Tp:DrBusy: drv=%d\n", d);
-        drives[d].tapemode = TAPE_RD_CONT;
-        if(drives[d].filenum == -1)  /* must indicate rewind to drive_svc*/
-          setkey_int(&poff->list, "tapemode", TAPE_RD_INIT);
-        else 
-          setkey_int(&poff->list, "tapemode", TAPE_RD_CONT);
-        setkey_int(&poff->list, "filenum", drives[d].filenum);
-        /* call drive[0,1]_svc and tell our caller to wait for completion */
-        write_log("kick_next_entry_rd(): clnt_call( READDRVDO ): drv=%d uid=%lu \n", d, p->uid);
-        status = clnt_call(clntdrv[d], READDRVDO, (xdrproc_t)xdr_Rkey, 
-	(char *)poff->list, (xdrproc_t)xdr_uint32_t,(char *)&driveback,TIMEOUT);
-        if(status != RPC_SUCCESS) {
-          if(status != RPC_TIMEDOUT) {  /* allow timeout? */
-            call_err = clnt_sperror(clntdrv[d], "Err clnt_call for READDRVDO");
-            drives[d].busy = 0;   /* free drive */
-            write_log("*Tp:DrNotBusy: drv=%d\n", d);
-            write_log("%s %s\n", datestring(), call_err);
-            noalrm = 0;
-            return(2);
-          } else {
-            write_log("%s timeout occured for READDRVDO drv#%d in kick_next_entry_rd()\n", datestring(), d);
-          }
-        }
-        if(driveback == 1) {
-          drives[d].busy = 0;     /* free drive */
-          write_log("*Tp:DrNotBusy: drv=%d\n", d);
-          write_log("**Error in kick_next_entry_rd() in tape_svc_proc.c\n");
-          noalrm = 0;
-          return(2);
-        }
-        sback = 1;
-        p = poff->next;
-        continue;
-      }
-    }
-    p = p->next;
-  }
-
-  /* now try for a tape not in any drive */
-  p = q_rd_front;
-  while(p) {
-    if(eeactive) {              /* import/export active, don't do this now */
-      sback = 0;
-      break;			/* break while(p) */
-    }
-    if((d=tapeindrive(p->tapeid)) != -1) {  /* tape in drive# d */
-      if(drives[d].busy || drives[d].offline) {	/* skip if busy drive */
-        p = p->next;
-        continue;
-      }
-      //skip if drive timeout is active and not the previous uid for the drive
-      if(drives[d].to && (drives[d].sumid != p->uid)) {
-        p = p->next;
-        continue;
-      }
-    }
-    /* ck if tape in any slot or drive */
-    if(((snum=tapeinslot(p->tapeid)) == -1) && (d == -1)) {
+  while(p && !eeactive) {	/* not while import/export is active */
+    if((tapeindrive(p->tapeid) == -1) && (tapeinslot(p->tapeid) == -1)) {
 #ifdef SUMDC
       /* the datacapture t50 is write oriented. needs to know this is for rd */
       write_log("*Tp:Need:Rd tapeid=%s is not in live slots\n", p->tapeid);
@@ -289,9 +215,83 @@ int kick_next_entry_rd() {
       insert_tq_entry_rd_need(ptmp); /* put at end of need rd q */
       write_log("NEED RD Q:\n");
       //rd_q_print(q_rd_need_front);	/* !!!TEMP */
-      sback = 0;
       continue;			/* see if there's more */
     }
+    p = p->next;
+  }
+  /* if an entry for an unmounted tape has waited too long, its tape is
+   * mounted next, and if no drive is free the victim drive only serves
+   * older entries until it can be given up (see tapesched.c) */
+  starve = 0;
+  victim = -1;
+  if(!eeactive) {
+    starve = tapesched_rd_starve(q_rd_front, drives, MAX_DRIVES, time(NULL),
+				&victim);
+  }
+  if(starve) {
+    write_log("Rd Q entry waiting since %ld. Drive to free=%d\n", 
+		(long)starve, victim);
+  }
+
+  /* start the next file, in tape position order, on each non-busy drive 
+   * whose tape has entries in the rd Q */
+  for(d=0; d < MAX_DRIVES; d++) {
+    if(drives[d].busy || drives[d].offline) continue;
+    if(!(p = tapesched_rd_mounted(q_rd_front, &drives[d], 
+			d == victim ? starve : 0))) continue;
+    if(poff) {      /* free any preceeding p. last freed elsewhere */
+      free(poff->tapeid);
+      free(poff->username);
+      freekeylist((KEY **)&poff->list);
+      free(poff);
+    }
+    setkey_int(&p->list, "dnum", d);   /* tape is in drive d */
+    poff = delete_q_rd(p);    /* remove from q */
+    write_log("*Tp:RdQdel: dsix=%lu drv=%d\n", poff->ds_index, d);
+    drives[d].busy = 1;       /* set drive busy */
+    drives[d].sumid = p->uid;
+    write_log("*Tp:DrBusy: drv=%d\n", d);
+    drives[d].tapemode = TAPE_RD_CONT;
+    if(drives[d].filenum == -1)  /* must indicate rewind to drive_svc*/
+      setkey_int(&poff->list, "tapemode", TAPE_RD_INIT);
+    else 
+      setkey_int(&poff->list, "tapemode", TAPE_RD_CONT);
+    setkey_int(&poff->list, "filenum", drives[d].filenum);
+    /* call drive[0,1]_svc and tell our caller to wait for completion */
+    write_log("kick_next_entry_rd(): clnt_call( READDRVDO ): drv=%d uid=%lu \n", d, p->uid);
+    status = clnt_call(clntdrv[d], READDRVDO, (xdrproc_t)xdr_Rkey, 
+	(char *)poff->list, (xdrproc_t)xdr_uint32_t,(char *)&driveback,TIMEOUT);
+    if(status != RPC_SUCCESS) {
+      if(status != RPC_TIMEDOUT) {  /* allow timeout? */
+        call_err = clnt_sperror(clntdrv[d], "Err clnt_call for READDRVDO");
+        drives[d].busy = 0;   /* free drive */
+        write_log("*Tp:DrNotBusy: drv=%d\n", d);
+        write_log("%s %s\n", datestring(), call_err);
+        noalrm = 0;
+        return(2);
+      } else {
+        write_log("%s timeout occured for READDRVDO drv#%d in kick_next_entry_rd()\n", datestring(), d);
+      }
+    }
+    if(driveback == 1) {
+      drives[d].busy = 0;     /* free drive */
+      write_log("*Tp:DrNotBusy: drv=%d\n", d);
+      write_log("**Error in kick_next_entry_rd() in tape_svc_proc.c\n");
+      noalrm = 0;
+      return(2);
+    }
+    sback = 1;
+  }
+
+  /* now mount a tape not in any drive. The one with the most (aged) 
+   * entries in the rd Q, or the starved one, starting with its lowest file# */
+  while((p = tapesched_rd_mount(q_rd_front, drives, MAX_DRIVES, starve, 
+			time(NULL)))) {
+    if(eeactive) {              /* import/export active, don't do this now */
+      sback = 0;
+      break;			/* break while(p) */
+    }
+    snum = tapeinslot(p->tapeid);
     /* try to find a free drive, first w/no tape and then not busy */
 #ifdef SUMDC
     //!!NOTE: the DCS does not have assigned wt drives.
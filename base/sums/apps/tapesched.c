@@ -0,0 +1,154 @@
+/* tapesched.c
+ * Read scheduling for tape_svc. kick_next_entry_rd() calls these to pick
+ * which rd Q entry to start next:
+ *
+ * tapesched_rd_mounted() - the next file to read from a tape already in a
+ *	drive: the queued file nearest the tape position, forward or back.
+ *	All queued files for a mounted tape are read (from any client)
+ *	before the tape is given up.
+ * tapesched_rd_mount() - which tape to mount next. The tape with the most
+ *	queued files, to get the most files read per robot move.
+ *	An entry's wait adds to its tape's count (one per TAPERDAGE secs).
+ * tapesched_rd_starve() - starvation guard. Once an entry for an unmounted
+ *	tape has waited TAPERDMAXWAIT secs, it is the next tape mounted, and
+ *	if no drive is free, the drive whose tape has the fewest entries only
+ *	serves entries older than it, so that drive is given up. Aging
+ *	normally gets a tape mounted long before this; the guard is a
+ *	backstop, as giving up a drive costs a mount.
+ *
+ * These only look at the rd Q and drives[] (passed in), so benchtapesched
+ * can replay a request log through them without tape_svc.
+*/
+
+#include <SUM.h>
+#include <tape.h>
+#include <sum_rpc.h>
+
+static int tapesched_indrive(DRIVE *drives, int ndrives, char *tapeid)
+{
+  int d;
+
+  for(d=0; d < ndrives; d++) {
+    if(drives[d].tapeid && !strcmp(drives[d].tapeid, tapeid))
+      return(d);
+  }
+  return(-1);
+}
+
+/* Return the oldest queue time of the entries in rd Q q that are for tapes
+ * not in any drive and have waited at least TAPERDMAXWAIT secs, or 0 if
+ * there are none. If there are, *victim is set to the drive that must be
+ * given up for that tape: -1 if a drive is empty or its tape has nothing 
+ * in the rd Q, else the drive whose tape has the fewest entries.
+*/
+time_t tapesched_rd_starve(TQ *q, DRIVE *drives, int ndrives, time_t now,
+			int *victim)
+{
+  TQ *p;
+  time_t starve = 0;
+  int d, cnt, mincnt = 0;
+
+  *victim = -1;
+  for(p = q; p; p = p->next) {
+    if(now - p->qtime < TAPERDMAXWAIT) continue;
+    if(starve && p->qtime >= starve) continue;
+    if(tapesched_indrive(drives, ndrives, p->tapeid) == -1)
+      starve = p->qtime;
+  }
+  if(!starve) return(0);
+
+  for(d=0; d < ndrives; d++) {
+    if(drives[d].offline) continue;
+    if(!drives[d].tapeid) {
+      *victim = -1;
+      break;
+    }
+    cnt = 0;
+    for(p = q; p; p = p->next) {
+      if(!strcmp(p->tapeid, drives[d].tapeid)) cnt++;
+    }
+    if(cnt == 0 && !drives[d].busy) {
+      *victim = -1;
+      break;
+    }
+    if(*victim == -1 || cnt < mincnt) {
+      *victim = d;
+      mincnt = cnt;
+    }
+  }
+  return(starve);
+}
+
+/* Return the rd Q entry to start next on the (not busy) drive, or NULL if
+ * there's none for its tape. That's the queued file nearest the tape
+ * position (just after drive->filenum): the lowest file# after it or the
+ * highest one before it, whichever is fewer files to space over. If the
+ * drive's timeout is active only entries for its last uid can be picked,
+ * and if starve is set only entries queued no later than starve.
+*/
+TQ *tapesched_rd_mounted(TQ *q, DRIVE *drive, time_t starve)
+{
+  TQ *fwd = NULL;
+  TQ *back = NULL;
+
+  if(!drive->tapeid) return(NULL);
+  for(; q; q = q->next) {
+    if(strcmp(q->tapeid, drive->tapeid)) continue;
+    if(drive->to && (drive->sumid != q->uid)) continue;
+    if(starve && q->qtime > starve) continue;
+    if(q->filenum > drive->filenum) {
+      if(!fwd || q->filenum < fwd->filenum) fwd = q;
+    }
+    else {
+      if(!back || q->filenum > back->filenum) back = q;
+    }
+  }
+  if(fwd && back)
+    return(fwd->filenum - drive->filenum - 1 <=
+	drive->filenum - back->filenum + 1 ? fwd : back);
+  return(fwd ? fwd : back);
+}
+
+/* Return the first rd Q entry (lowest file#) of the tape to mount next,
+ * or NULL if all queued tapes are in a drive. Only tapes not in any
+ * drive are considered. If starve is set it's the tape with the entry
+ * queued at starve. Else it's the tape with the most queued entries,
+ * where each TAPERDAGE secs its oldest entry has waited counts as one
+ * more entry.
+*/
+TQ *tapesched_rd_mount(TQ *q, DRIVE *drives, int ndrives, time_t starve, 
+			time_t now)
+{
+  TQ *p, *e, *first, *best = NULL;
+  time_t oldest;
+  double score, bestscore = 0;
+  int cnt;
+
+  for(p = q; p; p = p->next) {
+    if(tapesched_indrive(drives, ndrives, p->tapeid) != -1) continue;
+    /* skip tapes already counted (their first entry is before p) */
+    for(e = q; e != p; e = e->next) {
+      if(!strcmp(e->tapeid, p->tapeid)) break;
+    }
+    if(e != p) continue;
+    first = p;
+    oldest = p->qtime;
+    cnt = 0;
+    for(e = p; e; e = e->next) {
+      if(strcmp(e->tapeid, p->tapeid)) continue;
+      cnt++;
+      if(e->filenum < first->filenum) first = e;
+      if(e->qtime < oldest) oldest = e->qtime;
+    }
+    if(starve) {
+      if(oldest == starve) return(first);
+      continue;
+    }
+    score = cnt + (double)(now - oldest) / TAPERDAGE;
+    if(!best || score > bestscore) {
+      best = first;
+      bestscore = score;
+    }
+  }
+  return(best);
+}
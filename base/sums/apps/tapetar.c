@@ -0,0 +1,428 @@
+/* tapetar.c
+ * Writes a tar file of SU dirs to a file descriptor (a tape drive, or a file
+ * in sim mode) and computes the md5 cksum of the bytes written in the same
+ * pass. This replaces the gtar | md5filter pipe that driven_svc used to popen.
+ *
+ * A reader thread walks the dirs and fills a ring of records (blocking*512
+ * bytes each, like 'gtar -b') with tar headers and file data. The calling
+ * thread hashes each full record and writes it with a single write(), so the
+ * drive always sees full records. The output is in the GNU tar format (the
+ * gtar default, incl. ././@LongLink names), so tapes written this way are
+ * read back with gtar as before.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <pwd.h>
+#include <grp.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <openssl/md5.h>
+#include "tapetar.h"
+
+#define TT_NRECS 8		/* records in the ring */
+#define TT_BLK 512		/* tar block */
+#define TT_NAMELEN 100		/* name field of a tar header */
+
+typedef struct TapeTar_struct {
+  int recsize;
+  int cnt;
+  char **roots;
+  char **members;
+  char *ring;			/* TT_NRECS records */
+  int head;			/* next record to write */
+  int tail;			/* record being filled */
+  int nfull;			/* filled records not yet written */
+  int fill;			/* bytes in the record being filled */
+  int done;			/* reader is finished */
+  int abort;			/* writer failed - reader must stop */
+  int rstatus;			/* reader status, 0 = ok */
+  uint64_t nfiles;
+  double writewait;
+  uid_t uid;			/* last uid/gid looked up */
+  gid_t gid;
+  char uname[32];
+  char gname[32];
+  char errmsg[256];
+  pthread_mutex_t mutex;
+  pthread_cond_t full;		/* a record was filled */
+  pthread_cond_t empty;		/* a record was written */
+} TapeTar_t;
+
+static double tt_now()
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return(tv.tv_sec + tv.tv_usec / 1.0e6);
+}
+
+static void tt_error(TapeTar_t *tt, const char *fmt, const char *path, int err)
+{
+  if(tt->rstatus == 0) {
+    snprintf(tt->errmsg, sizeof(tt->errmsg), fmt, path, strerror(err));
+    tt->rstatus = -1;
+  }
+}
+
+/* Hand the record being filled to the writer and wait for a free one.
+ * Return -1 if the writer has failed.
+*/
+static int tt_nextrec(TapeTar_t *tt)
+{
+  double t0;
+  int ret;
+
+  pthread_mutex_lock(&tt->mutex);
+  tt->nfull++;
+  tt->tail = (tt->tail + 1) % TT_NRECS;
+  tt->fill = 0;
+  pthread_cond_signal(&tt->full);
+  t0 = tt_now();
+  while(tt->nfull == TT_NRECS && !tt->abort)
+    pthread_cond_wait(&tt->empty, &tt->mutex);
+  tt->writewait += tt_now() - t0;
+  ret = tt->abort ? -1 : 0;
+  pthread_mutex_unlock(&tt->mutex);
+  return(ret);
+}
+
+/* Append len bytes (zeros if buf is NULL) to the stream. */
+static int tt_put(TapeTar_t *tt, const char *buf, size_t len)
+{
+  char *rec;
+  size_t n;
+
+  while(len > 0) {
+    rec = tt->ring + (size_t)tt->tail * tt->recsize;
+    n = tt->recsize - tt->fill;
+    if(n > len) n = len;
+    if(buf) {
+      memcpy(rec + tt->fill, buf, n);
+      buf += n;
+    }
+    else
+      memset(rec + tt->fill, 0, n);
+    tt->fill += n;
+    len -= n;
+    if(tt->fill == tt->recsize && tt_nextrec(tt))
+      return(-1);
+  }
+  return(0);
+}
+
+/* Append size bytes of the open file fd, then pad to a full tar block.
+ * The data is read straight into the ring. If the file shrank while being
+ * read, the rest is zero filled (as gtar does) and it is an error.
+*/
+static int tt_putfile(TapeTar_t *tt, int fd, uint64_t size, const char *path)
+{
+  char *rec;
+  uint64_t left = size;
+  ssize_t n;
+  size_t want;
+
+  while(left > 0) {
+    rec = tt->ring + (size_t)tt->tail * tt->recsize;
+    want = tt->recsize - tt->fill;
+    if(want > left) want = left;
+    n = read(fd, rec + tt->fill, want);
+    if(n <= 0) {
+      if(n == -1 && errno == EINTR) continue;
+      tt_error(tt, "Error reading %s: %s", path, n == 0 ? EIO : errno);
+      return(tt_put(tt, NULL, left + (TT_BLK - size % TT_BLK) % TT_BLK));
+    }
+    tt->fill += n;
+    left -= n;
+    if(tt->fill == tt->recsize && tt_nextrec(tt))
+      return(-1);
+  }
+  return(tt_put(tt, NULL, (TT_BLK - size % TT_BLK) % TT_BLK));
+}
+
+/* Octal number field of len bytes, NUL terminated. A value too big for
+ * a 12 byte field (files >= 8GB) is stored in GNU base-256.
+*/
+static void tt_octal(char *field, int len, uint64_t val)
+{
+  int i;
+
+  if(len == 12 && val > 077777777777ULL) {
+    field[0] = (char)0x80;
+    for(i = len - 1; i > 0; i--, val >>= 8)
+      field[i] = (char)(val & 0xff);
+    return;
+  }
+  field[len - 1] = 0;
+  for(i = len - 2; i >= 0; i--, val >>= 3)
+    field[i] = '0' + (val & 7);
+}
+
+static void tt_names(TapeTar_t *tt, struct stat *sb)
+{
+  struct passwd *pw;
+  struct group *gr;
+
+  if(tt->uname[0] == 0 || sb->st_uid != tt->uid) {
+    tt->uid = sb->st_uid;
+    pw = getpwuid(sb->st_uid);
+    snprintf(tt->uname, sizeof(tt->uname), "%s", pw ? pw->pw_name : "");
+  }
+  if(tt->gname[0] == 0 || sb->st_gid != tt->gid) {
+    tt->gid = sb->st_gid;
+    gr = getgrgid(sb->st_gid);
+    snprintf(tt->gname, sizeof(tt->gname), "%s", gr ? gr->gr_name : "");
+  }
+}
+
+/* Fill in hdr and append it. */
+static int tt_puthdr(TapeTar_t *tt, char *hdr, const char *name, int type,
+			struct stat *sb, uint64_t size, const char *link)
+{
+  unsigned int sum = 0;
+  int i;
+
+  strncpy(hdr, name, TT_NAMELEN);
+  tt_octal(hdr + 100, 8, sb ? sb->st_mode & 07777 : 0);
+  tt_octal(hdr + 108, 8, sb ? sb->st_uid : 0);
+  tt_octal(hdr + 116, 8, sb ? sb->st_gid : 0);
+  tt_octal(hdr + 124, 12, size);
+  tt_octal(hdr + 136, 12, sb ? sb->st_mtime : 0);
+  hdr[156] = type;
+  if(link)
+    strncpy(hdr + 157, link, TT_NAMELEN);
+  memcpy(hdr + 257, "ustar  ", 8);	/* GNU magic + version */
+  if(sb) {
+    tt_names(tt, sb);
+    strncpy(hdr + 265, tt->uname, 32);
+    strncpy(hdr + 297, tt->gname, 32);
+  }
+  memset(hdr + 148, ' ', 8);
+  for(i = 0; i < TT_BLK; i++)
+    sum += (unsigned char)hdr[i];
+  snprintf(hdr + 148, 7, "%06o", sum);	/* 6 digits, NUL, space */
+  return(tt_put(tt, hdr, TT_BLK));
+}
+
+/* Append a GNU long name (type 'L') or long link (type 'K') entry. */
+static int tt_putlong(TapeTar_t *tt, int type, const char *name)
+{
+  char hdr[TT_BLK];
+  size_t len = strlen(name) + 1;
+
+  memset(hdr, 0, TT_BLK);
+  if(tt_puthdr(tt, hdr, "././@LongLink", type, NULL, len, NULL))
+    return(-1);
+  if(tt_put(tt, name, len))
+    return(-1);
+  return(tt_put(tt, NULL, (TT_BLK - len % TT_BLK) % TT_BLK));
+}
+
+static int tt_entry(TapeTar_t *tt, const char *name, int type,
+			struct stat *sb, uint64_t size, const char *link)
+{
+  char hdr[TT_BLK];
+
+  if(strlen(name) > TT_NAMELEN && tt_putlong(tt, 'L', name))
+    return(-1);
+  if(link && strlen(link) > TT_NAMELEN && tt_putlong(tt, 'K', link))
+    return(-1);
+  memset(hdr, 0, TT_BLK);
+  tt->nfiles++;
+  return(tt_puthdr(tt, hdr, name, type, sb, size, link));
+}
+
+/* Archive path (a file, symlink or dir and all below it). Its name in the
+ * archive is path+namepos. path is a PATH_MAX buffer that is extended in
+ * place while walking the tree. Return -1 only if the writer failed; other
+ * errors are kept in tt->rstatus and the walk goes on, like gtar does.
+*/
+static int tt_walk(TapeTar_t *tt, char *path, int namepos)
+{
+  struct stat sb;
+  struct dirent **list;
+  char link[PATH_MAX];
+  int len, nent, i, fd, ret = 0;
+  ssize_t n;
+
+  if(lstat(path, &sb)) {
+    tt_error(tt, "Can't stat %s: %s", path, errno);
+    return(0);
+  }
+  if(S_ISREG(sb.st_mode)) {
+    if((fd = open(path, O_RDONLY)) == -1) {
+      tt_error(tt, "Can't open %s: %s", path, errno);
+      return(0);
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    if(!(ret = tt_entry(tt, path + namepos, '0', &sb, sb.st_size, NULL)))
+      ret = tt_putfile(tt, fd, sb.st_size, path);
+    close(fd);
+    return(ret);
+  }
+  if(S_ISLNK(sb.st_mode)) {
+    if((n = readlink(path, link, sizeof(link) - 1)) == -1) {
+      tt_error(tt, "Can't readlink %s: %s", path, errno);
+      return(0);
+    }
+    link[n] = 0;
+    return(tt_entry(tt, path + namepos, '2', &sb, 0, link));
+  }
+  if(!S_ISDIR(sb.st_mode))
+    return(0);			/* gtar also skips sockets etc. */
+
+  len = strlen(path);
+  if(len + 2 >= PATH_MAX) {
+    tt_error(tt, "Path too long %s: %s", path, ENAMETOOLONG);
+    return(0);
+  }
+  path[len] = '/';		/* dir names end in '/' */
+  path[len + 1] = 0;
+  ret = tt_entry(tt, path + namepos, '5', &sb, 0, NULL);
+  path[len] = 0;
+  if(ret) return(ret);
+
+  if((nent = scandir(path, &list, NULL, alphasort)) == -1) {
+    tt_error(tt, "Can't read dir %s: %s", path, errno);
+    return(0);
+  }
+  for(i = 0; i < nent; i++) {
+    if(!ret && strcmp(list[i]->d_name, ".") && strcmp(list[i]->d_name, "..")) {
+      if(len + 1 + strlen(list[i]->d_name) >= PATH_MAX)
+        tt_error(tt, "Path too long %s: %s", path, ENAMETOOLONG);
+      else {
+        sprintf(path + len, "/%s", list[i]->d_name);
+        ret = tt_walk(tt, path, namepos);
+        path[len] = 0;
+      }
+    }
+    free(list[i]);
+  }
+  free(list);
+  return(ret);
+}
+
+static void *tt_reader(void *arg)
+{
+  TapeTar_t *tt = (TapeTar_t *)arg;
+  char path[PATH_MAX];
+  int i, ret = 0;
+
+  for(i = 0; i < tt->cnt && !ret; i++) {
+    if(snprintf(path, sizeof(path), "%s/%s", tt->roots[i], tt->members[i]) >= sizeof(path)) {
+      tt_error(tt, "Path too long %s: %s", tt->members[i], ENAMETOOLONG);
+      continue;
+    }
+    ret = tt_walk(tt, path, strlen(tt->roots[i]) + 1);
+  }
+  /* end of archive is two zero blocks, then pad out the last record */
+  if(!ret && !(ret = tt_put(tt, NULL, 2 * TT_BLK)) && tt->fill > 0)
+    tt_put(tt, NULL, tt->recsize - tt->fill);
+
+  pthread_mutex_lock(&tt->mutex);
+  tt->done = 1;
+  pthread_cond_signal(&tt->full);
+  pthread_mutex_unlock(&tt->mutex);
+  return(NULL);
+}
+
+int tapetar_write(int fd, int blocking, int cnt, char **roots, char **members,
+			TapeTarStat_t *stat)
+{
+  TapeTar_t tt;
+  pthread_t reader;
+  MD5_CTX md5ctx;
+  unsigned char md5val[16];
+  double start, t0;
+  char *rec;
+  ssize_t n;
+  size_t off;
+  int i, status = 0;
+
+  start = tt_now();
+  memset(stat, 0, sizeof(TapeTarStat_t));
+  memset(&tt, 0, sizeof(tt));
+  tt.recsize = blocking * TT_BLK;
+  tt.cnt = cnt;
+  tt.roots = roots;
+  tt.members = members;
+  if(!(tt.ring = (char *)malloc((size_t)TT_NRECS * tt.recsize))) {
+    snprintf(stat->errmsg, sizeof(stat->errmsg), "Can't malloc %d records of %d bytes", TT_NRECS, tt.recsize);
+    return(-1);
+  }
+  pthread_mutex_init(&tt.mutex, NULL);
+  pthread_cond_init(&tt.full, NULL);
+  pthread_cond_init(&tt.empty, NULL);
+  if(pthread_create(&reader, NULL, tt_reader, &tt)) {
+    snprintf(stat->errmsg, sizeof(stat->errmsg), "Can't start the reader thread");
+    status = -1;
+    goto out;
+  }
+
+  MD5_Init(&md5ctx);
+  while(1) {
+    pthread_mutex_lock(&tt.mutex);
+    t0 = tt_now();
+    while(tt.nfull == 0 && !tt.done)
+      pthread_cond_wait(&tt.full, &tt.mutex);
+    stat->readwait += tt_now() - t0;
+    if(tt.nfull == 0) {		/* reader done */
+      pthread_mutex_unlock(&tt.mutex);
+      break;
+    }
+    rec = tt.ring + (size_t)tt.head * tt.recsize;
+    pthread_mutex_unlock(&tt.mutex);
+
+    MD5_Update(&md5ctx, rec, tt.recsize);
+    for(off = 0; off < tt.recsize; off += n) {
+      if((n = write(fd, rec + off, tt.recsize - off)) == -1) {
+        if(errno == EINTR) { n = 0; continue; }
+        snprintf(stat->errmsg, sizeof(stat->errmsg), "Write failed after %llu bytes: %s", (unsigned long long)stat->bytes, strerror(errno));
+        status = -1;
+        break;
+      }
+    }
+
+    pthread_mutex_lock(&tt.mutex);
+    if(status) {
+      tt.abort = 1;
+    }
+    else {
+      stat->bytes += tt.recsize;
+      tt.head = (tt.head + 1) % TT_NRECS;
+      tt.nfull--;
+    }
+    pthread_cond_signal(&tt.empty);
+    pthread_mutex_unlock(&tt.mutex);
+    if(status) break;
+  }
+  pthread_join(reader, NULL);
+  MD5_Final(md5val, &md5ctx);
+
+  if(!status && tt.rstatus) {
+    snprintf(stat->errmsg, sizeof(stat->errmsg), "%s", tt.errmsg);
+    status = -1;
+  }
+  for(i = 0; i < 16; i++)
+    sprintf(stat->md5str + 2*i, "%02x", md5val[i]);
+  stat->nfiles = tt.nfiles;
+  stat->writewait = tt.writewait;
+
+out:
+  pthread_cond_destroy(&tt.empty);
+  pthread_cond_destroy(&tt.full);
+  pthread_mutex_destroy(&tt.mutex);
+  free(tt.ring);
+  stat->seconds = tt_now() - start;
+  return(status);
+}
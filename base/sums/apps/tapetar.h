@@ -0,0 +1,29 @@
+/* tapetar.h
+ * In-process replacement for 'gtar -cf - -b GTARBLOCK | md5filter' used by
+ * driven_svc to write SU directories to tape. See tapetar.c.
+*/
+#ifndef __TAPETAR_H
+#define __TAPETAR_H
+
+#include <stdint.h>
+
+/* What tapetar_write() did */
+typedef struct TapeTarStat_struct {
+  uint64_t bytes;	/* bytes written, incl. the padding of the last record */
+  uint64_t nfiles;	/* files, dirs and symlinks archived */
+  double seconds;	/* wall time */
+  double readwait;	/* secs the writer waited for the reader */
+  double writewait;	/* secs the reader waited for the writer */
+  char md5str[33];	/* md5 cksum (hex) of the bytes written */
+  char errmsg[256];	/* why tapetar_write() returned -1 */
+} TapeTarStat_t;
+
+/* Write a tar file of members[i] (relative to dir roots[i]), i = 0 to cnt-1,
+ * to fd in records of blocking*512 bytes. Same as
+ * 'gtar -cf - -b blocking -C roots[0] members[0] -C roots[1] ...'.
+ * Returns 0 on success, else -1 (see stat->errmsg).
+*/
+int tapetar_write(int fd, int blocking, int cnt, char **roots, char **members,
+			TapeTarStat_t *stat);
+
+#endif
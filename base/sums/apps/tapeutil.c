@@ -276,6 +276,7 @@ TQ *q_entry_make(KEY *list, SUMID_t uid, char *tapeid, int filenum,
     p->tapeid = strdup(tapeid);
     p->username = strdup(user);
     p->filenum = filenum;
+    p->qtime = time(NULL);
     p->list = newkeylist();
     add_keys(list, &p->list);	/* NOTE:does not do fileptr */
     /* must explicitly put in this fileptr if present */
@@ -311,8 +312,8 @@ void tq_entry_rd_dump2() {	//See NOTE: above
 }
 
 /* Put in rd Q in ascending file number order. Note: the tapeid
- * order doesn't matter as once a tape gets in a drive, the entire
- * rd Q is scanned for any other files from that tape. 
+ * order doesn't matter as kick_next_entry_rd() picks the tape to mount
+ * and the order to read its files in (see tapesched.c). 
 */
 void insert_tq_entry_rd_sort(TQ *p) {
   TQ *qprev = q_rd_front;
@@ -54,6 +54,16 @@
  *    void	addkey (KEY **list, char *key, void *val, int type)
  *	add value associated with key name 
  *	with NO check for duplicate key
+ *    void	freekeyidx (KEY *node)
+ *	free the hash index kept on node (by xdr_Rkey() for decoded lists)
+ *
+ *  A list that findkey() has to walk KEYIDX_MIN keys of gets a hash index
+ *    of its key names, kept on its first node (KEY.idx). setkey_any(),
+ *    addkey() and deletekey() keep the index of the list up to date (and
+ *    move it to the new first node), so findkey() and all the getkey_ and
+ *    setkey_ functions on a long list (e.g. the dsix_0..dsix_N of a SUMS
+ *    request) don't walk it. The list itself and its order are as before.
+ *    The list must only be changed with these functions.
  *
  *  There is also an internal support function key_strdup analogous to the
  *    System V strdup function.
@@ -82,11 +92,80 @@
 #include <soi_key.h>
 #include <soi_error.h>
 #include "SUM.h"
+#include "uthash.h"
 
 #define VERSION_NUM	(4.5)
+#define KEYIDX_MIN	(16)	/* index a list when findkey() walks this many */
 
 int kludge = 2;		/* workaround for malloc / alignment problem */
 
+/* Hash index of a key-list (uthash, as keyU.c): one per name in the list */
+struct keyidx {
+  KEY *key;			/* first node in the list w/the name */
+  UT_hash_handle hh;		/* keyed on key->name */
+};
+
+	   /*  make node the one found for its name, or only if there's none  */
+static void keyidx_put (struct keyidx **idx, KEY *node, int replace) {
+  struct keyidx *ent = NULL;
+
+  HASH_FIND_STR (*idx, node->name, ent);
+  if (ent) {
+    if (!replace) return;
+    HASH_DEL (*idx, ent);		/*  its hash key is the old name  */
+  }
+  else if (!(ent = (struct keyidx *)malloc (sizeof (struct keyidx))))
+    return;
+  ent->key = node;
+  HASH_ADD_KEYPTR (hh, *idx, node->name, strlen (node->name), ent);
+}
+
+		      /*  node (w/name) is gone, the next one is dup or none  */
+static void keyidx_del (struct keyidx **idx, KEY *node, KEY *dup) {
+  struct keyidx *ent = NULL;
+
+  HASH_FIND_STR (*idx, node->name, ent);
+  if (!ent || ent->key != node) return;
+  HASH_DEL (*idx, ent);
+  if (dup) {
+    ent->key = dup;
+    HASH_ADD_KEYPTR (hh, *idx, dup->name, strlen (dup->name), ent);
+  }
+  else
+    free (ent);
+}
+
+static void keyidx_make (KEY *list) {
+  struct keyidx *idx = NULL;
+  KEY *walker;
+
+  for (walker = list; walker; walker = walker->next)
+    keyidx_put (&idx, walker, 0);
+  list->idx = idx;
+}
+
+		 /*  new_one was put in front of the list, give it the index  */
+static void keyidx_push (KEY *new_one) {
+  KEY *old_head = new_one->next;
+
+  new_one->idx = NULL;
+  if (!old_head || !old_head->idx) return;
+  new_one->idx = old_head->idx;
+  old_head->idx = NULL;
+  keyidx_put (&new_one->idx, new_one, 1);
+}
+
+void freekeyidx (KEY *node) {
+  struct keyidx *ent, *tmp;
+
+  if (!node) return;
+  HASH_ITER (hh, node->idx, ent, tmp) {
+    HASH_DEL (node->idx, ent);
+    free (ent);
+  }
+  node->idx = NULL;
+}
+
 KEY *newkeylist () {
    return NULL;
 }
@@ -96,6 +175,7 @@ void freekeylist (KEY **list) {
    while (*list) {
       free ((*list)->name);
       free ((*list)->val);
+      freekeyidx (*list);
       node = *list;
       *list = (*list)->next;
       free (node);
@@ -104,19 +184,32 @@ void freekeylist (KEY **list) {
 
 KEY *findkey (KEY *list, char *key) {
   KEY *walker = list;
+  int n = 0;
 
   soi_errno = NO_ERROR;
   if (!key) {
     soi_errno = KEY_NOT_FOUND;
     return NULL;
   }
+  if (list && list->idx) {
+    struct keyidx *ent = NULL;
+    HASH_FIND_STR (list->idx, key, ent);
+    if (ent)
+      return ent->key;
+    soi_errno = KEY_NOT_FOUND;
+    return NULL;
+  }
   while (walker) {
-    if (strcmp (walker->name, key)) 
+    if (strcmp (walker->name, key)) {
       walker = walker->next;
-    else 
-      return walker;
+      n++;
+    } else 
+      break;
   }
-  soi_errno = KEY_NOT_FOUND;
+  if (n >= KEYIDX_MIN)		      /*  long list, don't walk it again  */
+    keyidx_make (list);
+  if (!walker)
+    soi_errno = KEY_NOT_FOUND;
   return walker;
 }
 
@@ -187,6 +280,7 @@ void setkey_any (KEY **list, char *key, void *val, int type) {
       new_one = (KEY *)malloc (kludge*sizeof (KEY));
       new_one->next = *list;
       new_one->name = key_strdup (key);
+      keyidx_push (new_one);
       *list = new_one;
       the_one = new_one;
    }
@@ -272,6 +366,7 @@ void addkey (KEY **list, char *key, void *val, int type) {
    new_one->next = *list;
    new_one->name = key_strdup (key);
    new_one->type = type;
+   keyidx_push (new_one);
    *list = new_one;
 
    switch (type) {
@@ -347,6 +442,7 @@ void addkey (KEY **list, char *key, void *val, int type) {
 void deletekey (KEY **list, char *key) {
    KEY *walker = *list;
    KEY *trailer = NULL;
+   KEY *dup, *indexed;
 
    if (!key) return;
 
@@ -355,12 +451,25 @@ void deletekey (KEY **list, char *key) {
          trailer = walker;
          walker = walker->next;
       } else {
+			 /*  fix the indexes on it and the nodes before it  */
+         for (dup = walker->next; dup && strcmp (dup->name, key);
+             dup = dup->next);
+         for (indexed = *list; indexed != walker; indexed = indexed->next)
+            if (indexed->idx) keyidx_del (&indexed->idx, walker, dup);
+         if (walker->idx) {
+            keyidx_del (&walker->idx, walker, dup);
+            if (walker->next && !walker->next->idx) {
+               walker->next->idx = walker->idx;
+               walker->idx = NULL;
+            }
+         }
          if (trailer)			       /* key is not at head of list */
             trailer->next = walker->next;
          else					   /* key is at head of list */
             *list = walker->next;
          free (walker->name);
          free (walker->val);
+         freekeyidx (walker);
          free (walker);
          walker = NULL;
       }
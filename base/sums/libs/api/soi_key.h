@@ -7,6 +7,8 @@
  *    name	Pointer to a null terminated string of characters
  *    val	Pointer to a datum of arbitrary type
  *    type	Code for type of data
+ *    idx	Hash index of the list from this node on, kept by key.c
+ *		(NULL until the list is long). Not sent by xdr_Rkey().
  *
  *  The following functions are provided for manipulation of key lists:
  *	getkeytype (list, name)
@@ -86,6 +88,7 @@ typedef struct key {
   char		*name;
   int		type;
   void		*val;
+  struct keyidx	*idx;
 } KEY;
 
 /****************************************************************************/
@@ -122,6 +125,7 @@ typedef struct key {
 extern void deletekey (KEY **list, char *key);
 extern KEY *findkey (KEY *list, char *key);
 extern void freekeylist (KEY **list);
+extern void freekeyidx (KEY *node);
 extern int getkeytype (KEY *list, char *key);
 extern void getkey_any (KEY *list, char *key, void *valptr);
 extern char *GETKEY_str(KEY *params, char *key);
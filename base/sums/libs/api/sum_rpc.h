@@ -129,6 +129,7 @@ bool_t xdr_keyseg(XDR *xdrs, keyseg *objp);
 struct Rkey {
         struct Rkey *next;
 	keyseg key_segment;
+	struct keyidx *idx;	/* not sent, see KEY */
 };
 typedef struct Rkey Rkey;
 bool_t xdr_Rkey(XDR *xdrs, Rkey *objp);
@@ -709,6 +710,7 @@ struct tq {
   char *tapeid;
   char *username;
   int filenum;
+  time_t qtime;		/* when queued (for aging of rd Q entries) */
 };
 typedef struct tq TQ;
 
@@ -747,6 +749,18 @@ struct partition {
 };
 typedef struct partition PART;
 
+/* What the rmdirs_*() threads removed (see rmdirs.c) */
+struct rmstat {
+  uint64_t bytes;	/* bytes freed */
+  uint64_t files;	/* files and symlinks unlinked */
+  uint64_t dirs;	/* dirs removed */
+  int sus;		/* wd's removed */
+  int errs;		/* wd's not (all) removed */
+  char errwd[MAXSTR];	/* the first of them */
+  double seconds;	/* from the first rmdirs_queue() to rmdirs_wait() */
+};
+typedef struct rmstat RmStat_t;
+
 /* Pe/uid assignment table. One of these is put onto the peuid_hdr pointer
  * each time a pe registers (opens) with dsds_svc, and removed when pe
  * deregisters (closes).
@@ -825,7 +839,11 @@ int DS_RmNow(char *wd, uint64_t sumid, double bytes, char *effdate, uint64_t ds_
 int DS_RmDoX(char *name, double bytesdel);
 int DS_RmNowX(char *wd, uint64_t sumid, double bytes, char *effdate, uint64_t ds_index, int archsub, double *rmbytes);
 int DS_Rm_Commit(void);
+int DS_RmFlushX(void);
 int rmdirs(char *wd, char *root);
+int rmdirs_start(int nthreads, int opspersec);
+int rmdirs_queue(char *wd, char *root);
+void rmdirs_wait(RmStat_t *stat);
 int SUM_Main_Update (KEY *params, KEY **results);
 //int SUM_Main_Update (KEY *params);
 int SUMLIB_Close(KEY *params);
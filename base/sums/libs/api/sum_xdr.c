@@ -117,6 +117,8 @@ xdr_Rkey(xdrs, objp)
   if(!xdr_keyseg(xdrs, &objp->key_segment)) {
     return(FALSE);
   }
+  if(xdrs->x_op == XDR_FREE)	/* index made by findkey() on a decoded list */
+    freekeyidx((KEY *)objp);
   return(TRUE);
 }
 
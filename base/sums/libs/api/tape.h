@@ -95,6 +95,13 @@
 #define TAPE_RD_INIT 1	/* tape just loaded for a read */
 #define TAPE_RD_CONT 2	/* subsequent tape read. filenum now valid */
 
+/* rd Q aging (see tapesched.c): each TAPERDAGE secs an entry waits counts
+ * as one more entry for its tape, and after TAPERDMAXWAIT secs its tape is
+ * mounted next, even if a drive must be given up for it. Tuned with
+ * benchtapesched; a shorter TAPERDMAXWAIT makes drives thrash when few */
+#define TAPERDAGE 3600
+#define TAPERDMAXWAIT 172800
+
 /* closed values in TAPE struct for writting status */
 /* NOTE: if change here check use in libSUM.d sql */
 #define TAPEUNINIT -1	/* tape uninitialized (no file 0 label) */
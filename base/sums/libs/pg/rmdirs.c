@@ -1,46 +1,289 @@
-/* Clean up starting at the directory given. Removes this directory and then 
+/* Clean up starting at the directory given. Removes this directory and then
  * moves up one directory and if there are no subdirs here then will delete it.
- * This continues until we find a subdir or until we get to the top of the 
+ * This continues until we find a subdir or until we get to the top of the
  * dsds assigned storage root which is given in the second argument.
  * The given directory name (wd) can end in a slash (/) or not.
  * Returns 1 if error on removing any directory.
+ *
+ * The tree is removed in-process with openat()/unlinkat() (symlinks are
+ * removed, never followed). sum_rm also uses the rmdirs_*() pool below to
+ * remove many dirs at once:
+ *
+ * rmdirs_start() - start nthreads removal threads. Deletion is limited to
+ *	opspersec unlinks+rmdirs a second (0 = no limit) so it doesn't take
+ *	all the i/o of the partitions from the SUMS clients.
+ * rmdirs_queue() - queue a dir for rmdirs(wd, root) by the threads. There is
+ *	a queue for each partition and a free thread takes from the one with
+ *	the fewest threads on it, so all the partitions are removed in parallel.
+ * rmdirs_wait() - wait for the queued dirs to be removed, and return the
+ *	bytes freed, etc. since the last rmdirs_wait().
 */
 #include <dirent.h>
 #include <strings.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/time.h>
 #include <SUM.h>
+#include <sum_rpc.h>
 
-int rmdirs(char *wd, char *root)
+#define RMDIRS_MAXTHREADS 32
+
+typedef struct rmdirs_job {
+  struct rmdirs_job *next;
+  char wd[MAXSTR];
+  char root[MAXSTR];
+} RMJOB;
+
+typedef struct rmdirs_part {
+  char root[MAXSTR];		/* the partition, e.g. /SUM1 */
+  RMJOB *front, *rear;
+  int active;			/* # threads removing from this partition */
+} RMPART;
+
+static pthread_mutex_t rm_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rm_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t rm_done = PTHREAD_COND_INITIALIZER;
+static pthread_t rm_threads[RMDIRS_MAXTHREADS];
+static RMPART rm_parts[MAX_PART];
+static int rm_nparts = 0;
+static int rm_nthreads = 0;
+static int rm_pending = 0;		/* queued + being removed */
+static double rm_opsec = 0.0;		/* ops/sec limit, 0 = none */
+static double rm_nextop = 0.0;		/* time the next op may start */
+static RmStat_t rm_stat;
+static double rm_t0 = 0.0;		/* time of first queue since wait */
+
+static double rmdirs_now()
 {
-  char *cptr;
-  int i;
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return((double)tv.tv_sec + (double)tv.tv_usec / 1.0e6);
+}
+
+/* Wait for our turn to do one unlink or rmdir, if rate limited */
+static void rmdirs_throttle()
+{
+  double now, t;
+
+  if(rm_opsec <= 0.0) return;
+  pthread_mutex_lock(&rm_mutex);
+  now = rmdirs_now();
+  t = rm_nextop > now ? rm_nextop : now;
+  rm_nextop = t + 1.0 / rm_opsec;
+  pthread_mutex_unlock(&rm_mutex);
+  if(t > now) usleep((useconds_t)((t - now) * 1.0e6));
+}
+
+/* Remove name in dir dfd, and everything under it if it's a dir. Adds what
+ * was freed to *st. Returns 1 if anything couldn't be removed.
+*/
+static int rmdirs_tree(int dfd, const char *name, RmStat_t *st)
+{
+  struct stat sbuf;
+  struct dirent *dp;
   DIR *dirp;
+  int fd, status = 0;
+
+  if(fstatat(dfd, name, &sbuf, AT_SYMLINK_NOFOLLOW))
+    return(errno != ENOENT);
+  if(!S_ISDIR(sbuf.st_mode)) {
+    rmdirs_throttle();
+    if(unlinkat(dfd, name, 0))
+      return(errno != ENOENT);
+    st->files++;
+    if(sbuf.st_nlink <= 1) st->bytes += (uint64_t)sbuf.st_blocks * 512;
+    return(0);
+  }
+  if((fd = openat(dfd, name, O_RDONLY|O_DIRECTORY|O_NOFOLLOW)) == -1)
+    return(errno != ENOENT);
+  if(!(dirp = fdopendir(fd))) {
+    close(fd);
+    return(1);
+  }
+  while((dp = readdir(dirp))) {
+    if(!strcmp(dp->d_name, ".") || !strcmp(dp->d_name, "..")) continue;
+    status |= rmdirs_tree(fd, dp->d_name, st);
+  }
+  closedir(dirp);		/* closes fd */
+  rmdirs_throttle();
+  if(unlinkat(dfd, name, AT_REMOVEDIR))
+    return(errno != ENOENT);
+  st->dirs++;
+  st->bytes += (uint64_t)sbuf.st_blocks * 512;
+  return(status);
+}
+
+static int rmdirs_x(char *wd, char *root, RmStat_t *st)
+{
+  char *cptr;
   char rmstr[MAXSTR];
-  char rmcmd[MAXSTR];
 
   strcpy(rmstr, wd);
-  if(!(cptr=(char *)rindex(rmstr, '/'))) 
+  if(!(cptr=(char *)rindex(rmstr, '/')))
     return(1);
   if(!strcmp(cptr+1, ""))		/* wd ends in a slash */
     *cptr=(char)NULL;			/* remove the slash */
-  sprintf(rmcmd, "rm -rf %s\n", rmstr);
-  if(system(rmcmd))
+  if(rmdirs_tree(AT_FDCWD, rmstr, st))
     return(1);
   cptr=(char *)rindex(rmstr, '/');	/* next directory up */
   *cptr=(char)NULL;
   while(strstr(rmstr, root)) {
-    if(!(dirp=opendir(rmstr))) return(1);
-    i=0;
-    while(readdir(dirp)) i++;
-    closedir(dirp);
-    if(i == 2) {			/* no subdir. ok to rmdir */
-      sprintf(rmcmd, "rm -rf %s\n", rmstr);
-      if(system(rmcmd))
-        return(1);
+    rmdirs_throttle();
+    if(rmdir(rmstr)) {			/* fails if any subdir left */
+      if(errno == ENOTEMPTY || errno == EEXIST) break;
+      if(errno != ENOENT) return(1);	/* ENOENT: another thread did it */
     }
     else
-      break;
+      st->dirs++;
     cptr=(char *)rindex(rmstr, '/');	/* next directory up */
     *cptr=(char)NULL;
   }
   return(0);
 }
+
+int rmdirs(char *wd, char *root)
+{
+  RmStat_t st;
+
+  memset(&st, 0, sizeof(st));
+  return(rmdirs_x(wd, root, &st));
+}
+
+/* Return the queue for the partition of wd (the part up to /Dnnn) */
+static RMPART *rmdirs_part(char *wd)
+{
+  char part[MAXSTR];
+  char *cptr;
+  int i;
+
+  strcpy(part, wd);
+  if((cptr = strstr(part+1, "/D"))) *cptr = (char)NULL;
+  for(i=0; i < rm_nparts; i++) {
+    if(!strcmp(rm_parts[i].root, part)) return(&rm_parts[i]);
+  }
+  if(rm_nparts == MAX_PART) return(&rm_parts[0]);
+  strcpy(rm_parts[rm_nparts].root, part);
+  return(&rm_parts[rm_nparts++]);
+}
+
+/* Add what one rmdirs_x() did to rm_stat (rm_mutex held) */
+static void rmdirs_add(char *wd, int status, RmStat_t *st)
+{
+  rm_stat.bytes += st->bytes;
+  rm_stat.files += st->files;
+  rm_stat.dirs += st->dirs;
+  if(status) {
+    if(!rm_stat.errs) strcpy(rm_stat.errwd, wd);
+    rm_stat.errs++;
+  }
+  else
+    rm_stat.sus++;
+}
+
+static void *rmdirs_thread(void *arg)
+{
+  RMPART *part;
+  RMJOB *job;
+  RmStat_t st;
+  int i, status;
+
+  pthread_mutex_lock(&rm_mutex);
+  for(;;) {
+    part = NULL;
+    for(i=0; i < rm_nparts; i++) {	/* least busy partition w/work */
+      if(!rm_parts[i].front) continue;
+      if(!part || rm_parts[i].active < part->active) part = &rm_parts[i];
+    }
+    if(!part) {
+      pthread_cond_wait(&rm_work, &rm_mutex);
+      continue;
+    }
+    job = part->front;
+    if(!(part->front = job->next)) part->rear = NULL;
+    part->active++;
+    pthread_mutex_unlock(&rm_mutex);
+
+    memset(&st, 0, sizeof(st));
+    status = rmdirs_x(job->wd, job->root, &st);
+
+    pthread_mutex_lock(&rm_mutex);
+    part->active--;
+    rmdirs_add(job->wd, status, &st);
+    free(job);
+    if(--rm_pending == 0) pthread_cond_broadcast(&rm_done);
+  }
+  return(NULL);
+}
+
+/* Start nthreads threads for rmdirs_queue(). Returns 1 if none started,
+ * and then rmdirs_queue() removes the dir itself.
+*/
+int rmdirs_start(int nthreads, int opspersec)
+{
+  sigset_t all, old;
+
+  pthread_mutex_lock(&rm_mutex);
+  rm_opsec = (double)opspersec;
+  if(nthreads > RMDIRS_MAXTHREADS) nthreads = RMDIRS_MAXTHREADS;
+  sigfillset(&all);		/* signals (sum_rm's SIGALRM) go to the caller */
+  pthread_sigmask(SIG_BLOCK, &all, &old);
+  while(rm_nthreads < nthreads) {
+    if(pthread_create(&rm_threads[rm_nthreads], NULL, rmdirs_thread, NULL))
+      break;
+    pthread_detach(rm_threads[rm_nthreads]);
+    rm_nthreads++;
+  }
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+  pthread_mutex_unlock(&rm_mutex);
+  return(rm_nthreads == 0);
+}
+
+/* Queue wd for removal as rmdirs(wd, root). Returns 1 on error. */
+int rmdirs_queue(char *wd, char *root)
+{
+  RMPART *part;
+  RMJOB *job;
+  RmStat_t st;
+  int status;
+
+  if(rm_nthreads == 0) {		/* no threads, rm it now */
+    if(rm_t0 == 0.0) rm_t0 = rmdirs_now();
+    memset(&st, 0, sizeof(st));
+    status = rmdirs_x(wd, root, &st);
+    rmdirs_add(wd, status, &st);
+    return(status);
+  }
+  if(!(job = (RMJOB *)malloc(sizeof(RMJOB)))) return(1);
+  strcpy(job->wd, wd);
+  strcpy(job->root, root);
+  job->next = NULL;
+  pthread_mutex_lock(&rm_mutex);
+  if(rm_t0 == 0.0) rm_t0 = rmdirs_now();
+  part = rmdirs_part(wd);
+  if(part->rear) part->rear->next = job;
+  else part->front = job;
+  part->rear = job;
+  rm_pending++;
+  pthread_cond_signal(&rm_work);
+  pthread_mutex_unlock(&rm_mutex);
+  return(0);
+}
+
+/* Wait for all queued dirs to be removed. Returns in *stat what was freed
+ * since the last rmdirs_wait(), and the secs from the first queue.
+*/
+void rmdirs_wait(RmStat_t *stat)
+{
+  pthread_mutex_lock(&rm_mutex);
+  while(rm_pending)
+    pthread_cond_wait(&rm_done, &rm_mutex);
+  *stat = rm_stat;
+  stat->seconds = rm_t0 == 0.0 ? 0.0 : rmdirs_now() - rm_t0;
+  memset(&rm_stat, 0, sizeof(rm_stat));
+  rm_t0 = 0.0;
+  pthread_mutex_unlock(&rm_mutex);
+}
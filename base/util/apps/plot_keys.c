@@ -114,6 +114,7 @@ int DoIt(void)
     while ((key = (DRMS_Keyword_t *)hiter_getnext (&hit)))
       printf ("\t%-10s\t%s (%s)\n", key->info->name, key->info->description,
           drms_type_names[key->info->type]);
+    hiter_free (&hit);
 
     /* show the segments */
     if (rec->segments.num_total)
@@ -122,6 +123,7 @@ int DoIt(void)
       hiter_new (&hit, &rec->segments);
       while ((seg = (DRMS_Segment_t *)hiter_getnext (&hit)))
           printf ("\t%-10s\t%s\n", seg->info->name, seg->info->description);
+      hiter_free (&hit);
       }
     return (0);
     }
@@ -167,6 +169,7 @@ int DoIt(void)
     hiter_new (&hit, &recordset->records[0]->keywords);
     while ((key = (DRMS_Keyword_t *)hiter_getnext (&hit)))
       keys[nkeys++] = strdup (key->info->name);
+    hiter_free (&hit);
     }
   else if (plot_keys)
     { /* get specified list */
@@ -168,7 +168,7 @@ int DoIt(void)
   DRMS_RecordSet_t *rs;
   DRMS_Keyword_t *key;
   DRMS_Segment_t *seg;
-  HIterator_t key_hit;
+  HIterator_t *key_hit = NULL;
   int nprime, iprime;
   int nsegments, isegment;
   int is_new_seg = 0;
@@ -330,8 +330,7 @@ int DoIt(void)
 	 }
     } /* foreach(seg) */
     
-    hiter_new(&key_hit, &rec->keywords);
-    while( (key = (DRMS_Keyword_t *)hiter_getnext(&key_hit)) )
+    while( (key = drms_record_nextkey(rec, &key_hit, 0)) )
       {
       int is_prime = 0;
       keyname = key->info->name;
@@ -371,6 +370,9 @@ int DoIt(void)
          lckeyname = NULL;
          }
       }
+
+    if (key_hit)
+      hiter_destroy(&key_hit);
     } /* foreach(rec) */
 
   if (pkeys)
@@ -245,6 +245,7 @@ int DoIt(void)
     while ((key = (DRMS_Keyword_t *)hiter_getnext (&hit)))
       printf ("\t%-10s\t%s (%s)\n", key->info->name, key->info->description,
           drms_type_names[key->info->type]);
+    hiter_free (&hit);
 
     /* show the segments */
     if (rec->segments.num_total)
@@ -253,6 +254,7 @@ int DoIt(void)
       hiter_new (&hit, &rec->segments);
       while ((seg = (DRMS_Segment_t *)hiter_getnext (&hit)))
           printf ("\t%-10s\t%s\n", seg->info->name, seg->info->description);
+      hiter_free (&hit);
       }
 
     if (seriesname)
@@ -307,6 +309,7 @@ int DoIt(void)
     hiter_new (&hit, &recordset->records[0]->keywords);
     while ((key = (DRMS_Keyword_t *)hiter_getnext (&hit)))
       keys[nkeys++] = strdup (key->info->name);
+    hiter_free (&hit);
     }
   else if (show_keys)
     { /* get specified list */